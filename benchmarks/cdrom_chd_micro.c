@@ -0,0 +1,429 @@
+/*
+ * CHD CD-ROM image micro-benchmark.
+ *
+ * Reads every track of a CHD through the track files of
+ * cdrom_image_chd.c and checks each sector against a raw image of that
+ * track (a BIN with the same sector size, or the ISO of a DVD), once
+ * hunk by hunk and once with the prefetch thread running; then times
+ * sequential and random sector reads against plain reads of the raw
+ * images.
+ *
+ * Usage: cdrom_chd_micro image.chd [track1.bin track2.bin ...]
+ */
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "bench_common.h"
+#include <86box/86box.h>
+#include <86box/cdrom.h>
+#include <86box/cdrom_image.h>
+#include <86box/cdrom_image_chd.h>
+#include <86box/log.h>
+#include <86box/plat.h>
+#include <86box/thread.h>
+
+#define RANDOM_READS 4096
+
+/* The prefetch thread needs real threads; the rest of the platform layer is not needed. */
+typedef struct bench_event_t {
+    pthread_mutex_t mutex;
+    pthread_cond_t  cond;
+    int             state;
+} bench_event_t;
+
+typedef struct bench_thread_t {
+    pthread_t thread;
+    void (*func)(void *param);
+    void *param;
+} bench_thread_t;
+
+static void *
+thread_run(void *priv)
+{
+    bench_thread_t *t = (bench_thread_t *) priv;
+
+    t->func(t->param);
+    return NULL;
+}
+
+thread_t *
+thread_create_named(void (*thread_func)(void *param), void *param, const char *name)
+{
+    bench_thread_t *t = (bench_thread_t *) calloc(1, sizeof(bench_thread_t));
+
+    (void) name;
+    t->func  = thread_func;
+    t->param = param;
+    pthread_create(&t->thread, NULL, thread_run, t);
+
+    return t;
+}
+
+int
+thread_wait(thread_t *arg)
+{
+    bench_thread_t *t = (bench_thread_t *) arg;
+
+    pthread_join(t->thread, NULL);
+    free(t);
+    return 0;
+}
+
+event_t *
+thread_create_event(void)
+{
+    bench_event_t *e = (bench_event_t *) calloc(1, sizeof(bench_event_t));
+
+    pthread_mutex_init(&e->mutex, NULL);
+    pthread_cond_init(&e->cond, NULL);
+    return e;
+}
+
+void
+thread_set_event(event_t *arg)
+{
+    bench_event_t *e = (bench_event_t *) arg;
+
+    pthread_mutex_lock(&e->mutex);
+    e->state = 1;
+    pthread_cond_broadcast(&e->cond);
+    pthread_mutex_unlock(&e->mutex);
+}
+
+void
+thread_reset_event(event_t *arg)
+{
+    bench_event_t *e = (bench_event_t *) arg;
+
+    pthread_mutex_lock(&e->mutex);
+    e->state = 0;
+    pthread_mutex_unlock(&e->mutex);
+}
+
+int
+thread_wait_event(event_t *arg, int timeout)
+{
+    bench_event_t  *e = (bench_event_t *) arg;
+    struct timespec abstime;
+
+    clock_gettime(CLOCK_REALTIME, &abstime);
+    abstime.tv_nsec += (long) (timeout % 1000) * 1000000;
+    abstime.tv_sec += timeout / 1000;
+    if (abstime.tv_nsec >= 1000000000) {
+        abstime.tv_nsec -= 1000000000;
+        abstime.tv_sec++;
+    }
+
+    pthread_mutex_lock(&e->mutex);
+    if (timeout == -1) {
+        while (!e->state)
+            pthread_cond_wait(&e->cond, &e->mutex);
+    } else if (!e->state)
+        pthread_cond_timedwait(&e->cond, &e->mutex, &abstime);
+    pthread_mutex_unlock(&e->mutex);
+
+    return 0;
+}
+
+void
+thread_destroy_event(event_t *arg)
+{
+    bench_event_t *e = (bench_event_t *) arg;
+
+    pthread_cond_destroy(&e->cond);
+    pthread_mutex_destroy(&e->mutex);
+    free(e);
+}
+
+mutex_t *
+thread_create_mutex(void)
+{
+    pthread_mutex_t *m = (pthread_mutex_t *) calloc(1, sizeof(pthread_mutex_t));
+
+    pthread_mutex_init(m, NULL);
+    return m;
+}
+
+void
+thread_close_mutex(mutex_t *arg)
+{
+    pthread_mutex_destroy((pthread_mutex_t *) arg);
+    free(arg);
+}
+
+int
+thread_wait_mutex(mutex_t *arg)
+{
+    return pthread_mutex_lock((pthread_mutex_t *) arg) == 0;
+}
+
+int
+thread_release_mutex(mutex_t *arg)
+{
+    return pthread_mutex_unlock((pthread_mutex_t *) arg) == 0;
+}
+
+void *
+log_open(const char *dev_name)
+{
+    (void) dev_name;
+    return NULL;
+}
+
+void
+log_close(void *priv)
+{
+    (void) priv;
+}
+
+void
+log_out(void *priv, const char *fmt, va_list ap)
+{
+    (void) priv;
+    vfprintf(stderr, fmt, ap);
+}
+
+FILE *
+plat_fopen64(const char *path, const char *mode)
+{
+    return fopen(path, mode);
+}
+
+static uint64_t
+now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ull + (uint64_t) ts.tv_nsec;
+}
+
+static uint32_t rng = 86;
+
+static uint32_t
+xr(void)
+{
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return rng;
+}
+
+typedef struct bench_track_t {
+    track_file_t *tf;
+    uint32_t      sector_size;
+    uint32_t      sectors;
+    uint8_t      *raw;        /* The raw image of the track, or NULL if none was given. */
+    const char   *fn;
+} bench_track_t;
+
+static int
+open_tracks(const char *fn, int read_ahead, bench_track_t *bt, int count)
+{
+    const chd_track_t *tracks;
+    int                error;
+    chd_t             *chd = chd_open(fn, read_ahead, NULL, &error);
+
+    if (chd == NULL) {
+        printf("Unable to open %s (error %i)\n", fn, error);
+        return 0;
+    }
+
+    const int n = chd_get_tracks(chd, &tracks);
+
+    for (int i = 0; (i < n) && (i < count); i++) {
+        bt[i].tf          = chd_track_init(chd, i, 0);
+        bt[i].sector_size = tracks[i].sector_size + (tracks[i].subcode ? 96 : 0);
+        bt[i].sectors     = tracks[i].frames;
+    }
+
+    /* The track files hold their own references. */
+    chd_close(chd);
+
+    return (n < count) ? n : count;
+}
+
+static void
+close_tracks(bench_track_t *bt, int n)
+{
+    for (int i = 0; i < n; i++) {
+        bt[i].tf->close(bt[i].tf);
+        bt[i].tf = NULL;
+    }
+}
+
+static int
+check_tracks(bench_track_t *bt, int n, const char *what)
+{
+    uint8_t buf[2448];
+
+    for (int i = 0; i < n; i++) {
+        if (bt[i].raw == NULL)
+            continue;
+
+        for (uint32_t s = 0; s < bt[i].sectors; s++) {
+            const uint8_t *ref = &bt[i].raw[(uint64_t) s * bt[i].sector_size];
+
+            if ((bt[i].tf->read(bt[i].tf, buf, (uint64_t) s * bt[i].sector_size, bt[i].sector_size) <= 0) ||
+                memcmp(buf, ref, bt[i].sector_size)) {
+                printf("  %s: track %i sector %" PRIu32 " MISMATCH\n", what, i + 1, s);
+                return 0;
+            }
+        }
+
+        /* Reads that do not start or end on a sector, as the PVD probing does. */
+        for (int r = 0; r < 256; r++) {
+            const uint64_t len  = bt[i].sectors * (uint64_t) bt[i].sector_size;
+            const uint64_t pos  = xr() % len;
+            size_t         size = 1 + (xr() % sizeof(buf));
+
+            if ((pos + size) > len)
+                size = len - pos;
+
+            if ((bt[i].tf->read(bt[i].tf, buf, pos, size) <= 0) || memcmp(buf, &bt[i].raw[pos], size)) {
+                printf("  %s: track %i offset %" PRIu64 " size %zu MISMATCH\n", what, i + 1, pos, size);
+                return 0;
+            }
+        }
+    }
+
+    printf("  %s: exact\n", what);
+    return 1;
+}
+
+/* Sequential reads of every sector, or random ones; MB/s. */
+static double
+time_chd(bench_track_t *bt, int n, int random)
+{
+    uint8_t  buf[2448];
+    uint64_t bytes = 0;
+    uint64_t start = now_ns();
+
+    for (int i = 0; i < n; i++) {
+        const uint32_t count = random ? RANDOM_READS : bt[i].sectors;
+
+        for (uint32_t s = 0; s < count; s++) {
+            const uint32_t sector = random ? (xr() % bt[i].sectors) : s;
+
+            bt[i].tf->read(bt[i].tf, buf, (uint64_t) sector * bt[i].sector_size, bt[i].sector_size);
+            bytes += bt[i].sector_size;
+        }
+    }
+
+    return (double) bytes * 1000.0 / (double) (now_ns() - start);
+}
+
+static double
+time_raw(bench_track_t *bt, int n, int random)
+{
+    uint8_t  buf[2448];
+    uint64_t bytes = 0;
+    uint64_t start = now_ns();
+
+    for (int i = 0; i < n; i++) {
+        FILE *fp = fopen(bt[i].fn, "rb");
+
+        if (fp == NULL)
+            continue;
+
+        const uint32_t count = random ? RANDOM_READS : bt[i].sectors;
+
+        for (uint32_t s = 0; s < count; s++) {
+            const uint32_t sector = random ? (xr() % bt[i].sectors) : s;
+
+            fseek(fp, (long) sector * bt[i].sector_size, SEEK_SET);
+            bytes += fread(buf, 1, bt[i].sector_size, fp);
+        }
+
+        fclose(fp);
+    }
+
+    return (double) bytes * 1000.0 / (double) (now_ns() - start);
+}
+
+int
+main(int argc, char **argv)
+{
+    bench_track_t bt[CHD_MAX_TRACKS];
+    int           failures = 0;
+    int           raws     = argc - 2;
+    int           n;
+
+    if (argc < 2) {
+        printf("Usage: %s image.chd [track1.bin track2.bin ...]\n", argv[0]);
+        return 1;
+    }
+
+    memset(bt, 0x00, sizeof(bt));
+    for (int i = 0; (i < raws) && (i < CHD_MAX_TRACKS); i++) {
+        FILE *fp = fopen(argv[i + 2], "rb");
+
+        if (fp == NULL) {
+            printf("Unable to open %s\n", argv[i + 2]);
+            return 1;
+        }
+
+        fseek(fp, 0, SEEK_END);
+        const long len = ftell(fp);
+        fseek(fp, 0, SEEK_SET);
+        bt[i].fn  = argv[i + 2];
+        bt[i].raw = (uint8_t *) malloc(len);
+        if (fread(bt[i].raw, 1, len, fp) != (size_t) len)
+            return 1;
+        fclose(fp);
+    }
+
+    n = open_tracks(argv[1], 0, bt, CHD_MAX_TRACKS);
+    if (n == 0)
+        return 1;
+
+    for (int i = 0; i < n; i++) {
+        printf("track %2i: %6" PRIu32 " sectors of %4" PRIu32 " bytes\n", i + 1,
+               bt[i].sectors, bt[i].sector_size);
+        if ((bt[i].raw != NULL) && (i < raws)) {
+            FILE *fp = fopen(bt[i].fn, "rb");
+
+            fseek(fp, 0, SEEK_END);
+            if ((uint64_t) ftell(fp) != ((uint64_t) bt[i].sectors * bt[i].sector_size)) {
+                printf("  %s is not the size of the track\n", bt[i].fn);
+                failures++;
+            }
+            fclose(fp);
+        }
+    }
+
+    if (!check_tracks(bt, n, "hunk by hunk"))
+        failures++;
+
+    const double seq_cold = time_chd(bt, n, 0);
+    const double rnd_cold = time_chd(bt, n, 1);
+    close_tracks(bt, n);
+
+    open_tracks(argv[1], 32, bt, CHD_MAX_TRACKS);
+    if (!check_tracks(bt, n, "prefetch"))
+        failures++;
+
+    close_tracks(bt, n);
+    open_tracks(argv[1], 32, bt, CHD_MAX_TRACKS);
+    const double seq_pre = time_chd(bt, n, 0);
+    const double rnd_pre = time_chd(bt, n, 1);
+    close_tracks(bt, n);
+
+    printf("sequential: %8.1f MB/s, prefetch %8.1f MB/s", seq_cold, seq_pre);
+    if (raws > 0)
+        printf(", raw %8.1f MB/s", time_raw(bt, (raws < n) ? raws : n, 0));
+    printf("\nrandom    : %8.1f MB/s, prefetch %8.1f MB/s", rnd_cold, rnd_pre);
+    if (raws > 0)
+        printf(", raw %8.1f MB/s", time_raw(bt, (raws < n) ? raws : n, 1));
+    printf("\n");
+
+    for (int i = 0; i < raws; i++)
+        free(bt[i].raw);
+
+    return failures ? 1 : 0;
+}
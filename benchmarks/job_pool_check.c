@@ -0,0 +1,328 @@
+/*
+ * Job pool check.
+ *
+ * Links job_pool.c against events with the semantics of the Windows
+ * build (src/qt/win_thread.c): auto-reset, so that each set wakes at
+ * most one waiter. Closes pools of several idle workers, pools whose
+ * workers are busy, and jobs with several threads waiting on them, and
+ * fails if any of them does not return within a few seconds. Then
+ * times submitting a job and waiting for it.
+ */
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <86box/thread.h>
+#include <86box/job_pool.h>
+
+#define TIMEOUT_S 5
+
+/* Auto-reset events, as CreateEvent(NULL, FALSE, FALSE, NULL). */
+typedef struct check_event_t {
+    pthread_mutex_t mutex;
+    pthread_cond_t  cond;
+    int             state;
+} check_event_t;
+
+typedef struct check_thread_t {
+    pthread_t thread;
+    void (*func)(void *param);
+    void *param;
+} check_thread_t;
+
+static void *
+check_thread_func(void *param)
+{
+    check_thread_t *t = (check_thread_t *) param;
+
+    t->func(t->param);
+
+    return NULL;
+}
+
+thread_t *
+thread_create_named(void (*func)(void *param), void *param, const char *name)
+{
+    check_thread_t *t = calloc(1, sizeof(check_thread_t));
+
+    (void) name;
+
+    t->func  = func;
+    t->param = param;
+    pthread_create(&t->thread, NULL, check_thread_func, t);
+
+    return (thread_t *) t;
+}
+
+int
+thread_wait(thread_t *arg)
+{
+    check_thread_t *t = (check_thread_t *) arg;
+
+    pthread_join(t->thread, NULL);
+    free(t);
+
+    return 0;
+}
+
+event_t *
+thread_create_event(void)
+{
+    check_event_t *ev = calloc(1, sizeof(check_event_t));
+
+    pthread_mutex_init(&ev->mutex, NULL);
+    pthread_cond_init(&ev->cond, NULL);
+
+    return (event_t *) ev;
+}
+
+void
+thread_set_event(event_t *arg)
+{
+    check_event_t *ev = (check_event_t *) arg;
+
+    pthread_mutex_lock(&ev->mutex);
+    ev->state = 1;
+    pthread_cond_signal(&ev->cond);
+    pthread_mutex_unlock(&ev->mutex);
+}
+
+void
+thread_reset_event(event_t *arg)
+{
+    check_event_t *ev = (check_event_t *) arg;
+
+    pthread_mutex_lock(&ev->mutex);
+    ev->state = 0;
+    pthread_mutex_unlock(&ev->mutex);
+}
+
+int
+thread_wait_event(event_t *arg, int timeout)
+{
+    check_event_t *ev = (check_event_t *) arg;
+
+    (void) timeout;
+
+    pthread_mutex_lock(&ev->mutex);
+    while (!ev->state)
+        pthread_cond_wait(&ev->cond, &ev->mutex);
+    ev->state = 0; /* Consumed by this waiter alone. */
+    pthread_mutex_unlock(&ev->mutex);
+
+    return 0;
+}
+
+void
+thread_destroy_event(event_t *arg)
+{
+    check_event_t *ev = (check_event_t *) arg;
+
+    pthread_cond_destroy(&ev->cond);
+    pthread_mutex_destroy(&ev->mutex);
+    free(ev);
+}
+
+mutex_t *
+thread_create_mutex(void)
+{
+    pthread_mutex_t *m = malloc(sizeof(pthread_mutex_t));
+
+    pthread_mutex_init(m, NULL);
+
+    return (mutex_t *) m;
+}
+
+void
+thread_close_mutex(mutex_t *arg)
+{
+    pthread_mutex_destroy((pthread_mutex_t *) arg);
+    free(arg);
+}
+
+int
+thread_wait_mutex(mutex_t *arg)
+{
+    return pthread_mutex_lock((pthread_mutex_t *) arg) == 0;
+}
+
+int
+thread_release_mutex(mutex_t *arg)
+{
+    return pthread_mutex_unlock((pthread_mutex_t *) arg) == 0;
+}
+
+static uint64_t
+now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t) ts.tv_sec * 1000000000ULL) + (uint64_t) ts.tv_nsec;
+}
+
+/* Runs a step on a thread of its own, so that a hang is reported instead of waited out. */
+typedef struct step_t {
+    void (*func)(void *priv);
+    void      *priv;
+    atomic_int done;
+} step_t;
+
+static void *
+step_thread(void *param)
+{
+    step_t *s = (step_t *) param;
+
+    s->func(s->priv);
+    atomic_store(&s->done, 1);
+
+    return NULL;
+}
+
+static int
+run_step(const char *name, void (*func)(void *priv), void *priv)
+{
+    step_t    s        = { func, priv, 0 };
+    uint64_t  deadline = now_ns() + (TIMEOUT_S * 1000000000ULL);
+    pthread_t t;
+
+    pthread_create(&t, NULL, step_thread, &s);
+
+    while (!atomic_load(&s.done) && (now_ns() < deadline))
+        usleep(1000);
+
+    if (!atomic_load(&s.done)) {
+        printf("  %s: hung\n", name);
+        return 1;
+    }
+
+    pthread_join(t, NULL);
+    return 0;
+}
+
+static void
+close_idle(void *priv)
+{
+    const int   threads = *(int *) priv;
+    job_pool_t *pool    = job_pool_create("check", threads);
+
+    /* Let every worker reach its wait before the close. */
+    usleep(20000);
+    job_pool_close(pool);
+}
+
+static atomic_int counter;
+
+static void
+job_sleep(void *priv)
+{
+    (void) priv;
+
+    usleep(5000);
+    atomic_fetch_add(&counter, 1);
+}
+
+static void
+close_busy(void *priv)
+{
+    job_pool_t *pool = job_pool_create("check", 4);
+    job_t      *jobs[8];
+
+    (void) priv;
+
+    for (int i = 0; i < 8; i++) {
+        jobs[i] = job_create(pool, "sleep", job_sleep, NULL);
+        job_submit(jobs[i]);
+    }
+    for (int i = 0; i < 8; i++)
+        job_close(jobs[i]);
+
+    job_pool_close(pool);
+}
+
+typedef struct waiter_t {
+    job_t    *job;
+    pthread_t thread;
+} waiter_t;
+
+static void *
+waiter_thread(void *param)
+{
+    job_wait(((waiter_t *) param)->job);
+
+    return NULL;
+}
+
+static void
+wait_many(void *priv)
+{
+    job_pool_t *pool = job_pool_create("check", 2);
+    job_t      *job  = job_create(pool, "sleep", job_sleep, NULL);
+    waiter_t    w[4];
+
+    (void) priv;
+
+    job_submit(job);
+    for (int i = 0; i < 4; i++) {
+        w[i].job = job;
+        pthread_create(&w[i].thread, NULL, waiter_thread, &w[i]);
+    }
+    for (int i = 0; i < 4; i++)
+        pthread_join(w[i].thread, NULL);
+
+    job_close(job);
+    job_pool_close(pool);
+}
+
+static void
+job_empty(void *priv)
+{
+    (void) priv;
+}
+
+int
+main(void)
+{
+    static const int sizes[] = { 1, 2, 3, 8 };
+    int              errors  = 0;
+    char             name[64];
+
+    for (int i = 0; i < (int) (sizeof(sizes) / sizeof(sizes[0])); i++) {
+        for (int n = 0; n < 20; n++) {
+            snprintf(name, sizeof(name), "close %i idle workers", sizes[i]);
+            errors += run_step(name, close_idle, (void *) &sizes[i]);
+        }
+    }
+
+    for (int n = 0; n < 20; n++)
+        errors += run_step("close busy workers", close_busy, NULL);
+
+    for (int n = 0; n < 20; n++)
+        errors += run_step("several waiters on one job", wait_many, NULL);
+
+    printf("job_pool_check: %s\n", errors ? "FAILED" : "ok");
+
+    if (!errors) {
+        job_pool_t    *pool  = job_pool_create("bench", 2);
+        job_t         *job   = job_create(pool, "empty", job_empty, NULL);
+        const int      iters = 100000;
+        const uint64_t start = now_ns();
+
+        for (int i = 0; i < iters; i++) {
+            job_submit(job);
+            job_wait(job);
+        }
+
+        printf("submit and wait: %.0f ns\n", (double) (now_ns() - start) / iters);
+
+        job_close(job);
+        job_pool_close(pool);
+    }
+
+    return errors ? 1 : 0;
+}
@@ -0,0 +1,213 @@
+/*
+ * MIDI event queue check.
+ *
+ * Drives midi_queue.c the way a MIDI device does: messages and SysEx
+ * dumps are queued at known positions within each 10 ms period, the
+ * period is ended as by midi_poll(), and the render side is run. Checks
+ * that every event is played in order, intact, and on the frame it was
+ * sent at one period later, including SysEx dumps that meet the end of
+ * the ring. Then times queuing and playing a dense stream of messages.
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "bench_common.h"
+#include <86box/midi_queue.h>
+
+#define RATE    32000 /* MT-32 */
+#define PERIODS 2000
+
+static int poll_pos; /* Samples at 48 kHz into the period, as sound_get_poll_pos() reports. */
+
+int
+sound_get_poll_pos(void)
+{
+    return poll_pos;
+}
+
+typedef struct check_t {
+    uint64_t frame;      /* Frames rendered so far. */
+    uint64_t expect[64]; /* Frame each event in flight is due at, by sequence number. */
+    uint32_t seq_in;     /* Events queued. */
+    uint32_t seq_out;    /* Events played. */
+    int      errors;
+} check_t;
+
+static void
+check_render(void *priv, int frames)
+{
+    check_t *c = (check_t *) priv;
+
+    c->frame += frames;
+}
+
+static void
+check_msg(void *priv, uint8_t *msg)
+{
+    check_t       *c   = (check_t *) priv;
+    const uint32_t seq = msg[1] | (msg[2] << 8);
+
+    if ((seq != (c->seq_out & 0xffff)) || (c->frame != c->expect[c->seq_out % 64])) {
+        if (c->errors++ < 10)
+            printf("  message %u: seq %u, frame %llu, expected frame %llu\n", c->seq_out, seq,
+                   (unsigned long long) c->frame, (unsigned long long) c->expect[c->seq_out % 64]);
+    }
+    c->seq_out++;
+}
+
+static void
+check_sysex(void *priv, uint8_t *sysex, unsigned int len)
+{
+    check_t *c = (check_t *) priv;
+
+    if ((sysex[0] != 0xf0) || (sysex[len - 1] != 0xf7) || (c->frame != c->expect[c->seq_out % 64]))
+        c->errors++;
+    for (unsigned int i = 1; i < (len - 1); i++) {
+        if (sysex[i] != (uint8_t) ((c->seq_out + i) & 0x7f)) {
+            c->errors++;
+            break;
+        }
+    }
+    c->seq_out++;
+}
+
+static const midi_queue_ops_t check_ops = {
+    .render     = check_render,
+    .play_msg   = check_msg,
+    .play_sysex = check_sysex
+};
+
+static uint64_t
+now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ull + (uint64_t) ts.tv_nsec;
+}
+
+static int
+check_timing(void)
+{
+    midi_queue_t      *q     = midi_queue_create(RATE);
+    check_t            c     = { 0 };
+    uint8_t            sysex[4096];
+    midi_queue_stats_t stats;
+
+    srand(86);
+
+    for (int p = 0; p < PERIODS; p++) {
+        const int events = rand() % 8;
+        int       pos    = 0;
+
+        for (int e = 0; e < events; e++) {
+            pos += rand() % (480 / 8);
+            poll_pos = pos;
+
+            c.expect[c.seq_in % 64] = ((uint64_t) p * (RATE / 100)) + ((uint64_t) pos * RATE / 48000);
+
+            if ((rand() % 16) == 0) {
+                const unsigned int len = 3 + (rand() % (sizeof(sysex) - 3));
+
+                sysex[0] = 0xf0;
+                for (unsigned int i = 1; i < (len - 1); i++)
+                    sysex[i] = (uint8_t) ((c.seq_in + i) & 0x7f);
+                sysex[len - 1] = 0xf7;
+                midi_queue_sysex(q, sysex, len);
+            } else {
+                const uint8_t msg[4] = { 0x90, c.seq_in & 0xff, (c.seq_in >> 8) & 0xff, 0 };
+
+                midi_queue_msg(q, msg);
+            }
+            c.seq_in++;
+        }
+
+        midi_queue_period(q);
+        midi_queue_render(q, &check_ops, &c);
+
+        if (c.frame != ((uint64_t) (p + 1) * (RATE / 100))) {
+            c.errors++;
+            break;
+        }
+    }
+
+    midi_queue_get_stats(q, &stats);
+    midi_queue_close(q);
+
+    printf("timing  : %u events in %d periods, %u left over, depth max %u, %d errors\n", c.seq_in, PERIODS,
+           stats.depth, stats.depth_max, c.errors);
+
+    /* Events of the last period are not due until the next one. */
+    return c.errors || stats.dropped || ((c.seq_in - c.seq_out) != stats.depth);
+}
+
+static void
+nop_render(void *priv, int frames)
+{
+    (void) priv;
+    (void) frames;
+}
+
+static void
+nop_msg(void *priv, uint8_t *msg)
+{
+    *(uint32_t *) priv += msg[1];
+}
+
+static const midi_queue_ops_t nop_ops = {
+    .render   = nop_render,
+    .play_msg = nop_msg
+};
+
+static void
+time_queue(uint64_t periods)
+{
+    midi_queue_t      *q      = midi_queue_create(RATE);
+    const uint8_t      msg[4] = { 0x90, 0x40, 0x7f, 0 };
+    uint32_t           sum    = 0;
+    midi_queue_stats_t stats;
+    uint64_t           start;
+
+    start = now_ns();
+    for (uint64_t p = 0; p < periods; p++) {
+        for (int e = 0; e < 100; e++) {
+            poll_pos = e * 4;
+            midi_queue_msg(q, msg);
+        }
+        midi_queue_period(q);
+        midi_queue_render(q, &nop_ops, &sum);
+        BENCH_CLOBBER();
+    }
+    start = now_ns() - start;
+
+    midi_queue_get_stats(q, &stats);
+    midi_queue_close(q);
+
+    printf("speed   : %.1f ns per event queued and played, render avg %llu ns per period\n",
+           (double) start / (double) (periods * 100), (unsigned long long) stats.render_ns_avg);
+}
+
+int
+main(int argc, char **argv)
+{
+    uint64_t iters = 20000ull;
+
+    for (int i = 1; i < argc; ++i) {
+        if (strncmp(argv[i], "--iters=", 8) == 0) {
+            iters = strtoull(argv[i] + 8, NULL, 10);
+        } else if (strcmp(argv[i], "--help") == 0) {
+            printf("Usage: %s [--iters=N]\n", argv[0]);
+            return 0;
+        }
+    }
+
+    if (check_timing())
+        return 1;
+
+    time_queue(iters);
+
+    return 0;
+}
@@ -0,0 +1,299 @@
+/*
+ * Nuked OPL3 vectorized core check.
+ *
+ * Plays an OPL register log through two chips, one running the reference
+ * per-slot core and one running the vectorized core (OPL3_LanesInit()),
+ * compares the two outputs byte for byte and times both. The log is a
+ * DOSBox raw OPL capture (.dro, version 2); without one, a random stress
+ * log that keeps switching 4-op, rhythm, waveform and feedback settings
+ * is used instead.
+ */
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "bench_common.h"
+#include <86box/86box.h>
+#include "cpu.h"
+#include <86box/thread.h>
+#include <86box/plat_unused.h>
+#include <86box/timer.h>
+#include <86box/sound.h>
+#include <86box/sound_worker.h>
+#include <86box/snd_opl_nuked.h>
+
+#define RATE 49716 /* Native rate, so that no resampling is involved. */
+
+/* Symbols the device glue in snd_opl_nuked.c refers to; the check only drives the chip itself. */
+cpu_state_t cpu_state;
+double      isa_timing;
+
+int
+music_get_pos(void)
+{
+    return 0;
+}
+
+int
+sound_get_pos(void)
+{
+    return 0;
+}
+
+void
+timer_add(UNUSED(pc_timer_t *timer), UNUSED(void (*callback)(void *priv)), UNUSED(void *priv), UNUSED(int start_timer))
+{
+}
+
+void
+timer_on_auto(UNUSED(pc_timer_t *timer), UNUSED(double period))
+{
+}
+
+sound_job_t *
+sound_job_create(UNUSED(const char *name), UNUSED(void (*func)(void *priv)), UNUSED(void *priv))
+{
+    return NULL;
+}
+
+void
+sound_job_close(UNUSED(sound_job_t *job))
+{
+}
+
+void
+sound_job_submit(UNUSED(sound_job_t *job))
+{
+}
+
+event_t *
+thread_create_event(void)
+{
+    return NULL;
+}
+
+void
+thread_set_event(UNUSED(event_t *arg))
+{
+}
+
+void
+thread_reset_event(UNUSED(event_t *arg))
+{
+}
+
+int
+thread_wait_event(UNUSED(event_t *arg), UNUSED(int timeout))
+{
+    return 0;
+}
+
+void
+thread_destroy_event(UNUSED(event_t *arg))
+{
+}
+
+typedef struct opl_event_t {
+    uint32_t samples; /* Samples to render before the write. */
+    uint16_t reg;
+    uint8_t  val;
+} opl_event_t;
+
+typedef struct opl_log_t {
+    opl_event_t *events;
+    uint32_t     count;
+    uint32_t     size;
+    uint64_t     samples;
+} opl_log_t;
+
+static void
+log_add(opl_log_t *log, uint32_t samples, uint16_t reg, uint8_t val)
+{
+    if (log->count == log->size) {
+        log->size   = log->size ? (log->size * 2) : 4096;
+        log->events = realloc(log->events, log->size * sizeof(opl_event_t));
+    }
+
+    log->events[log->count].samples = samples;
+    log->events[log->count].reg     = reg;
+    log->events[log->count].val     = val;
+    log->count++;
+    log->samples += samples;
+}
+
+static uint64_t
+now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ull + (uint64_t) ts.tv_nsec;
+}
+
+/* DOSBox raw OPL version 2: delays are in milliseconds, the high bit of the index selects the second bank. */
+static int
+log_load_dro(opl_log_t *log, const char *fn)
+{
+    FILE    *fp = fopen(fn, "rb");
+    uint8_t  hdr[26];
+    uint8_t  codemap[128];
+    uint8_t  pair[2];
+    uint32_t pending = 0;
+    uint64_t ms      = 0;
+    uint64_t done    = 0;
+
+    if (fp == NULL) {
+        printf("%s: cannot open\n", fn);
+        return 0;
+    }
+
+    if ((fread(hdr, 1, sizeof(hdr), fp) != sizeof(hdr)) || memcmp(hdr, "DBRAWOPL", 8) || (hdr[8] != 2) || hdr[9]
+        || hdr[21] || hdr[22] || (hdr[25] > sizeof(codemap)) || (fread(codemap, 1, hdr[25], fp) != hdr[25])) {
+        printf("%s: not an uncompressed version 2 DRO file\n", fn);
+        fclose(fp);
+        return 0;
+    }
+
+    while (fread(pair, 1, 2, fp) == 2) {
+        uint64_t total;
+
+        if ((pair[0] == hdr[23]) || (pair[0] == hdr[24])) {
+            ms += (pair[0] == hdr[23]) ? (pair[1] + 1) : ((pair[1] + 1) << 8);
+            total = (ms * RATE) / 1000;
+            pending += (uint32_t) (total - done);
+            done = total;
+        } else if ((pair[0] & 0x7f) < hdr[25]) {
+            log_add(log, pending, ((pair[0] & 0x80) << 1) | codemap[pair[0] & 0x7f], pair[1]);
+            pending = 0;
+        }
+    }
+    log_add(log, pending + RATE, 0x000, 0x00);
+
+    fclose(fp);
+    return 1;
+}
+
+static void
+log_random(opl_log_t *log, uint32_t seconds)
+{
+    static const uint8_t regs[] = { 0x20, 0x40, 0x60, 0x80, 0xa0, 0xb0, 0xc0, 0xe0 };
+
+    srand(86);
+    log_add(log, 0, 0x105, 0x01);
+    log_add(log, 0, 0x001, 0x20);
+
+    while (log->samples < ((uint64_t) seconds * RATE)) {
+        const uint16_t bank = (rand() & 1) << 8;
+        const int      r    = rand() % 100;
+        uint16_t       reg;
+        uint8_t        val = rand() & 0xff;
+
+        if (r < 2)
+            reg = 0x104, val &= 0x3f;
+        else if (r < 4)
+            reg = 0x105, val &= 0x01;
+        else if (r < 8)
+            reg = 0x0bd;
+        else if (r < 10)
+            reg = 0x008;
+        else {
+            reg = bank | (regs[rand() % 8] + (rand() % 22));
+            if ((reg & 0xf0) == 0xb0)
+                val = 0x20 | (val & 0x1f);
+        }
+
+        log_add(log, rand() % 64, reg, val);
+    }
+}
+
+/* Renders the log and returns the time spent in nanoseconds. */
+static uint64_t
+render(const opl_log_t *log, int lanes, int32_t *out)
+{
+    opl3_chip *chip = calloc(1, sizeof(opl3_chip));
+    int32_t    buf[2];
+    uint64_t   start;
+
+    OPL3_Reset(chip, RATE);
+    if (lanes)
+        OPL3_LanesInit(chip);
+
+    start = now_ns();
+    for (uint32_t i = 0; i < log->count; i++) {
+        for (uint32_t j = 0; j < log->events[i].samples; j++) {
+            OPL3_Generate(chip, buf);
+            *out++ = buf[0];
+            *out++ = buf[1];
+        }
+        OPL3_WriteRegBuffered(chip, log->events[i].reg, log->events[i].val);
+    }
+    start = now_ns() - start;
+
+    free(chip);
+    return start;
+}
+
+int
+main(int argc, char **argv)
+{
+    opl_log_t   log   = { 0 };
+    const char *fn    = NULL;
+    int         iters = 3;
+    int32_t    *ref;
+    int32_t    *test;
+    uint64_t    ref_ns  = 0;
+    uint64_t    test_ns = 0;
+    uint64_t    mismatch;
+
+    for (int i = 1; i < argc; ++i) {
+        if (strncmp(argv[i], "--iters=", 8) == 0) {
+            iters = atoi(argv[i] + 8);
+        } else if (strcmp(argv[i], "--help") == 0) {
+            printf("Usage: %s [--iters=N] [capture.dro]\n", argv[0]);
+            return 0;
+        } else
+            fn = argv[i];
+    }
+
+    if (fn != NULL) {
+        if (!log_load_dro(&log, fn))
+            return 1;
+    } else
+        log_random(&log, 60);
+
+    ref  = malloc(log.samples * 2 * sizeof(int32_t));
+    test = malloc(log.samples * 2 * sizeof(int32_t));
+
+    for (int i = 0; i < iters; i++) {
+        ref_ns += render(&log, 0, ref);
+        test_ns += render(&log, 1, test);
+    }
+
+    mismatch = log.samples;
+    for (uint64_t i = 0; i < log.samples * 2; i++) {
+        if (ref[i] != test[i]) {
+            mismatch = i / 2;
+            break;
+        }
+    }
+
+    printf("%s: %u writes, %llu samples (%.1f s)\n", fn ? fn : "random log", log.count,
+           (unsigned long long) log.samples, (double) log.samples / RATE);
+    if (mismatch < log.samples)
+        printf("  output: MISMATCH at sample %llu\n", (unsigned long long) mismatch);
+    else
+        printf("  output: identical\n");
+    printf("  reference : %9.1f ns/sample\n", (double) ref_ns / (double) (log.samples * iters));
+    printf("  vectorized: %9.1f ns/sample  speedup %.2fx\n", (double) test_ns / (double) (log.samples * iters),
+           ratio((double) ref_ns, (double) test_ns));
+
+    free(test);
+    free(ref);
+    free(log.events);
+
+    return (mismatch < log.samples) ? 1 : 0;
+}
@@ -0,0 +1,795 @@
+/*
+ * S3 accelerator fast path check.
+ *
+ * Builds vid_s3.c into the check so that its internal state is reachable,
+ * and runs random rectangle fills, BitBlts and pattern fills through
+ * s3_accel_start() twice: once with the row fast path (s3_accel_fast())
+ * and once with it disabled, so that everything goes through the
+ * per-pixel engine. The mixes, write masks, clip rectangles, directions
+ * and source/destination overlaps are all randomized, as are a share of
+ * register states the fast path must turn down. VRAM, changedvram and the
+ * engine registers must come out identical. Then times a few common
+ * operations through both.
+ */
+#include "../src/video/vid_s3.c"
+
+#include <time.h>
+
+#define VRAM_SIZE (1 << 20)
+#define TESTS     20000
+
+/* Symbols the rest of vid_s3.c refers to; the check only drives the accelerator. */
+const device_t att490_ramdac_device     = { 0 };
+const device_t att491_ramdac_device     = { 0 };
+const device_t att492_ramdac_device     = { 0 };
+const device_t att498_ramdac_device     = { 0 };
+const device_t av9194_device            = { 0 };
+const device_t bt485_ramdac_device      = { 0 };
+const device_t gendac_ramdac_device     = { 0 };
+const device_t ibm_rgb528_ramdac_device = { 0 };
+const device_t icd2061_device           = { 0 };
+const device_t ics2494an_305_device     = { 0 };
+const device_t ics9161_device           = { 0 };
+const device_t nmc93cxx_device          = { 0 };
+const device_t sc11483_ramdac_device    = { 0 };
+const device_t sc1502x_ramdac_device    = { 0 };
+const device_t sdac_ramdac_device       = { 0 };
+const device_t tvp3026_ramdac_device    = { 0 };
+
+monitor_t monitors[MONITORS_NUM];
+int       monitor_index_global;
+double    cpuclock;
+int       xga_active;
+uint32_t *video_15to32;
+uint32_t *video_16to32;
+
+void *
+device_add(UNUSED(const device_t *dev))
+{
+    return NULL;
+}
+
+void *
+device_add_inst_params(UNUSED(const device_t *dev), UNUSED(int inst), UNUSED(void *params))
+{
+    return NULL;
+}
+
+int
+device_get_config_int(UNUSED(const char *name))
+{
+    return 0;
+}
+
+int
+device_get_instance(void)
+{
+    return 0;
+}
+
+void
+io_sethandler(UNUSED(uint16_t base), UNUSED(int size),
+              UNUSED(uint8_t (*inb)(uint16_t addr, void *priv)),
+              UNUSED(uint16_t (*inw)(uint16_t addr, void *priv)),
+              UNUSED(uint32_t (*inl)(uint16_t addr, void *priv)),
+              UNUSED(void (*outb)(uint16_t addr, uint8_t val, void *priv)),
+              UNUSED(void (*outw)(uint16_t addr, uint16_t val, void *priv)),
+              UNUSED(void (*outl)(uint16_t addr, uint32_t val, void *priv)),
+              UNUSED(void *priv))
+{
+}
+
+void
+io_removehandler(UNUSED(uint16_t base), UNUSED(int size),
+                 UNUSED(uint8_t (*inb)(uint16_t addr, void *priv)),
+                 UNUSED(uint16_t (*inw)(uint16_t addr, void *priv)),
+                 UNUSED(uint32_t (*inl)(uint16_t addr, void *priv)),
+                 UNUSED(void (*outb)(uint16_t addr, uint8_t val, void *priv)),
+                 UNUSED(void (*outw)(uint16_t addr, uint16_t val, void *priv)),
+                 UNUSED(void (*outl)(uint16_t addr, uint32_t val, void *priv)),
+                 UNUSED(void *priv))
+{
+}
+
+void
+mem_mapping_add(UNUSED(mem_mapping_t *mapping), UNUSED(uint32_t base), UNUSED(uint32_t size),
+                UNUSED(uint8_t (*read_b)(uint32_t addr, void *priv)),
+                UNUSED(uint16_t (*read_w)(uint32_t addr, void *priv)),
+                UNUSED(uint32_t (*read_l)(uint32_t addr, void *priv)),
+                UNUSED(void (*write_b)(uint32_t addr, uint8_t val, void *priv)),
+                UNUSED(void (*write_w)(uint32_t addr, uint16_t val, void *priv)),
+                UNUSED(void (*write_l)(uint32_t addr, uint32_t val, void *priv)),
+                UNUSED(uint8_t *exec), UNUSED(uint32_t flags), UNUSED(void *priv))
+{
+}
+
+void
+mem_mapping_set_handler(UNUSED(mem_mapping_t *mapping),
+                        UNUSED(uint8_t (*read_b)(uint32_t addr, void *priv)),
+                        UNUSED(uint16_t (*read_w)(uint32_t addr, void *priv)),
+                        UNUSED(uint32_t (*read_l)(uint32_t addr, void *priv)),
+                        UNUSED(void (*write_b)(uint32_t addr, uint8_t val, void *priv)),
+                        UNUSED(void (*write_w)(uint32_t addr, uint16_t val, void *priv)),
+                        UNUSED(void (*write_l)(uint32_t addr, uint32_t val, void *priv)))
+{
+}
+
+void
+mem_mapping_set_addr(UNUSED(mem_mapping_t *mapping), UNUSED(uint32_t base), UNUSED(uint32_t size))
+{
+}
+
+void
+mem_mapping_set_p(UNUSED(mem_mapping_t *mapping), UNUSED(void *priv))
+{
+}
+
+void
+mem_mapping_disable(UNUSED(mem_mapping_t *mapping))
+{
+}
+
+void
+mem_mapping_enable(UNUSED(mem_mapping_t *mapping))
+{
+}
+
+void
+pci_add_card(UNUSED(uint8_t add_type), UNUSED(uint8_t (*read)(int func, int addr, void *priv)),
+             UNUSED(void (*write)(int func, int addr, uint8_t val, void *priv)), UNUSED(void *priv), UNUSED(uint8_t *slot))
+{
+}
+
+void
+pci_irq(UNUSED(uint8_t slot), UNUSED(uint8_t pci_int), UNUSED(int level), UNUSED(int set), UNUSED(uint8_t *irq_state))
+{
+}
+
+int
+rom_init(UNUSED(rom_t *rom), UNUSED(const char *fn), UNUSED(uint32_t address), UNUSED(int size),
+         UNUSED(int mask), UNUSED(int file_offset), UNUSED(uint32_t flags))
+{
+    return 0;
+}
+
+int
+rom_present(UNUSED(const char *fn))
+{
+    return 0;
+}
+
+uint64_t
+plat_timer_read(void)
+{
+    return 0;
+}
+
+void
+video_inform_monitor(UNUSED(int type), UNUSED(const video_timings_t *ptr), UNUSED(int monitor_index))
+{
+}
+
+thread_t *
+thread_create_named(UNUSED(void (*thread_func)(void *param)), UNUSED(void *param), UNUSED(const char *name))
+{
+    return NULL;
+}
+
+int
+thread_wait(UNUSED(thread_t *arg))
+{
+    return 0;
+}
+
+event_t *
+thread_create_event(void)
+{
+    return NULL;
+}
+
+void
+thread_set_event(UNUSED(event_t *arg))
+{
+}
+
+void
+thread_reset_event(UNUSED(event_t *arg))
+{
+}
+
+int
+thread_wait_event(UNUSED(event_t *arg), UNUSED(int timeout))
+{
+    return 0;
+}
+
+void
+thread_destroy_event(UNUSED(event_t *arg))
+{
+}
+
+void *
+ddc_init(UNUSED(void *i2c))
+{
+    return NULL;
+}
+
+void
+ddc_close(UNUSED(void *eeprom))
+{
+}
+
+void *
+i2c_gpio_init(UNUSED(char *bus_name))
+{
+    return NULL;
+}
+
+void
+i2c_gpio_close(UNUSED(void *dev_handle))
+{
+}
+
+void
+i2c_gpio_set(UNUSED(void *dev_handle), UNUSED(uint8_t scl), UNUSED(uint8_t sda))
+{
+}
+
+uint8_t
+i2c_gpio_get_scl(UNUSED(void *dev_handle))
+{
+    return 1;
+}
+
+uint8_t
+i2c_gpio_get_sda(UNUSED(void *dev_handle))
+{
+    return 1;
+}
+
+void *
+i2c_gpio_get_bus(UNUSED(void *dev_handle))
+{
+    return NULL;
+}
+
+uint16_t
+nmc93cxx_eeprom_read(UNUSED(nmc93cxx_eeprom_t *eeprom))
+{
+    return 0;
+}
+
+void
+nmc93cxx_eeprom_write(UNUSED(nmc93cxx_eeprom_t *eeprom), UNUSED(int eecs), UNUSED(int eesk), UNUSED(int eedi))
+{
+}
+
+uint8_t
+xga_read_test(UNUSED(uint32_t addr), UNUSED(void *priv))
+{
+    return 0xff;
+}
+
+void
+xga_write_test(UNUSED(uint32_t addr), UNUSED(uint8_t val), UNUSED(void *priv))
+{
+}
+
+int
+svga_init(UNUSED(const device_t *info), UNUSED(svga_t *svga), UNUSED(void *priv), UNUSED(int memsize),
+          UNUSED(void (*recalctimings_ex)(struct svga_t *svga)),
+          UNUSED(uint8_t (*video_in)(uint16_t addr, void *priv)),
+          UNUSED(void (*video_out)(uint16_t addr, uint8_t val, void *priv)),
+          UNUSED(void (*hwcursor_draw)(struct svga_t *svga, int displine)),
+          UNUSED(void (*overlay_draw)(struct svga_t *svga, int displine)))
+{
+    return 0;
+}
+
+void
+svga_close(UNUSED(svga_t *svga))
+{
+}
+
+void
+svga_recalctimings(UNUSED(svga_t *svga))
+{
+}
+
+uint8_t
+svga_in(UNUSED(uint16_t addr), UNUSED(void *priv))
+{
+    return 0xff;
+}
+
+void
+svga_out(UNUSED(uint16_t addr), UNUSED(uint8_t val), UNUSED(void *priv))
+{
+}
+
+uint8_t
+svga_read_linear(UNUSED(uint32_t addr), UNUSED(void *priv))
+{
+    return 0xff;
+}
+
+uint16_t
+svga_readw_linear(UNUSED(uint32_t addr), UNUSED(void *priv))
+{
+    return 0xffff;
+}
+
+uint32_t
+svga_readl_linear(UNUSED(uint32_t addr), UNUSED(void *priv))
+{
+    return 0xffffffff;
+}
+
+void
+svga_write_linear(UNUSED(uint32_t addr), UNUSED(uint8_t val), UNUSED(void *priv))
+{
+}
+
+void
+svga_writew_linear(UNUSED(uint32_t addr), UNUSED(uint16_t val), UNUSED(void *priv))
+{
+}
+
+void
+svga_writel_linear(UNUSED(uint32_t addr), UNUSED(uint32_t val), UNUSED(void *priv))
+{
+}
+
+#define RENDER_STUB(name)                \
+    void name(UNUSED(svga_t *svga)) \
+    {                                    \
+    }
+
+RENDER_STUB(svga_render_2bpp_lowres)
+RENDER_STUB(svga_render_2bpp_highres)
+RENDER_STUB(svga_render_2bpp_s3_lowres)
+RENDER_STUB(svga_render_2bpp_s3_highres)
+RENDER_STUB(svga_render_8bpp_highres)
+RENDER_STUB(svga_render_15bpp_highres)
+RENDER_STUB(svga_render_16bpp_highres)
+RENDER_STUB(svga_render_24bpp_highres)
+RENDER_STUB(svga_render_32bpp_highres)
+
+/* RAMDACs and clock generators. */
+void
+att49x_ramdac_out(UNUSED(uint16_t addr), UNUSED(int rs2), UNUSED(uint8_t val), UNUSED(void *priv), UNUSED(svga_t *svga))
+{
+}
+
+uint8_t
+att49x_ramdac_in(UNUSED(uint16_t addr), UNUSED(int rs2), UNUSED(void *priv), UNUSED(svga_t *svga))
+{
+    return 0xff;
+}
+
+void
+att498_ramdac_out(UNUSED(uint16_t addr), UNUSED(int rs2), UNUSED(uint8_t val), UNUSED(void *priv), UNUSED(svga_t *svga))
+{
+}
+
+uint8_t
+att498_ramdac_in(UNUSED(uint16_t addr), UNUSED(int rs2), UNUSED(void *priv), UNUSED(svga_t *svga))
+{
+    return 0xff;
+}
+
+float
+av9194_getclock(UNUSED(int clock), UNUSED(void *priv))
+{
+    return 25175000.0f;
+}
+
+void
+bt48x_ramdac_out(UNUSED(uint16_t addr), UNUSED(int rs2), UNUSED(int rs3), UNUSED(uint8_t val), UNUSED(void *priv), UNUSED(svga_t *svga))
+{
+}
+
+uint8_t
+bt48x_ramdac_in(UNUSED(uint16_t addr), UNUSED(int rs2), UNUSED(int rs3), UNUSED(void *priv), UNUSED(svga_t *svga))
+{
+    return 0xff;
+}
+
+void
+bt48x_recalctimings(UNUSED(void *priv), UNUSED(svga_t *svga))
+{
+}
+
+void
+bt48x_hwcursor_draw(UNUSED(svga_t *svga), UNUSED(int displine))
+{
+}
+
+void
+ibm_rgb528_ramdac_out(UNUSED(uint16_t addr), UNUSED(int rs2), UNUSED(uint8_t val), UNUSED(void *priv), UNUSED(svga_t *svga))
+{
+}
+
+uint8_t
+ibm_rgb528_ramdac_in(UNUSED(uint16_t addr), UNUSED(int rs2), UNUSED(void *priv), UNUSED(svga_t *svga))
+{
+    return 0xff;
+}
+
+void
+ibm_rgb528_recalctimings(UNUSED(void *priv), UNUSED(svga_t *svga))
+{
+}
+
+void
+ibm_rgb528_hwcursor_draw(UNUSED(svga_t *svga), UNUSED(int displine))
+{
+}
+
+float
+ibm_rgb528_getclock(UNUSED(int clock), UNUSED(void *priv))
+{
+    return 25175000.0f;
+}
+
+void
+ibm_rgb528_ramdac_set_ref_clock(UNUSED(void *priv), UNUSED(svga_t *svga), UNUSED(float ref_clock))
+{
+}
+
+void
+icd2061_write(UNUSED(void *priv), UNUSED(int val))
+{
+}
+
+float
+icd2061_getclock(UNUSED(int clock), UNUSED(void *priv))
+{
+    return 25175000.0f;
+}
+
+void
+icd2061_set_ref_clock(UNUSED(void *priv), UNUSED(float ref_clock))
+{
+}
+
+float
+ics2494_getclock(UNUSED(int clock), UNUSED(void *priv))
+{
+    return 25175000.0f;
+}
+
+void
+sc1148x_ramdac_out(UNUSED(uint16_t addr), UNUSED(int rs2), UNUSED(uint8_t val), UNUSED(void *priv), UNUSED(svga_t *svga))
+{
+}
+
+uint8_t
+sc1148x_ramdac_in(UNUSED(uint16_t addr), UNUSED(int rs2), UNUSED(void *priv), UNUSED(svga_t *svga))
+{
+    return 0xff;
+}
+
+void
+sc1502x_ramdac_out(UNUSED(uint16_t addr), UNUSED(uint8_t val), UNUSED(void *priv), UNUSED(svga_t *svga))
+{
+}
+
+uint8_t
+sc1502x_ramdac_in(UNUSED(uint16_t addr), UNUSED(void *priv), UNUSED(svga_t *svga))
+{
+    return 0xff;
+}
+
+void
+sdac_ramdac_out(UNUSED(uint16_t addr), UNUSED(int rs2), UNUSED(uint8_t val), UNUSED(void *priv), UNUSED(svga_t *svga))
+{
+}
+
+uint8_t
+sdac_ramdac_in(UNUSED(uint16_t addr), UNUSED(int rs2), UNUSED(void *priv), UNUSED(svga_t *svga))
+{
+    return 0xff;
+}
+
+float
+sdac_getclock(UNUSED(int clock), UNUSED(void *priv))
+{
+    return 25175000.0f;
+}
+
+void
+sdac_set_ref_clock(UNUSED(void *priv), UNUSED(float ref_clock))
+{
+}
+
+void
+tvp3026_ramdac_out(UNUSED(uint16_t addr), UNUSED(int rs2), UNUSED(int rs3), UNUSED(uint8_t val), UNUSED(void *priv), UNUSED(svga_t *svga))
+{
+}
+
+uint8_t
+tvp3026_ramdac_in(UNUSED(uint16_t addr), UNUSED(int rs2), UNUSED(int rs3), UNUSED(void *priv), UNUSED(svga_t *svga))
+{
+    return 0xff;
+}
+
+void
+tvp3026_recalctimings(UNUSED(void *priv), UNUSED(svga_t *svga))
+{
+}
+
+void
+tvp3026_hwcursor_draw(UNUSED(svga_t *svga), UNUSED(int displine))
+{
+}
+
+float
+tvp3026_getclock(UNUSED(int clock), UNUSED(void *priv))
+{
+    return 25175000.0f;
+}
+
+uint32_t
+tvp3026_conv_16to32(UNUSED(svga_t *svga), uint16_t color, UNUSED(uint8_t bpp))
+{
+    return color;
+}
+
+/* The check itself. */
+static uint8_t   vram_init[VRAM_SIZE];
+static uint8_t   vram_fast[VRAM_SIZE];
+static uint8_t   vram_ref[VRAM_SIZE];
+static uint8_t   changed_fast[VRAM_SIZE >> 12];
+static uint8_t   changed_ref[VRAM_SIZE >> 12];
+static monitor_t monitor;
+static s3_t      s3_start;
+static s3_t      s3_fast;
+static s3_t      s3;
+static uint32_t  rng_state = 0x12345678;
+
+/*
+   accel.pix_trans_val is a 4 MB buffer for CPU transfers, which none of
+   the operations checked here use; it is left out of every copy and
+   compare.
+ */
+#define PIX_TRANS_START offsetof(s3_t, accel.pix_trans_val)
+#define PIX_TRANS_END   (PIX_TRANS_START + sizeof(s3.accel.pix_trans_val))
+#define ACCEL_START     offsetof(s3_t, accel)
+#define ACCEL_END       (ACCEL_START + sizeof(s3.accel))
+
+static void
+state_clear(s3_t *dst)
+{
+    memset(dst, 0, PIX_TRANS_START);
+    memset((uint8_t *) dst + PIX_TRANS_END, 0, sizeof(s3_t) - PIX_TRANS_END);
+}
+
+/* Copies bytes [start, end) of the state, which must span pix_trans_val. */
+static void
+state_copy(s3_t *dst, const s3_t *src, size_t start, size_t end)
+{
+    memcpy((uint8_t *) dst + start, (const uint8_t *) src + start, PIX_TRANS_START - start);
+    memcpy((uint8_t *) dst + PIX_TRANS_END, (const uint8_t *) src + PIX_TRANS_END, end - PIX_TRANS_END);
+}
+
+static int
+state_differs(const s3_t *a, const s3_t *b, size_t start, size_t end)
+{
+    return memcmp((const uint8_t *) a + start, (const uint8_t *) b + start, PIX_TRANS_START - start) ||
+           memcmp((const uint8_t *) a + PIX_TRANS_END, (const uint8_t *) b + PIX_TRANS_END, end - PIX_TRANS_END);
+}
+
+static uint32_t
+rng(void)
+{
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+
+    return rng_state;
+}
+
+/* Mostly states the fast path takes, with a share of ones it must turn down. */
+static void
+random_state(void)
+{
+    static const int chips[] = { S3_VISION864, S3_VISION964, S3_TRIO64, S3_VISION968 };
+    static const int cmds[]  = { 2, 6, 7 };
+    static const int bpps[]  = { 0, 1, 3 };
+    static const int pitch[] = { 640, 800, 1024, 1280 };
+    int              bpp     = bpps[rng() % 3];
+    int              w;
+    int              h;
+    int              x;
+    int              y;
+
+    state_clear(&s3_start);
+
+    s3_start.chip      = chips[rng() & 3];
+    s3_start.bpp       = bpp;
+    s3_start.vram_mask = VRAM_SIZE - 1;
+    s3_start.width     = (rng() & 3) ? pitch[rng() & 3] : (8 + (rng() % 1024));
+
+    s3_start.svga.bpp           = (bpp == 0) ? 8 : ((bpp == 1) ? 16 : 32);
+    s3_start.svga.packed_chain4 = 1;
+    s3_start.svga.monitor       = &monitor;
+    if (!(rng() & 15))
+        s3_start.svga.bpp = 24;
+    if (!(rng() & 15))
+        s3_start.color_16bit = 1;
+
+    w = (rng() & 3) ? (1 + (rng() % 96)) : (1 + (rng() % 700));
+    h = (rng() & 3) ? (1 + (rng() % 32)) : (1 + (rng() % 300));
+    x = rng() % 1100;
+    y = rng() % 700;
+
+    s3_start.accel.cmd = (cmds[rng() % 3] << 13) | 0x10 | (rng() & 0xa0) | (rng() & 0x600);
+    if (!(rng() & 15))
+        s3_start.accel.cmd |= 0x100; /* CPU data: left to the pixel engine. */
+    if (!(rng() & 15))
+        s3_start.accel.cmd &= ~0x10; /* Draw disabled. */
+
+    s3_start.accel.frgd_mix = ((rng() & 3) << 5) | (rng() & 0xf);
+    s3_start.accel.bkgd_mix = ((rng() & 3) << 5) | (rng() & 0xf);
+
+    s3_start.accel.maj_axis_pcnt = w - 1;
+    s3_start.accel.multifunc[0]  = h - 1;
+    s3_start.accel.cur_x         = x;
+    s3_start.accel.cur_y         = y;
+
+    /* Sources near the destination, so that copies overlap in every direction. */
+    if (rng() & 1) {
+        s3_start.accel.destx_distp = (x + (rng() % 17) - 8) & 0xfff;
+        s3_start.accel.desty_axstp = (y + (rng() % 9) - 4) & 0xfff;
+    } else {
+        s3_start.accel.destx_distp = rng() % 1100;
+        s3_start.accel.desty_axstp = rng() % 700;
+    }
+
+    if (rng() & 1) {
+        s3_start.accel.multifunc[1] = 0;
+        s3_start.accel.multifunc[2] = 0;
+        s3_start.accel.multifunc[3] = 0xfff;
+        s3_start.accel.multifunc[4] = 0xfff;
+    } else {
+        s3_start.accel.multifunc[1] = rng() % 500;
+        s3_start.accel.multifunc[2] = rng() % 800;
+        s3_start.accel.multifunc[3] = rng() % 800;
+        s3_start.accel.multifunc[4] = rng() % 1200;
+    }
+
+    s3_start.accel.multifunc[0xa] = (rng() & 7) ? 0 : (rng() & 0xff);
+    s3_start.accel.multifunc[0xd] = (rng() & 3) ? 0 : (rng() & 0x77);
+    s3_start.accel.multifunc[0xe] = (rng() & 7) ? 0 : (rng() & 0x1ff);
+
+    s3_start.accel.wrt_mask   = (rng() & 1) ? 0xffffffff : rng();
+    s3_start.accel.rd_mask    = (rng() & 1) ? 0xffffffff : rng();
+    s3_start.accel.frgd_color = rng();
+    s3_start.accel.bkgd_color = rng();
+    s3_start.accel.color_cmp  = rng();
+}
+
+static void
+run(uint8_t *vram, uint8_t *changed, int fast)
+{
+    state_copy(&s3, &s3_start, 0, sizeof(s3_t));
+    s3.svga.vram        = vram;
+    s3.svga.changedvram = changed;
+
+    s3_accel_fast_enabled = fast;
+    s3_accel_start(-1, 0, 0xffffffff, 0, &s3);
+}
+
+static int
+check_one(int test)
+{
+    random_state();
+
+    memcpy(vram_fast, vram_init, VRAM_SIZE);
+    memcpy(vram_ref, vram_init, VRAM_SIZE);
+    memset(changed_fast, 0, sizeof(changed_fast));
+    memset(changed_ref, 0, sizeof(changed_ref));
+
+    run(vram_fast, changed_fast, 1);
+    state_copy(&s3_fast, &s3, ACCEL_START, ACCEL_END);
+    run(vram_ref, changed_ref, 0);
+
+    if (memcmp(vram_fast, vram_ref, VRAM_SIZE) || memcmp(changed_fast, changed_ref, sizeof(changed_ref)) ||
+        state_differs(&s3_fast, &s3, ACCEL_START, ACCEL_END)) {
+        printf("  test %i: cmd=%04x bpp=%i mix=%02x width=%i differs\n", test, s3_start.accel.cmd, s3_start.bpp,
+               s3_start.accel.frgd_mix, s3_start.width);
+        return 1;
+    }
+
+    return 0;
+}
+
+static uint64_t
+now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t) ts.tv_sec * 1000000000ULL) + (uint64_t) ts.tv_nsec;
+}
+
+static double
+time_op(int cmd, int bpp, int mix, int fast)
+{
+    const int iters = 200;
+    uint64_t  start;
+
+    state_clear(&s3_start);
+    s3_start.chip               = S3_TRIO64;
+    s3_start.bpp                = bpp;
+    s3_start.vram_mask          = VRAM_SIZE - 1;
+    s3_start.width              = 1024 >> ((bpp == 3) ? 1 : 0);
+    s3_start.svga.bpp           = (bpp == 0) ? 8 : ((bpp == 1) ? 16 : 32);
+    s3_start.svga.packed_chain4 = 1;
+    s3_start.svga.monitor       = &monitor;
+
+    s3_start.accel.cmd           = (cmd << 13) | 0xb0;
+    s3_start.accel.frgd_mix      = mix;
+    s3_start.accel.maj_axis_pcnt = 255;
+    s3_start.accel.multifunc[0]  = 127;
+    s3_start.accel.multifunc[3]  = 0xfff;
+    s3_start.accel.multifunc[4]  = 0xfff;
+    s3_start.accel.cur_y         = 200;
+    s3_start.accel.destx_distp   = 16;
+    s3_start.accel.desty_axstp   = 8;
+    s3_start.accel.wrt_mask      = 0xffffffff;
+    s3_start.accel.frgd_color    = 0x12345678;
+
+    run(vram_fast, changed_fast, fast);
+
+    start = now_ns();
+    for (int i = 0; i < iters; i++) {
+        state_copy(&s3, &s3_start, ACCEL_START, ACCEL_END);
+        s3_accel_start(-1, 0, 0xffffffff, 0, &s3);
+    }
+
+    return (double) (now_ns() - start) / iters / 1000.0;
+}
+
+int
+main(void)
+{
+    static const struct {
+        const char *name;
+        int         cmd;
+        int         mix;
+    } ops[] = {
+        {"fill   ", 2, 0x27},
+        { "copy   ", 6, 0x67},
+        { "xor    ", 6, 0x65},
+        { "pattern", 7, 0x67},
+    };
+    int errors = 0;
+
+    for (int i = 0; i < VRAM_SIZE; i++)
+        vram_init[i] = rng();
+
+    for (int t = 0; (t < TESTS) && (errors < 10); t++)
+        errors += check_one(t);
+
+    printf("s3_accel_check: %s\n", errors ? "FAILED" : "ok");
+
+    if (!errors) {
+        printf("256x128 rectangle:\n");
+        for (int bpp = 0; bpp < 4; bpp++) {
+            if (bpp == 2)
+                continue;
+
+            for (int i = 0; i < (int) (sizeof(ops) / sizeof(ops[0])); i++) {
+                const double slow = time_op(ops[i].cmd, bpp, ops[i].mix, 0);
+                const double fast = time_op(ops[i].cmd, bpp, ops[i].mix, 1);
+
+                printf("  %2ibpp %s: %8.2f us (per-pixel %8.2f us)  speedup %.2fx\n", (bpp == 3) ? 32 : (8 << bpp), ops[i].name,
+                       fast, slow, slow / fast);
+            }
+        }
+    }
+
+    return errors ? 1 : 0;
+}
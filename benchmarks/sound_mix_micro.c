@@ -0,0 +1,239 @@
+/*
+ * Sound output kernel micro-benchmark.
+ *
+ * Checks the kernels in sound_mix.c against the per-sample loops they
+ * replace (the float/int16 conversion of the output mixer) for every
+ * length up to a few vectors, compares the
+ * single-precision stereo biquad with the double sb_iir() recurrence of
+ * filters.h, then times one output block of each.
+ */
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "bench_common.h"
+#include <86box/sound_mix.h>
+
+#define FRAMES  960 /* SOUNDBUFLEN at 48 kHz */
+#define SAMPLES (FRAMES * 2)
+
+static int32_t mix_init[SAMPLES];
+static int32_t mix_ref[SAMPLES];
+static int32_t mix_test[SAMPLES];
+static int16_t dac_init[SAMPLES];
+static float   out_ref[SAMPLES];
+static float   out_test[SAMPLES];
+static int16_t out16_ref[SAMPLES];
+static int16_t out16_test[SAMPLES];
+
+static const double filter_b[3] = { 0.03356837051492005100, 0.06713674102984010200, 0.03356837051492005100 };
+static const double filter_a[3] = { 1.00000000000000000000, -1.41898265221812010000, 0.55326988968868285000 };
+
+/* The loop sound_stream_output() used to run. */
+static void
+reference_convert(int32_t *mix, float *out, int16_t *out_int16, int is_float, int n)
+{
+    for (int c = 0; c < n; c++) {
+        if (is_float)
+            out[c] = ((float) mix[c]) / (float) 32768.0;
+        else {
+            if (mix[c] > 32767)
+                mix[c] = 32767;
+            if (mix[c] < -32768)
+                mix[c] = -32768;
+
+            out_int16[c] = (int16_t) mix[c];
+        }
+    }
+}
+
+/* sb_iir() from filters.h, one channel of state per lane. */
+typedef struct reference_iir_t {
+    double x[2][3];
+    double y[2][3];
+} reference_iir_t;
+
+static double
+reference_iir(reference_iir_t *f, int i, double sample)
+{
+    for (int n = 2; n > 0; n--) {
+        f->x[i][n] = f->x[i][n - 1];
+        f->y[i][n] = f->y[i][n - 1];
+    }
+
+    f->x[i][0] = sample;
+    f->y[i][0] = filter_b[0] * f->x[i][0];
+    for (int n = 1; n <= 2; n++)
+        f->y[i][0] += filter_b[n] * f->x[i][n] - filter_a[n] * f->y[i][n];
+
+    return f->y[i][0];
+}
+
+static uint64_t
+now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ull + (uint64_t) ts.tv_nsec;
+}
+
+static int
+verify_convert(void)
+{
+    for (int n = 0; n <= 67; n++) {
+        memcpy(mix_ref, mix_init, sizeof(mix_ref));
+        memset(out_ref, 0, sizeof(out_ref));
+        memset(out_test, 0, sizeof(out_test));
+        reference_convert(mix_ref, out_ref, NULL, 1, n);
+        sound_mix_to_float(out_test, mix_init, n);
+        if (memcmp(out_ref, out_test, sizeof(out_ref))) {
+            printf("  to_float: MISMATCH (n=%d)\n", n);
+            return 0;
+        }
+
+        memset(out16_ref, 0, sizeof(out16_ref));
+        memset(out16_test, 0, sizeof(out16_test));
+        reference_convert(mix_ref, NULL, out16_ref, 0, n);
+        sound_mix_to_int16(out16_test, mix_init, n);
+        if (memcmp(out16_ref, out16_test, sizeof(out16_ref))) {
+            printf("  to_int16: MISMATCH (n=%d)\n", n);
+            return 0;
+        }
+
+        for (int i = 0; i < n; i++)
+            out_ref[i] = (float) dac_init[i];
+        memset(&out_ref[n], 0, sizeof(out_ref) - n * sizeof(float));
+        memset(out_test, 0, sizeof(out_test));
+        sound_mix_s16_to_float(out_test, dac_init, n);
+        if (memcmp(out_ref, out_test, sizeof(out_ref))) {
+            printf("  s16_to_float: MISMATCH (n=%d)\n", n);
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+/* Largest difference from the double filter over a few blocks, in 16-bit LSBs. */
+static double
+verify_biquad(void)
+{
+    reference_iir_t ref = { 0 };
+    sound_biquad_t  bq;
+    double          worst = 0.0;
+
+    sound_biquad_init(&bq, filter_b, filter_a);
+    for (int block = 0; block < 50; block++) {
+        sound_mix_s16_to_float(out_test, dac_init, SAMPLES);
+        sound_biquad_stereo(&bq, out_test, FRAMES);
+
+        for (int c = 0; c < SAMPLES; c++) {
+            const double d = fabs(reference_iir(&ref, c & 1, (double) dac_init[c]) - out_test[c]);
+
+            if (d > worst)
+                worst = d;
+        }
+    }
+
+    return worst;
+}
+
+typedef enum bench_kind_t {
+    BENCH_TO_FLOAT,
+    BENCH_TO_INT16,
+    BENCH_BIQUAD
+} bench_kind_t;
+
+static const char *const bench_names[] = { "to float", "to int16", "biquad" };
+
+static double
+time_op(bench_kind_t kind, int use_ref, uint64_t iters)
+{
+    reference_iir_t ref = { 0 };
+    sound_biquad_t  bq;
+    uint64_t        start;
+
+    sound_biquad_init(&bq, filter_b, filter_a);
+    memcpy(mix_test, mix_init, sizeof(mix_test));
+
+    start = now_ns();
+    for (uint64_t i = 0; i < iters; i++) {
+        switch (kind) {
+            case BENCH_TO_FLOAT:
+                if (use_ref)
+                    reference_convert(mix_test, out_test, NULL, 1, SAMPLES);
+                else
+                    sound_mix_to_float(out_test, mix_test, SAMPLES);
+                break;
+            case BENCH_TO_INT16:
+                if (use_ref)
+                    reference_convert(mix_test, NULL, out16_test, 0, SAMPLES);
+                else
+                    sound_mix_to_int16(out16_test, mix_test, SAMPLES);
+                break;
+            case BENCH_BIQUAD:
+                if (use_ref) {
+                    for (int c = 0; c < SAMPLES; c++)
+                        out_test[c] = (float) reference_iir(&ref, c & 1, (double) dac_init[c]);
+                } else {
+                    sound_mix_s16_to_float(out_test, dac_init, SAMPLES);
+                    sound_biquad_stereo(&bq, out_test, FRAMES);
+                }
+                break;
+        }
+        BENCH_CLOBBER();
+    }
+
+    return (double) (now_ns() - start) / (double) iters;
+}
+
+int
+main(int argc, char **argv)
+{
+    uint64_t iters    = 20000ull;
+    int      failures = 0;
+    double   worst;
+
+    for (int i = 1; i < argc; ++i) {
+        if (strncmp(argv[i], "--iters=", 8) == 0) {
+            iters = strtoull(argv[i] + 8, NULL, 10);
+        } else if (strcmp(argv[i], "--help") == 0) {
+            printf("Usage: %s [--iters=N]\n", argv[0]);
+            return 0;
+        }
+    }
+
+    /* Mixed output spans well past 16 bits so that the clamp is exercised. */
+    srand(86);
+    for (int i = 0; i < SAMPLES; i++) {
+        mix_init[i] = (rand() % 131072) - 65536;
+        dac_init[i] = (int16_t) ((rand() & 0xffff) - 32768);
+    }
+    mix_init[0] = 1 << 24;
+    mix_init[1] = -(1 << 24);
+
+    if (verify_convert())
+        printf("conversions: exact\n");
+    else
+        failures++;
+
+    worst = verify_biquad();
+    printf("biquad: max difference from double %.4f LSB\n", worst);
+    if (worst > 0.5)
+        failures++;
+
+    printf("%d frames/block, %llu blocks\n", FRAMES, (unsigned long long) iters);
+    for (int k = BENCH_TO_FLOAT; k <= BENCH_BIQUAD; k++) {
+        const double ref = time_op(k, 1, iters);
+        const double ns  = time_op(k, 0, iters);
+
+        printf("  %-10s: %9.1f ns/block  (per-sample %9.1f)  speedup %.2fx\n",
+               bench_names[k], ns, ref, ratio(ref, ns));
+    }
+
+    return failures ? 1 : 0;
+}
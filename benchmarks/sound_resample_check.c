@@ -0,0 +1,180 @@
+/*
+ * Sound resampler check.
+ *
+ * Feeds sine tones through sound_resample.c at the rate pairs the mixer
+ * uses, in blocks of the size the sources deliver, and compares the
+ * output with the ideal sine at the output rate: the error for tones in
+ * the passband, and for down conversion how much of a tone between the
+ * two Nyquist frequencies aliases back. Then times the conversion of a
+ * block of noise.
+ */
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "bench_common.h"
+#include <86box/sound_resample.h>
+
+#define AMPLITUDE 16384.0
+#define SECONDS   2
+
+typedef struct rate_pair_t {
+    int in_rate;
+    int out_rate;
+    int block; /* Source block length in frames. */
+} rate_pair_t;
+
+static const rate_pair_t pairs[] = {
+    { 49716, 48000, 49716 / 36 }, /* OPL music stream */
+    { 44100, 48000, 49716 / 45 }, /* Wavetable stream */
+    { 44100, 48000, 44100 / 10 }, /* CD audio */
+    { 48000, 96000, 48000 / 50 }, /* Sound stream to a 96 kHz device */
+    { 49716, 96000, 49716 / 36 },
+    { 48000, 44100, 48000 / 50 }
+};
+
+static uint64_t
+now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ull + (uint64_t) ts.tv_nsec;
+}
+
+/*
+   Converts SECONDS of a tone at freq and returns the output, with the
+   number of frames in *count. The converter adds no delay: output frame j
+   is the input at time j / out_rate.
+ */
+static int32_t *
+convert_tone(const rate_pair_t *p, double freq, int *count)
+{
+    sound_resampler_t *rs     = sound_resampler_create(p->in_rate, p->out_rate);
+    const int          frames = p->in_rate * SECONDS;
+    int32_t           *in     = malloc(p->block * 2 * sizeof(int32_t));
+    int32_t           *out    = malloc((sound_resampler_out_max(rs, frames) + p->block) * 2 * sizeof(int32_t));
+    int                done   = 0;
+
+    for (int pos = 0; pos < frames; pos += p->block) {
+        for (int i = 0; i < p->block; i++) {
+            const double v = AMPLITUDE * sin(2.0 * M_PI * freq * (double) (pos + i) / (double) p->in_rate);
+
+            in[i * 2]     = (int32_t) lrint(v);
+            in[i * 2 + 1] = (int32_t) lrint(-v);
+        }
+        done += sound_resampler_process(rs, in, p->block, &out[done * 2]);
+    }
+
+    free(in);
+    sound_resampler_close(rs);
+
+    *count = done;
+    return out;
+}
+
+/* Error against the ideal sine relative to the tone, in dB. The first and last 1000 frames are skipped. */
+static double
+tone_error_db(const rate_pair_t *p, double freq)
+{
+    int      count;
+    int32_t *out = convert_tone(p, freq, &count);
+    double   sig = 0.0;
+    double   err = 0.0;
+
+    for (int j = 1000; j < (count - 1000); j++) {
+        const double ideal = AMPLITUDE * sin(2.0 * M_PI * freq * (double) j / (double) p->out_rate);
+
+        sig += ideal * ideal;
+        err += (out[j * 2] - ideal) * (out[j * 2] - ideal);
+        err += (out[j * 2 + 1] + ideal) * (out[j * 2 + 1] + ideal);
+    }
+
+    free(out);
+    return 10.0 * log10((err / 2.0) / sig);
+}
+
+/* Level of the output for a tone that the output rate cannot carry, relative to the tone, in dB. */
+static double
+alias_db(const rate_pair_t *p, double freq)
+{
+    int      count;
+    int32_t *out = convert_tone(p, freq, &count);
+    double   pwr = 0.0;
+
+    for (int j = 1000; j < (count - 1000); j++)
+        pwr += (double) out[j * 2] * (double) out[j * 2];
+
+    free(out);
+    return 10.0 * log10((pwr / (count - 2000)) / (AMPLITUDE * AMPLITUDE / 2.0));
+}
+
+static double
+time_pair(const rate_pair_t *p, uint64_t iters)
+{
+    sound_resampler_t *rs   = sound_resampler_create(p->in_rate, p->out_rate);
+    int32_t           *in   = malloc(p->block * 2 * sizeof(int32_t));
+    int32_t           *out  = malloc(sound_resampler_out_max(rs, p->block) * 2 * sizeof(int32_t));
+    uint64_t           made = 0;
+    uint64_t           start;
+
+    srand(86);
+    for (int i = 0; i < (p->block * 2); i++)
+        in[i] = (rand() % 65536) - 32768;
+
+    start = now_ns();
+    for (uint64_t i = 0; i < iters; i++) {
+        made += sound_resampler_process(rs, in, p->block, out);
+        BENCH_CLOBBER();
+    }
+    start = now_ns() - start;
+
+    free(out);
+    free(in);
+    sound_resampler_close(rs);
+
+    return (double) start / (double) made;
+}
+
+int
+main(int argc, char **argv)
+{
+    uint64_t iters    = 2000ull;
+    int      failures = 0;
+
+    for (int i = 1; i < argc; ++i) {
+        if (strncmp(argv[i], "--iters=", 8) == 0) {
+            iters = strtoull(argv[i] + 8, NULL, 10);
+        } else if (strcmp(argv[i], "--help") == 0) {
+            printf("Usage: %s [--iters=N]\n", argv[0]);
+            return 0;
+        }
+    }
+
+    for (size_t i = 0; i < (sizeof(pairs) / sizeof(pairs[0])); i++) {
+        const rate_pair_t *p    = &pairs[i];
+        const double       e1k  = tone_error_db(p, 1000.0);
+        const double       e10k = tone_error_db(p, 10000.0);
+        const double       e16k = tone_error_db(p, 16000.0);
+        const double       ns   = time_pair(p, iters);
+
+        printf("%5d -> %5d Hz, %4d-frame blocks\n", p->in_rate, p->out_rate, p->block);
+        printf("  error   : 1 kHz %6.1f dB, 10 kHz %6.1f dB, 16 kHz %6.1f dB\n", e1k, e10k, e16k);
+        if (p->in_rate > p->out_rate) {
+            const double a = alias_db(p, 0.25 * (p->in_rate + p->out_rate));
+
+            printf("  alias   : %6.1f dB\n", a);
+            if (a > -70.0)
+                failures++;
+        }
+        printf("  speed   : %6.1f ns/frame (%.0fx real time)\n", ns, 1e9 / (ns * p->out_rate));
+
+        if ((e1k > -80.0) || (e10k > -80.0) || (e16k > -80.0))
+            failures++;
+    }
+
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,237 @@
+/*
+ * SVGA scanline converter micro-benchmark.
+ *
+ * Checks every compiled-in kernel set from vid_svga_render_simd.c for
+ * bit-exactness against a reference built the same way as the scalar
+ * renderers in vid_svga_render.c (video_15to32[]/video_16to32[] tables,
+ * map8[] palette lookups, dword-assembled 24bpp pixels), then times them.
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "bench_common.h"
+#include <86box/vid_svga_render_simd.h>
+
+#define LINE_PIXELS 1600 /* Widest common mode is 1600x1200. */
+#define SRC_BYTES   (LINE_PIXELS * 4 + 64)
+
+typedef enum kernel_id {
+    K_PAL8 = 0,
+    K_RGB555,
+    K_RGB565,
+    K_RGB888,
+    K_XRGB8888,
+    K_COUNT
+} kernel_id_t;
+
+static const char *const kernel_names[K_COUNT] = { "8bpp", "15bpp", "16bpp", "24bpp", "32bpp" };
+
+static uint32_t table_15to32[65536];
+static uint32_t table_16to32[65536];
+static uint32_t map8[256];
+static uint8_t  src_buf[SRC_BYTES];
+static uint32_t dst_ref[LINE_PIXELS + 16];
+static uint32_t dst_test[LINE_PIXELS + 16];
+
+/* Copies of calc_15to32()/calc_16to32() from video.c. */
+static uint32_t
+calc_15to32(int c)
+{
+    int b = (int) ((((double) (c & 31)) / 31.0) * 255.0);
+    int g = (int) ((((double) ((c >> 5) & 31)) / 31.0) * 255.0);
+    int r = (int) ((((double) ((c >> 10) & 31)) / 31.0) * 255.0);
+
+    return b | (g << 8) | (r << 16) | 0xff000000;
+}
+
+static uint32_t
+calc_16to32(int c)
+{
+    int b = (int) ((((double) (c & 31)) / 31.0) * 255.0);
+    int g = (int) ((((double) ((c >> 5) & 63)) / 63.0) * 255.0);
+    int r = (int) ((((double) ((c >> 11) & 31)) / 31.0) * 255.0);
+
+    return b | (g << 8) | (r << 16) | 0xff000000;
+}
+
+static uint32_t
+rd32(const uint8_t *p)
+{
+    uint32_t v;
+
+    memcpy(&v, p, 4);
+    return v;
+}
+
+static void
+reference(kernel_id_t k, uint32_t *dst, const uint8_t *src, int count, uint8_t mask)
+{
+    for (int i = 0; i < count; i++) {
+        switch (k) {
+            case K_PAL8:
+                dst[i] = map8[src[i] & mask];
+                break;
+            case K_RGB555:
+                dst[i] = table_15to32[(src[i * 2] | (src[i * 2 + 1] << 8)) & 0x7fff];
+                break;
+            case K_RGB565:
+                dst[i] = table_16to32[src[i * 2] | (src[i * 2 + 1] << 8)];
+                break;
+            case K_RGB888:
+                dst[i] = rd32(src + i * 3) & 0xffffff;
+                break;
+            case K_XRGB8888:
+                dst[i] = rd32(src + i * 4) & 0xffffff;
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+static void
+run_kernel(const svga_render_kernels_t *kern, kernel_id_t k, uint32_t *dst, const uint8_t *src, int count, uint8_t mask)
+{
+    switch (k) {
+        case K_PAL8:
+            kern->pal8(dst, src, count, map8, mask);
+            break;
+        case K_RGB555:
+            kern->rgb555(dst, src, count);
+            break;
+        case K_RGB565:
+            kern->rgb565(dst, src, count);
+            break;
+        case K_RGB888:
+            kern->rgb888(dst, src, count);
+            break;
+        case K_XRGB8888:
+            kern->xrgb8888(dst, src, count);
+            break;
+        default:
+            break;
+    }
+}
+
+static uint64_t
+now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ull + (uint64_t) ts.tv_nsec;
+}
+
+/* Every line length up to 64 pixels (all tail paths) plus full lines, at odd source offsets. */
+static int
+verify(const svga_render_kernels_t *kern, kernel_id_t k)
+{
+    static const uint8_t masks[] = { 0xff, 0x0f };
+
+    for (int offset = 0; offset < 4; offset++) {
+        for (int count = 0; count <= LINE_PIXELS; count = (count < 64) ? (count + 1) : (count * 2 + 5)) {
+            for (size_t m = 0; m < sizeof(masks); m++) {
+                memset(dst_ref, 0xa5, sizeof(dst_ref));
+                memset(dst_test, 0xa5, sizeof(dst_test));
+                reference(k, dst_ref, src_buf + offset, count, masks[m]);
+                run_kernel(kern, k, dst_test, src_buf + offset, count, masks[m]);
+                if (memcmp(dst_ref, dst_test, sizeof(dst_ref))) {
+                    printf("  %-6s: MISMATCH (count=%d offset=%d mask=%02x)\n", kernel_names[k], count, offset, masks[m]);
+                    return 0;
+                }
+            }
+        }
+    }
+
+    /* The 16bpp converters must match the full lookup tables. */
+    if ((k == K_RGB555) || (k == K_RGB565)) {
+        static uint8_t  all_src[65536 * 2];
+        static uint32_t all_ref[65536];
+        static uint32_t all_test[65536];
+
+        for (int c = 0; c < 65536; c++) {
+            all_src[c * 2]     = c & 0xff;
+            all_src[c * 2 + 1] = c >> 8;
+        }
+        reference(k, all_ref, all_src, 65536, 0xff);
+        run_kernel(kern, k, all_test, all_src, 65536, 0xff);
+        if (memcmp(all_ref, all_test, sizeof(all_ref))) {
+            printf("  %-6s: MISMATCH (exhaustive)\n", kernel_names[k]);
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+static double
+time_kernel(const svga_render_kernels_t *kern, kernel_id_t k, uint64_t lines)
+{
+    uint64_t start = now_ns();
+
+    for (uint64_t i = 0; i < lines; i++) {
+        if (kern != NULL)
+            run_kernel(kern, k, dst_test, src_buf, LINE_PIXELS, 0xff);
+        else
+            reference(k, dst_test, src_buf, LINE_PIXELS, 0xff);
+        BENCH_CLOBBER();
+    }
+
+    return (double) (now_ns() - start) / (double) lines;
+}
+
+int
+main(int argc, char **argv)
+{
+    uint64_t lines    = 200000ull;
+    int      failures = 0;
+    double   ref_ns[K_COUNT];
+
+    for (int i = 1; i < argc; ++i) {
+        if (strncmp(argv[i], "--lines=", 8) == 0) {
+            lines = strtoull(argv[i] + 8, NULL, 10);
+        } else if (strcmp(argv[i], "--help") == 0) {
+            printf("Usage: %s [--lines=N]\n", argv[0]);
+            return 0;
+        }
+    }
+
+    for (int c = 0; c < 65536; c++) {
+        table_15to32[c] = calc_15to32(c & 0x7fff);
+        table_16to32[c] = calc_16to32(c);
+    }
+    srand(86);
+    for (int c = 0; c < 256; c++)
+        map8[c] = ((uint32_t) rand() << 16) ^ (uint32_t) rand();
+    for (int c = 0; c < SRC_BYTES; c++)
+        src_buf[c] = rand() & 0xff;
+
+    printf("reference (renderer loops), %d pixels/line, %llu lines\n", LINE_PIXELS, (unsigned long long) lines);
+    for (int k = 0; k < K_COUNT; k++) {
+        ref_ns[k] = time_kernel(NULL, k, lines);
+        printf("  %-6s: %9.1f ns/line\n", kernel_names[k], ref_ns[k]);
+    }
+
+    for (int impl = 0; impl < SVGA_RENDER_IMPL_MAX; impl++) {
+        const svga_render_kernels_t *kern = svga_render_kernels_get(impl);
+
+        if (kern == NULL)
+            continue;
+
+        printf("impl=%s\n", kern->name);
+        for (int k = 0; k < K_COUNT; k++) {
+            if (!verify(kern, k)) {
+                failures++;
+                continue;
+            }
+
+            double ns = time_kernel(kern, k, lines);
+            printf("  %-6s: %9.1f ns/line  exact  speedup %.2fx\n", kernel_names[k], ns, ratio(ref_ns[k], ns));
+        }
+    }
+
+    return failures ? 1 : 0;
+}
@@ -79,6 +79,7 @@
 #include <86box/mouse.h>
 #include <86box/gameport.h>
 #include <86box/fdd.h>
+#include <86box/fdd_86f.h>
 #include <86box/fdd_audio.h>
 #include <86box/fdc.h>
 #include <86box/fdc_ext.h>
@@ -96,6 +97,7 @@
 #include <86box/thread.h>
 #include <86box/network.h>
 #include <86box/sound.h>
+#include <86box/sound_worker.h>
 #include <86box/plat_unused.h>
 
 #ifdef USE_DYNAREC
@@ -1612,6 +1614,9 @@ pc_reset_hard_close(void)
 
     scsi_disk_close();
 
+    /* The mixer may still be handing buffers to the sources closeal() frees. */
+    sound_mix_thread_end();
+
     closeal();
 
     video_reset_close();
@@ -1871,6 +1876,8 @@ pc_close(UNUSED(thread_t *ptr))
     for (uint8_t i = 0; i < FDD_NUM; i++)
         fdd_close(i);
 
+    d86f_cache_pool_close();
+
 #ifdef ENABLE_808X_LOG
     if (dump_on_exit)
         dumpregs(0);
@@ -1888,8 +1895,14 @@ pc_close(UNUSED(thread_t *ptr))
 
     network_close();
 
+    sound_mix_thread_end();
+
     sound_cd_thread_end();
 
+    sound_fdd_thread_end();
+
+    sound_worker_close();
+
     cdrom_close();
 
     rdisk_close();
@@ -1898,6 +1911,8 @@ pc_close(UNUSED(thread_t *ptr))
 
     scsi_disk_close();
 
+    hdd_image_aio_close();
+
     gdbstub_close();
 }
 
@@ -25,6 +25,7 @@
 #include <86box/device.h>
 #include <86box/config.h>
 #include <86box/cdrom.h>
+#include <86box/cdrom_ecc.h>
 #include <86box/cdrom_image.h>
 #include <86box/cdrom_interface.h>
 #ifdef USE_CDROM_MITSUMI
@@ -293,50 +294,6 @@ msf_to_bcd(int *m, int *s, int *f)
     *f = bin2bcd(*f);
 }
 
-void
-cdrom_compute_ecc_block(cdrom_t *dev, uint8_t *parity, const uint8_t *data,
-                        uint32_t major_count, uint32_t minor_count,
-                        uint32_t major_mult, uint32_t minor_inc, int m2f1)
-{
-    uint32_t size = major_count * minor_count;
-
-    for (uint32_t major = 0; major < major_count; ++major) {
-        uint32_t index = (major >> 1) * major_mult + (major & 1);
-
-        uint8_t ecc_a = 0;
-        uint8_t ecc_b = 0;
-
-        for (uint32_t minor = 0; minor < minor_count; ++minor) {
-            uint8_t temp = data[index];
-
-            if (m2f1 && (index < 4))
-                temp = 0x00;
-
-            index += minor_inc;
-
-            if (index >= size)
-                index -= size;
-
-            ecc_a ^= temp;
-            ecc_b ^= temp;
-            ecc_a = dev->_F_LUT[ecc_a];
-        }
-
-        parity[major] = dev->_B_LUT[dev->_F_LUT[ecc_a] ^ ecc_b];
-        parity[major + major_count] = parity[major] ^ ecc_b;
-    }
-}
-
-static void
-cdrom_generate_ecc_data(cdrom_t *dev, const uint8_t *data, int m2f1)
-{
-    /* Compute ECC P code. */
-    cdrom_compute_ecc_block(dev, dev->p_parity, data, 86, 24, 2, 86, m2f1);
-
-    /* Compute ECC Q code. */
-    cdrom_compute_ecc_block(dev, dev->q_parity, data, 52, 43, 86, 88, m2f1);
-}
-
 static int
 cdrom_is_sector_good(cdrom_t *dev, const uint8_t *b, const uint8_t mode2, const uint8_t form)
 {
@@ -344,16 +301,17 @@ cdrom_is_sector_good(cdrom_t *dev, const uint8_t *b, const uint8_t mode2, const
 
     if (!dev->no_check && (dev->cd_status != CD_STATUS_DVD) && (!mode2 || (form == 1))) {
         if (mode2 && (form == 1)) {
-            const uint32_t crc = cdrom_crc32(0xffffffff, &(b[16]), 2056) ^ 0xffffffff;
+            const uint32_t crc = cdrom_edc(&(b[16]), 2056);
 
             ret = ret && (crc == (*(uint32_t *) &(b[2072])));
         } else if (!mode2) {
-            const uint32_t crc = cdrom_crc32(0xffffffff, b, 2064) ^ 0xffffffff;
+            const uint32_t crc = cdrom_edc(b, 2064);
 
             ret = ret && (crc == (*(uint32_t *) &(b[2064])));
         }
 
-        cdrom_generate_ecc_data(dev, &(b[12]), mode2 && (form == 1));
+        cdrom_ecc_compute_p(&(b[12]), dev->p_parity, mode2 && (form == 1));
+        cdrom_ecc_compute_q(&(b[12]), dev->q_parity, mode2 && (form == 1));
 
         ret = ret && !memcmp(dev->p_parity, &(b[2076]), 172);
         ret = ret && !memcmp(dev->q_parity, &(b[2248]), 104);
@@ -3079,6 +3037,8 @@ cdrom_hard_reset(void)
 {
     cdrom_assigned_letters = 0;
 
+    cdrom_ecc_init();
+
     for (uint8_t i = 0; i < CDROM_NUM; i++) {
         cdrom_t *dev = &cdrom[i];
 
@@ -3140,11 +3100,6 @@ cdrom_hard_reset(void)
 
                 cdrom_load(dev, dev->image_path, 0);
             }
-
-            for (uint32_t j = 0; j < _LUT_SIZE; ++j) {
-                dev->_F_LUT[j] = (j << 1) ^ (j & 0x80 ? 0x11d : 0);
-                dev->_B_LUT[j ^ dev->_F_LUT[j]] = j;
-            }
         }
     }
 
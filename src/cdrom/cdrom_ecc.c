@@ -0,0 +1,437 @@
+/*
+ * 86Box    A hypervisor and IBM PC system emulator that specializes in
+ *          running old operating systems and software designed for IBM
+ *          PC systems and compatibles from 1981 through fairly recent
+ *          system designs based on the PCI bus.
+ *
+ *          This file is part of the 86Box distribution.
+ *
+ *          EDC and Reed-Solomon P/Q parity of CD-ROM sectors.
+ *
+ *          The EDC is a reflected CRC-32 with the polynomial 0xd8018001.
+ *          On x86-64 hosts with PCLMULQDQ, selected at runtime, the data
+ *          is folded 64 bytes at a time with carry-less multiplies down
+ *          to 16 bytes, which have the same remainder; those and the
+ *          tail, or the whole buffer on other hosts, go through the
+ *          braided table CRC of cdrom_crc32().
+ *
+ *          P and Q are each a set of RS(n, n - 2) codewords over GF(2^8):
+ *          P has 86 codewords of 24 data bytes taken down the columns of
+ *          the sector seen as 24 rows of 86 bytes, Q has 52 codewords of
+ *          43 data bytes taken along its diagonals. Every codeword is the same
+ *          Horner recurrence, so the codewords are computed side by side,
+ *          16 to a vector, using SSE2 on x86-64 and NEON on ARM64, with a
+ *          table-driven loop elsewhere. The P columns are read straight
+ *          from the sector; the Q diagonals are gathered straight into the
+ *          lanes, a 16-bit word (both bytes of one codeword pair) at a
+ *          time. benchmarks/cdrom_ecc_micro.c compares them against the
+ *          byte-at-a-time loops they replace.
+ *
+ * Authors: 86Box contributors.
+ *
+ *          Copyright 2026 86Box contributors.
+ */
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <86box/cdrom_ecc.h>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#    define ECC_SSE2
+#    if defined(__GNUC__) || defined(__clang__)
+#        define EDC_CLMUL
+#        define CLMUL_TARGET __attribute__((target("pclmul")))
+#    elif defined(_MSC_VER)
+#        define EDC_CLMUL
+#        define CLMUL_TARGET
+#        include <intrin.h>
+#    endif
+#    include <immintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#    define ECC_NEON
+#    include <arm_neon.h>
+#endif
+
+#define P_COUNT 86 /* Codewords. */
+#define P_ROWS  24 /* Bytes per codeword, less the two of parity. */
+#define Q_COUNT 52
+#define Q_ROWS  43
+#define Q_WORDS 26 /* Codeword pairs; the sector is 26 rows of 43 such pairs. */
+
+static uint8_t ecc_f[256]; /* x * a */
+static uint8_t ecc_b[256]; /* x / (a + 1) */
+static int     ecc_ready;
+
+#ifdef EDC_CLMUL
+static int      edc_clmul;
+static uint64_t edc_fold128[2]; /* Multipliers for the low and high halves of a block. */
+static uint64_t edc_fold512[2];
+
+static int
+cpu_has_clmul(void)
+{
+#    if defined(_MSC_VER) && !defined(__clang__)
+    int regs[4];
+
+    __cpuid(regs, 1);
+    return !!(regs[2] & (1 << 1));
+#    else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("pclmul");
+#    endif
+}
+
+/*
+   x^n mod P, bit-reflected into the upper half of a 64-bit lane, where a
+   carry-less multiply by a reflected block half gives the product times x;
+   hence the n - 1.
+ */
+static uint64_t
+edc_xpow(int n)
+{
+    uint64_t r = 1;
+    uint64_t ret = 0;
+
+    for (int i = 0; i < (n - 1); i++) {
+        r <<= 1;
+        if (r & 0x100000000ULL)
+            r ^= 0x18001801bULL; /* 0xd8018001 unreflected, with the x^32 term. */
+    }
+
+    for (int d = 0; d < 32; d++) {
+        if (r & (1ULL << d))
+            ret |= 1ULL << (63 - d);
+    }
+
+    return ret;
+}
+
+/* Moves the remainder of x 128 or 512 bits on; the low half of x holds the higher powers. */
+static inline CLMUL_TARGET __m128i
+edc_fold(__m128i x, __m128i k)
+{
+    return _mm_xor_si128(_mm_clmulepi64_si128(x, k, 0x00), _mm_clmulepi64_si128(x, k, 0x11));
+}
+
+static CLMUL_TARGET uint32_t
+edc_compute_clmul(const uint8_t *buf, size_t len)
+{
+    const __m128i k128 = _mm_loadu_si128((const __m128i *) edc_fold128);
+    const __m128i k512 = _mm_loadu_si128((const __m128i *) edc_fold512);
+    __m128i       x0   = _mm_loadu_si128((const __m128i *) &buf[0]);
+    __m128i       x1   = _mm_loadu_si128((const __m128i *) &buf[16]);
+    __m128i       x2   = _mm_loadu_si128((const __m128i *) &buf[32]);
+    __m128i       x3   = _mm_loadu_si128((const __m128i *) &buf[48]);
+    uint8_t       rem[16];
+
+    buf += 64;
+    len -= 64;
+
+    for (; len >= 64; buf += 64, len -= 64) {
+        x0 = _mm_xor_si128(edc_fold(x0, k512), _mm_loadu_si128((const __m128i *) &buf[0]));
+        x1 = _mm_xor_si128(edc_fold(x1, k512), _mm_loadu_si128((const __m128i *) &buf[16]));
+        x2 = _mm_xor_si128(edc_fold(x2, k512), _mm_loadu_si128((const __m128i *) &buf[32]));
+        x3 = _mm_xor_si128(edc_fold(x3, k512), _mm_loadu_si128((const __m128i *) &buf[48]));
+    }
+
+    x1 = _mm_xor_si128(edc_fold(x0, k128), x1);
+    x2 = _mm_xor_si128(edc_fold(x1, k128), x2);
+    x3 = _mm_xor_si128(edc_fold(x2, k128), x3);
+
+    for (; len >= 16; buf += 16, len -= 16)
+        x3 = _mm_xor_si128(edc_fold(x3, k128), _mm_loadu_si128((const __m128i *) buf));
+
+    /* With an initial value of 0 the EDC of the remainder is that of all that came before it. */
+    _mm_storeu_si128((__m128i *) rem, x3);
+
+    return cdrom_crc32(cdrom_crc32(0xffffffff, rem, 16), buf, len) ^ 0xffffffff;
+}
+#endif
+
+void
+cdrom_ecc_init(void)
+{
+    if (ecc_ready)
+        return;
+
+#ifdef EDC_CLMUL
+    edc_fold128[0] = edc_xpow(128 + 64);
+    edc_fold128[1] = edc_xpow(128);
+    edc_fold512[0] = edc_xpow(512 + 64);
+    edc_fold512[1] = edc_xpow(512);
+    edc_clmul      = cpu_has_clmul();
+#endif
+
+    for (uint32_t j = 0; j < 256; j++) {
+        ecc_f[j]             = (j << 1) ^ ((j & 0x80) ? 0x11d : 0);
+        ecc_b[j ^ ecc_f[j]] = j;
+    }
+
+    ecc_ready = 1;
+}
+
+uint32_t
+cdrom_edc(const uint8_t *buf, size_t len)
+{
+    cdrom_ecc_init();
+
+#ifdef EDC_CLMUL
+    if (edc_clmul && (len >= 64))
+        return edc_compute_clmul(buf, len);
+#endif
+
+    return cdrom_crc32(0xffffffff, buf, len) ^ 0xffffffff;
+}
+
+#if defined(ECC_SSE2)
+typedef __m128i ecc_vec_t;
+
+static inline ecc_vec_t
+ecc_vec_zero(void)
+{
+    return _mm_setzero_si128();
+}
+
+/* One step of a = (a ^ x) * a, b ^= x; doubling in GF(2^8) shifts left and folds the carry back in as 0x1d. */
+static inline void
+ecc_step(ecc_vec_t *a, ecc_vec_t *b, ecc_vec_t x)
+{
+    const __m128i t = _mm_xor_si128(*a, x);
+
+    *b = _mm_xor_si128(*b, x);
+    *a = _mm_xor_si128(_mm_add_epi8(t, t), _mm_and_si128(_mm_cmplt_epi8(t, _mm_setzero_si128()), _mm_set1_epi8(0x1d)));
+}
+
+static inline ecc_vec_t
+ecc_load(const uint8_t *p)
+{
+    return _mm_loadu_si128((const __m128i *) p);
+}
+
+static inline void
+ecc_store(uint8_t *p, ecc_vec_t v)
+{
+    _mm_storeu_si128((__m128i *) p, v);
+}
+#elif defined(ECC_NEON)
+typedef uint8x16_t ecc_vec_t;
+
+static inline ecc_vec_t
+ecc_vec_zero(void)
+{
+    return vdupq_n_u8(0);
+}
+
+static inline void
+ecc_step(ecc_vec_t *a, ecc_vec_t *b, ecc_vec_t x)
+{
+    const uint8x16_t t = veorq_u8(*a, x);
+
+    *b = veorq_u8(*b, x);
+    *a = veorq_u8(vshlq_n_u8(t, 1),
+                  vandq_u8(vreinterpretq_u8_s8(vshrq_n_s8(vreinterpretq_s8_u8(t), 7)), vdupq_n_u8(0x1d)));
+}
+
+static inline ecc_vec_t
+ecc_load(const uint8_t *p)
+{
+    return vld1q_u8(p);
+}
+
+static inline void
+ecc_store(uint8_t *p, ecc_vec_t v)
+{
+    vst1q_u8(p, v);
+}
+#endif
+
+/* Turns the a and b of each codeword into its two parity bytes. */
+static void
+ecc_finish(const uint8_t *a, const uint8_t *b, int count, uint8_t *parity)
+{
+    for (int m = 0; m < count; m++) {
+        parity[m]         = ecc_b[ecc_f[a[m]] ^ b[m]];
+        parity[m + count] = parity[m] ^ b[m];
+    }
+}
+
+/*
+   Runs the recurrence down rows[0 .. nrows - 1] for count codewords, one
+   per column. count must be at least 16: when it is not a multiple of 16
+   the last vector is moved back to end at count, redoing a few codewords
+   rather than reading past the rows.
+ */
+static void
+ecc_compute(const uint8_t *const *rows, int nrows, int count, uint8_t *parity)
+{
+    uint8_t a[P_COUNT];
+    uint8_t b[P_COUNT];
+
+#if defined(ECC_SSE2) || defined(ECC_NEON)
+    for (int off = 0; off < count; off += 16) {
+        ecc_vec_t va = ecc_vec_zero();
+        ecc_vec_t vb = ecc_vec_zero();
+
+        if (off > (count - 16))
+            off = count - 16;
+
+        for (int r = 0; r < nrows; r++)
+            ecc_step(&va, &vb, ecc_load(&rows[r][off]));
+
+        ecc_store(&a[off], va);
+        ecc_store(&b[off], vb);
+    }
+#else
+    memset(a, 0x00, count);
+    memset(b, 0x00, count);
+
+    for (int r = 0; r < nrows; r++) {
+        const uint8_t *x = rows[r];
+
+        for (int m = 0; m < count; m++) {
+            a[m] = ecc_f[a[m] ^ x[m]];
+            b[m] ^= x[m];
+        }
+    }
+#endif
+
+    ecc_finish(a, b, count, parity);
+}
+
+void
+cdrom_ecc_compute_p(const uint8_t *data, uint8_t *parity, int m2f1)
+{
+    const uint8_t *rows[P_ROWS];
+    uint8_t        row0[P_COUNT];
+
+    cdrom_ecc_init();
+
+    for (int r = 0; r < P_ROWS; r++)
+        rows[r] = &data[r * P_COUNT];
+
+    if (m2f1) {
+        memcpy(row0, data, P_COUNT);
+        memset(row0, 0x00, 4);
+        rows[0] = row0;
+    }
+
+    ecc_compute(rows, P_ROWS, P_COUNT, parity);
+}
+
+#if defined(ECC_SSE2) || defined(ECC_NEON)
+static inline uint16_t
+ecc_load16(const uint8_t *p)
+{
+    uint16_t w;
+
+    memcpy(&w, p, 2);
+    return w;
+}
+
+/* Gathers n pairs, 86 bytes apart, into the lanes of a vector. */
+static inline ecc_vec_t
+ecc_gather(const uint8_t *p, int n)
+{
+#    if defined(ECC_SSE2)
+    __m128i v = _mm_setzero_si128();
+
+    v = _mm_insert_epi16(v, ecc_load16(p), 0);
+    v = _mm_insert_epi16(v, ecc_load16(p + 86), 1);
+    if (n > 2) {
+        v = _mm_insert_epi16(v, ecc_load16(p + (2 * 86)), 2);
+        v = _mm_insert_epi16(v, ecc_load16(p + (3 * 86)), 3);
+        v = _mm_insert_epi16(v, ecc_load16(p + (4 * 86)), 4);
+        v = _mm_insert_epi16(v, ecc_load16(p + (5 * 86)), 5);
+        v = _mm_insert_epi16(v, ecc_load16(p + (6 * 86)), 6);
+        v = _mm_insert_epi16(v, ecc_load16(p + (7 * 86)), 7);
+    }
+
+    return v;
+#    else
+    uint16x8_t v = vdupq_n_u16(0);
+
+    v = vsetq_lane_u16(ecc_load16(p), v, 0);
+    v = vsetq_lane_u16(ecc_load16(p + 86), v, 1);
+    if (n > 2) {
+        v = vsetq_lane_u16(ecc_load16(p + (2 * 86)), v, 2);
+        v = vsetq_lane_u16(ecc_load16(p + (3 * 86)), v, 3);
+        v = vsetq_lane_u16(ecc_load16(p + (4 * 86)), v, 4);
+        v = vsetq_lane_u16(ecc_load16(p + (5 * 86)), v, 5);
+        v = vsetq_lane_u16(ecc_load16(p + (6 * 86)), v, 6);
+        v = vsetq_lane_u16(ecc_load16(p + (7 * 86)), v, 7);
+    }
+
+    return vreinterpretq_u8_u16(v);
+#    endif
+}
+#endif
+
+void
+cdrom_ecc_compute_q(const uint8_t *data, uint8_t *parity, int m2f1)
+{
+    cdrom_ecc_init();
+
+    /*
+       Byte r of Q codeword pair c is pair r of row (c + r) mod 26 of the
+       sector, so the pairs for one r are 86 bytes apart, wrapping around
+       after the last row.
+     */
+#if defined(ECC_SSE2) || defined(ECC_NEON)
+    /* Rows 0-24 again after the sector, so that the wrap needs no test. */
+    uint8_t   wrap[(Q_WORDS + Q_WORDS - 1) * P_COUNT];
+    uint8_t   a[4 * 16];
+    uint8_t   b[4 * 16];
+    ecc_vec_t va[4];
+    ecc_vec_t vb[4];
+
+    memcpy(wrap, data, Q_WORDS * P_COUNT);
+    memcpy(&wrap[Q_WORDS * P_COUNT], data, (Q_WORDS - 1) * P_COUNT);
+    if (m2f1) {
+        memset(wrap, 0x00, 4);
+        memset(&wrap[Q_WORDS * P_COUNT], 0x00, 4);
+    }
+
+    for (int i = 0; i < 4; i++)
+        va[i] = vb[i] = ecc_vec_zero();
+
+    for (int r = 0; r < Q_ROWS; r++) {
+        const uint8_t *p = &wrap[((r % Q_WORDS) * P_COUNT) + (r << 1)];
+
+        ecc_step(&va[0], &vb[0], ecc_gather(p, 8));
+        ecc_step(&va[1], &vb[1], ecc_gather(p + (8 * P_COUNT), 8));
+        ecc_step(&va[2], &vb[2], ecc_gather(p + (16 * P_COUNT), 8));
+        ecc_step(&va[3], &vb[3], ecc_gather(p + (24 * P_COUNT), 2));
+    }
+
+    for (int i = 0; i < 4; i++) {
+        ecc_store(&a[i * 16], va[i]);
+        ecc_store(&b[i * 16], vb[i]);
+    }
+
+    ecc_finish(a, b, Q_COUNT, parity);
+#else
+    const uint8_t *rows[Q_ROWS];
+    uint16_t       diag[Q_ROWS][Q_WORDS];
+
+    /* Gather them into row r, so that the pairs run across it. */
+    for (int r = 0; r < Q_ROWS; r++) {
+        int row = r % Q_WORDS;
+
+        for (int c = 0; c < Q_WORDS; c++) {
+            memcpy(&diag[r][c], &data[((row * Q_ROWS) + r) << 1], 2);
+            if (++row == Q_WORDS)
+                row = 0;
+        }
+
+        rows[r] = (const uint8_t *) diag[r];
+    }
+
+    /* Header bytes 0-3 are pairs 0 and 1 of row 0, which land at (0, 0) and (1, 25). */
+    if (m2f1) {
+        diag[0][0]  = 0x0000;
+        diag[1][25] = 0x0000;
+    }
+
+    ecc_compute(rows, Q_ROWS, Q_COUNT, parity);
+#endif
+}
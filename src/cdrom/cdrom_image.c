@@ -36,7 +36,9 @@
 #include <86box/path.h>
 #include <86box/plat.h>
 #include <86box/cdrom.h>
+#include <86box/cdrom_ecc.h>
 #include <86box/cdrom_image.h>
+#include <86box/cdrom_image_chd.h>
 #include <86box/cdrom_image_viso.h>
 
 #include <sndfile.h>
@@ -106,17 +108,32 @@ typedef struct
 
 #define dstruct_t mds_disc_struct_t
 
+/*
+   A stretch of frames over which the track and index lookups give the same
+   answer, so that a sector can be found by a binary search instead of
+   going through every index of every track.
+*/
+typedef struct track_range_t {
+    uint64_t start; /* In frames, that is, LBA + 150. */
+    uint64_t end;   /* First frame past the range. */
+    int32_t  track; /* As found by image_get_track(). */
+    int32_t  data_track;
+    int32_t  data_index;
+} track_range_t;
+
 typedef struct cd_image_t {
-    cdrom_t      *dev;
-    void         *log;
-    int           is_dvd;
-    int           has_audio;
-    int           has_dstruct;
-    int32_t       tracks_num;
-    uint32_t      bad_sectors_num;
-    track_t      *tracks;
-    uint32_t     *bad_sectors;
-    dstruct_t     dstruct;
+    cdrom_t       *dev;
+    void          *log;
+    int            is_dvd;
+    int            has_audio;
+    int            has_dstruct;
+    int32_t        tracks_num;
+    uint32_t       bad_sectors_num;
+    int32_t        ranges_num;
+    track_t       *tracks;
+    uint32_t      *bad_sectors;
+    track_range_t *ranges;
+    dstruct_t      dstruct;
 } cd_image_t;
 
 typedef enum
@@ -253,6 +270,15 @@ typedef struct audio_file_t {
     SF_INFO  info;
 } audio_file_t;
 
+/* Read-ahead window of a binary file. */
+typedef struct bin_file_t {
+    int      sectors; /* Sectors per host read, 0 to read one at a time. */
+    size_t   size;
+    size_t   len;
+    uint64_t start;
+    uint8_t *buf;
+} bin_file_t;
+
 /* Audio file functions */
 static int
 audio_read(void *priv, uint8_t *buffer, const uint64_t seek, const size_t count)
@@ -355,7 +381,8 @@ cleanup_error:
 static int
 bin_read(void *priv, uint8_t *buffer, const uint64_t seek, const size_t count)
 {
-    const track_file_t *tf = (track_file_t *) priv;
+    const track_file_t *tf  = (track_file_t *) priv;
+    bin_file_t         *bin = (bin_file_t *) tf->priv;
 
     if (tf->fp == NULL)
         return 0;
@@ -363,16 +390,47 @@ bin_read(void *priv, uint8_t *buffer, const uint64_t seek, const size_t count)
     image_log(tf->log, "binary_read(%08lx, pos=%" PRIu64 " count=%lu)\n",
                     tf->fp, seek, count);
 
-    if (fseeko64(tf->fp, seek, SEEK_SET) == -1) {
-        image_log(tf->log, "binary_read failed during seek!\n");
-
-        return -1;
+    /* The window is sized by the first read, which is one sector of the track. */
+    if ((bin != NULL) && bin->sectors && (bin->buf == NULL)) {
+        bin->size = count * bin->sectors;
+        bin->buf  = (uint8_t *) malloc(bin->size);
     }
 
-    if (fread(buffer, count, 1, tf->fp) != 1) {
-        image_log(tf->log, "binary_read failed during read!\n");
+    if ((bin != NULL) && (bin->buf != NULL) && (count <= bin->size)) {
+        if ((seek < bin->start) || ((seek + count) > (bin->start + bin->len))) {
+            /* Fill the window from here on; it may run short at the end of the file. */
+            bin->len = 0;
+            if (fseeko64(tf->fp, seek, SEEK_SET) == -1) {
+                image_log(tf->log, "binary_read failed during seek!\n");
+
+                return -1;
+            }
+
+            const size_t len = fread(bin->buf, 1, bin->size, tf->fp);
+
+            if (len < count) {
+                image_log(tf->log, "binary_read failed during read!\n");
+
+                return -1;
+            }
+
+            bin->start = seek;
+            bin->len   = len;
+        }
+
+        memcpy(buffer, bin->buf + (seek - bin->start), count);
+    } else {
+        if (fseeko64(tf->fp, seek, SEEK_SET) == -1) {
+            image_log(tf->log, "binary_read failed during seek!\n");
+
+            return -1;
+        }
+
+        if (fread(buffer, count, 1, tf->fp) != 1) {
+            image_log(tf->log, "binary_read failed during read!\n");
 
-        return -1;
+            return -1;
+        }
     }
 
     if (UNLIKELY(tf->motorola)) {
@@ -415,6 +473,12 @@ bin_close(void *priv)
         tf->fp = NULL;
     }
 
+    if (tf->priv != NULL) {
+        free(((bin_file_t *) tf->priv)->buf);
+        free(tf->priv);
+        tf->priv = NULL;
+    }
+
     memset(tf->fn, 0x00, sizeof(tf->fn));
 
     log_close(tf->log);
@@ -452,6 +516,10 @@ bin_init(const uint8_t id, const char *filename, int *error)
 
     /* Set the function pointers. */
     if (!*error) {
+        bin_file_t *bin = (bin_file_t *) calloc(1, sizeof(bin_file_t));
+
+        bin->sectors   = cdrom[id].read_ahead;
+        tf->priv       = bin;
         tf->read       = bin_read;
         tf->get_length = bin_get_length;
         tf->close      = bin_close;
@@ -521,7 +589,7 @@ index_file_close(track_index_t *idx)
 
 /* Internal functions. */
 static int
-image_get_track(const cd_image_t *img, const uint32_t sector)
+image_scan_track(const cd_image_t *img, const uint32_t sector)
 {
     int ret = -1;
 
@@ -541,8 +609,8 @@ image_get_track(const cd_image_t *img, const uint32_t sector)
 }
 
 static void
-image_get_track_and_index(const cd_image_t *img, const uint32_t sector,
-                          int *track, int *index)
+image_scan_track_and_index(const cd_image_t *img, const uint32_t sector,
+                           int *track, int *index)
 {
     *track = -1;
     *index = -1;
@@ -561,6 +629,143 @@ image_get_track_and_index(const cd_image_t *img, const uint32_t sector,
     }
 }
 
+static int
+image_compare_frames(const void *a, const void *b)
+{
+    const uint64_t fa = *(const uint64_t *) a;
+    const uint64_t fb = *(const uint64_t *) b;
+
+    return (fa > fb) - (fa < fb);
+}
+
+/*
+   Splits the disc at every frame where an index starts or ends, and notes
+   what the scans above find in each piece, so the lookups below can give
+   exactly the same answers.
+*/
+static void
+image_build_ranges(cd_image_t *img)
+{
+    uint64_t *bounds   = NULL;
+    int       bounds_n = 0;
+
+    free(img->ranges);
+    img->ranges     = NULL;
+    img->ranges_num = 0;
+
+    for (int i = 0; i < img->tracks_num; i++)
+        bounds_n += (img->tracks[i].max_index + 1) * 2;
+
+    if (bounds_n == 0)
+        return;
+
+    bounds   = (uint64_t *) malloc(bounds_n * sizeof(uint64_t));
+    bounds_n = 0;
+
+    for (int i = 0; i < img->tracks_num; i++) {
+        const track_t *ct = &(img->tracks[i]);
+
+        for (int j = 0; j <= ct->max_index; j++) {
+            const track_index_t *ci = &(ct->idx[j]);
+
+            if ((ci->type >= INDEX_ZERO) && (ci->length != 0ULL)) {
+                bounds[bounds_n++] = ci->start;
+                bounds[bounds_n++] = ci->start + ci->length;
+            }
+        }
+    }
+
+    qsort(bounds, bounds_n, sizeof(uint64_t), image_compare_frames);
+
+    img->ranges = (track_range_t *) calloc(MAX(bounds_n, 1), sizeof(track_range_t));
+
+    for (int k = 0; k < (bounds_n - 1); k++) {
+        track_range_t *r;
+        int            track;
+        int            data_track;
+        int            data_index;
+
+        if ((bounds[k] == bounds[k + 1]) || (bounds[k] > 0xffffffffULL))
+            continue;
+
+        /* The scans take an LBA and add 150 to it as a 32-bit number. */
+        track = image_scan_track(img, (uint32_t) (bounds[k] - 150));
+        image_scan_track_and_index(img, (uint32_t) (bounds[k] - 150), &data_track, &data_index);
+
+        if ((track == -1) && (data_track == -1))
+            continue;
+
+        r = (img->ranges_num > 0) ? &(img->ranges[img->ranges_num - 1]) : NULL;
+        if ((r != NULL) && (r->end == bounds[k]) && (r->track == track) &&
+            (r->data_track == data_track) && (r->data_index == data_index)) {
+            r->end = bounds[k + 1];
+            continue;
+        }
+
+        r             = &(img->ranges[img->ranges_num++]);
+        r->start      = bounds[k];
+        r->end        = bounds[k + 1];
+        r->track      = track;
+        r->data_track = data_track;
+        r->data_index = data_index;
+    }
+
+    free(bounds);
+
+    image_log(img->log, "%i tracks in %i ranges\n", img->tracks_num, img->ranges_num);
+}
+
+static const track_range_t *
+image_find_range(const cd_image_t *img, const uint32_t sector)
+{
+    const uint64_t frame = (uint32_t) (sector + 150);
+    int            lo    = 0;
+    int            hi    = img->ranges_num - 1;
+
+    while (lo <= hi) {
+        const int            mid = (lo + hi) >> 1;
+        const track_range_t *r   = &(img->ranges[mid]);
+
+        if (frame < r->start)
+            hi = mid - 1;
+        else if (frame >= r->end)
+            lo = mid + 1;
+        else
+            return r;
+    }
+
+    return NULL;
+}
+
+static int
+image_get_track(const cd_image_t *img, const uint32_t sector)
+{
+    const track_range_t *r;
+
+    if (img->ranges == NULL)
+        return image_scan_track(img, sector);
+
+    r = image_find_range(img, sector);
+
+    return r ? r->track : -1;
+}
+
+static void
+image_get_track_and_index(const cd_image_t *img, const uint32_t sector,
+                          int *track, int *index)
+{
+    const track_range_t *r;
+
+    if (img->ranges == NULL) {
+        image_scan_track_and_index(img, sector, track, index);
+        return;
+    }
+
+    r      = image_find_range(img, sector);
+    *track = r ? r->data_track : -1;
+    *index = r ? r->data_index : -1;
+}
+
 static int
 image_is_sector_bad(const cd_image_t *img, const uint32_t sector)
 {
@@ -2292,6 +2497,125 @@ image_load_mds(cd_image_t *img, const char *mdsfile)
     return success;
 }
 
+static int
+image_load_chd(cd_image_t *img, const char *chdfile)
+{
+    const chd_track_t *tracks  = NULL;
+    track_t           *ct      = NULL;
+    chd_t             *chd     = NULL;
+    int                success = 2;
+    int                error   = CHD_ERROR_NONE;
+    int                tracks_num;
+
+    img->tracks     = NULL;
+    /*
+       Pass 1 - loading the CHD image, one track file per track.
+     */
+    image_log(img->log, "Pass 1 (loading the CHD image)...\n");
+    img->tracks_num = 0;
+
+    chd = chd_open(chdfile, cdrom[img->dev->id].read_ahead, img->log, &error);
+
+    if (chd == NULL) {
+        switch (error) {
+            case CHD_ERROR_CODEC:
+                warning("CHD image \"%s\" is compressed with a codec that this build does "
+                        "not support\n", chdfile);
+                break;
+            case CHD_ERROR_PARENT:
+                warning("CHD image \"%s\" needs a parent image, which is not supported\n",
+                        chdfile);
+                break;
+            default:
+#ifdef ENABLE_IMAGE_LOG
+                log_warning(img->log, "    [CHD   ] Unable to open CHD image \"%s\"\n", chdfile);
+#else
+                warning("Unable to open CHD image \"%s\"\n", chdfile);
+#endif
+                break;
+        }
+
+        return 0;
+    }
+
+    image_insert_track(img, 1, 0xa0);
+    image_insert_track(img, 1, 0xa1);
+    image_insert_track(img, 1, 0xa2);
+
+    tracks_num = chd_get_tracks(chd, &tracks);
+
+    for (int i = 0; i < tracks_num; i++) {
+        const chd_track_t *cht = &(tracks[i]);
+        track_file_t      *tf  = chd_track_init(chd, i, img->dev->id);
+
+        if (tf == NULL) {
+            success = 0;
+            break;
+        }
+
+        ct = image_insert_track(img, 1, cht->number);
+
+        for (int j = 0; j < 3; j++) {
+            ct->idx[j].type = INDEX_NONE;
+            ct->idx[j].file = tf;
+        }
+
+        ct->attr        = cht->audio ? AUDIO_TRACK : DATA_TRACK;
+        ct->mode        = cht->mode;
+        ct->form        = cht->form;
+        ct->sector_size = cht->sector_size + (cht->subcode ? 96 : 0);
+        ct->skip        = cht->skip;
+
+        image_set_track_subch_type(ct);
+
+        /* A pre-gap is either at the start of the track file, or silence. */
+        if (cht->pregap_in_image && (cht->pregap > 0)) {
+            ct->idx[0].type       = INDEX_NORMAL;
+            ct->idx[0].file_start = 0ULL;
+            ct->idx[1].file_start = cht->pregap;
+        } else {
+            if (cht->pregap > 0) {
+                ct->idx[0].type   = INDEX_ZERO;
+                ct->idx[0].length = cht->pregap;
+            }
+            ct->idx[1].file_start = 0ULL;
+        }
+        ct->idx[1].type = INDEX_NORMAL;
+
+        if (cht->postgap > 0) {
+            ct->idx[2].type   = INDEX_ZERO;
+            ct->idx[2].length = cht->postgap;
+        }
+
+        if (cht->audio)
+            success = 1;
+
+        image_log(img->log, "    [TRACK   ] %02X/%02X, ATTR %02X, MODE %02X/%02X,\n",
+                  ct->session,
+                  ct->point,
+                  ct->attr,
+                  ct->mode, ct->form);
+        image_log(img->log, "               %i\n",
+                  ct->sector_size);
+    }
+
+    img->is_dvd = chd_is_dvd(chd) ? 1 : 2;
+
+    /* The track files hold their own references. */
+    chd_close(chd);
+
+    if (success)
+        image_process(img);
+    else
+#ifdef ENABLE_IMAGE_LOG
+        log_warning(img->log, "    [CHD   ] Unable to open CHD image \"%s\"\n", chdfile);
+#else
+        warning("Unable to open CHD image \"%s\"\n", chdfile);
+#endif
+
+    return success;
+}
+
 /* Root functions. */
 static void
 image_clear_tracks(cd_image_t *img)
@@ -2414,7 +2738,6 @@ image_read_sector(const void *local, uint8_t *buffer,
                   const uint32_t sector)
 {
     const cd_image_t *img    = (const cd_image_t *) local;
-    cdrom_t          *dev    = (cdrom_t *) img->dev;
     int               m      = 0;
     int               s      = 0;
     int               f      = 0;
@@ -2487,20 +2810,20 @@ image_read_sector(const void *local, uint8_t *buffer,
                 uint32_t crc;
 
                 if ((trk->mode == 2) && (trk->form == 1)) {
-                    crc = cdrom_crc32(0xffffffff, &(buf[16]), 2056) ^ 0xffffffff;
+                    crc = cdrom_edc(&(buf[16]), 2056);
                     memcpy(&(buf[2072]), &crc, 4);
                 } else {
-                    crc = cdrom_crc32(0xffffffff, buf, 2064) ^ 0xffffffff;
+                    crc = cdrom_edc(buf, 2064);
                     memcpy(&(buf[2064]), &crc, 4);
                 }
 
                 int m2f1 = (trk->mode == 2) && (trk->form == 1);
 
                 /* Compute ECC P code. */
-                cdrom_compute_ecc_block(dev, &(buf[2076]), &(buf[12]), 86, 24, 2, 86, m2f1);
+                cdrom_ecc_compute_p(&(buf[12]), &(buf[2076]), m2f1);
 
                 /* Compute ECC Q code. */
-                cdrom_compute_ecc_block(dev, &(buf[2248]), &(buf[12]), 52, 43, 86, 88, m2f1);
+                cdrom_ecc_compute_q(&(buf[12]), &(buf[2248]), m2f1);
             }
 
             if ((ret > 0) && ((idx->type < INDEX_NORMAL) || (trk->subch_type != 0x08))) {
@@ -2652,6 +2975,7 @@ image_close(void *local)
         if (img->bad_sectors != NULL)
             free(img->bad_sectors);
 
+        free(img->ranges);
         free(img);
     }
 }
@@ -2682,6 +3006,7 @@ image_open(cdrom_t *dev, const char *path)
         int       ret;
         const int is_cue  = ((ext == 4) && !stricmp(path + strlen(path) - ext + 1, "CUE"));
         const int is_mds  = ((ext == 4) && !stricmp(path + strlen(path) - ext + 1, "MDS"));
+        const int is_chd  = ((ext == 4) && !stricmp(path + strlen(path) - ext + 1, "CHD"));
         char      n[1024] = { 0 };
 
         sprintf(n, "CD-ROM %i Image", dev->id + 1);
@@ -2692,6 +3017,13 @@ image_open(cdrom_t *dev, const char *path)
         if (is_mds) {
             ret = image_load_mds(img, path);
 
+            if (ret >= 2)
+                img->has_audio = 0;
+            else if (ret)
+                img->has_audio = 1;
+        } else if (is_chd) {
+            ret = image_load_chd(img, path);
+
             if (ret >= 2)
                 img->has_audio = 0;
             else if (ret)
@@ -2716,6 +3048,8 @@ image_open(cdrom_t *dev, const char *path)
         }
 
         if (ret > 0) {
+            image_build_ranges(img);
+
             if (img->is_dvd == 2) {
                 uint32_t lb = image_get_last_block(img); /* Should be safer than previous way of doing it? */
                 img->is_dvd = (lb >= 524287);    /* Minimum 1 GB total capacity as threshold for DVD. */
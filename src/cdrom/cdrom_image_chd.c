@@ -0,0 +1,1544 @@
+/*
+ * 86Box    A hypervisor and IBM PC system emulator that specializes in
+ *          running old operating systems and software designed for IBM
+ *          PC systems and compatibles from 1981 through fairly recent
+ *          system designs based on the PCI bus.
+ *
+ *          This file is part of the 86Box distribution.
+ *
+ *          Compressed hunks of MAME CHD (version 5) CD-ROM and DVD
+ *          images back-end.
+ *
+ *          The image is split into hunks of usually eight frames of
+ *          2352 data and 96 subcode bytes, each compressed on its own
+ *          by one of up to four codecs named in the header, or stored,
+ *          or a reference to an identical earlier hunk. The hunk map is
+ *          Huffman coded. Of the codecs, deflate is always available,
+ *          Zstandard, LZMA and FLAC when found at build time; the
+ *          Huffman codec is not supported. An image that uses a codec
+ *          we lack still opens, and only its hunks compressed with that
+ *          codec fail to read.
+ *
+ *          Decompressed hunks are kept in a small LRU cache, and when a
+ *          track is being read sequentially, a thread decompresses the
+ *          next few hunks ahead of the reader.
+ *
+ * Authors: 86Box contributors.
+ *
+ *          Copyright 2026 86Box contributors.
+ */
+#ifndef _LARGEFILE_SOURCE
+#    define _LARGEFILE_SOURCE
+#endif
+#ifndef _LARGEFILE64_SOURCE
+#    define _LARGEFILE64_SOURCE
+#endif
+#define __STDC_FORMAT_MACROS
+#include <inttypes.h>
+#ifdef ENABLE_IMAGE_CHD_LOG
+#include <stdarg.h>
+#endif
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <zlib.h>
+#ifdef USE_ZSTD
+#    include <zstd.h>
+#endif
+#ifdef USE_LZMA
+#    include <lzma.h>
+#endif
+#ifdef USE_FLAC
+#    include <FLAC/stream_decoder.h>
+#endif
+#include <86box/86box.h>
+#include <86box/cdrom.h>
+#include <86box/cdrom_ecc.h>
+#include <86box/cdrom_image.h>
+#include <86box/cdrom_image_chd.h>
+#include <86box/log.h>
+#include <86box/plat.h>
+#include <86box/thread.h>
+
+#define CHD_V5_HEADER_SIZE  124
+#define CHD_FRAME_SIZE      2448
+#define CHD_SECTOR_DATA     2352
+#define CHD_SUBCODE_DATA    96
+#define CHD_TRACK_PADDING   4
+#define CHD_MAX_HUNK_BYTES  (1 << 20)
+
+#define CHD_CACHE_HUNKS     32
+#define CHD_PREFETCH_MAX    (CHD_CACHE_HUNKS / 2)
+#define CHD_NO_HUNK         0xffffffff
+
+#define CHD_TAG(a, b, c, d) (((uint32_t) (a) << 24) | ((uint32_t) (b) << 16) | \
+                             ((uint32_t) (c) << 8) | (uint32_t) (d))
+
+#define CHD_CODEC_ZLIB      CHD_TAG('z', 'l', 'i', 'b')
+#define CHD_CODEC_ZSTD      CHD_TAG('z', 's', 't', 'd')
+#define CHD_CODEC_LZMA      CHD_TAG('l', 'z', 'm', 'a')
+#define CHD_CODEC_CD_ZLIB   CHD_TAG('c', 'd', 'z', 'l')
+#define CHD_CODEC_CD_ZSTD   CHD_TAG('c', 'd', 'z', 's')
+#define CHD_CODEC_CD_LZMA   CHD_TAG('c', 'd', 'l', 'z')
+#define CHD_CODEC_CD_FLAC   CHD_TAG('c', 'd', 'f', 'l')
+
+/* The STREAMINFO that cdfl leaves out: 44.1 kHz, 2 channels, 16 bits. */
+#define CHD_FLAC_HEADER_SIZE 0x2a
+
+#define CHD_META_TRACK      CHD_TAG('C', 'H', 'T', 'R')
+#define CHD_META_TRACK2     CHD_TAG('C', 'H', 'T', '2')
+#define CHD_META_GDROM      CHD_TAG('C', 'H', 'G', 'D')
+#define CHD_META_DVD        CHD_TAG('D', 'V', 'D', ' ')
+
+/* Hunk map entry types; 0 to 3 are the codecs of the header. */
+enum {
+    CHD_MAP_CODEC_0 = 0,
+    CHD_MAP_CODEC_3 = 3,
+    CHD_MAP_NONE,
+    CHD_MAP_SELF,
+    CHD_MAP_PARENT,
+    CHD_MAP_RLE_SMALL,
+    CHD_MAP_RLE_LARGE,
+    CHD_MAP_SELF_0,
+    CHD_MAP_SELF_1,
+    CHD_MAP_PARENT_SELF,
+    CHD_MAP_PARENT_0,
+    CHD_MAP_PARENT_1,
+    CHD_MAP_ZERO      /* Ours, for the unused hunks of an uncompressed map. */
+};
+
+enum {
+    CHD_HUNK_EMPTY = 0,
+    CHD_HUNK_LOADING,
+    CHD_HUNK_READY
+};
+
+typedef struct chd_map_entry_t {
+    uint64_t offset;          /* File offset, or the hunk a SELF entry repeats. */
+    uint32_t length;
+    uint8_t  type;
+} chd_map_entry_t;
+
+typedef struct chd_hunk_t {
+    uint32_t hunk;
+    int      state;
+    uint64_t used;
+    uint8_t *data;
+} chd_hunk_t;
+
+/* Everything one thread needs to decompress hunks on its own. */
+typedef struct chd_codec_t {
+    FILE    *fp;
+    uint8_t *comp;
+    uint8_t *temp;
+    z_stream zlib;
+    int      zlib_ready;
+#ifdef USE_ZSTD
+    ZSTD_DCtx *zstd;
+#endif
+#ifdef USE_LZMA
+    lzma_stream lzma;
+#endif
+#ifdef USE_FLAC
+    FLAC__StreamDecoder *flac;
+    uint8_t              flac_header[CHD_FLAC_HEADER_SIZE];
+    const uint8_t       *flac_src;     /* The header, then the compressed data. */
+    uint32_t             flac_src_len;
+    uint32_t             flac_src_pos;
+    uint32_t             flac_comp_len;
+    uint64_t             flac_read;    /* Bytes handed to the decoder, for its tell callback. */
+    uint8_t             *flac_dst;
+    uint32_t             flac_samples; /* Stereo samples wanted, and decoded so far. */
+    uint32_t             flac_done;
+#endif
+} chd_codec_t;
+
+struct chd_t {
+    char             fn[260];
+    void            *log;
+    int              refs;
+    int              is_dvd;
+
+    uint64_t         logical_bytes;
+    uint64_t         map_offset;
+    uint64_t         meta_offset;
+    uint32_t         hunk_bytes;
+    uint32_t         unit_bytes;
+    uint32_t         hunk_count;
+    uint32_t         max_comp;
+    uint32_t         compressors[4];
+    chd_map_entry_t *map;
+
+    int              tracks_num;
+    chd_track_t      tracks[CHD_MAX_TRACKS];
+
+    mutex_t         *mutex;
+    event_t         *loaded;
+    chd_hunk_t       cache[CHD_CACHE_HUNKS];
+    uint64_t         clock;
+    uint32_t         last_hunk;
+    chd_codec_t      codec;
+
+    thread_t        *thread;
+    event_t         *wake;
+    chd_codec_t      prefetch;
+    uint32_t         prefetch_hunks;
+    uint32_t         prefetch_next;
+    uint32_t         prefetch_end;
+    int              quit;
+};
+
+/* One track of the CHD, as a track file. */
+typedef struct chd_file_t {
+    chd_t             *chd;
+    const chd_track_t *track;
+    uint32_t           sector_size;
+} chd_file_t;
+
+typedef struct chd_bits_t {
+    const uint8_t *data;
+    uint32_t       len;
+    uint32_t       pos;
+    uint32_t       buffer;
+    int            bits;
+} chd_bits_t;
+
+typedef struct chd_track_type_t {
+    const char *name;
+    int         mode;
+    int         form;
+    int         sector_size;
+    int         skip;
+} chd_track_type_t;
+
+static const chd_track_type_t chd_track_types[] = {
+    { "MODE1",          1, 0, COOKED_SECTOR_SIZE, 0 },
+    { "MODE1_RAW",      1, 0, RAW_SECTOR_SIZE,    0 },
+    { "MODE2",          2, 1, 2336,               8 },
+    { "MODE2_FORM1",    2, 1, COOKED_SECTOR_SIZE, 0 },
+    { "MODE2_FORM2",    2, 2, 2324,               0 },
+    { "MODE2_FORM_MIX", 2, 1, 2336,               8 },
+    { "MODE2_RAW",      2, 1, RAW_SECTOR_SIZE,    0 },
+    { "AUDIO",          0, 0, RAW_SECTOR_SIZE,    0 },
+    { NULL,             0, 0, 0,                  0 }
+};
+
+static const uint8_t chd_sync[12] = { 0x00, 0xff, 0xff, 0xff, 0xff, 0xff,
+                                      0xff, 0xff, 0xff, 0xff, 0xff, 0x00 };
+
+#ifdef ENABLE_IMAGE_CHD_LOG
+int image_chd_do_log = ENABLE_IMAGE_CHD_LOG;
+
+void
+image_chd_log(void *priv, const char *fmt, ...)
+{
+    va_list ap;
+
+    if (image_chd_do_log) {
+        va_start(ap, fmt);
+        log_out(priv, fmt, ap);
+        va_end(ap);
+    }
+}
+#else
+#    define image_chd_log(priv, fmt, ...)
+#endif
+
+static uint32_t
+chd_be16(const uint8_t *p)
+{
+    return (p[0] << 8) | p[1];
+}
+
+static uint32_t
+chd_be32(const uint8_t *p)
+{
+    return ((uint32_t) p[0] << 24) | (p[1] << 16) | (p[2] << 8) | p[3];
+}
+
+static uint64_t
+chd_be48(const uint8_t *p)
+{
+    return ((uint64_t) chd_be16(p) << 32) | chd_be32(p + 2);
+}
+
+static uint64_t
+chd_be64(const uint8_t *p)
+{
+    return ((uint64_t) chd_be32(p) << 32) | chd_be32(p + 4);
+}
+
+static int
+chd_pread(FILE *fp, void *buffer, const uint64_t offset, const size_t count)
+{
+    if (fseeko64(fp, offset, SEEK_SET) == -1)
+        return 0;
+
+    return fread(buffer, 1, count, fp) == count;
+}
+
+/* The hunk map is an MSB-first bit stream. */
+static uint32_t
+chd_bits_peek(chd_bits_t *bs, const int num)
+{
+    if (num == 0)
+        return 0;
+
+    while (bs->bits < num) {
+        if (bs->pos < bs->len)
+            bs->buffer |= (uint32_t) bs->data[bs->pos] << (24 - bs->bits);
+        bs->pos++;
+        bs->bits += 8;
+    }
+
+    return bs->buffer >> (32 - num);
+}
+
+static void
+chd_bits_remove(chd_bits_t *bs, const int num)
+{
+    bs->buffer <<= num;
+    bs->bits -= num;
+}
+
+static uint64_t
+chd_bits_read(chd_bits_t *bs, int num)
+{
+    uint64_t ret = 0;
+
+    /* At most 16 bits at a time, so that the buffer always has room for them. */
+    while (num > 0) {
+        const int n = (num > 16) ? 16 : num;
+
+        ret = (ret << n) | chd_bits_peek(bs, n);
+        chd_bits_remove(bs, n);
+        num -= n;
+    }
+
+    return ret;
+}
+
+/* The 16-entry Huffman code of the map types, lengths of at most 8 bits. */
+static int
+chd_huffman_import(chd_bits_t *bs, uint16_t *lookup)
+{
+    uint8_t  lengths[16] = { 0 };
+    uint32_t histo[33]   = { 0 };
+    uint32_t codes[16];
+    uint32_t start       = 0;
+    int      node        = 0;
+
+    /* Run-length coded lengths: 1 escapes either a literal 1 or a length and a repeat count. */
+    while (node < 16) {
+        int len = (int) chd_bits_read(bs, 4);
+
+        if (len != 1)
+            lengths[node++] = len;
+        else {
+            len = (int) chd_bits_read(bs, 4);
+            if (len == 1)
+                lengths[node++] = len;
+            else {
+                int rep = (int) chd_bits_read(bs, 4) + 3;
+
+                if ((node + rep) > 16)
+                    return 0;
+                while (rep--)
+                    lengths[node++] = len;
+            }
+        }
+    }
+
+    /* Canonical codes, assigned from the longest length down. */
+    for (int i = 0; i < 16; i++) {
+        if (lengths[i] > 8)
+            return 0;
+        histo[lengths[i]]++;
+    }
+    for (int len = 32; len > 0; len--) {
+        const uint32_t next = (start + histo[len]) >> 1;
+
+        if ((len != 1) && ((next * 2) != (start + histo[len])))
+            return 0;
+        histo[len] = start;
+        start      = next;
+    }
+    for (int i = 0; i < 16; i++) {
+        if (lengths[i] > 0)
+            codes[i] = histo[lengths[i]]++;
+    }
+
+    /* Every 8-bit peek maps to the symbol and its length. */
+    memset(lookup, 0x00, 256 * sizeof(uint16_t));
+    for (int i = 0; i < 16; i++) {
+        if (lengths[i] > 0) {
+            const int shift = 8 - lengths[i];
+
+            for (uint32_t j = codes[i] << shift; j < ((codes[i] + 1) << shift); j++)
+                lookup[j] = (i << 5) | lengths[i];
+        }
+    }
+
+    return 1;
+}
+
+static int
+chd_huffman_decode(chd_bits_t *bs, const uint16_t *lookup)
+{
+    const uint16_t entry = lookup[chd_bits_peek(bs, 8)];
+
+    chd_bits_remove(bs, entry & 0x1f);
+
+    return entry >> 5;
+}
+
+static int
+chd_read_map(chd_t *chd)
+{
+    uint8_t   hdr[16];
+    uint8_t  *comp;
+    uint8_t  *raw;
+    uint16_t  lookup[256];
+    uint16_t  crc_table[256];
+    uint16_t  crc       = 0xffff;
+    uint64_t  cur;
+    uint64_t  last_self = 0;
+    uint64_t  last_parent = 0;
+    uint32_t  map_bytes;
+    uint32_t  rep       = 0;
+    uint8_t   last      = 0;
+    chd_bits_t bs;
+
+    chd->map = (chd_map_entry_t *) calloc(chd->hunk_count, sizeof(chd_map_entry_t));
+    if (chd->map == NULL)
+        return 0;
+
+    /* An uncompressed CHD has a plain table of hunk numbers in the file, 0 for unused. */
+    if (chd->compressors[0] == 0) {
+        raw = (uint8_t *) malloc((size_t) chd->hunk_count * 4);
+        if ((raw == NULL) || !chd_pread(chd->codec.fp, raw, chd->map_offset, (size_t) chd->hunk_count * 4)) {
+            free(raw);
+            return 0;
+        }
+
+        for (uint32_t i = 0; i < chd->hunk_count; i++) {
+            chd->map[i].offset = (uint64_t) chd_be32(&raw[i * 4]) * chd->hunk_bytes;
+            chd->map[i].length = chd->hunk_bytes;
+            chd->map[i].type   = chd->map[i].offset ? CHD_MAP_NONE : CHD_MAP_ZERO;
+        }
+
+        free(raw);
+        return 1;
+    }
+
+    if (!chd_pread(chd->codec.fp, hdr, chd->map_offset, sizeof(hdr)))
+        return 0;
+
+    map_bytes = chd_be32(hdr);
+    cur       = chd_be48(&hdr[4]);
+
+    const int length_bits = hdr[12];
+    const int self_bits   = hdr[13];
+    const int parent_bits = hdr[14];
+
+    comp = (uint8_t *) malloc(map_bytes);
+    raw  = (uint8_t *) malloc((size_t) chd->hunk_count * 12);
+    if ((comp == NULL) || (raw == NULL) || !chd_pread(chd->codec.fp, comp, chd->map_offset + 16, map_bytes)) {
+        free(comp);
+        free(raw);
+        return 0;
+    }
+
+    memset(&bs, 0x00, sizeof(bs));
+    bs.data = comp;
+    bs.len  = map_bytes;
+
+    if (!chd_huffman_import(&bs, lookup)) {
+        free(comp);
+        free(raw);
+        return 0;
+    }
+
+    /* First the types, with runs of the previous one coded as repeat counts. */
+    for (uint32_t i = 0; i < chd->hunk_count; i++) {
+        if (rep > 0) {
+            raw[i * 12] = last;
+            rep--;
+        } else {
+            const int val = chd_huffman_decode(&bs, lookup);
+
+            if (val == CHD_MAP_RLE_SMALL) {
+                raw[i * 12] = last;
+                rep         = 2 + chd_huffman_decode(&bs, lookup);
+            } else if (val == CHD_MAP_RLE_LARGE) {
+                raw[i * 12] = last;
+                rep         = 2 + 16 + (chd_huffman_decode(&bs, lookup) << 4);
+                rep        += chd_huffman_decode(&bs, lookup);
+            } else
+                raw[i * 12] = last = val;
+        }
+    }
+
+    /* Then lengths and offsets, rebuilt into the 12-byte entries the map CRC covers. */
+    for (uint32_t i = 0; i < chd->hunk_count; i++) {
+        uint8_t  *e      = &raw[i * 12];
+        uint64_t  offset = cur;
+        uint32_t  length = 0;
+        uint32_t  crc16  = 0;
+
+        switch (e[0]) {
+            case CHD_MAP_CODEC_0 ... CHD_MAP_CODEC_3:
+                length = (uint32_t) chd_bits_read(&bs, length_bits);
+                cur   += length;
+                crc16  = (uint32_t) chd_bits_read(&bs, 16);
+                break;
+
+            case CHD_MAP_NONE:
+                length = chd->hunk_bytes;
+                cur   += length;
+                crc16  = (uint32_t) chd_bits_read(&bs, 16);
+                break;
+
+            case CHD_MAP_SELF:
+                last_self = offset = chd_bits_read(&bs, self_bits);
+                break;
+
+            case CHD_MAP_PARENT:
+                last_parent = offset = chd_bits_read(&bs, parent_bits);
+                break;
+
+            case CHD_MAP_SELF_1:
+                last_self++;
+                fallthrough;
+            case CHD_MAP_SELF_0:
+                e[0]   = CHD_MAP_SELF;
+                offset = last_self;
+                break;
+
+            case CHD_MAP_PARENT_SELF:
+                e[0]        = CHD_MAP_PARENT;
+                last_parent = offset = ((uint64_t) i * chd->hunk_bytes) / chd->unit_bytes;
+                break;
+
+            case CHD_MAP_PARENT_1:
+                last_parent += chd->hunk_bytes / chd->unit_bytes;
+                fallthrough;
+            case CHD_MAP_PARENT_0:
+                e[0]   = CHD_MAP_PARENT;
+                offset = last_parent;
+                break;
+
+            default:
+                free(comp);
+                free(raw);
+                return 0;
+        }
+
+        e[1]  = length >> 16;
+        e[2]  = length >> 8;
+        e[3]  = length;
+        e[4]  = offset >> 40;
+        e[5]  = offset >> 32;
+        e[6]  = offset >> 24;
+        e[7]  = offset >> 16;
+        e[8]  = offset >> 8;
+        e[9]  = offset;
+        e[10] = crc16 >> 8;
+        e[11] = crc16;
+
+        chd->map[i].offset = offset;
+        chd->map[i].length = length;
+        chd->map[i].type   = e[0];
+
+        if ((e[0] <= CHD_MAP_CODEC_3) && (length > chd->max_comp))
+            chd->max_comp = length;
+    }
+
+    /* CRC-16-CCITT of the rebuilt entries. */
+    for (uint32_t i = 0; i < 256; i++) {
+        uint16_t c = i << 8;
+
+        for (int j = 0; j < 8; j++)
+            c = (c & 0x8000) ? ((c << 1) ^ 0x1021) : (c << 1);
+        crc_table[i] = c;
+    }
+    for (uint32_t i = 0; i < (chd->hunk_count * 12); i++)
+        crc = (crc << 8) ^ crc_table[(crc >> 8) ^ raw[i]];
+
+    free(comp);
+    free(raw);
+
+    if (crc != chd_be16(&hdr[10])) {
+        image_chd_log(chd->log, "Map CRC mismatch: %04X, expected %04X\n", crc, chd_be16(&hdr[10]));
+        return 0;
+    }
+
+    return 1;
+}
+
+static int
+chd_codec_supported(const uint32_t tag)
+{
+    switch (tag) {
+        case CHD_CODEC_ZLIB:
+        case CHD_CODEC_CD_ZLIB:
+#ifdef USE_ZSTD
+        case CHD_CODEC_ZSTD:
+        case CHD_CODEC_CD_ZSTD:
+#endif
+#ifdef USE_LZMA
+        case CHD_CODEC_LZMA:
+        case CHD_CODEC_CD_LZMA:
+#endif
+#ifdef USE_FLAC
+        case CHD_CODEC_CD_FLAC:
+#endif
+            return 1;
+
+        default:
+            return 0;
+    }
+}
+
+static int
+chd_codec_is_cd(const uint32_t tag)
+{
+    return (tag == CHD_CODEC_CD_ZLIB) || (tag == CHD_CODEC_CD_ZSTD) || (tag == CHD_CODEC_CD_LZMA) ||
+           (tag == CHD_CODEC_CD_FLAC);
+}
+
+static int
+chd_parse_track(chd_t *chd, const char *text, const int v2)
+{
+    char         type[32]    = { 0 };
+    char         subtype[32] = { 0 };
+    char         pgtype[32]  = { 0 };
+    char         pgsub[32]   = { 0 };
+    int          number      = 0;
+    int          frames      = 0;
+    int          pregap      = 0;
+    int          postgap     = 0;
+    chd_track_t *ct;
+    int          i;
+
+    if (v2) {
+        if (sscanf(text, "TRACK:%d TYPE:%31s SUBTYPE:%31s FRAMES:%d PREGAP:%d PGTYPE:%31s "
+                   "PGSUB:%31s POSTGAP:%d", &number, type, subtype, &frames, &pregap,
+                   pgtype, pgsub, &postgap) != 8)
+            return 0;
+    } else if (sscanf(text, "TRACK:%d TYPE:%31s SUBTYPE:%31s FRAMES:%d",
+                      &number, type, subtype, &frames) != 4)
+        return 0;
+
+    if ((number < 1) || (number > CHD_MAX_TRACKS) || (frames <= 0) || (pregap < 0) ||
+        (postgap < 0) || (chd->tracks_num >= CHD_MAX_TRACKS))
+        return 0;
+
+    for (i = 0; chd_track_types[i].name != NULL; i++) {
+        if (!strcmp(type, chd_track_types[i].name))
+            break;
+    }
+    if (chd_track_types[i].name == NULL)
+        return 0;
+
+    ct                  = &chd->tracks[chd->tracks_num++];
+    ct->number          = number;
+    ct->audio           = !strcmp(type, "AUDIO");
+    ct->mode            = chd_track_types[i].mode;
+    ct->form            = chd_track_types[i].form;
+    ct->sector_size     = chd_track_types[i].sector_size;
+    ct->skip            = chd_track_types[i].skip;
+    ct->subcode         = !strcmp(subtype, "RW_RAW") && (ct->sector_size == RAW_SECTOR_SIZE);
+    ct->frames          = frames;
+    ct->pregap          = pregap;
+    ct->pregap_in_image = (pgtype[0] == 'V') && (pregap <= frames);
+    ct->postgap         = postgap;
+
+    return 1;
+}
+
+static int
+chd_compare_tracks(const void *a, const void *b)
+{
+    return ((const chd_track_t *) a)->number - ((const chd_track_t *) b)->number;
+}
+
+static int
+chd_read_metadata(chd_t *chd, int *error)
+{
+    uint8_t  hdr[16];
+    char     text[257];
+    uint64_t offset   = chd->meta_offset;
+    uint64_t frame    = 0;
+    int      is_dvd   = 0;
+
+    /* A chain of tagged entries; the bound only guards against loops in a damaged file. */
+    for (int n = 0; (offset != 0) && (n < 1024); n++) {
+        if (!chd_pread(chd->codec.fp, hdr, offset, sizeof(hdr)))
+            return 0;
+
+        const uint32_t tag    = chd_be32(hdr);
+        const uint32_t length = chd_be32(&hdr[4]) & 0x00ffffff;
+
+        if ((tag == CHD_META_TRACK) || (tag == CHD_META_TRACK2)) {
+            const uint32_t len = (length < (sizeof(text) - 1)) ? length : (sizeof(text) - 1);
+
+            if (!chd_pread(chd->codec.fp, text, offset + 16, len))
+                return 0;
+            text[len] = 0;
+
+            image_chd_log(chd->log, "Track metadata: %s\n", text);
+
+            if (!chd_parse_track(chd, text, tag == CHD_META_TRACK2))
+                return 0;
+        } else if (tag == CHD_META_DVD)
+            is_dvd = 1;
+        else if (tag == CHD_META_GDROM) {
+            image_chd_log(chd->log, "GD-ROM images are not supported\n");
+            return 0;
+        }
+
+        offset = chd_be64(&hdr[8]);
+    }
+
+    if (chd->tracks_num > 0) {
+        if (chd->unit_bytes != CHD_FRAME_SIZE)
+            return 0;
+
+        qsort(chd->tracks, chd->tracks_num, sizeof(chd_track_t), chd_compare_tracks);
+
+        /* Each track starts on a multiple of four frames of the CHD. */
+        for (int i = 0; i < chd->tracks_num; i++) {
+            chd_track_t *ct = &chd->tracks[i];
+
+            if (ct->number != (i + 1))
+                return 0;
+
+            ct->first_frame = frame;
+            frame += (ct->frames + CHD_TRACK_PADDING - 1) & ~(CHD_TRACK_PADDING - 1);
+        }
+
+        if ((frame * CHD_FRAME_SIZE) > chd->logical_bytes)
+            return 0;
+    } else if (is_dvd && (chd->unit_bytes == COOKED_SECTOR_SIZE)) {
+        /* A DVD is a single track of bare 2048-byte sectors. */
+        chd_track_t *ct = &chd->tracks[chd->tracks_num++];
+
+        ct->number      = 1;
+        ct->mode        = 1;
+        ct->sector_size = COOKED_SECTOR_SIZE;
+        ct->frames      = (uint32_t) (chd->logical_bytes / COOKED_SECTOR_SIZE);
+        chd->is_dvd     = 1;
+    } else {
+        /* Hard disks, LaserDiscs and the like. */
+        *error = CHD_ERROR_FORMAT;
+        return 0;
+    }
+
+    return 1;
+}
+
+static int
+chd_codec_init(chd_t *chd, chd_codec_t *codec)
+{
+    memset(codec, 0x00, sizeof(chd_codec_t));
+
+    codec->fp   = plat_fopen64(chd->fn, "rb");
+    codec->comp = (uint8_t *) malloc(chd->max_comp ? chd->max_comp : 1);
+    codec->temp = (uint8_t *) malloc(chd->hunk_bytes);
+#ifdef USE_LZMA
+    codec->lzma = (lzma_stream) LZMA_STREAM_INIT;
+#endif
+
+    return (codec->fp != NULL) && (codec->comp != NULL) && (codec->temp != NULL);
+}
+
+static void
+chd_codec_close(chd_codec_t *codec)
+{
+    if (codec->fp != NULL)
+        fclose(codec->fp);
+    free(codec->comp);
+    free(codec->temp);
+    if (codec->zlib_ready)
+        inflateEnd(&codec->zlib);
+#ifdef USE_ZSTD
+    if (codec->zstd != NULL)
+        ZSTD_freeDCtx(codec->zstd);
+#endif
+#ifdef USE_LZMA
+    lzma_end(&codec->lzma);
+#endif
+#ifdef USE_FLAC
+    if (codec->flac != NULL)
+        FLAC__stream_decoder_delete(codec->flac);
+#endif
+
+    memset(codec, 0x00, sizeof(chd_codec_t));
+}
+
+/* Raw deflate, LZMA1 or Zstandard data that must decompress to exactly len bytes. */
+static int
+chd_decompress(chd_codec_t *codec, const uint32_t tag, const uint8_t *src,
+               const uint32_t src_len, uint8_t *dst, const uint32_t len)
+{
+    switch (tag) {
+        case CHD_CODEC_ZLIB:
+            if (!codec->zlib_ready) {
+                if (inflateInit2(&codec->zlib, -MAX_WBITS) != Z_OK)
+                    return 0;
+                codec->zlib_ready = 1;
+            } else
+                inflateReset(&codec->zlib);
+
+            codec->zlib.next_in   = (Bytef *) src;
+            codec->zlib.avail_in  = src_len;
+            codec->zlib.next_out  = dst;
+            codec->zlib.avail_out = len;
+
+            (void) inflate(&codec->zlib, Z_FINISH);
+
+            return codec->zlib.total_out == len;
+
+#ifdef USE_ZSTD
+        case CHD_CODEC_ZSTD: {
+            if ((codec->zstd == NULL) && ((codec->zstd = ZSTD_createDCtx()) == NULL))
+                return 0;
+
+            const size_t ret = ZSTD_decompressDCtx(codec->zstd, dst, len, src, src_len);
+
+            return !ZSTD_isError(ret) && (ret == len);
+        }
+#endif
+
+#ifdef USE_LZMA
+        case CHD_CODEC_LZMA: {
+            /* No end marker: the decoder stops when the output is full. */
+            lzma_options_lzma opts;
+            lzma_filter       filters[2];
+
+            memset(&opts, 0x00, sizeof(opts));
+            opts.dict_size = (len < LZMA_DICT_SIZE_MIN) ? LZMA_DICT_SIZE_MIN : len;
+            opts.lc        = 3;
+            opts.lp        = 0;
+            opts.pb        = 2;
+
+            filters[0].id      = LZMA_FILTER_LZMA1;
+            filters[0].options = &opts;
+            filters[1].id      = LZMA_VLI_UNKNOWN;
+            filters[1].options = NULL;
+
+            if (lzma_raw_decoder(&codec->lzma, filters) != LZMA_OK)
+                return 0;
+
+            codec->lzma.next_in   = src;
+            codec->lzma.avail_in  = src_len;
+            codec->lzma.next_out  = dst;
+            codec->lzma.avail_out = len;
+
+            const lzma_ret ret = lzma_code(&codec->lzma, LZMA_RUN);
+
+            return ((ret == LZMA_OK) || (ret == LZMA_STREAM_END)) && (codec->lzma.avail_out == 0);
+        }
+#endif
+
+        default:
+            return 0;
+    }
+}
+
+/*
+   The CD codecs compress the data of all frames of the hunk as one block
+   and their subcode as another, after a bitmap of the frames whose sync
+   and P/Q parity were dropped because they can be generated again.
+ */
+static int
+chd_decompress_cd(const chd_t *chd, chd_codec_t *codec, const uint32_t tag,
+                  const uint8_t *src, const uint32_t src_len, uint8_t *dst)
+{
+    const uint32_t frames       = chd->hunk_bytes / CHD_FRAME_SIZE;
+    const uint32_t ecc_bytes    = (frames + 7) / 8;
+    const uint32_t len_bytes    = (chd->hunk_bytes < 65536) ? 2 : 3;
+    const uint32_t header_bytes = ecc_bytes + len_bytes;
+    uint32_t       base_len;
+    uint32_t       base;
+    uint32_t       sub;
+
+    if (src_len < header_bytes)
+        return 0;
+
+    base_len = chd_be16(&src[ecc_bytes]);
+    if (len_bytes > 2)
+        base_len = (base_len << 8) | src[ecc_bytes + 2];
+
+    if ((header_bytes + base_len) > src_len)
+        return 0;
+
+    switch (tag) {
+        case CHD_CODEC_CD_ZSTD:
+            base = sub = CHD_CODEC_ZSTD;
+            break;
+        case CHD_CODEC_CD_LZMA:
+            base = CHD_CODEC_LZMA;
+            sub  = CHD_CODEC_ZLIB;
+            break;
+        default:
+            base = sub = CHD_CODEC_ZLIB;
+            break;
+    }
+
+    if (!chd_decompress(codec, base, &src[header_bytes], base_len,
+                        codec->temp, frames * CHD_SECTOR_DATA) ||
+        !chd_decompress(codec, sub, &src[header_bytes + base_len], src_len - header_bytes - base_len,
+                        &codec->temp[frames * CHD_SECTOR_DATA], frames * CHD_SUBCODE_DATA))
+        return 0;
+
+    for (uint32_t i = 0; i < frames; i++) {
+        uint8_t *s = &dst[i * CHD_FRAME_SIZE];
+
+        memcpy(s, &codec->temp[i * CHD_SECTOR_DATA], CHD_SECTOR_DATA);
+        memcpy(&s[CHD_SECTOR_DATA], &codec->temp[(frames * CHD_SECTOR_DATA) + (i * CHD_SUBCODE_DATA)],
+               CHD_SUBCODE_DATA);
+
+        if (src[i >> 3] & (1 << (i & 7))) {
+            memcpy(s, chd_sync, sizeof(chd_sync));
+            cdrom_ecc_compute_p(&s[12], &s[2076], 0);
+            cdrom_ecc_compute_q(&s[12], &s[2248], 0);
+        }
+    }
+
+    return 1;
+}
+
+#ifdef USE_FLAC
+/* The decoder reads our STREAMINFO first, then the frames of the hunk. */
+static FLAC__StreamDecoderReadStatus
+chd_flac_read(const FLAC__StreamDecoder *dec, FLAC__byte buffer[], size_t *bytes, void *priv)
+{
+    chd_codec_t *codec = (chd_codec_t *) priv;
+    size_t       done  = 0;
+
+    (void) dec;
+
+    while (done < *bytes) {
+        if (codec->flac_src == codec->flac_header) {
+            if (codec->flac_src_pos >= codec->flac_src_len) {
+                codec->flac_src     = codec->comp;
+                codec->flac_src_len = codec->flac_comp_len;
+                codec->flac_src_pos = 0;
+                continue;
+            }
+        } else if (codec->flac_src_pos >= codec->flac_src_len)
+            break;
+
+        size_t n = codec->flac_src_len - codec->flac_src_pos;
+
+        if (n > (*bytes - done))
+            n = *bytes - done;
+        memcpy(&buffer[done], &codec->flac_src[codec->flac_src_pos], n);
+        codec->flac_src_pos += n;
+        done += n;
+    }
+
+    *bytes = done;
+    codec->flac_read += done;
+
+    return done ? FLAC__STREAM_DECODER_READ_STATUS_CONTINUE : FLAC__STREAM_DECODER_READ_STATUS_END_OF_STREAM;
+}
+
+static FLAC__StreamDecoderTellStatus
+chd_flac_tell(const FLAC__StreamDecoder *dec, FLAC__uint64 *offset, void *priv)
+{
+    (void) dec;
+
+    *offset = ((chd_codec_t *) priv)->flac_read;
+
+    return FLAC__STREAM_DECODER_TELL_STATUS_OK;
+}
+
+/* Samples go out big-endian, as the audio frames of a CHD are stored. */
+static FLAC__StreamDecoderWriteStatus
+chd_flac_write(const FLAC__StreamDecoder *dec, const FLAC__Frame *frame,
+               const FLAC__int32 *const buffer[], void *priv)
+{
+    chd_codec_t *codec = (chd_codec_t *) priv;
+
+    (void) dec;
+
+    if (frame->header.channels != 2)
+        return FLAC__STREAM_DECODER_WRITE_STATUS_ABORT;
+
+    for (uint32_t i = 0; (i < frame->header.blocksize) && (codec->flac_done < codec->flac_samples); i++) {
+        uint8_t *d = &codec->flac_dst[codec->flac_done++ * 4];
+
+        d[0] = buffer[0][i] >> 8;
+        d[1] = buffer[0][i];
+        d[2] = buffer[1][i] >> 8;
+        d[3] = buffer[1][i];
+    }
+
+    return FLAC__STREAM_DECODER_WRITE_STATUS_CONTINUE;
+}
+
+static void
+chd_flac_error(const FLAC__StreamDecoder *dec, FLAC__StreamDecoderErrorStatus status, void *priv)
+{
+    (void) dec;
+    (void) status;
+    (void) priv;
+}
+
+/*
+   The cdfl codec has no sync or parity bitmap: the data of all frames is
+   FLAC audio with its STREAMINFO left out, and the subcode follows as
+   raw deflate once the audio ends.
+ */
+static int
+chd_decompress_cd_flac(const chd_t *chd, chd_codec_t *codec, const uint32_t src_len, uint8_t *dst)
+{
+    const uint32_t frames     = chd->hunk_bytes / CHD_FRAME_SIZE;
+    uint32_t       block_size = (frames * CHD_SECTOR_DATA) / 4;
+    FLAC__uint64   pos        = 0;
+    int            ret;
+
+    if ((codec->flac == NULL) && ((codec->flac = FLAC__stream_decoder_new()) == NULL))
+        return 0;
+
+    /* The block size chdman picks for the encoder, which the decoder only checks frames against. */
+    while (block_size > 2048)
+        block_size /= 2;
+
+    memset(codec->flac_header, 0x00, sizeof(codec->flac_header));
+    memcpy(codec->flac_header, "fLaC", 4);
+    codec->flac_header[0x04] = 0x80; /* STREAMINFO, the last metadata block. */
+    codec->flac_header[0x07] = 0x22;
+    codec->flac_header[0x08] = codec->flac_header[0x0a] = block_size >> 8;
+    codec->flac_header[0x09] = codec->flac_header[0x0b] = block_size & 0xff;
+    codec->flac_header[0x12] = 44100 >> 12;
+    codec->flac_header[0x13] = (44100 >> 4) & 0xff;
+    codec->flac_header[0x14] = ((44100 << 4) & 0xff) | ((2 - 1) << 1);
+    codec->flac_header[0x15] = 0xf0; /* 16 bits, and an unknown length. */
+
+    codec->flac_src      = codec->flac_header;
+    codec->flac_src_len  = sizeof(codec->flac_header);
+    codec->flac_src_pos  = 0;
+    codec->flac_comp_len = src_len;
+    codec->flac_read     = 0;
+    codec->flac_dst      = codec->temp;
+    codec->flac_samples  = (frames * CHD_SECTOR_DATA) / 4;
+    codec->flac_done     = 0;
+
+    if (FLAC__stream_decoder_init_stream(codec->flac, chd_flac_read, NULL, chd_flac_tell, NULL, NULL,
+                                         chd_flac_write, NULL, chd_flac_error, codec) !=
+        FLAC__STREAM_DECODER_INIT_STATUS_OK)
+        return 0;
+
+    ret = FLAC__stream_decoder_process_until_end_of_metadata(codec->flac);
+    while (ret && (codec->flac_done < codec->flac_samples)) {
+        ret = FLAC__stream_decoder_process_single(codec->flac) &&
+              ((codec->flac_done >= codec->flac_samples) ||
+               (FLAC__stream_decoder_get_state(codec->flac) != FLAC__STREAM_DECODER_END_OF_STREAM));
+    }
+
+    /* Where the audio ended, less the STREAMINFO we made up. */
+    if (ret)
+        ret = FLAC__stream_decoder_get_decode_position(codec->flac, &pos) &&
+              (pos >= sizeof(codec->flac_header)) && ((pos - sizeof(codec->flac_header)) <= src_len);
+    FLAC__stream_decoder_finish(codec->flac);
+
+    if (!ret)
+        return 0;
+
+    pos -= sizeof(codec->flac_header);
+    if (!chd_decompress(codec, CHD_CODEC_ZLIB, &codec->comp[pos], src_len - (uint32_t) pos,
+                        &codec->temp[frames * CHD_SECTOR_DATA], frames * CHD_SUBCODE_DATA))
+        return 0;
+
+    for (uint32_t i = 0; i < frames; i++) {
+        uint8_t *s = &dst[i * CHD_FRAME_SIZE];
+
+        memcpy(s, &codec->temp[i * CHD_SECTOR_DATA], CHD_SECTOR_DATA);
+        memcpy(&s[CHD_SECTOR_DATA], &codec->temp[(frames * CHD_SECTOR_DATA) + (i * CHD_SUBCODE_DATA)],
+               CHD_SUBCODE_DATA);
+    }
+
+    return 1;
+}
+#endif
+
+static int
+chd_read_hunk(const chd_t *chd, chd_codec_t *codec, const uint32_t hunk, uint8_t *dst, const int depth)
+{
+    const chd_map_entry_t *e = &chd->map[hunk];
+
+    switch (e->type) {
+        case CHD_MAP_CODEC_0 ... CHD_MAP_CODEC_3: {
+            const uint32_t tag = chd->compressors[e->type];
+
+            /* Only these hunks of an image with a codec we lack are unreadable. */
+            if (!chd_codec_supported(tag))
+                return 0;
+
+            if (!chd_pread(codec->fp, codec->comp, e->offset, e->length))
+                return 0;
+
+#ifdef USE_FLAC
+            if (tag == CHD_CODEC_CD_FLAC)
+                return chd_decompress_cd_flac(chd, codec, e->length, dst);
+#endif
+            if (chd_codec_is_cd(tag))
+                return chd_decompress_cd(chd, codec, tag, codec->comp, e->length, dst);
+
+            return chd_decompress(codec, tag, codec->comp, e->length, dst, chd->hunk_bytes);
+        }
+
+        case CHD_MAP_NONE:
+            return chd_pread(codec->fp, dst, e->offset, chd->hunk_bytes);
+
+        case CHD_MAP_SELF:
+            /* Always a hunk stored earlier, but a damaged map could loop. */
+            if ((e->offset >= hunk) || (depth > 4))
+                return 0;
+            return chd_read_hunk(chd, codec, (uint32_t) e->offset, dst, depth + 1);
+
+        case CHD_MAP_ZERO:
+            memset(dst, 0x00, chd->hunk_bytes);
+            return 1;
+
+        default:
+            return 0;
+    }
+}
+
+/* The cache; all of these are called with the mutex held. */
+static chd_hunk_t *
+chd_cache_find(chd_t *chd, const uint32_t hunk)
+{
+    for (int i = 0; i < CHD_CACHE_HUNKS; i++) {
+        if ((chd->cache[i].hunk == hunk) && (chd->cache[i].state != CHD_HUNK_EMPTY))
+            return &chd->cache[i];
+    }
+
+    return NULL;
+}
+
+/* The least recently used slot that is not being filled; the prefetch depth guarantees one. */
+static chd_hunk_t *
+chd_cache_victim(chd_t *chd)
+{
+    chd_hunk_t *victim = NULL;
+
+    for (int i = 0; i < CHD_CACHE_HUNKS; i++) {
+        chd_hunk_t *slot = &chd->cache[i];
+
+        if (slot->state == CHD_HUNK_EMPTY)
+            return slot;
+
+        if ((slot->state == CHD_HUNK_READY) && ((victim == NULL) || (slot->used < victim->used)))
+            victim = slot;
+    }
+
+    return victim;
+}
+
+static const uint8_t *
+chd_cache_get(chd_t *chd, const uint32_t hunk)
+{
+    chd_hunk_t *slot;
+
+    while ((slot = chd_cache_find(chd, hunk)) != NULL) {
+        if (slot->state == CHD_HUNK_READY) {
+            slot->used = ++chd->clock;
+            return slot->data;
+        }
+
+        /* The prefetch thread is on it; wait rather than decompress it twice. */
+        thread_reset_event(chd->loaded);
+        thread_release_mutex(chd->mutex);
+        thread_wait_event(chd->loaded, 10);
+        thread_wait_mutex(chd->mutex);
+    }
+
+    slot = chd_cache_victim(chd);
+    if (slot == NULL)
+        return NULL;
+
+    slot->state = CHD_HUNK_EMPTY;
+    if (!chd_read_hunk(chd, &chd->codec, hunk, slot->data, 0)) {
+        image_chd_log(chd->log, "Unable to read hunk %" PRIu32 "\n", hunk);
+        return NULL;
+    }
+
+    slot->hunk  = hunk;
+    slot->state = CHD_HUNK_READY;
+    slot->used  = ++chd->clock;
+
+    return slot->data;
+}
+
+static void
+chd_prefetch_thread(void *priv)
+{
+    chd_t *chd = (chd_t *) priv;
+
+    thread_wait_mutex(chd->mutex);
+
+    while (!chd->quit) {
+        if (chd->prefetch_next >= chd->prefetch_end) {
+            thread_reset_event(chd->wake);
+            thread_release_mutex(chd->mutex);
+            thread_wait_event(chd->wake, -1);
+            thread_wait_mutex(chd->mutex);
+            continue;
+        }
+
+        const uint32_t hunk = chd->prefetch_next++;
+        chd_hunk_t    *slot;
+
+        if ((hunk >= chd->hunk_count) || (chd_cache_find(chd, hunk) != NULL) ||
+            ((slot = chd_cache_victim(chd)) == NULL))
+            continue;
+
+        slot->hunk  = hunk;
+        slot->state = CHD_HUNK_LOADING;
+
+        /* Decompress outside the lock, with our own file and codec state. */
+        thread_release_mutex(chd->mutex);
+        const int ok = chd_read_hunk(chd, &chd->prefetch, hunk, slot->data, 0);
+        thread_wait_mutex(chd->mutex);
+
+        slot->state = ok ? CHD_HUNK_READY : CHD_HUNK_EMPTY;
+        slot->used  = ++chd->clock;
+
+        thread_set_event(chd->loaded);
+    }
+
+    thread_release_mutex(chd->mutex);
+}
+
+int
+chd_read(chd_t *chd, uint8_t *buffer, uint64_t offset, size_t count)
+{
+    int ret = 1;
+
+    thread_wait_mutex(chd->mutex);
+
+    while (count > 0) {
+        const uint32_t hunk = (uint32_t) (offset / chd->hunk_bytes);
+        const uint32_t pos  = (uint32_t) (offset % chd->hunk_bytes);
+        const size_t   len  = ((chd->hunk_bytes - pos) < count) ? (chd->hunk_bytes - pos) : count;
+        const uint8_t *data;
+
+        if ((hunk >= chd->hunk_count) || ((data = chd_cache_get(chd, hunk)) == NULL)) {
+            ret = 0;
+            break;
+        }
+
+        memcpy(buffer, &data[pos], len);
+
+        /* Moving on to the next hunk: keep the ones after it coming. */
+        if (hunk != chd->last_hunk) {
+            if ((chd->thread != NULL) && (hunk == (chd->last_hunk + 1))) {
+                chd->prefetch_next = hunk + 1;
+                chd->prefetch_end  = hunk + 1 + chd->prefetch_hunks;
+                thread_set_event(chd->wake);
+            }
+
+            chd->last_hunk = hunk;
+        }
+
+        buffer += len;
+        offset += len;
+        count  -= len;
+    }
+
+    thread_release_mutex(chd->mutex);
+
+    return ret;
+}
+
+static void
+chd_free(chd_t *chd)
+{
+    if (chd->thread != NULL) {
+        thread_wait_mutex(chd->mutex);
+        chd->quit = 1;
+        thread_set_event(chd->wake);
+        thread_release_mutex(chd->mutex);
+
+        thread_wait(chd->thread);
+        chd->thread = NULL;
+    }
+
+    if (chd->wake != NULL)
+        thread_destroy_event(chd->wake);
+    if (chd->loaded != NULL)
+        thread_destroy_event(chd->loaded);
+    if (chd->mutex != NULL)
+        thread_close_mutex(chd->mutex);
+
+    chd_codec_close(&chd->codec);
+    chd_codec_close(&chd->prefetch);
+
+    for (int i = 0; i < CHD_CACHE_HUNKS; i++)
+        free(chd->cache[i].data);
+
+    free(chd->map);
+    free(chd);
+}
+
+chd_t *
+chd_open(const char *fn, const int read_ahead, void *log, int *error)
+{
+    uint8_t  hdr[CHD_V5_HEADER_SIZE];
+    uint32_t unsupported = 0;
+    uint32_t readable    = 0;
+    chd_t   *chd         = (chd_t *) calloc(1, sizeof(chd_t));
+
+    *error = CHD_ERROR_FILE;
+
+    if (chd == NULL)
+        return NULL;
+
+    strncpy(chd->fn, fn, sizeof(chd->fn) - 1);
+    chd->log       = log;
+    chd->refs      = 1;
+    chd->last_hunk = CHD_NO_HUNK;
+
+    chd->codec.fp = plat_fopen64(chd->fn, "rb");
+    if ((chd->codec.fp == NULL) || !chd_pread(chd->codec.fp, hdr, 0, sizeof(hdr)))
+        goto fail;
+
+    *error = CHD_ERROR_FORMAT;
+    if (memcmp(hdr, "MComprHD", 8) || (chd_be32(&hdr[12]) != 5)) {
+        image_chd_log(log, "Not a version 5 CHD\n");
+        goto fail;
+    }
+
+    for (int i = 0; i < 4; i++)
+        chd->compressors[i] = chd_be32(&hdr[16 + (i * 4)]);
+    chd->logical_bytes = chd_be64(&hdr[32]);
+    chd->map_offset    = chd_be64(&hdr[40]);
+    chd->meta_offset   = chd_be64(&hdr[48]);
+    chd->hunk_bytes    = chd_be32(&hdr[56]);
+    chd->unit_bytes    = chd_be32(&hdr[60]);
+
+    if ((chd->hunk_bytes == 0) || (chd->hunk_bytes > CHD_MAX_HUNK_BYTES) || (chd->unit_bytes == 0) ||
+        (chd->hunk_bytes % chd->unit_bytes) || (chd->logical_bytes == 0) ||
+        (((chd->logical_bytes + chd->hunk_bytes - 1) / chd->hunk_bytes) > 0xfffffffeULL))
+        goto fail;
+
+    chd->hunk_count = (uint32_t) ((chd->logical_bytes + chd->hunk_bytes - 1) / chd->hunk_bytes);
+
+    image_chd_log(log, "%" PRIu32 " hunks of %" PRIu32 " bytes, codecs %08X %08X %08X %08X\n",
+                  chd->hunk_count, chd->hunk_bytes, chd->compressors[0], chd->compressors[1],
+                  chd->compressors[2], chd->compressors[3]);
+
+    if (!chd_read_map(chd) || !chd_read_metadata(chd, error))
+        goto fail;
+
+    /*
+       Hunks compressed with a codec we lack only fail when read, as chdman
+       picks the codec per hunk and may have used it for a few of them;
+       refuse the image only when there is nothing we can read.
+     */
+    for (uint32_t i = 0; i < chd->hunk_count; i++) {
+        const uint8_t type = chd->map[i].type;
+
+        if (type == CHD_MAP_PARENT) {
+            *error = CHD_ERROR_PARENT;
+            goto fail;
+        }
+
+        if (type <= CHD_MAP_CODEC_3) {
+            const uint32_t tag = chd->compressors[type];
+
+            if (!chd_codec_supported(tag))
+                unsupported++;
+            else
+                readable++;
+
+            if (chd_codec_is_cd(tag) && (chd->hunk_bytes % CHD_FRAME_SIZE))
+                goto fail;
+        } else
+            readable++;
+    }
+
+    if (unsupported > 0) {
+        image_chd_log(log, "%" PRIu32 " hunks use a codec that is not supported\n", unsupported);
+
+        if (readable == 0) {
+            *error = CHD_ERROR_CODEC;
+            goto fail;
+        }
+    }
+
+    *error = CHD_ERROR_FILE;
+
+    /* The map was read with a bare file; now the full codec state. */
+    fclose(chd->codec.fp);
+    if (!chd_codec_init(chd, &chd->codec))
+        goto fail;
+
+    for (int i = 0; i < CHD_CACHE_HUNKS; i++) {
+        chd->cache[i].hunk = CHD_NO_HUNK;
+        chd->cache[i].data = (uint8_t *) malloc(chd->hunk_bytes);
+        if (chd->cache[i].data == NULL)
+            goto fail;
+    }
+
+    chd->mutex  = thread_create_mutex();
+    chd->loaded = thread_create_event();
+
+    /* As many hunks ahead as the drive reads sectors ahead, at least one. */
+    if (read_ahead > 0) {
+        chd->prefetch_hunks = (uint32_t) (((uint64_t) read_ahead * chd->unit_bytes +
+                                           chd->hunk_bytes - 1) / chd->hunk_bytes);
+        if (chd->prefetch_hunks > CHD_PREFETCH_MAX)
+            chd->prefetch_hunks = CHD_PREFETCH_MAX;
+
+        if (chd_codec_init(chd, &chd->prefetch)) {
+            chd->wake   = thread_create_event();
+            chd->thread = thread_create(chd_prefetch_thread, chd);
+        }
+    }
+
+    *error = CHD_ERROR_NONE;
+    return chd;
+
+fail:
+    chd_free(chd);
+    return NULL;
+}
+
+void
+chd_close(chd_t *chd)
+{
+    if ((chd != NULL) && (--chd->refs == 0))
+        chd_free(chd);
+}
+
+int
+chd_is_dvd(const chd_t *chd)
+{
+    return chd->is_dvd;
+}
+
+int
+chd_get_tracks(const chd_t *chd, const chd_track_t **tracks)
+{
+    *tracks = chd->tracks;
+
+    return chd->tracks_num;
+}
+
+uint64_t
+chd_get_length(const chd_t *chd)
+{
+    return chd->logical_bytes;
+}
+
+/* Track files. */
+static int
+chd_track_read(void *priv, uint8_t *buffer, uint64_t seek, size_t count)
+{
+    const track_file_t *tf = (track_file_t *) priv;
+    const chd_file_t   *cf = (chd_file_t *) tf->priv;
+    const chd_track_t  *ct = cf->track;
+    chd_t              *chd = cf->chd;
+    uint8_t             frame[CHD_FRAME_SIZE];
+
+    image_chd_log(tf->log, "chd_read(pos=%" PRIu64 " count=%lu)\n", seek, count);
+
+    while (count > 0) {
+        const uint64_t sector = seek / cf->sector_size;
+        const uint32_t pos    = (uint32_t) (seek % cf->sector_size);
+        const size_t   len    = ((cf->sector_size - pos) < count) ? (cf->sector_size - pos) : count;
+        const uint64_t offset = (ct->first_frame + sector) * chd->unit_bytes;
+
+        if (sector >= ct->frames)
+            return -1;
+
+        if (ct->audio) {
+            /* Audio is stored big-endian. */
+            if (!chd_read(chd, frame, offset, cf->sector_size))
+                return -1;
+
+            for (int i = 0; i < CHD_SECTOR_DATA; i += 2) {
+                const uint8_t b = frame[i];
+
+                frame[i]     = frame[i + 1];
+                frame[i + 1] = b;
+            }
+
+            memcpy(buffer, &frame[pos], len);
+        } else if (!chd_read(chd, buffer, offset + pos, len))
+            return -1;
+
+        buffer += len;
+        seek   += len;
+        count  -= len;
+    }
+
+    return 1;
+}
+
+static uint64_t
+chd_track_get_length(void *priv)
+{
+    const track_file_t *tf = (track_file_t *) priv;
+    const chd_file_t   *cf = (chd_file_t *) tf->priv;
+
+    return (uint64_t) cf->track->frames * cf->sector_size;
+}
+
+static void
+chd_track_close(void *priv)
+{
+    track_file_t *tf = (track_file_t *) priv;
+
+    if (tf == NULL)
+        return;
+
+    if (tf->priv != NULL) {
+        chd_close(((chd_file_t *) tf->priv)->chd);
+        free(tf->priv);
+        tf->priv = NULL;
+    }
+
+    log_close(tf->log);
+    tf->log = NULL;
+
+    free(tf);
+}
+
+track_file_t *
+chd_track_init(chd_t *chd, const int track, const uint8_t id)
+{
+    track_file_t *tf = (track_file_t *) calloc(1, sizeof(track_file_t));
+    chd_file_t   *cf = (chd_file_t *) calloc(1, sizeof(chd_file_t));
+    char          n[1024] = { 0 };
+
+    if ((tf == NULL) || (cf == NULL) || (track < 0) || (track >= chd->tracks_num)) {
+        free(tf);
+        free(cf);
+        return NULL;
+    }
+
+    cf->chd         = chd;
+    cf->track       = &chd->tracks[track];
+    cf->sector_size = cf->track->sector_size + (cf->track->subcode ? CHD_SUBCODE_DATA : 0);
+    chd->refs++;
+
+    memcpy(tf->fn, chd->fn, sizeof(tf->fn));
+    tf->priv       = cf;
+    tf->read       = chd_track_read;
+    tf->get_length = chd_track_get_length;
+    tf->close      = chd_track_close;
+
+    sprintf(n, "CD-ROM %i CHD  ", id + 1);
+    tf->log = log_open(n);
+
+    return tf;
+}
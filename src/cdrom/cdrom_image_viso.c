@@ -31,6 +31,10 @@
 #include <sys/stat.h>
 #include <time.h>
 #include <wchar.h>
+#ifdef __unix__
+#    include <errno.h>
+#    include <unistd.h>
+#endif
 #include <86box/86box.h>
 #include <86box/cdrom.h>
 #include <86box/cdrom_image.h>
@@ -79,7 +83,10 @@ typedef struct stat stat_t;
     }
 
 #define VISO_SECTOR_SIZE COOKED_SECTOR_SIZE
-#define VISO_OPEN_FILES  32
+
+/* Metadata cache, rebuilt whenever a directory or file in the tree changed. */
+#define VISO_CACHE_MAGIC   "86BVISO1"
+#define VISO_CACHE_VERSION 1
 
 enum {
     VISO_CHARSET_D = 0,
@@ -113,6 +120,7 @@ typedef struct _viso_entry_ {
         uint64_t data_offset;
     };
     uint16_t pt_idx;
+    uint16_t open_slot; /* valid while file is open */
 
     stat_t stats;
 
@@ -121,20 +129,49 @@ typedef struct _viso_entry_ {
     char *basename, path[];
 } viso_entry_t;
 
+typedef struct {
+    viso_entry_t *entry;
+    uint64_t      last_used;
+} viso_open_file_t;
+
 typedef struct {
     uint64_t vol_size_offsets[2];
     uint64_t pt_meta_offsets[2];
     int      format;
     uint8_t  use_version_suffix : 1;
-    size_t   metadata_sectors, all_sectors, entry_map_size, sector_size, file_fifo_pos;
+    size_t   metadata_sectors, all_sectors, entry_map_size, sector_size;
     uint8_t *metadata;
 
     track_file_t   tf;
     viso_entry_t  *root_dir;
     viso_entry_t **entry_map;
-    viso_entry_t  *file_fifo[VISO_OPEN_FILES];
+
+    /* Least recently used host files are closed first once all slots are taken. */
+    viso_open_file_t *open_files;
+    size_t            open_files_max, open_files_count;
+    uint64_t          open_clock;
 } viso_t;
 
+typedef struct {
+    char     magic[8]; /* written last, so that an interrupted save is never loaded */
+    uint32_t version;
+    uint32_t sector_size;
+    uint64_t metadata_sectors;
+    uint64_t all_sectors;
+    uint32_t dirs;
+    uint32_t files;
+    uint32_t dirname_len;
+    int32_t  tz_offset;
+    char     emu_version[32];
+} viso_cache_header_t;
+
+typedef struct {
+    uint64_t size;
+    int64_t  mtime;
+    uint32_t mode;
+    uint32_t path_len;
+} viso_cache_stamp_t;
+
 static const char rr_eid[]   = "RRIP_1991A"; /* identifiers used in ER field for Rock Ridge */
 static const char rr_edesc[] = "THE ROCK RIDGE INTERCHANGE PROTOCOL PROVIDES SUPPORT FOR POSIX FILE SYSTEM SEMANTICS.";
 static int8_t     tz_offset  = 0;
@@ -680,73 +717,147 @@ viso_compare_entries(const void *a, const void *b)
     return strcmp((*((viso_entry_t **) a))->name_short, (*((viso_entry_t **) b))->name_short);
 }
 
+/* Reads len bytes at offset of a host file, returning fewer only at the end of the file, or -1. */
+static int64_t
+viso_file_read(FILE *fp, uint8_t *buffer, uint64_t offset, size_t len)
+{
+#ifdef __unix__
+    /* Positioned I/O on the descriptor does not depend on the stream position, nor move it. */
+    const int fd   = fileno(fp);
+    size_t    done = 0;
+
+    while (done < len) {
+        const ssize_t n = pread(fd, buffer + done, len - done, offset + done);
+
+        if ((n < 0) && (errno == EINTR))
+            continue;
+        else if (n < 0)
+            return -1;
+        else if (n == 0)
+            break;
+        done += n;
+    }
+
+    return done;
+#else
+    size_t done;
+
+    if (fseeko64(fp, offset, SEEK_SET) == -1)
+        return -1;
+    done = fread(buffer, 1, len, fp);
+    if ((done < len) && ferror(fp))
+        return -1;
+
+    return done;
+#endif
+}
+
+static void
+viso_file_close(viso_t *viso, size_t slot)
+{
+    viso_entry_t *entry = viso->open_files[slot].entry;
+
+    image_viso_log(viso->tf.log, "Closing [%s]...\n", entry->path);
+    fclose(entry->file);
+    entry->file = NULL;
+
+    /* Move the last slot into the freed one. */
+    viso->open_files[slot] = viso->open_files[--viso->open_files_count];
+    if (slot < viso->open_files_count)
+        viso->open_files[slot].entry->open_slot = slot;
+}
+
+static void
+viso_file_close_lru(viso_t *viso)
+{
+    size_t lru = 0;
+
+    for (size_t i = 1; i < viso->open_files_count; i++) {
+        if (viso->open_files[i].last_used < viso->open_files[lru].last_used)
+            lru = i;
+    }
+
+    viso_file_close(viso, lru);
+}
+
+static FILE *
+viso_file_get(viso_t *viso, viso_entry_t *entry)
+{
+    if (entry->file) {
+        viso->open_files[entry->open_slot].last_used = ++viso->open_clock;
+        return entry->file;
+    }
+
+    if (viso->open_files_count >= viso->open_files_max)
+        viso_file_close_lru(viso);
+
+    image_viso_log(viso->tf.log, "Opening [%s]...\n", entry->path);
+    entry->file = fopen(entry->path, "rb");
+    if (!entry->file && viso->open_files_count) {
+        /* The host may be out of descriptors even with slots to spare; give one back and retry. */
+        viso_file_close_lru(viso);
+        entry->file = fopen(entry->path, "rb");
+    }
+    if (!entry->file) {
+        image_viso_log(viso->tf.log, "Failed\n");
+        return NULL;
+    }
+
+    entry->open_slot                                    = viso->open_files_count;
+    viso->open_files[viso->open_files_count].entry      = entry;
+    viso->open_files[viso->open_files_count++].last_used = ++viso->open_clock;
+
+    return entry->file;
+}
+
 int
 viso_read(void *priv, uint8_t *buffer, uint64_t seek, size_t count)
 {
     track_file_t *tf   = (track_file_t *) priv;
     viso_t       *viso = (viso_t *) tf->priv;
 
-    /* Handle reads in a sector by sector basis. */
+    /* Handle reads in runs of sectors belonging to the metadata or to a single file. */
     while (count > 0) {
-        /* Determine the current sector, offset and remainder. */
-        size_t sector        = seek / viso->sector_size;
-        size_t sector_offset = seek % viso->sector_size;
-        size_t sector_remain = MIN(count, viso->sector_size - sector_offset);
+        /* Determine the current sector and the length of the run starting there. */
+        size_t sector = seek / viso->sector_size;
+        size_t run    = MIN(count, viso->sector_size - (seek % viso->sector_size));
 
-        /* Handle sector. */
         if (sector < viso->metadata_sectors) {
             /* Copy metadata. */
-            memcpy(buffer, viso->metadata + seek, sector_remain);
+            run = MIN(count, (viso->metadata_sectors * viso->sector_size) - seek);
+            memcpy(buffer, viso->metadata + seek, run);
         } else {
-            size_t read = 0;
+            int64_t read = 0;
 
             /* Get the file entry corresponding to this sector. */
             viso_entry_t *entry = viso->entry_map[sector - viso->metadata_sectors];
             if (entry) {
-                /* Open file if it's not already open. */
-                if (!entry->file) {
-                    /* Close any existing FIFO entry's file. */
-                    viso_entry_t *other_entry = viso->file_fifo[viso->file_fifo_pos];
-                    if (other_entry && other_entry->file) {
-                        image_viso_log(viso->tf.log, "Closing [%s]...\n", other_entry->path);
-                        fclose(other_entry->file);
-                        other_entry->file = NULL;
-                        image_viso_log(viso->tf.log, "Done\n");
-                    }
-
-                    /* Open file. */
-                    image_viso_log(viso->tf.log, "Opening [%s]...\n", entry->path);
-                    if ((entry->file = fopen(entry->path, "rb"))) {
-                        image_viso_log(viso->tf.log, "Done\n");
-
-                        /* Add this entry to the FIFO. */
-                        viso->file_fifo[viso->file_fifo_pos++] = entry;
-                        viso->file_fifo_pos &= (sizeof(viso->file_fifo) / sizeof(viso->file_fifo[0])) - 1;
-                    } else {
-                        image_viso_log(viso->tf.log, "Failed\n");
-
-                        /* Clear any existing FIFO entry. */
-                        viso->file_fifo[viso->file_fifo_pos] = NULL;
-                    }
+                /* The file's sectors are contiguous, so read up to its last one at once. */
+                const uint64_t pos  = seek - entry->data_offset;
+                const uint64_t size = entry->stats.st_size;
+                const uint64_t end  = ((size + viso->sector_size - 1) / viso->sector_size) * viso->sector_size;
+
+                run = MIN(count, end - pos);
+                if (pos < size) {
+                    FILE *fp = viso_file_get(viso, entry);
+
+                    if (!fp)
+                        return -1;
+                    read = viso_file_read(fp, buffer, pos, MIN(run, size - pos));
+                    if (read < 0)
+                        return -1;
                 }
-
-                /* Read data. */
-                if (!entry->file || (fseeko64(entry->file, seek - entry->data_offset, SEEK_SET) == -1))
-                    return -1;
-                read = fread(buffer, 1, sector_remain, entry->file);
-                if (sector_remain && !read)
-                    return -1;
             }
 
-            /* Fill remainder with 00 bytes if needed. */
-            if (read < sector_remain)
-                memset(buffer + read, 0x00, sector_remain - read);
+            /* Fill the padding of the last sector, or what a shrunk file no longer has, with 00 bytes. */
+            if ((size_t) read < run)
+                memset(buffer + read, 0x00, run - read);
         }
 
-        /* Move on to the next sector. */
-        buffer += sector_remain;
-        seek += sector_remain;
-        count -= sector_remain;
+        /* Move on to the next run. */
+        buffer += run;
+        seek += run;
+        count -= run;
     }
 
     return 1;
@@ -761,6 +872,24 @@ viso_get_length(void *priv)
     return ((uint64_t) viso->all_sectors) * viso->sector_size;
 }
 
+static void
+viso_free_entries(viso_t *viso)
+{
+    viso_entry_t *entry = viso->root_dir;
+    viso_entry_t *next_entry;
+
+    while (entry) {
+        if (entry->file)
+            fclose(entry->file);
+        next_entry = entry->next;
+        free(entry);
+        entry = next_entry;
+    }
+
+    viso->root_dir         = NULL;
+    viso->open_files_count = 0;
+}
+
 void
 viso_close(void *priv)
 {
@@ -772,27 +901,22 @@ viso_close(void *priv)
 
     image_viso_log(viso->tf.log, "close()\n");
 
-    /* De-allocate everything. */
-    if (tf->fp)
+    /* De-allocate everything. The temporary file is only left if initialization failed. */
+    if (tf->fp) {
         fclose(tf->fp);
 #ifndef ENABLE_IMAGE_VISO_LOG
-    remove(nvr_path(viso->tf.fn));
+        remove(nvr_path(viso->tf.fn));
 #endif
-
-    viso_entry_t *entry = viso->root_dir;
-    viso_entry_t *next_entry;
-    while (entry) {
-        if (entry->file)
-            fclose(entry->file);
-        next_entry = entry->next;
-        free(entry);
-        entry = next_entry;
     }
 
+    viso_free_entries(viso);
+
     if (viso->metadata)
         free(viso->metadata);
     if (viso->entry_map)
         free(viso->entry_map);
+    if (viso->open_files)
+        free(viso->open_files);
 
     if (tf->log != NULL)
         log_close(tf->log);
@@ -800,14 +924,237 @@ viso_close(void *priv)
     free(viso);
 }
 
+static void
+viso_cache_name(char *fn, const char *dirname)
+{
+    uint64_t hash = 0xcbf29ce484222325ULL; /* FNV-1a */
+
+    for (const char *p = dirname; *p; p++)
+        hash = (hash ^ (uint8_t) *p) * 0x100000001b3ULL;
+
+    sprintf(fn, "viso_%016" PRIx64 ".cache", hash);
+}
+
+static void
+viso_cache_stamp(viso_cache_stamp_t *stamp, const char *path, const stat_t *stats)
+{
+    stamp->size     = S_ISDIR(stats->st_mode) ? 0 : stats->st_size;
+    stamp->mtime    = stats->st_mtime;
+    stamp->mode     = stats->st_mode;
+    stamp->path_len = strlen(path);
+}
+
+/* Reads the next stamp and its path, then checks them against the host. */
+static int
+viso_cache_check(FILE *fp, viso_cache_stamp_t *stamp, char **path, uint32_t *path_max, stat_t *stats)
+{
+    if ((fread(stamp, sizeof(viso_cache_stamp_t), 1, fp) != 1) || (stamp->path_len > 65535))
+        return 0;
+
+    if (stamp->path_len >= *path_max) {
+        char *new_path = (char *) realloc(*path, stamp->path_len + 1);
+        if (!new_path)
+            return 0;
+        *path     = new_path;
+        *path_max = stamp->path_len + 1;
+    }
+    if (fread(*path, 1, stamp->path_len, fp) != stamp->path_len)
+        return 0;
+    (*path)[stamp->path_len] = '\0';
+
+    if (stat(*path, stats) != 0)
+        return 0;
+    if (!S_ISDIR(stats->st_mode) && (stats->st_size > ((uint32_t) -1)))
+        stats->st_size = (uint32_t) -1;
+
+    return (stats->st_mtime == stamp->mtime) && (stats->st_mode == stamp->mode) &&
+           (S_ISDIR(stats->st_mode) ? !stamp->size : (stats->st_size == stamp->size));
+}
+
+/* Rebuilds the file entries, entry map and metadata of an unchanged tree from its cache. */
+static int
+viso_cache_load(viso_t *viso, const char *dirname)
+{
+    viso_cache_header_t header;
+    viso_cache_stamp_t  stamp;
+    stat_t              stats;
+    viso_entry_t       *entry;
+    viso_entry_t       *last_entry = NULL;
+    viso_entry_t      **entry_map_p;
+    char                fn[64];
+    char               *path        = NULL;
+    uint32_t            path_max    = 0;
+    const size_t        dirname_len = strlen(dirname);
+    uint64_t            offset;
+    FILE               *fp;
+
+    viso_cache_name(fn, dirname);
+    fp = plat_fopen64(nvr_path(fn), "rb");
+    if (!fp)
+        return 0;
+
+    if ((fread(&header, sizeof(header), 1, fp) != 1) || memcmp(header.magic, VISO_CACHE_MAGIC, sizeof(header.magic)) ||
+        (header.version != VISO_CACHE_VERSION) || strncmp(header.emu_version, EMU_VERSION, sizeof(header.emu_version)) ||
+        (header.tz_offset != tz_offset) || (header.dirname_len != dirname_len) || !header.dirs ||
+        (header.sector_size < VISO_SECTOR_SIZE) || (header.sector_size > (1 << 30)) ||
+        (header.all_sectors < header.metadata_sectors) || !header.metadata_sectors)
+        goto fail;
+
+    /* Every directory must be unchanged, the root first. */
+    for (uint32_t i = 0; i < header.dirs; i++) {
+        if (!viso_cache_check(fp, &stamp, &path, &path_max, &stats) || !S_ISDIR(stats.st_mode) ||
+            (!i && strcmp(path, dirname)))
+            goto fail;
+        if (!i) {
+            viso->root_dir = (viso_entry_t *) calloc(1, sizeof(viso_entry_t) + dirname_len + 1);
+            if (!viso->root_dir)
+                goto fail;
+            strcpy(viso->root_dir->path, dirname);
+            viso->root_dir->stats  = stats;
+            viso->root_dir->parent = viso->root_dir;
+            last_entry             = viso->root_dir;
+        }
+    }
+
+    viso->sector_size      = header.sector_size;
+    viso->metadata_sectors = header.metadata_sectors;
+    viso->all_sectors      = header.all_sectors;
+    viso->entry_map_size   = header.all_sectors - header.metadata_sectors;
+    viso->entry_map        = (viso_entry_t **) calloc(MAX(viso->entry_map_size, 1), sizeof(viso_entry_t *));
+    if (!viso->entry_map)
+        goto fail;
+
+    /* Then every file, in the order their sectors were assigned in. */
+    entry_map_p = viso->entry_map;
+    offset      = ((uint64_t) viso->metadata_sectors) * viso->sector_size;
+    for (uint32_t i = 0; i < header.files; i++) {
+        if (!viso_cache_check(fp, &stamp, &path, &path_max, &stats) || S_ISDIR(stats.st_mode))
+            goto fail;
+
+        size_t size = stats.st_size / viso->sector_size;
+        if (stats.st_size % viso->sector_size)
+            size++; /* round up to the next sector */
+        if (size > (viso->entry_map_size - (entry_map_p - viso->entry_map)))
+            goto fail;
+
+        entry = (viso_entry_t *) calloc(1, sizeof(viso_entry_t) + stamp.path_len + 1);
+        if (!entry)
+            goto fail;
+        strcpy(entry->path, path);
+        entry->stats       = stats;
+        entry->parent      = viso->root_dir;
+        entry->data_offset = offset;
+        last_entry->next   = entry;
+        last_entry         = entry;
+
+        offset += ((uint64_t) size) * viso->sector_size;
+        while (size-- > 0)
+            *entry_map_p++ = entry;
+    }
+    if ((size_t) (entry_map_p - viso->entry_map) != viso->entry_map_size)
+        goto fail;
+
+    viso->metadata = (uint8_t *) malloc(viso->metadata_sectors * viso->sector_size);
+    if (!viso->metadata || (fread(viso->metadata, viso->sector_size, viso->metadata_sectors, fp) != viso->metadata_sectors))
+        goto fail;
+
+    image_viso_log(viso->tf.log, "Loaded %" PRIu32 " directories and %" PRIu32 " files from cache [%s]\n",
+                   header.dirs, header.files, fn);
+
+    fclose(fp);
+    free(path);
+    return 1;
+
+fail:
+    image_viso_log(viso->tf.log, "Cache [%s] is stale or damaged, rebuilding\n", fn);
+
+    fclose(fp);
+    if (path)
+        free(path);
+    viso_free_entries(viso);
+    if (viso->entry_map) {
+        free(viso->entry_map);
+        viso->entry_map = NULL;
+    }
+    if (viso->metadata) {
+        free(viso->metadata);
+        viso->metadata = NULL;
+    }
+    viso->sector_size      = VISO_SECTOR_SIZE;
+    viso->metadata_sectors = viso->all_sectors = viso->entry_map_size = 0;
+    return 0;
+}
+
+static int
+viso_cache_write_stamp(FILE *fp, const char *path, const stat_t *stats, time_t now)
+{
+    viso_cache_stamp_t stamp;
+
+    /* Timestamps this recent may not change with a modification made within their
+       granularity (two seconds on FAT), which would leave the cache undetectably stale. */
+    if ((int64_t) stats->st_mtime >= ((int64_t) now - 2))
+        return 0;
+
+    viso_cache_stamp(&stamp, path, stats);
+    return (fwrite(&stamp, sizeof(stamp), 1, fp) == 1) && (fwrite(path, 1, stamp.path_len, fp) == stamp.path_len);
+}
+
+static void
+viso_cache_save(viso_t *viso, const char *dirname, const viso_entry_t *dirs, time_t now)
+{
+    viso_cache_header_t header = { 0 };
+    const viso_entry_t *entry;
+    char                fn[64];
+    int                 ok;
+    FILE               *fp;
+
+    viso_cache_name(fn, dirname);
+    fp = plat_fopen64(nvr_path(fn), "wb");
+    if (!fp)
+        return;
+
+    header.version          = VISO_CACHE_VERSION;
+    header.sector_size      = viso->sector_size;
+    header.metadata_sectors = viso->metadata_sectors;
+    header.all_sectors      = viso->all_sectors;
+    header.dirs             = 1;
+    for (entry = dirs; entry; entry = entry->next)
+        header.dirs++;
+    for (entry = viso->root_dir->next; entry; entry = entry->next)
+        header.files++;
+    header.dirname_len = strlen(dirname);
+    header.tz_offset   = tz_offset;
+    strncpy(header.emu_version, EMU_VERSION, sizeof(header.emu_version) - 1);
+
+    ok = (fwrite(&header, sizeof(header), 1, fp) == 1) &&
+         viso_cache_write_stamp(fp, dirname, &viso->root_dir->stats, now);
+    for (entry = dirs; ok && entry; entry = entry->next)
+        ok = viso_cache_write_stamp(fp, entry->path, &entry->stats, now);
+    for (entry = viso->root_dir->next; ok && entry; entry = entry->next)
+        ok = viso_cache_write_stamp(fp, entry->path, &entry->stats, now);
+    if (ok)
+        ok = (fwrite(viso->metadata, viso->sector_size, viso->metadata_sectors, fp) == viso->metadata_sectors);
+
+    if (ok) {
+        memcpy(header.magic, VISO_CACHE_MAGIC, sizeof(header.magic));
+        ok = (fflush(fp) == 0) && (fseeko64(fp, 0, SEEK_SET) != -1) && (fwrite(&header, sizeof(header), 1, fp) == 1);
+    }
+    ok &= (fclose(fp) == 0);
+
+    image_viso_log(viso->tf.log, "%s cache [%s]\n", ok ? "Saved" : "Not saving", fn);
+    if (!ok)
+        remove(nvr_path(fn));
+}
+
 track_file_t *
 viso_init(const uint8_t id, const char *dirname, int *error)
 {
     /* Initialize our data structure. */
-    viso_t  *viso = (viso_t *) calloc(1, sizeof(viso_t));
-    uint8_t *data = NULL;
-    uint8_t *p;
-    *error        = 1;
+    viso_t       *viso       = (viso_t *) calloc(1, sizeof(viso_t));
+    viso_entry_t *cache_dirs = NULL;
+    uint8_t      *data       = NULL;
+    uint8_t      *p;
+    *error                   = 1;
 
     if (viso == NULL)
         goto end;
@@ -823,11 +1170,38 @@ viso_init(const uint8_t id, const char *dirname, int *error)
     viso->format             = VISO_FORMAT_ISO | VISO_FORMAT_JOLIET | VISO_FORMAT_RR;
     viso->use_version_suffix = (viso->format & VISO_FORMAT_ISO); /* cleared later if required */
 
+    viso->open_files_max = cdrom[id].viso_open_files;
+    if (viso->open_files_max < 1)
+        viso->open_files_max = CD_VISO_OPEN_FILES_DEFAULT;
+    viso->open_files = (viso_open_file_t *) calloc(viso->open_files_max, sizeof(viso_open_file_t));
+    if (!viso->open_files)
+        goto end;
+
     /* Prepare temporary data buffers. */
     data = calloc(2, viso->sector_size);
     if (!data)
         goto end;
 
+    /* Get current time for the volume descriptors, and calculate
+       the timezone offset for descriptors and file times to use. */
+    tzset();
+    time_t now = time(NULL);
+    struct tm now_tm;
+    if (viso->format & VISO_FORMAT_ISO) { /* timezones are ISO only */
+#ifdef _WIN32
+        gmtime_s(&now_tm, &now);  // Windows: output first param, input second
+#else
+        gmtime_r(&now, &now_tm);  // POSIX: input first param, output second
+#endif
+        tz_offset = (now - mktime(&now_tm)) / (3600 / 4);
+    }
+
+    /* Skip building the metadata if this tree is unchanged since it was last mounted. */
+    if (viso_cache_load(viso, dirname)) {
+        *error = 0;
+        goto end;
+    }
+
         /* Open temporary file. */
 #ifdef ENABLE_IMAGE_VISO_LOG
     strcpy(viso->tf.fn, "viso-debug.iso");
@@ -1042,20 +1416,6 @@ next_dir:
     for (int i = 0; i < 16; i++)
         fwrite(data, viso->sector_size, 1, viso->tf.fp);
 
-    /* Get current time for the volume descriptors, and calculate
-       the timezone offset for descriptors and file times to use. */
-    tzset();
-    time_t now = time(NULL);
-    struct tm now_tm;
-    if (viso->format & VISO_FORMAT_ISO) { /* timezones are ISO only */
-#ifdef _WIN32
-        gmtime_s(&now_tm, &now);  // Windows: output first param, input second
-#else
-        gmtime_r(&now, &now_tm);  // POSIX: input first param, output second
-#endif
-        tz_offset = (now - mktime(&now_tm)) / (3600 / 4);
-    }
-
     /* Get root directory basename for the volume ID. */
     const char *basename = path_get_filename(viso->root_dir->path);
     if (!basename || (basename[0] == '\0'))
@@ -1535,9 +1895,15 @@ next_entry:
     while (entry) {
         /* Skip this entry if it corresponds to a directory. */
         if (S_ISDIR(entry->stats.st_mode)) {
-            /* Deallocate directory entries to save some memory. */
+            /* Deallocate directory entries to save some memory, keeping
+               the actual directories around for the cache until it is saved. */
             prev_entry->next = entry->next;
-            free(entry);
+            if (entry->basename) {
+                entry->next = cache_dirs;
+                cache_dirs  = entry;
+            } else {
+                free(entry);
+            }
             entry = prev_entry->next;
             continue;
         }
@@ -1610,10 +1976,20 @@ next_entry:
     remove(nvr_path(viso->tf.fn));
 #endif
 
+    viso_cache_save(viso, dirname, cache_dirs, now);
+
     /* All good. */
     *error = 0;
 
 end:
+    while (cache_dirs) {
+        entry = cache_dirs->next;
+        free(cache_dirs);
+        cache_dirs = entry;
+    }
+    if (data)
+        free(data);
+
     /* Set the function pointers. */
     viso->tf.priv = viso;
     if (!*error) {
@@ -1627,8 +2003,6 @@ end:
     } else {
         if (viso != NULL) {
             image_viso_log(viso->tf.log, "Initialization failed\n");
-            if (data)
-                free(data);
             viso_close(&viso->tf);
         }
         return NULL;
@@ -774,9 +774,16 @@ load_sound(void)
     else
         sound_is_float = 0;
 
+    sound_output_freq = ini_section_get_int(cat, "sound_output_freq", SOUND_FREQ);
+    if ((sound_output_freq != FREQ_44100) && (sound_output_freq != FREQ_48000) &&
+        (sound_output_freq != FREQ_88200) && (sound_output_freq != FREQ_96000))
+        sound_output_freq = SOUND_FREQ;
+
     p = ini_section_get_string(cat, "fm_driver", "nuked");
     if (!strcmp(p, "ymfm")) {
         fm_driver = FM_DRV_YMFM;
+    } else if (!strcmp(p, "nuked_simd")) {
+        fm_driver = FM_DRV_NUKED_SIMD;
     } else {
         fm_driver = FM_DRV_NUKED;
     }
@@ -1320,6 +1327,15 @@ load_hard_disks(void)
         p                   = ini_section_get_string(cat, temp, tmp2);
         hdd[c].speed_preset = hdd_preset_get_from_internal_name(p);
 
+        /* Fall back to the hdd_NN_msync name the setting had before. */
+        sprintf(temp, "hdd_%02i_msync", c + 1);
+        hdd[c].flush = ini_section_get_int(cat, temp, HDD_FLUSH_NONE);
+        ini_section_delete_var(cat, temp);
+        sprintf(temp, "hdd_%02i_flush", c + 1);
+        hdd[c].flush = ini_section_get_int(cat, temp, hdd[c].flush);
+        if (hdd[c].flush > HDD_FLUSH_SYNC)
+            hdd[c].flush = HDD_FLUSH_NONE;
+
         /* MFM/RLL */
         sprintf(temp, "hdd_%02i_mfm_channel", c + 1);
         if (hdd[c].bus_type == HDD_BUS_MFM)
@@ -1494,6 +1510,8 @@ load_floppy_and_cdrom_drives(void)
 
         sprintf(temp, "fdd_%02i_turbo", c + 1);
         fdd_set_turbo(c, !!ini_section_get_int(cat, temp, 0));
+        sprintf(temp, "fdd_%02i_sector_timing", c + 1);
+        fdd_set_sector_timing(c, !!ini_section_get_int(cat, temp, 0));
         sprintf(temp, "fdd_%02i_check_bpb", c + 1);
         fdd_set_check_bpb(c, !!ini_section_get_int(cat, temp, 1));
 
@@ -1511,6 +1529,10 @@ load_floppy_and_cdrom_drives(void)
             sprintf(temp, "fdd_%02i_turbo", c + 1);
             ini_section_delete_var(cat, temp);
         }
+        if (fdd_get_sector_timing(c) == 0) {
+            sprintf(temp, "fdd_%02i_sector_timing", c + 1);
+            ini_section_delete_var(cat, temp);
+        }
         if (fdd_get_check_bpb(c) == 1) {
             sprintf(temp, "fdd_%02i_check_bpb", c + 1);
             ini_section_delete_var(cat, temp);
@@ -1563,6 +1585,16 @@ load_floppy_and_cdrom_drives(void)
         sprintf(temp, "cdrom_%02i_no_check", c + 1);
         cdrom[c].no_check = ini_section_get_int(cat, temp, 0);
 
+        sprintf(temp, "cdrom_%02i_read_ahead", c + 1);
+        cdrom[c].read_ahead = ini_section_get_int(cat, temp, CD_READ_AHEAD_DEFAULT);
+        if ((cdrom[c].read_ahead < 0) || (cdrom[c].read_ahead > CD_READ_AHEAD_MAX))
+            cdrom[c].read_ahead = CD_READ_AHEAD_DEFAULT;
+
+        sprintf(temp, "cdrom_%02i_viso_open_files", c + 1);
+        cdrom[c].viso_open_files = ini_section_get_int(cat, temp, CD_VISO_OPEN_FILES_DEFAULT);
+        if ((cdrom[c].viso_open_files < 1) || (cdrom[c].viso_open_files > CD_VISO_OPEN_FILES_MAX))
+            cdrom[c].viso_open_files = CD_VISO_OPEN_FILES_DEFAULT;
+
         sprintf(temp, "cdrom_%02i_type", c + 1);
         p = ini_section_get_string(cat, temp, cdrom[c].bus_type == CDROM_BUS_MKE ? "cr563" : "86cd");
         /* TODO: Configuration migration, remove when no longer needed. */
@@ -2254,6 +2286,7 @@ config_load(void)
                 fdd_set_type(i, 0);
 
             fdd_set_turbo(i, 0);
+            fdd_set_sector_timing(i, 0);
             fdd_set_check_bpb(i, 1);
         }
 
@@ -2907,8 +2940,15 @@ save_sound(void)
     else
         ini_section_set_string(cat, "sound_type", (sound_is_float == 1) ? "float" : "int16");
 
+    if (sound_output_freq == SOUND_FREQ)
+        ini_section_delete_var(cat, "sound_output_freq");
+    else
+        ini_section_set_int(cat, "sound_output_freq", sound_output_freq);
+
     if (fm_driver == FM_DRV_NUKED)
         ini_section_delete_var(cat, "fm_driver");
+    else if (fm_driver == FM_DRV_NUKED_SIMD)
+        ini_section_set_string(cat, "fm_driver", "nuked_simd");
     else
         ini_section_set_string(cat, "fm_driver", "ymfm");
 
@@ -3463,6 +3503,12 @@ save_hard_disks(void)
             ini_section_delete_var(cat, temp);
         else
             ini_section_set_string(cat, temp, hdd_preset_get_internal_name(hdd[c].speed_preset));
+
+        sprintf(temp, "hdd_%02i_flush", c + 1);
+        if (hdd_is_valid(c) && (hdd[c].flush != HDD_FLUSH_NONE))
+            ini_section_set_int(cat, temp, hdd[c].flush);
+        else
+            ini_section_delete_var(cat, temp);
     }
 
     ini_delete_section_if_empty(config, cat);
@@ -3505,6 +3551,12 @@ save_floppy_and_cdrom_drives(void)
         else
             ini_section_set_int(cat, temp, fdd_get_turbo(c));
 
+        sprintf(temp, "fdd_%02i_sector_timing", c + 1);
+        if (fdd_get_sector_timing(c) == 0)
+            ini_section_delete_var(cat, temp);
+        else
+            ini_section_set_int(cat, temp, fdd_get_sector_timing(c));
+
         sprintf(temp, "fdd_%02i_check_bpb", c + 1);
         if (fdd_get_check_bpb(c) == 1)
             ini_section_delete_var(cat, temp);
@@ -3543,6 +3595,18 @@ save_floppy_and_cdrom_drives(void)
         else
             ini_section_delete_var(cat, temp);
 
+        sprintf(temp, "cdrom_%02i_read_ahead", c + 1);
+        if ((cdrom[c].bus_type == 0) || (cdrom[c].read_ahead == CD_READ_AHEAD_DEFAULT))
+            ini_section_delete_var(cat, temp);
+        else
+            ini_section_set_int(cat, temp, cdrom[c].read_ahead);
+
+        sprintf(temp, "cdrom_%02i_viso_open_files", c + 1);
+        if ((cdrom[c].bus_type == 0) || (cdrom[c].viso_open_files == CD_VISO_OPEN_FILES_DEFAULT))
+            ini_section_delete_var(cat, temp);
+        else
+            ini_section_set_int(cat, temp, cdrom[c].viso_open_files);
+
         sprintf(temp, "cdrom_%02i_speed", c + 1);
         if ((cdrom[c].bus_type == 0) || (cdrom[c].speed == 8))
             ini_section_delete_var(cat, temp);
@@ -109,6 +109,7 @@
 #define FEATURE_DISABLE_IRQ_SERVICE    0xde
 
 #define IDE_TIME                       10.0
+#define IDE_AIO_POLL_TIME              (2.0 * IDE_TIME)
 
 #define IDE_ATAPI_IS_EARLY             ide->sc->pad0
 
@@ -995,6 +996,58 @@ ide_set_callback(ide_t *ide, double callback)
         timer_on_auto(&ide->timer, callback);
 }
 
+/*
+   Starts reading the sectors of a read command as soon as it is written,
+   so that the host reads them while the emulated seek and transfer time
+   runs, rather than when the callback needs them.
+ */
+static void
+ide_aio_start(ide_t *ide, int dma)
+{
+    const uint32_t count = ide->tf->secount ? ide->tf->secount : 256;
+
+    /* Commands that the callback is going to reject read nothing. */
+    if (!ide->tf->lba && !ide->cfg_spt)
+        return;
+    if ((ide->command == WIN_READ_MULTIPLE) && !ide->blocksize)
+        return;
+
+    /* DMA from a memory-mapped image goes straight from the mapping to guest memory. */
+    if (dma && (hdd_image_get_map(ide->hdd_num, ide_get_sector(ide), count) != NULL))
+        return;
+
+    ide->aio_req = hdd_image_submit(ide->hdd_num, HDD_OP_READ, ide_get_sector(ide), count, ide->sector_buffer);
+}
+
+static void
+ide_aio_cancel(ide_t *ide)
+{
+    if (ide->aio_req != NULL) {
+        hdd_image_req_wait(ide->aio_req);
+        ide->aio_req = NULL;
+    }
+}
+
+/*
+   Collects the read started with the command. Returns 1 if it is still in
+   progress, in which case the callback has been re-armed to look again,
+   so that the guest keeps running while the host waits for its disk.
+ */
+static int
+ide_aio_finish(ide_t *ide, int *ret)
+{
+    if (ide->aio_req == NULL)
+        *ret = hdd_image_read(ide->hdd_num, ide_get_sector(ide),
+                              ide->tf->secount ? ide->tf->secount : 256, ide->sector_buffer);
+    else if ((*ret = hdd_image_req_poll(ide->aio_req)) == HDD_IMAGE_REQ_PENDING) {
+        ide_set_callback(ide, IDE_AIO_POLL_TIME);
+        return 1;
+    } else
+        ide->aio_req = NULL;
+
+    return 0;
+}
+
 void
 ide_set_board_callback(uint8_t board, double callback)
 {
@@ -1579,6 +1632,8 @@ ide_reset_registers(ide_t *ide)
 {
     uint16_t ide_signatures[4] = { 0x7f7f, 0x0000, 0xeb14, 0x7f7f };
 
+    ide_aio_cancel(ide);
+
     ide->tf->atastat  = DRDY_STAT | DSC_STAT;
     ide->tf->error    = 1;
     ide->tf->secount  = 1;
@@ -1724,6 +1779,8 @@ ide_writeb(uint16_t addr, uint8_t val, void *priv)
                 ((val != WIN_SRST) || (ide->type != IDE_ATAPI)))
                 break;
 
+            ide_aio_cancel(ide);
+
             if ((ide->type == IDE_NONE) || ((ide->type & IDE_SHADOW) && (val != WIN_DRIVE_DIAGNOSTICS)))
                 break;
 
@@ -1795,6 +1852,7 @@ ide_writeb(uint16_t addr, uint8_t val, void *priv)
                             wait_time        = seek_time > xfer_time ? seek_time : xfer_time;
                         } else if ((val == WIN_READ_MULTIPLE) && (hdd[ide->hdd_num].speed_preset == 0)) {
                            ide_set_callback(ide, 200.0 * IDE_TIME);
+                           ide_aio_start(ide, 0);
                            ide->do_initial_read = 1;
                            break;
                         } else if ((val == WIN_READ_MULTIPLE) && (ide->blocksize > 0)) {
@@ -1815,6 +1873,7 @@ ide_writeb(uint16_t addr, uint8_t val, void *priv)
                             wait_time        = seek_time + xfer_time;
                         }
                         ide_set_callback(ide, wait_time);
+                        ide_aio_start(ide, (val == WIN_READ_DMA) || (val == WIN_READ_DMA_ALT));
                     } else
                         ide_set_callback(ide, 200.0 * IDE_TIME);
                     ide->do_initial_read = 1;
@@ -2274,6 +2333,7 @@ ide_callback(void *priv)
     const ide_bm_t *bm  = ide_boards[ide->board]->bm;
     int             chk_chs;
     int             ret;
+    uint8_t        *buf = NULL;
     uint8_t         err = 0x00;
 
     ide_log("ide_callback(%i): %02X\n", ide->channel, ide->command);
@@ -2353,10 +2413,10 @@ ide_callback(void *priv)
                 err = IDNF_ERR;
             else {
                 if (ide->do_initial_read) {
+                    if (ide_aio_finish(ide, &ret))
+                        return;
                     ide->do_initial_read = 0;
                     ide->sector_pos      = 0;
-                    ret = hdd_image_read(ide->hdd_num, ide_get_sector(ide),
-                                         ide->tf->secount ? ide->tf->secount : 256, ide->sector_buffer);
                 } else
                     ret = 0;
 
@@ -2394,12 +2454,21 @@ ide_callback(void *priv)
 
                 ide->tf->pos = 0;
 
-                if (hdd_image_read(ide->hdd_num, ide_get_sector(ide), ide->sector_pos, ide->sector_buffer) < 0) {
+                if (ide->aio_req == NULL)
+                    buf = hdd_image_get_map(ide->hdd_num, ide_get_sector(ide), ide->sector_pos);
+                if (buf != NULL)
+                    ret = 0;
+                else if (ide_aio_finish(ide, &ret))
+                    return;
+                else
+                    buf = ide->sector_buffer;
+
+                if (ret < 0) {
                     ide_log("IDE %i: DMA read aborted (image read error)\n", ide->channel);
                     err = UNC_ERR;
                 } else if (!ide_boards[ide->board]->force_ata3 && bm->dma) {
                     /* We should not abort - we should simply wait for the host to start DMA. */
-                    ret = bm->dma(ide->sector_buffer, ide->sector_pos * 512, 0, 0, bm->priv);
+                    ret = bm->dma(buf, ide->sector_pos * 512, 0, 0, bm->priv);
                     if (ret == 2) {
                         /* Bus master DMA disabled, simply wait for the host to enable DMA. */
                         ide->tf->atastat = DRQ_STAT | DRDY_STAT | DSC_STAT;
@@ -2438,10 +2507,10 @@ ide_callback(void *priv)
                 err = IDNF_ERR;
             else {
                 if (ide->do_initial_read) {
+                    if (ide_aio_finish(ide, &ret))
+                        return;
                     ide->do_initial_read = 0;
                     ide->sector_pos      = 0;
-                    ret = hdd_image_read(ide->hdd_num, ide_get_sector(ide),
-                                         ide->tf->secount ? ide->tf->secount : 256, ide->sector_buffer);
                 } else {
                     ret = 0;
                 }
@@ -2851,6 +2920,8 @@ ide_board_close(int board)
         dev = ide_drives[c];
 
         if (dev != NULL) {
+            ide_aio_cancel(dev);
+
             if ((dev->type == IDE_HDD) && (dev->hdd_num != -1))
                 hdd_image_close(dev->hdd_num);
 
@@ -3234,6 +3305,8 @@ ide_drive_reset(int d)
 
     ide_set_signature(ide_drives[d]);
 
+    ide_aio_cancel(ide_drives[d]);
+
     if (ide_drives[d]->sector_buffer)
         memset(ide_drives[d]->sector_buffer, 0, 256 * 512);
 
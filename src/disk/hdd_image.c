@@ -16,6 +16,7 @@
  */
 #define _GNU_SOURCE
 #include <stdarg.h>
+#include <stdatomic.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
@@ -25,14 +26,24 @@
 #include <wchar.h>
 #include <errno.h>
 #ifdef __unix__
+#include <fcntl.h>
 #include <unistd.h>
 #endif
+#if defined(__unix__) && (UINTPTR_MAX > 0xffffffffU)
+#    include <sys/mman.h>
+#    include <sys/stat.h>
+/* Only on 64-bit hosts, where any image fits in the address space. */
+#    define HDD_IMAGE_MMAP
+#endif
 #define HAVE_STDARG_H
 #include <86box/86box.h>
 #include <86box/path.h>
 #include <86box/plat.h>
 #include <86box/random.h>
+#include <86box/thread.h>
+#include <86box/job_pool.h>
 #include <86box/hdd.h>
+#include <86box/hdd_overlay.h>
 #include "minivhd/minivhd.h"
 #include "minivhd/internal.h"
 
@@ -40,19 +51,57 @@
 #define HDD_IMAGE_HDI 1
 #define HDD_IMAGE_HDX 2
 #define HDD_IMAGE_VHD 3
+#define HDD_IMAGE_OVL 4
 
 typedef struct hdd_image_t {
-    FILE     *file; /* Used for HDD_IMAGE_RAW, HDD_IMAGE_HDI, and HDD_IMAGE_HDX. */
-    MVHDMeta *vhd;  /* Used for HDD_IMAGE_VHD. */
-    uint32_t  base;
-    uint32_t  pos;
-    uint32_t  last_sector;
-    uint8_t   type; /* HDD_IMAGE_RAW, HDD_IMAGE_HDI, HDD_IMAGE_HDX, or HDD_IMAGE_VHD */
-    uint8_t   loaded;
+    FILE          *file; /* Used for HDD_IMAGE_RAW, HDD_IMAGE_HDI, and HDD_IMAGE_HDX. */
+    MVHDMeta      *vhd;  /* Used for HDD_IMAGE_VHD. */
+    hdd_overlay_t *ovl;  /* Used for HDD_IMAGE_OVL. */
+    uint32_t       base;
+    uint32_t       pos;
+    uint32_t       last_sector;
+    uint8_t        type; /* HDD_IMAGE_RAW, HDD_IMAGE_HDI, HDD_IMAGE_HDX, HDD_IMAGE_VHD, or HDD_IMAGE_OVL */
+    uint8_t        loaded;
+    uint8_t       *map;  /* Whole file mapped, for HDD_IMAGE_RAW, HDD_IMAGE_HDI, and HDD_IMAGE_HDX. */
+    uint64_t       map_size;
+
+    hdd_overlay_writer_t *writer; /* Claim on a file written other than through an overlay. */
 } hdd_image_t;
 
 hdd_image_t hdd_images[HDD_NUM];
 
+/*
+   Asynchronous requests are carried out by a small job pool, started with
+   the first request, so that a slow host disk stalls the controller that is
+   waiting for the data rather than the whole emulation. Each image has a
+   job of its own that works through its queue, so requests of one image are
+   carried out one at a time and in the order submitted; the synchronous
+   calls wait for the job of their image to go idle first.
+ */
+#define HDD_IMAGE_AIO_THREADS 2
+
+struct hdd_image_req_t {
+    uint8_t          id;
+    uint8_t          op;
+    uint32_t         sector;
+    uint32_t         count;
+    uint8_t         *buffer;
+    int              ret;
+    atomic_int       done;
+    event_t         *event; /* Created by hdd_image_req_wait(), set once done. */
+    hdd_image_req_t *next;
+};
+
+static struct {
+    job_pool_t *pool;
+    mutex_t    *mutex;
+    job_t      *jobs[HDD_NUM];
+
+    /* Protected by the mutex. */
+    hdd_image_req_t *head[HDD_NUM];
+    hdd_image_req_t *tail[HDD_NUM];
+} aio;
+
 static char  empty_sector[512];
 #ifndef __unix__
 static char *empty_sector_1mb;
@@ -76,6 +125,14 @@ hdd_image_log(const char *fmt, ...)
 #    define hdd_image_log(fmt, ...)
 #endif
 
+/* Waits until every request of the image has been carried out. */
+static void
+hdd_image_drain(uint8_t id)
+{
+    if (aio.jobs[id] != NULL)
+        job_wait(aio.jobs[id]);
+}
+
 int
 image_is_hdi(const char *s)
 {
@@ -241,6 +298,87 @@ prepare_new_hard_disk(uint8_t id, uint64_t full_size)
     return 1;
 }
 
+/*
+   Raw, HDI and HDX images keep their sectors at a fixed offset, so they are
+   mapped whole, read-only: reads become copies from the page cache, and a
+   controller can have its DMA go straight from the mapping to guest memory.
+   Writes still go through pwrite(), which the mapping sees, so that a full
+   host disk under a sparse image fails the write instead of raising SIGBUS.
+ */
+static void
+hdd_image_map_file(uint8_t id, uint64_t full_size)
+{
+#ifdef HDD_IMAGE_MMAP
+    const uint64_t size = full_size + hdd_images[id].base;
+    void          *map;
+
+    struct stat    st;
+
+    if ((hdd_images[id].file == NULL) || (size == 0))
+        return;
+
+    /* Pages past the end of the file cannot be touched. */
+    fflush(hdd_images[id].file);
+    if (fstat(fileno(hdd_images[id].file), &st) || ((uint64_t) st.st_size < size))
+        return;
+
+    map = mmap(NULL, size, PROT_READ, MAP_SHARED, fileno(hdd_images[id].file), 0);
+    if (map == MAP_FAILED) {
+        hdd_image_log("Hard disk image %i: Unable to map the image, using file I/O\n", id);
+        return;
+    }
+
+    hdd_images[id].map      = (uint8_t *) map;
+    hdd_images[id].map_size = size;
+#else
+    (void) id;
+    (void) full_size;
+#endif
+}
+
+static void
+hdd_image_unmap_file(uint8_t id)
+{
+#ifdef HDD_IMAGE_MMAP
+    if (hdd_images[id].map != NULL)
+        munmap(hdd_images[id].map, hdd_images[id].map_size);
+#endif
+    hdd_images[id].map      = NULL;
+    hdd_images[id].map_size = 0;
+}
+
+/* Writes sectors just written back to the host disk as chosen for the disk. */
+static void
+hdd_image_written(uint8_t id, uint32_t sector, uint32_t count)
+{
+#ifdef __unix__
+    const int fd = fileno(hdd_images[id].file);
+
+    if (hdd[id].flush == HDD_FLUSH_SYNC)
+        (void) fsync(fd);
+#    ifdef __linux__
+    else if (hdd[id].flush == HDD_FLUSH_ASYNC)
+        (void) sync_file_range(fd, ((off64_t) sector << 9) + hdd_images[id].base, (off64_t) count << 9, SYNC_FILE_RANGE_WRITE);
+#    endif
+#else
+    (void) id;
+    (void) sector;
+    (void) count;
+#endif
+}
+
+/* Returns where the sectors are in the mapping, or NULL if they are not all mapped. */
+static uint8_t *
+hdd_image_map_ptr(uint8_t id, uint32_t sector, uint32_t count)
+{
+    const uint64_t offset = ((uint64_t) sector << 9) + hdd_images[id].base;
+
+    if ((hdd_images[id].map == NULL) || ((offset + ((uint64_t) count << 9)) > hdd_images[id].map_size))
+        return NULL;
+
+    return &hdd_images[id].map[offset];
+}
+
 void
 hdd_image_init(void)
 {
@@ -273,12 +411,18 @@ hdd_image_load(int id)
     hdd_images[id].base = 0;
 
     if (hdd_images[id].loaded) {
+        hdd_image_unmap_file(id);
+        hdd_overlay_release_write(hdd_images[id].writer);
+        hdd_images[id].writer = NULL;
         if (hdd_images[id].file) {
             fclose(hdd_images[id].file);
             hdd_images[id].file = NULL;
         } else if (hdd_images[id].vhd) {
             mvhd_close(hdd_images[id].vhd);
             hdd_images[id].vhd = NULL;
+        } else if (hdd_images[id].ovl) {
+            hdd_overlay_close(hdd_images[id].ovl);
+            hdd_images[id].ovl = NULL;
         }
         hdd_images[id].loaded = 0;
     }
@@ -391,17 +535,56 @@ retry_vhd:
             ret = prepare_new_hard_disk(id, full_size);
             if (ret <= 0)
                 goto fail_raw;
+            hdd_image_map_file(id, full_size);
             return ret;
         } else {
             /* Failed for another reason */
             hdd_image_log("Failed for another reason\n");
 fail_raw:
+            hdd_overlay_release_write(hdd_images[id].writer);
+            hdd_images[id].writer      = NULL;
             hdd_images[id].type        = HDD_IMAGE_RAW;
             hdd_images[id].last_sector = (uint32_t) (((uint64_t) hdd[id].spt) * ((uint64_t) hdd[id].hpc) * ((uint64_t) hdd[id].tracks)) - 1;
             return 1;
         }
     } else {
-        if (image_is_hdi(fn)) {
+        /* Overlays sharing the file as their backing file would not see what this disk writes. */
+        if (!hdd[id].wp && !hdd_overlay_is_overlay(fn)) {
+            hdd_images[id].writer = hdd_overlay_claim_write(fn);
+            if (hdd_images[id].writer == NULL) {
+                hdd_image_log("The image is the backing file of an overlay in use\n");
+                fclose(hdd_images[id].file);
+                hdd_images[id].file = NULL;
+                memset(hdd[id].fn, 0, sizeof(hdd[id].fn));
+                goto fail_raw;
+            }
+        }
+
+        if (hdd_overlay_is_overlay(fn)) {
+            hdd_overlay_info_t info;
+
+            fclose(hdd_images[id].file);
+            hdd_images[id].file = NULL;
+            hdd_images[id].ovl  = hdd_overlay_open(fn, hdd[id].wp);
+            if (hdd_images[id].ovl == NULL) {
+                /* Most likely a backing file has gone missing. */
+                hdd_image_log("Overlay: Unable to open the overlay or its backing chain\n");
+                memset(hdd[id].fn, 0, sizeof(hdd[id].fn));
+                goto fail_raw;
+            }
+
+            /* The geometry of the base image, if it records one. */
+            hdd_overlay_get_info(hdd_images[id].ovl, &info);
+            if (info.tracks && info.hpc && info.spt) {
+                hdd[id].tracks = info.tracks;
+                hdd[id].hpc    = info.hpc;
+                hdd[id].spt    = info.spt;
+            }
+            hdd_images[id].type        = HDD_IMAGE_OVL;
+            hdd_images[id].last_sector = (uint32_t) info.sectors - 1;
+            hdd_images[id].loaded      = 1;
+            return 1;
+        } else if (image_is_hdi(fn)) {
             if (fseeko64(hdd_images[id].file, 0x8, SEEK_SET) == -1)
                 fatal("hdd_image_load(): HDI: Error seeking to offset 0x8\n");
             if (fread(&(hdd_images[id].base), 1, 4, hdd_images[id].file) != 4)
@@ -505,6 +688,9 @@ fail_raw:
         ret                        = 1;
     }
 
+    if (ret == 1)
+        hdd_image_map_file(id, full_size);
+
     return ret;
 }
 
@@ -514,8 +700,10 @@ hdd_image_seek(uint8_t id, uint32_t sector)
     off64_t addr = sector;
     addr         = (uint64_t) sector << 9LL;
 
+    hdd_image_drain(id);
+
     hdd_images[id].pos = sector;
-    if (hdd_images[id].type != HDD_IMAGE_VHD) {
+    if ((hdd_images[id].type != HDD_IMAGE_VHD) && (hdd_images[id].type != HDD_IMAGE_OVL)) {
         if (!hdd_images[id].file || (fseeko64(hdd_images[id].file, addr + hdd_images[id].base, SEEK_SET) == -1)) {
             hdd_image_log("hdd_image_seek(): Error seeking\n");
             return -1;
@@ -525,8 +713,8 @@ hdd_image_seek(uint8_t id, uint32_t sector)
     return 0;
 }
 
-int
-hdd_image_read(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer)
+static int
+hdd_image_do_read(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer)
 {
     int    non_transferred_sectors;
     size_t num_read;
@@ -537,8 +725,43 @@ hdd_image_read(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer)
         hdd_images[id].pos        = sector + count - non_transferred_sectors - 1;
         if (hdd_images[id].vhd->error)
             return -1;
+    } else if (hdd_images[id].type == HDD_IMAGE_OVL) {
+        if (hdd_overlay_read(hdd_images[id].ovl, sector, count, buffer) < 0)
+            return -1;
+        hdd_images[id].pos = sector + count;
     } else {
-        if (!hdd_images[id].file || (fseeko64(hdd_images[id].file, ((uint64_t) (sector) << 9LL) + hdd_images[id].base, SEEK_SET) == -1)) {
+        const uint8_t *map = hdd_image_map_ptr(id, sector, count);
+
+        if (map != NULL) {
+            memcpy(buffer, map, (size_t) count << 9);
+            hdd_images[id].pos = sector + count;
+            return 0;
+        }
+
+        if (!hdd_images[id].file)
+            return -1;
+#ifdef __unix__
+        /* Positioned I/O on the descriptor does not depend on the stream position, nor move it. */
+        const int fd     = fileno(hdd_images[id].file);
+        off64_t   offset = ((uint64_t) (sector) << 9LL) + hdd_images[id].base;
+        size_t    done   = 0;
+
+        while (done < ((size_t) count << 9)) {
+            const ssize_t n = pread(fd, buffer + done, ((size_t) count << 9) - done, offset + done);
+
+            if ((n < 0) && (errno == EINTR))
+                continue;
+            else if (n < 0) {
+                hdd_images[id].pos = sector + (uint32_t) (done >> 9);
+                return -1;
+            } else if (n == 0)
+                break;
+            done += n;
+        }
+        num_read           = done >> 9;
+        hdd_images[id].pos = sector + num_read;
+#else
+        if (fseeko64(hdd_images[id].file, ((uint64_t) (sector) << 9LL) + hdd_images[id].base, SEEK_SET) == -1) {
             hdd_image_log("Hard disk image %i: Read error during seek\n", id);
             return -1;
         }
@@ -547,6 +770,7 @@ hdd_image_read(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer)
         hdd_images[id].pos = sector + num_read;
         if ((num_read < count) && !feof(hdd_images[id].file))
             return -1;
+#endif
     }
 
     return 0;
@@ -581,8 +805,8 @@ hdd_image_read_ex(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer)
     return 0;
 }
 
-int
-hdd_image_write(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer)
+static int
+hdd_image_do_write(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer)
 {
     int    non_transferred_sectors;
     size_t num_write;
@@ -593,8 +817,32 @@ hdd_image_write(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer)
         hdd_images[id].pos        = sector + count - non_transferred_sectors - 1;
         if (hdd_images[id].vhd->error)
             return -1;
+    } else if (hdd_images[id].type == HDD_IMAGE_OVL) {
+        if (hdd_overlay_write(hdd_images[id].ovl, sector, count, buffer) < 0)
+            return -1;
+        hdd_images[id].pos = sector + count;
     } else {
-        if (!hdd_images[id].file || (fseeko64(hdd_images[id].file, ((uint64_t) (sector) << 9LL) + hdd_images[id].base, SEEK_SET) == -1)) {
+        if (!hdd_images[id].file)
+            return -1;
+#ifdef __unix__
+        const int fd     = fileno(hdd_images[id].file);
+        off64_t   offset = ((uint64_t) (sector) << 9LL) + hdd_images[id].base;
+        size_t    done   = 0;
+
+        while (done < ((size_t) count << 9)) {
+            const ssize_t n = pwrite(fd, buffer + done, ((size_t) count << 9) - done, offset + done);
+
+            if ((n < 0) && (errno == EINTR))
+                continue;
+            else if (n <= 0)
+                break;
+            done += n;
+        }
+        num_write          = done >> 9;
+        hdd_images[id].pos = sector + num_write;
+        hdd_image_written(id, sector, num_write);
+#else
+        if (fseeko64(hdd_images[id].file, ((uint64_t) (sector) << 9LL) + hdd_images[id].base, SEEK_SET) == -1) {
             hdd_image_log("Hard disk image %i: Write error during seek\n", id);
             return -1;
         }
@@ -602,6 +850,7 @@ hdd_image_write(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer)
         num_write          = fwrite(buffer, 512, count, hdd_images[id].file);
         hdd_images[id].pos = sector + num_write;
         fflush(hdd_images[id].file);
+#endif
         if (num_write < count)
             return -1;
     }
@@ -609,6 +858,151 @@ hdd_image_write(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer)
     return 0;
 }
 
+/* Carries out the queued requests of one image. */
+static void
+hdd_image_aio_job(void *priv)
+{
+    const uint8_t    id = (uint8_t) (uintptr_t) priv;
+    hdd_image_req_t *req;
+    int              ret;
+
+    while (1) {
+        thread_wait_mutex(aio.mutex);
+        req = aio.head[id];
+        if (req != NULL) {
+            aio.head[id] = req->next;
+            if (aio.head[id] == NULL)
+                aio.tail[id] = NULL;
+        }
+        thread_release_mutex(aio.mutex);
+
+        if (req == NULL)
+            break;
+
+        if (req->op == HDD_OP_WRITE)
+            ret = hdd_image_do_write(req->id, req->sector, req->count, req->buffer);
+        else
+            ret = hdd_image_do_read(req->id, req->sector, req->count, req->buffer);
+
+        thread_wait_mutex(aio.mutex);
+        req->ret = ret;
+        atomic_store_explicit(&req->done, 1, memory_order_release);
+        if (req->event != NULL)
+            thread_set_event(req->event);
+        thread_release_mutex(aio.mutex);
+    }
+}
+
+hdd_image_req_t *
+hdd_image_submit(uint8_t id, int op, uint32_t sector, uint32_t count, uint8_t *buffer)
+{
+    hdd_image_req_t *req = calloc(1, sizeof(hdd_image_req_t));
+
+    req->id     = id;
+    req->op     = op;
+    req->sector = sector;
+    req->count  = count;
+    req->buffer = buffer;
+
+    if (aio.pool == NULL) {
+        aio.pool  = job_pool_create("hdd_image_aio", HDD_IMAGE_AIO_THREADS);
+        aio.mutex = thread_create_mutex();
+    }
+    if (aio.jobs[id] == NULL)
+        aio.jobs[id] = job_create(aio.pool, "hard disk image", hdd_image_aio_job, (void *) (uintptr_t) id);
+
+    thread_wait_mutex(aio.mutex);
+    if (aio.tail[id])
+        aio.tail[id]->next = req;
+    else
+        aio.head[id] = req;
+    aio.tail[id] = req;
+    thread_release_mutex(aio.mutex);
+
+    job_submit(aio.jobs[id]);
+
+    return req;
+}
+
+int
+hdd_image_req_poll(hdd_image_req_t *req)
+{
+    int ret;
+
+    /* Under the mutex, so that the worker is done with the request and its event before they are freed. */
+    thread_wait_mutex(aio.mutex);
+    ret = atomic_load_explicit(&req->done, memory_order_acquire);
+    thread_release_mutex(aio.mutex);
+
+    if (!ret)
+        return HDD_IMAGE_REQ_PENDING;
+
+    ret = req->ret;
+    if (req->event != NULL)
+        thread_destroy_event(req->event);
+    free(req);
+
+    return ret;
+}
+
+int
+hdd_image_req_wait(hdd_image_req_t *req)
+{
+    /* The event is only ever set, never reset, so the one wake-up cannot be lost. */
+    thread_wait_mutex(aio.mutex);
+    if (!atomic_load_explicit(&req->done, memory_order_acquire))
+        req->event = thread_create_event();
+    thread_release_mutex(aio.mutex);
+
+    if (req->event != NULL)
+        thread_wait_event(req->event, -1);
+
+    return hdd_image_req_poll(req);
+}
+
+void
+hdd_image_aio_close(void)
+{
+    if (aio.pool == NULL)
+        return;
+
+    /* Whatever is still queued is carried out before the jobs go. */
+    for (uint8_t i = 0; i < HDD_NUM; i++) {
+        hdd_image_drain(i);
+        job_close(aio.jobs[i]);
+        aio.jobs[i] = NULL;
+    }
+
+    job_pool_close(aio.pool);
+    thread_close_mutex(aio.mutex);
+    aio.pool  = NULL;
+    aio.mutex = NULL;
+}
+
+int
+hdd_image_read(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer)
+{
+    hdd_image_drain(id);
+
+    return hdd_image_do_read(id, sector, count, buffer);
+}
+
+int
+hdd_image_write(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer)
+{
+    hdd_image_drain(id);
+
+    return hdd_image_do_write(id, sector, count, buffer);
+}
+
+uint8_t *
+hdd_image_get_map(uint8_t id, uint32_t sector, uint32_t count)
+{
+    hdd_image_drain(id);
+
+    return hdd_image_map_ptr(id, sector, count);
+}
+
 int
 hdd_image_write_ex(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer)
 {
@@ -629,12 +1023,18 @@ hdd_image_write_ex(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer)
 int
 hdd_image_zero(uint8_t id, uint32_t sector, uint32_t count)
 {
+    hdd_image_drain(id);
+
     if (hdd_images[id].type == HDD_IMAGE_VHD) {
         hdd_images[id].vhd->error   = 0;
         int non_transferred_sectors = mvhd_format_sectors(hdd_images[id].vhd, sector, count);
         hdd_images[id].pos          = sector + count - non_transferred_sectors - 1;
         if (hdd_images[id].vhd->error)
             return -1;
+    } else if (hdd_images[id].type == HDD_IMAGE_OVL) {
+        if (hdd_overlay_zero(hdd_images[id].ovl, sector, count) < 0)
+            return -1;
+        hdd_images[id].pos = sector + count - 1;
     } else {
         memset(empty_sector, 0, 512);
 
@@ -653,6 +1053,7 @@ hdd_image_zero(uint8_t id, uint32_t sector, uint32_t count)
         }
 
         fflush(hdd_images[id].file);
+        hdd_image_written(id, sector, count);
     }
 
     return 0;
@@ -677,6 +1078,9 @@ hdd_image_zero_ex(uint8_t id, uint32_t sector, uint32_t count)
 uint32_t
 hdd_image_get_pos(uint8_t id)
 {
+    /* The requests of the image move it too. */
+    hdd_image_drain(id);
+
     return hdd_images[id].pos;
 }
 
@@ -692,13 +1096,21 @@ hdd_image_unload(uint8_t id, UNUSED(int fn_preserve))
     if (strlen(hdd[id].fn) == 0)
         return;
 
+    hdd_image_drain(id);
+
     if (hdd_images[id].loaded) {
+        hdd_image_unmap_file(id);
+        hdd_overlay_release_write(hdd_images[id].writer);
+        hdd_images[id].writer = NULL;
         if (hdd_images[id].file != NULL) {
             fclose(hdd_images[id].file);
             hdd_images[id].file = NULL;
         } else if (hdd_images[id].vhd != NULL) {
             mvhd_close(hdd_images[id].vhd);
             hdd_images[id].vhd = NULL;
+        } else if (hdd_images[id].ovl != NULL) {
+            hdd_overlay_close(hdd_images[id].ovl);
+            hdd_images[id].ovl = NULL;
         }
         hdd_images[id].loaded = 0;
     }
@@ -716,12 +1128,19 @@ hdd_image_close(uint8_t id)
     if (!hdd_images[id].loaded)
         return;
 
+    hdd_image_drain(id);
+    hdd_image_unmap_file(id);
+    hdd_overlay_release_write(hdd_images[id].writer);
+
     if (hdd_images[id].file != NULL) {
         fclose(hdd_images[id].file);
         hdd_images[id].file = NULL;
     } else if (hdd_images[id].vhd != NULL) {
         mvhd_close(hdd_images[id].vhd);
         hdd_images[id].vhd = NULL;
+    } else if (hdd_images[id].ovl != NULL) {
+        hdd_overlay_close(hdd_images[id].ovl);
+        hdd_images[id].ovl = NULL;
     }
 
     memset(&hdd_images[id], 0, sizeof(hdd_image_t));
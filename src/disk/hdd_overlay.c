@@ -0,0 +1,1183 @@
+/*
+ * 86Box    A hypervisor and IBM PC system emulator that specializes in
+ *          running old operating systems and software designed for IBM
+ *          PC systems and compatibles from 1981 through fairly recent
+ *          system designs based on the PCI bus.
+ *
+ *          This file is part of the 86Box distribution.
+ *
+ *          Copy-on-write overlay hard disk images.
+ *
+ *          An overlay file is a 512-byte header, the name of the backing
+ *          file, a map with one 32-bit entry per block of the disk, and
+ *          the blocks themselves in the order they were first written. A
+ *          map entry of 0 means the block is read from the backing file,
+ *          and any other value n means it is held in data slot n - 1. The
+ *          map is kept in memory, so finding a sector takes no I/O. The
+ *          header fields and map entries are little-endian whatever the
+ *          host, so overlays can move between hosts.
+ *
+ *          Writing part of a block that the overlay does not hold yet
+ *          copies the rest of it from the backing chain first; the block
+ *          is written before its map entry, so an interrupted write
+ *          leaves at worst an unused slot behind.
+ *
+ *          The backing files are never written, and are opened once no
+ *          matter how many overlays use them. Their blocks are kept in a
+ *          single LRU cache shared by every drive, so machines cloned
+ *          from the same base image share one copy of what they read. For
+ *          that cache to stay right, a file is never open as a backing
+ *          file and for writing at the same time: whichever comes second,
+ *          an overlay or another disk image, is refused.
+ *
+ * Authors: 86Box contributors.
+ *
+ *          Copyright 2026 86Box contributors.
+ */
+#ifndef _GNU_SOURCE
+#    define _GNU_SOURCE
+#endif
+#include <inttypes.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <wchar.h>
+#include <errno.h>
+#ifdef __unix__
+#    include <sys/stat.h>
+#    include <unistd.h>
+#endif
+#define HAVE_STDARG_H
+#include <86box/86box.h>
+#include <86box/path.h>
+#include <86box/plat.h>
+#include <86box/thread.h>
+#include <86box/hdd_overlay.h>
+
+#define OVL_MAGIC       "86BOXOVL"
+#define OVL_VERSION     1
+#define OVL_HEADER_SIZE 512
+#define OVL_MAX_DEPTH   16
+#define OVL_DATA_ALIGN  4096
+
+/* The cache holds 64 kB blocks of the backing files, whatever their own block size. */
+#define OVL_CACHE_SHIFT   7
+#define OVL_CACHE_SECTORS (1 << OVL_CACHE_SHIFT)
+#define OVL_CACHE_BLOCKS  256
+#define OVL_CACHE_HASH    512
+
+/* In host order; ovl_read_header() and ovl_write_new() convert it to and from the file. */
+typedef struct ovl_header_t {
+    uint32_t version;       /* At 0x08, after the magic. */
+    uint32_t block_sectors; /* 0x0c */
+    uint64_t sectors;       /* 0x10 */
+    uint64_t map_offset;    /* 0x18 */
+    uint64_t data_offset;   /* 0x20 */
+    uint32_t map_entries;   /* 0x28 */
+    uint32_t backing_len;   /* 0x2c; the name of the backing file follows the header, 0 for none. */
+    uint32_t tracks;        /* 0x30 */
+    uint32_t hpc;           /* 0x34 */
+    uint32_t spt;           /* 0x38 */
+} ovl_header_t;
+
+/* A file opened for writing, by an overlay or as a disk image of its own. */
+struct hdd_overlay_writer_t {
+    char                  path[MAX_IMAGE_PATH_LEN];
+    hdd_overlay_writer_t *next;
+};
+
+struct hdd_overlay_t {
+    char                  path[MAX_IMAGE_PATH_LEN];
+    FILE                 *file;
+    int                   read_only;
+    int                   shared; /* A backing file, opened read-only and cached. */
+    int                   refs;
+    hdd_overlay_writer_t *writer; /* For a file opened for writing. */
+    hdd_overlay_t        *backing;
+    hdd_overlay_t        *next;   /* In the list of shared files. */
+    uint64_t              base;   /* Offset of sector 0, for raw, HDI and HDX files. */
+    uint64_t              sectors;
+    uint32_t             *map;    /* NULL for raw, HDI and HDX files. */
+    uint32_t              slots;  /* Data slots in use. */
+    ovl_header_t          hdr;
+    char                  backing_name[MAX_IMAGE_PATH_LEN];
+#ifndef __unix__
+    mutex_t *io_mutex; /* Positioned I/O is emulated with fseek(). */
+#endif
+};
+
+typedef struct ovl_cache_entry_t {
+    hdd_overlay_t *file; /* NULL if free. */
+    uint64_t       block;
+    int            hash_next;
+    int            lru_prev;
+    int            lru_next;
+    uint8_t       *data;
+} ovl_cache_entry_t;
+
+/* The cache and the lists of shared files and of files opened for writing, protected by the mutex. */
+static struct {
+    mutex_t              *mutex;
+    hdd_overlay_t        *shared;
+    hdd_overlay_writer_t *writers;
+    ovl_cache_entry_t entries[OVL_CACHE_BLOCKS];
+    int               hash[OVL_CACHE_HASH];
+    int               lru_head;
+    int               lru_tail;
+    uint64_t          hits;
+    uint64_t          misses;
+} ovl;
+
+#ifdef ENABLE_HDD_OVERLAY_LOG
+int hdd_overlay_do_log = ENABLE_HDD_OVERLAY_LOG;
+
+static void
+hdd_overlay_log(const char *fmt, ...)
+{
+    va_list ap;
+
+    if (hdd_overlay_do_log) {
+        va_start(ap, fmt);
+        pclog_ex(fmt, ap);
+        va_end(ap);
+    }
+}
+#else
+#    define hdd_overlay_log(fmt, ...)
+#endif
+
+static hdd_overlay_t *ovl_open(const char *fn, int read_only, int depth);
+static void           ovl_release(hdd_overlay_t *l);
+static int            ovl_read(hdd_overlay_t *l, uint64_t sector, uint32_t count, uint8_t *buf);
+
+static void
+ovl_init(void)
+{
+    if (ovl.mutex != NULL)
+        return;
+
+    ovl.mutex = thread_create_mutex();
+    for (int i = 0; i < OVL_CACHE_HASH; i++)
+        ovl.hash[i] = -1;
+    for (int i = 0; i < OVL_CACHE_BLOCKS; i++) {
+        ovl.entries[i].hash_next = -1;
+        ovl.entries[i].lru_prev  = i - 1;
+        ovl.entries[i].lru_next  = (i == (OVL_CACHE_BLOCKS - 1)) ? -1 : (i + 1);
+    }
+    ovl.lru_head = 0;
+    ovl.lru_tail = OVL_CACHE_BLOCKS - 1;
+}
+
+static uint32_t
+ovl_get_le32(const uint8_t *p)
+{
+    return (uint32_t) p[0] | ((uint32_t) p[1] << 8) | ((uint32_t) p[2] << 16) | ((uint32_t) p[3] << 24);
+}
+
+static uint64_t
+ovl_get_le64(const uint8_t *p)
+{
+    return (uint64_t) ovl_get_le32(p) | ((uint64_t) ovl_get_le32(p + 4) << 32);
+}
+
+static void
+ovl_put_le32(uint8_t *p, uint32_t v)
+{
+    p[0] = v & 0xff;
+    p[1] = (v >> 8) & 0xff;
+    p[2] = (v >> 16) & 0xff;
+    p[3] = v >> 24;
+}
+
+static void
+ovl_put_le64(uint8_t *p, uint64_t v)
+{
+    ovl_put_le32(p, (uint32_t) v);
+    ovl_put_le32(p + 4, (uint32_t) (v >> 32));
+}
+
+/* Returns the number of bytes read, which is short only at the end of the file, or -1. */
+static int64_t
+ovl_pread(hdd_overlay_t *l, void *buf, size_t len, uint64_t offset)
+{
+#ifdef __unix__
+    const int fd   = fileno(l->file);
+    size_t    done = 0;
+
+    while (done < len) {
+        const ssize_t n = pread(fd, (uint8_t *) buf + done, len - done, offset + done);
+
+        if ((n < 0) && (errno == EINTR))
+            continue;
+        else if (n < 0)
+            return -1;
+        else if (n == 0)
+            break;
+        done += n;
+    }
+
+    return done;
+#else
+    size_t done;
+
+    thread_wait_mutex(l->io_mutex);
+    if (fseeko64(l->file, offset, SEEK_SET) == -1) {
+        thread_release_mutex(l->io_mutex);
+        return -1;
+    }
+    done = fread(buf, 1, len, l->file);
+    if ((done < len) && !feof(l->file)) {
+        thread_release_mutex(l->io_mutex);
+        return -1;
+    }
+    thread_release_mutex(l->io_mutex);
+
+    return done;
+#endif
+}
+
+static int
+ovl_pwrite(hdd_overlay_t *l, const void *buf, size_t len, uint64_t offset)
+{
+#ifdef __unix__
+    const int fd   = fileno(l->file);
+    size_t    done = 0;
+
+    while (done < len) {
+        const ssize_t n = pwrite(fd, (const uint8_t *) buf + done, len - done, offset + done);
+
+        if ((n < 0) && (errno == EINTR))
+            continue;
+        else if (n <= 0)
+            return -1;
+        done += n;
+    }
+
+    return 0;
+#else
+    int ret = 0;
+
+    thread_wait_mutex(l->io_mutex);
+    if ((fseeko64(l->file, offset, SEEK_SET) == -1) || (fwrite(buf, 1, len, l->file) != len))
+        ret = -1;
+    fflush(l->file);
+    thread_release_mutex(l->io_mutex);
+
+    return ret;
+#endif
+}
+
+/* Cache. */
+static int
+ovl_cache_hash(const hdd_overlay_t *l, uint64_t block)
+{
+    return (int) ((((uintptr_t) l >> 4) ^ (block * 0x9e3779b1ULL)) % OVL_CACHE_HASH);
+}
+
+static void
+ovl_cache_unlink(int i)
+{
+    ovl_cache_entry_t *e = &ovl.entries[i];
+
+    if (e->lru_prev >= 0)
+        ovl.entries[e->lru_prev].lru_next = e->lru_next;
+    else
+        ovl.lru_head = e->lru_next;
+    if (e->lru_next >= 0)
+        ovl.entries[e->lru_next].lru_prev = e->lru_prev;
+    else
+        ovl.lru_tail = e->lru_prev;
+}
+
+static void
+ovl_cache_to_head(int i)
+{
+    ovl_cache_unlink(i);
+    ovl.entries[i].lru_prev = -1;
+    ovl.entries[i].lru_next = ovl.lru_head;
+    if (ovl.lru_head >= 0)
+        ovl.entries[ovl.lru_head].lru_prev = i;
+    else
+        ovl.lru_tail = i;
+    ovl.lru_head = i;
+}
+
+/* Free entries go to the tail, to be reused first. */
+static void
+ovl_cache_to_tail(int i)
+{
+    ovl_cache_unlink(i);
+    ovl.entries[i].lru_next = -1;
+    ovl.entries[i].lru_prev = ovl.lru_tail;
+    if (ovl.lru_tail >= 0)
+        ovl.entries[ovl.lru_tail].lru_next = i;
+    else
+        ovl.lru_head = i;
+    ovl.lru_tail = i;
+}
+
+static int
+ovl_cache_find(const hdd_overlay_t *l, uint64_t block)
+{
+    for (int i = ovl.hash[ovl_cache_hash(l, block)]; i >= 0; i = ovl.entries[i].hash_next) {
+        if ((ovl.entries[i].file == l) && (ovl.entries[i].block == block))
+            return i;
+    }
+
+    return -1;
+}
+
+static void
+ovl_cache_drop(int i)
+{
+    ovl_cache_entry_t *e    = &ovl.entries[i];
+    int               *prev = &ovl.hash[ovl_cache_hash(e->file, e->block)];
+
+    while (*prev != i)
+        prev = &ovl.entries[*prev].hash_next;
+    *prev = e->hash_next;
+
+    e->file      = NULL;
+    e->hash_next = -1;
+    ovl_cache_to_tail(i);
+}
+
+/* Called with the mutex held. */
+static void
+ovl_cache_insert(hdd_overlay_t *l, uint64_t block, const uint8_t *data)
+{
+    const int          i = ovl.lru_tail;
+    ovl_cache_entry_t *e = &ovl.entries[i];
+    int                h;
+
+    if (ovl_cache_find(l, block) >= 0)
+        return;
+
+    if (e->file != NULL)
+        ovl_cache_drop(i);
+    if (e->data == NULL)
+        e->data = malloc(OVL_CACHE_SECTORS << 9);
+
+    memcpy(e->data, data, OVL_CACHE_SECTORS << 9);
+    e->file      = l;
+    e->block     = block;
+    h            = ovl_cache_hash(l, block);
+    e->hash_next = ovl.hash[h];
+    ovl.hash[h]  = i;
+    ovl_cache_to_head(i);
+}
+
+static void
+ovl_cache_purge(const hdd_overlay_t *l)
+{
+    for (int i = 0; i < OVL_CACHE_BLOCKS; i++) {
+        if (ovl.entries[i].file == l)
+            ovl_cache_drop(i);
+    }
+}
+
+/* Reads sectors the file holds itself, taking those of an overlay that it does not hold from its backing chain. */
+static int
+ovl_read_direct(hdd_overlay_t *l, uint64_t sector, uint32_t count, uint8_t *buf)
+{
+    const uint32_t bs = l->hdr.block_sectors;
+
+    if (sector >= l->sectors) {
+        memset(buf, 0, (size_t) count << 9);
+        return 0;
+    }
+    if ((l->sectors - sector) < count) {
+        memset(buf + ((l->sectors - sector) << 9), 0, (size_t) (count - (l->sectors - sector)) << 9);
+        count = (uint32_t) (l->sectors - sector);
+    }
+
+    if (l->map == NULL) {
+        const int64_t n = ovl_pread(l, buf, (size_t) count << 9, l->base + (sector << 9));
+
+        if (n < 0)
+            return -1;
+        /* Short raw images read as zeroes past their end. */
+        memset(buf + n, 0, ((size_t) count << 9) - n);
+        return 0;
+    }
+
+    while (count > 0) {
+        const uint32_t idx   = (uint32_t) (sector / bs);
+        const uint32_t entry = l->map[idx];
+        uint32_t       run   = MIN(count, bs - (uint32_t) (sector % bs));
+        uint32_t       next  = idx + 1;
+
+        /* Extend the run over following blocks held in consecutive slots, or not held at all. */
+        while ((run < count) && (l->map[next] == (entry ? (entry + (next - idx)) : 0))) {
+            run += MIN(count - run, bs);
+            next++;
+        }
+
+        if (entry) {
+            const uint64_t offset = l->hdr.data_offset + (((uint64_t) (entry - 1) * bs + (sector % bs)) << 9);
+
+            if (ovl_pread(l, buf, (size_t) run << 9, offset) != ((int64_t) run << 9))
+                return -1;
+        } else if (ovl_read(l->backing, sector, run, buf) < 0)
+            return -1;
+
+        sector += run;
+        count -= run;
+        buf += (size_t) run << 9;
+    }
+
+    return 0;
+}
+
+/* Whether the file holds any sector of the cache block itself. */
+static int
+ovl_holds_any(const hdd_overlay_t *l, uint64_t block)
+{
+    const uint64_t first = block << OVL_CACHE_SHIFT;
+    uint64_t       last  = first + OVL_CACHE_SECTORS - 1;
+
+    if (first >= l->sectors)
+        return 0;
+    if (l->map == NULL)
+        return 1;
+    if (last >= l->sectors)
+        last = l->sectors - 1;
+
+    for (uint64_t idx = first / l->hdr.block_sectors; idx <= (last / l->hdr.block_sectors); idx++) {
+        if (l->map[idx])
+            return 1;
+    }
+
+    return 0;
+}
+
+static int
+ovl_cache_read(hdd_overlay_t *l, uint64_t sector, uint32_t count, uint8_t *buf)
+{
+    while (count > 0) {
+        const uint64_t block = sector >> OVL_CACHE_SHIFT;
+        const uint32_t off   = sector & (OVL_CACHE_SECTORS - 1);
+        const uint32_t n     = MIN(count, OVL_CACHE_SECTORS - off);
+        int            i;
+
+        if (!ovl_holds_any(l, block)) {
+            /* Nothing of this file here, so cache it where it comes from instead. */
+            if ((l->map == NULL) || (sector >= l->sectors))
+                memset(buf, 0, (size_t) n << 9);
+            else if (ovl_read(l->backing, sector, n, buf) < 0)
+                return -1;
+        } else {
+            thread_wait_mutex(ovl.mutex);
+            i = ovl_cache_find(l, block);
+            if (i >= 0) {
+                memcpy(buf, ovl.entries[i].data + ((size_t) off << 9), (size_t) n << 9);
+                ovl_cache_to_head(i);
+                ovl.hits++;
+                thread_release_mutex(ovl.mutex);
+            } else {
+                uint8_t *data = malloc(OVL_CACHE_SECTORS << 9);
+
+                ovl.misses++;
+                thread_release_mutex(ovl.mutex);
+
+                /* Read without the mutex held, so that a miss does not hold up the other drives. */
+                if (ovl_read_direct(l, block << OVL_CACHE_SHIFT, OVL_CACHE_SECTORS, data) < 0) {
+                    free(data);
+                    return -1;
+                }
+                memcpy(buf, data + ((size_t) off << 9), (size_t) n << 9);
+
+                thread_wait_mutex(ovl.mutex);
+                ovl_cache_insert(l, block, data);
+                thread_release_mutex(ovl.mutex);
+                free(data);
+            }
+        }
+
+        sector += n;
+        count -= n;
+        buf += (size_t) n << 9;
+    }
+
+    return 0;
+}
+
+/* Reads sectors as seen through the file; a missing backing file reads as zeroes. */
+static int
+ovl_read(hdd_overlay_t *l, uint64_t sector, uint32_t count, uint8_t *buf)
+{
+    if (l == NULL) {
+        memset(buf, 0, (size_t) count << 9);
+        return 0;
+    }
+
+    if (l->shared)
+        return ovl_cache_read(l, sector, count, buf);
+
+    return ovl_read_direct(l, sector, count, buf);
+}
+
+/* Gives block idx a data slot, filling what is not being written from the backing chain. */
+static int
+ovl_alloc_block(hdd_overlay_t *l, uint32_t idx, uint32_t off, uint32_t n, const uint8_t *buf)
+{
+    const uint32_t bs     = l->hdr.block_sectors;
+    const uint32_t slot   = l->slots;
+    const uint64_t offset = l->hdr.data_offset + (((uint64_t) slot * bs) << 9);
+    const uint32_t entry  = slot + 1;
+    uint8_t        le[4];
+    int            ret;
+
+    if (n == bs)
+        ret = ovl_pwrite(l, buf, (size_t) bs << 9, offset);
+    else {
+        uint8_t *block = malloc((size_t) bs << 9);
+
+        ret = ovl_read(l->backing, (uint64_t) idx * bs, bs, block);
+        if (ret == 0) {
+            memcpy(block + ((size_t) off << 9), buf, (size_t) n << 9);
+            ret = ovl_pwrite(l, block, (size_t) bs << 9, offset);
+        }
+        free(block);
+    }
+
+    if (ret < 0)
+        return -1;
+
+    /* Only now that the data is in place. */
+    ovl_put_le32(le, entry);
+    if (ovl_pwrite(l, le, sizeof(le), l->hdr.map_offset + ((uint64_t) idx << 2)) < 0)
+        return -1;
+
+    l->map[idx] = entry;
+    l->slots++;
+
+    return 0;
+}
+
+static int
+ovl_write(hdd_overlay_t *l, uint64_t sector, uint32_t count, const uint8_t *buf)
+{
+    const uint32_t bs = l->hdr.block_sectors;
+
+    if (l->read_only || (sector >= l->sectors) || ((l->sectors - sector) < count))
+        return -1;
+
+    if (l->map == NULL)
+        return ovl_pwrite(l, buf, (size_t) count << 9, l->base + (sector << 9));
+
+    while (count > 0) {
+        const uint32_t idx = (uint32_t) (sector / bs);
+        const uint32_t off = (uint32_t) (sector % bs);
+        const uint32_t n   = MIN(count, bs - off);
+
+        if (l->map[idx]) {
+            const uint64_t offset = l->hdr.data_offset + (((uint64_t) (l->map[idx] - 1) * bs + off) << 9);
+
+            if (ovl_pwrite(l, buf, (size_t) n << 9, offset) < 0)
+                return -1;
+        } else if (ovl_alloc_block(l, idx, off, n, buf) < 0)
+            return -1;
+
+        sector += n;
+        count -= n;
+        buf += (size_t) n << 9;
+    }
+
+    return 0;
+}
+
+/* Opening and closing. */
+static uint64_t
+ovl_align(uint64_t v, uint64_t align)
+{
+    return (v + align - 1) & ~(align - 1);
+}
+
+/* Resolves the name of a backing file relative to the directory of the overlay. */
+static void
+ovl_backing_path(char *dest, const char *fn, const char *backing)
+{
+    char dir[MAX_IMAGE_PATH_LEN];
+
+    path_get_dirname(dir, fn);
+    if (path_abs((char *) backing) || (dir[0] == '\0'))
+        snprintf(dest, MAX_IMAGE_PATH_LEN, "%s", backing);
+    else if ((strlen(dir) + strlen(backing) + 2) <= MAX_IMAGE_PATH_LEN)
+        path_append_filename(dest, dir, backing);
+    else
+        dest[0] = '\0';
+}
+
+static int
+ovl_read_header(FILE *fp, ovl_header_t *hdr)
+{
+    uint8_t raw[OVL_HEADER_SIZE];
+
+    if ((fseeko64(fp, 0, SEEK_SET) == -1) || (fread(raw, 1, sizeof(raw), fp) != sizeof(raw)) || memcmp(raw, OVL_MAGIC, 8))
+        return 0;
+
+    hdr->version       = ovl_get_le32(&raw[0x08]);
+    hdr->block_sectors = ovl_get_le32(&raw[0x0c]);
+    hdr->sectors       = ovl_get_le64(&raw[0x10]);
+    hdr->map_offset    = ovl_get_le64(&raw[0x18]);
+    hdr->data_offset   = ovl_get_le64(&raw[0x20]);
+    hdr->map_entries   = ovl_get_le32(&raw[0x28]);
+    hdr->backing_len   = ovl_get_le32(&raw[0x2c]);
+    hdr->tracks        = ovl_get_le32(&raw[0x30]);
+    hdr->hpc           = ovl_get_le32(&raw[0x34]);
+    hdr->spt           = ovl_get_le32(&raw[0x38]);
+
+    return 1;
+}
+
+int
+hdd_overlay_is_overlay(const char *fn)
+{
+    ovl_header_t hdr;
+    FILE        *fp = plat_fopen(fn, "rb");
+    int          ret;
+
+    if (fp == NULL)
+        return 0;
+
+    ret = ovl_read_header(fp, &hdr);
+    fclose(fp);
+
+    return ret;
+}
+
+/* Sets up a file that is not an overlay: raw, or HDI or HDX with their header skipped. */
+static int
+ovl_open_raw(hdd_overlay_t *l)
+{
+    uint8_t  hdr[0x28];
+    uint64_t size;
+
+    if (fseeko64(l->file, 0, SEEK_END) == -1)
+        return 0;
+    size = ftello64(l->file);
+
+    if ((size >= 0x28) && !fseeko64(l->file, 0, SEEK_SET) && (fread(hdr, 1, 8, l->file) == 8) &&
+        (ovl_get_le64(hdr) == 0xD778A82044445459LL)) {
+        if (fread(&hdr[0x08], 1, 0x20, l->file) != 0x20)
+            return 0;
+        l->base       = 0x28;
+        l->sectors    = ovl_get_le64(&hdr[0x08]) >> 9;
+        l->hdr.spt    = ovl_get_le32(&hdr[0x14]);
+        l->hdr.hpc    = ovl_get_le32(&hdr[0x18]);
+        l->hdr.tracks = ovl_get_le32(&hdr[0x1c]);
+    } else if (!strcasecmp(path_get_extension(l->path), "HDI")) {
+        if (fseeko64(l->file, 0, SEEK_SET) || (fread(hdr, 1, 0x20, l->file) != 0x20) || (ovl_get_le32(&hdr[0x10]) != 512))
+            return 0;
+        l->base       = ovl_get_le32(&hdr[0x08]);
+        l->sectors    = ovl_get_le32(&hdr[0x0c]) >> 9;
+        l->hdr.spt    = ovl_get_le32(&hdr[0x14]);
+        l->hdr.hpc    = ovl_get_le32(&hdr[0x18]);
+        l->hdr.tracks = ovl_get_le32(&hdr[0x1c]);
+    } else
+        l->sectors = size >> 9;
+
+    return 1;
+}
+
+static int
+ovl_open_overlay(hdd_overlay_t *l, int depth)
+{
+    ovl_header_t *hdr = &l->hdr;
+    char          backing[MAX_IMAGE_PATH_LEN];
+
+    if ((hdr->version != OVL_VERSION) || !hdr->block_sectors || (hdr->block_sectors & (hdr->block_sectors - 1)) ||
+        (hdr->map_entries != ((hdr->sectors + hdr->block_sectors - 1) / hdr->block_sectors)) ||
+        (hdr->backing_len >= MAX_IMAGE_PATH_LEN)) {
+        hdd_overlay_log("Overlay %s: Bad header\n", l->path);
+        return 0;
+    }
+
+    l->sectors = hdr->sectors;
+
+    if (hdr->backing_len) {
+        if (fread(l->backing_name, 1, hdr->backing_len, l->file) != hdr->backing_len)
+            return 0;
+        l->backing_name[hdr->backing_len] = '\0';
+
+        ovl_backing_path(backing, l->path, l->backing_name);
+        l->backing = ovl_open(backing, 1, depth + 1);
+        if (l->backing == NULL) {
+            hdd_overlay_log("Overlay %s: Unable to open backing file %s\n", l->path, backing);
+            return 0;
+        }
+    }
+
+    l->map = calloc(MAX(hdr->map_entries, 1), sizeof(uint32_t));
+    if ((fseeko64(l->file, hdr->map_offset, SEEK_SET) == -1) ||
+        (fread(l->map, sizeof(uint32_t), hdr->map_entries, l->file) != hdr->map_entries))
+        return 0;
+
+    for (uint32_t i = 0; i < hdr->map_entries; i++) {
+        l->map[i] = ovl_get_le32((const uint8_t *) &l->map[i]);
+        if (l->map[i] > l->slots)
+            l->slots = l->map[i];
+    }
+
+    return 1;
+}
+
+/* Whether two names are of the same file. */
+static int
+ovl_same_file(const char *a, const char *b)
+{
+#ifdef __unix__
+    struct stat sa;
+    struct stat sb;
+
+    if (!stat(a, &sa) && !stat(b, &sb))
+        return (sa.st_dev == sb.st_dev) && (sa.st_ino == sb.st_ino);
+
+    return !strcmp(a, b);
+#else
+    return !strcasecmp(a, b);
+#endif
+}
+
+hdd_overlay_writer_t *
+hdd_overlay_claim_write(const char *fn)
+{
+    hdd_overlay_writer_t *w;
+
+    ovl_init();
+
+    thread_wait_mutex(ovl.mutex);
+    for (hdd_overlay_t *l = ovl.shared; l != NULL; l = l->next) {
+        if (ovl_same_file(l->path, fn)) {
+            thread_release_mutex(ovl.mutex);
+            hdd_overlay_log("Overlay: %s is the backing file of an open overlay, not opening it for writing\n", fn);
+            return NULL;
+        }
+    }
+
+    w = calloc(1, sizeof(hdd_overlay_writer_t));
+    snprintf(w->path, sizeof(w->path), "%s", fn);
+    w->next     = ovl.writers;
+    ovl.writers = w;
+    thread_release_mutex(ovl.mutex);
+
+    return w;
+}
+
+void
+hdd_overlay_release_write(hdd_overlay_writer_t *writer)
+{
+    hdd_overlay_writer_t **prev;
+
+    if (writer == NULL)
+        return;
+
+    thread_wait_mutex(ovl.mutex);
+    for (prev = &ovl.writers; *prev != writer; prev = &(*prev)->next)
+        ;
+    *prev = writer->next;
+    thread_release_mutex(ovl.mutex);
+
+    free(writer);
+}
+
+static void
+ovl_free(hdd_overlay_t *l)
+{
+    hdd_overlay_release_write(l->writer);
+    if (l->backing != NULL)
+        ovl_release(l->backing);
+    if (l->file != NULL)
+        fclose(l->file);
+#ifndef __unix__
+    if (l->io_mutex != NULL)
+        thread_close_mutex(l->io_mutex);
+#endif
+    free(l->map);
+    free(l);
+}
+
+/* Opens a file of the chain; read-only ones are shared. */
+static hdd_overlay_t *
+ovl_open(const char *fn, int read_only, int depth)
+{
+    hdd_overlay_t *l;
+    int            ret;
+
+    if (depth > OVL_MAX_DEPTH) {
+        hdd_overlay_log("Overlay %s: Backing chain too long\n", fn);
+        return NULL;
+    }
+
+    ovl_init();
+
+    if (read_only) {
+        thread_wait_mutex(ovl.mutex);
+        for (l = ovl.shared; l != NULL; l = l->next) {
+            if (!strcmp(l->path, fn)) {
+                l->refs++;
+                thread_release_mutex(ovl.mutex);
+                return l;
+            }
+        }
+        thread_release_mutex(ovl.mutex);
+    }
+
+    l = calloc(1, sizeof(hdd_overlay_t));
+    snprintf(l->path, sizeof(l->path), "%s", fn);
+    l->read_only = read_only;
+#ifndef __unix__
+    l->io_mutex = thread_create_mutex();
+#endif
+
+    if (!read_only) {
+        l->writer = hdd_overlay_claim_write(fn);
+        if (l->writer == NULL) {
+            ovl_free(l);
+            return NULL;
+        }
+    }
+
+    l->file = plat_fopen(fn, read_only ? "rb" : "rb+");
+    if (l->file == NULL) {
+        ovl_free(l);
+        return NULL;
+    }
+
+    if (ovl_read_header(l->file, &l->hdr))
+        ret = ovl_open_overlay(l, depth);
+    else {
+        memset(&l->hdr, 0, sizeof(ovl_header_t));
+        ret = ovl_open_raw(l);
+    }
+    if (!ret) {
+        ovl_free(l);
+        return NULL;
+    }
+
+    if (read_only) {
+        thread_wait_mutex(ovl.mutex);
+        for (hdd_overlay_writer_t *w = ovl.writers; w != NULL; w = w->next) {
+            if (ovl_same_file(w->path, fn)) {
+                thread_release_mutex(ovl.mutex);
+                hdd_overlay_log("Overlay %s: Open for writing by another disk, not sharing it\n", fn);
+                ovl_free(l);
+                return NULL;
+            }
+        }
+        l->shared  = 1;
+        l->refs    = 1;
+        l->next    = ovl.shared;
+        ovl.shared = l;
+        thread_release_mutex(ovl.mutex);
+    }
+
+    hdd_overlay_log("Overlay %s: %" PRIu64 " sectors, %u blocks held, %s\n", fn, l->sectors, l->slots,
+                    read_only ? "read-only" : "read/write");
+
+    return l;
+}
+
+static void
+ovl_release(hdd_overlay_t *l)
+{
+    if (l->shared) {
+        hdd_overlay_t **prev;
+
+        thread_wait_mutex(ovl.mutex);
+        if (--l->refs > 0) {
+            thread_release_mutex(ovl.mutex);
+            return;
+        }
+
+        for (prev = &ovl.shared; *prev != l; prev = &(*prev)->next)
+            ;
+        *prev = l->next;
+        ovl_cache_purge(l);
+
+        /* Give the memory back once no drive uses an overlay any more. */
+        if (ovl.shared == NULL) {
+            for (int i = 0; i < OVL_CACHE_BLOCKS; i++) {
+                free(ovl.entries[i].data);
+                ovl.entries[i].data = NULL;
+            }
+        }
+        thread_release_mutex(ovl.mutex);
+    }
+
+    ovl_free(l);
+}
+
+hdd_overlay_t *
+hdd_overlay_open(const char *fn, int read_only)
+{
+    hdd_overlay_t *l = ovl_open(fn, read_only, 0);
+
+    if ((l != NULL) && (l->map == NULL)) {
+        /* Not an overlay. */
+        ovl_release(l);
+        return NULL;
+    }
+
+    return l;
+}
+
+void
+hdd_overlay_close(hdd_overlay_t *ovl_file)
+{
+    if (ovl_file != NULL)
+        ovl_release(ovl_file);
+}
+
+int
+hdd_overlay_read(hdd_overlay_t *ovl_file, uint64_t sector, uint32_t count, uint8_t *buffer)
+{
+    return ovl_read(ovl_file, sector, count, buffer);
+}
+
+int
+hdd_overlay_write(hdd_overlay_t *ovl_file, uint64_t sector, uint32_t count, const uint8_t *buffer)
+{
+    return ovl_write(ovl_file, sector, count, buffer);
+}
+
+int
+hdd_overlay_zero(hdd_overlay_t *ovl_file, uint64_t sector, uint32_t count)
+{
+    const uint32_t bs   = ovl_file->hdr.block_sectors;
+    uint8_t       *zero = calloc(bs, 512);
+    int            ret  = 0;
+
+    while ((count > 0) && (ret == 0)) {
+        const uint32_t n = MIN(count, bs - (uint32_t) (sector % bs));
+
+        /* A block of a blank overlay that it does not hold reads as zeroes already. */
+        if ((ovl_file->backing != NULL) || ovl_file->map[sector / bs])
+            ret = ovl_write(ovl_file, sector, n, zero);
+
+        sector += n;
+        count -= n;
+    }
+
+    free(zero);
+
+    return ret;
+}
+
+void
+hdd_overlay_get_info(hdd_overlay_t *ovl_file, hdd_overlay_info_t *info)
+{
+    memset(info, 0, sizeof(hdd_overlay_info_t));
+
+    info->path          = ovl_file->path;
+    info->sectors       = ovl_file->sectors;
+    info->block_sectors = ovl_file->hdr.block_sectors;
+    info->blocks        = ovl_file->hdr.map_entries;
+    info->allocated     = ovl_file->slots;
+    info->tracks        = ovl_file->hdr.tracks;
+    info->hpc           = ovl_file->hdr.hpc;
+    info->spt           = ovl_file->hdr.spt;
+}
+
+hdd_overlay_t *
+hdd_overlay_get_backing(hdd_overlay_t *ovl_file)
+{
+    return ovl_file->backing;
+}
+
+void
+hdd_overlay_get_cache_stats(hdd_overlay_cache_stats_t *stats)
+{
+    memset(stats, 0, sizeof(hdd_overlay_cache_stats_t));
+    if (ovl.mutex == NULL)
+        return;
+
+    thread_wait_mutex(ovl.mutex);
+    stats->hits   = ovl.hits;
+    stats->misses = ovl.misses;
+    for (int i = 0; i < OVL_CACHE_BLOCKS; i++)
+        stats->blocks += (ovl.entries[i].file != NULL);
+    thread_release_mutex(ovl.mutex);
+}
+
+/* Creating, committing and flattening. */
+static int
+ovl_write_new(const char *fn, const char *backing, uint64_t sectors, uint32_t block_sectors, const ovl_header_t *geometry)
+{
+    ovl_header_t hdr;
+    FILE        *fp;
+    uint8_t      raw[OVL_HEADER_SIZE];
+    uint8_t      zero[512] = { 0 };
+    uint64_t     pos;
+    int          ret = 1;
+
+    memset(&hdr, 0, sizeof(ovl_header_t));
+    hdr.version       = OVL_VERSION;
+    hdr.block_sectors = block_sectors;
+    hdr.sectors       = sectors;
+    hdr.map_entries   = (uint32_t) ((sectors + block_sectors - 1) / block_sectors);
+    hdr.backing_len   = backing ? (uint32_t) strlen(backing) : 0;
+    hdr.map_offset    = ovl_align(OVL_HEADER_SIZE + hdr.backing_len, 512);
+    hdr.data_offset   = ovl_align(hdr.map_offset + ((uint64_t) hdr.map_entries << 2), OVL_DATA_ALIGN);
+    if (geometry != NULL) {
+        hdr.tracks = geometry->tracks;
+        hdr.hpc    = geometry->hpc;
+        hdr.spt    = geometry->spt;
+    }
+
+    memset(raw, 0, sizeof(raw));
+    memcpy(raw, OVL_MAGIC, 8);
+    ovl_put_le32(&raw[0x08], hdr.version);
+    ovl_put_le32(&raw[0x0c], hdr.block_sectors);
+    ovl_put_le64(&raw[0x10], hdr.sectors);
+    ovl_put_le64(&raw[0x18], hdr.map_offset);
+    ovl_put_le64(&raw[0x20], hdr.data_offset);
+    ovl_put_le32(&raw[0x28], hdr.map_entries);
+    ovl_put_le32(&raw[0x2c], hdr.backing_len);
+    ovl_put_le32(&raw[0x30], hdr.tracks);
+    ovl_put_le32(&raw[0x34], hdr.hpc);
+    ovl_put_le32(&raw[0x38], hdr.spt);
+
+    fp = plat_fopen(fn, "wb");
+    if (fp == NULL)
+        return 0;
+
+    if ((fwrite(raw, 1, sizeof(raw), fp) != sizeof(raw)) ||
+        (hdr.backing_len && (fwrite(backing, 1, hdr.backing_len, fp) != hdr.backing_len)))
+        ret = 0;
+
+    /* The empty map, and the padding up to the first block. */
+    for (pos = OVL_HEADER_SIZE + hdr.backing_len; ret && (pos < hdr.data_offset); pos += 512) {
+        const size_t n = (size_t) MIN(512, hdr.data_offset - pos);
+
+        if (fwrite(zero, 1, n, fp) != n)
+            ret = 0;
+    }
+
+    fclose(fp);
+
+    return ret;
+}
+
+int
+hdd_overlay_create(const char *fn, const char *backing, uint64_t sectors, uint32_t block_sectors)
+{
+    hdd_overlay_t *l = NULL;
+    char           path[MAX_IMAGE_PATH_LEN];
+    int            ret;
+
+    if (!block_sectors || (block_sectors & (block_sectors - 1)) || (backing && (strlen(backing) >= MAX_IMAGE_PATH_LEN)))
+        return 0;
+
+    if (backing != NULL) {
+        ovl_backing_path(path, fn, backing);
+        l = ovl_open(path, 1, 1);
+        if (l == NULL)
+            return 0;
+        if (!sectors)
+            sectors = l->sectors;
+    }
+
+    ret = sectors && ((sectors / block_sectors) < UINT32_MAX) &&
+          ovl_write_new(fn, backing, sectors, block_sectors, l ? &l->hdr : NULL);
+
+    if (l != NULL)
+        ovl_release(l);
+
+    return ret;
+}
+
+int
+hdd_overlay_commit(const char *fn)
+{
+    hdd_overlay_t *top = hdd_overlay_open(fn, 0);
+    hdd_overlay_t *dest;
+    char           path[MAX_IMAGE_PATH_LEN];
+    uint8_t       *buf;
+    uint32_t       bs;
+    int            ret = 1;
+
+    if (top == NULL)
+        return 0;
+    if (top->backing == NULL) {
+        hdd_overlay_close(top);
+        return 0;
+    }
+
+    /* The overlay reads only the blocks it holds from here on; let go of the backing file so it can be written. */
+    ovl_release(top->backing);
+    top->backing = NULL;
+
+    ovl_backing_path(path, top->path, top->backing_name);
+    dest = ovl_open(path, 0, 1);
+    if (dest == NULL) {
+        hdd_overlay_close(top);
+        return 0;
+    }
+
+    bs  = top->hdr.block_sectors;
+    buf = malloc((size_t) bs << 9);
+    for (uint32_t idx = 0; ret && (idx < top->hdr.map_entries); idx++) {
+        const uint64_t sector = (uint64_t) idx * bs;
+        const uint32_t n      = (uint32_t) MIN(bs, top->sectors - sector);
+
+        if (!top->map[idx])
+            continue;
+
+        if ((ovl_read_direct(top, sector, n, buf) < 0) || (sector >= dest->sectors) ||
+            (ovl_write(dest, sector, (uint32_t) MIN(n, dest->sectors - sector), buf) < 0))
+            ret = 0;
+    }
+    free(buf);
+
+    ovl_release(dest);
+    fflush(top->file);
+
+    /* Start over empty, on the same backing file. */
+    if (ret) {
+        const ovl_header_t hdr = top->hdr;
+
+        snprintf(path, sizeof(path), "%s", top->backing_name);
+        hdd_overlay_close(top);
+        return ovl_write_new(fn, path, hdr.sectors, hdr.block_sectors, &hdr);
+    }
+
+    hdd_overlay_close(top);
+
+    return 0;
+}
+
+int
+hdd_overlay_flatten(const char *fn, const char *dest)
+{
+    hdd_overlay_t *l = hdd_overlay_open(fn, 1);
+    FILE          *fp;
+    uint8_t       *buf;
+    int            ret = 1;
+
+    if (l == NULL)
+        return 0;
+
+    fp = plat_fopen(dest, "wb");
+    if (fp == NULL) {
+        hdd_overlay_close(l);
+        return 0;
+    }
+
+    buf = malloc(2048 << 9);
+    for (uint64_t sector = 0; ret && (sector < l->sectors); sector += 2048) {
+        const uint32_t n = (uint32_t) MIN(2048, l->sectors - sector);
+
+        if ((ovl_read(l, sector, n, buf) < 0) || (fwrite(buf, 512, n, fp) != n))
+            ret = 0;
+    }
+    free(buf);
+
+    fclose(fp);
+    hdd_overlay_close(l);
+
+    return ret;
+}
@@ -61,10 +61,21 @@
 #define MVHD_START_TS          946684800
 
 
+/* Sector bitmaps of the most recently used blocks kept in memory. */
+#define MVHD_BITMAP_CACHE      8
+
 typedef struct MVHDSectorBitmap {
-    uint8_t* curr_bitmap;
+    uint8_t* curr_bitmap;  /* Bitmap of curr_block, one of those in the cache */
     int      sector_count;
     int      curr_block;
+    uint8_t* cache_data;   /* Storage for all of the cached bitmaps */
+    uint32_t use_count;
+    struct {
+        uint8_t* bitmap;
+        int      block;    /* -1 if the entry is unused */
+        bool     dirty;    /* Changed since it was last written to the file */
+        uint32_t last_use;
+    } cache[MVHD_BITMAP_CACHE];
 } MVHDSectorBitmap;
 
 typedef struct MVHDFooter {
@@ -121,6 +132,8 @@ struct MVHDMeta {
     MVHDFooter       footer;
     MVHDSparseHeader sparse;
     uint32_t*        block_offset;
+    uint32_t         bat_dirty_first; /* BAT entries changed but not yet written to the file */
+    uint32_t         bat_dirty_count;
     int              sect_per_block;
     MVHDSectorBitmap bitmap;
     int (*read_sectors)(struct MVHDMeta*, uint32_t, int, void*);
@@ -179,7 +179,7 @@ calc_sparse_values(MVHDMeta* vhdm)
 
 
 /**
- * \brief Allocate memory for a sector bitmap.
+ * \brief Allocate memory for the cache of sector bitmaps.
  *
  * Each data block is preceded by a sector bitmap. Each bit indicates whether the corresponding sector
  * is considered 'clean' or 'dirty' (for sparse VHD images), or whether to read from the parent or current
@@ -194,12 +194,18 @@ calc_sparse_values(MVHDMeta* vhdm)
 static int
 init_sector_bitmap(MVHDMeta* vhdm, MVHDError* err)
 {
-    vhdm->bitmap.curr_bitmap = calloc(vhdm->bitmap.sector_count, MVHD_SECTOR_SIZE);
-    if (vhdm->bitmap.curr_bitmap == NULL) {
+    vhdm->bitmap.cache_data = calloc((size_t) vhdm->bitmap.sector_count * MVHD_BITMAP_CACHE, MVHD_SECTOR_SIZE);
+    if (vhdm->bitmap.cache_data == NULL) {
         *err = MVHD_ERR_MEM;
         return -1;
     }
 
+    for (int i = 0; i < MVHD_BITMAP_CACHE; i++) {
+        vhdm->bitmap.cache[i].bitmap = vhdm->bitmap.cache_data + ((size_t) i * vhdm->bitmap.sector_count * MVHD_SECTOR_SIZE);
+        vhdm->bitmap.cache[i].block  = -1;
+    }
+
+    vhdm->bitmap.curr_bitmap = vhdm->bitmap.cache[0].bitmap;
     vhdm->bitmap.curr_block = -1;
 
     return 0;
@@ -595,7 +601,8 @@ cleanup_format_buff:
     vhdm->format_buffer.zero_data = NULL;
 
 cleanup_bitmap:
-    free(vhdm->bitmap.curr_bitmap);
+    free(vhdm->bitmap.cache_data);
+    vhdm->bitmap.cache_data = NULL;
     vhdm->bitmap.curr_bitmap = NULL;
 
 cleanup_bat:
@@ -630,8 +637,9 @@ mvhd_close(MVHDMeta* vhdm)
         free(vhdm->block_offset);
         vhdm->block_offset = NULL;
     }
-    if (vhdm->bitmap.curr_bitmap != NULL) {
-        free(vhdm->bitmap.curr_bitmap);
+    if (vhdm->bitmap.cache_data != NULL) {
+        free(vhdm->bitmap.cache_data);
+        vhdm->bitmap.cache_data = NULL;
         vhdm->bitmap.curr_bitmap = NULL;
     }
     if (vhdm->format_buffer.zero_data != NULL) {
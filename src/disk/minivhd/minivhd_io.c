@@ -97,10 +97,32 @@ mvhd_write_empty_sectors(FILE *f, int sector_count)
 }
 
 /**
- * \brief Read the sector bitmap for a block.
+ * \brief Write a cached sector bitmap to file
  *
- * If the block is sparse, the sector bitmap in memory will be
- * zeroed. Otherwise, the sector bitmap is read from the VHD file.
+ * \param [in] vhdm MiniVHD data structure
+ * \param [in] i The cache entry to write
+ */
+static void
+write_sect_bitmap(MVHDMeta *vhdm, int i)
+{
+    int64_t abs_offset = (int64_t)vhdm->block_offset[vhdm->bitmap.cache[i].block] * MVHD_SECTOR_SIZE;
+
+    if (mvhd_fseeko64(vhdm->f, abs_offset, SEEK_SET) == -1)
+        vhdm->error = 1;
+    if (!fwrite(vhdm->bitmap.cache[i].bitmap, MVHD_SECTOR_SIZE, vhdm->bitmap.sector_count, vhdm->f))
+        vhdm->error = 1;
+
+    vhdm->bitmap.cache[i].dirty = false;
+}
+
+/**
+ * \brief Make the sector bitmap for a block the current one.
+ *
+ * The bitmaps of the last few blocks used are kept in memory, so that
+ * going back and forth between blocks does not read them again. Otherwise
+ * the least recently used one is replaced. If the block is sparse, the
+ * sector bitmap in memory will be zeroed. Otherwise, the sector bitmap is
+ * read from the VHD file.
  *
  * \param [in] vhdm MiniVHD data structure
  * \param [in] blk The block for which to read the sector bitmap from
@@ -108,50 +130,139 @@ mvhd_write_empty_sectors(FILE *f, int sector_count)
 static void
 read_sect_bitmap(MVHDMeta *vhdm, int blk)
 {
-    if (vhdm->block_offset[blk] != MVHD_SPARSE_BLK) {
-        mvhd_fseeko64(vhdm->f, (uint64_t)vhdm->block_offset[blk] * MVHD_SECTOR_SIZE, SEEK_SET);
-        if (!fread(vhdm->bitmap.curr_bitmap, vhdm->bitmap.sector_count * MVHD_SECTOR_SIZE, 1, vhdm->f))
-            vhdm->error = 1;
-    } else
-        memset(vhdm->bitmap.curr_bitmap, 0, vhdm->bitmap.sector_count * MVHD_SECTOR_SIZE);
+    int i;
+    int lru = 0;
+
+    for (i = 0; i < MVHD_BITMAP_CACHE; i++) {
+        if (vhdm->bitmap.cache[i].block == blk)
+            break;
+        if (vhdm->bitmap.cache[i].last_use < vhdm->bitmap.cache[lru].last_use)
+            lru = i;
+    }
+
+    if (i == MVHD_BITMAP_CACHE) {
+        i = lru;
+        if (vhdm->bitmap.cache[i].dirty)
+            write_sect_bitmap(vhdm, i);
+
+        if (vhdm->block_offset[blk] != MVHD_SPARSE_BLK) {
+            mvhd_fseeko64(vhdm->f, (uint64_t)vhdm->block_offset[blk] * MVHD_SECTOR_SIZE, SEEK_SET);
+            if (!fread(vhdm->bitmap.cache[i].bitmap, vhdm->bitmap.sector_count * MVHD_SECTOR_SIZE, 1, vhdm->f)) {
+                vhdm->error = 1;
+                blk = -1; /* Do not keep what could not be read. */
+            }
+        } else
+            memset(vhdm->bitmap.cache[i].bitmap, 0, vhdm->bitmap.sector_count * MVHD_SECTOR_SIZE);
+
+        vhdm->bitmap.cache[i].block = blk;
+    }
 
+    vhdm->bitmap.cache[i].last_use = ++vhdm->bitmap.use_count;
+    vhdm->bitmap.curr_bitmap = vhdm->bitmap.cache[i].bitmap;
     vhdm->bitmap.curr_block = blk;
 }
 
 /**
- * \brief Write the current sector bitmap in memory to file
+ * \brief Write the sector bitmaps changed since they were last written to file
  *
  * \param [in] vhdm MiniVHD data structure
  */
 static void
-write_curr_sect_bitmap(MVHDMeta* vhdm)
+write_dirty_sect_bitmaps(MVHDMeta* vhdm)
 {
-    if (vhdm->bitmap.curr_block >= 0) {
-        int64_t abs_offset = (int64_t)vhdm->block_offset[vhdm->bitmap.curr_block] * MVHD_SECTOR_SIZE;
-        if (mvhd_fseeko64(vhdm->f, abs_offset, SEEK_SET) == -1)
-            vhdm->error = 1;
-        if (!fwrite(vhdm->bitmap.curr_bitmap, MVHD_SECTOR_SIZE, vhdm->bitmap.sector_count, vhdm->f))
-            vhdm->error = 1;
+    for (int i = 0; i < MVHD_BITMAP_CACHE; i++) {
+        if (vhdm->bitmap.cache[i].dirty)
+            write_sect_bitmap(vhdm, i);
+    }
+}
+
+/**
+ * \brief Count how many sectors from a given one have the same bitmap bit
+ *
+ * \param [in] bitmap The sector bitmap
+ * \param [in] sib The first sector in the block
+ * \param [in] max The most sectors to count
+ * \param [out] set Whether the bit of the sectors is set
+ *
+ * \return The number of sectors, at least 1 and at most max
+ */
+static int
+sect_bitmap_run(const uint8_t *bitmap, int sib, int max, bool *set)
+{
+    int n = 1;
+
+    *set = VHD_TESTBIT(bitmap, sib) != 0;
+
+    while (n < max) {
+        const int k = sib + n;
+
+        /* Whole bytes at a time where possible. */
+        if (!(k & 7) && ((max - n) >= 8) && (bitmap[k >> 3] == (*set ? 0xff : 0x00))) {
+            n += 8;
+            continue;
+        }
+        if ((VHD_TESTBIT(bitmap, k) != 0) != *set)
+            break;
+        n++;
     }
+
+    return n;
 }
 
 /**
- * \brief Write block offset from memory into file
+ * \brief Mark a block offset as changed in memory
+ *
+ * Nothing is written here. The changed entries are written together by
+ * write_dirty_bat_entries(), once the sectors that made the blocks
+ * necessary are in the file.
  *
  * \param [in] vhdm MiniVHD data structure
- * \param [in] blk The block for which to write the offset for
+ * \param [in] blk The block whose offset changed
  */
 static void
-write_bat_entry(MVHDMeta *vhdm, int blk)
+mark_bat_entry(MVHDMeta *vhdm, int blk)
 {
-    uint64_t table_offset = vhdm->sparse.bat_offset + ((uint64_t)blk * sizeof *vhdm->block_offset);
-    uint32_t offset = mvhd_to_be32(vhdm->block_offset[blk]);
+    if (!vhdm->bat_dirty_count) {
+        vhdm->bat_dirty_first = blk;
+        vhdm->bat_dirty_count = 1;
+    } else if ((uint32_t) blk < vhdm->bat_dirty_first) {
+        vhdm->bat_dirty_count += vhdm->bat_dirty_first - blk;
+        vhdm->bat_dirty_first = blk;
+    } else if ((uint32_t) blk >= (vhdm->bat_dirty_first + vhdm->bat_dirty_count))
+        vhdm->bat_dirty_count = blk - vhdm->bat_dirty_first + 1;
+}
 
-    if (mvhd_fseeko64(vhdm->f, table_offset, SEEK_SET) == -1)
-        vhdm->error = 1;
-    if (!fwrite(&offset, sizeof offset, 1, vhdm->f))
+/**
+ * \brief Write the changed range of the BAT from memory into file
+ *
+ * \param [in] vhdm MiniVHD data structure
+ */
+static void
+write_dirty_bat_entries(MVHDMeta *vhdm)
+{
+    uint32_t entries[MVHD_BAT_ENT_PER_SECT];
+    uint32_t done = 0;
+
+    if (!vhdm->bat_dirty_count)
+        return;
+
+    if (mvhd_fseeko64(vhdm->f, vhdm->sparse.bat_offset + ((uint64_t)vhdm->bat_dirty_first * sizeof *vhdm->block_offset),
+                      SEEK_SET) == -1)
         vhdm->error = 1;
-    fflush(vhdm->f);
+
+    while (done < vhdm->bat_dirty_count) {
+        uint32_t n = vhdm->bat_dirty_count - done;
+
+        if (n > MVHD_BAT_ENT_PER_SECT)
+            n = MVHD_BAT_ENT_PER_SECT;
+        for (uint32_t i = 0; i < n; i++)
+            entries[i] = mvhd_to_be32(vhdm->block_offset[vhdm->bat_dirty_first + done + i]);
+        if (!fwrite(entries, sizeof *entries, n, vhdm->f))
+            vhdm->error = 1;
+        done += n;
+    }
+
+    vhdm->bat_dirty_count = 0;
 }
 
 /**
@@ -213,7 +324,7 @@ create_block(MVHDMeta *vhdm, int blk)
 
     /* We no longer have a sparse block. Update that BAT! */
     vhdm->block_offset[blk] = sect_offset;
-    write_bat_entry(vhdm, blk);
+    mark_bat_entry(vhdm, blk);
 
     fflush(vhdm->f);
 }
@@ -247,43 +358,95 @@ mvhd_sparse_read(MVHDMeta *vhdm, uint32_t offset, int num_sectors, void *out_buf
 
     uint8_t* buff = (uint8_t*)out_buff;
     int64_t addr = 0ULL;
-    uint32_t s = 0;
-    uint32_t ls = 0;
+    uint32_t s = offset;
+    uint32_t ls = offset + transfer_sectors;
     int blk = 0;
-    int prev_blk = -1;
     int sib = 0;
-    ls = offset + transfer_sectors;
+    int run = 0;
+    bool set;
 
-    for (s = offset; s < ls; s++) {
+    /* Runs of sectors with the same bitmap bit are read, or zeroed, at once. */
+    for (; s < ls; s += run) {
         blk = s / vhdm->sect_per_block;
         sib = s % vhdm->sect_per_block;
-        if (blk != prev_blk) {
-            prev_blk = blk;
-            if (vhdm->bitmap.curr_block != blk) {
-                read_sect_bitmap(vhdm, blk);
-                if (mvhd_fseeko64(vhdm->f, (uint64_t)sib * MVHD_SECTOR_SIZE, SEEK_CUR) == -1)
-                    vhdm->error = 1;
-            } else {
-                addr = (((int64_t) vhdm->block_offset[blk]) + vhdm->bitmap.sector_count + sib) *
-                       MVHD_SECTOR_SIZE;
-                if (mvhd_fseeko64(vhdm->f, addr, SEEK_SET) == -1)
-                    vhdm->error = 1;
-            }
-        }
-
-        if (VHD_TESTBIT(vhdm->bitmap.curr_bitmap, sib)) {
-            if (!fread(buff, MVHD_SECTOR_SIZE, 1, vhdm->f) && !feof(vhdm->f))
+        if (vhdm->bitmap.curr_block != blk)
+            read_sect_bitmap(vhdm, blk);
+
+        run = vhdm->sect_per_block - sib;
+        if ((uint32_t) run > (ls - s))
+            run = ls - s;
+        run = sect_bitmap_run(vhdm->bitmap.curr_bitmap, sib, run, &set);
+
+        if (set) {
+            addr = (((int64_t) vhdm->block_offset[blk]) + vhdm->bitmap.sector_count + sib) *
+                   MVHD_SECTOR_SIZE;
+            if (mvhd_fseeko64(vhdm->f, addr, SEEK_SET) == -1)
                 vhdm->error = 1;
-        } else {
-            memset(buff, 0, MVHD_SECTOR_SIZE);
-            mvhd_fseeko64(vhdm->f, MVHD_SECTOR_SIZE, SEEK_CUR);
-        }
-        buff += MVHD_SECTOR_SIZE;
+            if (!fread(buff, (size_t) run * MVHD_SECTOR_SIZE, 1, vhdm->f) && !feof(vhdm->f))
+                vhdm->error = 1;
+        } else
+            memset(buff, 0, (size_t) run * MVHD_SECTOR_SIZE);
+        buff += (size_t) run * MVHD_SECTOR_SIZE;
     }
 
     return truncated_sectors;
 }
 
+/**
+ * \brief Read sectors through a chain of differencing images
+ *
+ * Runs of sectors present in a differencing image are read from it, and
+ * runs that are not are read from its parent, in turn.
+ *
+ * \param [in] vhdm MiniVHD data structure
+ * \param [in] offset The first sector
+ * \param [in] count The number of sectors, all within the image
+ * \param [out] buff The buffer to read into
+ */
+static void
+diff_read_chain(MVHDMeta *vhdm, uint32_t offset, int count, uint8_t *buff)
+{
+    int blk = 0;
+    int sib = 0;
+    int run = 0;
+    bool set;
+
+    if (vhdm->footer.disk_type != MVHD_TYPE_DIFF) {
+        if (vhdm->footer.disk_type == MVHD_TYPE_DYNAMIC)
+            mvhd_sparse_read(vhdm, offset, count, buff);
+        else
+            mvhd_fixed_read(vhdm, offset, count, buff);
+        return;
+    }
+
+    for (; count > 0; count -= run) {
+        blk = offset / vhdm->sect_per_block;
+        sib = offset % vhdm->sect_per_block;
+        if (vhdm->bitmap.curr_block != blk)
+            read_sect_bitmap(vhdm, blk);
+
+        run = vhdm->sect_per_block - sib;
+        if (run > count)
+            run = count;
+        run = sect_bitmap_run(vhdm->bitmap.curr_bitmap, sib, run, &set);
+
+        /* We handle actual sector reading using the sparse functions,
+           as a differencing VHD is also a sparse VHD */
+        if (set)
+            mvhd_sparse_read(vhdm, offset, run, buff);
+        else {
+            diff_read_chain(vhdm->parent, offset, run, buff);
+            if (vhdm->parent->error) {
+                vhdm->parent->error = 0;
+                vhdm->error = 1;
+            }
+        }
+
+        offset += run;
+        buff += (size_t) run * MVHD_SECTOR_SIZE;
+    }
+}
+
 int
 mvhd_diff_read(MVHDMeta *vhdm, uint32_t offset, int num_sectors, void *out_buff)
 {
@@ -293,41 +456,7 @@ mvhd_diff_read(MVHDMeta *vhdm, uint32_t offset, int num_sectors, void *out_buff)
 
     check_sectors(offset, num_sectors, total_sectors, &transfer_sectors, &truncated_sectors);
 
-    uint8_t *buff = (uint8_t*)out_buff;
-    MVHDMeta *curr_vhdm = vhdm;
-    uint32_t s = 0;
-    uint32_t ls = 0;
-    int blk = 0;
-    int sib = 0;
-    ls = offset + transfer_sectors;
-
-    for (s = offset; s < ls; s++) {
-        while (curr_vhdm->footer.disk_type == MVHD_TYPE_DIFF) {
-            blk = s / curr_vhdm->sect_per_block;
-            sib = s % curr_vhdm->sect_per_block;
-            if (curr_vhdm->bitmap.curr_block != blk) {
-                read_sect_bitmap(curr_vhdm, blk);
-            }
-            if (!VHD_TESTBIT(curr_vhdm->bitmap.curr_bitmap, sib)) {
-                curr_vhdm = curr_vhdm->parent;
-            } else { break; }
-        }
-
-        /* We handle actual sector reading using the fixed or sparse functions,
-           as a differencing VHD is also a sparse VHD */
-        if ((curr_vhdm->footer.disk_type == MVHD_TYPE_DIFF) ||
-            (curr_vhdm->footer.disk_type == MVHD_TYPE_DYNAMIC))
-            mvhd_sparse_read(curr_vhdm, s, 1, buff);
-        else
-            mvhd_fixed_read(curr_vhdm, s, 1, buff);
-        if (curr_vhdm->error) {
-            curr_vhdm->error = 0;
-            vhdm->error = 1;
-        }
-
-        curr_vhdm = vhdm;
-        buff += MVHD_SECTOR_SIZE;
-    }
+    diff_read_chain(vhdm, offset, transfer_sectors, (uint8_t*)out_buff);
 
     return truncated_sectors;
 }
@@ -363,52 +492,49 @@ mvhd_sparse_diff_write(MVHDMeta *vhdm, uint32_t offset, int num_sectors, void *i
 
     uint8_t* buff = (uint8_t *) in_buff;
     int64_t addr = 0ULL;
-    uint32_t s = 0;
-    uint32_t ls = 0;
+    uint32_t s = offset;
+    uint32_t ls = offset + transfer_sectors;
     int blk = 0;
-    int prev_blk = -1;
     int sib = 0;
-    ls = offset + transfer_sectors;
+    int run = 0;
 
     if (offset < total_sectors) {
-        for (s = offset; s < ls; s++) {
+        /* The sectors of each block are written at once. */
+        for (; s < ls; s += run) {
             blk = s / vhdm->sect_per_block;
             sib = s % vhdm->sect_per_block;
-            if (vhdm->bitmap.curr_block != blk && prev_blk >= 0) {
-                /* Write the sector bitmap for the previous block, before we replace it. */
-                write_curr_sect_bitmap(vhdm);
-            }
+            run = vhdm->sect_per_block - sib;
+            if ((uint32_t) run > (ls - s))
+                run = ls - s;
 
             if (vhdm->block_offset[blk] == MVHD_SPARSE_BLK) {
                 /* "read" the sector bitmap first, before creating a new block, as the bitmap will be
                    zero either way */
                 read_sect_bitmap(vhdm, blk);
                 create_block(vhdm, blk);
-            }
-
-            if (blk != prev_blk) {
-                if (vhdm->bitmap.curr_block != blk) {
-                    read_sect_bitmap(vhdm, blk);
-                    if (mvhd_fseeko64(vhdm->f, (uint64_t)sib * MVHD_SECTOR_SIZE, SEEK_CUR) == -1)
-                        vhdm->error = 1;
-                } else {
-                    addr = (((int64_t) vhdm->block_offset[blk]) + vhdm->bitmap.sector_count + sib) *
-                           MVHD_SECTOR_SIZE;
-                    if (mvhd_fseeko64(vhdm->f, addr, SEEK_SET) == -1)
-                        vhdm->error = 1;
-                }
-                prev_blk = blk;
-            }
+            } else if (vhdm->bitmap.curr_block != blk)
+                read_sect_bitmap(vhdm, blk);
 
-            if (!fwrite(buff, MVHD_SECTOR_SIZE, 1, vhdm->f))
+            addr = (((int64_t) vhdm->block_offset[blk]) + vhdm->bitmap.sector_count + sib) *
+                   MVHD_SECTOR_SIZE;
+            if (mvhd_fseeko64(vhdm->f, addr, SEEK_SET) == -1)
                 vhdm->error = 1;
-            VHD_SETBIT(vhdm->bitmap.curr_bitmap, sib);
-            buff += MVHD_SECTOR_SIZE;
+            if (!fwrite(buff, (size_t) run * MVHD_SECTOR_SIZE, 1, vhdm->f))
+                vhdm->error = 1;
+
+            for (int i = sib; i < (sib + run); i++)
+                VHD_SETBIT(vhdm->bitmap.curr_bitmap, i);
+            for (int i = 0; i < MVHD_BITMAP_CACHE; i++) {
+                if (vhdm->bitmap.cache[i].bitmap == vhdm->bitmap.curr_bitmap)
+                    vhdm->bitmap.cache[i].dirty = true;
+            }
+            buff += (size_t) run * MVHD_SECTOR_SIZE;
         }
     }
 
-    /* And write the sector bitmap for the last block we visited to disk */
-    write_curr_sect_bitmap(vhdm);
+    /* And write the sector bitmaps, then the BAT entries of any new blocks, after the data */
+    write_dirty_sect_bitmaps(vhdm);
+    write_dirty_bat_entries(vhdm);
 
     fflush(vhdm->f);
 
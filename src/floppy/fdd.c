@@ -74,6 +74,7 @@ typedef struct fdd_t {
     int densel;
     int head;
     int turbo;
+    int sector_timing;
     int check_bpb;
 } fdd_t;
 
@@ -634,6 +635,18 @@ fdd_get_turbo(int drive)
     return fdd[drive].turbo;
 }
 
+void
+fdd_set_sector_timing(int drive, int sector_timing)
+{
+    fdd[drive].sector_timing = sector_timing;
+}
+
+int
+fdd_get_sector_timing(int drive)
+{
+    return fdd[drive].sector_timing;
+}
+
 void
 fdd_set_check_bpb(int drive, int check_bpb)
 {
@@ -23,6 +23,10 @@
 #include <stdarg.h>
 #include <assert.h>
 #include <wchar.h>
+#ifdef __unix__
+#    include <errno.h>
+#    include <unistd.h>
+#endif
 #define HAVE_STDARG_H
 #include <86box/86box.h>
 #include <86box/timer.h>
@@ -32,6 +36,8 @@
 #include <86box/random.h>
 #include <86box/plat.h>
 #include <86box/ui.h>
+#include <86box/thread.h>
+#include <86box/job_pool.h>
 #include <86box/fdd.h>
 #include <86box/fdc.h>
 #include <86box/fdd_86f.h>
@@ -148,15 +154,18 @@ typedef union decoded_t {
 } decoded_t;
 
 typedef struct sector_t {
-    uint8_t c;
-    uint8_t h;
-    uint8_t r;
-    uint8_t n;
-    uint8_t flags;
-    uint8_t pad;
-    uint8_t pad0;
-    uint8_t pad1;
-    void   *prev;
+    uint8_t  c;
+    uint8_t  h;
+    uint8_t  r;
+    uint8_t  n;
+    uint8_t  flags;
+    uint8_t  pad;
+    uint8_t  pad0;
+    uint8_t  pad1;
+    /* Word positions at which the ID field ends and the data field begins, for sector timing. */
+    uint16_t id_pos;
+    uint16_t data_pos;
+    void    *prev;
 } sector_t;
 
 /* Disk flags:
@@ -178,6 +187,8 @@ typedef struct sector_t {
  *      If bits 6, 5 are 0, and bit 7 is 1, the extra bitcell count
  *      specifies the entire bitcell count
  */
+typedef struct d86f_cache_t d86f_cache_t;
+
 typedef struct d86f_t {
     FILE     *fp;
     uint8_t   state;
@@ -186,6 +197,7 @@ typedef struct d86f_t {
     uint8_t   format_state;
     uint8_t   error_condition;
     uint8_t   id_found;
+    uint8_t   timed_state;
     uint16_t  version;
     uint16_t  disk_flags;
     uint16_t  satisfying_bytes;
@@ -203,26 +215,28 @@ typedef struct d86f_t {
 #ifdef D86F_COMPRESS
     int is_compressed;
 #endif
-    int32_t     extra_bit_cells[2];
-    uint32_t    file_size;
-    uint32_t    index_count;
-    uint32_t    track_pos;
-    uint32_t    datac;
-    uint32_t    id_pos;
-    uint32_t    dma_over;
-    uint32_t    index_hole_pos[2];
-    uint32_t    track_offset[512];
-    sector_id_t last_sector;
-    sector_id_t req_sector;
-    find_t      id_find;
-    find_t      data_find;
-    crc_t       calc_crc;
-    crc_t       track_crc;
-    char        original_file_name[2048];
-    uint8_t    *filebuf;
-    uint8_t    *outbuf;
-    sector_t   *last_side_sector[2];
-    uint16_t    crc_table[256];
+    int32_t       extra_bit_cells[2];
+    uint32_t      file_size;
+    uint32_t      index_count;
+    uint32_t      track_pos;
+    uint32_t      datac;
+    uint32_t      id_pos;
+    uint32_t      dma_over;
+    uint32_t      index_hole_pos[2];
+    uint32_t      track_offset[512];
+    uint64_t      timed_ts;
+    sector_id_t   last_sector;
+    sector_id_t   req_sector;
+    find_t        id_find;
+    find_t        data_find;
+    crc_t         calc_crc;
+    crc_t         track_crc;
+    char          original_file_name[2048];
+    uint8_t      *filebuf;
+    uint8_t      *outbuf;
+    sector_t     *last_side_sector[2];
+    d86f_cache_t *cache;
+    uint16_t      crc_table[256];
 } d86f_t;
 
 static const uint8_t encoded_fm[64] = {
@@ -598,8 +612,9 @@ d86f_register_86f(int drive)
     d86f_handler[drive].check_crc         = 1;
 }
 
-int
-d86f_get_array_size(int drive, int side, int words)
+/* Bytes of bit cells (or words if words is set) of a track, from the disk flags and the track's extra bit cells. */
+static int
+d86f_array_size(uint16_t disk_flags, int32_t extra_bit_cells, int words)
 {
     int array_size;
     int hole;
@@ -607,10 +622,10 @@ d86f_get_array_size(int drive, int side, int words)
     int ssd;
     int mpc;
 
-    rm   = d86f_get_rpm_mode(drive);
-    ssd  = d86f_get_speed_shift_dir(drive);
-    hole = (d86f_handler[drive].disk_flags(drive) >> 1) & 3;
-    mpc  = (d86f_handler[drive].disk_flags(drive) >> 13) & 1;
+    rm   = (disk_flags & 0x60) >> 5;
+    ssd  = (disk_flags & 0x1000) >> 12;
+    hole = (disk_flags >> 1) & 3;
+    mpc  = (disk_flags >> 13) & 1;
 
     if (!rm && ssd) /* Special case - extra bit cells size specifies entire array size. */
         array_size = 0;
@@ -680,7 +695,7 @@ d86f_get_array_size(int drive, int side, int words)
         }
 
     array_size <<= 4;
-    array_size += d86f_handler[drive].extra_bit_cells(drive, side);
+    array_size += extra_bit_cells;
 
     if (mpc && !words) {
         if (array_size & 7)
@@ -700,6 +715,12 @@ d86f_get_array_size(int drive, int side, int words)
     return array_size;
 }
 
+int
+d86f_get_array_size(int drive, int side, int words)
+{
+    return d86f_array_size(d86f_handler[drive].disk_flags(drive), d86f_handler[drive].extra_bit_cells(drive, side), words);
+}
+
 int
 d86f_valid_bit_rate(int drive)
 {
@@ -2450,6 +2471,184 @@ d86f_turbo_poll(int drive, int side)
     }
 }
 
+/*
+ * Sector timing: the sector-level state machine of turbo mode, but with
+ * each step taken when the head would reach the field it concerns. The
+ * position of the head is worked out from the time elapsed since the last
+ * poll, and the poll timer is set to fire at the next ID or data field
+ * instead of on every bit cell. READ TRACK and FORMAT TRACK, and wrong
+ * densities, still go through the bit cell emulation.
+ */
+static int
+d86f_sector_timing(int drive)
+{
+    return fdd_get_sector_timing(drive) && !fdd_get_turbo(drive) && (d86f[drive]->version == 0x0063);
+}
+
+static int
+d86f_timed_state(uint8_t state)
+{
+    return (state != STATE_SECTOR_NOT_FOUND) && ((state & 0xF0) != 0xE0);
+}
+
+static sector_t *
+d86f_timed_find_sector(int drive, int side, sector_id_t *id)
+{
+    const d86f_t   *dev = d86f[drive];
+    sector_t       *s   = dev->last_side_sector[side];
+
+    while (s) {
+        if ((s->c == id->id.c) && (s->h == id->id.h) && (s->r == id->id.r) && (s->n == id->id.n))
+            return s;
+        s = s->prev;
+    }
+
+    return NULL;
+}
+
+/* Bit cells from the head position to the start of the given word. */
+static uint32_t
+d86f_timed_distance(int drive, int side, uint16_t word)
+{
+    const d86f_t *dev = d86f[drive];
+    uint32_t      raw = d86f_handler[drive].get_raw_size(drive, side);
+
+    return ((((uint32_t) word << 4) % raw) + raw - dev->track_pos) % raw;
+}
+
+/* Move the head on by the bit cells that went by since the last poll. */
+static void
+d86f_timed_advance(int drive, int side)
+{
+    d86f_t  *dev    = d86f[drive];
+    uint64_t period = d86f_byteperiod(drive);
+    uint32_t raw    = d86f_handler[drive].get_raw_size(drive, side);
+    uint64_t bits;
+
+    bits = (((uint64_t) tsc << 32) - dev->timed_ts) / period;
+
+    dev->track_pos = (uint32_t) ((dev->track_pos + (bits % raw)) % raw);
+    dev->timed_ts += bits * period;
+}
+
+/* Bit cells until the current state has something to do, 0 if it can go on right away. */
+static uint32_t
+d86f_timed_wait(int drive, int side)
+{
+    d86f_t   *dev   = d86f[drive];
+    uint32_t  raw   = d86f_handler[drive].get_raw_size(drive, side);
+    uint32_t  spins = (raw - dev->track_pos) + raw;
+    uint32_t  dist;
+    uint32_t  best  = 0;
+    sector_t *s;
+
+    switch (dev->state) {
+        case STATE_0A_FIND_ID:
+            /* The first ID field to go by the head. */
+            dev->id_found = 0;
+            for (s = dev->last_side_sector[side]; s; s = s->prev) {
+                if (s->flags & SECTOR_NO_ID)
+                    continue;
+                dist = d86f_timed_distance(drive, side, s->id_pos);
+                if (!dist)
+                    dist = raw;
+                if (!dev->id_found || (dist < best)) {
+                    dev->id_found         = 1;
+                    best                  = dist;
+                    dev->last_sector.id.c = s->c;
+                    dev->last_sector.id.h = s->h;
+                    dev->last_sector.id.r = s->r;
+                    dev->last_sector.id.n = s->n;
+                }
+            }
+            return dev->id_found ? best : spins;
+
+        case STATE_05_FIND_ID:
+        case STATE_09_FIND_ID:
+        case STATE_06_FIND_ID:
+        case STATE_0C_FIND_ID:
+        case STATE_11_FIND_ID:
+        case STATE_16_FIND_ID:
+            /* Not there, the controller gives up after two index pulses. */
+            s = d86f_timed_find_sector(drive, side, &dev->req_sector);
+            if ((s == NULL) || (s->flags & SECTOR_NO_ID))
+                return spins;
+            return d86f_timed_distance(drive, side, s->id_pos);
+
+        case STATE_05_READ_ID:
+        case STATE_09_READ_ID:
+        case STATE_06_READ_ID:
+        case STATE_0C_READ_ID:
+        case STATE_11_READ_ID:
+        case STATE_16_READ_ID:
+            s = d86f_timed_find_sector(drive, side, &dev->last_sector);
+            return s ? d86f_timed_distance(drive, side, s->data_pos) : 0;
+
+        case STATE_06_READ_DATA:
+        case STATE_0C_READ_DATA:
+        case STATE_11_SCAN_DATA:
+        case STATE_16_VERIFY_DATA:
+        case STATE_05_WRITE_DATA:
+        case STATE_09_WRITE_DATA:
+            /* DMA moves the whole sector once it has gone by, PIO a byte at a time. */
+            if (fdc_is_dma(d86f_fdc))
+                return ((128 << dev->last_sector.id.n) + 2) << 4;
+            return 16;
+
+        case STATE_IDLE:
+            return raw - dev->track_pos;
+
+        default:
+            return 0;
+    }
+}
+
+static void
+d86f_timed_poll(int drive, int side)
+{
+    d86f_t  *dev  = d86f[drive];
+    uint32_t bits = 0;
+
+    d86f_timed_advance(drive, side);
+
+    while (1) {
+        /* The head is where the state was waiting for. */
+        if ((dev->state != STATE_IDLE) && (dev->state == dev->timed_state)) {
+            if ((dev->state == STATE_0A_FIND_ID) && !dev->id_found) {
+                dev->state = STATE_IDLE;
+                fdc_noidam(d86f_fdc);
+            } else
+                d86f_turbo_poll(drive, side);
+        }
+
+        if (!d86f_timed_state(dev->state)) {
+            /* A callback started a command that needs the bit cells. */
+            dev->timed_state = STATE_IDLE;
+            timer_set_delay_u64(&fdd_poll_time[drive], d86f_byteperiod(drive));
+            return;
+        }
+
+        bits             = d86f_timed_wait(drive, side);
+        dev->timed_state = dev->state;
+        if (bits || (dev->state == STATE_IDLE))
+            break;
+    }
+
+    timer_set_delay_u64(&fdd_poll_time[drive], bits * d86f_byteperiod(drive));
+}
+
+/* Have a command that was just started looked at on the next bit cell rather than up to a revolution later. */
+static void
+d86f_timed_start(int drive)
+{
+    d86f_t *dev = d86f[drive];
+
+    if (d86f_sector_timing(drive) && timer_is_enabled(&fdd_poll_time[drive])) {
+        dev->timed_state = STATE_IDLE;
+        timer_set_delay_u64(&fdd_poll_time[drive], d86f_byteperiod(drive));
+    }
+}
+
 void
 d86f_poll(int drive)
 {
@@ -2479,6 +2678,14 @@ d86f_poll(int drive)
         return;
     }
 
+    if (d86f_sector_timing(drive)) {
+        if (d86f_timed_state(dev->state)) {
+            d86f_timed_poll(drive, side);
+            return;
+        }
+        dev->timed_ts = (uint64_t) tsc << 32;
+    }
+
     if ((dev->state != STATE_02_SPIN_TO_INDEX) && (dev->state != STATE_0D_SPIN_TO_INDEX))
         d86f_get_bit(drive, side ^ 1);
 
@@ -2710,7 +2917,7 @@ d86f_prepare_sector(int drive, int side, int prev_pos, uint8_t *id_buf, uint8_t
     d86f_t   *dev = d86f[drive];
     uint16_t  pos;
     int       i;
-    sector_t *s;
+    sector_t *s = NULL;
 
     int      real_gap2_len = gap2;
     int      real_gap3_len = gap3;
@@ -2725,7 +2932,7 @@ d86f_prepare_sector(int drive, int side, int prev_pos, uint8_t *id_buf, uint8_t
     uint16_t dataam_mfm  = 0x4555;
     uint16_t datadam_mfm = 0x4A55;
 
-    if (fdd_get_turbo(drive) && (dev->version == 0x0063)) {
+    if ((fdd_get_turbo(drive) || fdd_get_sector_timing(drive)) && (dev->version == 0x0063)) {
         s = (sector_t *) calloc(1, sizeof(sector_t));
         s->c     = id_buf[0];
         s->h     = id_buf[1];
@@ -2750,6 +2957,9 @@ d86f_prepare_sector(int drive, int side, int prev_pos, uint8_t *id_buf, uint8_t
 
     sync_len = mfm ? 12 : 6;
 
+    if (s)
+        s->id_pos = pos;
+
     if (!(flags & SECTOR_NO_ID)) {
         for (i = 0; i < sync_len; i++) {
             d86f_write_direct_common(drive, side, 0, 0, pos);
@@ -2776,12 +2986,17 @@ d86f_prepare_sector(int drive, int side, int prev_pos, uint8_t *id_buf, uint8_t
             d86f_write_direct_common(drive, side, dev->calc_crc.bytes[i], 0, pos);
             pos = (pos + 1) % raw_size;
         }
+        if (s)
+            s->id_pos = pos;
         for (i = 0; i < real_gap2_len; i++) {
             d86f_write_direct_common(drive, side, gap_fill, 0, pos);
             pos = (pos + 1) % raw_size;
         }
     }
 
+    if (s)
+        s->data_pos = pos;
+
     if (!(flags & SECTOR_NO_DATA)) {
         for (i = 0; i < sync_len; i++) {
             d86f_write_direct_common(drive, side, 0, 0, pos);
@@ -2798,6 +3013,8 @@ d86f_prepare_sector(int drive, int side, int prev_pos, uint8_t *id_buf, uint8_t
         d86f_write_direct_common(drive, side, mfm ? ((flags & SECTOR_DELETED_DATA) ? datadam_mfm : dataam_mfm) : ((flags & SECTOR_DELETED_DATA) ? datadam_fm : dataam_fm), 1, pos);
         pos = (pos + 1) % raw_size;
         d86f_calccrc(dev, (flags & SECTOR_DELETED_DATA) ? 0xF8 : 0xFB);
+        if (s)
+            s->data_pos = pos;
         if (data_len > 0) {
             for (i = 0; i < data_len; i++) {
                 d86f_write_direct_common(drive, side, data_buf[i], 0, pos);
@@ -2940,19 +3157,405 @@ d86f_track_header_size(int drive)
     return temp;
 }
 
+/*
+ * Track cache of 86F images.
+ *
+ * The tracks of an image are read into memory by a small job pool as soon
+ * as it is loaded, and tracks changed by a write or a format are handed to
+ * the same pool to write back, so that neither a seek nor a sector write
+ * waits on the host disk. A seek only blocks if its track has not been read
+ * yet, and that track is read next. Each image has a job of its own, so its
+ * file is used by one worker at a time; a run of the job does one thing and
+ * submits the job again, writes first, then the track a seek waits for,
+ * then the others in order.
+ */
+#define D86F_WORKER_THREADS 2
+
+typedef struct d86f_cache_track_t {
+    uint16_t side_flags;
+    int32_t  extra_bit_cells;
+    uint32_t index_hole_pos;
+    uint32_t size;  /* Bytes of bit cells, the surface data follows if the image has any. */
+    uint8_t *data;
+    uint8_t  ready;
+    uint8_t  dirty;
+    uint8_t  failed; /* Ready, but could not be read. */
+} d86f_cache_track_t;
+
+struct d86f_cache_t {
+    FILE     *fp;
+    uint16_t  disk_flags;
+    int       tracks;
+    int       next;   /* Next track to read in order. */
+    int       wanted; /* Track a seek is waiting for, -1 if none. */
+    int       table_dirty;
+    int       closing;
+    uint32_t  track_offset[512];
+    job_t    *job;
+    event_t  *done; /* Set whenever a track has been read. */
+
+    d86f_cache_track_t track[512];
+};
+
+/* The mutex protects the caches, the workers take it to pick and hand in their work. */
+static struct {
+    job_pool_t *pool;
+    mutex_t    *mutex;
+} d86f_pool;
+
+static int
+d86f_cache_pread(d86f_cache_t *cache, void *buf, uint32_t len, uint32_t offset)
+{
+#ifdef __unix__
+    const int fd   = fileno(cache->fp);
+    uint32_t  done = 0;
+
+    while (done < len) {
+        const ssize_t n = pread(fd, (uint8_t *) buf + done, len - done, (off_t) offset + done);
+
+        if ((n < 0) && (errno == EINTR))
+            continue;
+        else if (n <= 0)
+            break;
+        done += n;
+    }
+
+    return done == len;
+#else
+    if (fseek(cache->fp, offset, SEEK_SET) == -1)
+        return 0;
+
+    return fread(buf, 1, len, cache->fp) == len;
+#endif
+}
+
+static void
+d86f_cache_pwrite(d86f_cache_t *cache, const void *buf, uint32_t len, uint32_t offset)
+{
+#ifdef __unix__
+    const int fd   = fileno(cache->fp);
+    uint32_t  done = 0;
+
+    while (done < len) {
+        const ssize_t n = pwrite(fd, (const uint8_t *) buf + done, len - done, (off_t) offset + done);
+
+        if ((n < 0) && (errno == EINTR))
+            continue;
+        else if (n <= 0) {
+            d86f_log("86F: Error writing back %u bytes at %08X\n", len, offset);
+            break;
+        }
+        done += n;
+    }
+#else
+    if ((fseek(cache->fp, offset, SEEK_SET) == -1) || (fwrite(buf, 1, len, cache->fp) != len))
+        d86f_log("86F: Error writing back %u bytes at %08X\n", len, offset);
+    fflush(cache->fp);
+#endif
+}
+
+/* Reads a track into its cache entry, returns 0 if it could not be read. */
+static int
+d86f_cache_read_track(d86f_cache_t *cache, uint32_t offset, d86f_cache_track_t *t)
+{
+    uint8_t header[10];
+    int     extra = (cache->disk_flags & 0x80) ? 4 : 0;
+    int     size;
+
+    if (!d86f_cache_pread(cache, header, 6 + extra, offset))
+        return 0;
+
+    t->side_flags = header[0] | (header[1] << 8);
+    if (extra) {
+        memcpy(&t->extra_bit_cells, &header[2], 4);
+        /* If RPM shift is 0% and direction is 1, the extra bit cells are the whole track length. */
+        if ((cache->disk_flags & 0x1060) != 0x1000) {
+            if (t->extra_bit_cells < -32768)
+                t->extra_bit_cells = -32768;
+            if (t->extra_bit_cells > 32768)
+                t->extra_bit_cells = 32768;
+        }
+    } else
+        t->extra_bit_cells = 0;
+    memcpy(&t->index_hole_pos, &header[2 + extra], 4);
+
+    size = d86f_array_size(cache->disk_flags, t->extra_bit_cells, 0);
+    if (size <= 0)
+        return 0;
+
+    t->size = size;
+    t->data = (uint8_t *) calloc(1, (cache->disk_flags & 1) ? (size << 1) : size);
+    /* Tracks cut short at the end of the file read as zeroes past that, like they did with fread(). */
+    (void) d86f_cache_pread(cache, t->data, (cache->disk_flags & 1) ? (size << 1) : size, offset + 6 + extra);
+
+    return 1;
+}
+
+/* Does one thing for the cache, and submits itself again if it did something. */
+static void
+d86f_cache_job(void *priv)
+{
+    d86f_cache_t       *cache = (d86f_cache_t *) priv;
+    d86f_cache_track_t  t;
+    uint32_t            table[512];
+    uint8_t            *buf    = NULL;
+    uint32_t            len    = 0;
+    uint32_t            offset = 0;
+    int                 op     = 0;
+    int                 i;
+
+    thread_wait_mutex(d86f_pool.mutex);
+
+    /* Pick one thing to do, copying what is to be written so the drive can go on changing it. */
+    i = -1;
+    if (cache->table_dirty) {
+        memcpy(table, cache->track_offset, cache->tracks << 2);
+        cache->table_dirty = 0;
+        op                 = 1;
+    } else {
+        for (i = 0; i < cache->tracks; i++) {
+            if (cache->track[i].dirty && cache->track_offset[i])
+                break;
+        }
+
+        if (i < cache->tracks) {
+            const d86f_cache_track_t *d     = &cache->track[i];
+            const int                 extra = (cache->disk_flags & 0x80) ? 4 : 0;
+            const uint32_t            data  = (cache->disk_flags & 1) ? (d->size << 1) : d->size;
+
+            len = 6 + extra + data;
+            buf = (uint8_t *) malloc(len);
+            buf[0] = d->side_flags & 0xff;
+            buf[1] = d->side_flags >> 8;
+            if (extra)
+                memcpy(&buf[2], &d->extra_bit_cells, 4);
+            memcpy(&buf[2 + extra], &d->index_hole_pos, 4);
+            memcpy(&buf[6 + extra], d->data, data);
+            offset                = cache->track_offset[i];
+            cache->track[i].dirty = 0;
+            op                    = 2;
+        } else if (!cache->closing) {
+            if ((cache->wanted >= 0) && !cache->track[cache->wanted].ready)
+                i = cache->wanted;
+            else {
+                while ((cache->next < cache->tracks) && cache->track[cache->next].ready)
+                    cache->next++;
+                i = cache->next;
+            }
+
+            if (i < cache->tracks) {
+                offset = cache->track_offset[i];
+                op     = 3;
+            }
+        }
+    }
+
+    thread_release_mutex(d86f_pool.mutex);
+
+    /* Nothing left to do. */
+    if (op == 0)
+        return;
+
+    memset(&t, 0, sizeof(d86f_cache_track_t));
+    if (op == 1)
+        d86f_cache_pwrite(cache, table, cache->tracks << 2, 8);
+    else if (op == 2) {
+        d86f_cache_pwrite(cache, buf, len, offset);
+        free(buf);
+    } else if (!d86f_cache_read_track(cache, offset, &t)) {
+        d86f_log("86F: Error reading track %i into the cache\n", i);
+        free(t.data);
+        memset(&t, 0, sizeof(d86f_cache_track_t));
+        t.failed = 1;
+    }
+
+    if (op == 3) {
+        thread_wait_mutex(d86f_pool.mutex);
+
+        /* Unless a write or format got to it first. */
+        if (!cache->track[i].ready) {
+            t.ready         = 1;
+            cache->track[i] = t;
+        } else
+            free(t.data);
+        if (cache->wanted == i)
+            cache->wanted = -1;
+        thread_set_event(cache->done);
+
+        thread_release_mutex(d86f_pool.mutex);
+    }
+
+    job_submit(cache->job);
+}
+
+static void
+d86f_cache_open(int drive)
+{
+    d86f_t       *dev = d86f[drive];
+    d86f_cache_t *cache;
+
+    if (d86f_pool.pool == NULL) {
+        d86f_pool.pool  = job_pool_create("86f_cache", D86F_WORKER_THREADS);
+        d86f_pool.mutex = thread_create_mutex();
+    }
+
+    cache             = (d86f_cache_t *) calloc(1, sizeof(d86f_cache_t));
+    cache->fp         = dev->fp;
+    cache->disk_flags = dev->disk_flags;
+    cache->tracks     = (dev->disk_flags & 8) ? 512 : 256;
+    cache->wanted     = -1;
+    cache->done       = thread_create_event();
+    cache->job        = job_create(d86f_pool.pool, "86F track cache", d86f_cache_job, cache);
+    memcpy(cache->track_offset, dev->track_offset, cache->tracks << 2);
+
+    /* Tracks absent from the file have nothing to read. */
+    for (int i = 0; i < cache->tracks; i++) {
+        if (!cache->track_offset[i])
+            cache->track[i].ready = 1;
+    }
+
+    dev->cache = cache;
+    job_submit(cache->job);
+}
+
+/* Writes back what is still waiting to be, and frees the cache. */
+static void
+d86f_cache_close(int drive)
+{
+    d86f_t       *dev   = d86f[drive];
+    d86f_cache_t *cache = dev->cache;
+
+    if (cache == NULL)
+        return;
+
+    /* From here on the job only writes, and stops submitting itself once it is done. */
+    thread_wait_mutex(d86f_pool.mutex);
+    cache->closing = 1;
+    thread_release_mutex(d86f_pool.mutex);
+
+    job_wait(cache->job);
+    job_close(cache->job);
+    thread_destroy_event(cache->done);
+    dev->cache = NULL;
+
+    for (int i = 0; i < cache->tracks; i++)
+        free(cache->track[i].data);
+    free(cache);
+}
+
+void
+d86f_cache_pool_close(void)
+{
+    if (d86f_pool.pool == NULL)
+        return;
+
+    job_pool_close(d86f_pool.pool);
+    thread_close_mutex(d86f_pool.mutex);
+    d86f_pool.pool  = NULL;
+    d86f_pool.mutex = NULL;
+}
+
+/* Returns the cache entry of a track, once it has been read. */
+static const d86f_cache_track_t *
+d86f_cache_get(d86f_cache_t *cache, int logical_track)
+{
+    /* Only the drive waits on the event, so resetting it under the mutex cannot lose a wake-up. */
+    thread_wait_mutex(d86f_pool.mutex);
+    while (!cache->track[logical_track].ready) {
+        cache->wanted = logical_track;
+        thread_reset_event(cache->done);
+        thread_release_mutex(d86f_pool.mutex);
+        job_submit(cache->job);
+        thread_wait_event(cache->done, -1);
+        thread_wait_mutex(d86f_pool.mutex);
+    }
+    thread_release_mutex(d86f_pool.mutex);
+
+    return &cache->track[logical_track];
+}
+
+/* Takes in a track that is to be written back. */
+static void
+d86f_cache_put(int drive, int side, int logical_track, uint32_t offset, const uint16_t *da, const uint16_t *sa)
+{
+    d86f_t             *dev   = d86f[drive];
+    d86f_cache_t       *cache = dev->cache;
+    d86f_cache_track_t *t     = &cache->track[logical_track];
+    uint32_t            size  = d86f_get_array_size(drive, side, 0);
+
+    thread_wait_mutex(d86f_pool.mutex);
+
+    if ((t->data == NULL) || (t->size != size)) {
+        free(t->data);
+        t->data = (uint8_t *) malloc(d86f_has_surface_desc(drive) ? (size << 1) : size);
+        t->size = size;
+    }
+
+    t->side_flags      = d86f_handler[drive].side_flags(drive);
+    t->extra_bit_cells = d86f_handler[drive].extra_bit_cells(drive, side);
+    t->index_hole_pos  = d86f_handler[drive].index_hole_pos(drive, side);
+    memcpy(t->data, da, size);
+    if (d86f_has_surface_desc(drive))
+        memcpy(t->data + size, sa, size);
+    t->ready  = 1;
+    t->dirty  = 1;
+    t->failed = 0;
+
+    cache->track_offset[logical_track] = offset;
+
+    thread_release_mutex(d86f_pool.mutex);
+
+    job_submit(cache->job);
+}
+
+/* Takes in the track table that is to be written back. */
+static void
+d86f_cache_put_table(int drive)
+{
+    d86f_t       *dev   = d86f[drive];
+    d86f_cache_t *cache = dev->cache;
+
+    thread_wait_mutex(d86f_pool.mutex);
+    memcpy(cache->track_offset, dev->track_offset, cache->tracks << 2);
+    cache->table_dirty = 1;
+    thread_release_mutex(d86f_pool.mutex);
+
+    job_submit(cache->job);
+}
+
 void
 d86f_read_track(int drive, int track, int thin_track, int side, uint16_t *da, uint16_t *sa)
 {
-    d86f_t *dev           = d86f[drive];
-    int     logical_track = 0;
-    int     array_size    = 0;
+    d86f_t                   *dev           = d86f[drive];
+    const d86f_cache_track_t *t;
+    int                       logical_track = 0;
+    int                       array_size    = 0;
 
     if (d86f_get_sides(drive) == 2)
         logical_track = ((track + thin_track) << 1) + side;
     else
         logical_track = track + thin_track;
 
-    if (dev->track_offset[logical_track]) {
+    t = (dev->track_offset[logical_track] && dev->cache) ? d86f_cache_get(dev->cache, logical_track) : NULL;
+    if ((t != NULL) && t->failed) {
+        /* Let the job let go of the file, and read the track from it directly. */
+        job_wait(dev->cache->job);
+        t = NULL;
+    }
+
+    if (t != NULL) {
+        if (!thin_track) {
+            dev->side_flags[side]      = t->side_flags;
+            dev->extra_bit_cells[side] = t->extra_bit_cells;
+            dev->index_hole_pos[side]  = t->index_hole_pos;
+        }
+        array_size = MIN(d86f_get_array_size(drive, side, 0), (int) t->size);
+        if (array_size > 0) {
+            memcpy(da, t->data, array_size);
+            if (d86f_has_surface_desc(drive))
+                memcpy(sa, t->data + t->size, array_size);
+        }
+    } else if (dev->track_offset[logical_track]) {
         if (!thin_track) {
             if (fseek(dev->fp, dev->track_offset[logical_track], SEEK_SET) == -1)
                 fatal("d86f_read_track(): Error seeking to offset dev->track_offset[logical_track]\n");
@@ -3130,7 +3733,9 @@ d86f_write_tracks(int drive, FILE **fp, uint32_t *track_table)
                     tbl[logical_track] = ftell(*fp);
                 }
 
-                if (tbl[logical_track]) {
+                if (tbl[logical_track] && (track_table == NULL) && dev->cache)
+                    d86f_cache_put(drive, side, logical_track, tbl[logical_track], dev->thin_track_encoded_data[thin_track][side], dev->thin_track_surface_data[thin_track][side]);
+                else if (tbl[logical_track]) {
                     fseek(*fp, tbl[logical_track], SEEK_SET);
                     d86f_write_track(drive, fp, side, dev->thin_track_encoded_data[thin_track][side], dev->thin_track_surface_data[thin_track][side]);
                 }
@@ -3149,7 +3754,9 @@ d86f_write_tracks(int drive, FILE **fp, uint32_t *track_table)
                 tbl[logical_track] = ftell(*fp);
             }
 
-            if (tbl[logical_track]) {
+            if (tbl[logical_track] && (track_table == NULL) && dev->cache)
+                d86f_cache_put(drive, side, logical_track, tbl[logical_track], d86f_handler[drive].encoded_data(drive, side), dev->track_surface_data[side]);
+            else if (tbl[logical_track]) {
                 if (fseek(*fp, tbl[logical_track], SEEK_SET) == -1)
                     fatal("d86f_write_tracks(): Error seeking to offset tbl[logical_track]\n");
                 d86f_write_track(drive, fp, side, d86f_handler[drive].encoded_data(drive, side), dev->track_surface_data[side]);
@@ -3177,6 +3784,13 @@ d86f_writeback(int drive)
     if (!dev->fp)
         return;
 
+    /* The workers write the table and the tracks from the cache. */
+    if (dev->cache) {
+        d86f_cache_put_table(drive);
+        d86f_write_tracks(drive, &dev->fp, NULL);
+        return;
+    }
+
     /* First write the track offsets table. */
     if (fseek(dev->fp, 0, SEEK_SET) == -1)
         fatal("86F write_back(): Error seeking to the beginning of the file\n");
@@ -3288,6 +3902,8 @@ d86f_readsector(int drive, int sector, int track, int side, int rate, int sector
         dev->state = STATE_02_FIND_ID;
     else
         dev->state = fdc_is_deleted(d86f_fdc) ? STATE_0C_FIND_ID : (fdc_is_verify(d86f_fdc) ? STATE_16_FIND_ID : STATE_06_FIND_ID);
+
+    d86f_timed_start(drive);
 }
 
 void
@@ -3314,6 +3930,8 @@ d86f_writesector(int drive, int sector, int track, int side, int rate, int secto
             dev->track_pos = 0;
     } else
         dev->state = fdc_is_deleted(d86f_fdc) ? STATE_09_FIND_ID : STATE_05_FIND_ID;
+
+    d86f_timed_start(drive);
 }
 
 void
@@ -3333,6 +3951,8 @@ d86f_comparesector(int drive, int sector, int track, int side, int rate, int sec
             dev->track_pos = 0;
     } else
         dev->state = STATE_11_FIND_ID;
+
+    d86f_timed_start(drive);
 }
 
 void
@@ -3360,6 +3980,8 @@ d86f_readaddress(int drive, UNUSED(int side), UNUSED(int rate))
             dev->track_pos = 0;
     } else
         dev->state = STATE_0A_FIND_ID;
+
+    d86f_timed_start(drive);
 }
 
 void
@@ -3468,6 +4090,8 @@ d86f_common_format(int drive, int side, UNUSED(int rate), uint8_t fill, int prox
             dev->track_pos = 0;
     } else
         dev->state = STATE_0D_SPIN_TO_INDEX;
+
+    d86f_timed_start(drive);
 }
 
 void
@@ -3869,6 +4493,12 @@ d86f_load(int drive, char *fn)
 
     d86f_register_86f(drive);
 
+#ifdef D86F_COMPRESS
+    /* Compressed images are recompressed as a whole on writeback, so they do without the cache. */
+    if (!dev->is_compressed)
+#endif
+        d86f_cache_open(drive);
+
     drives[drive].seek = d86f_seek;
     d86f_common_handlers(drive);
     drives[drive].format = d86f_format;
@@ -3908,6 +4538,9 @@ d86f_close(int drive)
 
     memcpy(temp_file_name, drive ? nvr_path("TEMP$$$1.$$$") : nvr_path("TEMP$$$0.$$$"), 26);
 
+    /* Before the file goes away, let the workers write back what they still have. */
+    d86f_cache_close(drive);
+
     if (d86f_has_surface_desc(drive)) {
         for (uint8_t i = 0; i < 2; i++) {
             if (dev->track_surface_data[i]) {
@@ -52,6 +52,14 @@
 
 #define CD_IMAGE_HISTORY         10
 
+/* Sectors read from an image file at a time. */
+#define CD_READ_AHEAD_DEFAULT    32
+#define CD_READ_AHEAD_MAX        256
+
+/* Host files a virtual ISO keeps open at a time. */
+#define CD_VISO_OPEN_FILES_DEFAULT 128
+#define CD_VISO_OPEN_FILES_MAX     1024
+
 #define CDROM_IMAGE              200
 
 /* This is so that if/when this is changed to something else,
@@ -70,8 +78,6 @@
 
 #define CD_FPS                   75
 
-#define _LUT_SIZE                0x100
-
 #define FRAMES_TO_MSF(f, M, S, F)                 \
     {                                             \
         uint64_t value = f;                       \
@@ -379,9 +385,8 @@ typedef struct cdrom {
     uint8_t            mode2;
 
     int                no_check;
-
-    uint8_t            _F_LUT[_LUT_SIZE];
-    uint8_t            _B_LUT[_LUT_SIZE];
+    int                read_ahead;   /* Sectors, or 0 to read one at a time. */
+    int                viso_open_files;
 
     uint8_t            p_parity[172];
     uint8_t            q_parity[104];
@@ -486,11 +491,6 @@ extern int             cdrom_is_paused(const uint8_t id);
 extern void            cdrom_eject(const uint8_t id);
 extern void            cdrom_reload(const uint8_t id);
 
-extern void            cdrom_compute_ecc_block(cdrom_t *dev, uint8_t *parity, const uint8_t *data,
-                                               uint32_t major_count, uint32_t minor_count,
-                                               uint32_t major_mult, uint32_t minor_inc, int m2f1);
-extern unsigned long   cdrom_crc32(unsigned long crc, const unsigned char *buf,
-                                   size_t len);
 
 extern int             cdrom_assigned_letters;
 
@@ -0,0 +1,46 @@
+/*
+ * 86Box    A hypervisor and IBM PC system emulator that specializes in
+ *          running old operating systems and software designed for IBM
+ *          PC systems and compatibles from 1981 through fairly recent
+ *          system designs based on the PCI bus.
+ *
+ *          This file is part of the 86Box distribution.
+ *
+ *          EDC and Reed-Solomon P/Q parity of Mode 1 and Mode 2 Form 1
+ *          CD-ROM sectors.
+ *
+ *          The data pointer of the parity functions points at the sector
+ *          header, 12 bytes into the raw sector; P covers the 2064 bytes
+ *          from there up to the P parity, and Q the 2236 bytes up to the
+ *          Q parity, so P must be in place before Q is computed. m2f1
+ *          treats the header as zeroes, as Mode 2 Form 1 requires.
+ *
+ * Authors: 86Box contributors.
+ *
+ *          Copyright 2026 86Box contributors.
+ */
+#ifndef EMU_CDROM_ECC_H
+#define EMU_CDROM_ECC_H
+
+#define CDROM_ECC_P_SIZE 172
+#define CDROM_ECC_Q_SIZE 104
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Builds the tables; called by cdrom_hard_reset(), and by the functions below if it has not been. */
+extern void cdrom_ecc_init(void);
+
+extern uint32_t cdrom_edc(const uint8_t *buf, size_t len);
+extern void     cdrom_ecc_compute_p(const uint8_t *data, uint8_t *parity, int m2f1);
+extern void     cdrom_ecc_compute_q(const uint8_t *data, uint8_t *parity, int m2f1);
+
+/* The EDC polynomial in the braided zlib CRC of utils/crc32.c, inverted on the way in and out. */
+extern unsigned long cdrom_crc32(unsigned long crc, const unsigned char *buf, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /*EMU_CDROM_ECC_H*/
@@ -0,0 +1,61 @@
+/*
+ * 86Box    A hypervisor and IBM PC system emulator that specializes in
+ *          running old operating systems and software designed for IBM
+ *          PC systems and compatibles from 1981 through fairly recent
+ *          system designs based on the PCI bus.
+ *
+ *          This file is part of the 86Box distribution.
+ *
+ *          Compressed hunks of MAME CHD (version 5) CD-ROM and DVD
+ *          images back-end header.
+ *
+ *          A CHD is opened once and each of its tracks is handed to the
+ *          image code as its own track file, which sees the sectors of
+ *          the track back to back as in a BIN file of that track.
+ *
+ * Authors: 86Box contributors.
+ *
+ *          Copyright 2026 86Box contributors.
+ */
+#ifndef CDROM_IMAGE_CHD_H
+#define CDROM_IMAGE_CHD_H
+
+#define CHD_MAX_TRACKS 99
+
+/* Reasons chd_open() can fail for. */
+enum {
+    CHD_ERROR_NONE = 0,
+    CHD_ERROR_FILE,      /* Cannot be opened or read. */
+    CHD_ERROR_FORMAT,    /* Not a version 5 CD-ROM or DVD CHD, or damaged. */
+    CHD_ERROR_CODEC,     /* Every hunk uses a codec that we were built without. */
+    CHD_ERROR_PARENT     /* Differencing CHD that needs its parent. */
+};
+
+typedef struct chd_t chd_t;
+
+typedef struct chd_track_t {
+    int      number;
+    int      audio;
+    int      mode;
+    int      form;
+    int      sector_size;     /* Data bytes per sector, without the subcode. */
+    int      skip;
+    int      subcode;         /* Raw P-W subcode stored after each sector. */
+    uint32_t frames;          /* Including a pre-gap stored in the image. */
+    uint32_t pregap;
+    int      pregap_in_image;
+    uint32_t postgap;
+    uint64_t first_frame;     /* Frame of the CHD the track starts at. */
+} chd_track_t;
+
+extern chd_t        *chd_open(const char *fn, int read_ahead, void *log, int *error);
+extern void          chd_close(chd_t *chd);
+extern int           chd_is_dvd(const chd_t *chd);
+extern int           chd_get_tracks(const chd_t *chd, const chd_track_t **tracks);
+extern int           chd_read(chd_t *chd, uint8_t *buffer, uint64_t offset, size_t count);
+extern uint64_t      chd_get_length(const chd_t *chd);
+
+/* Track files, which hold a reference to the CHD until they are closed. */
+extern track_file_t *chd_track_init(chd_t *chd, int track, const uint8_t id);
+
+#endif /*CDROM_IMAGE_CHD_H*/
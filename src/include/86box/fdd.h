@@ -57,6 +57,8 @@ extern void fdd_set_head(int drive, int head);
 extern int  fdd_get_head(int drive);
 extern void fdd_set_turbo(int drive, int turbo);
 extern int  fdd_get_turbo(int drive);
+extern void fdd_set_sector_timing(int drive, int sector_timing);
+extern int  fdd_get_sector_timing(int drive);
 extern void fdd_set_check_bpb(int drive, int check_bpb);
 extern int  fdd_get_check_bpb(int drive);
 
@@ -51,6 +51,8 @@ extern d86f_handler_t d86f_handler[FDD_NUM];
 extern void     d86f_init(void);
 extern void     d86f_load(int drive, char *fn);
 extern void     d86f_close(int drive);
+/* Joins the threads of the track caches; every image must have been closed. */
+extern void     d86f_cache_pool_close(void);
 extern void     d86f_seek(int drive, int track);
 extern int      d86f_hole(int drive);
 extern uint64_t d86f_byteperiod(int drive);
@@ -107,6 +107,9 @@ typedef struct ide_s {
     uint16_t *buffer;
     uint8_t  *sector_buffer;
 
+    /* Read started when a read command was written, into sector_buffer. */
+    struct hdd_image_req_t *aio_req;
+
     pc_timer_t timer;
 
     /* Task file. */
@@ -83,6 +83,23 @@ enum {
     HDD_OP_WRITE = 3
 };
 
+/*
+ * How soon writes to a raw, HDI or HDX image reach the host disk. The other
+ * settings act as HDD_FLUSH_NONE where the host lacks the call they need:
+ * HDD_FLUSH_ASYNC needs sync_file_range() and so Linux, HDD_FLUSH_SYNC
+ * needs fsync() and so a Unix host.
+ */
+enum {
+    HDD_FLUSH_NONE  = 0, /* Leave writing back to the host. */
+    HDD_FLUSH_ASYNC = 1, /* Start writing back after every write. */
+    HDD_FLUSH_SYNC  = 2  /* Finish writing back before every write completes. */
+};
+
+/* Returned by hdd_image_req_poll() while the request is still in progress. */
+#define HDD_IMAGE_REQ_PENDING 1
+
+typedef struct hdd_image_req_t hdd_image_req_t;
+
 #define HDD_MAX_ZONES     16
 #define HDD_MAX_CACHE_SEG 16
 
@@ -157,7 +174,8 @@ typedef struct hard_disk_t {
     uint8_t            wp;           /* Disk has been mounted
                                         READ-ONLY */
     uint8_t            pad;
-    uint8_t            pad0;
+    uint8_t            flush;        /* HDD_FLUSH_*, how soon writes to a
+                                        raw, HDI or HDX image reach the host disk. */
 
     void              *priv;
 
@@ -221,6 +239,16 @@ extern uint32_t hdd_image_get_pos(uint8_t id);
 extern uint8_t  hdd_image_get_type(uint8_t id);
 extern void     hdd_image_unload(uint8_t id, int fn_preserve);
 extern void     hdd_image_close(uint8_t id);
+/* Asynchronous HDD_OP_READ or HDD_OP_WRITE; the request is freed once hdd_image_req_poll() or _wait() returns its result. */
+extern hdd_image_req_t *hdd_image_submit(uint8_t id, int op, uint32_t sector, uint32_t count, uint8_t *buffer);
+extern int              hdd_image_req_poll(hdd_image_req_t *req);
+extern int              hdd_image_req_wait(hdd_image_req_t *req);
+/* Carries out the requests still queued and joins the threads that carry them out. */
+extern void             hdd_image_aio_close(void);
+
+/* Sectors of a memory-mapped image, for a controller to read directly, or NULL if they are not mapped. */
+extern uint8_t *hdd_image_get_map(uint8_t id, uint32_t sector, uint32_t count);
+
 extern void     hdd_image_calc_chs(uint32_t *c, uint32_t *h, uint32_t *s, uint32_t size);
 
 extern int image_is_hdi(const char *s);
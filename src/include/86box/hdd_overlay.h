@@ -0,0 +1,80 @@
+/*
+ * 86Box    A hypervisor and IBM PC system emulator that specializes in
+ *          running old operating systems and software designed for IBM
+ *          PC systems and compatibles from 1981 through fairly recent
+ *          system designs based on the PCI bus.
+ *
+ *          This file is part of the 86Box distribution.
+ *
+ *          Copy-on-write overlay hard disk images.
+ *
+ *          An overlay holds only the blocks written to it; every other
+ *          block is read from its backing file, which is a raw, HDI or
+ *          HDX image or another overlay, so that many machines can be
+ *          cloned from one base image and snapshots can be stacked.
+ *
+ * Authors: 86Box contributors.
+ *
+ *          Copyright 2026 86Box contributors.
+ */
+#ifndef EMU_HDD_OVERLAY_H
+#define EMU_HDD_OVERLAY_H
+
+#define HDD_OVERLAY_BLOCK_SECTORS 128 /* 64 kB, the default for new overlays. */
+
+typedef struct hdd_overlay_t        hdd_overlay_t;
+typedef struct hdd_overlay_writer_t hdd_overlay_writer_t;
+
+typedef struct hdd_overlay_info_t {
+    const char *path;
+    uint64_t    sectors;
+    uint32_t    block_sectors; /* 0 for a backing file that is not an overlay. */
+    uint32_t    blocks;
+    uint32_t    allocated;     /* Blocks held by this overlay. */
+    uint32_t    tracks;        /* Geometry, or 0 if not known. */
+    uint32_t    hpc;
+    uint32_t    spt;
+} hdd_overlay_info_t;
+
+typedef struct hdd_overlay_cache_stats_t {
+    uint64_t hits;
+    uint64_t misses;
+    uint32_t blocks; /* Blocks held in the cache. */
+} hdd_overlay_cache_stats_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern int hdd_overlay_is_overlay(const char *fn);
+/* The backing file name is relative to the directory of the overlay; a sectors of 0 takes the size of the backing file. */
+extern int hdd_overlay_create(const char *fn, const char *backing, uint64_t sectors, uint32_t block_sectors);
+
+extern hdd_overlay_t *hdd_overlay_open(const char *fn, int read_only);
+extern void           hdd_overlay_close(hdd_overlay_t *ovl);
+extern int            hdd_overlay_read(hdd_overlay_t *ovl, uint64_t sector, uint32_t count, uint8_t *buffer);
+extern int            hdd_overlay_write(hdd_overlay_t *ovl, uint64_t sector, uint32_t count, const uint8_t *buffer);
+extern int            hdd_overlay_zero(hdd_overlay_t *ovl, uint64_t sector, uint32_t count);
+extern void           hdd_overlay_get_info(hdd_overlay_t *ovl, hdd_overlay_info_t *info);
+extern hdd_overlay_t *hdd_overlay_get_backing(hdd_overlay_t *ovl);
+
+/*
+ * A disk image opened for writing other than through an overlay claims its
+ * file, so that it is not read as a shared backing file at the same time.
+ * Returns NULL if the file is the backing file of an open overlay.
+ */
+extern hdd_overlay_writer_t *hdd_overlay_claim_write(const char *fn);
+extern void                  hdd_overlay_release_write(hdd_overlay_writer_t *writer);
+
+/* Writes the blocks of the overlay into its backing file and empties the overlay. */
+extern int hdd_overlay_commit(const char *fn);
+/* Writes the whole disk as seen through the overlay to a new raw image. */
+extern int hdd_overlay_flatten(const char *fn, const char *dest);
+
+extern void hdd_overlay_get_cache_stats(hdd_overlay_cache_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /*EMU_HDD_OVERLAY_H*/
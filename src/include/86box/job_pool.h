@@ -0,0 +1,59 @@
+/*
+ * 86Box    A hypervisor and IBM PC system emulator that specializes in
+ *          running old operating systems and software designed for IBM
+ *          PC systems and compatibles from 1981 through fairly recent
+ *          system designs based on the PCI bus.
+ *
+ *          This file is part of the 86Box distribution.
+ *
+ *          Pools of worker threads running jobs header.
+ *
+ *          A job is a function that its owner wants run whenever it is
+ *          submitted, such as rendering the next block of CD audio or
+ *          carrying out the queued requests of a disk image. Jobs are
+ *          run by a fixed pool of threads; a job never runs on two
+ *          threads at once, and a job submitted again before it has
+ *          started runs only once. A job submitted while it runs, even
+ *          by itself, runs again after it returns.
+ *
+ * Authors: 86Box contributors.
+ *
+ *          Copyright 2026 86Box contributors.
+ */
+#ifndef EMU_JOB_POOL_H
+#define EMU_JOB_POOL_H
+
+typedef struct job_pool_t job_pool_t;
+typedef struct job_t      job_t;
+
+typedef struct job_stats_t {
+    uint64_t runs;
+    uint64_t coalesced;   /* Submissions folded into one still waiting to run. */
+    uint64_t run_ns_last; /* Time taken by the last run. */
+    uint64_t run_ns_max;
+    uint64_t run_ns_avg;
+    uint64_t wait_ns_max; /* Time from submission to the start of the run. */
+    uint64_t wait_ns_avg;
+} job_stats_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern job_pool_t *job_pool_create(const char *name, int threads);
+/* Joins the threads and frees the pool; its jobs must have been closed. */
+extern void job_pool_close(job_pool_t *pool);
+
+extern job_t *job_create(job_pool_t *pool, const char *name, void (*func)(void *priv), void *priv);
+/* Cancels the job if it is waiting, and waits for it to finish if it is running. */
+extern void job_close(job_t *job);
+extern void job_submit(job_t *job);
+/* Waits until the job is neither waiting nor running, so also for the runs it submits itself. */
+extern void job_wait(job_t *job);
+extern void job_get_stats(job_t *job, job_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /*EMU_JOB_POOL_H*/
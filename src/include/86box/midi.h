@@ -31,7 +31,7 @@ extern void        midi_in_device_init(void);
 typedef struct midi_device_t {
     void (*play_sysex)(uint8_t *sysex, unsigned int len);
     void (*play_msg)(uint8_t *msg);
-    void (*poll)(void);
+    void (*poll)(void); /* Called every 10 ms of emulated time. */
     void (*reset)(void);
     int (*write)(uint8_t val);
 } midi_device_t;
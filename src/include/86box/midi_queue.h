@@ -0,0 +1,66 @@
+/*
+ * 86Box    A hypervisor and IBM PC system emulator that specializes in
+ *          running old operating systems and software designed for IBM
+ *          PC systems and compatibles from 1981 through fairly recent
+ *          system designs based on the PCI bus.
+ *
+ *          This file is part of the 86Box distribution.
+ *
+ *          Timestamped MIDI event queue for the software synthesizers.
+ *
+ *          The emulation thread stamps every message with the emulated
+ *          time at which it was sent, in frames at the synthesizer rate,
+ *          and the render thread of the synthesizer applies it at exactly
+ *          that frame of its output instead of at the start of the next
+ *          10 ms block.
+ *
+ * Authors: 86Box contributors.
+ *
+ *          Copyright 2026 86Box contributors.
+ */
+#ifndef EMU_MIDI_QUEUE_H
+#define EMU_MIDI_QUEUE_H
+
+typedef struct midi_queue_t midi_queue_t;
+
+typedef struct midi_queue_ops_t {
+    /* Renders the next frames frames of output. */
+    void (*render)(void *priv, int frames);
+    void (*play_msg)(void *priv, uint8_t *msg);
+    void (*play_sysex)(void *priv, uint8_t *sysex, unsigned int len);
+} midi_queue_ops_t;
+
+typedef struct midi_queue_stats_t {
+    uint32_t depth;          /* Events waiting to be played. */
+    uint32_t depth_max;
+    uint32_t dropped;        /* Events lost to a full queue. */
+    uint32_t backlog_max;    /* Most 10 ms periods owed to the render thread at once. */
+    uint64_t periods;        /* 10 ms periods rendered. */
+    uint64_t skipped;        /* Periods given up on after the render thread fell too far behind. */
+    uint64_t render_ns_last; /* Time taken to render the last period. */
+    uint64_t render_ns_max;
+    uint64_t render_ns_avg;
+} midi_queue_stats_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern midi_queue_t *midi_queue_create(int rate);
+extern void          midi_queue_close(midi_queue_t *q);
+
+/* Emulation side: queue an event at the current emulated time, and end a 10 ms period. */
+extern void midi_queue_msg(midi_queue_t *q, const uint8_t *msg);
+extern void midi_queue_sysex(midi_queue_t *q, const uint8_t *sysex, unsigned int len);
+extern void midi_queue_period(midi_queue_t *q);
+
+/* Render side: renders every period ended so far, playing each event at its frame. */
+extern void midi_queue_render(midi_queue_t *q, const midi_queue_ops_t *ops, void *priv);
+
+extern void midi_queue_get_stats(midi_queue_t *q, midi_queue_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /*EMU_MIDI_QUEUE_H*/
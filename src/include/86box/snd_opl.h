@@ -49,13 +49,15 @@ enum fm_type {
     FM_MAX       = 26
 };
 
-#define FM_TYPE_MASK 255
-#define FM_FORCE_48K 256
+#define FM_TYPE_MASK  255
+#define FM_FORCE_48K  256
+#define FM_NUKED_SIMD 512 /* Nuked OPL3 with the vectorized core. */
 
 enum fm_driver {
-    FM_DRV_NUKED = 0,
-    FM_DRV_YMFM  = 1,
-    FM_DRV_MAX   = 2
+    FM_DRV_NUKED      = 0,
+    FM_DRV_YMFM       = 1,
+    FM_DRV_NUKED_SIMD = 2,
+    FM_DRV_MAX        = 3
 };
 
 typedef struct fm_drv_t {
@@ -80,6 +82,8 @@ extern const fm_drv_t ymfm_opl2board_drv;
 #ifdef EMU_DEVICE_H
 extern const device_t ym3812_nuked_device;
 extern const device_t ymf262_nuked_device;
+extern const device_t ym3812_nuked_simd_device;
+extern const device_t ymf262_nuked_simd_device;
 
 extern const device_t ym2149_ymfm_device;
 
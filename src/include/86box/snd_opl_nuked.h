@@ -93,6 +93,47 @@ struct _opl3_channel {
     uint8_t       ch_num;
 };
 
+/*
+   State of the vectorized core (OPL3_LanesInit). Slot n of the chip is
+   lane n of every array; the registers are gathered from the slots and
+   channels after each register write, and the per-sample state lives only
+   here while the core is in use.
+ */
+#define OPL_LANES     40 /* 36 slots, padded to whole vectors */
+#define OPL_LANE_ZERO 72 /* Index of the constant zero in sig[] */
+
+typedef struct _opl3_lanes {
+    /* Gathered registers. */
+    uint16_t eg_base[OPL_LANES]; /* total level plus key scale level */
+    uint16_t trem[OPL_LANES];    /* 0xffff if tremolo is on */
+    uint16_t key[OPL_LANES];     /* 0xffff if keyed on */
+    uint16_t ar[OPL_LANES];
+    uint16_t dr[OPL_LANES];
+    uint16_t sr[OPL_LANES]; /* release rate, or 0 for a sustained envelope */
+    uint16_t rr[OPL_LANES];
+    uint16_t ks[OPL_LANES];
+    uint16_t sl[OPL_LANES];
+    uint32_t pg_inc[OPL_LANES]; /* phase increment at the current vibrato position */
+    uint8_t  wf[36];
+    uint8_t  fb[36];
+    uint8_t  mod[36];       /* modulation input, as an index into sig[] */
+    uint8_t  ch_out[18][4]; /* channel outputs, as indices into sig[] */
+
+    /* Slot state. */
+    uint16_t eg_rout[OPL_LANES];
+    uint16_t eg_gen[OPL_LANES];
+    uint16_t eg_out[OPL_LANES];
+    uint16_t pg_reset[OPL_LANES];
+    uint32_t pg_phase[OPL_LANES];
+    uint16_t pg_phase_out[OPL_LANES];
+    int16_t  prout[36];
+    int16_t  sig[OPL_LANE_ZERO + 1]; /* slot outputs, then feedback inputs, then zero */
+
+    uint8_t on;
+    uint8_t dirty;
+    uint8_t vibpos;
+} opl3_lanes;
+
 typedef struct _opl3_writebuf {
     uint64_t time;
     uint16_t reg;
@@ -141,14 +182,39 @@ struct _opl3_chip {
     uint32_t writebuf_last;
     uint64_t writebuf_lasttime;
     opl3_writebuf writebuf[OPL_WRITEBUF_SIZE];
+
+    opl3_lanes lanes;
 };
 
+#define NUKED_QUEUE_SIZE  1024 /* Must be a power of two. */
+#define NUKED_QUEUE_BATCH 32   /* Register writes queued before the synthesis job is submitted. */
+
+enum {
+    NUKED_CMD_RENDER = 0,
+    NUKED_CMD_WRITE,
+    NUKED_CMD_RESET
+};
+
+/* Work for the synthesis job; pos is the sample the emulation was at when it was queued. */
+typedef struct nuked_cmd_t {
+    int      pos;
+    uint16_t reg;
+    uint8_t  val;
+    uint8_t  type;
+} nuked_cmd_t;
+
 typedef struct {
+    /* Owned by the synthesis job. */
     opl3_chip opl;
+    int       pos;
+    int32_t   buffer[MUSICBUFLEN * 2];
+
+    /* Owned by the emulation thread. */
     int8_t    flags;
     int8_t    is_48k;
 
     uint16_t port;
+    uint8_t  newm;
     uint8_t  status;
     uint8_t  timer_ctrl;
     uint16_t timer_count[2];
@@ -156,10 +222,14 @@ typedef struct {
 
     pc_timer_t timers[2];
 
-    int     pos;
-    int32_t buffer[MUSICBUFLEN * 2];
+    int (*get_pos)(void);
+    int   queued_pos;
 
-    int32_t *(*update)(void *priv);
+    nuked_cmd_t    queue[NUKED_QUEUE_SIZE];
+    atomic_uint    queue_wr;
+    atomic_uint    queue_rd;
+    struct job_t  *job; /* On the sound workers, see sound_worker.h. */
+    event_t       *done_event;
 } nuked_drv_t;
 
 enum {
@@ -189,6 +259,8 @@ void OPL3_Reset(opl3_chip *chip, uint32_t samplerate);
 void OPL3_WriteReg(void *priv, uint16_t reg, uint8_t val);
 void OPL3_WriteRegBuffered(void *priv, uint16_t reg, uint8_t val);
 void OPL3_GenerateStream(opl3_chip *chip, int32_t *sndptr, uint32_t numsamples);
+/* Switches a freshly reset chip to the vectorized core, which gives bit-identical output. */
+void OPL3_LanesInit(opl3_chip *chip);
 
 static void OPL3_Generate4Ch(void *priv, int32_t *buf4);
 void OPL3_Generate4Ch_Resampled(opl3_chip *chip, int32_t *buf4);
@@ -4,11 +4,13 @@
 #ifdef __cplusplus
 extern "C" {
 #endif
-void   *sid_init(uint8_t type, double range);
+/* sampling: 0 for fast decimation, 1 for band-limited resampling. */
+void   *sid_init(uint8_t type, double range, int sampling);
 void    sid_close(void *priv);
 void    sid_reset(void *priv);
 uint8_t sid_read(uint16_t addr, void *priv);
 void    sid_write(uint16_t addr, uint8_t val, void *priv);
+/* Renders exactly len samples at 48 kHz. */
 void    sid_fillbuf(int16_t *buf, int len, void *priv);
 #ifdef __cplusplus
 }
@@ -2,6 +2,7 @@
 #define SOUND_SND_SB_DSP_H
 
 #include <86box/fifo.h>
+#include <86box/sound_mix.h>
 
 /*Sound Blaster Clones, for quirks*/
 #define SB_SUBTYPE_DEFAULT             0 /* Handle as a Creative card */
@@ -153,6 +154,8 @@ typedef struct sb_dsp_t {
     int16_t buffer[SOUNDBUFLEN * 2];
     int     pos;
 
+    sound_biquad_t dac_filter; /* 3.2 kHz output low-pass of the 8-bit SBs */
+
     uint8_t azt_eeprom[AZTECH_EEPROM_SIZE]; /* the eeprom in the Aztech cards is attached to the DSP */
 
     uint8_t  ess_regs[256]; /* ESS registers. */
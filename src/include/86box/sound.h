@@ -41,6 +41,15 @@ extern int sound_gain;
 #define WT_FREQ     FREQ_44100
 #define WTBUFLEN    (MUSIC_FREQ / 45)
 
+/*
+   Rate of the single mixed stream handed to the audio backend; every
+   stream above is converted to it. The output block is 20 ms, as for the
+   sound stream.
+ */
+extern int sound_output_freq;
+
+#define SOUND_OUTPUT_BUFLEN (sound_output_freq / 50)
+
 enum {
     SOUND_NONE = 0,
     SOUND_INTERNAL
@@ -51,10 +60,12 @@ extern int gated;
 extern int speakval;
 extern int speakon;
 
-extern int sound_pos_global;
-
-extern int music_pos_global;
-extern int wavetable_pos_global;
+/* Position of the emulated time within the current output buffer, in samples. */
+extern int sound_get_pos(void);
+extern int music_get_pos(void);
+extern int wavetable_get_pos(void);
+/* Position of the emulated time within the current 10 ms MIDI poll period, in samples. */
+extern int sound_get_poll_pos(void);
 
 extern int sound_card_current[SOUND_CARD_MAX];
 
@@ -70,6 +81,14 @@ extern void wavetable_add_handler(void (*get_buffer)(int32_t *buffer,
                                                      int len, void *priv),
                                   void *priv);
 
+/*
+   Ring source of the sound stream: samples written to the returned ring
+   from any one thread are added to the stream by the mixer thread, a
+   block at a time. A source with its own render thread, such as the SID,
+   uses it instead of doing its work in a get_buffer handler.
+ */
+extern struct sound_ring_t *sound_add_ring(void);
+
 extern void sound_set_cd_audio_filter(void (*filter)(int     channel,
                                                      double *buffer, void *priv),
                                       void *priv);
@@ -97,6 +116,8 @@ extern void sound_reset(void);
 
 extern void sound_card_reset(void);
 
+extern void sound_mix_thread_end(void);
+
 extern void sound_cd_thread_end(void);
 extern void sound_cd_thread_reset(void);
 
@@ -106,9 +127,6 @@ extern void sound_fdd_thread_end(void);
 extern void closeal(void);
 extern void inital(void);
 extern void givealbuffer(const void *buf);
-extern void givealbuffer_music(const void *buf);
-extern void givealbuffer_wt(const void *buf);
-extern void givealbuffer_cd(const void *buf);
 extern void givealbuffer_fdd(const void *buf, const uint32_t size);
 
 #define sb_vibra16c_onboard_relocate_base sb_vibra16s_onboard_relocate_base
@@ -0,0 +1,53 @@
+/*
+ * 86Box    A hypervisor and IBM PC system emulator that specializes in
+ *          running old operating systems and software designed for IBM
+ *          PC systems and compatibles from 1981 through fairly recent
+ *          system designs based on the PCI bus.
+ *
+ *          This file is part of the 86Box distribution.
+ *
+ *          Block kernels for the sound output path.
+ *
+ *          The conversions give the same results as the per-sample loops
+ *          they replace. Buffers are interleaved stereo; n counts
+ *          samples and frames counts stereo pairs.
+ *
+ * Authors: 86Box contributors.
+ *
+ *          Copyright 2026 86Box contributors.
+ */
+#ifndef EMU_SOUND_MIX_H
+#define EMU_SOUND_MIX_H
+
+/*
+   Second-order IIR section in transposed direct form II, with the two
+   channels of a stereo stream running side by side. a0 is normalised to 1.
+ */
+typedef struct sound_biquad_t {
+    float b0, b1, b2;
+    float a1, a2;
+    float z1[2];
+    float z2[2];
+} sound_biquad_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* dst[i] = src[i] / 32768.0f. */
+extern void sound_mix_to_float(float *dst, const int32_t *src, int n);
+/* dst[i] = src[i] saturated to 16 bits. */
+extern void sound_mix_to_int16(int16_t *dst, const int32_t *src, int n);
+/* dst[i] = src[i]. */
+extern void sound_mix_s16_to_float(float *dst, const int16_t *src, int n);
+
+/* Takes the coefficients in the b (feed-forward) / a (feedback) layout of filters.h. */
+extern void sound_biquad_init(sound_biquad_t *bq, const double b[3], const double a[3]);
+extern void sound_biquad_reset(sound_biquad_t *bq);
+extern void sound_biquad_stereo(sound_biquad_t *bq, float *buf, int frames);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /*EMU_SOUND_MIX_H*/
@@ -0,0 +1,42 @@
+/*
+ * 86Box    A hypervisor and IBM PC system emulator that specializes in
+ *          running old operating systems and software designed for IBM
+ *          PC systems and compatibles from 1981 through fairly recent
+ *          system designs based on the PCI bus.
+ *
+ *          This file is part of the 86Box distribution.
+ *
+ *          Polyphase sample rate converter for the sound output path.
+ *
+ *          Converts an interleaved stereo stream from one fixed rate to
+ *          another. Input may be fed in blocks of any length; whatever
+ *          output the block completes is returned at once, and the rest
+ *          of the filter history is kept for the next call.
+ *
+ * Authors: 86Box contributors.
+ *
+ *          Copyright 2026 86Box contributors.
+ */
+#ifndef EMU_SOUND_RESAMPLE_H
+#define EMU_SOUND_RESAMPLE_H
+
+typedef struct sound_resampler_t sound_resampler_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern sound_resampler_t *sound_resampler_create(int in_rate, int out_rate);
+extern void               sound_resampler_close(sound_resampler_t *rs);
+extern void               sound_resampler_reset(sound_resampler_t *rs);
+
+/* Most output frames that frames input frames can complete. */
+extern int sound_resampler_out_max(const sound_resampler_t *rs, int frames);
+/* Consumes frames input frames and returns the number of frames written to out. */
+extern int sound_resampler_process(sound_resampler_t *rs, const int32_t *in, int frames, int32_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /*EMU_SOUND_RESAMPLE_H*/
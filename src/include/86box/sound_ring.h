@@ -0,0 +1,50 @@
+/*
+ * 86Box    A hypervisor and IBM PC system emulator that specializes in
+ *          running old operating systems and software designed for IBM
+ *          PC systems and compatibles from 1981 through fairly recent
+ *          system designs based on the PCI bus.
+ *
+ *          This file is part of the 86Box distribution.
+ *
+ *          Single-producer/single-consumer sample rings.
+ *
+ *          One thread writes and one other thread reads; neither ever
+ *          blocks or takes a lock. Transfers are all-or-nothing, so a
+ *          stereo frame is never split.
+ *
+ * Authors: 86Box contributors.
+ *
+ *          Copyright 2026 86Box contributors.
+ */
+#ifndef EMU_SOUND_RING_H
+#define EMU_SOUND_RING_H
+
+typedef struct sound_ring_t sound_ring_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Creates a ring holding at least len samples. */
+extern sound_ring_t *sound_ring_create(uint32_t len);
+extern void          sound_ring_close(sound_ring_t *ring);
+/* Discards everything in the ring; neither side may be using it. */
+extern void sound_ring_flush(sound_ring_t *ring);
+
+/* Samples that can be written (producer side). */
+extern uint32_t sound_ring_space(sound_ring_t *ring);
+/* Samples that can be read (consumer side). */
+extern uint32_t sound_ring_fill(sound_ring_t *ring);
+
+/* Appends len samples, or nothing if there is not enough room; returns 1 on success. */
+extern int sound_ring_write(sound_ring_t *ring, const int32_t *buf, uint32_t len);
+/* Removes len samples, or nothing if there are not enough; returns 1 on success. */
+extern int sound_ring_read(sound_ring_t *ring, int32_t *buf, uint32_t len);
+/* Removes up to len samples and adds them to buf; returns the number removed. */
+extern uint32_t sound_ring_mix(sound_ring_t *ring, int32_t *buf, uint32_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /*EMU_SOUND_RING_H*/
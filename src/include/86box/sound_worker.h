@@ -0,0 +1,46 @@
+/*
+ * 86Box    A hypervisor and IBM PC system emulator that specializes in
+ *          running old operating systems and software designed for IBM
+ *          PC systems and compatibles from 1981 through fairly recent
+ *          system designs based on the PCI bus.
+ *
+ *          Shared worker threads for the audio feeders.
+ *
+ *          A job is a function that a feeder wants run whenever it is
+ *          submitted, such as rendering the next block of CD audio or of
+ *          a software synthesizer; see job_pool.h for how jobs are run.
+ *
+ * Authors: 86Box contributors.
+ *
+ *          Copyright 2026 86Box contributors.
+ */
+#ifndef EMU_SOUND_WORKER_H
+#define EMU_SOUND_WORKER_H
+
+#include <86box/job_pool.h>
+
+typedef job_t       sound_job_t;
+typedef job_stats_t sound_job_stats_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern sound_job_t *sound_job_create(const char *name, void (*func)(void *priv), void *priv);
+/* Runs on a worker of its own, never queued behind the feeders. */
+extern sound_job_t *sound_mixer_job_create(const char *name, void (*func)(void *priv), void *priv);
+/* Cancels the job if it is waiting, and waits for it to finish if it is running. */
+extern void sound_job_close(sound_job_t *job);
+extern void sound_job_submit(sound_job_t *job);
+/* Waits until the job has finished its runs; does nothing for a NULL job. */
+extern void sound_job_wait(sound_job_t *job);
+extern void sound_job_get_stats(sound_job_t *job, sound_job_stats_t *stats);
+
+/* Joins the worker threads; every job must have been closed. */
+extern void sound_worker_close(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /*EMU_SOUND_WORKER_H*/
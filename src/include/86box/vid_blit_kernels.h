@@ -0,0 +1,123 @@
+/*
+ * 86Box    A hypervisor and IBM PC system emulator that specializes in
+ *          running old operating systems and software designed for IBM
+ *          PC systems and compatibles from 1981 through fairly recent
+ *          system designs based on the PCI bus.
+ *
+ *          This file is part of the 86Box distribution.
+ *
+ *          Shared span kernels for the 2D accelerators.
+ *
+ *          Each kernel processes one row of a blit whose addresses are
+ *          already known not to wrap, at 1 to 4 bytes per pixel. The
+ *          result is always identical to the chip's per-pixel walk in
+ *          the given direction, including when the source and the
+ *          destination overlap; the callers remain in charge of clipping,
+ *          address masking and register side effects.
+ *
+ *          Raster operations use the GDI ROP3 encoding: bit
+ *          ((P << 2) | (S << 1) | D) of the code is the result for that
+ *          combination, so 0xf0 is PATCOPY, 0xcc SRCCOPY and 0xaa a no-op.
+ *
+ * Authors: 86Box contributors.
+ *
+ *          Copyright 2026 86Box contributors.
+ */
+#ifndef VIDEO_BLIT_KERNELS_H
+#define VIDEO_BLIT_KERNELS_H
+
+#define BLIT_ROP3_BLACKNESS 0x00
+#define BLIT_ROP3_NOTSRC    0x33
+#define BLIT_ROP3_DSTINVERT 0x55
+#define BLIT_ROP3_SRCINVERT 0x66
+#define BLIT_ROP3_SRCAND    0x88
+#define BLIT_ROP3_NOP       0xaa
+#define BLIT_ROP3_SRCCOPY   0xcc
+#define BLIT_ROP3_SRCPAINT  0xee
+#define BLIT_ROP3_PATCOPY   0xf0
+#define BLIT_ROP3_PATINVERT 0x5a
+#define BLIT_ROP3_WHITENESS 0xff
+
+#define BLIT_ROP3_USES_S(rop) ((((rop) >> 2) ^ (rop)) & 0x33)
+#define BLIT_ROP3_USES_D(rop) ((((rop) >> 1) ^ (rop)) & 0x55)
+#define BLIT_ROP3_USES_P(rop) ((((rop) >> 4) ^ (rop)) & 0x0f)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* The 16 IBM 8514/A mix functions (also used by S3, Mach8/32/64 and XGA) as ROP3 codes. */
+extern const uint8_t blit_mix_rop3[16];
+
+static inline uint32_t
+blit_rop3(uint8_t rop, uint32_t d, uint32_t s, uint32_t p)
+{
+    uint32_t r = 0;
+
+    if (rop & 0x01)
+        r |= ~p & ~s & ~d;
+    if (rop & 0x02)
+        r |= ~p & ~s & d;
+    if (rop & 0x04)
+        r |= ~p & s & ~d;
+    if (rop & 0x08)
+        r |= ~p & s & d;
+    if (rop & 0x10)
+        r |= p & ~s & ~d;
+    if (rop & 0x20)
+        r |= p & ~s & d;
+    if (rop & 0x40)
+        r |= p & s & ~d;
+    if (rop & 0x80)
+        r |= p & s & d;
+
+    return r;
+}
+
+/* The same ROP with the pattern standing in for the source, for engines that supply a solid colour as the source. */
+static inline uint8_t
+blit_rop3_src_as_pat(uint8_t rop)
+{
+    return (uint8_t) blit_rop3(rop, BLIT_ROP3_NOP, BLIT_ROP3_PATCOPY, BLIT_ROP3_PATCOPY);
+}
+
+/*
+   dst (and src) point at the first pixel the chip visits; dir is +1 or -1,
+   and with -1 the span covers the count pixels ending at that pixel.
+ */
+
+/* Solid fill with the low bpp * 8 bits of color. */
+extern void blit_fill_span(uint8_t *dst, int count, int bpp, uint32_t color);
+/* Straight copy. */
+extern void blit_copy_span(uint8_t *dst, const uint8_t *src, int count, int bpp, int dir);
+/*
+   dst = (rop3(dst, src, pat) & wmask) | (dst & ~wmask). src may be NULL if
+   the ROP does not use it.
+ */
+extern void blit_rop3_span(uint8_t *dst, const uint8_t *src, int count, int bpp, int dir,
+                           uint8_t rop, uint32_t pat, uint32_t wmask);
+/*
+   Monochrome expansion: bit n of the span (counted from bit 7 of bits[0],
+   or from bit 0 if lsb_first is set, starting at bit_offset) selects fg
+   over bg as the source of pixel n. Pixels with a clear bit are left alone
+   if bg_transparent is set.
+ */
+extern void blit_mono_expand_span(uint8_t *dst, const uint8_t *bits, int bit_offset, int lsb_first,
+                                  int count, int bpp, int dir, uint32_t fg, uint32_t bg,
+                                  int bg_transparent, uint8_t rop, uint32_t wmask);
+
+/* Marks the 4 KB pages holding [addr, addr + len) as changed. */
+static inline void
+blit_mark_changed(uint8_t *changedvram, uint32_t addr, uint32_t len, uint8_t val)
+{
+    if (len == 0)
+        return;
+    for (uint32_t page = addr >> 12; page <= ((addr + len - 1) >> 12); page++)
+        changedvram[page] = val;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /*VIDEO_BLIT_KERNELS_H*/
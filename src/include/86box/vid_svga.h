@@ -331,6 +331,17 @@ typedef struct svga_t {
     void *     priv_parent;
 
     void *     local;
+
+    /* Target buffer lines changed this frame, handed to the blit. A count
+       above VIDEO_DIRTY_RECTS_MAX means too many to track. */
+    video_rect_t dirty[VIDEO_DIRTY_RECTS_MAX];
+    int          dirty_count;
+    int          dirty_full;
+
+    /* Border state the previous frame was drawn with. */
+    uint32_t dirty_overscan_color;
+    int      dirty_scrollcache;
+    int      dirty_dpms;
 } svga_t;
 
 extern void     ibm8514_set_poll(svga_t *svga);
@@ -416,6 +427,7 @@ enum {
 };
 
 uint32_t svga_lookup_lut_ram(svga_t* svga, uint32_t val);
+uint32_t svga_conv_16to32(struct svga_t *svga, uint16_t color, uint8_t bpp);
 
 /* We need a way to add a device with a pointer to a parent device so it can attach itself to it, and
    possibly also a second ATi 68860 RAM DAC type that auto-sets SVGA render on RAM DAC render change. */
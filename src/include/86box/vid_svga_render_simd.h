@@ -0,0 +1,59 @@
+/*
+ * 86Box    A hypervisor and IBM PC system emulator that specializes in
+ *          running old operating systems and software designed for IBM
+ *          PC systems and compatibles from 1981 through fairly recent
+ *          system designs based on the PCI bus.
+ *
+ *          This file is part of the 86Box distribution.
+ *
+ *          Vectorized SVGA scanline converters.
+ *
+ *          These kernels convert one contiguous run of VRAM into 32bpp
+ *          target buffer pixels. They are bit-exact with the scalar
+ *          loops in vid_svga_render.c, which remain in charge of address
+ *          remapping, wraparound and RAMDAC LUT handling.
+ *
+ * Authors: 86Box contributors.
+ *
+ *          Copyright 2026 86Box contributors.
+ */
+#ifndef VIDEO_SVGA_RENDER_SIMD_H
+#define VIDEO_SVGA_RENDER_SIMD_H
+
+enum {
+    SVGA_RENDER_IMPL_SCALAR = 0,
+    SVGA_RENDER_IMPL_SSE2,
+    SVGA_RENDER_IMPL_AVX2,
+    SVGA_RENDER_IMPL_NEON,
+    SVGA_RENDER_IMPL_MAX
+};
+
+typedef struct svga_render_kernels_t {
+    const char *name;
+
+    /* 8bpp palettized: dst[i] = pal[src[i] & mask]. */
+    void (*pal8)(uint32_t *dst, const uint8_t *src, int count, const uint32_t *pal, uint8_t mask);
+    /* 15bpp (x555) and 16bpp (565) to 8888, matching video_15to32[] / video_16to32[]. */
+    void (*rgb555)(uint32_t *dst, const uint8_t *src, int count);
+    void (*rgb565)(uint32_t *dst, const uint8_t *src, int count);
+    /* Packed 24bpp to 32bpp with a zero top byte. */
+    void (*rgb888)(uint32_t *dst, const uint8_t *src, int count);
+    /* 32bpp with the top byte cleared. */
+    void (*xrgb8888)(uint32_t *dst, const uint8_t *src, int count);
+} svga_render_kernels_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern const svga_render_kernels_t *svga_render_kernels;
+
+/* Returns NULL if the implementation is not compiled in or not supported by the host CPU. */
+extern const svga_render_kernels_t *svga_render_kernels_get(int impl);
+extern void                         svga_render_simd_init(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /*VIDEO_SVGA_RENDER_SIMD_H*/
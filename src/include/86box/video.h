@@ -106,6 +106,19 @@ typedef struct bitmap_t {
     uint32_t *line[2112];
 } bitmap_t;
 
+/*
+   A region of the target buffer that changed since the previous blit,
+   in target buffer coordinates.
+ */
+typedef struct video_rect_t {
+    int x;
+    int y;
+    int w;
+    int h;
+} video_rect_t;
+
+#define VIDEO_DIRTY_RECTS_MAX 16
+
 typedef struct rgb_t {
     uint8_t r;
     uint8_t g;
@@ -144,6 +157,9 @@ typedef struct monitor_t {
     int                      mon_changeframecount;
     int                      mon_renderedframes;
     atomic_int               mon_actualrenderedframes;
+    int                      mon_droppedframes;        /* Replaced before the frontend presented them. */
+    atomic_int               mon_actualdroppedframes;  /* Dropped during the last second. */
+    atomic_int               mon_droppedframes_total;
     atomic_int               mon_screenshots;
     atomic_int               mon_screenshots_clipboard;
     atomic_int               mon_screenshots_raw;
@@ -278,6 +294,9 @@ extern void video_blit_memtoscreen_8(int x, int y, int w, int h);
 extern void video_blend_monitor(int x, int y, int monitor_index);
 extern void video_process_8_monitor(int x, int y, int monitor_index);
 extern void video_blit_memtoscreen_monitor(int x, int y, int w, int h, int monitor_index);
+extern void video_blit_memtoscreen_dirty_monitor(int x, int y, int w, int h, const video_rect_t *dirty, int dirty_count, int monitor_index);
+extern int  video_blit_get_dirty_monitor(video_rect_t *rects, int monitor_index);
+extern bitmap_t *video_blit_source_monitor(int monitor_index);
 extern void video_blit_complete_monitor(int monitor_index);
 extern void video_wait_for_blit_monitor(int monitor_index);
 extern void video_wait_for_buffer_monitor(int monitor_index);
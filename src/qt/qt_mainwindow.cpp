@@ -203,6 +203,7 @@ MainWindow::MainWindow(QWidget *parent)
         hz = ((hz + 2) / 5) * 5;
 #endif
         hertz_label->setText(tr("%1 Hz").arg(QString::number(hz) + (monitors[0].mon_interlace ? "i" : "")));
+        hertz_label->setToolTip(tr("%1 frames dropped in the last second, %2 in total").arg(monitors[0].mon_actualdroppedframes.load()).arg(monitors[0].mon_droppedframes_total.load()));
     });
     statusBar()->addPermanentWidget(hertz_label);
     frameRateTimer->start(1000);
@@ -510,10 +510,11 @@ RendererStack::blit(int x, int y, int w, int h)
     sy = y;
     sw = this->w = w;
     sh = this->h       = h;
-    uint8_t *imagebits = std::get<uint8_t *>(imagebufs[currentBuf]);
+    uint8_t  *imagebits = std::get<uint8_t *>(imagebufs[currentBuf]);
+    bitmap_t *source    = video_blit_source_monitor(m_monitor_index);
     for (int y1 = y; y1 < (y + h); y1++) {
         auto scanline = imagebits + (y1 * rendererWindow->getBytesPerRow()) + (x * 4);
-        video_copy(scanline, &(monitors[m_monitor_index].target_buffer->line[y1][x]), w * 4);
+        video_copy(scanline, &(source->line[y1][x]), w * 4);
     }
 
     if (monitors[m_monitor_index].mon_screenshots_raw) {
@@ -62,6 +62,8 @@ SettingsSound::save()
 
     if (ui->radioButtonYMFM->isChecked())
         fm_driver = FM_DRV_YMFM;
+    else if (ui->radioButtonNukedSimd->isChecked())
+        fm_driver = FM_DRV_NUKED_SIMD;
     else
         fm_driver = FM_DRV_NUKED;
 }
@@ -179,6 +181,9 @@ SettingsSound::onCurrentMachineChanged(const int machineId)
         case FM_DRV_YMFM:
             ui->radioButtonYMFM->setChecked(true);
             break;
+        case FM_DRV_NUKED_SIMD:
+            ui->radioButtonNukedSimd->setChecked(true);
+            break;
         case FM_DRV_NUKED:
         default:
             ui->radioButtonNuked->setChecked(true);
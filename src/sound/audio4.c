@@ -33,20 +33,17 @@
 #endif
 
 #define I_NORMAL 0
-#define I_MUSIC 1
-#define I_WT 2
-#define I_CD 3
-#define I_FDD 4
-#define I_MIDI 5
+#define I_FDD 1
+#define I_MIDI 2
 
-static int audio[6] = {-1, -1, -1, -1, -1, -1};
+static int audio[3] = {-1, -1, -1};
 
 #ifdef USE_NEW_API
-static struct audio_swpar info[5];
+static struct audio_swpar info[3];
 #else
-static audio_info_t info[6];
+static audio_info_t info[3];
 #endif
-static int freqs[6] = {SOUND_FREQ, MUSIC_FREQ, WT_FREQ, CD_FREQ, SOUND_FREQ, 0};
+static int freqs[3] = {SOUND_FREQ, SOUND_FREQ, 0};
 
 void
 closeal(void)
@@ -62,6 +59,8 @@ closeal(void)
 void
 inital(void)
 {
+    freqs[I_NORMAL] = sound_output_freq;
+
     for (int i = 0; i < sizeof(audio) / sizeof(audio[0]); i++) {
         audio[i] = open("/dev/audio", O_WRONLY);
         if (audio[i] == -1)
@@ -146,25 +145,7 @@ givealbuffer_common(const void *buf, const uint8_t src, const int size)
 void
 givealbuffer(const void *buf)
 {
-    givealbuffer_common(buf, I_NORMAL, SOUNDBUFLEN << 1);
-}
-
-void
-givealbuffer_music(const void *buf)
-{
-    givealbuffer_common(buf, I_MUSIC, MUSICBUFLEN << 1);
-}
-
-void
-givealbuffer_wt(const void *buf)
-{
-    givealbuffer_common(buf, I_WT, WTBUFLEN << 1);
-}
-
-void
-givealbuffer_cd(const void *buf)
-{
-    givealbuffer_common(buf, I_CD, CD_BUFLEN << 1);
+    givealbuffer_common(buf, I_NORMAL, SOUND_OUTPUT_BUFLEN << 1);
 }
 
 void
@@ -13,8 +13,10 @@
 #include <86box/config.h>
 #include <86box/device.h>
 #include <86box/midi.h>
+#include <86box/midi_queue.h>
 #include <86box/thread.h>
 #include <86box/sound.h>
+#include <86box/sound_worker.h>
 #include <86box/plat_unused.h>
 
 #define RENDER_RATE                100
@@ -35,12 +37,12 @@ typedef struct fluidsynth {
     int               samplerate;
     int               sound_font;
 
-    thread_t *thread_h;
-    event_t  *event, *start_event;
-    int       buf_size;
-    float    *buffer;
-    int16_t  *buffer_int16;
-    int       midi_pos;
+    sound_job_t  *job;
+    int           buf_size;
+    int           buf_pos;
+    float        *buffer;
+    int16_t      *buffer_int16;
+    midi_queue_t *queue;
 
     int on;
 } fluidsynth_t;
@@ -53,58 +55,47 @@ fluidsynth_available(void)
     return 1;
 }
 
-void
-fluidsynth_poll(void)
-{
-    fluidsynth_t *data = &fsdev;
-    data->midi_pos++;
-    if (data->midi_pos == SOUND_FREQ / RENDER_RATE) {
-        data->midi_pos = 0;
-        thread_set_event(data->event);
-    }
-}
-
+/* Renders frames frames into the output buffer, handing it over whenever it fills up. */
 static void
-fluidsynth_thread(void *param)
+fluidsynth_render(void *priv, int frames)
 {
-    fluidsynth_t *data     = (fluidsynth_t *) param;
-    int           buf_pos  = 0;
-    int           buf_size = data->buf_size / BUFFER_SEGMENTS;
+    fluidsynth_t *data       = (fluidsynth_t *) priv;
+    const int     frame_size = 2 * (sound_is_float ? sizeof(float) : sizeof(int16_t));
 
-    thread_set_event(data->start_event);
+    while (frames > 0) {
+        int count = (data->buf_size - data->buf_pos) / frame_size;
 
-    while (data->on) {
-        thread_wait_event(data->event, -1);
-        thread_reset_event(data->event);
+        if (count > frames)
+            count = frames;
 
         if (sound_is_float) {
-            float *buf = (float *) ((uint8_t *) data->buffer + buf_pos);
-            memset(buf, 0, buf_size);
+            float *buf = (float *) ((uint8_t *) data->buffer + data->buf_pos);
+            memset(buf, 0, count * frame_size);
             if (data->synth)
-                fluid_synth_write_float(data->synth, buf_size / (2 * sizeof(float)), buf, 0, 2, buf, 1, 2);
-            buf_pos += buf_size;
-            if (buf_pos >= data->buf_size) {
-                givealbuffer_midi(data->buffer, data->buf_size / sizeof(float));
-                buf_pos = 0;
-            }
+                fluid_synth_write_float(data->synth, count, buf, 0, 2, buf, 1, 2);
         } else {
-            int16_t *buf = (int16_t *) ((uint8_t *) data->buffer_int16 + buf_pos);
-            memset(buf, 0, buf_size);
+            int16_t *buf = (int16_t *) ((uint8_t *) data->buffer_int16 + data->buf_pos);
+            memset(buf, 0, count * frame_size);
             if (data->synth)
-                fluid_synth_write_s16(data->synth, buf_size / (2 * sizeof(int16_t)), buf, 0, 2, buf, 1, 2);
-            buf_pos += buf_size;
-            if (buf_pos >= data->buf_size) {
+                fluid_synth_write_s16(data->synth, count, buf, 0, 2, buf, 1, 2);
+        }
+        data->buf_pos += count * frame_size;
+        frames -= count;
+
+        if (data->buf_pos >= data->buf_size) {
+            if (sound_is_float)
+                givealbuffer_midi(data->buffer, data->buf_size / sizeof(float));
+            else
                 givealbuffer_midi(data->buffer_int16, data->buf_size / sizeof(int16_t));
-                buf_pos = 0;
-            }
+            data->buf_pos = 0;
         }
     }
 }
 
-void
-fluidsynth_msg(uint8_t *msg)
+static void
+fluidsynth_play_msg(void *priv, uint8_t *msg)
 {
-    fluidsynth_t *data = &fsdev;
+    fluidsynth_t *data = (fluidsynth_t *) priv;
 
     uint32_t val = *((uint32_t *) msg);
 
@@ -141,14 +132,50 @@ fluidsynth_msg(uint8_t *msg)
     }
 }
 
-void
-fluidsynth_sysex(uint8_t *data, unsigned int len)
+static void
+fluidsynth_play_sysex(void *priv, uint8_t *data, unsigned int len)
 {
-    fluidsynth_t *d = &fsdev;
+    fluidsynth_t *d = (fluidsynth_t *) priv;
 
     fluid_synth_sysex(d->synth, (const char *) data, len, 0, 0, 0, 0);
 }
 
+static const midi_queue_ops_t fluidsynth_queue_ops = {
+    .render     = fluidsynth_render,
+    .play_msg   = fluidsynth_play_msg,
+    .play_sysex = fluidsynth_play_sysex
+};
+
+void
+fluidsynth_poll(void)
+{
+    fluidsynth_t *data = &fsdev;
+
+    midi_queue_period(data->queue);
+    sound_job_submit(data->job);
+}
+
+static void
+fluidsynth_job_run(void *priv)
+{
+    fluidsynth_t *data = (fluidsynth_t *) priv;
+
+    if (data->on)
+        midi_queue_render(data->queue, &fluidsynth_queue_ops, data);
+}
+
+void
+fluidsynth_msg(uint8_t *msg)
+{
+    midi_queue_msg(fsdev.queue, msg);
+}
+
+void
+fluidsynth_sysex(uint8_t *data, unsigned int len)
+{
+    midi_queue_sysex(fsdev.queue, data, len);
+}
+
 void *
 fluidsynth_init(UNUSED(const device_t *info))
 {
@@ -263,6 +290,11 @@ fluidsynth_init(UNUSED(const device_t *info))
 
     al_set_midi(data->samplerate, data->buf_size);
 
+    data->buf_pos = 0;
+    data->queue   = midi_queue_create(data->samplerate);
+    data->job     = sound_job_create("FluidSynth", fluidsynth_job_run, data);
+    data->on      = 1;
+
     dev = calloc(1, sizeof(midi_device_t));
 
     dev->play_msg   = fluidsynth_msg;
@@ -271,16 +303,6 @@ fluidsynth_init(UNUSED(const device_t *info))
 
     midi_out_init(dev);
 
-    data->on = 1;
-
-    data->start_event = thread_create_event();
-
-    data->event    = thread_create_event();
-    data->thread_h = thread_create(fluidsynth_thread, data);
-
-    thread_wait_event(data->start_event, -1);
-    thread_reset_event(data->start_event);
-
     return dev;
 }
 
@@ -293,8 +315,11 @@ fluidsynth_close(void *priv)
     fluidsynth_t *data = &fsdev;
 
     data->on = 0;
-    thread_set_event(data->event);
-    thread_wait(data->thread_h);
+    sound_job_close(data->job);
+    data->job = NULL;
+
+    midi_queue_close(data->queue);
+    data->queue = NULL;
 
     if (data->synth) {
         delete_fluid_synth(data->synth);
@@ -8,10 +8,12 @@
 #include <86box/device.h>
 #include <86box/mem.h>
 #include <86box/midi.h>
+#include <86box/midi_queue.h>
 #include <86box/plat.h>
 #include <86box/thread.h>
 #include <86box/rom.h>
 #include <86box/sound.h>
+#include <86box/sound_worker.h>
 #include <86box/ui.h>
 #include <mt32emu/c_interface/c_interface.h>
 
@@ -150,19 +152,18 @@ cm32ln_available(void)
     return roms_present[1];
 }
 
-static thread_t *thread_h    = NULL;
-static event_t  *event       = NULL;
-static event_t  *start_event = NULL;
-static int       mt32_on     = 0;
+static sound_job_t *job     = NULL;
+static int          mt32_on = 0;
 
 #define RENDER_RATE     100
 #define BUFFER_SEGMENTS 10
 
-static uint32_t samplerate   = 44100;
-static int      buf_size     = 0;
-static float   *buffer       = NULL;
-static int16_t *buffer_int16 = NULL;
-static int      midi_pos     = 0;
+static uint32_t      samplerate   = 44100;
+static int           buf_size     = 0;
+static int           buf_pos      = 0;
+static float        *buffer       = NULL;
+static int16_t      *buffer_int16 = NULL;
+static midi_queue_t *queue        = NULL;
 
 static mt32emu_report_handler_version
 get_mt32_report_handler_version(UNUSED(mt32emu_report_handler_i i))
@@ -198,66 +199,86 @@ mt32_stream_int16(int16_t *stream, int len)
         mt32emu_render_bit16s(context, stream, len);
 }
 
-void
-mt32_poll(void)
-{
-    midi_pos++;
-    if (midi_pos == SOUND_FREQ / RENDER_RATE) {
-        midi_pos = 0;
-        thread_set_event(event);
-    }
-}
-
+/* Renders frames frames into the output buffer, handing it over whenever it fills up. */
 static void
-mt32_thread(UNUSED(void *param))
+mt32_render(UNUSED(void *priv), int frames)
 {
-    int      buf_pos = 0;
-    int      bsize   = buf_size / BUFFER_SEGMENTS;
-    float   *buf;
-    int16_t *buf16;
+    const int frame_size = 2 * (sound_is_float ? sizeof(float) : sizeof(int16_t));
 
-    thread_set_event(start_event);
+    while (frames > 0) {
+        int count = (buf_size - buf_pos) / frame_size;
 
-    while (mt32_on) {
-        thread_wait_event(event, -1);
-        thread_reset_event(event);
+        if (count > frames)
+            count = frames;
 
         if (sound_is_float) {
-            buf = (float *) ((uint8_t *) buffer + buf_pos);
-            memset(buf, 0, bsize);
-            mt32_stream(buf, bsize / (2 * sizeof(float)));
-            buf_pos += bsize;
-            if (buf_pos >= buf_size) {
-                givealbuffer_midi(buffer, buf_size / sizeof(float));
-                buf_pos = 0;
-            }
+            float *buf = (float *) ((uint8_t *) buffer + buf_pos);
+            memset(buf, 0, count * frame_size);
+            mt32_stream(buf, count);
         } else {
-            buf16 = (int16_t *) ((uint8_t *) buffer_int16 + buf_pos);
-            memset(buf16, 0, bsize);
-            mt32_stream_int16(buf16, bsize / (2 * sizeof(int16_t)));
-            buf_pos += bsize;
-            if (buf_pos >= buf_size) {
+            int16_t *buf16 = (int16_t *) ((uint8_t *) buffer_int16 + buf_pos);
+            memset(buf16, 0, count * frame_size);
+            mt32_stream_int16(buf16, count);
+        }
+        buf_pos += count * frame_size;
+        frames -= count;
+
+        if (buf_pos >= buf_size) {
+            if (sound_is_float)
+                givealbuffer_midi(buffer, buf_size / sizeof(float));
+            else
                 givealbuffer_midi(buffer_int16, buf_size / sizeof(int16_t));
-                buf_pos = 0;
-            }
+            buf_pos = 0;
         }
     }
 }
 
-void
-mt32_msg(uint8_t *val)
+static void
+mt32_play_msg(UNUSED(void *priv), uint8_t *val)
 {
     if (context)
         mt32_check("mt32emu_play_msg", mt32emu_play_msg(context, *(uint32_t *) val), MT32EMU_RC_OK);
 }
 
-void
-mt32_sysex(uint8_t *data, unsigned int len)
+static void
+mt32_play_sysex(UNUSED(void *priv), uint8_t *data, unsigned int len)
 {
     if (context)
         mt32_check("mt32emu_play_sysex", mt32emu_play_sysex(context, data, len), MT32EMU_RC_OK);
 }
 
+static const midi_queue_ops_t mt32_queue_ops = {
+    .render     = mt32_render,
+    .play_msg   = mt32_play_msg,
+    .play_sysex = mt32_play_sysex
+};
+
+void
+mt32_poll(void)
+{
+    midi_queue_period(queue);
+    sound_job_submit(job);
+}
+
+static void
+mt32_job_run(UNUSED(void *priv))
+{
+    if (mt32_on)
+        midi_queue_render(queue, &mt32_queue_ops, NULL);
+}
+
+void
+mt32_msg(uint8_t *val)
+{
+    midi_queue_msg(queue, val);
+}
+
+void
+mt32_sysex(uint8_t *data, unsigned int len)
+{
+    midi_queue_sysex(queue, data, len);
+}
+
 void *
 mt32emu_init(char *control_rom, char *pcm_rom)
 {
@@ -298,6 +319,11 @@ mt32emu_init(char *control_rom, char *pcm_rom)
 
     al_set_midi(samplerate, buf_size);
 
+    buf_pos = 0;
+    queue   = midi_queue_create(samplerate);
+    job     = sound_job_create("MT-32", mt32_job_run, NULL);
+    mt32_on = 1;
+
     dev = calloc(1, sizeof(midi_device_t));
 
     dev->play_msg   = mt32_msg;
@@ -306,16 +332,6 @@ mt32emu_init(char *control_rom, char *pcm_rom)
 
     midi_out_init(dev);
 
-    mt32_on = 1;
-
-    start_event = thread_create_event();
-
-    event    = thread_create_event();
-    thread_h = thread_create(mt32_thread, 0);
-
-    thread_wait_event(start_event, -1);
-    thread_reset_event(start_event);
-
     return dev;
 }
 
@@ -350,12 +366,11 @@ mt32_close(void *priv)
         return;
 
     mt32_on = 0;
-    thread_set_event(event);
-    thread_wait(thread_h);
+    sound_job_close(job);
+    job = NULL;
 
-    event       = NULL;
-    start_event = NULL;
-    thread_h    = NULL;
+    midi_queue_close(queue);
+    queue = NULL;
 
     if (context) {
         mt32emu_close_synth(context);
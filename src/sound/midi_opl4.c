@@ -3,7 +3,6 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <stdbool.h>
-#include <stdatomic.h>
 #include <stdlib.h>
 #include <string.h>
 #include <wchar.h>
@@ -12,10 +11,12 @@
 #include <86box/device.h>
 #include <86box/mem.h>
 #include <86box/midi.h>
+#include <86box/midi_queue.h>
 #include <86box/plat.h>
 #include <86box/thread.h>
 #include <86box/rom.h>
 #include <86box/sound.h>
+#include <86box/sound_worker.h>
 #include <86box/ui.h>
 #include <86box/snd_opl.h>
 #include <86box/opl4_defines.h>
@@ -278,11 +279,10 @@ typedef struct opl4_midi {
     VOICE_DATA        voice_data[24];
     int16_t           buffer[(48000 / 100) * 2 * BUFFER_SEGMENTS];
     float             buffer_float[(48000 / 100) * 2 * BUFFER_SEGMENTS];
-    uint32_t          midi_pos;
+    uint32_t          buf_pos;
     bool              on;
-    atomic_bool       gen_in_progress;
-    thread_t         *thread;
-    event_t          *wait_event;
+    sound_job_t      *job;
+    midi_queue_t     *queue;
 } opl4_midi_t;
 
 static opl4_midi_t *opl4_midi_cur;
@@ -405,7 +405,6 @@ note_off(uint8_t note, uint8_t velocity, MIDI_CHANNEL_DATA *midi_channel, opl4_m
     /* Velocity not used */
     (void) velocity;
 
-    while (opl4_midi->gen_in_progress) { }
     for (uint8_t i = 0; i < 24; i++) {
         VOICE_DATA *voice = &opl4_midi->voice_data[i];
         if (voice->is_active && voice->midi_channel == midi_channel && voice->note == note) {
@@ -439,8 +438,6 @@ note_on(uint8_t note, uint8_t velocity, MIDI_CHANNEL_DATA *midi_channel, opl4_mi
     int                           i      = 0;
     uint8_t                       voices = 0;
 
-    while (opl4_midi->gen_in_progress) { }
-
     if (midi_channel->drum_channel)
         wave_data[voices++] = &region_ptr[0x80].regions[note - 0x1A].wave_data;
     else {
@@ -557,65 +554,52 @@ program_change(uint8_t midi_channel, uint8_t program, opl4_midi_t *opl4_midi)
     opl4_midi->midi_channel_data[midi_channel].instrument = program;
 }
 
+extern void givealbuffer_midi(void *buf, uint32_t size);
+
+/* Renders frames frames into the output buffer, handing it over whenever it fills up. */
 static void
-opl4_midi_thread(UNUSED(void *arg))
+opl4_midi_render(void *priv, int frames)
 {
-    opl4_midi_t *opl4_midi         = opl4_midi_cur;
-    uint32_t     i                 = 0;
-    uint32_t     buf_size          = RENDER_RATE * 2;
-    uint32_t     buf_size_segments = buf_size * BUFFER_SEGMENTS;
-    uint32_t     buf_pos           = 0;
-
-    int32_t buffer[RENDER_RATE * 2];
-
-    extern void givealbuffer_midi(void *buf, uint32_t size);
-    while (opl4_midi->on) {
-        thread_wait_event(opl4_midi->wait_event, -1);
-        thread_reset_event(opl4_midi->wait_event);
-        if (!opl4_midi->on)
-            break;
-        atomic_store(&opl4_midi->gen_in_progress, true);
-        opl4_midi->opl4.generate(opl4_midi->opl4.priv, buffer, RENDER_RATE);
-        atomic_store(&opl4_midi->gen_in_progress, false);
+    opl4_midi_t *opl4_midi = (opl4_midi_t *) priv;
+    int32_t      buffer[RENDER_RATE * 2];
+
+    while (frames > 0) {
+        uint32_t count = (RENDER_RATE * BUFFER_SEGMENTS) - opl4_midi->buf_pos;
+
+        if (count > (uint32_t) frames)
+            count = frames;
+        if (count > RENDER_RATE)
+            count = RENDER_RATE;
+
+        opl4_midi->opl4.generate(opl4_midi->opl4.priv, buffer, count);
         if (sound_is_float) {
-            for (i = 0; i < (buf_size / 2); i++) {
-                opl4_midi->buffer_float[(i + buf_pos) * 2]       = buffer[i * 2] / 32768.0;
-                opl4_midi->buffer_float[((i + buf_pos) * 2) + 1] = buffer[(i * 2) + 1] / 32768.0;
-            }
-            buf_pos += buf_size / 2;
-            if (buf_pos >= (buf_size_segments / 2)) {
-                givealbuffer_midi(opl4_midi->buffer_float, buf_size_segments);
-                buf_pos = 0;
+            for (uint32_t i = 0; i < count; i++) {
+                opl4_midi->buffer_float[(i + opl4_midi->buf_pos) * 2]       = buffer[i * 2] / 32768.0;
+                opl4_midi->buffer_float[((i + opl4_midi->buf_pos) * 2) + 1] = buffer[(i * 2) + 1] / 32768.0;
             }
         } else {
-            for (i = 0; i < (buf_size / 2); i++) {
-                opl4_midi->buffer[(i + buf_pos) * 2]       = buffer[i * 2] & 0xFFFF;       /* Outputs are clamped beforehand. */
-                opl4_midi->buffer[((i + buf_pos) * 2) + 1] = buffer[(i * 2) + 1] & 0xFFFF; /* Outputs are clamped beforehand. */
-            }
-            buf_pos += buf_size / 2;
-            if (buf_pos >= (buf_size_segments / 2)) {
-                givealbuffer_midi(opl4_midi->buffer, buf_size_segments);
-                buf_pos = 0;
+            for (uint32_t i = 0; i < count; i++) {
+                opl4_midi->buffer[(i + opl4_midi->buf_pos) * 2]       = buffer[i * 2] & 0xFFFF;       /* Outputs are clamped beforehand. */
+                opl4_midi->buffer[((i + opl4_midi->buf_pos) * 2) + 1] = buffer[(i * 2) + 1] & 0xFFFF; /* Outputs are clamped beforehand. */
             }
         }
+        opl4_midi->buf_pos += count;
+        frames -= count;
+
+        if (opl4_midi->buf_pos >= (RENDER_RATE * BUFFER_SEGMENTS)) {
+            if (sound_is_float)
+                givealbuffer_midi(opl4_midi->buffer_float, RENDER_RATE * 2 * BUFFER_SEGMENTS);
+            else
+                givealbuffer_midi(opl4_midi->buffer, RENDER_RATE * 2 * BUFFER_SEGMENTS);
+            opl4_midi->buf_pos = 0;
+        }
     }
 }
 
 static void
-opl4_midi_poll(void)
+opl4_midi_play_msg(void *priv, uint8_t *val)
 {
-    opl4_midi_t *opl4_midi = opl4_midi_cur;
-    opl4_midi->midi_pos++;
-    if (opl4_midi->midi_pos == RENDER_RATE) {
-        opl4_midi->midi_pos = 0;
-        thread_set_event(opl4_midi->wait_event);
-    }
-}
-
-void
-opl4_midi_msg(uint8_t *val)
-{
-    opl4_midi_t *opl4_midi = opl4_midi_cur;
+    opl4_midi_t *opl4_midi = (opl4_midi_t *) priv;
 
     uint32_t msg         = *(uint32_t *) (val);
     uint8_t  data_byte_1 = msg & 0xFF;
@@ -648,6 +632,37 @@ opl4_midi_msg(uint8_t *val)
     }
 }
 
+static const midi_queue_ops_t opl4_midi_queue_ops = {
+    .render     = opl4_midi_render,
+    .play_msg   = opl4_midi_play_msg,
+    .play_sysex = NULL
+};
+
+static void
+opl4_midi_job_run(void *priv)
+{
+    opl4_midi_t *opl4_midi = (opl4_midi_t *) priv;
+
+    /* Events are played here, between renders, so the chip is never written while generating. */
+    if (opl4_midi->on)
+        midi_queue_render(opl4_midi->queue, &opl4_midi_queue_ops, opl4_midi);
+}
+
+static void
+opl4_midi_poll(void)
+{
+    opl4_midi_t *opl4_midi = opl4_midi_cur;
+
+    midi_queue_period(opl4_midi->queue);
+    sound_job_submit(opl4_midi->job);
+}
+
+void
+opl4_midi_msg(uint8_t *val)
+{
+    midi_queue_msg(opl4_midi_cur->queue, val);
+}
+
 void
 opl4_midi_sysex(UNUSED(uint8_t *data), UNUSED(unsigned int len))
 {
@@ -671,6 +686,7 @@ opl4_init(UNUSED(const device_t *info))
     opl4_midi_cur = calloc(1, sizeof(opl4_midi_t));
 
     fm_driver_get(FM_YMF278B, &opl4_midi_cur->opl4);
+    opl4_midi_cur->queue = midi_queue_create(48000);
 
     opl4_midi_cur->opl4.write(0x38A, 0x05, opl4_midi_cur->opl4.priv);
     opl4_midi_cur->opl4.write(0x389, 0x3, opl4_midi_cur->opl4.priv);
@@ -678,7 +694,6 @@ opl4_init(UNUSED(const device_t *info))
 
     opl4_midi_cur->on                                = true;
     opl4_midi_cur->midi_channel_data[9].drum_channel = true;
-    atomic_init(&opl4_midi_cur->gen_in_progress, 0);
 
     for (uint8_t voice = 0; voice < NR_OF_WAVE_CHANNELS; voice++) {
         opl4_midi_cur->voice_data[voice].number          = voice;
@@ -693,8 +708,7 @@ opl4_init(UNUSED(const device_t *info))
         opl4_midi_cur->voice_data[voice].reg_misc        = 0;
         opl4_midi_cur->voice_data[voice].reg_lfo_vibrato = 0;
     }
-    opl4_midi_cur->wait_event = thread_create_event();
-    opl4_midi_cur->thread     = thread_create(opl4_midi_thread, NULL);
+    opl4_midi_cur->job = sound_job_create("OPL4-ML", opl4_midi_job_run, opl4_midi_cur);
     return dev;
 }
 
@@ -705,8 +719,8 @@ opl4_close(void *p)
         return;
 
     opl4_midi_cur->on = false;
-    thread_set_event(opl4_midi_cur->wait_event);
-    thread_wait(opl4_midi_cur->thread);
+    sound_job_close(opl4_midi_cur->job);
+    midi_queue_close(opl4_midi_cur->queue);
     free(opl4_midi_cur);
     opl4_midi_cur = NULL;
 }
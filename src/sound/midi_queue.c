@@ -0,0 +1,361 @@
+/*
+ * 86Box    A hypervisor and IBM PC system emulator that specializes in
+ *          running old operating systems and software designed for IBM
+ *          PC systems and compatibles from 1981 through fairly recent
+ *          system designs based on the PCI bus.
+ *
+ *          This file is part of the 86Box distribution.
+ *
+ *          Timestamped MIDI event queue for the software synthesizers.
+ *
+ *          Events are variable length records in a byte ring: a header
+ *          with the frame at which to play the event, then the message
+ *          or SysEx bytes. A record never wraps; when it does not fit
+ *          before the end of the ring, the rest of the ring is filled
+ *          with a padding record and the event starts over at the
+ *          beginning, so that the render thread can hand SysEx data to
+ *          the synthesizer straight out of the ring.
+ *
+ *          The render thread owns the read side and never waits. On the
+ *          write side the emulation thread is normally alone, but MIDI
+ *          thru from a host input device comes in on the input thread,
+ *          so writers take a flag that in practice is never contended.
+ *
+ *          Time is counted in 10 ms periods, one per MIDI poll, plus the
+ *          position of the emulated time within the current period. An
+ *          event sent during period n is played during the period that
+ *          the render thread renders on poll n + 1, at the same offset,
+ *          which keeps the latency the synthesizers already had while
+ *          placing every event on its own frame.
+ *
+ * Authors: 86Box contributors.
+ *
+ *          Copyright 2026 86Box contributors.
+ */
+#include <inttypes.h>
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#define HAVE_STDARG_H
+#include <86box/86box.h>
+#include <86box/midi.h>
+#include <86box/midi_queue.h>
+#include <86box/sound.h>
+
+#define MIDI_QUEUE_SIZE        65536 /* Bytes, a power of two that holds several SysEx dumps of SYSEX_SIZE. */
+#define MIDI_QUEUE_ALIGN       16
+#define MIDI_QUEUE_BACKLOG_MAX 20 /* Periods the render thread may fall behind before it skips ahead. */
+
+enum {
+    MIDI_EVENT_PAD = 0,
+    MIDI_EVENT_MSG,
+    MIDI_EVENT_SYSEX
+};
+
+typedef struct midi_event_t {
+    uint64_t time; /* Frame at the synthesizer rate. */
+    uint32_t len;  /* Bytes of data after the header. */
+    uint32_t type;
+} midi_event_t;
+
+struct midi_queue_t {
+    uint8_t *buf;
+    int      rate;
+    int      period_frames;
+
+    /* Write side. */
+    atomic_flag lock;
+    uint64_t    period;
+    atomic_uint wr;
+    atomic_uint queued;
+    atomic_uint dropped;
+    atomic_uint depth_max;
+
+    /* Frames owed to the render thread so far. */
+    atomic_ullong target;
+
+    /* Read side. */
+    atomic_uint   rd;
+    atomic_uint   played;
+    uint64_t      pos;
+    atomic_uint   backlog_max;
+    atomic_ullong periods;
+    atomic_ullong skipped;
+    atomic_ullong render_ns_last;
+    atomic_ullong render_ns_max;
+    atomic_ullong render_ns_total;
+};
+
+#ifdef ENABLE_MIDI_QUEUE_LOG
+int midi_queue_do_log = ENABLE_MIDI_QUEUE_LOG;
+
+static void
+midi_queue_log(const char *fmt, ...)
+{
+    va_list ap;
+
+    if (midi_queue_do_log) {
+        va_start(ap, fmt);
+        pclog_ex(fmt, ap);
+        va_end(ap);
+    }
+}
+#else
+#    define midi_queue_log(fmt, ...)
+#endif
+
+static uint64_t
+midi_queue_now_ns(void)
+{
+    struct timespec ts;
+
+    timespec_get(&ts, TIME_UTC);
+    return ((uint64_t) ts.tv_sec * 1000000000ULL) + (uint64_t) ts.tv_nsec;
+}
+
+static uint32_t
+midi_queue_record_len(uint32_t len)
+{
+    return (sizeof(midi_event_t) + len + MIDI_QUEUE_ALIGN - 1) & ~(MIDI_QUEUE_ALIGN - 1);
+}
+
+midi_queue_t *
+midi_queue_create(int rate)
+{
+    midi_queue_t *q = calloc(1, sizeof(midi_queue_t));
+
+    q->buf           = calloc(MIDI_QUEUE_SIZE, 1);
+    q->rate          = rate;
+    q->period_frames = rate / 100;
+
+    atomic_flag_clear(&q->lock);
+    atomic_init(&q->wr, 0);
+    atomic_init(&q->queued, 0);
+    atomic_init(&q->dropped, 0);
+    atomic_init(&q->depth_max, 0);
+    atomic_init(&q->target, 0);
+    atomic_init(&q->rd, 0);
+    atomic_init(&q->played, 0);
+    atomic_init(&q->backlog_max, 0);
+    atomic_init(&q->periods, 0);
+    atomic_init(&q->skipped, 0);
+    atomic_init(&q->render_ns_last, 0);
+    atomic_init(&q->render_ns_max, 0);
+    atomic_init(&q->render_ns_total, 0);
+
+    return q;
+}
+
+void
+midi_queue_close(midi_queue_t *q)
+{
+    midi_queue_stats_t stats;
+
+    if (q == NULL)
+        return;
+
+    midi_queue_get_stats(q, &stats);
+    midi_queue_log("MIDI queue: %" PRIu64 " periods, depth max %u, %u dropped, backlog max %u, %" PRIu64 " skipped, "
+                   "render avg %" PRIu64 " ns, max %" PRIu64 " ns\n",
+                   stats.periods, stats.depth_max, stats.dropped, stats.backlog_max, stats.skipped,
+                   stats.render_ns_avg, stats.render_ns_max);
+
+    free(q->buf);
+    free(q);
+}
+
+static void
+midi_queue_push(midi_queue_t *q, uint32_t type, const uint8_t *data, uint32_t len)
+{
+    const uint32_t rec = midi_queue_record_len(len);
+    uint64_t       offset;
+    uint32_t       wr;
+    uint32_t       idx;
+    uint32_t       need;
+    uint32_t       depth;
+    uint32_t       max;
+    midi_event_t  *ev;
+
+    if (rec > MIDI_QUEUE_SIZE / 2)
+        return;
+
+    while (atomic_flag_test_and_set_explicit(&q->lock, memory_order_acquire))
+        ;
+
+    /* Frame of the emulated time within the period, never past its end. */
+    offset = ((uint64_t) sound_get_poll_pos() * q->rate) / SOUND_FREQ;
+    if (offset >= (uint64_t) q->period_frames)
+        offset = q->period_frames - 1;
+
+    wr   = atomic_load_explicit(&q->wr, memory_order_relaxed);
+    idx  = wr & (MIDI_QUEUE_SIZE - 1);
+    need = rec;
+    if ((MIDI_QUEUE_SIZE - idx) < rec)
+        need += MIDI_QUEUE_SIZE - idx;
+
+    if ((MIDI_QUEUE_SIZE - (wr - atomic_load_explicit(&q->rd, memory_order_acquire))) < need) {
+        atomic_fetch_add_explicit(&q->dropped, 1, memory_order_relaxed);
+        atomic_flag_clear_explicit(&q->lock, memory_order_release);
+        return;
+    }
+
+    if (need != rec) {
+        ev       = (midi_event_t *) &q->buf[idx];
+        ev->time = 0;
+        ev->len  = MIDI_QUEUE_SIZE - idx - sizeof(midi_event_t);
+        ev->type = MIDI_EVENT_PAD;
+        wr += MIDI_QUEUE_SIZE - idx;
+        idx = 0;
+    }
+
+    ev       = (midi_event_t *) &q->buf[idx];
+    ev->time = (q->period * q->period_frames) + offset;
+    ev->len  = len;
+    ev->type = type;
+    memcpy(&q->buf[idx + sizeof(midi_event_t)], data, len);
+
+    atomic_store_explicit(&q->wr, wr + rec, memory_order_release);
+
+    depth = atomic_fetch_add_explicit(&q->queued, 1, memory_order_relaxed) + 1 -
+            atomic_load_explicit(&q->played, memory_order_relaxed);
+    max   = atomic_load_explicit(&q->depth_max, memory_order_relaxed);
+    if (depth > max)
+        atomic_store_explicit(&q->depth_max, depth, memory_order_relaxed);
+
+    atomic_flag_clear_explicit(&q->lock, memory_order_release);
+}
+
+void
+midi_queue_msg(midi_queue_t *q, const uint8_t *msg)
+{
+    /* Short messages are handed around as four bytes, as in midi_device_t. */
+    midi_queue_push(q, MIDI_EVENT_MSG, msg, 4);
+}
+
+void
+midi_queue_sysex(midi_queue_t *q, const uint8_t *sysex, unsigned int len)
+{
+    midi_queue_push(q, MIDI_EVENT_SYSEX, sysex, len);
+}
+
+void
+midi_queue_period(midi_queue_t *q)
+{
+    while (atomic_flag_test_and_set_explicit(&q->lock, memory_order_acquire))
+        ;
+
+    q->period++;
+    /* Release, so that the render thread sees every event of the period it is told to render. */
+    atomic_store_explicit(&q->target, q->period * q->period_frames, memory_order_release);
+
+    atomic_flag_clear_explicit(&q->lock, memory_order_release);
+}
+
+/* Next event to play, or NULL if the queue is empty. Padding is consumed on the way. */
+static midi_event_t *
+midi_queue_peek(midi_queue_t *q)
+{
+    uint32_t rd = atomic_load_explicit(&q->rd, memory_order_relaxed);
+
+    while (rd != atomic_load_explicit(&q->wr, memory_order_acquire)) {
+        midi_event_t *ev = (midi_event_t *) &q->buf[rd & (MIDI_QUEUE_SIZE - 1)];
+
+        if (ev->type != MIDI_EVENT_PAD)
+            return ev;
+
+        rd += midi_queue_record_len(ev->len);
+        atomic_store_explicit(&q->rd, rd, memory_order_release);
+    }
+
+    return NULL;
+}
+
+static void
+midi_queue_pop(midi_queue_t *q, const midi_event_t *ev)
+{
+    const uint32_t rd = atomic_load_explicit(&q->rd, memory_order_relaxed);
+
+    atomic_store_explicit(&q->rd, rd + midi_queue_record_len(ev->len), memory_order_release);
+    atomic_fetch_add_explicit(&q->played, 1, memory_order_relaxed);
+}
+
+void
+midi_queue_render(midi_queue_t *q, const midi_queue_ops_t *ops, void *priv)
+{
+    const uint64_t target = atomic_load_explicit(&q->target, memory_order_acquire);
+    uint64_t       periods;
+    uint64_t       start;
+    uint64_t       ns;
+
+    if (q->pos >= target)
+        return;
+
+    periods = (target - q->pos) / q->period_frames;
+
+    if (periods > atomic_load_explicit(&q->backlog_max, memory_order_relaxed))
+        atomic_store_explicit(&q->backlog_max, (uint32_t) periods, memory_order_relaxed);
+
+    /*
+       Rather than spend the next several periods catching up on audio that
+       would be played far too late, drop all but the most recent ones; the
+       events of the dropped periods are played at the start of what is left.
+     */
+    if (periods > MIDI_QUEUE_BACKLOG_MAX) {
+        atomic_fetch_add_explicit(&q->skipped, periods - MIDI_QUEUE_BACKLOG_MAX, memory_order_relaxed);
+        q->pos  = target - ((uint64_t) MIDI_QUEUE_BACKLOG_MAX * q->period_frames);
+        periods = MIDI_QUEUE_BACKLOG_MAX;
+    }
+
+    start = midi_queue_now_ns();
+
+    while (q->pos < target) {
+        midi_event_t *ev    = midi_queue_peek(q);
+        uint64_t      until = target;
+
+        if ((ev != NULL) && (ev->time < target))
+            until = ev->time;
+
+        if (until > q->pos) {
+            ops->render(priv, (int) (until - q->pos));
+            q->pos = until;
+        }
+
+        if ((ev == NULL) || (ev->time >= target))
+            break;
+
+        if (ev->type == MIDI_EVENT_SYSEX) {
+            if (ops->play_sysex)
+                ops->play_sysex(priv, (uint8_t *) &ev[1], ev->len);
+        } else if (ops->play_msg)
+            ops->play_msg(priv, (uint8_t *) &ev[1]);
+
+        midi_queue_pop(q, ev);
+    }
+
+    ns = midi_queue_now_ns() - start;
+    atomic_fetch_add_explicit(&q->periods, periods, memory_order_relaxed);
+    atomic_store_explicit(&q->render_ns_last, ns / periods, memory_order_relaxed);
+    atomic_fetch_add_explicit(&q->render_ns_total, ns, memory_order_relaxed);
+    if ((ns / periods) > atomic_load_explicit(&q->render_ns_max, memory_order_relaxed))
+        atomic_store_explicit(&q->render_ns_max, ns / periods, memory_order_relaxed);
+}
+
+void
+midi_queue_get_stats(midi_queue_t *q, midi_queue_stats_t *stats)
+{
+    const uint32_t queued = atomic_load_explicit(&q->queued, memory_order_relaxed);
+
+    stats->depth          = queued - atomic_load_explicit(&q->played, memory_order_relaxed);
+    stats->depth_max      = atomic_load_explicit(&q->depth_max, memory_order_relaxed);
+    stats->dropped        = atomic_load_explicit(&q->dropped, memory_order_relaxed);
+    stats->backlog_max    = atomic_load_explicit(&q->backlog_max, memory_order_relaxed);
+    stats->periods        = atomic_load_explicit(&q->periods, memory_order_relaxed);
+    stats->skipped        = atomic_load_explicit(&q->skipped, memory_order_relaxed);
+    stats->render_ns_last = atomic_load_explicit(&q->render_ns_last, memory_order_relaxed);
+    stats->render_ns_max  = atomic_load_explicit(&q->render_ns_max, memory_order_relaxed);
+    stats->render_ns_avg  = stats->periods ? (atomic_load_explicit(&q->render_ns_total, memory_order_relaxed) / stats->periods) : 0;
+}
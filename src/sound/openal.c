@@ -32,23 +32,16 @@
 #include <86box/sound.h>
 #include <86box/plat_unused.h>
 
-#define FREQ   SOUND_FREQ
-#define BUFLEN SOUNDBUFLEN
+#define FREQ SOUND_FREQ
 
 #define I_NORMAL 0
-#define I_MUSIC  1
-#define I_WT     2
-#define I_CD     3
-#define I_FDD    4
-#define I_MIDI   5
-
-ALuint        buffers[4];       /* front and back buffers */
-ALuint        buffers_music[4]; /* front and back buffers */
-ALuint        buffers_wt[4];    /* front and back buffers */
-ALuint        buffers_cd[4];    /* front and back buffers */
-ALuint        buffers_fdd[4];   /* front and back buffers */
-ALuint        buffers_midi[4];  /* front and back buffers */
-static ALuint source[6];        /* audio source - CHANGED FROM 5 TO 6 */
+#define I_FDD    1
+#define I_MIDI   2
+
+ALuint        buffers[4];      /* front and back buffers */
+ALuint        buffers_fdd[4];  /* front and back buffers */
+ALuint        buffers_midi[4]; /* front and back buffers */
+static ALuint source[3];       /* 0=mixed output, 1=fdd, 2=midi(optional) */
 
 static int         midi_freq     = 44100;
 static int         midi_buf_size = 4410;
@@ -105,11 +98,9 @@ closeal(void)
     alSourceStopv(sources, source);
     alDeleteSources(sources, source);
 
-    if (sources >= 6)
+    if (sources > I_MIDI)
         alDeleteBuffers(4, buffers_midi);
     alDeleteBuffers(4, buffers_fdd);
-    alDeleteBuffers(4, buffers_cd);
-    alDeleteBuffers(4, buffers_music);
     alDeleteBuffers(4, buffers);
 
     alutExit();
@@ -120,18 +111,13 @@ closeal(void)
 void
 inital(void)
 {
-    float   *buf             = NULL;
-    float   *music_buf       = NULL;
-    float   *wt_buf          = NULL;
-    float   *cd_buf          = NULL;
-    float   *midi_buf        = NULL;
-    float   *fdd_buf         = NULL;
-    int16_t *buf_int16       = NULL;
-    int16_t *music_buf_int16 = NULL;
-    int16_t *wt_buf_int16    = NULL;
-    int16_t *cd_buf_int16    = NULL;
-    int16_t *midi_buf_int16  = NULL;
-    int16_t *fdd_buf_int16   = NULL;
+    const int buflen         = SOUND_OUTPUT_BUFLEN;
+    float    *buf            = NULL;
+    float    *midi_buf       = NULL;
+    float    *fdd_buf        = NULL;
+    int16_t  *buf_int16      = NULL;
+    int16_t  *midi_buf_int16 = NULL;
+    int16_t  *fdd_buf_int16  = NULL;
 
     int init_midi = 0;
 
@@ -146,128 +132,53 @@ inital(void)
         init_midi = 1; /* If the device is neither none, nor system MIDI, initialize the
                           MIDI buffer and source, otherwise, do not. */
 
-    sources = 5 + !!init_midi;
+    sources = 2 + !!init_midi;
     if (sound_is_float) {
-        buf       = (float *) calloc((BUFLEN << 1), sizeof(float));
-        music_buf = (float *) calloc((MUSICBUFLEN << 1), sizeof(float));
-        wt_buf    = (float *) calloc((WTBUFLEN << 1), sizeof(float));
-        cd_buf    = (float *) calloc((CD_BUFLEN << 1), sizeof(float));
-        fdd_buf   = (float *) calloc((BUFLEN << 1), sizeof(float));
+        buf     = (float *) calloc((buflen << 1), sizeof(float));
+        fdd_buf = (float *) calloc((SOUNDBUFLEN << 1), sizeof(float));
         if (init_midi)
             midi_buf = (float *) calloc(midi_buf_size, sizeof(float));
     } else {
-        buf_int16       = (int16_t *) calloc((BUFLEN << 1), sizeof(int16_t));
-        music_buf_int16 = (int16_t *) calloc((MUSICBUFLEN << 1), sizeof(int16_t));
-        wt_buf_int16    = (int16_t *) calloc((WTBUFLEN << 1), sizeof(int16_t));
-        cd_buf_int16    = (int16_t *) calloc((CD_BUFLEN << 1), sizeof(int16_t));
-        fdd_buf_int16   = (int16_t *) calloc((BUFLEN << 1), sizeof(int16_t));
+        buf_int16     = (int16_t *) calloc((buflen << 1), sizeof(int16_t));
+        fdd_buf_int16 = (int16_t *) calloc((SOUNDBUFLEN << 1), sizeof(int16_t));
         if (init_midi)
             midi_buf_int16 = (int16_t *) calloc(midi_buf_size, sizeof(int16_t));
     }
 
     alGenBuffers(4, buffers);
-    alGenBuffers(4, buffers_cd);
     alGenBuffers(4, buffers_fdd);
-    alGenBuffers(4, buffers_music);
-    alGenBuffers(4, buffers_wt);
     if (init_midi)
         alGenBuffers(4, buffers_midi);
 
-    // Create sources: 0=main, 1=music, 2=wt, 3=cd, 4=fdd, 5=midi(optional)
     alGenSources(sources, source);
 
-    if (init_midi)
-        alGenSources(5, source);
-    else
-        alGenSources(4, source);
-
-    alSource3f(source[I_NORMAL], AL_POSITION, 0.0f, 0.0f, 0.0f);
-    alSource3f(source[I_NORMAL], AL_VELOCITY, 0.0f, 0.0f, 0.0f);
-    alSource3f(source[I_NORMAL], AL_DIRECTION, 0.0f, 0.0f, 0.0f);
-    alSourcef(source[I_NORMAL], AL_ROLLOFF_FACTOR, 0.0f);
-    alSourcei(source[I_NORMAL], AL_SOURCE_RELATIVE, AL_TRUE);
-
-    alSource3f(source[I_MUSIC], AL_POSITION, 0.0f, 0.0f, 0.0f);
-    alSource3f(source[I_MUSIC], AL_VELOCITY, 0.0f, 0.0f, 0.0f);
-    alSource3f(source[I_MUSIC], AL_DIRECTION, 0.0f, 0.0f, 0.0f);
-    alSourcef(source[I_MUSIC], AL_ROLLOFF_FACTOR, 0.0f);
-    alSourcei(source[I_MUSIC], AL_SOURCE_RELATIVE, AL_TRUE);
-
-    alSource3f(source[I_WT], AL_POSITION, 0.0f, 0.0f, 0.0f);
-    alSource3f(source[I_WT], AL_VELOCITY, 0.0f, 0.0f, 0.0f);
-    alSource3f(source[I_WT], AL_DIRECTION, 0.0f, 0.0f, 0.0f);
-    alSourcef(source[I_WT], AL_ROLLOFF_FACTOR, 0.0f);
-    alSourcei(source[I_WT], AL_SOURCE_RELATIVE, AL_TRUE);
-
-    alSource3f(source[I_CD], AL_POSITION, 0.0f, 0.0f, 0.0f);
-    alSource3f(source[I_CD], AL_VELOCITY, 0.0f, 0.0f, 0.0f);
-    alSource3f(source[I_CD], AL_DIRECTION, 0.0f, 0.0f, 0.0f);
-    alSourcef(source[I_CD], AL_ROLLOFF_FACTOR, 0.0f);
-    alSourcei(source[I_CD], AL_SOURCE_RELATIVE, AL_TRUE);
-
-    alSource3f(source[I_FDD], AL_POSITION, 0.0f, 0.0f, 0.0f);
-    alSource3f(source[I_FDD], AL_VELOCITY, 0.0f, 0.0f, 0.0f);
-    alSource3f(source[I_FDD], AL_DIRECTION, 0.0f, 0.0f, 0.0f);
-    alSourcef(source[I_FDD], AL_ROLLOFF_FACTOR, 0.0f);
-    alSourcei(source[I_FDD], AL_SOURCE_RELATIVE, AL_TRUE);
-  
-    if (init_midi) {
-        alSource3f(source[I_MIDI], AL_POSITION, 0.0f, 0.0f, 0.0f);
-        alSource3f(source[I_MIDI], AL_VELOCITY, 0.0f, 0.0f, 0.0f);
-        alSource3f(source[I_MIDI], AL_DIRECTION, 0.0f, 0.0f, 0.0f);
-        alSourcef(source[I_MIDI], AL_ROLLOFF_FACTOR, 0.0f);
-        alSourcei(source[I_MIDI], AL_SOURCE_RELATIVE, AL_TRUE);
-    }
-
-    if (sound_is_float) {
-        memset(buf, 0, BUFLEN * 2 * sizeof(float));
-        memset(cd_buf, 0, CD_BUFLEN * 2 * sizeof(float));
-        memset(music_buf, 0, MUSICBUFLEN * 2 * sizeof(float));
-        memset(wt_buf, 0, WTBUFLEN * 2 * sizeof(float));
-        memset(fdd_buf, 0, BUFLEN * 2 * sizeof(float));
-        if (init_midi)
-            memset(midi_buf, 0, midi_buf_size * sizeof(float));
-    } else {
-        memset(buf_int16, 0, BUFLEN * 2 * sizeof(int16_t));
-        memset(cd_buf_int16, 0, CD_BUFLEN * 2 * sizeof(int16_t));
-        memset(music_buf_int16, 0, MUSICBUFLEN * 2 * sizeof(int16_t));
-        memset(wt_buf_int16, 0, WTBUFLEN * 2 * sizeof(int16_t));
-        memset(fdd_buf_int16, 0, BUFLEN * 2 * sizeof(int16_t));
-        if (init_midi)
-            memset(midi_buf_int16, 0, midi_buf_size * sizeof(int16_t));
+    for (int i = 0; i < sources; i++) {
+        alSource3f(source[i], AL_POSITION, 0.0f, 0.0f, 0.0f);
+        alSource3f(source[i], AL_VELOCITY, 0.0f, 0.0f, 0.0f);
+        alSource3f(source[i], AL_DIRECTION, 0.0f, 0.0f, 0.0f);
+        alSourcef(source[i], AL_ROLLOFF_FACTOR, 0.0f);
+        alSourcei(source[i], AL_SOURCE_RELATIVE, AL_TRUE);
     }
 
     for (uint8_t c = 0; c < 4; c++) {
         if (sound_is_float) {
-            alBufferData(buffers[c], AL_FORMAT_STEREO_FLOAT32, buf, BUFLEN * 2 * sizeof(float), FREQ);
-            alBufferData(buffers_music[c], AL_FORMAT_STEREO_FLOAT32, music_buf, MUSICBUFLEN * 2 * sizeof(float), MUSIC_FREQ);
-            alBufferData(buffers_wt[c], AL_FORMAT_STEREO_FLOAT32, wt_buf, WTBUFLEN * 2 * sizeof(float), WT_FREQ);
-            alBufferData(buffers_cd[c], AL_FORMAT_STEREO_FLOAT32, cd_buf, CD_BUFLEN * 2 * sizeof(float), CD_FREQ);
-            alBufferData(buffers_fdd[c], AL_FORMAT_STEREO_FLOAT32, fdd_buf, BUFLEN * 2 * sizeof(float), FREQ);
+            alBufferData(buffers[c], AL_FORMAT_STEREO_FLOAT32, buf, buflen * 2 * sizeof(float), sound_output_freq);
+            alBufferData(buffers_fdd[c], AL_FORMAT_STEREO_FLOAT32, fdd_buf, SOUNDBUFLEN * 2 * sizeof(float), FREQ);
             if (init_midi)
                 alBufferData(buffers_midi[c], AL_FORMAT_STEREO_FLOAT32, midi_buf, midi_buf_size * (int) sizeof(float), midi_freq);
         } else {
-            alBufferData(buffers[c], AL_FORMAT_STEREO16, buf_int16, BUFLEN * 2 * sizeof(int16_t), FREQ);
-            alBufferData(buffers_music[c], AL_FORMAT_STEREO16, music_buf_int16, MUSICBUFLEN * 2 * sizeof(int16_t), MUSIC_FREQ);
-            alBufferData(buffers_wt[c], AL_FORMAT_STEREO16, wt_buf_int16, WTBUFLEN * 2 * sizeof(int16_t), WT_FREQ);
-            alBufferData(buffers_cd[c], AL_FORMAT_STEREO16, cd_buf_int16, CD_BUFLEN * 2 * sizeof(int16_t), CD_FREQ);
-            alBufferData(buffers_fdd[c], AL_FORMAT_STEREO16, fdd_buf_int16, BUFLEN * 2 * sizeof(int16_t), FREQ);
+            alBufferData(buffers[c], AL_FORMAT_STEREO16, buf_int16, buflen * 2 * sizeof(int16_t), sound_output_freq);
+            alBufferData(buffers_fdd[c], AL_FORMAT_STEREO16, fdd_buf_int16, SOUNDBUFLEN * 2 * sizeof(int16_t), FREQ);
             if (init_midi)
                 alBufferData(buffers_midi[c], AL_FORMAT_STEREO16, midi_buf_int16, midi_buf_size * (int) sizeof(int16_t), midi_freq);
         }
     }
 
     alSourceQueueBuffers(source[I_NORMAL], 4, buffers);
-    alSourceQueueBuffers(source[I_MUSIC], 4, buffers_music);
-    alSourceQueueBuffers(source[I_WT], 4, buffers_wt);
-    alSourceQueueBuffers(source[I_CD], 4, buffers_cd);
     alSourceQueueBuffers(source[I_FDD], 4, buffers_fdd);
     if (init_midi)
         alSourceQueueBuffers(source[I_MIDI], 4, buffers_midi);
     alSourcePlay(source[I_NORMAL]);
-    alSourcePlay(source[I_MUSIC]);
-    alSourcePlay(source[I_WT]);
-    alSourcePlay(source[I_CD]);
     alSourcePlay(source[I_FDD]);
     if (init_midi)
         alSourcePlay(source[I_MIDI]);
@@ -275,17 +186,11 @@ inital(void)
     if (sound_is_float) {
         if (init_midi)
             free(midi_buf);
-        free(cd_buf);
-        free(wt_buf);
-        free(music_buf);
         free(buf);
         free(fdd_buf);
     } else {
         if (init_midi)
             free(midi_buf_int16);
-        free(cd_buf_int16);
-        free(wt_buf_int16);
-        free(music_buf_int16);
         free(buf_int16);
         free(fdd_buf_int16);
     }
@@ -328,35 +233,17 @@ givealbuffer_common(const void *buf, const uint8_t src, const int size, const in
 void
 givealbuffer(const void *buf)
 {
-    givealbuffer_common(buf, 0, BUFLEN << 1, FREQ);
-}
-
-void
-givealbuffer_music(const void *buf)
-{
-    givealbuffer_common(buf, 1, MUSICBUFLEN << 1, MUSIC_FREQ);
-}
-
-void
-givealbuffer_wt(const void *buf)
-{
-    givealbuffer_common(buf, 2, WTBUFLEN << 1, WT_FREQ);
-}
-
-void
-givealbuffer_cd(const void *buf)
-{
-    givealbuffer_common(buf, 3, CD_BUFLEN << 1, CD_FREQ);
+    givealbuffer_common(buf, I_NORMAL, SOUND_OUTPUT_BUFLEN << 1, sound_output_freq);
 }
 
 void
 givealbuffer_midi(const void *buf, const uint32_t size)
 {
-    givealbuffer_common(buf, 5, (int) size, midi_freq);
+    givealbuffer_common(buf, I_MIDI, (int) size, midi_freq);
 }
 
 void
 givealbuffer_fdd(const void *buf, const uint32_t size)
 {
-    givealbuffer_common(buf, 4, (int) size, FREQ);
-}
\ No newline at end of file
+    givealbuffer_common(buf, I_FDD, (int) size, FREQ);
+}
@@ -586,6 +586,8 @@ ac97_via_remap_modem_codec(void *priv, uint16_t new_io_base, uint8_t enable)
 static void
 ac97_via_update_stereo(ac97_via_t *dev, ac97_via_sgd_t *sgd)
 {
+    const int pos = sound_get_pos();
+
 #ifdef OLD_CODE
     int32_t l = (((sgd->out_l * sgd->vol_l) >> 15) * dev->master_vol_l) >> 15;
     int32_t r = (((sgd->out_r * sgd->vol_r) >> 15) * dev->master_vol_r) >> 15;
@@ -603,7 +605,7 @@ ac97_via_update_stereo(ac97_via_t *dev, ac97_via_sgd_t *sgd)
     else if (r > 32767)
         r = 32767;
 
-    for (; sgd->pos < sound_pos_global; sgd->pos++) {
+    for (; sgd->pos < pos; sgd->pos++) {
         sgd->buffer[sgd->pos * 2]     = l;
         sgd->buffer[sgd->pos * 2 + 1] = r;
     }
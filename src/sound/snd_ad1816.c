@@ -167,7 +167,9 @@ ad1816_filter_opl(void *priv, double *out_l, double *out_r)
 void
 ad1816_update(ad1816_t *ad1816)
 {
-    for (; ad1816->pos < sound_pos_global; ad1816->pos++) {
+    const int pos = sound_get_pos();
+
+    for (; ad1816->pos < pos; ad1816->pos++) {
         ad1816->buffer[ad1816->pos * 2]     = ad1816->out_l;
         ad1816->buffer[ad1816->pos * 2 + 1] = ad1816->out_r;
     }
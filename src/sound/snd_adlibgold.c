@@ -82,7 +82,7 @@ typedef struct adgold_t {
     int treble;
     int bass;
 
-    int16_t mma_buffer[2][SOUNDBUFLEN];
+    int16_t mma_buffer[2][MUSICBUFLEN];
 
     int pos;
 
@@ -641,10 +641,13 @@ adgold_read(uint16_t addr, void *priv)
     return temp;
 }
 
+/* The card is mixed at the rate of its OPL3, on the music stream, so that the FM is only resampled once, to the output. */
 void
 adgold_update(adgold_t *adgold)
 {
-    for (; adgold->pos < sound_pos_global; adgold->pos++) {
+    const int pos = music_get_pos();
+
+    for (; adgold->pos < pos; adgold->pos++) {
         adgold->mma_buffer[0][adgold->pos] = adgold->mma_buffer[1][adgold->pos] = 0;
 
         if (adgold->adgold_mma_regs[0][9] & 0x20)
@@ -957,7 +960,7 @@ adgold_init(UNUSED(const device_t *info))
     adgold->surround_enabled = device_get_config_int("surround");
     adgold->gameport_enabled = device_get_config_int("gameport");
 
-    fm_driver_get_ex(FM_YMF262, &adgold->opl, 1);
+    fm_driver_get(FM_YMF262, &adgold->opl);
     if (adgold->surround_enabled)
         ym7128_init(&adgold->ym7128);
 
@@ -1047,7 +1050,7 @@ adgold_init(UNUSED(const device_t *info))
 
     timer_add(&adgold->adgold_mma_timer_count, adgold_timer_poll, adgold, 1);
 
-    sound_add_handler(adgold_get_buffer, adgold);
+    music_add_handler(adgold_get_buffer, adgold);
 
     sound_set_cd_audio_filter(adgold_filter_cd_audio, adgold);
 
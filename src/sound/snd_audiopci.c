@@ -2362,6 +2362,7 @@ es137x_update(es137x_t *dev)
 {
     int32_t l;
     int32_t r;
+    int     pos;
 
     if (dev->type == AUDIOPCI_ES1370) {
         l = dev->dac[0].out_l * (((dev->akm_codec.registers[0x4] & 0x80) ? 0 : akm4531_gain_2dbstep_5bits[(dev->akm_codec.registers[0x4] & 0x1f)]) / 32767.0);
@@ -2397,7 +2398,8 @@ es137x_update(es137x_t *dev)
     else if (r > 32767)
         r = 32767;
 
-    for (; dev->pos < ((dev->type == AUDIOPCI_ES1370) ? wavetable_pos_global : sound_pos_global); dev->pos++) {
+    pos = (dev->type == AUDIOPCI_ES1370) ? wavetable_get_pos() : sound_get_pos();
+    for (; dev->pos < pos; dev->pos++) {
         dev->buffer[dev->pos * 2]     = l;
         dev->buffer[dev->pos * 2 + 1] = r;
     }
@@ -1041,8 +1041,9 @@ cmi8x38_update(cmi8x38_t *dev, cmi8x38_dma_t *dma)
     const sb_ct1745_mixer_t *mixer = &dev->sb->mixer_sb16;
     int32_t                  l     = (dma->out_fl * mixer->voice_l) * mixer->master_l;
     int32_t                  r     = (dma->out_fr * mixer->voice_r) * mixer->master_r;
+    const int                pos   = sound_get_pos();
 
-    for (; dma->pos < sound_pos_global; dma->pos++) {
+    for (; dma->pos < pos; dma->pos++) {
         dma->buffer[dma->pos * 2]     = l;
         dma->buffer[dma->pos * 2 + 1] = r;
     }
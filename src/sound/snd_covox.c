@@ -67,7 +67,9 @@ typedef struct covox_s {
 static void
 covox_update(covox_t *covox)
 {
-    for (; covox->pos < sound_pos_global; covox->pos++) {
+    const int pos = sound_get_pos();
+
+    for (; covox->pos < pos; covox->pos++) {
         covox->buffer[0][covox->pos] = (int8_t) (covox->dac_val ^ 0x80) * 0x40;
         covox->buffer[1][covox->pos] = (int8_t) (covox->dac_val ^ 0x80) * 0x40;
     }
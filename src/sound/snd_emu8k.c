@@ -40,6 +40,17 @@
 #define EMU8K_DEBUG_REGISTERS
 #endif
 
+#if defined(__x86_64__) || defined(_M_X64)
+#    define EMU8K_SSE2
+#    include <emmintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#    define EMU8K_NEON
+#    include <arm_neon.h>
+#endif
+
+/* Samples processed per pass by the voice and effect stages. */
+#define EMU8K_BLOCK 64
+
 char *PORT_NAMES[][8] = {
     /* Data 0 ( 0x620/0x622) */
     {
@@ -1554,62 +1565,83 @@ emu8k_outb(uint16_t addr, uint8_t val, void *priv)
 void
 emu8k_work_chorus(int32_t *inbuf, int32_t *outbuf, emu8k_chorus_eng_t *engine, int count)
 {
-    for (int pos = 0; pos < count; pos++) {
-        double lfo_inter1 = chortable[engine->lfo_pos.int_address];
+    double offset_lfo[EMU8K_BLOCK];
+    int    fraction_part[EMU8K_BLOCK];
+
+    /* The LFO does not depend on the signal, so each block runs it first and then each channel in turn. */
+    for (int base = 0; base < count; base += EMU8K_BLOCK) {
+        const int n = ((count - base) < EMU8K_BLOCK) ? (count - base) : EMU8K_BLOCK;
+        int       write;
+
+        for (int pos = 0; pos < n; pos++) {
+            double lfo_inter1 = chortable[engine->lfo_pos.int_address];
 #if 0
-        double lfo_inter2 = chortable[(engine->lfo_pos.int_address+1)&0xFFFF];
+            double lfo_inter2 = chortable[(engine->lfo_pos.int_address+1)&0xFFFF];
 #endif
 
-        double offset_lfo = lfo_inter1; //= lfo_inter1 + ((lfo_inter2-lfo_inter1)*engine->lfo_pos.fract_address/65536.0);
-        offset_lfo *= engine->lfodepth_multip;
+            offset_lfo[pos] = lfo_inter1; //= lfo_inter1 + ((lfo_inter2-lfo_inter1)*engine->lfo_pos.fract_address/65536.0);
+            offset_lfo[pos] *= engine->lfodepth_multip;
 
-        /* Work left */
-        double readdouble    = (double) engine->write - (double) engine->delay_samples_central - offset_lfo;
-        int    read          = (int32_t) floor(readdouble);
-        int    fraction_part = (readdouble - (double) read) * 65536.0;
-        int    next_value    = read + 1;
-        if (read < 0) {
-            read += EMU8K_LFOCHORUS_SIZE;
-            if (next_value < 0)
-                next_value += EMU8K_LFOCHORUS_SIZE;
-        } else if (next_value >= EMU8K_LFOCHORUS_SIZE) {
-            next_value -= EMU8K_LFOCHORUS_SIZE;
-            if (read >= EMU8K_LFOCHORUS_SIZE)
-                read -= EMU8K_LFOCHORUS_SIZE;
+            engine->lfo_pos.addr += engine->lfo_inc.addr;
+            engine->lfo_pos.int_address &= 0xFFFF;
         }
-        int32_t dat1 = engine->chorus_left_buffer[read];
-        int32_t dat2 = engine->chorus_left_buffer[next_value];
-        dat1 += ((dat2 - dat1) * fraction_part) >> 16;
-
-        engine->chorus_left_buffer[engine->write] = *inbuf + ((dat1 * engine->feedback) >> 8);
-
-        /* Work right */
-        readdouble = (double) engine->write - (double) engine->delay_samples_central - engine->delay_offset_samples_right - offset_lfo;
-        read       = (int32_t) floor(readdouble);
-        next_value = read + 1;
-        if (read < 0) {
-            read += EMU8K_LFOCHORUS_SIZE;
-            if (next_value < 0)
-                next_value += EMU8K_LFOCHORUS_SIZE;
-        } else if (next_value >= EMU8K_LFOCHORUS_SIZE) {
-            next_value -= EMU8K_LFOCHORUS_SIZE;
-            if (read >= EMU8K_LFOCHORUS_SIZE)
-                read -= EMU8K_LFOCHORUS_SIZE;
+
+        /* Work left */
+        write = engine->write;
+        for (int pos = 0; pos < n; pos++) {
+            double readdouble  = (double) write - (double) engine->delay_samples_central - offset_lfo[pos];
+            int    read        = (int32_t) floor(readdouble);
+            int    next_value  = read + 1;
+            fraction_part[pos] = (readdouble - (double) read) * 65536.0;
+            if (read < 0) {
+                read += EMU8K_LFOCHORUS_SIZE;
+                if (next_value < 0)
+                    next_value += EMU8K_LFOCHORUS_SIZE;
+            } else if (next_value >= EMU8K_LFOCHORUS_SIZE) {
+                next_value -= EMU8K_LFOCHORUS_SIZE;
+                if (read >= EMU8K_LFOCHORUS_SIZE)
+                    read -= EMU8K_LFOCHORUS_SIZE;
+            }
+            int32_t dat1 = engine->chorus_left_buffer[read];
+            int32_t dat2 = engine->chorus_left_buffer[next_value];
+            dat1 += ((dat2 - dat1) * fraction_part[pos]) >> 16;
+
+            engine->chorus_left_buffer[write] = inbuf[pos] + ((dat1 * engine->feedback) >> 8);
+            outbuf[pos * 2] += dat1;
+
+            if (++write >= EMU8K_LFOCHORUS_SIZE)
+                write = 0;
         }
-        int32_t dat3 = engine->chorus_right_buffer[read];
-        int32_t dat4 = engine->chorus_right_buffer[next_value];
-        dat3 += ((dat4 - dat3) * fraction_part) >> 16;
 
-        engine->chorus_right_buffer[engine->write] = *inbuf + ((dat3 * engine->feedback) >> 8);
+        /* Work right (with the interpolation fraction of the left side) */
+        write = engine->write;
+        for (int pos = 0; pos < n; pos++) {
+            double readdouble = (double) write - (double) engine->delay_samples_central - engine->delay_offset_samples_right - offset_lfo[pos];
+            int    read       = (int32_t) floor(readdouble);
+            int    next_value = read + 1;
+            if (read < 0) {
+                read += EMU8K_LFOCHORUS_SIZE;
+                if (next_value < 0)
+                    next_value += EMU8K_LFOCHORUS_SIZE;
+            } else if (next_value >= EMU8K_LFOCHORUS_SIZE) {
+                next_value -= EMU8K_LFOCHORUS_SIZE;
+                if (read >= EMU8K_LFOCHORUS_SIZE)
+                    read -= EMU8K_LFOCHORUS_SIZE;
+            }
+            int32_t dat3 = engine->chorus_right_buffer[read];
+            int32_t dat4 = engine->chorus_right_buffer[next_value];
+            dat3 += ((dat4 - dat3) * fraction_part[pos]) >> 16;
 
-        ++engine->write;
-        engine->write %= EMU8K_LFOCHORUS_SIZE;
-        engine->lfo_pos.addr += engine->lfo_inc.addr;
-        engine->lfo_pos.int_address &= 0xFFFF;
+            engine->chorus_right_buffer[write] = inbuf[pos] + ((dat3 * engine->feedback) >> 8);
+            outbuf[pos * 2 + 1] += dat3;
 
-        (*outbuf++) += dat1;
-        (*outbuf++) += dat3;
-        inbuf++;
+            if (++write >= EMU8K_LFOCHORUS_SIZE)
+                write = 0;
+        }
+
+        engine->write = write;
+        inbuf += n;
+        outbuf += n * 2;
     }
 }
 
@@ -1679,53 +1711,132 @@ emu8k_reverb_damper_work(emu8k_reverb_combfilter_t *comb, int32_t in)
     return comb->filterstore;
 }
 
+#if defined EMU8K_SSE2
+/*
+   The six reflection combs over a block, side by side: combs 0-3 in the
+   lanes of one vector and 4-5 in the low lanes of another. Each lane does
+   the float arithmetic of emu8k_reverb_comb_work() in the same order, so
+   the result is identical; only the delay line reads and writes are done
+   one comb at a time. Combs 2 and 4 go to dat1 and the rest to dat2 with
+   link_return_type set, otherwise all six go to dat1.
+ */
+static void
+emu8k_reverb_combs_block(emu8k_reverb_eng_t *engine, const int32_t *in, int32_t *dat1, int32_t *dat2, int count)
+{
+    emu8k_reverb_combfilter_t *comb = engine->reflections;
+    const __m128               damp1[2]    = { _mm_setr_ps(comb[0].damp1, comb[1].damp1, comb[2].damp1, comb[3].damp1),
+                                               _mm_setr_ps(comb[4].damp1, comb[5].damp1, 0.0f, 0.0f) };
+    const __m128               damp2[2]    = { _mm_setr_ps(comb[0].damp2, comb[1].damp2, comb[2].damp2, comb[3].damp2),
+                                               _mm_setr_ps(comb[4].damp2, comb[5].damp2, 0.0f, 0.0f) };
+    const __m128               feedback[2] = { _mm_setr_ps(comb[0].feedback, comb[1].feedback, comb[2].feedback, comb[3].feedback),
+                                               _mm_setr_ps(comb[4].feedback, comb[5].feedback, 0.0f, 0.0f) };
+    const __m128               gain[2]     = { _mm_setr_ps(comb[0].output_gain, comb[1].output_gain, comb[2].output_gain, comb[3].output_gain),
+                                               _mm_setr_ps(comb[4].output_gain, comb[5].output_gain, 0.0f, 0.0f) };
+    __m128i                    store[2]    = { _mm_setr_epi32(comb[0].filterstore, comb[1].filterstore, comb[2].filterstore, comb[3].filterstore),
+                                               _mm_setr_epi32(comb[4].filterstore, comb[5].filterstore, 0, 0) };
+    int                        read_pos[6];
+    int32_t                    out[8];
+    int32_t                    bufin[8];
+
+    for (uint8_t c = 0; c < 6; c++)
+        read_pos[c] = comb[c].read_pos;
+
+    for (int pos = 0; pos < count; pos++) {
+        const __m128 in_f = _mm_cvtepi32_ps(_mm_set1_epi32(in[pos]));
+        __m128i      echo[2];
+
+        echo[0] = _mm_setr_epi32(comb[0].reflection[read_pos[0]], comb[1].reflection[read_pos[1]],
+                                 comb[2].reflection[read_pos[2]], comb[3].reflection[read_pos[3]]);
+        echo[1] = _mm_setr_epi32(comb[4].reflection[read_pos[4]], comb[5].reflection[read_pos[5]], 0, 0);
+
+        for (uint8_t v = 0; v < 2; v++) {
+            const __m128 echo_f = _mm_cvtepi32_ps(echo[v]);
+
+            /* filterstore = (output * damp2) + (filterstore * damp1) */
+            store[v] = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(echo_f, damp2[v]), _mm_mul_ps(_mm_cvtepi32_ps(store[v]), damp1[v])));
+            /* bufin = in - (filterstore * feedback) */
+            _mm_storeu_si128((__m128i *) &bufin[v * 4], _mm_cvttps_epi32(_mm_sub_ps(in_f, _mm_mul_ps(_mm_cvtepi32_ps(store[v]), feedback[v]))));
+            _mm_storeu_si128((__m128i *) &out[v * 4], _mm_cvttps_epi32(_mm_mul_ps(echo_f, gain[v])));
+        }
+
+        for (uint8_t c = 0; c < 6; c++) {
+            comb[c].reflection[read_pos[c]] = bufin[c];
+            if (++read_pos[c] >= comb[c].bufsize)
+                read_pos[c] = 0;
+        }
+
+        if (engine->link_return_type) {
+            dat1[pos] += out[2] + out[4];
+            dat2[pos] += out[0] + out[1] + out[3] + out[5];
+        } else
+            dat1[pos] += out[0] + out[1] + out[2] + out[3] + out[4] + out[5];
+    }
+
+    _mm_storeu_si128((__m128i *) &out[0], store[0]);
+    _mm_storeu_si128((__m128i *) &out[4], store[1]);
+    for (uint8_t c = 0; c < 6; c++) {
+        comb[c].read_pos    = read_pos[c];
+        comb[c].filterstore = out[c];
+    }
+}
+#else
+/* Runs one comb filter over a block, adding its output to acc. */
+static void
+emu8k_reverb_comb_block(emu8k_reverb_combfilter_t *comb, const int32_t *in, int32_t *acc, int count)
+{
+    for (int pos = 0; pos < count; pos++)
+        acc[pos] += emu8k_reverb_comb_work(comb, in[pos]);
+}
+#endif
+
 /* TODO: This is not a correct emulation, just a workalike implementation. */
 void
 emu8k_work_reverb(int32_t *inbuf, int32_t *outbuf, emu8k_reverb_eng_t *engine, int count)
 {
-    int pos;
-    if (engine->link_return_type) {
-        for (pos = 0; pos < count; pos++) {
-            int32_t dat1;
-            int32_t dat2;
-            int32_t in;
-            int32_t in2;
-            in   = emu8k_reverb_damper_work(&engine->damper, inbuf[pos]);
-            in2  = (in * engine->refl_in_amp) >> 8;
-            dat2 = emu8k_reverb_comb_work(&engine->reflections[0], in2);
-            dat2 += emu8k_reverb_comb_work(&engine->reflections[1], in2);
-            dat1 = emu8k_reverb_comb_work(&engine->reflections[2], in2);
-            dat2 += emu8k_reverb_comb_work(&engine->reflections[3], in2);
-            dat1 += emu8k_reverb_comb_work(&engine->reflections[4], in2);
-            dat2 += emu8k_reverb_comb_work(&engine->reflections[5], in2);
-
-            dat1 += (emu8k_reverb_tail_work(&engine->tailL, &engine->allpass[0], in + dat1) * engine->link_return_amp) >> 8;
-            dat2 += (emu8k_reverb_tail_work(&engine->tailR, &engine->allpass[4], in + dat2) * engine->link_return_amp) >> 8;
-
-            (*outbuf++) += (dat1 * engine->out_mix) >> 8;
-            (*outbuf++) += (dat2 * engine->out_mix) >> 8;
+    int32_t in[EMU8K_BLOCK];
+    int32_t in2[EMU8K_BLOCK];
+    int32_t dat1[EMU8K_BLOCK];
+    int32_t dat2[EMU8K_BLOCK];
+
+    /* Each filter keeps its own state, so a block is run through one filter at a time. */
+    for (int base = 0; base < count; base += EMU8K_BLOCK) {
+        const int n = ((count - base) < EMU8K_BLOCK) ? (count - base) : EMU8K_BLOCK;
+        int       pos;
+
+        for (pos = 0; pos < n; pos++) {
+            in[pos]  = emu8k_reverb_damper_work(&engine->damper, inbuf[base + pos]);
+            in2[pos] = (in[pos] * engine->refl_in_amp) >> 8;
         }
-    } else {
-        for (pos = 0; pos < count; pos++) {
-            int32_t dat1;
-            int32_t dat2;
-            int32_t in;
-            int32_t in2;
-            in   = emu8k_reverb_damper_work(&engine->damper, inbuf[pos]);
-            in2  = (in * engine->refl_in_amp) >> 8;
-            dat1 = emu8k_reverb_comb_work(&engine->reflections[0], in2);
-            dat1 += emu8k_reverb_comb_work(&engine->reflections[1], in2);
-            dat1 += emu8k_reverb_comb_work(&engine->reflections[2], in2);
-            dat1 += emu8k_reverb_comb_work(&engine->reflections[3], in2);
-            dat1 += emu8k_reverb_comb_work(&engine->reflections[4], in2);
-            dat1 += emu8k_reverb_comb_work(&engine->reflections[5], in2);
-            dat2 = dat1;
-
-            dat1 += (emu8k_reverb_tail_work(&engine->tailL, &engine->allpass[0], in + dat1) * engine->link_return_amp) >> 8;
-            dat2 += (emu8k_reverb_tail_work(&engine->tailR, &engine->allpass[4], in + dat2) * engine->link_return_amp) >> 8;
-
-            (*outbuf++) += (dat1 * engine->out_mix) >> 8;
-            (*outbuf++) += (dat2 * engine->out_mix) >> 8;
+
+        memset(dat1, 0, n * sizeof(int32_t));
+        memset(dat2, 0, n * sizeof(int32_t));
+#if defined EMU8K_SSE2
+        emu8k_reverb_combs_block(engine, in2, dat1, dat2, n);
+        if (!engine->link_return_type)
+            memcpy(dat2, dat1, n * sizeof(int32_t));
+#else
+        if (engine->link_return_type) {
+            emu8k_reverb_comb_block(&engine->reflections[0], in2, dat2, n);
+            emu8k_reverb_comb_block(&engine->reflections[1], in2, dat2, n);
+            emu8k_reverb_comb_block(&engine->reflections[2], in2, dat1, n);
+            emu8k_reverb_comb_block(&engine->reflections[3], in2, dat2, n);
+            emu8k_reverb_comb_block(&engine->reflections[4], in2, dat1, n);
+            emu8k_reverb_comb_block(&engine->reflections[5], in2, dat2, n);
+        } else {
+            for (uint8_t c = 0; c < 6; c++)
+                emu8k_reverb_comb_block(&engine->reflections[c], in2, dat1, n);
+            memcpy(dat2, dat1, n * sizeof(int32_t));
+        }
+#endif
+
+        for (pos = 0; pos < n; pos++)
+            dat1[pos] += (emu8k_reverb_tail_work(&engine->tailL, &engine->allpass[0], in[pos] + dat1[pos]) * engine->link_return_amp) >> 8;
+        for (pos = 0; pos < n; pos++)
+            dat2[pos] += (emu8k_reverb_tail_work(&engine->tailR, &engine->allpass[4], in[pos] + dat2[pos]) * engine->link_return_amp) >> 8;
+
+        for (pos = 0; pos < n; pos++) {
+            (*outbuf++) += (dat1[pos] * engine->out_mix) >> 8;
+            (*outbuf++) += (dat2[pos] * engine->out_mix) >> 8;
         }
     }
 }
@@ -1755,352 +1866,518 @@ int32_t old_pitch[32] = { 0 };
 int32_t old_cut[32]   = { 0 };
 int32_t old_vol[32]   = { 0 };
 #endif
-void
-emu8k_update(emu8k_t *emu8k)
+
+/*
+ * The voices are rendered a block at a time. The envelopes, LFOs and
+ * oscillator position of a voice do not depend on its audio, so they are
+ * run first and the per-sample values the audio needs are staged in
+ * arrays; the interpolation, filter and volume stages then each run over
+ * the whole block, the interpolation and volume/pan four samples at a
+ * time with SSE2 or NEON.
+ */
+typedef struct emu8k_stage_t {
+    uint32_t addr[EMU8K_BLOCK];
+    uint16_t fract[EMU8K_BLOCK];
+    uint16_t volume[EMU8K_BLOCK];
+    uint16_t ctoff[EMU8K_BLOCK];
+    int32_t  dat[EMU8K_BLOCK];
+} emu8k_stage_t;
+
+static void
+emu8k_voice_envelope(emu8k_voice_t *emu_voice)
 {
-    if (emu8k->pos >= wavetable_pos_global)
-        return;
+    int32_t attenuation  = emu_voice->initial_att;
+    int32_t filtercut    = emu_voice->initial_filter;
+    int32_t currentpitch = emu_voice->ip;
+    /* run envelopes */
+    emu8k_envelope_t *volenv = &emu_voice->vol_envelope;
+    switch (volenv->state) {
+        case ENV_DELAY:
+            volenv->delay_samples--;
+            if (volenv->delay_samples <= 0) {
+                volenv->state         = ENV_ATTACK;
+                volenv->delay_samples = 0;
+            }
+            attenuation = 0x1FFFFF;
+            break;
 
-    int32_t       *buf;
-    emu8k_voice_t *emu_voice;
-    int            pos;
+        case ENV_ATTACK:
+            /* Attack amount is in linear amplitude */
+            volenv->value_amp_hz += volenv->attack_amount_amp_hz;
+            if (volenv->value_amp_hz >= (1 << 21)) {
+                volenv->value_amp_hz = 1 << 21;
+                volenv->value_db_oct = 0;
+                if (volenv->hold_samples) {
+                    volenv->state = ENV_HOLD;
+                } else {
+                    /* RAMP_UP since db value is inverted and it is 0 at this point. */
+                    volenv->state = ENV_RAMP_UP;
+                }
+            }
+            attenuation += env_vol_amplitude_to_db[volenv->value_amp_hz >> 5] << 5;
+            break;
 
-    /* Clean the buffers since we will accumulate into them. */
-    buf = &emu8k->buffer[emu8k->pos * 2];
-    memset(buf, 0, 2 * (wavetable_pos_global - emu8k->pos) * sizeof(emu8k->buffer[0]));
-    memset(&emu8k->chorus_in_buffer[emu8k->pos], 0, (wavetable_pos_global - emu8k->pos) * sizeof(emu8k->chorus_in_buffer[0]));
-    memset(&emu8k->reverb_in_buffer[emu8k->pos], 0, (wavetable_pos_global - emu8k->pos) * sizeof(emu8k->reverb_in_buffer[0]));
+        case ENV_HOLD:
+            volenv->hold_samples--;
+            if (volenv->hold_samples <= 0) {
+                volenv->state = ENV_RAMP_UP;
+            }
+            attenuation += volenv->value_db_oct;
+            break;
 
-    /* Voices section  */
-    for (uint8_t c = 0; c < 32; c++) {
-        emu_voice = &emu8k->voice[c];
-        buf       = &emu8k->buffer[emu8k->pos * 2];
+        case ENV_RAMP_DOWN:
+            /* Decay/release amount is in fraction of dBs and is always positive */
+            volenv->value_db_oct -= volenv->ramp_amount_db_oct;
+            if (volenv->value_db_oct <= volenv->sustain_value_db_oct) {
+                volenv->value_db_oct = volenv->sustain_value_db_oct;
+                volenv->state        = ENV_SUSTAIN;
+            }
+            attenuation += volenv->value_db_oct;
+            break;
 
-        for (pos = emu8k->pos; pos < wavetable_pos_global; pos++) {
-            int32_t dat;
+        case ENV_RAMP_UP:
+            /* Decay/release amount is in fraction of dBs and is always positive */
+            volenv->value_db_oct += volenv->ramp_amount_db_oct;
+            if (volenv->value_db_oct >= volenv->sustain_value_db_oct) {
+                volenv->value_db_oct = volenv->sustain_value_db_oct;
+                volenv->state        = ENV_SUSTAIN;
+            }
+            attenuation += volenv->value_db_oct;
+            break;
 
-            if (emu_voice->cvcf_curr_volume) {
-                /* Waveform oscillator */
-#ifdef RESAMPLER_LINEAR
-                dat = EMU8K_READ_INTERP_LINEAR(emu8k, emu_voice->addr.int_address,
-                                               emu_voice->addr.fract_address);
+        case ENV_SUSTAIN:
+            attenuation += volenv->value_db_oct;
+            break;
+
+        case ENV_STOPPED:
+            attenuation = 0x1FFFFF;
+            break;
+
+        default:
+            break;
+    }
+
+    emu8k_envelope_t *modenv = &emu_voice->mod_envelope;
+    switch (modenv->state) {
+        case ENV_DELAY:
+            modenv->delay_samples--;
+            if (modenv->delay_samples <= 0) {
+                modenv->state         = ENV_ATTACK;
+                modenv->delay_samples = 0;
+            }
+            break;
+
+        case ENV_ATTACK:
+            /* Attack amount is in linear amplitude */
+            modenv->value_amp_hz += modenv->attack_amount_amp_hz;
+            modenv->value_db_oct = env_mod_hertz_to_octave[modenv->value_amp_hz >> 5] << 5;
+            if (modenv->value_amp_hz >= (1 << 21)) {
+                modenv->value_amp_hz = 1 << 21;
+                modenv->value_db_oct = 1 << 21;
+                if (modenv->hold_samples) {
+                    modenv->state = ENV_HOLD;
+                } else {
+                    modenv->state = ENV_RAMP_DOWN;
+                }
+            }
+            break;
+
+        case ENV_HOLD:
+            modenv->hold_samples--;
+            if (modenv->hold_samples <= 0) {
+                modenv->state = ENV_RAMP_UP;
+            }
+            break;
+
+        case ENV_RAMP_DOWN:
+            /* Decay/release amount is in fraction of octave and is always positive */
+            modenv->value_db_oct -= modenv->ramp_amount_db_oct;
+            if (modenv->value_db_oct <= modenv->sustain_value_db_oct) {
+                modenv->value_db_oct = modenv->sustain_value_db_oct;
+                modenv->state        = ENV_SUSTAIN;
+            }
+            break;
 
+        case ENV_RAMP_UP:
+            /* Decay/release amount is in fraction of octave and is always positive */
+            modenv->value_db_oct += modenv->ramp_amount_db_oct;
+            if (modenv->value_db_oct >= modenv->sustain_value_db_oct) {
+                modenv->value_db_oct = modenv->sustain_value_db_oct;
+                modenv->state        = ENV_SUSTAIN;
+            }
+            break;
+
+        default:
+            break;
+    }
+
+    /* run lfos */
+    if (emu_voice->lfo1_delay_samples) {
+        emu_voice->lfo1_delay_samples--;
+    } else {
+        emu_voice->lfo1_count.addr += emu_voice->lfo1_speed;
+        emu_voice->lfo1_count.int_address &= 0xFFFF;
+    }
+    if (emu_voice->lfo2_delay_samples) {
+        emu_voice->lfo2_delay_samples--;
+    } else {
+        emu_voice->lfo2_count.addr += emu_voice->lfo2_speed;
+        emu_voice->lfo2_count.int_address &= 0xFFFF;
+    }
+
+    if (emu_voice->fixed_modenv_pitch_height) {
+        /* modenv range 1<<21, pitch height range 1<<14 desired range 0x1000 (+/-one octave) */
+        currentpitch += ((modenv->value_db_oct >> 9) * emu_voice->fixed_modenv_pitch_height) >> 14;
+    }
+
+    if (emu_voice->fixed_lfo1_vibrato) {
+        /* table range 1<<15, pitch mod range 1<<14 desired range 0x1000 (+/-one octave) */
+        int32_t lfo1_vibrato = (lfotable[emu_voice->lfo1_count.int_address] * emu_voice->fixed_lfo1_vibrato) >> 17;
+        currentpitch += lfo1_vibrato;
+    }
+    if (emu_voice->fixed_lfo2_vibrato) {
+        /* table range 1<<15, pitch mod range 1<<14 desired range 0x1000 (+/-one octave) */
+        int32_t lfo2_vibrato = (lfotable[emu_voice->lfo2_count.int_address] * emu_voice->fixed_lfo2_vibrato) >> 17;
+        currentpitch += lfo2_vibrato;
+    }
+
+    if (emu_voice->fixed_modenv_filter_height) {
+        /* modenv range 1<<21, pitch height range 1<<14 desired range 0x200000 (+/-full filter range) */
+        filtercut += ((modenv->value_db_oct >> 9) * emu_voice->fixed_modenv_filter_height) >> 5;
+    }
+
+    if (emu_voice->fixed_lfo1_filt_mod) {
+        /* table range 1<<15, pitch mod range 1<<14 desired range 0x100000 (+/-three octaves) */
+        int32_t lfo1_filtmod = (lfotable[emu_voice->lfo1_count.int_address] * emu_voice->fixed_lfo1_filt_mod) >> 9;
+        filtercut += lfo1_filtmod;
+    }
+
+    if (emu_voice->fixed_lfo1_tremolo) {
+        /* table range 1<<15, pitch mod range 1<<14 desired range 0x40000 (+/-12dBs). */
+        int32_t lfo1_tremolo = (lfotable[emu_voice->lfo1_count.int_address] * emu_voice->fixed_lfo1_tremolo) >> 11;
+        attenuation += lfo1_tremolo;
+    }
+
+    if (currentpitch > 0xFFFF)
+        currentpitch = 0xFFFF;
+    if (currentpitch < 0)
+        currentpitch = 0;
+    if (attenuation > 0x1FFFFF)
+        attenuation = 0x1FFFFF;
+    if (attenuation < 0)
+        attenuation = 0;
+    if (filtercut > 0x1FFFFF)
+        filtercut = 0x1FFFFF;
+    if (filtercut < 0)
+        filtercut = 0;
+
+    emu_voice->vtft_vol_target    = env_vol_db_to_vol_target[attenuation >> 5];
+    emu_voice->vtft_filter_target = filtercut >> 5;
+    emu_voice->ptrx_pit_target    = freqtable[currentpitch] >> 18;
+}
+
+/* Advances a voice by count samples, staging its position, volume and cutoff; returns 0 if it is silent throughout. */
+static int
+emu8k_voice_control(emu8k_voice_t *emu_voice, emu8k_stage_t *stage, int count)
+{
+    int active = 0;
+
+    for (int pos = 0; pos < count; pos++) {
+        stage->addr[pos]   = emu_voice->addr.int_address;
+        stage->fract[pos]  = emu_voice->addr.fract_address;
+        stage->volume[pos] = emu_voice->cvcf_curr_volume;
+        stage->ctoff[pos]  = emu_voice->cvcf_curr_filt_ctoff;
+        active |= emu_voice->cvcf_curr_volume;
+
+        if (emu_voice->env_engine_on)
+            emu8k_voice_envelope(emu_voice);
+
+        /*
+        I've recopilated these sentences to get an idea of how to loop
+
+        - Set its PSST register and its CLS register to zero to cause no loops to occur.
+        -Setting the Loop Start Offset and the Loop End Offset to the same value, will cause the oscillator to loop the entire memory.
+
+        -Setting the PlayPosition greater than the Loop End Offset, will cause the oscillator to play in reverse, back to the Loop End Offset.
+           It's pretty neat, but appears to be uncontrollable (the rate at which the samples are played in reverse).
+
+        -Note that due to interpolator offset, the actual loop point is one greater than the start address
+        -Note that due to interpolator offset, the actual loop point will end at an address one greater than the loop address
+        -Note that the actual audio location is the point 1 word higher than this value due to interpolation offset
+        -In programs that use the awe, they generally set the loop address as "loopaddress -1" to compensate for the above.
+        (Note: I am already using address+1 in the interpolators so these things are already as they should.)
+        */
+        emu_voice->addr.addr += ((uint64_t) emu_voice->cpf_curr_pitch) << 18;
+        if (emu_voice->addr.addr >= emu_voice->loop_end.addr) {
+            emu_voice->addr.int_address -= (emu_voice->loop_end.int_address - emu_voice->loop_start.int_address);
+            emu_voice->addr.int_address &= EMU8K_MEM_ADDRESS_MASK;
+        }
+
+        /* TODO: How and when are the target and current values updated */
+        emu_voice->cpf_curr_pitch       = emu_voice->ptrx_pit_target;
+        emu_voice->cvcf_curr_volume     = emu8k_vol_slide(&emu_voice->volumeslide, emu_voice->vtft_vol_target);
+        emu_voice->cvcf_curr_filt_ctoff = emu_voice->vtft_filter_target;
+    }
+
+    return active;
+}
+
+/* Waveform oscillator */
+static void
+emu8k_voice_interp(emu8k_t *emu8k, emu8k_stage_t *stage, int count)
+{
+    int pos = 0;
+
+#if defined RESAMPLER_CUBIC && (defined EMU8K_SSE2 || defined EMU8K_NEON)
+    /* Same products and sums, in the same order, as EMU8K_READ_INTERP_CUBIC(). */
+    for (; pos <= (count - 4); pos += 4) {
+        int32_t      tap[4][4];
+        const float *table[4];
+
+        for (uint8_t c = 0; c < 4; c++) {
+            const uint32_t addr = stage->addr[pos + c];
+
+            table[c]  = &cubic_table[(stage->fract[pos + c] >> (16 - CUBIC_RESOLUTION_LOG)) << 2];
+            tap[0][c] = EMU8K_READ(emu8k, addr);
+            tap[1][c] = EMU8K_READ(emu8k, addr + 1);
+            tap[2][c] = EMU8K_READ(emu8k, addr + 2);
+            tap[3][c] = EMU8K_READ(emu8k, addr + 3);
+        }
+
+#    if defined EMU8K_SSE2
+        __m128 t0 = _mm_loadu_ps(table[0]);
+        __m128 t1 = _mm_loadu_ps(table[1]);
+        __m128 t2 = _mm_loadu_ps(table[2]);
+        __m128 t3 = _mm_loadu_ps(table[3]);
+        __m128 dat;
+
+        _MM_TRANSPOSE4_PS(t0, t1, t2, t3);
+        dat = _mm_mul_ps(_mm_cvtepi32_ps(_mm_loadu_si128((const __m128i *) tap[0])), t0);
+        dat = _mm_add_ps(dat, _mm_mul_ps(_mm_cvtepi32_ps(_mm_loadu_si128((const __m128i *) tap[1])), t1));
+        dat = _mm_add_ps(dat, _mm_mul_ps(_mm_cvtepi32_ps(_mm_loadu_si128((const __m128i *) tap[2])), t2));
+        dat = _mm_add_ps(dat, _mm_mul_ps(_mm_cvtepi32_ps(_mm_loadu_si128((const __m128i *) tap[3])), t3));
+        _mm_storeu_si128((__m128i *) &stage->dat[pos], _mm_cvttps_epi32(dat));
+#    else
+        const float32x4x2_t t01 = vtrnq_f32(vld1q_f32(table[0]), vld1q_f32(table[1]));
+        const float32x4x2_t t23 = vtrnq_f32(vld1q_f32(table[2]), vld1q_f32(table[3]));
+        float32x4_t         dat;
+
+        dat = vmulq_f32(vcvtq_f32_s32(vld1q_s32(tap[0])), vcombine_f32(vget_low_f32(t01.val[0]), vget_low_f32(t23.val[0])));
+        dat = vaddq_f32(dat, vmulq_f32(vcvtq_f32_s32(vld1q_s32(tap[1])), vcombine_f32(vget_low_f32(t01.val[1]), vget_low_f32(t23.val[1]))));
+        dat = vaddq_f32(dat, vmulq_f32(vcvtq_f32_s32(vld1q_s32(tap[2])), vcombine_f32(vget_high_f32(t01.val[0]), vget_high_f32(t23.val[0]))));
+        dat = vaddq_f32(dat, vmulq_f32(vcvtq_f32_s32(vld1q_s32(tap[3])), vcombine_f32(vget_high_f32(t01.val[1]), vget_high_f32(t23.val[1]))));
+        vst1q_s32(&stage->dat[pos], vcvtq_s32_f32(dat));
+#    endif
+    }
+#endif
+
+    for (; pos < count; pos++) {
+#ifdef RESAMPLER_LINEAR
+        stage->dat[pos] = EMU8K_READ_INTERP_LINEAR(emu8k, stage->addr[pos], stage->fract[pos]);
 #elif defined RESAMPLER_CUBIC
-                dat = EMU8K_READ_INTERP_CUBIC(emu8k, emu_voice->addr.int_address,
-                                              emu_voice->addr.fract_address);
+        stage->dat[pos] = EMU8K_READ_INTERP_CUBIC(emu8k, stage->addr[pos], stage->fract[pos]);
 #endif
+    }
+}
 
-                /* Filter section */
-                if (emu_voice->filterq_idx || emu_voice->cvcf_curr_filt_ctoff != 0xFFFF) {
-                    int           cutoff = emu_voice->cvcf_curr_filt_ctoff >> 8;
-                    const int64_t coef0  = filt_coeffs[emu_voice->filterq_idx][cutoff][0];
-                    const int64_t coef1  = filt_coeffs[emu_voice->filterq_idx][cutoff][1];
-                    const int64_t coef2  = filt_coeffs[emu_voice->filterq_idx][cutoff][2];
 /* clip at twice the range */
 #define ClipBuffer(buf) (buf < -16777216) ? -16777216 : (buf > 16777216) ? 16777216 \
                                                                          : buf
 
+/* Filter section */
+static int32_t
+emu8k_voice_filter(emu8k_voice_t *emu_voice, int32_t dat, uint16_t ctoff)
+{
+    int           cutoff = ctoff >> 8;
+    const int64_t coef0  = filt_coeffs[emu_voice->filterq_idx][cutoff][0];
+    const int64_t coef1  = filt_coeffs[emu_voice->filterq_idx][cutoff][1];
+    const int64_t coef2  = filt_coeffs[emu_voice->filterq_idx][cutoff][2];
 #ifdef FILTER_INITIAL
 #    define NOOP(x) (void) x;
-                    NOOP(coef1)
-                    /* Apply expected attenuation. (FILTER_MOOG does it implicitly, but this one doesn't).
-                     * Work in 24bits. */
-                    dat = (dat * emu_voice->filt_att) >> 8;
-
-                    int64_t vhp = ((-emu_voice->filt_buffer[0] * coef2) >> 24) - emu_voice->filt_buffer[1] - dat;
-                    emu_voice->filt_buffer[1] += (emu_voice->filt_buffer[0] * coef0) >> 24;
-                    emu_voice->filt_buffer[0] += (vhp * coef0) >> 24;
-                    dat = (int32_t) (emu_voice->filt_buffer[1] >> 8);
-                    if (dat > 32767)
-                        dat = 32767;
-                    else if (dat < -32768)
-                        dat = -32768;
+    NOOP(coef1)
+    /* Apply expected attenuation. (FILTER_MOOG does it implicitly, but this one doesn't).
+     * Work in 24bits. */
+    dat = (dat * emu_voice->filt_att) >> 8;
+
+    int64_t vhp = ((-emu_voice->filt_buffer[0] * coef2) >> 24) - emu_voice->filt_buffer[1] - dat;
+    emu_voice->filt_buffer[1] += (emu_voice->filt_buffer[0] * coef0) >> 24;
+    emu_voice->filt_buffer[0] += (vhp * coef0) >> 24;
+    dat = (int32_t) (emu_voice->filt_buffer[1] >> 8);
+    if (dat > 32767)
+        dat = 32767;
+    else if (dat < -32768)
+        dat = -32768;
 
 #elif defined FILTER_MOOG
 
-                    /*move to 24bits*/
-                    dat <<= 8;
+    /*move to 24bits*/
+    dat <<= 8;
 
-                    dat -= (coef2 * emu_voice->filt_buffer[4]) >> 24; /*feedback*/
-                    int64_t t1                = emu_voice->filt_buffer[1];
-                    emu_voice->filt_buffer[1] = ((dat + emu_voice->filt_buffer[0]) * coef0 - emu_voice->filt_buffer[1] * coef1) >> 24;
-                    emu_voice->filt_buffer[1] = ClipBuffer(emu_voice->filt_buffer[1]);
+    dat -= (coef2 * emu_voice->filt_buffer[4]) >> 24; /*feedback*/
+    int64_t t1                = emu_voice->filt_buffer[1];
+    emu_voice->filt_buffer[1] = ((dat + emu_voice->filt_buffer[0]) * coef0 - emu_voice->filt_buffer[1] * coef1) >> 24;
+    emu_voice->filt_buffer[1] = ClipBuffer(emu_voice->filt_buffer[1]);
 
-                    int64_t t2                = emu_voice->filt_buffer[2];
-                    emu_voice->filt_buffer[2] = ((emu_voice->filt_buffer[1] + t1) * coef0 - emu_voice->filt_buffer[2] * coef1) >> 24;
-                    emu_voice->filt_buffer[2] = ClipBuffer(emu_voice->filt_buffer[2]);
+    int64_t t2                = emu_voice->filt_buffer[2];
+    emu_voice->filt_buffer[2] = ((emu_voice->filt_buffer[1] + t1) * coef0 - emu_voice->filt_buffer[2] * coef1) >> 24;
+    emu_voice->filt_buffer[2] = ClipBuffer(emu_voice->filt_buffer[2]);
 
-                    int64_t t3                = emu_voice->filt_buffer[3];
-                    emu_voice->filt_buffer[3] = ((emu_voice->filt_buffer[2] + t2) * coef0 - emu_voice->filt_buffer[3] * coef1) >> 24;
-                    emu_voice->filt_buffer[3] = ClipBuffer(emu_voice->filt_buffer[3]);
+    int64_t t3                = emu_voice->filt_buffer[3];
+    emu_voice->filt_buffer[3] = ((emu_voice->filt_buffer[2] + t2) * coef0 - emu_voice->filt_buffer[3] * coef1) >> 24;
+    emu_voice->filt_buffer[3] = ClipBuffer(emu_voice->filt_buffer[3]);
 
-                    emu_voice->filt_buffer[4] = ((emu_voice->filt_buffer[3] + t3) * coef0 - emu_voice->filt_buffer[4] * coef1) >> 24;
-                    emu_voice->filt_buffer[4] = ClipBuffer(emu_voice->filt_buffer[4]);
+    emu_voice->filt_buffer[4] = ((emu_voice->filt_buffer[3] + t3) * coef0 - emu_voice->filt_buffer[4] * coef1) >> 24;
+    emu_voice->filt_buffer[4] = ClipBuffer(emu_voice->filt_buffer[4]);
 
-                    emu_voice->filt_buffer[0] = ClipBuffer(dat);
+    emu_voice->filt_buffer[0] = ClipBuffer(dat);
 
-                    dat = (int32_t) (emu_voice->filt_buffer[4] >> 8);
-                    if (dat > 32767)
-                        dat = 32767;
-                    else if (dat < -32768)
-                        dat = -32768;
+    dat = (int32_t) (emu_voice->filt_buffer[4] >> 8);
+    if (dat > 32767)
+        dat = 32767;
+    else if (dat < -32768)
+        dat = -32768;
 
 #elif defined FILTER_CONSTANT
 
-                    /* Apply expected attenuation. (FILTER_MOOG does it implicitly, but this one is constant gain).
-                     * Also stay at 24bits.*/
-                    dat = (dat * emu_voice->filt_att) >> 8;
+    /* Apply expected attenuation. (FILTER_MOOG does it implicitly, but this one is constant gain).
+     * Also stay at 24bits.*/
+    dat = (dat * emu_voice->filt_att) >> 8;
 
-                    emu_voice->filt_buffer[0] = (coef1 * emu_voice->filt_buffer[0]
-                                                 + coef0 * (dat + ((coef2 * (emu_voice->filt_buffer[0] - emu_voice->filt_buffer[1])) >> 24)))
-                        >> 24;
-                    emu_voice->filt_buffer[1] = (coef1 * emu_voice->filt_buffer[1]
-                                                 + coef0 * emu_voice->filt_buffer[0])
-                        >> 24;
+    emu_voice->filt_buffer[0] = (coef1 * emu_voice->filt_buffer[0]
+                                 + coef0 * (dat + ((coef2 * (emu_voice->filt_buffer[0] - emu_voice->filt_buffer[1])) >> 24)))
+        >> 24;
+    emu_voice->filt_buffer[1] = (coef1 * emu_voice->filt_buffer[1]
+                                 + coef0 * emu_voice->filt_buffer[0])
+        >> 24;
 
-                    emu_voice->filt_buffer[0] = ClipBuffer(emu_voice->filt_buffer[0]);
-                    emu_voice->filt_buffer[1] = ClipBuffer(emu_voice->filt_buffer[1]);
+    emu_voice->filt_buffer[0] = ClipBuffer(emu_voice->filt_buffer[0]);
+    emu_voice->filt_buffer[1] = ClipBuffer(emu_voice->filt_buffer[1]);
 
-                    dat = (int32_t) (emu_voice->filt_buffer[1] >> 8);
-                    if (dat > 32767)
-                        dat = 32767;
-                    else if (dat < -32768)
-                        dat = -32768;
+    dat = (int32_t) (emu_voice->filt_buffer[1] >> 8);
+    if (dat > 32767)
+        dat = 32767;
+    else if (dat < -32768)
+        dat = -32768;
 
 #endif
-                }
-                if ((emu8k->hwcf3 & 0x04) && !CCCA_DMA_ACTIVE(emu_voice->ccca)) {
-                    /*volume and pan*/
-                    dat = (dat * emu_voice->cvcf_curr_volume) >> 16;
-
-                    (*buf++) += (dat * emu_voice->vol_l) >> 8;
-                    (*buf++) += (dat * emu_voice->vol_r) >> 8;
-
-                    /* Effects section */
-                    if (emu_voice->ptrx_revb_send > 0) {
-                        emu8k->reverb_in_buffer[pos] += (dat * emu_voice->ptrx_revb_send) >> 8;
-                    }
-                    if (emu_voice->csl_chor_send > 0) {
-                        emu8k->chorus_in_buffer[pos] += (dat * emu_voice->csl_chor_send) >> 8;
-                    }
-                }
-            }
 
-            if (emu_voice->env_engine_on) {
-                int32_t attenuation  = emu_voice->initial_att;
-                int32_t filtercut    = emu_voice->initial_filter;
-                int32_t currentpitch = emu_voice->ip;
-                /* run envelopes */
-                emu8k_envelope_t *volenv = &emu_voice->vol_envelope;
-                switch (volenv->state) {
-                    case ENV_DELAY:
-                        volenv->delay_samples--;
-                        if (volenv->delay_samples <= 0) {
-                            volenv->state         = ENV_ATTACK;
-                            volenv->delay_samples = 0;
-                        }
-                        attenuation = 0x1FFFFF;
-                        break;
-
-                    case ENV_ATTACK:
-                        /* Attack amount is in linear amplitude */
-                        volenv->value_amp_hz += volenv->attack_amount_amp_hz;
-                        if (volenv->value_amp_hz >= (1 << 21)) {
-                            volenv->value_amp_hz = 1 << 21;
-                            volenv->value_db_oct = 0;
-                            if (volenv->hold_samples) {
-                                volenv->state = ENV_HOLD;
-                            } else {
-                                /* RAMP_UP since db value is inverted and it is 0 at this point. */
-                                volenv->state = ENV_RAMP_UP;
-                            }
-                        }
-                        attenuation += env_vol_amplitude_to_db[volenv->value_amp_hz >> 5] << 5;
-                        break;
-
-                    case ENV_HOLD:
-                        volenv->hold_samples--;
-                        if (volenv->hold_samples <= 0) {
-                            volenv->state = ENV_RAMP_UP;
-                        }
-                        attenuation += volenv->value_db_oct;
-                        break;
-
-                    case ENV_RAMP_DOWN:
-                        /* Decay/release amount is in fraction of dBs and is always positive */
-                        volenv->value_db_oct -= volenv->ramp_amount_db_oct;
-                        if (volenv->value_db_oct <= volenv->sustain_value_db_oct) {
-                            volenv->value_db_oct = volenv->sustain_value_db_oct;
-                            volenv->state        = ENV_SUSTAIN;
-                        }
-                        attenuation += volenv->value_db_oct;
-                        break;
-
-                    case ENV_RAMP_UP:
-                        /* Decay/release amount is in fraction of dBs and is always positive */
-                        volenv->value_db_oct += volenv->ramp_amount_db_oct;
-                        if (volenv->value_db_oct >= volenv->sustain_value_db_oct) {
-                            volenv->value_db_oct = volenv->sustain_value_db_oct;
-                            volenv->state        = ENV_SUSTAIN;
-                        }
-                        attenuation += volenv->value_db_oct;
-                        break;
-
-                    case ENV_SUSTAIN:
-                        attenuation += volenv->value_db_oct;
-                        break;
+    return dat;
+}
 
-                    case ENV_STOPPED:
-                        attenuation = 0x1FFFFF;
-                        break;
+#if defined EMU8K_SSE2
+/* Low 32 bits of a 32x32 multiply; SSE2 only has the 32x32->64 form. */
+static inline __m128i
+emu8k_mullo_epi32(__m128i a, __m128i b)
+{
+    const __m128i even = _mm_mul_epu32(a, b);
+    const __m128i odd  = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
 
-                    default:
-                        break;
-                }
+    return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)), _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+#endif
 
-                emu8k_envelope_t *modenv = &emu_voice->mod_envelope;
-                switch (modenv->state) {
-                    case ENV_DELAY:
-                        modenv->delay_samples--;
-                        if (modenv->delay_samples <= 0) {
-                            modenv->state         = ENV_ATTACK;
-                            modenv->delay_samples = 0;
-                        }
-                        break;
+/* Volume and pan, then the effects sends; a sample with zero volume adds nothing. */
+static void
+emu8k_voice_mix(emu8k_t *emu8k, emu8k_voice_t *emu_voice, emu8k_stage_t *stage, int32_t *buf, int first, int count)
+{
+    int32_t  *reverb = &emu8k->reverb_in_buffer[first];
+    int32_t  *chorus = &emu8k->chorus_in_buffer[first];
+    const int revb   = emu_voice->ptrx_revb_send;
+    const int chor   = emu_voice->csl_chor_send;
+    int       pos    = 0;
+
+#if defined EMU8K_SSE2
+    const __m128i vol_l  = _mm_set1_epi32(emu_voice->vol_l);
+    const __m128i vol_r  = _mm_set1_epi32(emu_voice->vol_r);
+    const __m128i revb_v = _mm_set1_epi32(revb);
+    const __m128i chor_v = _mm_set1_epi32(chor);
+
+    for (; pos <= (count - 4); pos += 4) {
+        const __m128i vol = _mm_unpacklo_epi16(_mm_loadl_epi64((const __m128i *) &stage->volume[pos]), _mm_setzero_si128());
+        const __m128i dat = _mm_srai_epi32(emu8k_mullo_epi32(_mm_loadu_si128((const __m128i *) &stage->dat[pos]), vol), 16);
+        const __m128i l   = _mm_srai_epi32(emu8k_mullo_epi32(dat, vol_l), 8);
+        const __m128i r   = _mm_srai_epi32(emu8k_mullo_epi32(dat, vol_r), 8);
+        __m128i      *out = (__m128i *) &buf[pos * 2];
+
+        _mm_storeu_si128(&out[0], _mm_add_epi32(_mm_loadu_si128(&out[0]), _mm_unpacklo_epi32(l, r)));
+        _mm_storeu_si128(&out[1], _mm_add_epi32(_mm_loadu_si128(&out[1]), _mm_unpackhi_epi32(l, r)));
+
+        /* Effects section */
+        if (revb > 0)
+            _mm_storeu_si128((__m128i *) &reverb[pos], _mm_add_epi32(_mm_loadu_si128((const __m128i *) &reverb[pos]),
+                                                                    _mm_srai_epi32(emu8k_mullo_epi32(dat, revb_v), 8)));
+        if (chor > 0)
+            _mm_storeu_si128((__m128i *) &chorus[pos], _mm_add_epi32(_mm_loadu_si128((const __m128i *) &chorus[pos]),
+                                                                    _mm_srai_epi32(emu8k_mullo_epi32(dat, chor_v), 8)));
+    }
+#elif defined EMU8K_NEON
+    for (; pos <= (count - 4); pos += 4) {
+        const int32x4_t   vol = vreinterpretq_s32_u32(vmovl_u16(vld1_u16(&stage->volume[pos])));
+        const int32x4_t   dat = vshrq_n_s32(vmulq_s32(vld1q_s32(&stage->dat[pos]), vol), 16);
+        const int32x4x2_t lr  = vzipq_s32(vshrq_n_s32(vmulq_n_s32(dat, emu_voice->vol_l), 8),
+                                          vshrq_n_s32(vmulq_n_s32(dat, emu_voice->vol_r), 8));
+
+        vst1q_s32(&buf[pos * 2], vaddq_s32(vld1q_s32(&buf[pos * 2]), lr.val[0]));
+        vst1q_s32(&buf[pos * 2 + 4], vaddq_s32(vld1q_s32(&buf[pos * 2 + 4]), lr.val[1]));
+
+        /* Effects section */
+        if (revb > 0)
+            vst1q_s32(&reverb[pos], vaddq_s32(vld1q_s32(&reverb[pos]), vshrq_n_s32(vmulq_n_s32(dat, revb), 8)));
+        if (chor > 0)
+            vst1q_s32(&chorus[pos], vaddq_s32(vld1q_s32(&chorus[pos]), vshrq_n_s32(vmulq_n_s32(dat, chor), 8)));
+    }
+#endif
 
-                    case ENV_ATTACK:
-                        /* Attack amount is in linear amplitude */
-                        modenv->value_amp_hz += modenv->attack_amount_amp_hz;
-                        modenv->value_db_oct = env_mod_hertz_to_octave[modenv->value_amp_hz >> 5] << 5;
-                        if (modenv->value_amp_hz >= (1 << 21)) {
-                            modenv->value_amp_hz = 1 << 21;
-                            modenv->value_db_oct = 1 << 21;
-                            if (modenv->hold_samples) {
-                                modenv->state = ENV_HOLD;
-                            } else {
-                                modenv->state = ENV_RAMP_DOWN;
-                            }
-                        }
-                        break;
+    for (; pos < count; pos++) {
+        /*volume and pan*/
+        const int32_t dat = (stage->dat[pos] * stage->volume[pos]) >> 16;
 
-                    case ENV_HOLD:
-                        modenv->hold_samples--;
-                        if (modenv->hold_samples <= 0) {
-                            modenv->state = ENV_RAMP_UP;
-                        }
-                        break;
+        buf[pos * 2] += (dat * emu_voice->vol_l) >> 8;
+        buf[pos * 2 + 1] += (dat * emu_voice->vol_r) >> 8;
 
-                    case ENV_RAMP_DOWN:
-                        /* Decay/release amount is in fraction of octave and is always positive */
-                        modenv->value_db_oct -= modenv->ramp_amount_db_oct;
-                        if (modenv->value_db_oct <= modenv->sustain_value_db_oct) {
-                            modenv->value_db_oct = modenv->sustain_value_db_oct;
-                            modenv->state        = ENV_SUSTAIN;
-                        }
-                        break;
+        /* Effects section */
+        if (revb > 0)
+            reverb[pos] += (dat * revb) >> 8;
+        if (chor > 0)
+            chorus[pos] += (dat * chor) >> 8;
+    }
+}
 
-                    case ENV_RAMP_UP:
-                        /* Decay/release amount is in fraction of octave and is always positive */
-                        modenv->value_db_oct += modenv->ramp_amount_db_oct;
-                        if (modenv->value_db_oct >= modenv->sustain_value_db_oct) {
-                            modenv->value_db_oct = modenv->sustain_value_db_oct;
-                            modenv->state        = ENV_SUSTAIN;
-                        }
-                        break;
+void
+emu8k_update(emu8k_t *emu8k)
+{
+    const int end = wavetable_get_pos();
 
-                    default:
-                        break;
-                }
+    if (emu8k->pos >= end)
+        return;
 
-                /* run lfos */
-                if (emu_voice->lfo1_delay_samples) {
-                    emu_voice->lfo1_delay_samples--;
-                } else {
-                    emu_voice->lfo1_count.addr += emu_voice->lfo1_speed;
-                    emu_voice->lfo1_count.int_address &= 0xFFFF;
-                }
-                if (emu_voice->lfo2_delay_samples) {
-                    emu_voice->lfo2_delay_samples--;
-                } else {
-                    emu_voice->lfo2_count.addr += emu_voice->lfo2_speed;
-                    emu_voice->lfo2_count.int_address &= 0xFFFF;
-                }
+    emu8k_stage_t  stage;
+    emu8k_voice_t *emu_voice;
 
-                if (emu_voice->fixed_modenv_pitch_height) {
-                    /* modenv range 1<<21, pitch height range 1<<14 desired range 0x1000 (+/-one octave) */
-                    currentpitch += ((modenv->value_db_oct >> 9) * emu_voice->fixed_modenv_pitch_height) >> 14;
-                }
+    /* Clean the buffers since we will accumulate into them. */
+    memset(&emu8k->buffer[emu8k->pos * 2], 0, 2 * (end - emu8k->pos) * sizeof(emu8k->buffer[0]));
+    memset(&emu8k->chorus_in_buffer[emu8k->pos], 0, (end - emu8k->pos) * sizeof(emu8k->chorus_in_buffer[0]));
+    memset(&emu8k->reverb_in_buffer[emu8k->pos], 0, (end - emu8k->pos) * sizeof(emu8k->reverb_in_buffer[0]));
 
-                if (emu_voice->fixed_lfo1_vibrato) {
-                    /* table range 1<<15, pitch mod range 1<<14 desired range 0x1000 (+/-one octave) */
-                    int32_t lfo1_vibrato = (lfotable[emu_voice->lfo1_count.int_address] * emu_voice->fixed_lfo1_vibrato) >> 17;
-                    currentpitch += lfo1_vibrato;
-                }
-                if (emu_voice->fixed_lfo2_vibrato) {
-                    /* table range 1<<15, pitch mod range 1<<14 desired range 0x1000 (+/-one octave) */
-                    int32_t lfo2_vibrato = (lfotable[emu_voice->lfo2_count.int_address] * emu_voice->fixed_lfo2_vibrato) >> 17;
-                    currentpitch += lfo2_vibrato;
-                }
+    /* Voices section  */
+    for (uint8_t c = 0; c < 32; c++) {
+        emu_voice = &emu8k->voice[c];
 
-                if (emu_voice->fixed_modenv_filter_height) {
-                    /* modenv range 1<<21, pitch height range 1<<14 desired range 0x200000 (+/-full filter range) */
-                    filtercut += ((modenv->value_db_oct >> 9) * emu_voice->fixed_modenv_filter_height) >> 5;
-                }
+        for (int pos = emu8k->pos; pos < end; pos += EMU8K_BLOCK) {
+            const int count = ((end - pos) < EMU8K_BLOCK) ? (end - pos) : EMU8K_BLOCK;
 
-                if (emu_voice->fixed_lfo1_filt_mod) {
-                    /* table range 1<<15, pitch mod range 1<<14 desired range 0x100000 (+/-three octaves) */
-                    int32_t lfo1_filtmod = (lfotable[emu_voice->lfo1_count.int_address] * emu_voice->fixed_lfo1_filt_mod) >> 9;
-                    filtercut += lfo1_filtmod;
-                }
+            if (!emu8k_voice_control(emu_voice, &stage, count))
+                continue;
 
-                if (emu_voice->fixed_lfo1_tremolo) {
-                    /* table range 1<<15, pitch mod range 1<<14 desired range 0x40000 (+/-12dBs). */
-                    int32_t lfo1_tremolo = (lfotable[emu_voice->lfo1_count.int_address] * emu_voice->fixed_lfo1_tremolo) >> 11;
-                    attenuation += lfo1_tremolo;
-                }
+            emu8k_voice_interp(emu8k, &stage, count);
 
-                if (currentpitch > 0xFFFF)
-                    currentpitch = 0xFFFF;
-                if (currentpitch < 0)
-                    currentpitch = 0;
-                if (attenuation > 0x1FFFFF)
-                    attenuation = 0x1FFFFF;
-                if (attenuation < 0)
-                    attenuation = 0;
-                if (filtercut > 0x1FFFFF)
-                    filtercut = 0x1FFFFF;
-                if (filtercut < 0)
-                    filtercut = 0;
-
-                emu_voice->vtft_vol_target    = env_vol_db_to_vol_target[attenuation >> 5];
-                emu_voice->vtft_filter_target = filtercut >> 5;
-                emu_voice->ptrx_pit_target    = freqtable[currentpitch] >> 18;
-            }
-            /*
-            I've recopilated these sentences to get an idea of how to loop
-
-            - Set its PSST register and its CLS register to zero to cause no loops to occur.
-            -Setting the Loop Start Offset and the Loop End Offset to the same value, will cause the oscillator to loop the entire memory.
-
-            -Setting the PlayPosition greater than the Loop End Offset, will cause the oscillator to play in reverse, back to the Loop End Offset.
-               It's pretty neat, but appears to be uncontrollable (the rate at which the samples are played in reverse).
-
-            -Note that due to interpolator offset, the actual loop point is one greater than the start address
-            -Note that due to interpolator offset, the actual loop point will end at an address one greater than the loop address
-            -Note that the actual audio location is the point 1 word higher than this value due to interpolation offset
-            -In programs that use the awe, they generally set the loop address as "loopaddress -1" to compensate for the above.
-            (Note: I am already using address+1 in the interpolators so these things are already as they should.)
-            */
-            emu_voice->addr.addr += ((uint64_t) emu_voice->cpf_curr_pitch) << 18;
-            if (emu_voice->addr.addr >= emu_voice->loop_end.addr) {
-                emu_voice->addr.int_address -= (emu_voice->loop_end.int_address - emu_voice->loop_start.int_address);
-                emu_voice->addr.int_address &= EMU8K_MEM_ADDRESS_MASK;
+            for (int i = 0; i < count; i++) {
+                if (stage.volume[i] && (emu_voice->filterq_idx || stage.ctoff[i] != 0xFFFF))
+                    stage.dat[i] = emu8k_voice_filter(emu_voice, stage.dat[i], stage.ctoff[i]);
             }
 
-            /* TODO: How and when are the target and current values updated */
-            emu_voice->cpf_curr_pitch       = emu_voice->ptrx_pit_target;
-            emu_voice->cvcf_curr_volume     = emu8k_vol_slide(&emu_voice->volumeslide, emu_voice->vtft_vol_target);
-            emu_voice->cvcf_curr_filt_ctoff = emu_voice->vtft_filter_target;
+            if ((emu8k->hwcf3 & 0x04) && !CCCA_DMA_ACTIVE(emu_voice->ccca))
+                emu8k_voice_mix(emu8k, emu_voice, &stage, &emu8k->buffer[pos * 2], pos, count);
         }
 
         /* Update EMU voice registers. */
@@ -2116,15 +2393,14 @@ emu8k_update(emu8k_t *emu8k)
 #endif
     }
 
-    buf = &emu8k->buffer[emu8k->pos * 2];
-    emu8k_work_reverb(&emu8k->reverb_in_buffer[emu8k->pos], buf, &emu8k->reverb_engine, wavetable_pos_global - emu8k->pos);
-    emu8k_work_chorus(&emu8k->chorus_in_buffer[emu8k->pos], buf, &emu8k->chorus_engine, wavetable_pos_global - emu8k->pos);
-    emu8k_work_eq(buf, wavetable_pos_global - emu8k->pos);
+    emu8k_work_reverb(&emu8k->reverb_in_buffer[emu8k->pos], &emu8k->buffer[emu8k->pos * 2], &emu8k->reverb_engine, end - emu8k->pos);
+    emu8k_work_chorus(&emu8k->chorus_in_buffer[emu8k->pos], &emu8k->buffer[emu8k->pos * 2], &emu8k->chorus_engine, end - emu8k->pos);
+    emu8k_work_eq(&emu8k->buffer[emu8k->pos * 2], end - emu8k->pos);
 
     /* Update EMU clock. */
-    emu8k->wc += (wavetable_pos_global - emu8k->pos);
+    emu8k->wc += (end - emu8k->pos);
 
-    emu8k->pos = wavetable_pos_global;
+    emu8k->pos = end;
 }
 
 void
@@ -1108,7 +1108,9 @@ gus_poll_timer_2(void *priv)
 static void
 gus_update(gus_t *gus)
 {
-    for (; gus->pos < sound_pos_global; gus->pos++) {
+    const int pos = sound_get_pos();
+
+    for (; gus->pos < pos; gus->pos++) {
         if (gus->out_l < -32768)
             gus->buffer[0][gus->pos] = -32768;
         else if (gus->out_l > 32767)
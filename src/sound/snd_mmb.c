@@ -50,7 +50,9 @@ mmb_log(const char *fmt, ...)
 void
 mmb_update(mmb_t *mmb)
 {
-    for (; mmb->pos < sound_pos_global; mmb->pos++) {
+    const int pos = sound_get_pos();
+
+    for (; mmb->pos < pos; mmb->pos++) {
         ayumi_process(&mmb->first.chip);
         ayumi_process(&mmb->second.chip);
 
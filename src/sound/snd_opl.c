@@ -60,6 +60,9 @@ fm_driver_get_ex(int chip_id, fm_drv_t *drv, int is_48k)
             if (fm_driver == FM_DRV_NUKED) {
                 *drv      = is_48k ? nuked_opl_drv_48k : nuked_opl_drv;
                 drv->priv = device_add_inst_params(&ym3812_nuked_device, fm_dev_inst[fm_driver][chip_id]++, flag_48k);
+            } else if (fm_driver == FM_DRV_NUKED_SIMD) {
+                *drv      = is_48k ? nuked_opl_drv_48k : nuked_opl_drv;
+                drv->priv = device_add_inst_params(&ym3812_nuked_simd_device, fm_dev_inst[fm_driver][chip_id]++, flag_48k);
             } else {
                 *drv      = ymfm_drv;
                 drv->priv = device_add_inst_params(&ym3812_ymfm_device, fm_dev_inst[fm_driver][chip_id]++, flag_48k);
@@ -70,6 +73,9 @@ fm_driver_get_ex(int chip_id, fm_drv_t *drv, int is_48k)
             if (fm_driver == FM_DRV_NUKED) {
                 *drv      = is_48k ? nuked_opl_drv_48k : nuked_opl_drv;
                 drv->priv = device_add_inst_params(&ymf262_nuked_device, fm_dev_inst[fm_driver][chip_id]++, flag_48k);
+            } else if (fm_driver == FM_DRV_NUKED_SIMD) {
+                *drv      = is_48k ? nuked_opl_drv_48k : nuked_opl_drv;
+                drv->priv = device_add_inst_params(&ymf262_nuked_simd_device, fm_dev_inst[fm_driver][chip_id]++, flag_48k);
             } else {
                 *drv      = ymfm_drv;
                 drv->priv = device_add_inst_params(&ymf262_ymfm_device, fm_dev_inst[fm_driver][chip_id]++, flag_48k);
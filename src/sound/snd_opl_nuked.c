@@ -38,6 +38,7 @@
  *          Copyright 2013-2020 Alexey Khokholov (Nuke.YKT)
  */
 #include <stdarg.h>
+#include <stdatomic.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -46,7 +47,9 @@
 #define HAVE_STDARG_H
 #include <86box/86box.h>
 #include <86box/sound.h>
+#include <86box/sound_worker.h>
 #include "cpu.h"
+#include <86box/thread.h>
 #include <86box/timer.h>
 #include <86box/device.h>
 #include <86box/snd_opl.h>
@@ -69,6 +72,14 @@
 
 #define RSM_FRAC    10
 
+#if defined(__x86_64__) || defined(_M_X64)
+#    define OPL_LANES_SSE2
+#    include <emmintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#    define OPL_LANES_NEON
+#    include <arm_neon.h>
+#endif
+
 // Channel types
 enum {
     ch_2op  = 0,
@@ -1056,17 +1067,546 @@ OPL3_ProcessSlot(opl3_slot *slot)
     OPL3_SlotGenerate(slot);
 }
 
+/*
+   Vectorized core.
+
+   The slots are processed a stage at a time instead of one slot at a
+   time: feedback, then the envelope generator for all 36 slots side by
+   side, then the phase generator, then the waveform lookups in slot
+   order, since a slot may be modulated by one processed before it in the
+   same sample. The rhythm section and the noise generator, which depend
+   on the slot order, are applied in between. Every step computes exactly
+   what OPL3_ProcessSlot() does.
+
+   The waveform lookups are not done with AVX2 gathers. Within a sample a
+   carrier reads the output of its modulator (slot 3 reads slot 0, and a
+   4-op channel chains four slots), so only the slots of one level of
+   those chains could share a gather. Each level would then need two
+   dependent gathers (wave, then exponent) of a handful of lanes, and a
+   runtime AVX2 check, since builds target baseline x86-64. The scalar
+   walk over the folded table is kept instead.
+
+   ESFMu (esfmu/esfm.c) is a separate core with its own slot layout,
+   per-operator output routing and emulation mode, and is not covered;
+   it keeps its per-slot function pointers.
+ */
+static void OPL3_ChipClock(opl3_chip *chip);
+
+/* Logarithmic sine (low 15 bits) and sign (bit 15) for each waveform and phase. */
+static uint16_t opl3_wave[8][1024];
+static uint8_t  opl3_wave_build = 0;
+
+static void
+OPL3_LanesBuildWaves(void)
+{
+    for (uint16_t phase = 0; phase < 0x400; phase++) {
+        const uint16_t quarter = (phase & 0x0100) ? logsinrom[(phase & 0xffu) ^ 0xffu] : logsinrom[phase & 0xffu];
+        const uint16_t half    = (phase & 0x80) ? logsinrom[((phase ^ 0xffu) << 1u) & 0xffu] : logsinrom[(phase << 1u) & 0xffu];
+        const uint16_t neg     = (phase & 0x0200) ? 0x8000 : 0x0000;
+
+        opl3_wave[0][phase] = quarter | neg;
+        opl3_wave[1][phase] = (phase & 0x0200) ? 0x1000 : quarter;
+        opl3_wave[2][phase] = quarter;
+        opl3_wave[3][phase] = (phase & 0x0100) ? 0x1000 : logsinrom[phase & 0xffu];
+        opl3_wave[4][phase] = ((phase & 0x0200) ? 0x1000 : half) | (((phase & 0x0300) == 0x0100) ? 0x8000 : 0x0000);
+        opl3_wave[5][phase] = (phase & 0x0200) ? 0x1000 : half;
+        opl3_wave[6][phase] = neg;
+        opl3_wave[7][phase] = ((neg ? ((phase & 0x01ff) ^ 0x01ff) : phase) << 3) | neg;
+    }
+
+    opl3_wave_build = 1;
+}
+
+static uint8_t
+OPL3_LanesIndex(opl3_chip *chip, const int16_t *ptr)
+{
+    size_t num;
+
+    if (ptr == &chip->zeromod)
+        return OPL_LANE_ZERO;
+
+    num = ((const uint8_t *) ptr - (const uint8_t *) chip->slot) / sizeof(opl3_slot);
+
+    return (ptr == &chip->slot[num].out) ? num : (36 + num);
+}
+
+static void
+OPL3_LanesPhaseInc(opl3_chip *chip)
+{
+    opl3_lanes *lanes = &chip->lanes;
+
+    for (uint8_t i = 0; i < 36; i++) {
+        const opl3_slot *slot  = &chip->slot[i];
+        uint16_t         f_num = slot->channel->f_num;
+        uint32_t         basefreq;
+
+        if (slot->reg_vib) {
+            int8_t  range;
+            uint8_t vibpos;
+
+            range  = (f_num >> 7) & 7;
+            vibpos = chip->vibpos;
+
+            if (!(vibpos & 3))
+                range = 0;
+            else if (vibpos & 1)
+                range >>= 1;
+            range >>= chip->vibshift;
+
+            if (vibpos & 4)
+                range = -range;
+            f_num += range;
+        }
+
+        basefreq         = (f_num << slot->channel->block) >> 1;
+        lanes->pg_inc[i] = (basefreq * mt[slot->reg_mult]) >> 1;
+    }
+
+    lanes->vibpos = chip->vibpos;
+}
+
+static void
+OPL3_LanesGather(opl3_chip *chip)
+{
+    opl3_lanes *lanes = &chip->lanes;
+
+    for (uint8_t i = 0; i < 36; i++) {
+        const opl3_slot    *slot    = &chip->slot[i];
+        const opl3_channel *channel = slot->channel;
+
+        lanes->eg_base[i] = (slot->reg_tl << 2) + (slot->eg_ksl >> kslshift[slot->reg_ksl]);
+        lanes->trem[i]    = (slot->trem == &chip->tremolo) ? 0xffff : 0x0000;
+        lanes->key[i]     = slot->key ? 0xffff : 0x0000;
+        lanes->ar[i]      = slot->reg_ar;
+        lanes->dr[i]      = slot->reg_dr;
+        lanes->sr[i]      = slot->reg_type ? 0 : slot->reg_rr;
+        lanes->rr[i]      = slot->reg_rr;
+        lanes->ks[i]      = channel->ksv >> ((slot->reg_ksr ^ 1) << 1);
+        lanes->sl[i]      = slot->reg_sl;
+        lanes->wf[i]      = slot->reg_wf;
+        lanes->fb[i]      = channel->fb;
+        lanes->mod[i]     = OPL3_LanesIndex(chip, slot->mod);
+    }
+
+    for (uint8_t i = 0; i < 18; i++) {
+        for (uint8_t j = 0; j < 4; j++)
+            lanes->ch_out[i][j] = OPL3_LanesIndex(chip, chip->channel[i].out[j]);
+    }
+
+    OPL3_LanesPhaseInc(chip);
+
+    lanes->dirty = 0;
+}
+
+void
+OPL3_LanesInit(opl3_chip *chip)
+{
+    opl3_lanes *lanes = &chip->lanes;
+
+    if (!opl3_wave_build)
+        OPL3_LanesBuildWaves();
+
+    memset(lanes, 0x00, sizeof(opl3_lanes));
+
+    for (uint8_t i = 0; i < 36; i++) {
+        const opl3_slot *slot = &chip->slot[i];
+
+        lanes->eg_rout[i]      = slot->eg_rout;
+        lanes->eg_gen[i]       = slot->eg_gen;
+        lanes->eg_out[i]       = slot->eg_out;
+        lanes->pg_reset[i]     = slot->pg_reset ? 0xffff : 0x0000;
+        lanes->pg_phase[i]     = slot->pg_phase;
+        lanes->pg_phase_out[i] = slot->pg_phase_out;
+        lanes->prout[i]        = slot->prout;
+        lanes->sig[i]          = slot->out;
+        lanes->sig[36 + i]     = slot->fbmod;
+    }
+
+    lanes->on    = 1;
+    lanes->dirty = 1;
+}
+
+#if defined(OPL_LANES_SSE2) || defined(OPL_LANES_NEON)
+#    if defined(OPL_LANES_SSE2)
+typedef __m128i opl_v16;
+
+static inline opl_v16 v16_load(const uint16_t *p) { return _mm_loadu_si128((const __m128i *) p); }
+static inline void    v16_store(uint16_t *p, opl_v16 a) { _mm_storeu_si128((__m128i *) p, a); }
+static inline opl_v16 v16_set(uint16_t a) { return _mm_set1_epi16((int16_t) a); }
+static inline opl_v16 v16_add(opl_v16 a, opl_v16 b) { return _mm_add_epi16(a, b); }
+static inline opl_v16 v16_and(opl_v16 a, opl_v16 b) { return _mm_and_si128(a, b); }
+static inline opl_v16 v16_or(opl_v16 a, opl_v16 b) { return _mm_or_si128(a, b); }
+static inline opl_v16 v16_not(opl_v16 a) { return _mm_xor_si128(a, _mm_set1_epi16(-1)); }
+static inline opl_v16 v16_eq(opl_v16 a, opl_v16 b) { return _mm_cmpeq_epi16(a, b); }
+static inline opl_v16 v16_lt(opl_v16 a, opl_v16 b) { return _mm_cmplt_epi16(a, b); }
+static inline opl_v16 v16_min(opl_v16 a, opl_v16 b) { return _mm_min_epi16(a, b); }
+static inline opl_v16 v16_sel(opl_v16 m, opl_v16 a, opl_v16 b) { return _mm_or_si128(_mm_and_si128(m, a), _mm_andnot_si128(m, b)); }
+static inline opl_v16 v16_shl(opl_v16 a, int n) { return _mm_sll_epi16(a, _mm_cvtsi32_si128(n)); }
+static inline opl_v16 v16_shr(opl_v16 a, int n) { return _mm_srl_epi16(a, _mm_cvtsi32_si128(n)); }
+static inline opl_v16 v16_sar(opl_v16 a, int n) { return _mm_sra_epi16(a, _mm_cvtsi32_si128(n)); }
+#    else
+typedef uint16x8_t opl_v16;
+
+static inline opl_v16 v16_load(const uint16_t *p) { return vld1q_u16(p); }
+static inline void    v16_store(uint16_t *p, opl_v16 a) { vst1q_u16(p, a); }
+static inline opl_v16 v16_set(uint16_t a) { return vdupq_n_u16(a); }
+static inline opl_v16 v16_add(opl_v16 a, opl_v16 b) { return vaddq_u16(a, b); }
+static inline opl_v16 v16_and(opl_v16 a, opl_v16 b) { return vandq_u16(a, b); }
+static inline opl_v16 v16_or(opl_v16 a, opl_v16 b) { return vorrq_u16(a, b); }
+static inline opl_v16 v16_not(opl_v16 a) { return vmvnq_u16(a); }
+static inline opl_v16 v16_eq(opl_v16 a, opl_v16 b) { return vceqq_u16(a, b); }
+static inline opl_v16 v16_lt(opl_v16 a, opl_v16 b) { return vcltq_u16(a, b); }
+static inline opl_v16 v16_min(opl_v16 a, opl_v16 b) { return vminq_u16(a, b); }
+static inline opl_v16 v16_sel(opl_v16 m, opl_v16 a, opl_v16 b) { return vbslq_u16(m, a, b); }
+static inline opl_v16 v16_shl(opl_v16 a, int n) { return vshlq_u16(a, vdupq_n_s16(n)); }
+static inline opl_v16 v16_shr(opl_v16 a, int n) { return vshlq_u16(a, vdupq_n_s16(-n)); }
+static inline opl_v16 v16_sar(opl_v16 a, int n) { return vreinterpretq_u16_s16(vshlq_s16(vreinterpretq_s16_u16(a), vdupq_n_s16(-n))); }
+#    endif
+
+/* OPL3_EnvelopeCalc() for eight slots at a time. The compares are signed on SSE2, which is fine as every operand is below 0x8000. */
+static void
+OPL3_LanesEnvelope(opl3_chip *chip)
+{
+    opl3_lanes   *lanes    = &chip->lanes;
+    const opl_v16 one      = v16_set(1);
+    const opl_v16 zero     = v16_set(0);
+    const opl_v16 eg_add   = v16_set(chip->eg_add);
+    const opl_v16 eg_state = v16_set(chip->eg_state);
+    const opl_v16 tremolo  = v16_set(chip->tremolo);
+    const opl_v16 incstep0 = v16_set(eg_incstep[0][chip->eg_timer_lo]);
+    const opl_v16 incstep1 = v16_set(eg_incstep[1][chip->eg_timer_lo]);
+    const opl_v16 incstep2 = v16_set(eg_incstep[2][chip->eg_timer_lo]);
+    const opl_v16 incstep3 = v16_set(eg_incstep[3][chip->eg_timer_lo]);
+
+    for (uint8_t i = 0; i < OPL_LANES; i += 8) {
+        const opl_v16 eg_rout = v16_load(&lanes->eg_rout[i]);
+        const opl_v16 gen     = v16_load(&lanes->eg_gen[i]);
+        const opl_v16 key     = v16_load(&lanes->key[i]);
+        const opl_v16 sl      = v16_load(&lanes->sl[i]);
+        const opl_v16 attack  = v16_eq(gen, v16_set(envelope_gen_num_attack));
+        const opl_v16 decay   = v16_eq(gen, v16_set(envelope_gen_num_decay));
+        const opl_v16 sustain = v16_eq(gen, v16_set(envelope_gen_num_sustain));
+        const opl_v16 reset   = v16_and(key, v16_eq(gen, v16_set(envelope_gen_num_release)));
+        opl_v16       reg_rate;
+        opl_v16       rate;
+        opl_v16       rate_hi;
+        opl_v16       rate_lo;
+        opl_v16       eg_shift;
+        opl_v16       shift_lo;
+        opl_v16       shift_hi;
+        opl_v16       shift;
+        opl_v16       shift_on;
+        opl_v16       new_rout;
+        opl_v16       eg_off;
+        opl_v16       at_zero;
+        opl_v16       at_sl;
+        opl_v16       inc_att;
+        opl_v16       inc_dec;
+        opl_v16       new_gen;
+
+        v16_store(&lanes->eg_out[i], v16_add(v16_add(eg_rout, v16_load(&lanes->eg_base[i])),
+                                             v16_and(v16_load(&lanes->trem[i]), tremolo)));
+
+        reg_rate = v16_sel(decay, v16_load(&lanes->dr[i]),
+                           v16_sel(sustain, v16_load(&lanes->sr[i]), v16_load(&lanes->rr[i])));
+        reg_rate = v16_sel(v16_or(attack, reset), v16_load(&lanes->ar[i]), reg_rate);
+        v16_store(&lanes->pg_reset[i], reset);
+
+        rate     = v16_add(v16_load(&lanes->ks[i]), v16_shl(reg_rate, 2));
+        rate_hi  = v16_min(v16_shr(rate, 2), v16_set(0x0f));
+        rate_lo  = v16_and(rate, v16_set(0x03));
+        eg_shift = v16_add(rate_hi, eg_add);
+
+        shift_lo = v16_or(v16_and(v16_eq(eg_shift, v16_set(12)), one),
+                          v16_or(v16_and(v16_eq(eg_shift, v16_set(13)), v16_and(v16_shr(rate_lo, 1), one)),
+                                 v16_and(v16_eq(eg_shift, v16_set(14)), v16_and(rate_lo, one))));
+        shift_lo = chip->eg_state ? shift_lo : zero;
+
+        shift_hi = v16_sel(v16_eq(rate_lo, zero), incstep0,
+                           v16_sel(v16_eq(rate_lo, one), incstep1,
+                                   v16_sel(v16_eq(rate_lo, v16_set(2)), incstep2, incstep3)));
+        shift_hi = v16_min(v16_add(v16_and(rate_hi, v16_set(0x03)), shift_hi), v16_set(0x03));
+        shift_hi = v16_sel(v16_eq(shift_hi, zero), eg_state, shift_hi);
+
+        shift    = v16_sel(v16_lt(rate_hi, v16_set(12)), shift_lo, shift_hi);
+        shift    = v16_and(v16_not(v16_eq(reg_rate, zero)), shift);
+        shift_on = v16_not(v16_eq(shift, zero));
+
+        eg_off   = v16_eq(v16_and(eg_rout, v16_set(0x1f8)), v16_set(0x1f8));
+        new_rout = v16_and(v16_not(v16_and(reset, v16_eq(rate_hi, v16_set(0x0f)))), eg_rout);
+        new_rout = v16_sel(v16_and(v16_not(v16_or(attack, reset)), eg_off), v16_set(0x1ff), new_rout);
+
+        at_zero  = v16_eq(eg_rout, zero);
+        at_sl    = v16_eq(v16_shr(eg_rout, 4), sl);
+
+        inc_att  = v16_sel(v16_eq(shift, one), v16_sar(v16_not(eg_rout), 3),
+                           v16_sel(v16_eq(shift, v16_set(2)), v16_sar(v16_not(eg_rout), 2), v16_sar(v16_not(eg_rout), 1)));
+        inc_att  = v16_and(v16_and(attack, v16_not(at_zero)),
+                           v16_and(v16_and(key, shift_on), v16_and(v16_not(v16_eq(rate_hi, v16_set(0x0f))), inc_att)));
+
+        inc_dec  = v16_sel(v16_eq(shift, one), one, v16_sel(v16_eq(shift, v16_set(2)), v16_set(2), v16_set(4)));
+        inc_dec  = v16_and(v16_and(v16_not(attack), v16_not(v16_and(decay, at_sl))),
+                           v16_and(v16_and(shift_on, v16_not(v16_or(eg_off, reset))), inc_dec));
+
+        v16_store(&lanes->eg_rout[i], v16_and(v16_add(new_rout, v16_or(inc_att, inc_dec)), v16_set(0x1ff)));
+
+        new_gen  = v16_sel(v16_and(attack, at_zero), v16_set(envelope_gen_num_decay), gen);
+        new_gen  = v16_sel(v16_and(decay, at_sl), v16_set(envelope_gen_num_sustain), new_gen);
+        new_gen  = v16_and(v16_not(reset), new_gen);
+        new_gen  = v16_sel(key, new_gen, v16_set(envelope_gen_num_release));
+        v16_store(&lanes->eg_gen[i], new_gen);
+    }
+}
+#else
+static void
+OPL3_LanesEnvelope(opl3_chip *chip)
+{
+    opl3_lanes *lanes = &chip->lanes;
+
+    for (uint8_t i = 0; i < 36; i++) {
+        const uint16_t eg_rout = lanes->eg_rout[i];
+        const uint16_t gen     = lanes->eg_gen[i];
+        const uint8_t  reset   = lanes->key[i] && (gen == envelope_gen_num_release);
+        uint8_t        reg_rate;
+        uint8_t        rate;
+        uint8_t        rate_hi;
+        uint8_t        rate_lo;
+        uint8_t        eg_shift;
+        uint8_t        shift = 0;
+        uint8_t        eg_off;
+        uint16_t       new_rout;
+        int16_t        eg_inc = 0;
+
+        lanes->eg_out[i] = eg_rout + lanes->eg_base[i] + (lanes->trem[i] & chip->tremolo);
+
+        if (reset || (gen == envelope_gen_num_attack))
+            reg_rate = lanes->ar[i];
+        else if (gen == envelope_gen_num_decay)
+            reg_rate = lanes->dr[i];
+        else if (gen == envelope_gen_num_sustain)
+            reg_rate = lanes->sr[i];
+        else
+            reg_rate = lanes->rr[i];
+
+        lanes->pg_reset[i] = reset ? 0xffff : 0x0000;
+
+        rate     = lanes->ks[i] + (reg_rate << 2);
+        rate_hi  = rate >> 2;
+        rate_lo  = rate & 0x03;
+        if (rate_hi & 0x10)
+            rate_hi = 0x0f;
+        eg_shift = rate_hi + chip->eg_add;
+
+        if (reg_rate) {
+            if (rate_hi < 12) {
+                if (chip->eg_state) {
+                    if (eg_shift == 12)
+                        shift = 1;
+                    else if (eg_shift == 13)
+                        shift = (rate_lo >> 1) & 0x01;
+                    else if (eg_shift == 14)
+                        shift = rate_lo & 0x01;
+                }
+            } else {
+                shift = (rate_hi & 0x03) + eg_incstep[rate_lo][chip->eg_timer_lo];
+                if (shift & 0x04)
+                    shift = 0x03;
+                if (!shift)
+                    shift = chip->eg_state;
+            }
+        }
+
+        new_rout = eg_rout;
+        if (reset && (rate_hi == 0x0f))
+            new_rout = 0x00;
+
+        eg_off = ((eg_rout & 0x1f8) == 0x1f8);
+        if ((gen != envelope_gen_num_attack) && !reset && eg_off)
+            new_rout = 0x1ff;
+
+        if (gen == envelope_gen_num_attack) {
+            if (!eg_rout)
+                lanes->eg_gen[i] = envelope_gen_num_decay;
+            else if (lanes->key[i] && shift && (rate_hi != 0x0f))
+                eg_inc = ~eg_rout >> (4 - shift);
+        } else if ((gen == envelope_gen_num_decay) && ((eg_rout >> 4) == lanes->sl[i]))
+            lanes->eg_gen[i] = envelope_gen_num_sustain;
+        else if (!eg_off && !reset && shift)
+            eg_inc = 1 << (shift - 1);
+
+        lanes->eg_rout[i] = (new_rout + eg_inc) & 0x1ff;
+
+        if (reset)
+            lanes->eg_gen[i] = envelope_gen_num_attack;
+
+        if (!lanes->key[i])
+            lanes->eg_gen[i] = envelope_gen_num_release;
+    }
+}
+#endif
+
+/* OPL3_PhaseGenerate() for every slot, including the noise generator and the rhythm section. */
+static void
+OPL3_LanesPhase(opl3_chip *chip)
+{
+    opl3_lanes *lanes = &chip->lanes;
+    uint32_t    noise = chip->noise;
+    uint32_t    noise_hh;
+    uint32_t    noise_sd;
+    uint16_t    phase;
+    uint8_t     rm_xor;
+
+    for (uint8_t i = 0; i < OPL_LANES; i++) {
+        lanes->pg_phase_out[i] = (uint16_t) (lanes->pg_phase[i] >> 9);
+        lanes->pg_phase[i]     = (lanes->pg_phase[i] & ~(uint32_t) (int16_t) lanes->pg_reset[i]) + lanes->pg_inc[i];
+    }
+
+    /* The noise generator advances once per slot. */
+    for (uint8_t i = 0; i < 13; i++)
+        noise = (noise >> 1) | ((((noise >> 14) ^ noise) & 0x01) << 22);
+    noise_hh = noise;
+    for (uint8_t i = 13; i < 16; i++)
+        noise = (noise >> 1) | ((((noise >> 14) ^ noise) & 0x01) << 22);
+    noise_sd = noise;
+    for (uint8_t i = 16; i < 36; i++)
+        noise = (noise >> 1) | ((((noise >> 14) ^ noise) & 0x01) << 22);
+    chip->noise = noise;
+
+    phase            = lanes->pg_phase_out[13];
+    chip->rm_hh_bit2 = (phase >> 2) & 1;
+    chip->rm_hh_bit3 = (phase >> 3) & 1;
+    chip->rm_hh_bit7 = (phase >> 7) & 1;
+    chip->rm_hh_bit8 = (phase >> 8) & 1;
+
+    if (chip->rhy & 0x20) {
+        rm_xor = (chip->rm_hh_bit2 ^ chip->rm_hh_bit7)
+                 | (chip->rm_hh_bit3 ^ chip->rm_tc_bit5)
+                 | (chip->rm_tc_bit3 ^ chip->rm_tc_bit5);
+
+        // hh
+        lanes->pg_phase_out[13] = (rm_xor << 9) | ((rm_xor ^ (noise_hh & 1)) ? 0xd0 : 0x34);
+
+        // sd
+        lanes->pg_phase_out[16] = (chip->rm_hh_bit8 << 9)
+                                  | ((chip->rm_hh_bit8 ^ (noise_sd & 1)) << 8);
+
+        // tc
+        phase            = lanes->pg_phase_out[17];
+        chip->rm_tc_bit3 = (phase >> 3) & 1;
+        chip->rm_tc_bit5 = (phase >> 5) & 1;
+        rm_xor           = (chip->rm_hh_bit2 ^ chip->rm_hh_bit7)
+                           | (chip->rm_hh_bit3 ^ chip->rm_tc_bit5)
+                           | (chip->rm_tc_bit3 ^ chip->rm_tc_bit5);
+
+        lanes->pg_phase_out[17] = (rm_xor << 9) | 0x80;
+    }
+}
+
+static inline void
+OPL3_LanesGenerate(opl3_lanes *lanes, uint8_t first, uint8_t last)
+{
+    for (uint8_t i = first; i < last; i++) {
+        const uint16_t phase = lanes->pg_phase_out[i] + lanes->sig[lanes->mod[i]];
+        const uint16_t wave  = opl3_wave[lanes->wf[i]][phase & 0x3ff];
+        const int16_t  out   = OPL3_EnvelopeCalcExp((wave & 0x7fff) + (lanes->eg_out[i] << 3));
+
+        lanes->sig[i] = (wave & 0x8000) ? ~out : out;
+    }
+}
+
+static inline void
+OPL3_LanesMix(opl3_chip *chip, int32_t *mix, int right)
+{
+    const opl3_lanes *lanes = &chip->lanes;
+
+    mix[0] = mix[1] = 0;
+
+    for (uint8_t i = 0; i < 18; i++) {
+        const opl3_channel *channel = &chip->channel[i];
+        const uint8_t      *out     = lanes->ch_out[i];
+        const int16_t       accm    = lanes->sig[out[0]] + lanes->sig[out[1]] + lanes->sig[out[2]] + lanes->sig[out[3]];
+
+#if OPL_ENABLE_STEREOEXT
+        mix[0] += (int16_t) ((accm * (right ? channel->rightpan : channel->leftpan)) >> 16);
+#else
+        mix[0] += (int16_t) (accm & (right ? channel->chb : channel->cha));
+#endif
+        mix[1] += (int16_t) (accm & (right ? channel->chd : channel->chc));
+    }
+}
+
+static void
+OPL3_Generate4ChLanes(opl3_chip *chip, int32_t *buf4)
+{
+    opl3_lanes *lanes = &chip->lanes;
+    int32_t     mix[2];
+
+    if (lanes->dirty)
+        OPL3_LanesGather(chip);
+    else if (lanes->vibpos != chip->vibpos)
+        OPL3_LanesPhaseInc(chip);
+
+    buf4[1] = chip->mixbuff[1];
+    buf4[3] = chip->mixbuff[3];
+
+    for (uint8_t i = 0; i < 36; i++) {
+        if (lanes->fb[i] != 0x00)
+            lanes->sig[36 + i] = (lanes->prout[i] + lanes->sig[i]) >> (0x09 - lanes->fb[i]);
+        else
+            lanes->sig[36 + i] = 0;
+
+        lanes->prout[i] = lanes->sig[i];
+    }
+
+    OPL3_LanesEnvelope(chip);
+    OPL3_LanesPhase(chip);
+
+#if OPL_QUIRK_CHANNELSAMPLEDELAY
+    OPL3_LanesGenerate(lanes, 0, 15);
+#else
+    OPL3_LanesGenerate(lanes, 0, 36);
+#endif
+
+    OPL3_LanesMix(chip, mix, 0);
+    chip->mixbuff[0] = mix[0];
+    chip->mixbuff[2] = mix[1];
+
+#if OPL_QUIRK_CHANNELSAMPLEDELAY
+    OPL3_LanesGenerate(lanes, 15, 18);
+#endif
+
+    buf4[0] = chip->mixbuff[0];
+    buf4[2] = chip->mixbuff[2];
+
+#if OPL_QUIRK_CHANNELSAMPLEDELAY
+    OPL3_LanesGenerate(lanes, 18, 33);
+#endif
+
+    OPL3_LanesMix(chip, mix, 1);
+    chip->mixbuff[1] = mix[0];
+    chip->mixbuff[3] = mix[1];
+
+#if OPL_QUIRK_CHANNELSAMPLEDELAY
+    OPL3_LanesGenerate(lanes, 33, 36);
+#endif
+
+    OPL3_ChipClock(chip);
+}
+
 static inline void
 OPL3_Generate4Ch(void *priv, int32_t *buf4)
 {
     opl3_chip     *chip = (opl3_chip *) priv;
     opl3_channel  *channel;
-    opl3_writebuf *writebuf;
     int16_t      **out;
     int32_t        mix[2];
     uint8_t        i;
     int16_t        accm;
-    uint8_t        shift = 0;
+
+    if (chip->lanes.on) {
+        OPL3_Generate4ChLanes(chip, buf4);
+        return;
+    }
 
     buf4[1] = chip->mixbuff[1];
     buf4[3] = chip->mixbuff[3];
@@ -1130,6 +1670,15 @@ OPL3_Generate4Ch(void *priv, int32_t *buf4)
         OPL3_ProcessSlot(&chip->slot[i]);
 #endif
 
+    OPL3_ChipClock(chip);
+}
+
+static void
+OPL3_ChipClock(opl3_chip *chip)
+{
+    opl3_writebuf *writebuf;
+    uint8_t        shift = 0;
+
     if ((chip->timer & 0x3f) == 0x3f)
         chip->tremolopos = (chip->tremolopos + 1) % 210;
 
@@ -1287,19 +1836,6 @@ OPL3_Reset(opl3_chip *chip, uint32_t samplerate)
 #endif
 }
 
-uint16_t
-nuked_write_addr(void *priv, uint16_t port, uint8_t val)
-{
-    const opl3_chip *chip = (opl3_chip *) priv;
-    uint16_t addr;
-
-    addr = val;
-    if ((port & 0x0002) && ((addr == 0x0005) || chip->newm))
-        addr |= 0x0100;
-
-    return addr;
-}
-
 void
 OPL3_WriteReg(void *priv, uint16_t reg, uint8_t val)
 {
@@ -1307,6 +1843,8 @@ OPL3_WriteReg(void *priv, uint16_t reg, uint8_t val)
     uint8_t    high = (reg >> 8) & 0x01;
     uint8_t    regm = reg & 0xff;
 
+    chip->lanes.dirty = 1;
+
     switch (regm & 0xf0) {
         case 0x00:
             if (high)
@@ -1534,42 +2072,119 @@ nuked_drv_set_do_cycles(void *priv, int8_t do_cycles)
         dev->flags &= ~FLAG_CYCLES;
 }
 
-static int32_t *
-nuked_drv_update(void *priv)
+/* Runs on the synthesis job. */
+static void
+nuked_drv_render(nuked_drv_t *dev, int pos)
 {
-    nuked_drv_t *dev = (nuked_drv_t *) priv;
-
-    if (dev->pos >= music_pos_global)
-        return dev->buffer;
+    if (dev->pos >= pos)
+        return;
 
-    OPL3_GenerateStream(&dev->opl,
-                        &dev->buffer[dev->pos * 2],
-                        music_pos_global - dev->pos);
+    if (dev->is_48k)
+        OPL3_GenerateResampledStream(&dev->opl,
+                                     &dev->buffer[dev->pos * 2],
+                                     pos - dev->pos);
+    else
+        OPL3_GenerateStream(&dev->opl,
+                            &dev->buffer[dev->pos * 2],
+                            pos - dev->pos);
 
-    for (; dev->pos < music_pos_global; dev->pos++) {
+    for (; dev->pos < pos; dev->pos++) {
         dev->buffer[dev->pos * 2] /= 2;
         dev->buffer[(dev->pos * 2) + 1] /= 2;
     }
-
-    return dev->buffer;
 }
 
-static int32_t *
-nuked_drv_update_48k(void *priv)
+static void
+nuked_drv_job(void *priv)
 {
     nuked_drv_t *dev = (nuked_drv_t *) priv;
+    uint32_t     rd  = atomic_load_explicit(&dev->queue_rd, memory_order_relaxed);
 
-    if (dev->pos >= sound_pos_global)
-        return dev->buffer;
+    while (rd != atomic_load_explicit(&dev->queue_wr, memory_order_acquire)) {
+        const nuked_cmd_t *cmd = &dev->queue[rd & (NUKED_QUEUE_SIZE - 1)];
 
-    OPL3_GenerateResampledStream(&dev->opl,
-                                 &dev->buffer[dev->pos * 2],
-                                 sound_pos_global - dev->pos);
+        switch (cmd->type) {
+            case NUKED_CMD_RENDER:
+                nuked_drv_render(dev, cmd->pos);
+                break;
 
-    for (; dev->pos < sound_pos_global; dev->pos++) {
-        dev->buffer[dev->pos * 2] /= 2;
-        dev->buffer[(dev->pos * 2) + 1] /= 2;
+            case NUKED_CMD_WRITE:
+                nuked_drv_render(dev, cmd->pos);
+                OPL3_WriteRegBuffered(&dev->opl, cmd->reg, cmd->val);
+                if (cmd->reg == 0x105)
+                    dev->opl.newm = cmd->val & 0x01;
+                break;
+
+            case NUKED_CMD_RESET:
+                dev->pos = 0;
+                break;
+
+            default:
+                break;
+        }
+
+        atomic_store_explicit(&dev->queue_rd, ++rd, memory_order_release);
+    }
+
+    thread_set_event(dev->done_event);
+}
+
+/* Waits until the synthesis job has carried out every queued command. */
+static void
+nuked_drv_sync(nuked_drv_t *dev)
+{
+    while (1) {
+        thread_reset_event(dev->done_event);
+        if (atomic_load_explicit(&dev->queue_rd, memory_order_acquire) ==
+            atomic_load_explicit(&dev->queue_wr, memory_order_relaxed))
+            break;
+
+        sound_job_submit(dev->job);
+        thread_wait_event(dev->done_event, -1);
     }
+}
+
+/*
+   The synthesis job replays the commands in order, rendering up to each
+   command's sample before carrying it out, so the output is the same as
+   rendering on the spot.
+ */
+static void
+nuked_drv_queue(nuked_drv_t *dev, uint8_t type, int pos, uint16_t reg, uint8_t val)
+{
+    const uint32_t wr = atomic_load_explicit(&dev->queue_wr, memory_order_relaxed);
+    nuked_cmd_t   *cmd;
+
+    if ((wr - atomic_load_explicit(&dev->queue_rd, memory_order_acquire)) == NUKED_QUEUE_SIZE)
+        nuked_drv_sync(dev);
+
+    cmd       = &dev->queue[wr & (NUKED_QUEUE_SIZE - 1)];
+    cmd->type = type;
+    cmd->pos  = pos;
+    cmd->reg  = reg;
+    cmd->val  = val;
+    atomic_store_explicit(&dev->queue_wr, wr + 1, memory_order_release);
+
+    if (type == NUKED_CMD_RESET)
+        dev->queued_pos = 0;
+    else if (pos > dev->queued_pos)
+        dev->queued_pos = pos;
+
+    /* Register writes are batched; a render is started right away so that it overlaps emulation. */
+    if ((type == NUKED_CMD_RENDER) || !((wr + 1) & (NUKED_QUEUE_BATCH - 1)))
+        sound_job_submit(dev->job);
+}
+
+static int32_t *
+nuked_drv_update(void *priv)
+{
+    nuked_drv_t *dev = (nuked_drv_t *) priv;
+    const int    pos = dev->get_pos();
+
+    if (pos > dev->queued_pos)
+        nuked_drv_queue(dev, NUKED_CMD_RENDER, pos, 0, 0);
+
+    nuked_drv_sync(dev);
 
     return dev->buffer;
 }
@@ -1578,11 +2193,14 @@ static uint8_t
 nuked_drv_read(uint16_t port, void *priv)
 {
     nuked_drv_t *dev = (nuked_drv_t *) priv;
+    const int    pos = dev->get_pos();
 
     if (dev->flags & FLAG_CYCLES)
         cycles -= ((int) (isa_timing * 8));
 
-    dev->update(dev);
+    /* The status only depends on the timers, so let the synthesis job catch up in the background. */
+    if (pos > dev->queued_pos)
+        nuked_drv_queue(dev, NUKED_CMD_RENDER, pos, 0, 0);
 
     uint8_t ret = 0xff;
 
@@ -1602,10 +2220,8 @@ nuked_drv_write(uint16_t port, uint8_t val, void *priv)
 {
     nuked_drv_t *dev = (nuked_drv_t *) priv;
 
-    dev->update(dev);
-
     if ((port & 0x0001) == 0x0001) {
-        OPL3_WriteRegBuffered(&dev->opl, dev->port, val);
+        nuked_drv_queue(dev, NUKED_CMD_WRITE, dev->get_pos(), dev->port, val);
 
         switch (dev->port) {
             case 0x002: /* Timer 1 */
@@ -1631,14 +2247,16 @@ nuked_drv_write(uint16_t port, uint8_t val, void *priv)
                 break;
 
             case 0x105:
-                dev->opl.newm = val & 0x01;
+                dev->newm = val & 0x01;
                 break;
 
             default:
                 break;
         }
     } else {
-        dev->port = nuked_write_addr(&dev->opl, port, val) & 0x01ff;
+        dev->port = val;
+        if ((port & 0x0002) && ((val == 0x05) || dev->newm))
+            dev->port |= 0x0100;
 
         if (!(dev->flags & FLAG_OPL3))
             dev->port &= 0x00ff;
@@ -1650,13 +2268,17 @@ nuked_drv_reset_buffer(void *priv)
 {
     nuked_drv_t *dev = (nuked_drv_t *) priv;
 
-    dev->pos = 0;
+    nuked_drv_queue(dev, NUKED_CMD_RESET, 0, 0, 0);
 }
 
 static void
 nuked_drv_close(void *priv)
 {
     nuked_drv_t *dev = (nuked_drv_t *) priv;
+
+    sound_job_close(dev->job);
+    thread_destroy_event(dev->done_event);
+
     free(dev);
 }
 
@@ -1674,16 +2296,24 @@ nuked_drv_init(const device_t *info)
 
     /* Initialize the NukedOPL object. */
     if (dev->is_48k) {
-        dev->update      = nuked_drv_update_48k;
+        dev->get_pos     = sound_get_pos;
         OPL3_Reset(&dev->opl, FREQ_48000);
     } else {
-        dev->update      = nuked_drv_update;
+        dev->get_pos     = music_get_pos;
         OPL3_Reset(&dev->opl, FREQ_49716);
     }
 
+    if (info->local & FM_NUKED_SIMD)
+        OPL3_LanesInit(&dev->opl);
+
     timer_add(&dev->timers[0], nuked_timer_1, dev, 0);
     timer_add(&dev->timers[1], nuked_timer_2, dev, 0);
 
+    atomic_init(&dev->queue_wr, 0);
+    atomic_init(&dev->queue_rd, 0);
+    dev->done_event = thread_create_event();
+    dev->job        = sound_job_create("OPL", nuked_drv_job, dev);
+
     return dev;
 }
 
@@ -1715,6 +2345,34 @@ const device_t ymf262_nuked_device = {
     .config        = NULL
 };
 
+const device_t ym3812_nuked_simd_device = {
+    .name          = "Yamaha YM3812 OPL2 (NUKED SIMD)",
+    .internal_name = "ym3812_nuked_simd",
+    .flags         = 0,
+    .local         = FM_YM3812 | FM_NUKED_SIMD,
+    .init          = nuked_drv_init,
+    .close         = nuked_drv_close,
+    .reset         = NULL,
+    .available     = NULL,
+    .speed_changed = NULL,
+    .force_redraw  = NULL,
+    .config        = NULL
+};
+
+const device_t ymf262_nuked_simd_device = {
+    .name          = "Yamaha YMF262 OPL3 (NUKED SIMD)",
+    .internal_name = "ymf262_nuked_simd",
+    .flags         = 0,
+    .local         = FM_YMF262 | FM_NUKED_SIMD,
+    .init          = nuked_drv_init,
+    .close         = nuked_drv_close,
+    .reset         = NULL,
+    .available     = NULL,
+    .speed_changed = NULL,
+    .force_redraw  = NULL,
+    .config        = NULL
+};
+
 const fm_drv_t nuked_opl_drv = {
     .read          = &nuked_drv_read,
     .write         = &nuked_drv_write,
@@ -1728,7 +2386,7 @@ const fm_drv_t nuked_opl_drv = {
 const fm_drv_t nuked_opl_drv_48k = {
     .read          = &nuked_drv_read,
     .write         = &nuked_drv_write,
-    .update        = &nuked_drv_update_48k,
+    .update        = &nuked_drv_update,
     .reset_buffer  = &nuked_drv_reset_buffer,
     .set_do_cycles = &nuked_drv_set_do_cycles,
     .priv          = NULL,
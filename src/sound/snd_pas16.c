@@ -1936,13 +1936,15 @@ pas16_input_sysex(void *priv, uint8_t *buffer, uint32_t len, int abort)
 static void
 pas16_update(pas16_t *pas16)
 {
+    const int pos = sound_get_pos();
+
     if (!(pas16->audiofilt & PAS16_FILT_MUTE)) {
-        for (; pas16->pos < sound_pos_global; pas16->pos++) {
+        for (; pas16->pos < pos; pas16->pos++) {
             pas16->pcm_buffer[0][pas16->pos] = 0;
             pas16->pcm_buffer[1][pas16->pos] = 0;
         }
     } else {
-        for (; pas16->pos < sound_pos_global; pas16->pos++) {
+        for (; pas16->pos < pos; pas16->pos++) {
             pas16->pcm_buffer[0][pas16->pos] = (int16_t) pas16->pcm_dat_l;
             pas16->pcm_buffer[1][pas16->pos] = (int16_t) pas16->pcm_dat_r;
         }
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -7,7 +8,12 @@
 #include <86box/plat.h>
 #include <86box/snd_resid.h>
 
-#define RESID_FREQ 48000
+#define RESID_FREQ  48000
+#define RESID_CLOCK 14318180 /* Divided by 16 for the SID clock. */
+
+/* Samples clocked at once; reSID may give one more or one fewer than asked for. */
+#define RESID_CHUNK 1024
+#define RESID_CARRY 16
 
 using reSIDfp::SID;
 
@@ -15,17 +21,24 @@ typedef struct psid_t {
     /* resid sid implementation */
     SID    *sid;
     int16_t last_sample;
-} psid_t;
 
-psid_t *psid;
+    /* Remainder of the SID cycles owed, in units of 1 / (16 * RESID_FREQ) cycle. */
+    uint32_t cycle_frac;
+
+    /* Samples reSID gave beyond those asked for, played first next time. */
+    int     carry_len;
+    int16_t carry[RESID_CARRY];
+    int16_t chunk[RESID_CHUNK + (RESID_CARRY * 2)];
+} psid_t;
 
 void *
-sid_init(uint8_t type, double range)
+sid_init(uint8_t type, double range, int sampling)
 {
-    reSIDfp::SamplingMethod method         = reSIDfp::RESAMPLE;
-    float                   cycles_per_sec = 14318180.0 / 16.0;
+    reSIDfp::SamplingMethod method         = sampling ? reSIDfp::RESAMPLE : reSIDfp::DECIMATE;
+    float                   cycles_per_sec = RESID_CLOCK / 16.0;
+    psid_t                 *psid;
 
-    psid      = new psid_t;
+    psid      = new psid_t();
     psid->sid = new SID;
 	psid->sid->setFilter6581Range(range);
 	psid->sid->reset();
@@ -60,17 +73,19 @@ sid_init(uint8_t type, double range)
 }
 
 void
-sid_close(UNUSED(void *priv))
+sid_close(void *priv)
 {
+    psid_t *psid = (psid_t *) priv;
+
     delete psid->sid;
-#if 0
-    free(psid);
-#endif
+    delete psid;
 }
 
 void
-sid_reset(UNUSED(void *priv))
+sid_reset(void *priv)
 {
+    psid_t *psid = (psid_t *) priv;
+
     psid->sid->reset();
 
     for (uint8_t c = 0; c < 32; c++)
@@ -78,32 +93,64 @@ sid_reset(UNUSED(void *priv))
 }
 
 uint8_t
-sid_read(uint16_t addr, UNUSED(void *priv))
+sid_read(uint16_t addr, void *priv)
 {
+    const psid_t *psid = (psid_t *) priv;
+
     return psid->sid->read(addr & 0x1f);
 }
 
 void
-sid_write(uint16_t addr, uint8_t val, UNUSED(void *priv))
+sid_write(uint16_t addr, uint8_t val, void *priv)
 {
+    const psid_t *psid = (psid_t *) priv;
+
     psid->sid->write(addr & 0x1f, val);
 }
 
-#define CLOCK_DELTA(n) (int) (((14318180.0 * n) / 16.0) / (float) RESID_FREQ)
-
+/*
+   Clocks the SID for exactly the time len samples take, carrying the
+   fraction of a cycle over to the next call so that the pitch is not
+   flattened by rounding every call down, and hands back exactly len
+   samples, keeping any reSID gave beyond that for the next call.
+ */
 static void
-fillbuf2(int &count, int16_t *buf, UNUSED(int len))
+fillbuf2(psid_t *psid, int16_t *buf, int len)
 {
-    int c = psid->sid->clock(count, buf);
+    const uint64_t owed   = ((uint64_t) len * RESID_CLOCK) + psid->cycle_frac;
+    const int      cycles = (int) (owed / (16 * RESID_FREQ));
+    int            got    = psid->carry_len;
+
+    psid->cycle_frac = (uint32_t) (owed % (16 * RESID_FREQ));
+
+    memcpy(psid->chunk, psid->carry, got * sizeof(int16_t));
+    got += psid->sid->clock(cycles, &psid->chunk[got]);
 
-    if (!c)
-        *buf = psid->last_sample;
-    psid->last_sample = *buf;
+    if (got > len) {
+        psid->carry_len = std::min(got - len, RESID_CARRY);
+        memcpy(psid->carry, &psid->chunk[len], psid->carry_len * sizeof(int16_t));
+        got = len;
+    } else
+        psid->carry_len = 0;
+
+    if (got > 0) {
+        memcpy(buf, psid->chunk, got * sizeof(int16_t));
+        psid->last_sample = buf[got - 1];
+    }
+    for (; got < len; got++)
+        buf[got] = psid->last_sample;
 }
+
 void
-sid_fillbuf(int16_t *buf, int len, UNUSED(void *priv))
+sid_fillbuf(int16_t *buf, int len, void *priv)
 {
-    int x = CLOCK_DELTA(len);
+    psid_t *psid = (psid_t *) priv;
+
+    while (len > 0) {
+        const int n = std::min(len, RESID_CHUNK);
 
-    fillbuf2(x, buf, len);
-}
\ No newline at end of file
+        fillbuf2(psid, buf, n);
+        buf += n;
+        len -= n;
+    }
+}
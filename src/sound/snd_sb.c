@@ -152,12 +152,17 @@ sb_get_buffer_sb2(int32_t *buffer, int len, void *priv)
     sb_t                    *sb    = (sb_t *) priv;
     const sb_ct1335_mixer_t *mixer = &sb->mixer_sb2;
     double                   out_mono;
+    float                    dac[SOUNDBUFLEN * 2];
 
     sb_dsp_update(&sb->dsp);
 
     if (sb->cms_enabled)
         cms_update(&sb->cms);
 
+    /* The DAC is mono, the right lane is filtered along but ignored. */
+    sound_mix_s16_to_float(dac, sb->dsp.buffer, len * 2);
+    sound_biquad_stereo(&sb->dsp.dac_filter, dac, len);
+
     for (int c = 0; c < len * 2; c += 2) {
         double out_l = 0.0;
         double out_r = 0.0;
@@ -176,9 +181,9 @@ sb_get_buffer_sb2(int32_t *buffer, int len, void *priv)
                  It is unclear from the docs if it has a filter, but it probably does. */
         /* TODO: Recording: Mic and line In with AGC. */
         if (sb->mixer_enabled)
-            out_mono = (sb_iir(0, 0, (double) sb->dsp.buffer[c]) * mixer->voice) / 3.9;
+            out_mono = (dac[c] * mixer->voice) / 3.9;
         else
-            out_mono = (((sb_iir(0, 0, (double) sb->dsp.buffer[c]) / 1.3) * 65536.0) / 3.0) / 65536.0;
+            out_mono = (((dac[c] / 1.3) * 65536.0) / 3.0) / 65536.0;
         out_l += out_mono;
         out_r += out_mono;
 
@@ -253,17 +258,23 @@ sb_get_buffer_sbpro(int32_t *buffer, const int len, void *priv)
 {
     sb_t                    *sb    = (sb_t *) priv;
     const sb_ct1345_mixer_t *mixer = &sb->mixer_sbpro;
+    float                    dac[SOUNDBUFLEN * 2];
 
     sb_dsp_update(&sb->dsp);
 
+    if (mixer->output_filter) {
+        sound_mix_s16_to_float(dac, sb->dsp.buffer, len * 2);
+        sound_biquad_stereo(&sb->dsp.dac_filter, dac, len);
+    }
+
     for (int c = 0; c < len * 2; c += 2) {
         double out_l = 0.0;
         double out_r = 0.0;
 
         /* TODO: Implement the stereo switch on the mixer instead of on the dsp? */
         if (mixer->output_filter) {
-            out_l += (sb_iir(0, 0, (double) sb->dsp.buffer[c]) * mixer->voice_l) / 3.9;
-            out_r += (sb_iir(0, 1, (double) sb->dsp.buffer[c + 1]) * mixer->voice_r) / 3.9;
+            out_l += (dac[c] * mixer->voice_l) / 3.9;
+            out_r += (dac[c + 1] * mixer->voice_r) / 3.9;
         } else {
             out_l += (sb->dsp.buffer[c] * mixer->voice_l) / 3.0;
             out_r += (sb->dsp.buffer[c + 1] * mixer->voice_r) / 3.0;
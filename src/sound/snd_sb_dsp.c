@@ -52,6 +52,19 @@ enum {
 void pollsb(void *priv);
 void sb_poll_i(void *priv);
 
+/* The 3.2 kHz Butterworth low-pass that sb_iir() applies, in filters.h layout. */
+static const double sb_dac_filter_b[3] = {
+    0.03356837051492005100,
+    0.06713674102984010200,
+    0.03356837051492005100
+};
+
+static const double sb_dac_filter_a[3] = {
+    1.00000000000000000000,
+    -1.41898265221812010000,
+    0.55326988968868285000
+};
+
 static int sbe2dat[4][9] = {
     {  0x01, -0x02, -0x04,  0x08, -0x10,  0x20,  0x40, -0x80, -106 },
     { -0x01,  0x02, -0x04,  0x08,  0x10, -0x20,  0x40, -0x80,  165 },
@@ -2207,6 +2220,8 @@ sb_dsp_init(sb_dsp_t *dsp, int type, int subtype, void *parent)
 
     sb_doreset(dsp);
 
+    sound_biquad_init(&dsp->dac_filter, sb_dac_filter_b, sb_dac_filter_a);
+
     timer_add(&dsp->output_timer, pollsb, dsp, 0);
     timer_add(&dsp->input_timer, sb_poll_i, dsp, 0);
     timer_add(&dsp->wb_timer, NULL, dsp, 0);
@@ -3056,11 +3071,13 @@ sb_poll_i(void *priv)
 void
 sb_dsp_update(sb_dsp_t *dsp)
 {
+    const int pos = sound_get_pos();
+
     if (dsp->muted) {
         dsp->sbdatl = 0;
         dsp->sbdatr = 0;
     }
-    for (; dsp->pos < sound_pos_global; dsp->pos++) {
+    for (; dsp->pos < pos; dsp->pos++) {
         dsp->buffer[dsp->pos * 2]     = dsp->sbdatl;
         dsp->buffer[dsp->pos * 2 + 1] = dsp->sbdatr;
     }
@@ -1,4 +1,5 @@
 #include <stdarg.h>
+#include <stdatomic.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -12,50 +13,187 @@
 #include <86box/io.h>
 #include <86box/snd_resid.h>
 #include <86box/sound.h>
+#include <86box/sound_ring.h>
+#include <86box/sound_worker.h>
+#include <86box/thread.h>
 #include <86box/plat_unused.h>
 
+/*
+   Register writes are queued with the sample they were made at, and a
+   sound worker job replays them, clocking the SID up to each write
+   before carrying it out. The job renders a block while the emulation
+   carries on with the next one, and hands the finished block straight to
+   the mixer through a ring, which starts a block of silence ahead so the
+   block is mixed one block later. The emulation thread only waits on a
+   read of the SID, which needs its state up to date, or when the queue
+   is full.
+ */
+#define SSI2001_QUEUE_SIZE  1024 /* Must be a power of 2. */
+#define SSI2001_QUEUE_BATCH 64   /* Commands queued between wake-ups of the job. */
+
+enum {
+    SSI2001_CMD_RENDER = 0,
+    SSI2001_CMD_WRITE,
+    SSI2001_CMD_END /* End of the block; pos is its length. */
+};
+
+typedef struct ssi2001_cmd_t {
+    int     pos;
+    uint8_t type;
+    uint8_t reg;
+    uint8_t val;
+} ssi2001_cmd_t;
+
 typedef struct ssi2001_t {
     void   *psid;
-    int16_t buffer[SOUNDBUFLEN * 2];
-    int     pos;
+    int16_t buffer[SOUNDBUFLEN];
+    int32_t out[SOUNDBUFLEN * 2];
     int     gameport_enabled;
+
+    /* Render side. */
+    int           pos;
+    sound_ring_t *ring;
+
+    /* Emulation side. */
+    int queued_pos;
+
+    sound_job_t  *job;
+    event_t      *done_event;
+    atomic_uint   queue_wr;
+    atomic_uint   queue_rd;
+    ssi2001_cmd_t queue[SSI2001_QUEUE_SIZE];
 } ssi2001_t;
 
 typedef struct entertainer_t {
     uint8_t regs;
 } entertainer_t;
 
+#ifdef ENABLE_SSI2001_LOG
+int ssi2001_do_log = ENABLE_SSI2001_LOG;
+
 static void
-ssi2001_update(ssi2001_t *ssi2001)
+ssi2001_log(const char *fmt, ...)
 {
-    if (ssi2001->pos >= sound_pos_global)
+    va_list ap;
+
+    if (ssi2001_do_log) {
+        va_start(ap, fmt);
+        pclog_ex(fmt, ap);
+        va_end(ap);
+    }
+}
+#else
+#    define ssi2001_log(fmt, ...)
+#endif
+
+/* Runs on a sound worker. */
+static void
+ssi2001_render(ssi2001_t *ssi2001, int pos)
+{
+    if (pos > SOUNDBUFLEN)
+        pos = SOUNDBUFLEN;
+    if (ssi2001->pos >= pos)
         return;
 
-    sid_fillbuf(&ssi2001->buffer[ssi2001->pos], sound_pos_global - ssi2001->pos, ssi2001->psid);
-    ssi2001->pos = sound_pos_global;
+    sid_fillbuf(&ssi2001->buffer[ssi2001->pos], pos - ssi2001->pos, ssi2001->psid);
+    ssi2001->pos = pos;
 }
 
 static void
-ssi2001_get_buffer(int32_t *buffer, int len, void *priv)
+ssi2001_job_run(void *priv)
 {
     ssi2001_t *ssi2001 = (ssi2001_t *) priv;
+    uint32_t   rd      = atomic_load_explicit(&ssi2001->queue_rd, memory_order_relaxed);
+
+    while (rd != atomic_load_explicit(&ssi2001->queue_wr, memory_order_acquire)) {
+        const ssi2001_cmd_t *cmd = &ssi2001->queue[rd & (SSI2001_QUEUE_SIZE - 1)];
+
+        ssi2001_render(ssi2001, cmd->pos);
+
+        switch (cmd->type) {
+            case SSI2001_CMD_WRITE:
+                sid_write(cmd->reg, cmd->val, ssi2001->psid);
+                break;
+
+            case SSI2001_CMD_END:
+                for (int c = 0; c < (cmd->pos * 2); c++)
+                    ssi2001->out[c] = ssi2001->buffer[c >> 1] / 2;
+                if ((ssi2001->ring != NULL) && !sound_ring_write(ssi2001->ring, ssi2001->out, cmd->pos * 2))
+                    ssi2001_log("SID: mixer behind, block dropped\n");
+                ssi2001->pos = 0;
+                break;
 
-    ssi2001_update(ssi2001);
+            default:
+                break;
+        }
 
-    for (int c = 0; c < len * 2; c++)
-        buffer[c] += ssi2001->buffer[c >> 1] / 2;
+        atomic_store_explicit(&ssi2001->queue_rd, ++rd, memory_order_release);
+    }
 
-    ssi2001->pos = 0;
+    thread_set_event(ssi2001->done_event);
+}
+
+/* Waits until the job has carried out every command queued before queue position wr. */
+static void
+ssi2001_sync(ssi2001_t *ssi2001, uint32_t wr)
+{
+    while (1) {
+        thread_reset_event(ssi2001->done_event);
+        if ((int32_t) (atomic_load_explicit(&ssi2001->queue_rd, memory_order_acquire) - wr) >= 0)
+            break;
+
+        sound_job_submit(ssi2001->job);
+        thread_wait_event(ssi2001->done_event, -1);
+    }
+}
+
+static void
+ssi2001_queue(ssi2001_t *ssi2001, uint8_t type, int pos, uint8_t reg, uint8_t val)
+{
+    const uint32_t wr = atomic_load_explicit(&ssi2001->queue_wr, memory_order_relaxed);
+    ssi2001_cmd_t *cmd;
+
+    if ((wr - atomic_load_explicit(&ssi2001->queue_rd, memory_order_acquire)) == SSI2001_QUEUE_SIZE)
+        ssi2001_sync(ssi2001, wr);
+
+    cmd       = &ssi2001->queue[wr & (SSI2001_QUEUE_SIZE - 1)];
+    cmd->type = type;
+    cmd->pos  = pos;
+    cmd->reg  = reg;
+    cmd->val  = val;
+    atomic_store_explicit(&ssi2001->queue_wr, wr + 1, memory_order_release);
+
+    if (type == SSI2001_CMD_END)
+        ssi2001->queued_pos = 0;
+    else if (pos > ssi2001->queued_pos)
+        ssi2001->queued_pos = pos;
+
+    if (!((wr + 1) & (SSI2001_QUEUE_BATCH - 1)))
+        sound_job_submit(ssi2001->job);
+}
+
+/* Only ends the block; the job writes it to the ring, which the mixer adds to the sound stream. */
+static void
+ssi2001_get_buffer(UNUSED(int32_t *buffer), int len, void *priv)
+{
+    ssi2001_t *ssi2001 = (ssi2001_t *) priv;
+
+    ssi2001_queue(ssi2001, SSI2001_CMD_END, len, 0, 0);
+    sound_job_submit(ssi2001->job);
 }
 
 static uint8_t
 ssi2001_read(uint16_t addr, void *priv)
 {
     ssi2001_t *ssi2001 = (ssi2001_t *) priv;
+    const int  pos     = sound_get_pos();
 
-    ssi2001_update(ssi2001);
+    /* OSC3 and ENV3 give the state of the voice at this very sample. */
+    if (pos > ssi2001->queued_pos)
+        ssi2001_queue(ssi2001, SSI2001_CMD_RENDER, pos, 0, 0);
+    ssi2001_sync(ssi2001, atomic_load_explicit(&ssi2001->queue_wr, memory_order_relaxed));
 
-    return sid_read(addr, priv);
+    return sid_read(addr, ssi2001->psid);
 }
 
 static void
@@ -63,8 +201,31 @@ ssi2001_write(uint16_t addr, uint8_t val, void *priv)
 {
     ssi2001_t *ssi2001 = (ssi2001_t *) priv;
 
-    ssi2001_update(ssi2001);
-    sid_write(addr, val, priv);
+    ssi2001_queue(ssi2001, SSI2001_CMD_WRITE, sound_get_pos(), addr & 0x1f, val);
+}
+
+static void
+ssi2001_start(ssi2001_t *ssi2001, uint8_t type, double range, int sampling)
+{
+    ssi2001->psid = sid_init(type, range, sampling);
+    sid_reset(ssi2001->psid);
+
+    /* One block of silence puts the mixer a block behind the job. */
+    ssi2001->ring = sound_add_ring();
+    if (ssi2001->ring != NULL)
+        sound_ring_write(ssi2001->ring, ssi2001->out, SOUNDBUFLEN * 2);
+
+    ssi2001->done_event = thread_create_event();
+    ssi2001->job        = sound_job_create("SID", ssi2001_job_run, ssi2001);
+}
+
+static void
+ssi2001_stop(ssi2001_t *ssi2001)
+{
+    sound_job_close(ssi2001->job);
+    thread_destroy_event(ssi2001->done_event);
+
+    sid_close(ssi2001->psid);
 }
 
 void *
@@ -72,8 +233,8 @@ ssi2001_init(UNUSED(const device_t *info))
 {
     ssi2001_t *ssi2001 = calloc(1, sizeof(ssi2001_t));
 
-    ssi2001->psid = sid_init(device_get_config_int("sid_config"),device_get_config_int("sid_adjustment"));
-    sid_reset(ssi2001->psid);
+    ssi2001_start(ssi2001, device_get_config_int("sid_config"), device_get_config_int("sid_adjustment"),
+                  device_get_config_int("sid_sampling"));
     uint16_t addr             = device_get_config_hex16("base");
     ssi2001->gameport_enabled = device_get_config_int("gameport");
     io_sethandler(addr, 0x0020, ssi2001_read, NULL, NULL, ssi2001_write, NULL, NULL, ssi2001);
@@ -88,7 +249,7 @@ ssi2001_close(void *priv)
 {
     ssi2001_t *ssi2001 = (ssi2001_t *) priv;
 
-    sid_close(ssi2001->psid);
+    ssi2001_stop(ssi2001);
 
     free(ssi2001);
 }
@@ -112,8 +273,7 @@ entertainer_init(UNUSED(const device_t *info))
     ssi2001_t     *ssi2001     = calloc(1, sizeof(ssi2001_t));
     entertainer_t *entertainer = calloc(1, sizeof(entertainer_t));
 
-    ssi2001->psid = sid_init(0, 0.5);
-    sid_reset(ssi2001->psid);
+    ssi2001_start(ssi2001, 0, 0.5, device_get_config_int("sid_sampling"));
     ssi2001->gameport_enabled = device_get_config_int("gameport");
     io_sethandler(0x200, 0x0001, entertainer_read, NULL, NULL, entertainer_write, NULL, NULL, entertainer);
     io_sethandler(0x280, 0x0020, ssi2001_read, NULL, NULL, ssi2001_write, NULL, NULL, ssi2001);
@@ -128,7 +288,7 @@ entertainer_close(void *priv)
 {
     ssi2001_t *ssi2001 = (ssi2001_t *) priv;
 
-    sid_close(ssi2001->psid);
+    ssi2001_stop(ssi2001);
 
     free(ssi2001);
 }
@@ -189,6 +349,21 @@ static const device_config_t ssi2001_config[] = {
         .selection      = {{"0.5"}},
         .bios           = { { 0 } }
     },
+    {
+        .name           = "sid_sampling",
+        .description    = "SID Sampling",
+        .type           = CONFIG_SELECTION,
+        .default_string = NULL,
+        .default_int    = 1,
+        .file_filter    = NULL,
+        .spinner        = { 0 },
+        .selection      = {
+            { .description = "Fast",      .value = 0 },
+            { .description = "Resampled", .value = 1 },
+            { .description = ""                      }
+        },
+        .bios           = { { 0 } }
+    },
     { .name = "", .description = "", .type = CONFIG_END }
 // clang-format off
 };
@@ -206,6 +381,21 @@ static const device_config_t entertainer_config[] = {
         .selection      = { { 0 } },
         .bios           = { { 0 } }
     },
+    {
+        .name           = "sid_sampling",
+        .description    = "SID Sampling",
+        .type           = CONFIG_SELECTION,
+        .default_string = NULL,
+        .default_int    = 1,
+        .file_filter    = NULL,
+        .spinner        = { 0 },
+        .selection      = {
+            { .description = "Fast",      .value = 0 },
+            { .description = "Resampled", .value = 1 },
+            { .description = ""                      }
+        },
+        .bios           = { { 0 } }
+    },
     { .name = "", .description = "", .type = CONFIG_END }
 // clang-format off
 };
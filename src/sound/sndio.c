@@ -25,15 +25,12 @@
 #include <86box/plat_unused.h>
 
 #define I_NORMAL 0
-#define I_MUSIC 1
-#define I_WT 2
-#define I_CD 3
-#define I_MIDI 4
-#define I_FDD 5
+#define I_MIDI 1
+#define I_FDD 2
 
-static struct sio_hdl* audio[6] = {NULL, NULL, NULL, NULL, NULL, NULL};
-static struct sio_par  info[6];
-static int             freqs[6] = { SOUND_FREQ, MUSIC_FREQ, WT_FREQ, CD_FREQ, SOUND_FREQ, 0 };
+static struct sio_hdl* audio[3] = {NULL, NULL, NULL};
+static struct sio_par  info[3];
+static int             freqs[3] = { SOUND_FREQ, 0, SOUND_FREQ };
 
 void
 closeal(void)
@@ -49,6 +46,8 @@ closeal(void)
 void
 inital(void)
 {
+    freqs[I_NORMAL] = sound_output_freq;
+
     for (int i = 0; i < sizeof(audio) / sizeof(audio[0]); i++) {
         audio[i] = sio_open(SIO_DEVANY, SIO_PLAY, 0);
         if (audio[i] != NULL) {
@@ -121,25 +120,7 @@ givealbuffer_common(const void *buf, const uint8_t src, const int size)
 void
 givealbuffer(const void *buf)
 {
-    givealbuffer_common(buf, I_NORMAL, SOUNDBUFLEN << 1);
-}
-
-void
-givealbuffer_music(const void *buf)
-{
-    givealbuffer_common(buf, I_MUSIC, MUSICBUFLEN << 1);
-}
-
-void
-givealbuffer_wt(const void *buf)
-{
-    givealbuffer_common(buf, I_WT, WTBUFLEN << 1);
-}
-
-void
-givealbuffer_cd(const void *buf)
-{
-    givealbuffer_common(buf, I_CD, CD_BUFLEN << 1);
+    givealbuffer_common(buf, I_NORMAL, SOUND_OUTPUT_BUFLEN << 1);
 }
 
 void
@@ -18,6 +18,7 @@
  */
 #include <math.h>
 #include <stdarg.h>
+#include <stdatomic.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -36,6 +37,10 @@
 #include <86box/timer.h>
 #include <86box/snd_mpu401.h>
 #include <86box/sound.h>
+#include <86box/sound_mix.h>
+#include <86box/sound_resample.h>
+#include <86box/sound_ring.h>
+#include <86box/sound_worker.h>
 #include <86box/fdd_audio.h>
 
 typedef struct {
@@ -47,11 +52,46 @@ typedef struct {
     void *priv;
 } sound_handler_t;
 
+/*
+   Source streams. The emulation thread (the CD audio job for the CD
+   stream) mixes the handlers of a stream into a block at the stream's own
+   rate and queues it. The mixer job adds the ring sources, converts the
+   block to the output rate and queues the result in pending. Each block
+   of the sound stream then takes one output block from every stream and
+   hands the sum to the audio backend, so the backend plays one stream.
+ */
+#define SOUND_MIX_BLOCKS 4
+#define SOUND_RINGS_MAX  8
+
+typedef struct sound_stream_t {
+    int         freq;
+    int         len;
+    const char *name;
+
+    sound_ring_t *blocks;
+    sound_ring_t *rings[SOUND_RINGS_MAX];
+    atomic_int    rings_num;
+
+    int32_t *mix;
+
+    sound_resampler_t *resampler; /* NULL when the stream is at the output rate. */
+    int32_t           *conv;
+    sound_ring_t      *pending;
+    uint32_t           prime;
+    int                primed;
+} sound_stream_t;
+
+enum {
+    SOUND_STREAM_SOUND = 0,
+    SOUND_STREAM_MUSIC,
+    SOUND_STREAM_WAVETABLE,
+    SOUND_STREAM_CD,
+    SOUND_STREAM_MAX
+};
+
 int sound_card_current[SOUND_CARD_MAX] = { 0, 0, 0, 0 };
-int sound_pos_global                   = 0;
-int music_pos_global                   = 0;
-int wavetable_pos_global               = 0;
 int sound_gain                         = 0;
+int sound_output_freq                  = SOUND_FREQ;
 
 static sound_handler_t sound_handlers[8];
 static sound_handler_t music_handlers[8];
@@ -59,40 +99,53 @@ static sound_handler_t wavetable_handlers[8];
 
 static double     cd_audio_volume_lut[256];
 
-static thread_t  *sound_cd_thread_h;
-static event_t   *sound_cd_event;
-static event_t   *sound_cd_start_event;
+static sound_job_t *sound_cd_job;
 static int32_t   *outbuffer;
-static float     *outbuffer_ex;
-static int16_t   *outbuffer_ex_int16;
 static int32_t   *outbuffer_m;
-static float     *outbuffer_m_ex;
-static int16_t   *outbuffer_m_ex_int16;
 static int32_t   *outbuffer_w;
-static float     *outbuffer_w_ex;
-static int16_t   *outbuffer_w_ex_int16;
 static int        sound_handlers_num;
 static int        music_handlers_num;
 static int        wavetable_handlers_num;
+/*
+   The poll timers fire once per block of samples rather than once per
+   sample; the position within the current buffer, which the devices use
+   to catch up, is worked out from the TSC by sound_get_pos() and friends.
+   The sound timer fires twice per buffer so that the MIDI devices still
+   get polled every 10 ms.
+ */
+#define SOUND_POLL_LEN (SOUNDBUFLEN / 2)
+
 static pc_timer_t sound_poll_timer;
 static uint64_t   sound_poll_latch;
+static int        sound_poll_half;
 static pc_timer_t music_poll_timer;
 static uint64_t   music_poll_latch;
 static pc_timer_t wavetable_poll_timer;
 static uint64_t   wavetable_poll_latch;
 
 static int16_t      cd_buffer[CDROM_NUM][CD_BUFLEN * 2];
-static float        cd_out_buffer[CD_BUFLEN * 2];
-static int16_t      cd_out_buffer_int16[CD_BUFLEN * 2];
+static int32_t      cd_out_buffer[CD_BUFLEN * 2];
 static unsigned int cd_vol_l;
 static unsigned int cd_vol_r;
 static int          cd_buf_update    = CD_BUFLEN / SOUNDBUFLEN;
 static volatile int cdaudioon        = 0;
 static int          cd_thread_enable = 0;
 
-static thread_t     *sound_fdd_thread_h;
-static event_t      *sound_fdd_event;
-static event_t      *sound_fdd_start_event;
+static sound_stream_t sound_streams[SOUND_STREAM_MAX] = {
+    { .freq = SOUND_FREQ, .len = SOUNDBUFLEN, .name = "sound"     },
+    { .freq = MUSIC_FREQ, .len = MUSICBUFLEN, .name = "music"     },
+    { .freq = WT_FREQ,    .len = WTBUFLEN,    .name = "wavetable" },
+    { .freq = CD_FREQ,    .len = CD_BUFLEN,   .name = "CD audio"  }
+};
+
+static int32_t *sound_out_mix;
+static float   *sound_out;
+static int16_t *sound_out_int16;
+
+static sound_job_t  *sound_mix_job;
+static volatile int sound_mix_on = 0;
+
+static sound_job_t  *sound_fdd_job;
 static volatile int fddaudioon = 0;
 static int          fdd_thread_enable = 0;
 
@@ -273,195 +326,276 @@ sound_set_cd_volume(unsigned int vol_l, unsigned int vol_r)
     cd_vol_r = vol_r;
 }
 
-static void
-sound_cd_clean_buffers(void)
-{
-    if (sound_is_float)
-        memset(cd_out_buffer, 0, (CD_BUFLEN * 2) * sizeof(float));
-    else
-        memset(cd_out_buffer_int16, 0, (CD_BUFLEN * 2) * sizeof(int16_t));
-}
+static void sound_stream_push(sound_stream_t *stream, const int32_t *buf);
 
+/* Renders one block of CD audio from every playing drive; run on the sound workers. */
 static void
-sound_cd_thread(UNUSED(void *param))
+sound_cd_job_run(UNUSED(void *priv))
 {
-    int      temp_buffer[2];
     int      channel_select[2];
     double   audio_vol_l;
     double   audio_vol_r;
     double   cd_buffer_temp[2] = { 0.0, 0.0 };
 
-    thread_set_event(sound_cd_start_event);
+    if (!cdaudioon)
+        return;
 
-    while (cdaudioon) {
-        thread_wait_event(sound_cd_event, -1);
-        thread_reset_event(sound_cd_event);
+    memset(cd_out_buffer, 0, sizeof(cd_out_buffer));
 
+    for (uint8_t i = 0; i < CDROM_NUM; i++) {
+        /* Just in case the job is in a loop when it gets ended. */
         if (!cdaudioon)
-            return;
+            break;
 
-        sound_cd_clean_buffers();
+        if ((cdrom[i].bus_type == CDROM_BUS_DISABLED) ||
+            (cdrom[i].cd_status != CD_STATUS_PLAYING))
+            continue;
+        const int ret = cdrom_audio_callback(&(cdrom[i]), cd_buffer[i],
+                                             CD_BUFLEN * 2);
+
+        if (ret) {
+            if (cdrom[i].get_volume) {
+                audio_vol_l = cd_audio_volume_lut[cdrom[i].get_volume(cdrom[i].priv, 0)];
+                audio_vol_r = cd_audio_volume_lut[cdrom[i].get_volume(cdrom[i].priv, 1)];
+            } else {
+                audio_vol_l = cd_audio_volume_lut[255];
+                audio_vol_r = cd_audio_volume_lut[255];
+            }
 
-        temp_buffer[0] = temp_buffer[1] = 0;
+            if (cdrom[i].get_channel) {
+                channel_select[0] = (int) cdrom[i].get_channel(cdrom[i].priv, 0);
+                channel_select[1] = (int) cdrom[i].get_channel(cdrom[i].priv, 1);
+            } else {
+                channel_select[0] = 1;
+                channel_select[1] = 2;
+            }
 
-        for (uint8_t i = 0; i < CDROM_NUM; i++) {
-            /* Just in case the thread is in a loop when it gets terminated. */
-            if (!cdaudioon)
-                break;
+            // uint16_t *cddab = (uint16_t *) cdrom[i].raw_buffer;
+            for (int c = 0; c < CD_BUFLEN * 2; c += 2) {
+                /* Apply ATAPI channel select */
+                cd_buffer_temp[0] = cd_buffer_temp[1] = 0.0;
+
+                if ((audio_vol_l != 0.0) && (channel_select[0] != 0)) {
+                    if (channel_select[0] & 1)
+                        /* Channel 0 => Port 0 */
+                        cd_buffer_temp[0] += ((double) cd_buffer[i][c]);
+                    if (channel_select[0] & 2)
+                        /* Channel 1 => Port 0 */
+                        cd_buffer_temp[0] += ((double) cd_buffer[i][c + 1]);
+
+                    /* Multiply Port 0 by Port 0 volume */
+                    cd_buffer_temp[0] *= audio_vol_l;
+                }
 
-            if ((cdrom[i].bus_type == CDROM_BUS_DISABLED) ||
-                (cdrom[i].cd_status != CD_STATUS_PLAYING))
-                continue;
-            const int ret = cdrom_audio_callback(&(cdrom[i]), cd_buffer[i],
-                                                 CD_BUFLEN * 2);
+                if ((audio_vol_r != 0.0) && (channel_select[1] != 0)) {
+                    if (channel_select[1] & 1)
+                        /* Channel 0 => Port 1 */
+                        cd_buffer_temp[1] += ((double) cd_buffer[i][c]);
+                    if (channel_select[1] & 2)
+                        /* Channel 1 => Port 1 */
+                        cd_buffer_temp[1] += ((double) cd_buffer[i][c + 1]);
 
-            if (ret) {
-                if (cdrom[i].get_volume) {
-                    audio_vol_l = cd_audio_volume_lut[cdrom[i].get_volume(cdrom[i].priv, 0)];
-                    audio_vol_r = cd_audio_volume_lut[cdrom[i].get_volume(cdrom[i].priv, 1)];
-                } else {
-                    audio_vol_l = cd_audio_volume_lut[255];
-                    audio_vol_r = cd_audio_volume_lut[255];
+                    /* Multiply Port 1 by Port 1 volume */
+                    cd_buffer_temp[1] *= audio_vol_r;
                 }
 
-                if (cdrom[i].get_channel) {
-                    channel_select[0] = (int) cdrom[i].get_channel(cdrom[i].priv, 0);
-                    channel_select[1] = (int) cdrom[i].get_channel(cdrom[i].priv, 1);
-                } else {
-                    channel_select[0] = 1;
-                    channel_select[1] = 2;
+                /* Apply sound card CD volume and filters */
+                if (filter_cd_audio != NULL) {
+                    filter_cd_audio(0, &(cd_buffer_temp[0]),
+                                    filter_cd_audio_p);
+                    filter_cd_audio(1, &(cd_buffer_temp[1]),
+                                    filter_cd_audio_p);
                 }
 
-                // uint16_t *cddab = (uint16_t *) cdrom[i].raw_buffer;
-                for (int c = 0; c < CD_BUFLEN * 2; c += 2) {
-                    /* Apply ATAPI channel select */
-                    cd_buffer_temp[0] = cd_buffer_temp[1] = 0.0;
-
-                    if ((audio_vol_l != 0.0) && (channel_select[0] != 0)) {
-                        if (channel_select[0] & 1)
-                            /* Channel 0 => Port 0 */
-                            cd_buffer_temp[0] += ((double) cd_buffer[i][c]);
-                        if (channel_select[0] & 2)
-                            /* Channel 1 => Port 0 */
-                            cd_buffer_temp[0] += ((double) cd_buffer[i][c + 1]);
-
-                        /* Multiply Port 0 by Port 0 volume */
-                        cd_buffer_temp[0] *= audio_vol_l;
-                    }
-
-                    if ((audio_vol_r != 0.0) && (channel_select[1] != 0)) {
-                        if (channel_select[1] & 1)
-                            /* Channel 0 => Port 1 */
-                            cd_buffer_temp[1] += ((double) cd_buffer[i][c]);
-                        if (channel_select[1] & 2)
-                            /* Channel 1 => Port 1 */
-                            cd_buffer_temp[1] += ((double) cd_buffer[i][c + 1]);
-
-                        /* Multiply Port 1 by Port 1 volume */
-                        cd_buffer_temp[1] *= audio_vol_r;
-                    }
-
-                    /* Apply sound card CD volume and filters */
-                    if (filter_cd_audio != NULL) {
-                        filter_cd_audio(0, &(cd_buffer_temp[0]),
-                                        filter_cd_audio_p);
-                        filter_cd_audio(1, &(cd_buffer_temp[1]),
-                                        filter_cd_audio_p);
-                    }
-
-                    if (sound_is_float) {
-                        cd_out_buffer[c] += (float) (cd_buffer_temp[0] / 32768.0);
-                        cd_out_buffer[c + 1] += (float) (cd_buffer_temp[1] / 32768.0);
-                    } else {
-                        temp_buffer[0] = (int) trunc(cd_buffer_temp[0]);
-                        temp_buffer[1] = (int) trunc(cd_buffer_temp[1]);
-
-                        if (temp_buffer[0] > 32767)
-                            temp_buffer[0] = 32767;
-                        if (temp_buffer[0] < -32768)
-                            temp_buffer[0] = -32768;
-                        if (temp_buffer[1] > 32767)
-                            temp_buffer[1] = 32767;
-                        if (temp_buffer[1] < -32768)
-                            temp_buffer[1] = -32768;
-
-                        cd_out_buffer_int16[c]     += (int16_t) temp_buffer[0];
-                        cd_out_buffer_int16[c + 1] += (int16_t) temp_buffer[1];
-                    }
-                }
+                /* Saturated along with the rest of the output, when it is converted. */
+                cd_out_buffer[c]     += (int32_t) trunc(cd_buffer_temp[0]);
+                cd_out_buffer[c + 1] += (int32_t) trunc(cd_buffer_temp[1]);
             }
         }
-
-        if (sound_is_float)
-            givealbuffer_cd(cd_out_buffer);
-        else
-            givealbuffer_cd(cd_out_buffer_int16);
     }
+
+    sound_stream_push(&sound_streams[SOUND_STREAM_CD], cd_out_buffer);
 }
 
 static void
-sound_realloc_buffers(void)
+sound_stream_realloc(sound_stream_t *stream)
 {
-    if (outbuffer_ex != NULL) {
-        free(outbuffer_ex);
-        outbuffer_ex = NULL;
+    const uint32_t out_len   = SOUND_OUTPUT_BUFLEN;
+    const uint32_t block_len = (uint32_t) (((int64_t) stream->len * sound_output_freq) / stream->freq) + 1;
+
+    if (stream->mix == NULL)
+        stream->mix = calloc(stream->len * 2, sizeof(int32_t));
+
+    if (stream->blocks == NULL)
+        stream->blocks = sound_ring_create(stream->len * 2 * SOUND_MIX_BLOCKS);
+    else
+        sound_ring_flush(stream->blocks);
+
+    for (int i = 0; i < atomic_load(&stream->rings_num); i++) {
+        sound_ring_close(stream->rings[i]);
+        stream->rings[i] = NULL;
     }
+    atomic_store(&stream->rings_num, 0);
 
-    if (outbuffer_ex_int16 != NULL) {
-        free(outbuffer_ex_int16);
-        outbuffer_ex_int16 = NULL;
+    sound_resampler_close(stream->resampler);
+    stream->resampler = NULL;
+    free(stream->conv);
+    stream->conv = NULL;
+    sound_ring_close(stream->pending);
+
+    if (stream->freq != sound_output_freq) {
+        stream->resampler = sound_resampler_create(stream->freq, sound_output_freq);
+        stream->conv      = calloc(sound_resampler_out_max(stream->resampler, stream->len) * 2, sizeof(int32_t));
     }
 
-    if (sound_is_float) {
-        outbuffer_ex = calloc(SOUNDBUFLEN * 2, sizeof(float));
-        memset(outbuffer_ex, 0x00, SOUNDBUFLEN * 2 * sizeof(float));
-    } else {
-        outbuffer_ex_int16 = calloc(SOUNDBUFLEN * 2, sizeof(int16_t));
-        memset(outbuffer_ex_int16, 0x00, SOUNDBUFLEN * 2 * sizeof(int16_t));
+    /* A stream starts once a block of its own and an output block are queued, see sound_stream_mix_pending(). */
+    stream->pending = sound_ring_create((block_len + out_len) * 2 * SOUND_MIX_BLOCKS);
+    stream->prime   = (block_len + out_len) * 2;
+    stream->primed  = 0;
+}
+
+static void
+sound_output_realloc(void)
+{
+    free(sound_out_mix);
+    free(sound_out);
+    sound_out = NULL;
+    free(sound_out_int16);
+    sound_out_int16 = NULL;
+
+    sound_out_mix = calloc(SOUND_OUTPUT_BUFLEN * 2, sizeof(int32_t));
+    if (sound_is_float)
+        sound_out = calloc(SOUND_OUTPUT_BUFLEN * 2, sizeof(float));
+    else
+        sound_out_int16 = calloc(SOUND_OUTPUT_BUFLEN * 2, sizeof(int16_t));
+}
+
+/* Adds the ring sources to a block in stream->mix and queues it at the output rate. */
+static void
+sound_stream_convert(sound_stream_t *stream)
+{
+    const int      rings_num = atomic_load(&stream->rings_num);
+    const int32_t *buf       = stream->mix;
+    int            frames    = stream->len;
+
+    for (int i = 0; i < rings_num; i++)
+        sound_ring_mix(stream->rings[i], stream->mix, stream->len * 2);
+
+    if (stream->resampler != NULL) {
+        frames = sound_resampler_process(stream->resampler, stream->mix, stream->len, stream->conv);
+        buf    = stream->conv;
     }
+
+    if (!sound_ring_write(stream->pending, buf, frames * 2))
+        sound_log("Sound: %s stream overrun, block dropped\n", stream->name);
 }
 
+/*
+   Adds the queued samples of a secondary stream to an output block. These
+   streams deliver blocks of a different length on their own schedule, so
+   a stream waits until a block of its own plus an output block is queued
+   before it joins the mix, and after an underrun waits again rather than
+   playing with a gap in every block.
+ */
 static void
-music_realloc_buffers(void)
+sound_stream_mix_pending(sound_stream_t *stream, int32_t *buf, uint32_t len)
 {
-    if (outbuffer_m_ex != NULL) {
-        free(outbuffer_m_ex);
-        outbuffer_m_ex = NULL;
+    if (!stream->primed) {
+        if (sound_ring_fill(stream->pending) < stream->prime)
+            return;
+
+        stream->primed = 1;
     }
 
-    if (outbuffer_m_ex_int16 != NULL) {
-        free(outbuffer_m_ex_int16);
-        outbuffer_m_ex_int16 = NULL;
+    if (sound_ring_mix(stream->pending, buf, len) < len)
+        stream->primed = 0;
+}
+
+/* Converts every queued block and hands each complete output block to the backend. */
+static void
+sound_mix_process(void)
+{
+    const uint32_t out_len = SOUND_OUTPUT_BUFLEN * 2;
+
+    for (int i = 0; i < SOUND_STREAM_MAX; i++) {
+        sound_stream_t *stream = &sound_streams[i];
+
+        while (sound_ring_read(stream->blocks, stream->mix, stream->len * 2))
+            sound_stream_convert(stream);
     }
 
-    if (sound_is_float) {
-        outbuffer_m_ex = calloc(MUSICBUFLEN * 2, sizeof(float));
-        memset(outbuffer_m_ex, 0x00, MUSICBUFLEN * 2 * sizeof(float));
-    } else {
-        outbuffer_m_ex_int16 = calloc(MUSICBUFLEN * 2, sizeof(int16_t));
-        memset(outbuffer_m_ex_int16, 0x00, MUSICBUFLEN * 2 * sizeof(int16_t));
+    while (sound_ring_read(sound_streams[SOUND_STREAM_SOUND].pending, sound_out_mix, out_len)) {
+        for (int i = SOUND_STREAM_MUSIC; i < SOUND_STREAM_MAX; i++)
+            sound_stream_mix_pending(&sound_streams[i], sound_out_mix, out_len);
+
+        if (sound_is_float) {
+            sound_mix_to_float(sound_out, sound_out_mix, out_len);
+            givealbuffer(sound_out);
+        } else {
+            sound_mix_to_int16(sound_out_int16, sound_out_mix, out_len);
+            givealbuffer(sound_out_int16);
+        }
     }
 }
 
+/*
+   Queues a block for the mixer job. If the mixer job has fallen
+   SOUND_MIX_BLOCKS behind, the block is dropped, just like the backends
+   drop a block when none of their buffers has been played yet. Without
+   the mixer job, the sound stream mixes everything queued so far.
+ */
 static void
-wavetable_realloc_buffers(void)
+sound_stream_push(sound_stream_t *stream, const int32_t *buf)
 {
-    if (outbuffer_w_ex != NULL) {
-        free(outbuffer_w_ex);
-        outbuffer_w_ex = NULL;
-    }
+    if (!sound_ring_write(stream->blocks, buf, stream->len * 2))
+        sound_log("Sound: mixer overrun, %s block dropped\n", stream->name);
+
+    if (sound_mix_on)
+        sound_job_submit(sound_mix_job);
+    else if (stream == &sound_streams[SOUND_STREAM_SOUND])
+        sound_mix_process();
+}
+
+static sound_ring_t *
+sound_stream_add_ring(sound_stream_t *stream)
+{
+    const int num = atomic_load(&stream->rings_num);
+
+    if (num >= SOUND_RINGS_MAX)
+        return NULL;
+
+    stream->rings[num] = sound_ring_create(stream->len * 2 * SOUND_MIX_BLOCKS);
+    atomic_store(&stream->rings_num, num + 1);
+
+    return stream->rings[num];
+}
 
-    if (outbuffer_w_ex_int16 != NULL) {
-        free(outbuffer_w_ex_int16);
-        outbuffer_w_ex_int16 = NULL;
+static void
+sound_mix_job_run(UNUSED(void *priv))
+{
+    if (sound_mix_on)
+        sound_mix_process();
+}
+
+static void
+sound_mix_thread_init(void)
+{
+    if (!sound_mix_on) {
+        sound_mix_job = sound_mixer_job_create("mixer", sound_mix_job_run, NULL);
+        sound_mix_on  = 1;
     }
+}
 
-    if (sound_is_float) {
-        outbuffer_w_ex = calloc(WTBUFLEN * 2, sizeof(float));
-        memset(outbuffer_w_ex, 0x00, WTBUFLEN * 2 * sizeof(float));
-    } else {
-        outbuffer_w_ex_int16 = calloc(WTBUFLEN * 2, sizeof(int16_t));
-        memset(outbuffer_w_ex_int16, 0x00, WTBUFLEN * 2 * sizeof(int16_t));
+void
+sound_mix_thread_end(void)
+{
+    if (sound_mix_on) {
+        sound_mix_on = 0;
+
+        sound_log("Waiting for the mixer to finish...\n");
+        sound_job_close(sound_mix_job);
+        sound_mix_job = NULL;
+        sound_log("Mixer finished...\n");
     }
 }
 
@@ -470,15 +604,6 @@ sound_init(void)
 {
     int available_cdrom_drives = 0;
 
-    outbuffer_ex       = NULL;
-    outbuffer_ex_int16 = NULL;
-
-    outbuffer_m_ex       = NULL;
-    outbuffer_m_ex_int16 = NULL;
-
-    outbuffer_w_ex       = NULL;
-    outbuffer_w_ex_int16 = NULL;
-
     outbuffer = NULL;
     outbuffer = calloc(SOUNDBUFLEN * 2, sizeof(int32_t));
     memset(outbuffer, 0x00, SOUNDBUFLEN * 2 * sizeof(int32_t));
@@ -510,17 +635,8 @@ sound_init(void)
     }
 
     if (available_cdrom_drives) {
-        cdaudioon = 1;
-
-        sound_cd_start_event = thread_create_event();
-
-        sound_cd_event    = thread_create_event();
-        sound_cd_thread_h = thread_create(sound_cd_thread, NULL);
-
-        sound_log("Waiting for CD start event...\n");
-        thread_wait_event(sound_cd_start_event, -1);
-        thread_reset_event(sound_cd_start_event);
-        sound_log("Done!\n");
+        sound_cd_job = sound_job_create("CD audio", sound_cd_job_run, NULL);
+        cdaudioon    = 1;
     } else
         cdaudioon = 0;
 
@@ -543,6 +659,12 @@ music_add_handler(void (*get_buffer)(int32_t *buffer, int len, void *priv), void
     music_handlers_num++;
 }
 
+sound_ring_t *
+sound_add_ring(void)
+{
+    return sound_stream_add_ring(&sound_streams[SOUND_STREAM_SOUND]);
+}
+
 void
 wavetable_add_handler(void (*get_buffer)(int32_t *buffer, int len, void *priv), void *priv)
 {
@@ -569,15 +691,56 @@ sound_set_pc_speaker_filter(void (*filter)(int channel, double *buffer, void *pr
     }
 }
 
+/*
+   Number of samples of a len-sample buffer that are due by now, given that
+   the buffer ends left 32:32 ticks after the next expiry of timer. This
+   gives the same count as a timer advancing by latch per sample would, and
+   while the timer is in its callback at the end of the buffer, it is len.
+ */
+static int
+sound_pos_from_timer(pc_timer_t *timer, uint64_t left, uint64_t latch, int len)
+{
+    const uint64_t remaining = timer_get_remaining_u64(timer) + left;
+    const uint64_t pending   = (remaining + latch - 1) / latch;
+
+    return (pending >= (uint64_t) len) ? 0 : (len - (int) pending);
+}
+
+int
+sound_get_pos(void)
+{
+    return sound_pos_from_timer(&sound_poll_timer, sound_poll_half ? 0 : (sound_poll_latch * SOUND_POLL_LEN),
+                                sound_poll_latch, SOUNDBUFLEN);
+}
+
+int
+sound_get_poll_pos(void)
+{
+    /* Whichever half is current, the timer next expires at its end. */
+    return sound_pos_from_timer(&sound_poll_timer, 0, sound_poll_latch, SOUND_POLL_LEN);
+}
+
+int
+music_get_pos(void)
+{
+    return sound_pos_from_timer(&music_poll_timer, 0, music_poll_latch, MUSICBUFLEN);
+}
+
+int
+wavetable_get_pos(void)
+{
+    return sound_pos_from_timer(&wavetable_poll_timer, 0, wavetable_poll_latch, WTBUFLEN);
+}
+
 void
 sound_poll(UNUSED(void *priv))
 {
-    timer_advance_u64(&sound_poll_timer, sound_poll_latch);
-
     midi_poll();
 
-    sound_pos_global++;
-    if (sound_pos_global == SOUNDBUFLEN) {
+    if (!sound_poll_half) {
+        sound_poll_half = 1;
+        timer_advance_u64(&sound_poll_timer, sound_poll_latch * SOUND_POLL_LEN);
+    } else {
         int c;
 
         memset(outbuffer, 0x00, SOUNDBUFLEN * 2 * sizeof(int32_t));
@@ -585,109 +748,52 @@ sound_poll(UNUSED(void *priv))
         for (c = 0; c < sound_handlers_num; c++)
             sound_handlers[c].get_buffer(outbuffer, SOUNDBUFLEN, sound_handlers[c].priv);
 
-        for (c = 0; c < SOUNDBUFLEN * 2; c++) {
-            if (sound_is_float)
-                outbuffer_ex[c] = ((float) outbuffer[c]) / (float) 32768.0;
-            else {
-                if (outbuffer[c] > 32767)
-                    outbuffer[c] = 32767;
-                if (outbuffer[c] < -32768)
-                    outbuffer[c] = -32768;
-
-                outbuffer_ex_int16[c] = (int16_t) outbuffer[c];
-            }
-        }
-
-        if (sound_is_float)
-            givealbuffer(outbuffer_ex);
-        else
-            givealbuffer(outbuffer_ex_int16);
+        sound_stream_push(&sound_streams[SOUND_STREAM_SOUND], outbuffer);
 
         if (cd_thread_enable) {
             cd_buf_update--;
             if (!cd_buf_update) {
                 cd_buf_update = (SOUND_FREQ / SOUNDBUFLEN) / (CD_FREQ / CD_BUFLEN);
-                thread_set_event(sound_cd_event);
+                sound_job_submit(sound_cd_job);
             }
         }
 
-        if (fdd_thread_enable) {
-            thread_set_event(sound_fdd_event);
-        }
-        sound_pos_global = 0;
+        if (fdd_thread_enable)
+            sound_job_submit(sound_fdd_job);
+
+        sound_poll_half = 0;
+        timer_advance_u64(&sound_poll_timer, sound_poll_latch * SOUND_POLL_LEN);
     }
 }
 
 void
 music_poll(UNUSED(void *priv))
 {
-    timer_advance_u64(&music_poll_timer, music_poll_latch);
-
-    music_pos_global++;
-    if (music_pos_global == MUSICBUFLEN) {
-        int c;
+    int c;
 
-        memset(outbuffer_m, 0x00, MUSICBUFLEN * 2 * sizeof(int32_t));
-
-        for (c = 0; c < music_handlers_num; c++)
-            music_handlers[c].get_buffer(outbuffer_m, MUSICBUFLEN, music_handlers[c].priv);
-
-        for (c = 0; c < MUSICBUFLEN * 2; c++) {
-            if (sound_is_float)
-                outbuffer_m_ex[c] = ((float) outbuffer_m[c]) / (float) 32768.0;
-            else {
-                if (outbuffer_m[c] > 32767)
-                    outbuffer_m[c] = 32767;
-                if (outbuffer_m[c] < -32768)
-                    outbuffer_m[c] = -32768;
+    memset(outbuffer_m, 0x00, MUSICBUFLEN * 2 * sizeof(int32_t));
 
-                outbuffer_m_ex_int16[c] = (int16_t) outbuffer_m[c];
-            }
-        }
+    for (c = 0; c < music_handlers_num; c++)
+        music_handlers[c].get_buffer(outbuffer_m, MUSICBUFLEN, music_handlers[c].priv);
 
-        if (sound_is_float)
-            givealbuffer_music(outbuffer_m_ex);
-        else
-            givealbuffer_music(outbuffer_m_ex_int16);
+    sound_stream_push(&sound_streams[SOUND_STREAM_MUSIC], outbuffer_m);
 
-        music_pos_global = 0;
-    }
+    timer_advance_u64(&music_poll_timer, music_poll_latch * MUSICBUFLEN);
 }
 
 void
 wavetable_poll(UNUSED(void *priv))
 {
-    timer_advance_u64(&wavetable_poll_timer, wavetable_poll_latch);
-
-    wavetable_pos_global++;
-    if (wavetable_pos_global == WTBUFLEN) {
-        int c;
-
-        memset(outbuffer_w, 0x00, WTBUFLEN * 2 * sizeof(int32_t));
+    int c;
 
-        for (c = 0; c < wavetable_handlers_num; c++)
-            wavetable_handlers[c].get_buffer(outbuffer_w, WTBUFLEN, wavetable_handlers[c].priv);
+    memset(outbuffer_w, 0x00, WTBUFLEN * 2 * sizeof(int32_t));
 
-        for (c = 0; c < WTBUFLEN * 2; c++) {
-            if (sound_is_float)
-                outbuffer_w_ex[c] = ((float) outbuffer_w[c]) / (float) 32768.0;
-            else {
-                if (outbuffer_w[c] > 32767)
-                    outbuffer_w[c] = 32767;
-                if (outbuffer_w[c] < -32768)
-                    outbuffer_w[c] = -32768;
+    for (c = 0; c < wavetable_handlers_num; c++)
+        wavetable_handlers[c].get_buffer(outbuffer_w, WTBUFLEN, wavetable_handlers[c].priv);
 
-                outbuffer_w_ex_int16[c] = (int16_t) outbuffer_w[c];
-            }
-        }
-
-        if (sound_is_float)
-            givealbuffer_wt(outbuffer_w_ex);
-        else
-            givealbuffer_wt(outbuffer_w_ex_int16);
+    sound_stream_push(&sound_streams[SOUND_STREAM_WAVETABLE], outbuffer_w);
 
-        wavetable_pos_global = 0;
-    }
+    timer_advance_u64(&wavetable_poll_timer, wavetable_poll_latch * WTBUFLEN);
 }
 
 void
@@ -703,17 +809,22 @@ sound_speed_changed(void)
 void
 sound_reset(void)
 {
-    sound_realloc_buffers();
+    sound_mix_thread_end();
 
-    music_realloc_buffers();
+    /* The CD job pushes into its stream and the floppy job into OpenAL; let their last blocks land first. */
+    sound_job_wait(sound_cd_job);
+    sound_job_wait(sound_fdd_job);
 
-    wavetable_realloc_buffers();
+    for (int i = 0; i < SOUND_STREAM_MAX; i++)
+        sound_stream_realloc(&sound_streams[i]);
+    sound_output_realloc();
 
     midi_out_device_init();
     midi_in_device_init();
 
     inital();
 
+    sound_poll_half = 0;
     timer_add(&sound_poll_timer, sound_poll, NULL, 1);
     sound_handlers_num = 0;
     memset(sound_handlers, 0x00, 8 * sizeof(sound_handler_t));
@@ -736,6 +847,8 @@ sound_reset(void)
 
     /* Reset the MPU-401 already loaded flag and the chain of input/output handlers. */
     midi_in_handlers_clear();
+
+    sound_mix_thread_init();
 }
 
 void
@@ -753,22 +866,10 @@ sound_cd_thread_end(void)
     if (cdaudioon) {
         cdaudioon = 0;
 
-        sound_log("Waiting for CD Audio thread to terminate...\n");
-        thread_set_event(sound_cd_event);
-        thread_wait(sound_cd_thread_h);
-        sound_log("CD Audio thread terminated...\n");
-
-        if (sound_cd_event) {
-            thread_destroy_event(sound_cd_event);
-            sound_cd_event = NULL;
-        }
-
-        sound_cd_thread_h = NULL;
-
-        if (sound_cd_start_event) {
-            thread_destroy_event(sound_cd_start_event);
-            sound_cd_event = NULL;
-        }
+        sound_log("Waiting for CD Audio to finish...\n");
+        sound_job_close(sound_cd_job);
+        sound_cd_job = NULL;
+        sound_log("CD Audio finished...\n");
     }
 }
 
@@ -785,52 +886,35 @@ sound_cd_thread_reset(void)
     }
 
     if (available_cdrom_drives && !cd_thread_enable) {
-        cdaudioon = 1;
-
-        sound_cd_start_event = thread_create_event();
-
-        sound_cd_event    = thread_create_event();
-        sound_cd_thread_h = thread_create(sound_cd_thread, NULL);
-
-        thread_wait_event(sound_cd_start_event, -1);
-        thread_reset_event(sound_cd_start_event);
+        sound_cd_job = sound_job_create("CD audio", sound_cd_job_run, NULL);
+        cdaudioon    = 1;
     } else if (!available_cdrom_drives && cd_thread_enable)
         sound_cd_thread_end();
 
     cd_thread_enable = available_cdrom_drives ? 1 : 0;
 }
 
+/* Renders one block of floppy drive sounds; run on the sound workers. */
 static void
-sound_fdd_thread(UNUSED(void *param))
+sound_fdd_job_run(UNUSED(void *priv))
 {
-    thread_set_event(sound_fdd_start_event);
-    while (fddaudioon) {
-        thread_wait_event(sound_fdd_event, -1);
-        thread_reset_event(sound_fdd_event);
+    static float fdd_float_buffer[SOUNDBUFLEN * 2];
 
-        if (!fddaudioon)
-            break;
+    if (!fddaudioon)
+        return;
 
-        static float fdd_float_buffer[SOUNDBUFLEN * 2];
-        memset(fdd_float_buffer, 0, sizeof(fdd_float_buffer));
-        fdd_audio_callback((int16_t*)fdd_float_buffer, SOUNDBUFLEN * 2);
-        givealbuffer_fdd(fdd_float_buffer, SOUNDBUFLEN * 2);
-    }
+    memset(fdd_float_buffer, 0, sizeof(fdd_float_buffer));
+    fdd_audio_callback((int16_t*)fdd_float_buffer, SOUNDBUFLEN * 2);
+    givealbuffer_fdd(fdd_float_buffer, SOUNDBUFLEN * 2);
 }
 
 void
 sound_fdd_thread_init(void)
 {
     if (!fddaudioon) {
-        fddaudioon = 1;
+        sound_fdd_job     = sound_job_create("floppy audio", sound_fdd_job_run, NULL);
+        fddaudioon        = 1;
         fdd_thread_enable = 1;
-
-        sound_fdd_start_event = thread_create_event();
-        sound_fdd_event = thread_create_event();
-        sound_fdd_thread_h = thread_create(sound_fdd_thread, NULL);
-
-        thread_wait_event(sound_fdd_start_event, -1);
-        thread_reset_event(sound_fdd_start_event);
     }
 }
 
@@ -841,19 +925,7 @@ sound_fdd_thread_end(void)
         fddaudioon = 0;
         fdd_thread_enable = 0;
 
-        thread_set_event(sound_fdd_event);
-        thread_wait(sound_fdd_thread_h);
-
-        if (sound_fdd_event) {
-            thread_destroy_event(sound_fdd_event);
-            sound_fdd_event = NULL;
-        }
-
-        sound_fdd_thread_h = NULL;
-
-        if (sound_fdd_start_event) {
-            thread_destroy_event(sound_fdd_start_event);
-            sound_fdd_start_event = NULL;
-        }
+        sound_job_close(sound_fdd_job);
+        sound_fdd_job = NULL;
     }
 }
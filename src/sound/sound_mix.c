@@ -0,0 +1,193 @@
+/*
+ * 86Box    A hypervisor and IBM PC system emulator that specializes in
+ *          running old operating systems and software designed for IBM
+ *          PC systems and compatibles from 1981 through fairly recent
+ *          system designs based on the PCI bus.
+ *
+ *          This file is part of the 86Box distribution.
+ *
+ *          Block kernels for the sound output path.
+ *
+ *          SSE2 is used on x86-64 and NEON on ARM64, with plain loops
+ *          elsewhere. The integer and conversion kernels are exact. The
+ *          stereo biquad keeps the left and right channels in two lanes
+ *          of one register, so a stereo filter costs the same as a mono
+ *          one; every backend evaluates the same expression in the same
+ *          order. benchmarks/sound_mix_micro.c compares them against the
+ *          per-sample loops of the mixer and filters.h.
+ *
+ * Authors: 86Box contributors.
+ *
+ *          Copyright 2026 86Box contributors.
+ */
+#include <math.h>
+#include <stdint.h>
+#include <86box/sound_mix.h>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#    define MIX_SSE2
+#    include <emmintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#    define MIX_NEON
+#    include <arm_neon.h>
+#endif
+
+/* State below this is flushed to zero so that a silent stream never runs on denormals. */
+#define BIQUAD_FLUSH 1e-20f
+
+void
+sound_mix_to_float(float *dst, const int32_t *src, int n)
+{
+    int i = 0;
+
+#if defined(MIX_SSE2)
+    const __m128 scale = _mm_set1_ps(1.0f / 32768.0f);
+
+    for (; i <= (n - 4); i += 4) {
+        const __m128 f = _mm_cvtepi32_ps(_mm_loadu_si128((const __m128i *) &src[i]));
+
+        _mm_storeu_ps(&dst[i], _mm_mul_ps(f, scale));
+    }
+#elif defined(MIX_NEON)
+    for (; i <= (n - 4); i += 4)
+        vst1q_f32(&dst[i], vmulq_n_f32(vcvtq_f32_s32(vld1q_s32(&src[i])), 1.0f / 32768.0f));
+#endif
+    /* Division by a power of two is exact, so this matches the multiply above. */
+    for (; i < n; i++)
+        dst[i] = ((float) src[i]) / (float) 32768.0;
+}
+
+void
+sound_mix_to_int16(int16_t *dst, const int32_t *src, int n)
+{
+    int i = 0;
+
+#if defined(MIX_SSE2)
+    for (; i <= (n - 8); i += 8) {
+        const __m128i lo = _mm_loadu_si128((const __m128i *) &src[i]);
+        const __m128i hi = _mm_loadu_si128((const __m128i *) &src[i + 4]);
+
+        _mm_storeu_si128((__m128i *) &dst[i], _mm_packs_epi32(lo, hi));
+    }
+#elif defined(MIX_NEON)
+    for (; i <= (n - 8); i += 8)
+        vst1q_s16(&dst[i], vcombine_s16(vqmovn_s32(vld1q_s32(&src[i])), vqmovn_s32(vld1q_s32(&src[i + 4]))));
+#endif
+    for (; i < n; i++) {
+        if (src[i] > 32767)
+            dst[i] = 32767;
+        else if (src[i] < -32768)
+            dst[i] = -32768;
+        else
+            dst[i] = (int16_t) src[i];
+    }
+}
+
+void
+sound_mix_s16_to_float(float *dst, const int16_t *src, int n)
+{
+    int i = 0;
+
+#if defined(MIX_SSE2)
+    for (; i <= (n - 8); i += 8) {
+        const __m128i s  = _mm_loadu_si128((const __m128i *) &src[i]);
+        const __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(s, s), 16);
+        const __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(s, s), 16);
+
+        _mm_storeu_ps(&dst[i], _mm_cvtepi32_ps(lo));
+        _mm_storeu_ps(&dst[i + 4], _mm_cvtepi32_ps(hi));
+    }
+#elif defined(MIX_NEON)
+    for (; i <= (n - 8); i += 8) {
+        const int16x8_t s = vld1q_s16(&src[i]);
+
+        vst1q_f32(&dst[i], vcvtq_f32_s32(vmovl_s16(vget_low_s16(s))));
+        vst1q_f32(&dst[i + 4], vcvtq_f32_s32(vmovl_s16(vget_high_s16(s))));
+    }
+#endif
+    for (; i < n; i++)
+        dst[i] = (float) src[i];
+}
+
+void
+sound_biquad_init(sound_biquad_t *bq, const double b[3], const double a[3])
+{
+    bq->b0 = (float) (b[0] / a[0]);
+    bq->b1 = (float) (b[1] / a[0]);
+    bq->b2 = (float) (b[2] / a[0]);
+    bq->a1 = (float) (a[1] / a[0]);
+    bq->a2 = (float) (a[2] / a[0]);
+
+    sound_biquad_reset(bq);
+}
+
+void
+sound_biquad_reset(sound_biquad_t *bq)
+{
+    bq->z1[0] = bq->z1[1] = 0.0f;
+    bq->z2[0] = bq->z2[1] = 0.0f;
+}
+
+void
+sound_biquad_stereo(sound_biquad_t *bq, float *buf, int frames)
+{
+#if defined(MIX_SSE2)
+    const __m128 b0 = _mm_set1_ps(bq->b0);
+    const __m128 b1 = _mm_set1_ps(bq->b1);
+    const __m128 b2 = _mm_set1_ps(bq->b2);
+    const __m128 a1 = _mm_set1_ps(bq->a1);
+    const __m128 a2 = _mm_set1_ps(bq->a2);
+    __m128       z1 = _mm_setr_ps(bq->z1[0], bq->z1[1], 0.0f, 0.0f);
+    __m128       z2 = _mm_setr_ps(bq->z2[0], bq->z2[1], 0.0f, 0.0f);
+
+    for (int i = 0; i < frames; i++) {
+        const __m128 x = _mm_castpd_ps(_mm_load_sd((const double *) &buf[i * 2]));
+        const __m128 y = _mm_add_ps(_mm_mul_ps(b0, x), z1);
+
+        z1 = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(b1, x), _mm_mul_ps(a1, y)), z2);
+        z2 = _mm_sub_ps(_mm_mul_ps(b2, x), _mm_mul_ps(a2, y));
+        _mm_store_sd((double *) &buf[i * 2], _mm_castps_pd(y));
+    }
+
+    _mm_storel_pi((__m64 *) bq->z1, z1);
+    _mm_storel_pi((__m64 *) bq->z2, z2);
+#elif defined(MIX_NEON)
+    const float32x2_t b0 = vdup_n_f32(bq->b0);
+    const float32x2_t b1 = vdup_n_f32(bq->b1);
+    const float32x2_t b2 = vdup_n_f32(bq->b2);
+    const float32x2_t a1 = vdup_n_f32(bq->a1);
+    const float32x2_t a2 = vdup_n_f32(bq->a2);
+    float32x2_t       z1 = vld1_f32(bq->z1);
+    float32x2_t       z2 = vld1_f32(bq->z2);
+
+    for (int i = 0; i < frames; i++) {
+        const float32x2_t x = vld1_f32(&buf[i * 2]);
+        const float32x2_t y = vadd_f32(vmul_f32(b0, x), z1);
+
+        z1 = vadd_f32(vsub_f32(vmul_f32(b1, x), vmul_f32(a1, y)), z2);
+        z2 = vsub_f32(vmul_f32(b2, x), vmul_f32(a2, y));
+        vst1_f32(&buf[i * 2], y);
+    }
+
+    vst1_f32(bq->z1, z1);
+    vst1_f32(bq->z2, z2);
+#else
+    for (int i = 0; i < frames; i++) {
+        for (int c = 0; c < 2; c++) {
+            const float x = buf[i * 2 + c];
+            const float y = (bq->b0 * x) + bq->z1[c];
+
+            bq->z1[c] = ((bq->b1 * x) - (bq->a1 * y)) + bq->z2[c];
+            bq->z2[c] = (bq->b2 * x) - (bq->a2 * y);
+            buf[i * 2 + c] = y;
+        }
+    }
+#endif
+
+    for (int c = 0; c < 2; c++) {
+        if (fabsf(bq->z1[c]) < BIQUAD_FLUSH)
+            bq->z1[c] = 0.0f;
+        if (fabsf(bq->z2[c]) < BIQUAD_FLUSH)
+            bq->z2[c] = 0.0f;
+    }
+}
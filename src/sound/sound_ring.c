@@ -0,0 +1,153 @@
+/*
+ * 86Box    A hypervisor and IBM PC system emulator that specializes in
+ *          running old operating systems and software designed for IBM
+ *          PC systems and compatibles from 1981 through fairly recent
+ *          system designs based on the PCI bus.
+ *
+ *          This file is part of the 86Box distribution.
+ *
+ *          Single-producer/single-consumer sample rings.
+ *
+ *          The read and write counters run freely and are only reduced
+ *          to an index when the buffer is accessed, so a full ring and an
+ *          empty one are told apart without a spare slot. The producer
+ *          publishes samples with a release store of the write counter
+ *          and the consumer frees them with a release store of the read
+ *          counter.
+ *
+ * Authors: 86Box contributors.
+ *
+ *          Copyright 2026 86Box contributors.
+ */
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <86box/sound_ring.h>
+
+struct sound_ring_t {
+    int32_t    *buf;
+    uint32_t    size;
+    uint32_t    mask;
+    atomic_uint wr;
+    atomic_uint rd;
+};
+
+sound_ring_t *
+sound_ring_create(uint32_t len)
+{
+    sound_ring_t *ring = calloc(1, sizeof(sound_ring_t));
+    uint32_t      size = 1;
+
+    while (size < len)
+        size <<= 1;
+
+    ring->buf  = calloc(size, sizeof(int32_t));
+    ring->size = size;
+    ring->mask = size - 1;
+    atomic_init(&ring->wr, 0);
+    atomic_init(&ring->rd, 0);
+
+    return ring;
+}
+
+void
+sound_ring_close(sound_ring_t *ring)
+{
+    if (ring == NULL)
+        return;
+
+    free(ring->buf);
+    free(ring);
+}
+
+void
+sound_ring_flush(sound_ring_t *ring)
+{
+    atomic_store(&ring->rd, atomic_load(&ring->wr));
+}
+
+uint32_t
+sound_ring_space(sound_ring_t *ring)
+{
+    const uint32_t wr = atomic_load_explicit(&ring->wr, memory_order_relaxed);
+    const uint32_t rd = atomic_load_explicit(&ring->rd, memory_order_acquire);
+
+    return ring->size - (wr - rd);
+}
+
+uint32_t
+sound_ring_fill(sound_ring_t *ring)
+{
+    const uint32_t rd = atomic_load_explicit(&ring->rd, memory_order_relaxed);
+    const uint32_t wr = atomic_load_explicit(&ring->wr, memory_order_acquire);
+
+    return wr - rd;
+}
+
+int
+sound_ring_write(sound_ring_t *ring, const int32_t *buf, uint32_t len)
+{
+    const uint32_t wr  = atomic_load_explicit(&ring->wr, memory_order_relaxed);
+    const uint32_t rd  = atomic_load_explicit(&ring->rd, memory_order_acquire);
+    const uint32_t pos = wr & ring->mask;
+    uint32_t       first;
+
+    if ((ring->size - (wr - rd)) < len)
+        return 0;
+
+    first = ring->size - pos;
+    if (first > len)
+        first = len;
+    memcpy(&ring->buf[pos], buf, first * sizeof(int32_t));
+    memcpy(ring->buf, &buf[first], (len - first) * sizeof(int32_t));
+
+    atomic_store_explicit(&ring->wr, wr + len, memory_order_release);
+    return 1;
+}
+
+int
+sound_ring_read(sound_ring_t *ring, int32_t *buf, uint32_t len)
+{
+    const uint32_t rd  = atomic_load_explicit(&ring->rd, memory_order_relaxed);
+    const uint32_t wr  = atomic_load_explicit(&ring->wr, memory_order_acquire);
+    const uint32_t pos = rd & ring->mask;
+    uint32_t       first;
+
+    if ((wr - rd) < len)
+        return 0;
+
+    first = ring->size - pos;
+    if (first > len)
+        first = len;
+    memcpy(buf, &ring->buf[pos], first * sizeof(int32_t));
+    memcpy(&buf[first], ring->buf, (len - first) * sizeof(int32_t));
+
+    atomic_store_explicit(&ring->rd, rd + len, memory_order_release);
+    return 1;
+}
+
+uint32_t
+sound_ring_mix(sound_ring_t *ring, int32_t *buf, uint32_t len)
+{
+    const uint32_t rd  = atomic_load_explicit(&ring->rd, memory_order_relaxed);
+    const uint32_t wr  = atomic_load_explicit(&ring->wr, memory_order_acquire);
+    const uint32_t pos = rd & ring->mask;
+    uint32_t       first;
+
+    if ((wr - rd) < len)
+        len = wr - rd;
+
+    first = ring->size - pos;
+    if (first > len)
+        first = len;
+    /* Plain loops over the two contiguous parts, which the compiler vectorizes. */
+    for (uint32_t i = 0; i < first; i++)
+        buf[i] += ring->buf[pos + i];
+    for (uint32_t i = first; i < len; i++)
+        buf[i] += ring->buf[i - first];
+
+    atomic_store_explicit(&ring->rd, rd + len, memory_order_release);
+    return len;
+}
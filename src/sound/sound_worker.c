@@ -0,0 +1,108 @@
+/*
+ * 86Box    A hypervisor and IBM PC system emulator that specializes in
+ *          running old operating systems and software designed for IBM
+ *          PC systems and compatibles from 1981 through fairly recent
+ *          system designs based on the PCI bus.
+ *
+ *          Shared worker threads for the audio feeders.
+ *
+ *          The mixer, CD audio, floppy sounds and the software MIDI
+ *          synthesizers each used to have a thread of their own, woken
+ *          every 10 or 20 ms. The feeders now share a job pool of
+ *          SOUND_WORKER_THREADS threads, started with the first job, so
+ *          a machine without CD audio or a synthesizer pays for nothing
+ *          but the mixer. The mixer has a thread of its own, so that a
+ *          long synthesizer block cannot hold up the output.
+ *
+ * Authors: 86Box contributors.
+ *
+ *          Copyright 2026 86Box contributors.
+ */
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <86box/86box.h>
+#include <86box/thread.h>
+#include <86box/job_pool.h>
+#include <86box/sound_worker.h>
+
+#define SOUND_WORKER_THREADS 2
+
+static struct {
+    job_pool_t *feeders;
+    job_pool_t *mixer;
+    atomic_int  started; /* 0, 1 while starting, 2 once running. */
+} pool;
+
+/* The pools are started once, by whichever thread creates the first job, and kept until sound_worker_close(). */
+static void
+sound_worker_start(void)
+{
+    int expected = 0;
+
+    if (atomic_compare_exchange_strong(&pool.started, &expected, 1)) {
+        pool.feeders = job_pool_create("sound_worker", SOUND_WORKER_THREADS);
+        pool.mixer   = job_pool_create("sound_mixer", 1);
+
+        atomic_store(&pool.started, 2);
+    } else {
+        while (atomic_load(&pool.started) != 2)
+            ;
+    }
+}
+
+sound_job_t *
+sound_job_create(const char *name, void (*func)(void *priv), void *priv)
+{
+    sound_worker_start();
+
+    return job_create(pool.feeders, name, func, priv);
+}
+
+sound_job_t *
+sound_mixer_job_create(const char *name, void (*func)(void *priv), void *priv)
+{
+    sound_worker_start();
+
+    return job_create(pool.mixer, name, func, priv);
+}
+
+void
+sound_job_close(sound_job_t *job)
+{
+    job_close(job);
+}
+
+void
+sound_job_submit(sound_job_t *job)
+{
+    job_submit(job);
+}
+
+void
+sound_job_wait(sound_job_t *job)
+{
+    if (job != NULL)
+        job_wait(job);
+}
+
+void
+sound_job_get_stats(sound_job_t *job, sound_job_stats_t *stats)
+{
+    job_get_stats(job, stats);
+}
+
+void
+sound_worker_close(void)
+{
+    if (atomic_load(&pool.started) != 2)
+        return;
+
+    job_pool_close(pool.feeders);
+    job_pool_close(pool.mixer);
+    pool.feeders = NULL;
+    pool.mixer   = NULL;
+
+    atomic_store(&pool.started, 0);
+}
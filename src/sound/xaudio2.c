@@ -49,14 +49,10 @@ static int                     initialized   = 0;
 static IXAudio2               *xaudio2       = NULL;
 static IXAudio2MasteringVoice *mastervoice   = NULL;
 static IXAudio2SourceVoice    *srcvoice      = NULL;
-static IXAudio2SourceVoice    *srcvoicemusic = NULL;
-static IXAudio2SourceVoice    *srcvoicewt    = NULL;
 static IXAudio2SourceVoice    *srcvoicemidi  = NULL;
-static IXAudio2SourceVoice    *srcvoicecd    = NULL;
 static IXAudio2SourceVoice    *srcvoicefdd   = NULL;
 
-#define FREQ   SOUND_FREQ
-#define BUFLEN SOUNDBUFLEN
+#define FREQ SOUND_FREQ
 
 static void WINAPI
 OnVoiceProcessingPassStart(UNUSED(IXAudio2VoiceCallback *callback), UNUSED(uint32_t bytesRequired))
@@ -131,7 +127,7 @@ inital(void)
     if (XAudio2Create(&xaudio2, 0, XAUDIO2_DEFAULT_PROCESSOR))
         return;
 
-    if (IXAudio2_CreateMasteringVoice(xaudio2, &mastervoice, 2, FREQ, 0, 0, NULL, 0)) {
+    if (IXAudio2_CreateMasteringVoice(xaudio2, &mastervoice, 2, sound_output_freq, 0, 0, NULL, 0)) {
         IXAudio2_Release(xaudio2);
         xaudio2 = NULL;
         return;
@@ -148,7 +144,7 @@ inital(void)
         fmt.wBitsPerSample = 16;
     }
 
-    fmt.nSamplesPerSec  = FREQ;
+    fmt.nSamplesPerSec  = sound_output_freq;
     fmt.nBlockAlign     = fmt.nChannels * fmt.wBitsPerSample / 8;
     fmt.nAvgBytesPerSec = fmt.nSamplesPerSec * fmt.nBlockAlign;
     fmt.cbSize          = 0;
@@ -161,24 +157,6 @@ inital(void)
         return;
     }
 
-    fmt.nSamplesPerSec  = MUSIC_FREQ;
-    fmt.nBlockAlign     = fmt.nChannels * fmt.wBitsPerSample / 8;
-    fmt.nAvgBytesPerSec = fmt.nSamplesPerSec * fmt.nBlockAlign;
-
-    (void) IXAudio2_CreateSourceVoice(xaudio2, &srcvoicemusic, &fmt, 0, 2.0f, &callbacks, NULL, NULL);
-
-    fmt.nSamplesPerSec  = WT_FREQ;
-    fmt.nBlockAlign     = fmt.nChannels * fmt.wBitsPerSample / 8;
-    fmt.nAvgBytesPerSec = fmt.nSamplesPerSec * fmt.nBlockAlign;
-
-    (void) IXAudio2_CreateSourceVoice(xaudio2, &srcvoicewt, &fmt, 0, 2.0f, &callbacks, NULL, NULL);
-
-    fmt.nSamplesPerSec  = CD_FREQ;
-    fmt.nBlockAlign     = fmt.nChannels * fmt.wBitsPerSample / 8;
-    fmt.nAvgBytesPerSec = fmt.nSamplesPerSec * fmt.nBlockAlign;
-
-    (void) IXAudio2_CreateSourceVoice(xaudio2, &srcvoicecd, &fmt, 0, 2.0f, &callbacks, NULL, NULL);
-
     fmt.nSamplesPerSec  = FREQ;
     fmt.nBlockAlign     = fmt.nChannels * fmt.wBitsPerSample / 8;
     fmt.nAvgBytesPerSec = fmt.nSamplesPerSec * fmt.nBlockAlign;
@@ -187,9 +165,6 @@ inital(void)
 
     (void) IXAudio2SourceVoice_SetVolume(srcvoice, 1, XAUDIO2_COMMIT_NOW);
     (void) IXAudio2SourceVoice_Start(srcvoice, 0, XAUDIO2_COMMIT_NOW);
-    (void) IXAudio2SourceVoice_Start(srcvoicecd, 0, XAUDIO2_COMMIT_NOW);
-    (void) IXAudio2SourceVoice_Start(srcvoicemusic, 0, XAUDIO2_COMMIT_NOW);
-    (void) IXAudio2SourceVoice_Start(srcvoicewt, 0, XAUDIO2_COMMIT_NOW);
     (void) IXAudio2SourceVoice_Start(srcvoicefdd, 0, XAUDIO2_COMMIT_NOW);
 
     const char *mdn = midi_out_device_get_internal_name(midi_output_device_current);
@@ -215,12 +190,6 @@ closeal(void)
     initialized = 0;
     (void) IXAudio2SourceVoice_Stop(srcvoice, 0, XAUDIO2_COMMIT_NOW);
     (void) IXAudio2SourceVoice_FlushSourceBuffers(srcvoice);
-    (void) IXAudio2SourceVoice_Stop(srcvoicemusic, 0, XAUDIO2_COMMIT_NOW);
-    (void) IXAudio2SourceVoice_FlushSourceBuffers(srcvoicemusic);
-    (void) IXAudio2SourceVoice_Stop(srcvoicewt, 0, XAUDIO2_COMMIT_NOW);
-    (void) IXAudio2SourceVoice_FlushSourceBuffers(srcvoicewt);
-    (void) IXAudio2SourceVoice_Stop(srcvoicecd, 0, XAUDIO2_COMMIT_NOW);
-    (void) IXAudio2SourceVoice_FlushSourceBuffers(srcvoicecd);
     (void) IXAudio2SourceVoice_Stop(srcvoicefdd, 0, XAUDIO2_COMMIT_NOW);
     (void) IXAudio2SourceVoice_FlushSourceBuffers(srcvoicefdd);
     if (srcvoicemidi) {
@@ -228,15 +197,11 @@ closeal(void)
         (void) IXAudio2SourceVoice_FlushSourceBuffers(srcvoicemidi);
         IXAudio2SourceVoice_DestroyVoice(srcvoicemidi);
     }
-    IXAudio2SourceVoice_DestroyVoice(srcvoicewt);
-    IXAudio2SourceVoice_DestroyVoice(srcvoicecd);
     IXAudio2SourceVoice_DestroyVoice(srcvoicefdd);
-    IXAudio2SourceVoice_DestroyVoice(srcvoicemusic);
     IXAudio2SourceVoice_DestroyVoice(srcvoice);
     IXAudio2MasteringVoice_DestroyVoice(mastervoice);
     IXAudio2_Release(xaudio2);
     srcvoice     = NULL;
-    srcvoicecd   = NULL;
     srcvoicemidi = NULL;
     srcvoicefdd  = NULL;
     mastervoice  = NULL;
@@ -278,26 +243,7 @@ givealbuffer_common(const void *buf, IXAudio2SourceVoice *sourcevoice, const siz
 void
 givealbuffer(const void *buf)
 {
-    givealbuffer_common(buf, srcvoice, BUFLEN << 1);
-}
-
-void
-givealbuffer_music(const void *buf)
-{
-    givealbuffer_common(buf, srcvoicemusic, MUSICBUFLEN << 1);
-}
-
-void
-givealbuffer_wt(const void *buf)
-{
-    givealbuffer_common(buf, srcvoicewt, WTBUFLEN << 1);
-}
-
-void
-givealbuffer_cd(const void *buf)
-{
-    if (srcvoicecd)
-        givealbuffer_common(buf, srcvoicecd, CD_BUFLEN << 1);
+    givealbuffer_common(buf, srcvoice, SOUND_OUTPUT_BUFLEN << 1);
 }
 
 void
@@ -300,112 +300,6 @@ plat_get_string(int i)
     return L"";
 }
 
-FILE *
-plat_fopen(const char *path, const char *mode)
-{
-    return fopen(path, mode);
-}
-
-FILE *
-plat_fopen64(const char *path, const char *mode)
-{
-    return fopen(path, mode);
-}
-
-int
-path_abs(char *path)
-{
-    return path[0] == '/';
-}
-
-void
-path_normalize(UNUSED(char *path))
-{
-    /* No-op. */
-}
-
-void
-path_slash(char *path)
-{
-    if (path[strlen(path) - 1] != '/') {
-        strcat(path, "/");
-    }
-    path_normalize(path);
-}
-
-const char *
-path_get_slash(char *path)
-{
-    char *ret = "";
-
-    if (path[strlen(path) - 1] != '/')
-        ret =  "/";
-
-    return ret;
-}
-
-void
-plat_put_backslash(char *s)
-{
-    int c = strlen(s) - 1;
-
-    if (s[c] != '/')
-        s[c] = '/';
-}
-
-/* Return the last element of a pathname. */
-char *
-path_get_basename(const char *path)
-{
-    int c = (int) strlen(path);
-
-    while (c > 0) {
-        if (path[c] == '/')
-            return ((char *) &path[c + 1]);
-        c--;
-    }
-
-    return ((char *) path);
-}
-char *
-path_get_filename(char *s)
-{
-    int c = strlen(s) - 1;
-
-    while (c > 0) {
-        if (s[c] == '/' || s[c] == '\\')
-            return (&s[c + 1]);
-        c--;
-    }
-
-    return s;
-}
-
-char *
-path_get_extension(char *s)
-{
-    int c = strlen(s) - 1;
-
-    if (c <= 0)
-        return s;
-
-    while (c && s[c] != '.')
-        c--;
-
-    if (!c)
-        return (&s[strlen(s)]);
-
-    return (&s[c + 1]);
-}
-
-void
-path_append_filename(char *dest, const char *s1, const char *s2)
-{
-    strcpy(dest, s1);
-    path_slash(dest);
-    strcat(dest, s2);
-}
-
 int
 plat_dir_check(char *path)
 {
@@ -528,26 +422,6 @@ ui_sb_update_text(void)
     /* No-op. */
 }
 
-void
-path_get_dirname(char *dest, const char *path)
-{
-    int   c = (int) strlen(path);
-    char *ptr = (char *) path;
-
-    while (c > 0) {
-        if (path[c] == '/' || path[c] == '\\') {
-            ptr = (char *) &path[c];
-            break;
-        }
-        c--;
-    }
-
-    /* Copy to destination. */
-    while (path < ptr)
-        *dest++ = *path++;
-    *dest = '\0';
-}
-
 void
 ui_sb_set_text_w(UNUSED(wchar_t *wstr))
 {
@@ -1658,32 +1532,6 @@ plat_get_cpu_string(char *outbuf, uint8_t len) {
     strncpy(outbuf, cpu_string, len);
 }
 
-void
-plat_set_thread_name(void *thread, const char *name)
-{
-#ifdef __APPLE__
-    if (thread) /* Apple pthread can only set self's name */
-        return;
-    char truncated[64];
-#elif defined(__NetBSD__)
-    char truncated[64];
-#elif defined(__HAIKU__)
-    char truncated[32];
-#else
-    char truncated[16];
-#endif
-    strncpy(truncated, name, sizeof(truncated) - 1);
-#ifdef __APPLE__
-    pthread_setname_np(truncated);
-#elif defined(__NetBSD__)
-    pthread_setname_np(thread ? *((pthread_t *) thread) : pthread_self(), truncated, "%s");
-#elif defined(__HAIKU__)
-    rename_thread(find_thread(NULL), truncated);
-#else
-    pthread_setname_np(thread ? *((pthread_t *) thread) : pthread_self(), truncated);
-#endif
-}
-
 /* Converts the numeric language ID to a language code string */
 void
 plat_language_code_r(UNUSED(int id), UNUSED(char *outbuf), UNUSED(int len))
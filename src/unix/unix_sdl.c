@@ -54,6 +54,13 @@ int                 resize_w          = 0;
 int                 resize_h          = 0;
 static void        *pixeldata;
 
+/* Rows of pixeldata (relative to params.y) not yet uploaded to sdl_tex. */
+static SDL_SpinLock dirty_lock;
+static int          dirty_y1;
+static int          dirty_y2;
+static int          dirty_all = 1;
+static int          shim_resync = 1; /* pixeldata missed a frame, copy the next one whole */
+
 extern void RenderImGui(void);
 static void
 sdl_integer_scale(double *d, double *g)
@@ -152,9 +159,41 @@ sdl_blit_shim(int x, int y, int w, int h, int monitor_index)
     params.w = w;
     params.h = h;
 
-    if (!(!sdl_enabled || (x < 0) || (y < 0) || (w <= 0) || (h <= 0) || (w > 2048) || (h > 2048) || (buffer32 == NULL) || (sdl_render == NULL) || (sdl_tex == NULL)) || (monitor_index >= 1))
-        for (int row = 0; row < h; ++row)
-            video_copy(&(((uint8_t *) pixeldata)[row * 2048 * sizeof(uint32_t)]), &(buffer32->line[y + row][x]), w * sizeof(uint32_t));
+    if (!(!sdl_enabled || (x < 0) || (y < 0) || (w <= 0) || (h <= 0) || (w > 2048) || (h > 2048) || (buffer32 == NULL) || (sdl_render == NULL) || (sdl_tex == NULL)) || (monitor_index >= 1)) {
+        video_rect_t    dirty[VIDEO_DIRTY_RECTS_MAX];
+        int             dirty_count;
+        const bitmap_t *source = video_blit_source_monitor(monitor_index);
+
+        if (shim_resync) {
+            dirty[0].x  = x;
+            dirty[0].y  = y;
+            dirty[0].w  = w;
+            dirty[0].h  = h;
+            dirty_count = 1;
+            shim_resync = 0;
+        } else
+            dirty_count = video_blit_get_dirty_monitor(dirty, monitor_index);
+
+        for (int i = 0; i < dirty_count; i++) {
+            for (int row = dirty[i].y; row < (dirty[i].y + dirty[i].h); ++row)
+                video_copy(&(((uint8_t *) pixeldata)[(((row - y) * 2048) + (dirty[i].x - x)) * sizeof(uint32_t)]),
+                           &(source->line[row][dirty[i].x]), dirty[i].w * sizeof(uint32_t));
+        }
+
+        /* Frames may pile up before sdl_blit() runs, so accumulate. */
+        SDL_AtomicLock(&dirty_lock);
+        for (int i = 0; i < dirty_count; i++) {
+            if (dirty_y2 <= dirty_y1) {
+                dirty_y1 = dirty[i].y - y;
+                dirty_y2 = dirty[i].y - y + dirty[i].h;
+            } else {
+                dirty_y1 = MIN(dirty_y1, dirty[i].y - y);
+                dirty_y2 = MAX(dirty_y2, dirty[i].y - y + dirty[i].h);
+            }
+        }
+        SDL_AtomicUnlock(&dirty_lock);
+    } else
+        shim_resync = 1;
 
     if (monitors[monitor_index].mon_screenshots_raw)
         video_screenshot((uint32_t *) pixeldata, 0, 0, 2048);
@@ -200,6 +239,8 @@ void
 sdl_blit(int x, int y, int w, int h)
 {
     SDL_Rect r_src;
+    SDL_Rect r_upd;
+    void    *pixels;
 
     if (!sdl_enabled || (x < 0) || (y < 0) || (w <= 0) || (h <= 0) || (w > 2048) || (h > 2048) || (buffer32 == NULL) || (sdl_render == NULL) || (sdl_tex == NULL)) {
         r_src.x = x;
@@ -219,12 +260,27 @@ sdl_blit(int x, int y, int w, int h)
         resize_pending = 0;
     }
 
+    /* Upload only the rows that changed, unless the texture is new. */
+    SDL_AtomicLock(&dirty_lock);
+    r_upd.x   = x;
+    r_upd.y   = dirty_all ? 0 : MAX(dirty_y1, 0);
+    r_upd.w   = w;
+    r_upd.h   = (dirty_all ? h : MIN(dirty_y2, h)) - r_upd.y;
+    dirty_y1  = dirty_y2 = 0;
+    dirty_all = 0;
+    SDL_AtomicUnlock(&dirty_lock);
+
+    if (r_upd.h > 0) {
+        pixels = &(((uint8_t *) pixeldata)[r_upd.y * 2048 * sizeof(uint32_t)]);
+        r_upd.y += y;
+        SDL_UpdateTexture(sdl_tex, &r_upd, pixels, 2048 * 4);
+    }
+    blitreq = 0;
+
     r_src.x = x;
     r_src.y = y;
     r_src.w = w;
     r_src.h = h;
-    SDL_UpdateTexture(sdl_tex, &r_src, pixeldata, 2048 * 4);
-    blitreq = 0;
 
     sdl_real_blit(&r_src);
     SDL_UnlockMutex(sdl_mutex);
@@ -330,6 +386,7 @@ sdl_reinit_texture(void)
 
     sdl_tex = SDL_CreateTexture(sdl_render, SDL_PIXELFORMAT_ARGB8888,
                                 SDL_TEXTUREACCESS_STREAMING, 2048, 2048);
+    dirty_all = 1;
     osd_init();
 }
 
@@ -0,0 +1,339 @@
+/*
+ * 86Box    A hypervisor and IBM PC system emulator that specializes in
+ *          running old operating systems and software designed for IBM
+ *          PC systems and compatibles from 1981 through fairly recent
+ *          system designs based on the PCI bus.
+ *
+ *          This file is part of the 86Box distribution.
+ *
+ *          Pools of worker threads running jobs.
+ *
+ *          The threads of a pool take jobs off a single FIFO. With no
+ *          jobs queued they sleep on one event, so an idle pool costs
+ *          nothing.
+ *
+ *          A job is in the FIFO at most once. Submitting it while it
+ *          waits there does nothing more, and submitting it while it
+ *          runs puts it back at the end of the FIFO once it is done, so
+ *          a job never runs on two threads at once and never misses a
+ *          wake-up, just as with a thread and event of its own.
+ *
+ * Authors: 86Box contributors.
+ *
+ *          Copyright 2026 86Box contributors.
+ */
+#include <inttypes.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#define HAVE_STDARG_H
+#include <86box/86box.h>
+#include <86box/thread.h>
+#include <86box/job_pool.h>
+
+#define JOB_POOL_THREADS_MAX 8
+
+enum {
+    JOB_IDLE = 0,
+    JOB_QUEUED,
+    JOB_RUNNING
+};
+
+struct job_t {
+    const char *name;
+    void (*func)(void *priv);
+    void       *priv;
+    job_pool_t *pool;
+
+    /* All below are protected by the pool mutex. */
+    int      state;
+    int      again;   /* Submitted while running. */
+    int      closing; /* In job_close(); submissions are ignored. */
+    event_t *idle;    /* Set whenever the job goes idle. */
+    job_t   *next;
+    uint64_t queued_ns;
+
+    job_stats_t stats;
+    uint64_t    run_ns_total;
+    uint64_t    wait_ns_total;
+};
+
+struct job_pool_t {
+    const char *name;
+    mutex_t    *mutex;
+    event_t    *wake;
+    thread_t   *threads[JOB_POOL_THREADS_MAX];
+    int         threads_num;
+
+    /* Protected by the mutex. */
+    job_t *head;
+    job_t *tail;
+    int    closing;
+};
+
+#ifdef ENABLE_JOB_POOL_LOG
+int job_pool_do_log = ENABLE_JOB_POOL_LOG;
+
+static void
+job_pool_log(const char *fmt, ...)
+{
+    va_list ap;
+
+    if (job_pool_do_log) {
+        va_start(ap, fmt);
+        pclog_ex(fmt, ap);
+        va_end(ap);
+    }
+}
+#else
+#    define job_pool_log(fmt, ...)
+#endif
+
+static uint64_t
+job_pool_now_ns(void)
+{
+    struct timespec ts;
+
+    timespec_get(&ts, TIME_UTC);
+    return ((uint64_t) ts.tv_sec * 1000000000ULL) + (uint64_t) ts.tv_nsec;
+}
+
+/* Called with the mutex held. */
+static void
+job_enqueue(job_t *job)
+{
+    job_pool_t *pool = job->pool;
+
+    job->state     = JOB_QUEUED;
+    job->queued_ns = job_pool_now_ns();
+    job->next      = NULL;
+
+    if (pool->tail)
+        pool->tail->next = job;
+    else
+        pool->head = job;
+    pool->tail = job;
+
+    thread_set_event(pool->wake);
+}
+
+static void
+job_pool_thread(void *param)
+{
+    job_pool_t *pool = (job_pool_t *) param;
+
+    thread_wait_mutex(pool->mutex);
+
+    while (1) {
+        job_t   *job = pool->head;
+        uint64_t start;
+        uint64_t ns;
+
+        if (job == NULL) {
+            if (pool->closing) {
+                /* Events on Windows wake a single waiter; pass the wake-up on to the next thread. */
+                thread_set_event(pool->wake);
+                break;
+            }
+
+            /* Reset under the mutex, so that a submission made after this cannot be missed. */
+            thread_reset_event(pool->wake);
+            thread_release_mutex(pool->mutex);
+            thread_wait_event(pool->wake, -1);
+            thread_wait_mutex(pool->mutex);
+            continue;
+        }
+
+        pool->head = job->next;
+        if (pool->head == NULL)
+            pool->tail = NULL;
+        job->state = JOB_RUNNING;
+
+        start = job_pool_now_ns();
+        ns    = start - job->queued_ns;
+        job->wait_ns_total += ns;
+        if (ns > job->stats.wait_ns_max)
+            job->stats.wait_ns_max = ns;
+        thread_release_mutex(pool->mutex);
+
+        job->func(job->priv);
+
+        ns = job_pool_now_ns() - start;
+        thread_wait_mutex(pool->mutex);
+
+        job->stats.runs++;
+        job->stats.run_ns_last = ns;
+        job->run_ns_total += ns;
+        if (ns > job->stats.run_ns_max)
+            job->stats.run_ns_max = ns;
+
+        if (job->again && !job->closing) {
+            job->again = 0;
+            job_enqueue(job);
+        } else {
+            job->again = 0;
+            job->state = JOB_IDLE;
+            thread_set_event(job->idle);
+        }
+    }
+
+    thread_release_mutex(pool->mutex);
+}
+
+job_pool_t *
+job_pool_create(const char *name, int threads)
+{
+    job_pool_t *pool = calloc(1, sizeof(job_pool_t));
+
+    if (threads > JOB_POOL_THREADS_MAX)
+        threads = JOB_POOL_THREADS_MAX;
+
+    pool->name        = name;
+    pool->mutex       = thread_create_mutex();
+    pool->wake        = thread_create_event();
+    pool->threads_num = threads;
+
+    for (int i = 0; i < threads; i++)
+        pool->threads[i] = thread_create_named(job_pool_thread, pool, name);
+
+    return pool;
+}
+
+void
+job_pool_close(job_pool_t *pool)
+{
+    if (pool == NULL)
+        return;
+
+    thread_wait_mutex(pool->mutex);
+    pool->closing = 1;
+    /* Jobs that were never closed are not run again. */
+    for (job_t *job = pool->head; job != NULL; job = job->next)
+        job->state = JOB_IDLE;
+    pool->head = NULL;
+    pool->tail = NULL;
+    thread_set_event(pool->wake);
+    thread_release_mutex(pool->mutex);
+
+    for (int i = 0; i < pool->threads_num; i++)
+        thread_wait(pool->threads[i]);
+
+    job_pool_log("Job pool %s: %i threads joined\n", pool->name, pool->threads_num);
+
+    thread_destroy_event(pool->wake);
+    thread_close_mutex(pool->mutex);
+    free(pool);
+}
+
+job_t *
+job_create(job_pool_t *pool, const char *name, void (*func)(void *priv), void *priv)
+{
+    job_t *job = calloc(1, sizeof(job_t));
+
+    job->name = name;
+    job->func = func;
+    job->priv = priv;
+    job->pool = pool;
+    job->idle = thread_create_event();
+
+    return job;
+}
+
+/* Called and returns with the mutex held. */
+static void
+job_wait_idle(job_t *job)
+{
+    job_pool_t *pool = job->pool;
+
+    while (job->state != JOB_IDLE) {
+        thread_reset_event(job->idle);
+        thread_release_mutex(pool->mutex);
+        thread_wait_event(job->idle, -1);
+        thread_wait_mutex(pool->mutex);
+    }
+
+    /* Another thread may be waiting on the job too, and only one is woken per set. */
+    thread_set_event(job->idle);
+}
+
+void
+job_close(job_t *job)
+{
+    job_pool_t *pool;
+    job_stats_t stats;
+
+    if (job == NULL)
+        return;
+
+    pool = job->pool;
+    thread_wait_mutex(pool->mutex);
+
+    job->closing = 1;
+    if (job->state == JOB_QUEUED) {
+        job_t **prev = &pool->head;
+
+        while (*prev != job)
+            prev = &(*prev)->next;
+        *prev = job->next;
+
+        pool->tail = NULL;
+        for (job_t *j = pool->head; j != NULL; j = j->next)
+            pool->tail = j;
+
+        job->state = JOB_IDLE;
+    } else
+        job_wait_idle(job);
+
+    thread_release_mutex(pool->mutex);
+
+    job_get_stats(job, &stats);
+    job_pool_log("Job pool %s: %s: %" PRIu64 " runs, %" PRIu64 " coalesced, run avg %" PRIu64 " ns, max %" PRIu64 " ns, "
+                 "wait avg %" PRIu64 " ns, max %" PRIu64 " ns\n",
+                 pool->name, job->name, stats.runs, stats.coalesced, stats.run_ns_avg, stats.run_ns_max,
+                 stats.wait_ns_avg, stats.wait_ns_max);
+
+    thread_destroy_event(job->idle);
+    free(job);
+}
+
+void
+job_submit(job_t *job)
+{
+    job_pool_t *pool = job->pool;
+
+    thread_wait_mutex(pool->mutex);
+
+    if (job->closing)
+        job->stats.coalesced++;
+    else if (job->state == JOB_IDLE)
+        job_enqueue(job);
+    else if ((job->state == JOB_QUEUED) || job->again)
+        job->stats.coalesced++;
+    else
+        job->again = 1;
+
+    thread_release_mutex(pool->mutex);
+}
+
+void
+job_wait(job_t *job)
+{
+    thread_wait_mutex(job->pool->mutex);
+    job_wait_idle(job);
+    thread_release_mutex(job->pool->mutex);
+}
+
+void
+job_get_stats(job_t *job, job_stats_t *stats)
+{
+    thread_wait_mutex(job->pool->mutex);
+
+    *stats             = job->stats;
+    stats->run_ns_avg  = stats->runs ? (job->run_ns_total / stats->runs) : 0;
+    stats->wait_ns_avg = stats->runs ? (job->wait_ns_total / stats->runs) : 0;
+
+    thread_release_mutex(job->pool->mutex);
+}
@@ -37,6 +37,7 @@
 #include <86box/vid_xga.h>
 #include <86box/vid_svga.h>
 #include <86box/vid_svga_render.h>
+#include <86box/vid_blit_kernels.h>
 #include <86box/vid_ati_eeprom.h>
 #include <86box/vid_ati_mach8.h>
 #include "cpu.h"
@@ -1040,6 +1041,88 @@ ibm8514_short_stroke_start(int count, int cpu_input, uint32_t mix_dat, uint32_t
     ibm8514_accel_start(count, cpu_input, mix_dat, cpu_dat, svga, len);
 }
 
+/*
+   Screen to screen BitBLTs where every pixel takes the foreground source (a
+   colour register, zero or display memory) with a logical mix and no
+   colour compare, run a row at a time through the shared span kernels.
+   Returns 0, before touching anything, if a clipped row would wrap around
+   VRAM, to leave the blit to the pixel loop.
+ */
+static int
+ibm8514_bitblt_fast(svga_t *svga, int frgd_sel, uint16_t wrt_mask, uint16_t frgd_color, uint16_t bkgd_color)
+{
+    ibm8514_t     *dev    = (ibm8514_t *) svga->dev8514;
+    const int      bpp    = dev->bpp ? 2 : 1;
+    const uint32_t mask   = dev->bpp ? (dev->vram_mask >> 1) : dev->vram_mask;
+    const int      xdir   = (dev->accel.cmd & 0x20) ? 1 : -1;
+    const int      ydir   = (dev->accel.cmd & 0x80) ? 1 : -1;
+    const int      width  = dev->accel.sx + 1;
+    const int      height = dev->accel.sy + 1;
+    const int      copy   = (frgd_sel == 3);
+    const int16_t  clip_t = dev->accel.clip_top;
+    const int16_t  clip_l = dev->accel.clip_left;
+    const int      clip_b = dev->accel.clip_bottom;
+    const int      clip_r = dev->accel.clip_right;
+    const uint8_t  rop    = blit_mix_rop3[dev->accel.frgd_mix & 0x0f];
+    uint32_t       color  = 0;
+    int16_t        dy     = dev->accel.dy;
+    int16_t        cy     = dev->accel.cy;
+
+    if (frgd_sel == 0)
+        color = bkgd_color;
+    else if (frgd_sel == 1)
+        color = frgd_color;
+
+    for (int pass = 0; pass < 2; pass++) {
+        dy = dev->accel.dy;
+        cy = dev->accel.cy;
+
+        for (int y = 0; y < height; y++) {
+            const int x1    = dev->accel.dx + ((width - 1) * xdir);
+            const int left  = MAX(MIN(dev->accel.dx, x1), clip_l);
+            const int right = MIN(MAX(dev->accel.dx, x1), clip_r);
+
+            if ((dy >= clip_t) && (dy <= clip_b) && (left <= right)) {
+                const int      count = right - left + 1;
+                const int      first = (xdir > 0) ? left : right;
+                const uint32_t dst   = (dev->accel.ge_offset + (dy * dev->pitch) + first) & mask;
+                const uint32_t src   = (dev->accel.ge_offset + (cy * dev->pitch) + dev->accel.cx + (first - dev->accel.dx)) & mask;
+                const uint32_t low   = (xdir > 0) ? dst : (dst - (count - 1));
+
+                if (pass == 0) {
+                    if ((xdir > 0) ? ((dst + count - 1) > mask) : (dst < (uint32_t) (count - 1)))
+                        return 0;
+                    if (copy && ((xdir > 0) ? ((src + count - 1) > mask) : (src < (uint32_t) (count - 1))))
+                        return 0;
+                } else {
+                    if (copy)
+                        blit_rop3_span(&dev->vram[dst * bpp], &dev->vram[src * bpp], count, bpp, xdir, rop, 0, wrt_mask);
+                    else
+                        blit_rop3_span(&dev->vram[dst * bpp], NULL, count, bpp, xdir, blit_rop3_src_as_pat(rop), color, wrt_mask);
+                    blit_mark_changed(dev->changedvram, low * bpp, count * bpp, svga->monitor->mon_changeframecount);
+                }
+            }
+
+            dy += ydir;
+            cy += ydir;
+        }
+    }
+
+    /* Leave the engine as the pixel loop would at the end of the blit. */
+    dev->accel.dy         = dy;
+    dev->accel.cy         = cy;
+    dev->accel.src        = dev->accel.ge_offset + (cy * dev->pitch);
+    dev->accel.dest       = dev->accel.ge_offset + (dy * dev->pitch);
+    dev->accel.sy         = -1;
+    dev->accel.fill_state = 0;
+    dev->accel.destx      = dev->accel.dx;
+    dev->accel.desty      = dy;
+    dev->fifo_idx         = 0;
+    dev->accel.cmd_back   = 1;
+
+    return 1;
+}
+
 void
 ibm8514_accel_start(int count, int cpu_input, uint32_t mix_dat, uint32_t cpu_dat, svga_t *svga, UNUSED(int len))
 {
@@ -3252,6 +3335,10 @@ skip_nibble_bitblt_write:
                             }
                         }
                     } else {
+                        if ((mix_dat == 0xffffffff) && (pixcntl != 3) && !compare_mode && (dev->accel.frgd_mix < 0x10) &&
+                            ibm8514_bitblt_fast(svga, frgd_mix, wrt_mask, frgd_color, bkgd_color))
+                            return;
+
                         while (count-- && dev->accel.sy >= 0) {
                             if ((dev->accel.dx >= clip_l) &&
                                 (dev->accel.dx <= clip_r) &&
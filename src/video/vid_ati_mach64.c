@@ -38,6 +38,7 @@
 #include <86box/vid_xga.h>
 #include <86box/vid_svga.h>
 #include <86box/vid_svga_render.h>
+#include <86box/vid_blit_kernels.h>
 #include <86box/vid_ati_eeprom.h>
 #include <86box/bswap.h>
 
@@ -1887,6 +1888,136 @@ mach64_start_line(mach64_t *mach64)
         svga->changedvram[(((addr) >> 3) & mach64->vram_mask) >> 12] = svga->monitor->mon_changeframecount; \
     }
 
+/*
+   Rectangle fills with the foreground colour, plain screen to screen
+   copies and left to right expansions of a 1bpp bitmap in VRAM, run a row
+   at a time through the shared span kernels. Only taken
+   for a freshly started blit with no host data, colour compare, polygon,
+   24bpp rotation or source tiling, and with rows that neither wrap in X
+   nor cross the end of VRAM. Returns 0 to fall back to the pixel loop.
+ */
+static int
+mach64_blit_rect_fast(mach64_t *mach64)
+{
+    svga_t        *svga   = &mach64->svga;
+    const int      size   = mach64->accel.dst_size;
+    const int      bpp    = 1 << size;
+    const int      xinc   = mach64->accel.xinc;
+    const int      width  = mach64->accel.dst_width;
+    const int      height = mach64->accel.dst_height;
+    const int      copy   = (mach64->accel.source_fg == SRC_BLITSRC);
+    const int      mono   = (mach64->accel.source_mix == MONO_SRC_BLITSRC);
+    const uint8_t  rop    = blit_mix_rop3[mach64->accel.mix_fg & 0xf];
+    const uint8_t  rop_bg = blit_mix_rop3[mach64->accel.mix_bg & 0xf];
+    int            src_x_start;
+    int            src_y;
+    int            dst_y;
+
+    if (mach64->accel.source_host || (!mono && (mach64->accel.source_mix != MONO_SRC_1)) ||
+        (mach64->accel.mix_fg & 0x10) || (size > 2) || (width <= 0) || (height <= 0) ||
+        (mach64->dst_cntl & (DST_POLYGON_EN | DST_24_ROT_EN)) ||
+        (mach64->accel.clr_cmp_fn == 1) || (mach64->accel.clr_cmp_fn == 4) || (mach64->accel.clr_cmp_fn == 5) ||
+        mach64->accel.dst_x || mach64->accel.dst_y)
+        return 0;
+
+    if (mach64->src_cntl & (SRC_LINEAR_EN | SRC_PATT_EN))
+        return 0;
+
+    if (mono) {
+        /* The background is either mixed like the foreground or left alone. */
+        if ((mach64->accel.source_fg != SRC_FG) || (mach64->accel.source_bg != SRC_BG) ||
+            (mach64->accel.src_size != WIDTH_1BIT) || (mach64->accel.src_width1 < width) || (xinc < 0) ||
+            (mach64->accel.mix_bg & 0x10) || ((rop_bg != rop) && (rop_bg != BLIT_ROP3_NOP)))
+            return 0;
+    } else if (copy) {
+        if ((mach64->accel.src_size != size) || (mach64->accel.src_width1 < width) ||
+            ((size == 0) && (mach64->type == MACH64_VT3) && (mach64->src_cntl & SRC_8x8x8_BRUSH)))
+            return 0;
+    } else if (mach64->accel.source_fg != SRC_FG)
+        return 0;
+
+    /* Every row must be contiguous in X and in VRAM. */
+    for (int pass = 0; pass < 2; pass++) {
+        src_x_start = mach64->accel.src_x_start;
+        src_y       = 0;
+        dst_y       = 0;
+
+        for (int y = 0; y < height; y++) {
+            const int dy    = (dst_y + mach64->accel.dst_y_start) & 0x3fff;
+            const int sy    = (src_y + mach64->accel.src_y_start) & 0x3fff;
+            const int x0    = mach64->accel.dst_x_start;
+            const int x1    = x0 + (width - 1) * xinc;
+            const int sx0   = src_x_start;
+            const int sx1   = sx0 + (width - 1) * xinc;
+            int       left  = MAX(MIN(x0, x1), mach64->accel.sc_left);
+            int       right = MIN(MAX(x0, x1), mach64->accel.sc_right);
+
+            if ((MIN(x0, x1) < 0) || (MAX(x0, x1) > 0xfff))
+                return 0;
+            if ((copy || mono) && ((MIN(sx0, sx1) < 0) || (MAX(sx0, sx1) > 0xfff)))
+                return 0;
+
+            if ((dy >= mach64->accel.sc_top) && (dy <= mach64->accel.sc_bottom) && (left <= right)) {
+                const int      first = (xinc > 0) ? left : right;
+                const int      count = right - left + 1;
+                const uint32_t dst   = (uint32_t) (mach64->accel.dst_offset + (dy * mach64->accel.dst_pitch) + left) << size;
+                const uint32_t src   = (uint32_t) (mach64->accel.src_offset + (sy * mach64->accel.src_pitch) +
+                                                 sx0 + (left - x0)) << size;
+                const uint32_t bit   = mach64->accel.src_offset + (sy * mach64->accel.src_pitch) + sx0 + (left - x0);
+                const uint32_t bytes = count << size;
+                const int      skip  = (first - left) << size;
+
+                if (pass == 0) {
+                    if (((dst + bytes - 1) > mach64->vram_mask) || (dst > mach64->vram_mask))
+                        return 0;
+                    if (mono && (((bit + count - 1) >> 3) > mach64->vram_mask))
+                        return 0;
+                    if (copy && (((src + bytes - 1) > mach64->vram_mask) || (src > mach64->vram_mask)))
+                        return 0;
+                } else {
+                    if (mono)
+                        blit_mono_expand_span(&svga->vram[dst], &svga->vram[bit >> 3], bit & 7,
+                                              !!(mach64->dp_pix_width & DP_BYTE_PIX_ORDER), count, bpp, 1,
+                                              mach64->accel.dp_frgd_clr, mach64->accel.dp_bkgd_clr,
+                                              rop_bg != rop, rop, mach64->accel.write_mask);
+                    else if (copy)
+                        blit_rop3_span(&svga->vram[dst + skip], &svga->vram[src + skip],
+                                       count, bpp, xinc, rop, 0, mach64->accel.write_mask);
+                    else
+                        blit_rop3_span(&svga->vram[dst + skip], NULL, count, bpp, xinc,
+                                       blit_rop3_src_as_pat(rop),
+                                       mach64->accel.dp_frgd_clr, mach64->accel.write_mask);
+                    blit_mark_changed(svga->changedvram, dst, bytes, svga->monitor->mon_changeframecount);
+                }
+            }
+
+            src_x_start = (mach64->src_y_x >> 16) & 0xfff;
+            src_y += mach64->accel.yinc;
+            dst_y += mach64->accel.yinc;
+        }
+    }
+
+    /* Leave the engine as the pixel loop would at the end of the blit. */
+    mach64->accel.x_count     = width;
+    mach64->accel.xx_count    = 0;
+    mach64->accel.dst_x       = 0;
+    mach64->accel.dst_y       = dst_y;
+    mach64->accel.src_x       = 0;
+    mach64->accel.src_y       = src_y;
+    mach64->accel.src_x_start = src_x_start;
+    mach64->accel.src_x_count = mach64->accel.src_width1;
+    mach64->accel.src_y_count -= height;
+    mach64->accel.poly_draw   = 0;
+    mach64->accel.dst_height  = 0;
+    mach64->accel.busy        = 0;
+    if (mach64->dst_cntl & DST_X_TILE)
+        mach64->dst_y_x = (mach64->dst_y_x & 0xfff) | ((mach64->dst_y_x + (mach64->accel.dst_width << 16)) & 0xfff0000);
+    if (mach64->dst_cntl & DST_Y_TILE)
+        mach64->dst_y_x = (mach64->dst_y_x & 0xfff0000) | ((mach64->dst_y_x + (mach64->dst_height_width & 0x1fff)) & 0xfff);
+
+    return 1;
+}
+
 void
 mach64_blit(uint32_t cpu_dat, int count, mach64_t *mach64)
 {
@@ -1901,6 +2032,9 @@ mach64_blit(uint32_t cpu_dat, int count, mach64_t *mach64)
 
     switch (mach64->accel.op) {
         case OP_RECT:
+            if ((count == -1) && mach64_blit_rect_fast(mach64))
+                return;
+
             while (count) {
                 uint8_t  write_mask = 0;
                 uint32_t src_dat = 0;
@@ -0,0 +1,465 @@
+/*
+ * 86Box    A hypervisor and IBM PC system emulator that specializes in
+ *          running old operating systems and software designed for IBM
+ *          PC systems and compatibles from 1981 through fairly recent
+ *          system designs based on the PCI bus.
+ *
+ *          This file is part of the 86Box distribution.
+ *
+ *          Shared span kernels for the 2D accelerators.
+ *
+ *          All raster operations are bitwise, so a span is processed as a
+ *          run of bytes with the pattern and write mask replicated to the
+ *          pixel size. A per-pixel walk that never reads a pixel it has
+ *          already written is equivalent to computing every pixel from
+ *          the original contents, which is done here in 16-byte blocks
+ *          in memmove order (SSE2 on x86-64, NEON on ARM64, 64-bit words
+ *          elsewhere). Walks that do read back their own output, such as
+ *          a forward blit onto an overlapping later destination, are
+ *          replayed pixel by pixel. benchmarks/vid_blit_micro.c checks
+ *          every path against a per-pixel reference.
+ *
+ * Authors: 86Box contributors.
+ *
+ *          Copyright 2026 86Box contributors.
+ */
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <86box/vid_blit_kernels.h>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#    define BLIT_SSE2
+#    include <emmintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#    define BLIT_NEON
+#    include <arm_neon.h>
+#endif
+
+/* Pattern and mask bytes are fetched at (byte offset % bpp) from a 32-byte replica. */
+#define REPL_SIZE 32
+
+const uint8_t blit_mix_rop3[16] = {
+    0x55, /* ~D */
+    0x00, /* 0 */
+    0xff, /* 1 */
+    0xaa, /* D */
+    0x33, /* ~S */
+    0x66, /* S ^ D */
+    0x99, /* ~(S ^ D) */
+    0xcc, /* S */
+    0x77, /* ~(S & D) */
+    0xbb, /* ~S | D */
+    0xdd, /* S | ~D */
+    0xee, /* S | D */
+    0x88, /* S & D */
+    0x44, /* S & ~D */
+    0x22, /* ~S & D */
+    0x11  /* ~(S | D) */
+};
+
+/*
+   Common codes get a direct expression, the rest are built from minterms.
+   ANDN(a, b) is ~a & b. When the ROP ignores the source, s aliases d.
+ */
+#define ROP3_BODY(T, AND, OR, XOR, ANDN, ONES)            \
+    switch (rop) {                                        \
+        case 0x00:                                        \
+            return XOR(d, d);                             \
+        case 0x0f:                                        \
+            return XOR(p, ONES);                          \
+        case 0x11:                                        \
+            return XOR(OR(s, d), ONES);                   \
+        case 0x22:                                        \
+            return ANDN(s, d);                            \
+        case 0x33:                                        \
+            return XOR(s, ONES);                          \
+        case 0x44:                                        \
+            return ANDN(d, s);                            \
+        case 0x55:                                        \
+            return XOR(d, ONES);                          \
+        case 0x5a:                                        \
+            return XOR(p, d);                             \
+        case 0x66:                                        \
+            return XOR(s, d);                             \
+        case 0x77:                                        \
+            return XOR(AND(s, d), ONES);                  \
+        case 0x88:                                        \
+            return AND(s, d);                             \
+        case 0x99:                                        \
+            return XOR(XOR(s, d), ONES);                  \
+        case 0xaa:                                        \
+            return d;                                     \
+        case 0xbb:                                        \
+            return OR(XOR(s, ONES), d);                   \
+        case 0xcc:                                        \
+            return s;                                     \
+        case 0xdd:                                        \
+            return OR(s, XOR(d, ONES));                   \
+        case 0xee:                                        \
+            return OR(s, d);                              \
+        case 0xf0:                                        \
+            return p;                                     \
+        case 0xff:                                        \
+            return ONES;                                  \
+        default:                                          \
+            break;                                        \
+    }                                                     \
+    {                                                     \
+        T r = XOR(d, d);                                  \
+        for (int m = 0; m < 8; m++) {                     \
+            if (rop & (1 << m)) {                         \
+                T t = (m & 4) ? p : XOR(p, ONES);         \
+                t   = AND(t, (m & 2) ? s : XOR(s, ONES)); \
+                t   = AND(t, (m & 1) ? d : XOR(d, ONES)); \
+                r   = OR(r, t);                           \
+            }                                             \
+        }                                                 \
+        return r;                                         \
+    }
+
+#define S_AND(a, b)  ((a) & (b))
+#define S_OR(a, b)   ((a) | (b))
+#define S_XOR(a, b)  ((a) ^ (b))
+#define S_ANDN(a, b) (~(a) & (b))
+
+static inline uint64_t
+rop3_u64(uint8_t rop, uint64_t d, uint64_t s, uint64_t p)
+{
+    ROP3_BODY(uint64_t, S_AND, S_OR, S_XOR, S_ANDN, ~(uint64_t) 0)
+}
+
+static inline uint8_t
+rop3_u8(uint8_t rop, uint8_t d, uint8_t s, uint8_t p)
+{
+    return (uint8_t) rop3_u64(rop, d, s, p);
+}
+
+#ifdef BLIT_SSE2
+static inline __m128i
+rop3_sse2(uint8_t rop, __m128i d, __m128i s, __m128i p)
+{
+    ROP3_BODY(__m128i, _mm_and_si128, _mm_or_si128, _mm_xor_si128, _mm_andnot_si128, _mm_set1_epi32(-1))
+}
+#endif
+
+#ifdef BLIT_NEON
+#    define N_ANDN(a, b) vbicq_u8(b, a)
+
+static inline uint8x16_t
+rop3_neon(uint8_t rop, uint8x16_t d, uint8x16_t s, uint8x16_t p)
+{
+    ROP3_BODY(uint8x16_t, vandq_u8, vorrq_u8, veorq_u8, N_ANDN, vdupq_n_u8(0xff))
+}
+#endif
+
+static inline uint32_t
+px_read(const uint8_t *p, int bpp)
+{
+    switch (bpp) {
+        case 1:
+            return p[0];
+        case 2:
+            return p[0] | (p[1] << 8);
+        case 3:
+            return p[0] | (p[1] << 8) | (p[2] << 16);
+        default:
+            return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t) p[3] << 24);
+    }
+}
+
+static inline void
+px_write(uint8_t *p, int bpp, uint32_t val)
+{
+    p[0] = val & 0xff;
+    if (bpp > 1)
+        p[1] = (val >> 8) & 0xff;
+    if (bpp > 2)
+        p[2] = (val >> 16) & 0xff;
+    if (bpp > 3)
+        p[3] = val >> 24;
+}
+
+static inline uint32_t
+px_mask(int bpp)
+{
+    return (bpp >= 4) ? 0xffffffff : ((1u << (bpp << 3)) - 1);
+}
+
+static void
+replicate(uint8_t *buf, uint32_t val, int bpp)
+{
+    for (int i = 0; i < REPL_SIZE; i++)
+        buf[i] = (val >> ((i % bpp) << 3)) & 0xff;
+}
+
+/*
+   Whether a per-pixel walk from dst/src in direction dir can be replayed from
+   the original contents, i.e. never reads a source pixel it has overwritten.
+ */
+static int
+walk_is_snapshot(const uint8_t *dst, const uint8_t *src, int count, int bpp, int dir)
+{
+    const ptrdiff_t span = (ptrdiff_t) count * bpp;
+    const uint8_t  *dlo  = (dir < 0) ? (dst - span + bpp) : dst;
+    const uint8_t  *slo  = (dir < 0) ? (src - span + bpp) : src;
+
+    if ((dlo + span <= slo) || (slo + span <= dlo))
+        return 1;
+
+    return (dir < 0) ? (dst >= src) : (dst <= src);
+}
+
+void
+blit_fill_span(uint8_t *dst, int count, int bpp, uint32_t color)
+{
+    /* 16 bytes hold a whole number of 8/16/32-bit pixels, 48 of 24-bit ones. */
+    const size_t period = (bpp == 3) ? 48 : 16;
+    const size_t n      = (size_t) count * bpp;
+    uint8_t      repl[48];
+    size_t       o = 0;
+
+    if (count <= 0)
+        return;
+
+    if (bpp == 1) {
+        memset(dst, color & 0xff, n);
+        return;
+    }
+
+    for (size_t i = 0; i < period; i++)
+        repl[i] = (color >> ((i % bpp) << 3)) & 0xff;
+    if (bpp == 3) {
+        for (; (o + 48) <= n; o += 48)
+            memcpy(dst + o, repl, 48);
+    } else {
+        for (; (o + 16) <= n; o += 16)
+            memcpy(dst + o, repl, 16);
+    }
+    memcpy(dst + o, repl, n - o);
+}
+
+void
+blit_copy_span(uint8_t *dst, const uint8_t *src, int count, int bpp, int dir)
+{
+    const ptrdiff_t step = (ptrdiff_t) dir * bpp;
+
+    if (count <= 0)
+        return;
+
+    if (walk_is_snapshot(dst, src, count, bpp, dir)) {
+        const ptrdiff_t span = (ptrdiff_t) count * bpp;
+
+        if (dir < 0)
+            memmove(dst - span + bpp, src - span + bpp, span);
+        else
+            memmove(dst, src, span);
+        return;
+    }
+
+    /* The walk reads back what it wrote, which replicates the first pixels along the span. */
+    for (int i = 0; i < count; i++, dst += step, src += step)
+        px_write(dst, bpp, px_read(src, bpp));
+}
+
+#ifdef BLIT_SSE2
+#    define BLOCK 16
+typedef __m128i blk_t;
+#    define BLK_LOAD(p)      _mm_loadu_si128((const __m128i *) (p))
+#    define BLK_STORE(p, v)  _mm_storeu_si128((__m128i *) (p), v)
+#    define BLK_SEL(m, a, b) _mm_or_si128(_mm_and_si128(a, m), _mm_andnot_si128(m, b))
+#    define BLK_ROP3         rop3_sse2
+#elif defined(BLIT_NEON)
+#    define BLOCK 16
+typedef uint8x16_t blk_t;
+#    define BLK_LOAD(p)      vld1q_u8(p)
+#    define BLK_STORE(p, v)  vst1q_u8(p, v)
+#    define BLK_SEL(m, a, b) vbslq_u8(m, a, b)
+#    define BLK_ROP3         rop3_neon
+#else
+#    define BLOCK 8
+typedef uint64_t blk_t;
+
+static inline uint64_t
+ld64(const uint8_t *p)
+{
+    uint64_t v;
+
+    memcpy(&v, p, 8);
+    return v;
+}
+
+#    define BLK_LOAD(p)      ld64(p)
+#    define BLK_STORE(p, v)  memcpy(p, &(uint64_t) { v }, 8)
+#    define BLK_SEL(m, a, b) (((a) & (m)) | ((b) & ~(m)))
+#    define BLK_ROP3         rop3_u64
+#endif
+
+#define ROP3_BLOCK(k, rop_code)                                                              \
+    {                                                                                        \
+        const blk_t vd = BLK_LOAD(d + (k) * BLOCK);                                          \
+        const blk_t vs = BLK_LOAD(s + (k) * BLOCK);                                          \
+                                                                                             \
+        BLK_STORE(d + (k) * BLOCK, BLK_SEL(vm[ph], BLK_ROP3(rop_code, vd, vs, vp[ph]), vd)); \
+    }
+
+#define ROP3_BYTE(o, rop_code)                                                              \
+    {                                                                                       \
+        const uint8_t m = mask[(o) % bpp];                                                  \
+                                                                                            \
+        d[o] = (rop3_u8(rop_code, d[o], s[o], pat[(o) % bpp]) & m) | (d[o] & (uint8_t) ~m); \
+    }
+
+/*
+   Blocks are aligned to the start of the span, so block k sees the pattern
+   at phase (k * BLOCK) % bpp; ph tracks k % bpp. Descending order handles
+   the partial block at the top first.
+ */
+#define ROP3_LOOP(rop_code)                         \
+    if (desc) {                                     \
+        for (size_t o = n; o-- > (blocks * BLOCK);) \
+            ROP3_BYTE(o, rop_code)                  \
+        ph = blocks % bpp;                          \
+        for (size_t k = blocks; k-- > 0;) {         \
+            ph = ph ? (ph - 1) : (bpp - 1);         \
+            ROP3_BLOCK(k, rop_code)                 \
+        }                                           \
+    } else {                                        \
+        ph = 0;                                     \
+        for (size_t k = 0; k < blocks; k++) {       \
+            ROP3_BLOCK(k, rop_code)                 \
+            ph = ((ph + 1) == bpp) ? 0 : (ph + 1);  \
+        }                                           \
+        for (size_t o = blocks * BLOCK; o < n; o++) \
+            ROP3_BYTE(o, rop_code)                  \
+    }
+
+#define ROP3_CASE(rop_code)  \
+    case rop_code:           \
+        ROP3_LOOP(rop_code); \
+        break;
+
+/*
+   Applies the ROP to n bytes from the original contents, in memmove order.
+   The common codes get their own copy of the loop so the operation is
+   resolved at compile time.
+ */
+static void
+rop3_bytes(uint8_t *d, const uint8_t *s, size_t n, int bpp, uint8_t rop,
+           const uint8_t *pat, const uint8_t *mask)
+{
+    const int    desc   = (s != NULL) && (d > s);
+    const size_t blocks = n / BLOCK;
+    blk_t        vp[4];
+    blk_t        vm[4];
+    int          ph;
+
+    if (s == NULL)
+        s = d;
+
+    for (int i = 0; i < bpp; i++) {
+        vp[i] = BLK_LOAD(pat + ((i * BLOCK) % bpp));
+        vm[i] = BLK_LOAD(mask + ((i * BLOCK) % bpp));
+    }
+
+    switch (rop) {
+        ROP3_CASE(0x00)
+        ROP3_CASE(0x0f)
+        ROP3_CASE(0x11)
+        ROP3_CASE(0x22)
+        ROP3_CASE(0x33)
+        ROP3_CASE(0x44)
+        ROP3_CASE(0x55)
+        ROP3_CASE(0x5a)
+        ROP3_CASE(0x66)
+        ROP3_CASE(0x77)
+        ROP3_CASE(0x88)
+        ROP3_CASE(0x99)
+        ROP3_CASE(0xaa)
+        ROP3_CASE(0xbb)
+        ROP3_CASE(0xcc)
+        ROP3_CASE(0xdd)
+        ROP3_CASE(0xee)
+        ROP3_CASE(0xf0)
+        ROP3_CASE(0xff)
+        default:
+            ROP3_LOOP(rop);
+            break;
+    }
+}
+
+void
+blit_rop3_span(uint8_t *dst, const uint8_t *src, int count, int bpp, int dir,
+               uint8_t rop, uint32_t pat, uint32_t wmask)
+{
+    const uint32_t  pmask = px_mask(bpp);
+    const int       full  = (wmask & pmask) == pmask;
+    const ptrdiff_t span  = (ptrdiff_t) count * bpp;
+    uint8_t         prepl[REPL_SIZE];
+    uint8_t         mrepl[REPL_SIZE];
+
+    if (count <= 0)
+        return;
+
+    if (!BLIT_ROP3_USES_S(rop))
+        src = NULL;
+
+    if (full) {
+        if (rop == BLIT_ROP3_NOP)
+            return;
+        if (rop == BLIT_ROP3_SRCCOPY) {
+            blit_copy_span(dst, src, count, bpp, dir);
+            return;
+        }
+        if ((src == NULL) && !BLIT_ROP3_USES_D(rop)) {
+            blit_fill_span((dir < 0) ? (dst - span + bpp) : dst, count, bpp, blit_rop3(rop, 0, 0, pat));
+            return;
+        }
+    }
+
+    if ((src != NULL) && !walk_is_snapshot(dst, src, count, bpp, dir)) {
+        const ptrdiff_t step = (ptrdiff_t) dir * bpp;
+
+        for (int i = 0; i < count; i++, dst += step, src += step) {
+            const uint32_t d = px_read(dst, bpp);
+
+            px_write(dst, bpp, (blit_rop3(rop, d, px_read(src, bpp), pat) & wmask) | (d & ~wmask));
+        }
+        return;
+    }
+
+    replicate(prepl, pat, bpp);
+    replicate(mrepl, wmask, bpp);
+    if (dir < 0) {
+        dst -= span - bpp;
+        if (src != NULL)
+            src -= span - bpp;
+    }
+    rop3_bytes(dst, src, span, bpp, rop, prepl, mrepl);
+}
+
+void
+blit_mono_expand_span(uint8_t *dst, const uint8_t *bits, int bit_offset, int lsb_first,
+                      int count, int bpp, int dir, uint32_t fg, uint32_t bg,
+                      int bg_transparent, uint8_t rop, uint32_t wmask)
+{
+    const ptrdiff_t step   = (ptrdiff_t) dir * bpp;
+    const uint32_t  pmask  = px_mask(bpp);
+    const int       direct = ((wmask & pmask) == pmask) && (rop == BLIT_ROP3_SRCCOPY);
+
+    for (int i = 0; i < count; i++, dst += step) {
+        const int bit = bit_offset + i;
+        const int set = lsb_first ? ((bits[bit >> 3] >> (bit & 7)) & 1) : ((bits[bit >> 3] >> (7 - (bit & 7))) & 1);
+
+        if (!set && bg_transparent)
+            continue;
+
+        if (direct)
+            px_write(dst, bpp, set ? fg : bg);
+        else {
+            const uint32_t d = px_read(dst, bpp);
+
+            px_write(dst, bpp, (blit_rop3(rop, d, set ? fg : bg, 0) & wmask) | (d & ~wmask));
+        }
+    }
+}
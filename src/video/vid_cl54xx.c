@@ -39,6 +39,7 @@
 #include <86box/vid_xga.h>
 #include <86box/vid_svga.h>
 #include <86box/vid_svga_render.h>
+#include <86box/vid_blit_kernels.h>
 #include <86box/plat_fallthrough.h>
 #include <86box/plat_unused.h>
 
@@ -2194,6 +2195,47 @@ gd54xx_rop(gd54xx_t *gd54xx, uint8_t *res, uint8_t *dst, const uint8_t *src)
     }
 }
 
+/* The Cirrus ROP codes as ROP3 codes for the shared span kernels; unknown codes leave the destination alone. */
+static uint8_t
+gd54xx_rop3(uint8_t rop)
+{
+    switch (rop) {
+        case 0x00:
+            return BLIT_ROP3_BLACKNESS;
+        case 0x05:
+            return BLIT_ROP3_SRCAND;
+        case 0x09:
+            return 0x44;
+        case 0x0b:
+            return BLIT_ROP3_DSTINVERT;
+        case 0x0d:
+            return BLIT_ROP3_SRCCOPY;
+        case 0x0e:
+            return BLIT_ROP3_WHITENESS;
+        case 0x50:
+            return 0x22;
+        case 0x59:
+            return BLIT_ROP3_SRCINVERT;
+        case 0x6d:
+            return BLIT_ROP3_SRCPAINT;
+        case 0x90:
+            return 0x11;
+        case 0x95:
+            return 0x99;
+        case 0xad:
+            return 0xdd;
+        case 0xd0:
+            return BLIT_ROP3_NOTSRC;
+        case 0xd6:
+            return 0xbb;
+        case 0xda:
+            return 0x77;
+
+        default:
+            return BLIT_ROP3_NOP;
+    }
+}
+
 static uint8_t
 gd54xx_get_aperture(gd54xx_t *gd54xx, uint32_t addr)
 {
@@ -3740,6 +3782,80 @@ gd54xx_mem_sys_src(gd54xx_t *gd54xx, uint32_t cpu_dat, uint32_t count)
     }
 }
 
+/*
+   Screen to screen blits that can be finished with the given byte count,
+   one row at a time through the shared span kernels: plain copies, and
+   forward color expansions whose rows hold whole pixels. Returns 0 to fall
+   back to the byte loop when a row wraps around the end of VRAM.
+ */
+static int
+gd54xx_normal_blit_fast(uint32_t count, gd54xx_t *gd54xx, svga_t *svga)
+{
+    const uint32_t width  = gd54xx->blt.width + 1;
+    const uint32_t height = gd54xx->blt.height + 1;
+    const int      dir    = gd54xx->blt.dir;
+    const int      bpp    = gd54xx->blt.pixel_width;
+    const int      expand = !!(gd54xx->blt.mode & CIRRUS_BLTMODE_COLOREXPAND);
+    const int      transp = !!(gd54xx->blt.mode & CIRRUS_BLTMODE_TRANSPARENTCOMP);
+    const uint8_t  rop    = gd54xx_rop3(gd54xx->blt.rop);
+    /* Color expansion reads one bit per pixel, each row starting on a new byte. */
+    const uint32_t src_len  = expand ? (((width / bpp) + 7) >> 3) : width;
+    const uint32_t src_step = expand ? src_len : (gd54xx->blt.src_pitch * dir);
+    const uint32_t skip     = expand ? (gd54xx->blt.pattern_x / bpp) : 0;
+    uint32_t       dst_addr;
+    uint32_t       src_addr;
+
+    if ((uint64_t) width * height > count)
+        return 0;
+    if (expand) {
+        /* The inverted transparent case writes only the clear bits. */
+        if ((dir < 0) || (width % bpp) || (gd54xx->blt.pattern_x % bpp) ||
+            (transp && (gd54xx->blt.modeext & CIRRUS_BLTMODEEXT_COLOREXPINV)))
+            return 0;
+    } else if (transp)
+        return 0;
+
+    dst_addr = gd54xx->blt.dst_addr;
+    src_addr = gd54xx->blt.src_addr;
+    for (uint32_t y = 0; y < height; y++) {
+        const uint32_t d = dst_addr & gd54xx->vram_mask;
+        const uint32_t s = src_addr & gd54xx->vram_mask;
+
+        if ((dir > 0) ? (((d + width - 1) > gd54xx->vram_mask) || ((s + src_len - 1) > gd54xx->vram_mask)) :
+                        ((d < (width - 1)) || (s < (width - 1))))
+            return 0;
+        dst_addr += gd54xx->blt.dst_pitch * dir;
+        src_addr += src_step;
+    }
+
+    dst_addr = gd54xx->blt.dst_addr;
+    src_addr = gd54xx->blt.src_addr;
+    for (uint32_t y = 0; y < height; y++) {
+        const uint32_t d = dst_addr & gd54xx->vram_mask;
+        const uint32_t s = src_addr & gd54xx->vram_mask;
+
+        if (!expand)
+            blit_rop3_span(&svga->vram[d], &svga->vram[s], width, 1, dir, rop, 0, 0xff);
+        else if (skip < (width / bpp))
+            blit_mono_expand_span(&svga->vram[d + (skip * bpp)], &svga->vram[s], skip, 0, (width / bpp) - skip, bpp, 1,
+                                  gd54xx->blt.fg_col, gd54xx->blt.bg_col, transp, rop, 0xffffffff);
+        blit_mark_changed(svga->changedvram, (dir > 0) ? d : (d - (width - 1)), width, changeframecount);
+        dst_addr += gd54xx->blt.dst_pitch * dir;
+        src_addr += src_step;
+    }
+
+    /* Leave the registers as the byte loop would after its last row. */
+    gd54xx->blt.dst_addr_backup = dst_addr & gd54xx->vram_mask;
+    if (!expand)
+        gd54xx->blt.src_addr_backup = src_addr & gd54xx->vram_mask;
+    gd54xx->blt.y_count         = (height * dir) & 7;
+    gd54xx->blt.x_count         = 0;
+    gd54xx->blt.height_internal = 0xffff;
+
+    gd54xx_reset_blit(gd54xx);
+    return 1;
+}
+
 static void
 gd54xx_normal_blit(uint32_t count, gd54xx_t *gd54xx, svga_t *svga)
 {
@@ -3760,6 +3876,9 @@ gd54xx_normal_blit(uint32_t count, gd54xx_t *gd54xx, svga_t *svga)
     gd54xx->blt.x_count         = 0;
     gd54xx->blt.y_count         = 0;
 
+    if (gd54xx_normal_blit_fast(count, gd54xx, svga))
+        return;
+
     while (count) {
         src  = 0;
         mask = 0;
@@ -36,6 +36,7 @@
 #include <86box/video.h>
 #include <86box/vid_svga.h>
 #include <86box/vid_svga_render.h>
+#include <86box/vid_blit_kernels.h>
 
 #define BIOS_ROM_PATH_W32_MACHSPEED_VGA_GUI_2400S   "roms/video/et4000w32/ET4000W32VLB_bios_MX27C512.BIN"
 #define BIOS_ROM_PATH_W32I_REVB_AXIS_MICRODEVICE    "roms/video/et4000w32/ET4KW32I.VBI"
@@ -2160,6 +2161,86 @@ et4000w32_decy(et4000w32p_t *et4000)
         }                                          \
     }
 
+/*
+   Runs whole rows of a screen to screen BitBLT through the shared span
+   kernels for as long as they need no byte by byte work: the foreground
+   ROP throughout, a source that does not wrap within the row, a pattern
+   that is unused or repeats every 4 bytes, and rows that stay clear of the
+   end of VRAM. Returns 1 once the last row is done, or 0 with the engine
+   at the start of the first row left for the byte loop.
+ */
+static int
+et4000w32_blit_rows_fast(et4000w32p_t *et4000, int w32p)
+{
+    svga_t        *svga   = &et4000->svga;
+    const uint8_t  rop    = et4000->acl.internal.rop_fg;
+    const int      dir    = (et4000->acl.internal.xy_dir & 1) ? -1 : 1;
+    const uint32_t width  = et4000->acl.internal.count_x + 1;
+    const int      pat_x  = et4000w32_max_x[et4000->acl.internal.pattern_wrap & 7];
+    const int      src_x  = et4000w32_max_x[et4000->acl.internal.source_wrap & 7];
+    const int      bpp    = BLIT_ROP3_USES_P(rop) ? 4 : 1;
+    const uint32_t mask   = et4000->vram_mask;
+
+    if (et4000->acl.x_count != et4000->acl.internal.count_x)
+        return 0;
+    if (BLIT_ROP3_USES_P(rop) && ((pat_x != 4) || (width & 3)))
+        return 0;
+    if (BLIT_ROP3_USES_S(rop) && src_x &&
+        ((dir > 0) ? ((et4000->acl.source_x_back + width) > (uint32_t) src_x) : (et4000->acl.source_x_back < (int) (width - 1))))
+        return 0;
+
+    while (1) {
+        const uint32_t d  = et4000->acl.dest_addr & mask;
+        const uint32_t s  = (et4000->acl.source_addr + et4000->acl.source_x) & mask;
+        const uint32_t lo = (dir > 0) ? d : (d - (width - 1));
+        uint32_t       pat = 0;
+
+        if ((dir > 0) ? ((d + width - 1) > mask) : (d < (width - 1)))
+            return 0;
+        if (BLIT_ROP3_USES_S(rop) && ((dir > 0) ? ((s + width - 1) > mask) : (s < (width - 1))))
+            return 0;
+        /* The kernel works in whole pixels, the chip byte by byte. */
+        if (BLIT_ROP3_USES_S(rop) && (bpp > 1) && (s != d) && (((s > d) ? (s - d) : (d - s)) < (uint32_t) bpp))
+            return 0;
+        if (BLIT_ROP3_USES_P(rop)) {
+            /* Byte j of each 4-byte pixel, in the order the chip would reach it. */
+            for (int j = 0; j < 4; j++) {
+                const uint32_t a = (et4000->acl.pattern_addr + ((et4000->acl.pattern_x + j + (dir < 0)) & 3)) & mask;
+
+                if ((a >= lo) && (a < (lo + width)))
+                    return 0;
+                pat |= (uint32_t) svga->vram[a] << (j << 3);
+            }
+        }
+
+        blit_rop3_span(&svga->vram[d - ((dir < 0) ? (bpp - 1) : 0)],
+                       BLIT_ROP3_USES_S(rop) ? &svga->vram[s - ((dir < 0) ? (bpp - 1) : 0)] : NULL,
+                       width / bpp, bpp, dir, rop, pat, 0xffffffff);
+        blit_mark_changed(svga->changedvram, lo, width, changeframecount);
+
+        /* The same steps as the byte loop at the end of a row. */
+        et4000->acl.mix_addr += dir * width;
+        if (et4000->acl.internal.xy_dir & 2) {
+            et4000w32_decy(et4000);
+            if (w32p)
+                et4000->acl.mix_back = et4000->acl.mix_addr = et4000->acl.mix_back - (et4000->acl.internal.mix_off + 1);
+            et4000->acl.dest_back = et4000->acl.dest_addr = et4000->acl.dest_back - (et4000->acl.internal.dest_off + 1);
+        } else {
+            et4000w32_incy(et4000);
+            if (w32p)
+                et4000->acl.mix_back = et4000->acl.mix_addr = et4000->acl.mix_back + et4000->acl.internal.mix_off + 1;
+            et4000->acl.dest_back = et4000->acl.dest_addr = et4000->acl.dest_back + et4000->acl.internal.dest_off + 1;
+        }
+
+        et4000->acl.pattern_x = et4000->acl.pattern_x_back;
+        et4000->acl.source_x  = et4000->acl.source_x_back;
+
+        et4000->acl.y_count--;
+        if (et4000->acl.y_count == 0xffff)
+            return 1;
+    }
+}
+
 static void
 et4000w32_blit(int count, int cpu_input, uint32_t src_dat, uint32_t mix_dat, et4000w32p_t *et4000)
 {
@@ -2275,6 +2356,14 @@ et4000w32_blit(int count, int cpu_input, uint32_t src_dat, uint32_t mix_dat, et4
             }
         }
     } else {
+        if ((count == -1) && !cpu_input && (mix_dat == 0xffffffff) && et4000w32_blit_rows_fast(et4000, 0)) {
+            et4000->acl.status &= ~ACL_XYST;
+            if (!(et4000->acl.internal.ctrl_routing & 7) || (et4000->acl.internal.ctrl_routing & 4))
+                et4000->acl.status &= ~ACL_SSO;
+            et4000->acl.cpu_input_num = 0;
+            return;
+        }
+
         while (count-- && (et4000->acl.y_count >= 0)) {
             pattern = svga->vram[(et4000->acl.pattern_addr + et4000->acl.pattern_x) & et4000->vram_mask];
 
@@ -2467,6 +2556,13 @@ et4000w32p_blit(int count, uint32_t mix, uint32_t sdat, int cpu_input, et4000w32
         }
     } else {
         et4000w32_log("BitBLT: count = %i\n", count);
+        if ((count == -1) && !cpu_input && (mix == 0xffffffff) && !(et4000->acl.internal.ctrl_routing & 0x40) &&
+            ((et4000->acl.internal.ctrl_routing & 0xa) != 8) && et4000w32_blit_rows_fast(et4000, 1)) {
+            et4000w32_log("BitBLT end\n");
+            et4000->acl.status &= ~(ACL_XYST | ACL_SSO);
+            return;
+        }
+
         while (count-- && (et4000->acl.y_count >= 0)) {
             pattern = svga->vram[(et4000->acl.pattern_addr + et4000->acl.pattern_x) & et4000->vram_mask];
 
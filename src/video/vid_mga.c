@@ -37,6 +37,7 @@
 #include <86box/vid_xga.h>
 #include <86box/vid_svga.h>
 #include <86box/vid_svga_render.h>
+#include <86box/vid_blit_kernels.h>
 
 #define ROM_MILLENNIUM    "roms/video/matrox/matrox2064wr2.BIN"
 #define ROM_MILLENNIUM_II "roms/video/matrox/matrox2164wpc.BIN"
@@ -3515,6 +3516,82 @@ blit_idump_read(mystique_t *mystique)
     return ret;
 }
 
+/*
+   Fast BitBLTs whose source rows end exactly where the destination rows
+   do, which is how drivers set them up, copied a row at a time through the
+   shared span kernels. Returns 0 to fall back to the pixel loop if a row
+   would wrap around the end of VRAM.
+ */
+static int
+blit_fbitblt_fast(mystique_t *mystique)
+{
+    svga_t         *svga    = &mystique->svga;
+    const int       x_dir   = mystique->dwgreg.sgn.scanleft ? -1 : 1;
+    const int       x_start = mystique->dwgreg.sgn.scanleft ? mystique->dwgreg.fxright : mystique->dwgreg.fxleft;
+    const int       x_end   = mystique->dwgreg.sgn.scanleft ? mystique->dwgreg.fxleft : mystique->dwgreg.fxright;
+    const int       left    = MAX(MIN(x_start, x_end), mystique->dwgreg.cxleft);
+    const int       right   = MIN(MAX(x_start, x_end), mystique->dwgreg.cxright);
+    const uint32_t  pitch   = mystique->dwgreg.pitch & PITCH_MASK;
+    uint32_t        ydst_lin;
+    uint32_t        src_row;
+    int             bpp;
+
+    switch (mystique->maccess_running & MACCESS_PWIDTH_MASK) {
+        case MACCESS_PWIDTH_8:
+            bpp = 1;
+            break;
+        case MACCESS_PWIDTH_16:
+            bpp = 2;
+            break;
+        case MACCESS_PWIDTH_24:
+            bpp = 3;
+            break;
+        case MACCESS_PWIDTH_32:
+            bpp = 4;
+            break;
+        default:
+            return 0;
+    }
+
+    if (((x_end - x_start) * x_dir < 0) || ((int32_t) (mystique->dwgreg.ar[0] - mystique->dwgreg.ar[3]) != (x_end - x_start)))
+        return 0;
+
+    for (int pass = 0; pass < 2; pass++) {
+        ydst_lin = mystique->dwgreg.ydst_lin;
+        src_row  = mystique->dwgreg.ar[3];
+
+        for (uint16_t y = 0; y < mystique->dwgreg.length; y++) {
+            if ((left <= right) && (ydst_lin >= mystique->dwgreg.ytop) && (ydst_lin <= mystique->dwgreg.ybot)) {
+                const int64_t dst   = (int64_t) (int32_t) ydst_lin + left;
+                const int64_t src   = (int64_t) (int32_t) src_row + (left - x_start);
+                const int     first = (x_dir > 0) ? 0 : (right - left);
+                const int     count = right - left + 1;
+
+                if (pass == 0) {
+                    if ((dst < 0) || (src < 0) || (((dst + count) * bpp - 1) > mystique->vram_mask) ||
+                        (((src + count) * bpp - 1) > mystique->vram_mask))
+                        return 0;
+                } else {
+                    blit_copy_span(&svga->vram[(dst + first) * bpp], &svga->vram[(src + first) * bpp], count, bpp, x_dir);
+                    blit_mark_changed(svga->changedvram, dst * bpp, count * bpp, changeframecount);
+                }
+            }
+
+            src_row += mystique->dwgreg.ar[5];
+            if (mystique->dwgreg.sgn.sdy)
+                ydst_lin -= pitch;
+            else
+                ydst_lin += pitch;
+        }
+    }
+
+    mystique->dwgreg.ar[0] += mystique->dwgreg.ar[5] * mystique->dwgreg.length;
+    mystique->dwgreg.ar[3]    = src_row;
+    mystique->dwgreg.ydst_lin = ydst_lin;
+
+    return 1;
+}
+
 static void
 blit_fbitblt(mystique_t *mystique)
 {
@@ -3524,6 +3601,11 @@ blit_fbitblt(mystique_t *mystique)
     int16_t  x_start = mystique->dwgreg.sgn.scanleft ? mystique->dwgreg.fxright : mystique->dwgreg.fxleft;
     int16_t  x_end   = mystique->dwgreg.sgn.scanleft ? mystique->dwgreg.fxleft : mystique->dwgreg.fxright;
 
+    if (blit_fbitblt_fast(mystique)) {
+        mystique->blitter_complete_refcount++;
+        return;
+    }
+
     src_addr = mystique->dwgreg.ar[3];
 
     for (uint16_t y = 0; y < mystique->dwgreg.length; y++) {
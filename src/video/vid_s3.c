@@ -42,6 +42,7 @@
 #include <86box/vid_xga.h>
 #include <86box/vid_svga.h>
 #include <86box/vid_svga_render.h>
+#include <86box/vid_blit_kernels.h>
 #include "cpu.h"
 
 #define ROM_ORCHID_86C911              "roms/video/s3/BIOS.BIN"
@@ -8275,6 +8276,249 @@ s3_visionx68_video_engine_op(uint32_t cpu_dat, s3_t *s3)
     }
 }
 
+static __inline uint32_t
+s3_accel_mix(int mix, uint32_t src_dat, uint32_t dest_dat)
+{
+    switch (mix) {
+        case 0x0:
+            return ~dest_dat;
+        case 0x1:
+            return 0;
+        case 0x2:
+            return ~0;
+        case 0x3:
+            return dest_dat;
+        case 0x4:
+            return ~src_dat;
+        case 0x5:
+            return src_dat ^ dest_dat;
+        case 0x6:
+            return ~(src_dat ^ dest_dat);
+        case 0x7:
+            return src_dat;
+        case 0x8:
+            return ~(src_dat & dest_dat);
+        case 0x9:
+            return ~src_dat | dest_dat;
+        case 0xa:
+            return src_dat | ~dest_dat;
+        case 0xb:
+            return src_dat | dest_dat;
+        case 0xc:
+            return src_dat & dest_dat;
+        case 0xd:
+            return src_dat & ~dest_dat;
+        case 0xe:
+            return ~src_dat & dest_dat;
+        case 0xf:
+        default:
+            return ~(src_dat | dest_dat);
+    }
+}
+
+/*Pattern span kernels for the fast path below, one per pixel size; fills and copies
+  go through the shared span kernels in vid_blit_kernels.c.*/
+#define S3_ACCEL_PATTERN_SPAN(bits)                                                                                       \
+    static void                                                                                                           \
+    s3_accel_pattern_span##bits(uint##bits##_t *dst, const uint##bits##_t *pat, int x, int n, uint32_t wrt_mask, int mix) \
+    {                                                                                                                     \
+        for (int i = 0; i < n; i++)                                                                                       \
+            dst[i] = (s3_accel_mix(mix, pat[(x + i) & 7], dst[i]) & wrt_mask) | (dst[i] & ~wrt_mask);                     \
+    }
+
+S3_ACCEL_PATTERN_SPAN(8)
+S3_ACCEL_PATTERN_SPAN(16)
+S3_ACCEL_PATTERN_SPAN(32)
+
+/*Row-at-a-time rectangle fill, BitBlt and pattern fill, used when the operation
+  is started from the command register with no CPU data, no colour compare, no
+  mix from display memory and plain 8/16/32bpp addressing. Pixels are visited in
+  the same order as the per-pixel engine, so the result is identical, including
+  for overlapping copies; the written area is marked in changedvram in bulk.
+  Anything else, and rectangles that wrap around the coordinate space or VRAM,
+  returns 0 and is left to the per-pixel engine.*/
+static int s3_accel_fast_enabled = 1; /*Cleared by benchmarks/s3_accel_check for its reference runs.*/
+
+static int
+s3_accel_fast(s3_t *s3, int cmd, uint32_t mix_dat, uint32_t cpu_dat, uint32_t srcbase, uint32_t dstbase, uint32_t wrt_mask,
+              int clip_t, int clip_l, int clip_b, int clip_r)
+{
+    svga_t  *svga      = &s3->svga;
+    int      w         = (s3->accel.maj_axis_pcnt & 0xfff) + 1;
+    int      h         = (s3->accel.multifunc[0] & 0xfff) + 1;
+    int      xdir      = (s3->accel.cmd & 0x20) ? 1 : -1;
+    int      ydir      = (s3->accel.cmd & 0x80) ? 1 : -1;
+    int      mix       = s3->accel.frgd_mix & 0xf;
+    int      vram_src  = 0;
+    uint32_t src_dat   = 0;
+    uint32_t pix_mask;
+    int      shift;
+    int      x0, y0;
+    int      sx0       = 0;
+    int      sy0       = 0;
+    int      x_lo, x_hi, y_lo, y_hi;
+    int64_t  lo, hi;
+    uint32_t pat[8][8];
+
+    if (!s3_accel_fast_enabled || ((cmd != 2) && (cmd != 6) && (cmd != 7)))
+        return 0;
+    if ((s3->accel.cmd & 0x110) != 0x010) /*CPU data, or draw disabled*/
+        return 0;
+    if ((mix_dat != 0xffffffff) || ((s3->accel.multifunc[0xa] & 0xc0) == 0xc0) || (s3->accel.multifunc[0xe] & 0x120))
+        return 0;
+    if (s3->color_16bit || (svga->bpp == 24) || !(svga->packed_chain4 || svga->force_old_addr))
+        return 0;
+
+    switch (s3->bpp) {
+        case 0:
+            shift = 0;
+            break;
+        case 1:
+            shift = 1;
+            break;
+        case 3:
+            shift = 2;
+            break;
+        default:
+            return 0;
+    }
+    pix_mask = s3->vram_mask >> shift;
+
+    switch ((s3->accel.frgd_mix >> 5) & 3) {
+        case 0:
+            src_dat = s3->accel.bkgd_color;
+            break;
+        case 1:
+            src_dat = s3->accel.frgd_color;
+            break;
+        case 2:
+            src_dat = cpu_dat;
+            break;
+        case 3:
+            vram_src = (cmd != 2);
+            break;
+
+        default:
+            break;
+    }
+
+    if (cmd == 2) {
+        x0 = s3->accel.cx;
+        y0 = s3->accel.cy;
+    } else {
+        x0  = s3->accel.dx;
+        y0  = s3->accel.dy;
+        sx0 = s3->accel.cx;
+        sy0 = s3->accel.cy;
+    }
+
+    /*Each row must end where the next one starts; the pixel engine skews the rows otherwise.*/
+    if (((x0 + (xdir * w)) < 0) || ((x0 + (xdir * w)) > 0xfff))
+        return 0;
+    if ((cmd == 2) && (((y0 + (ydir * (h - 1))) < 0) || ((y0 + (ydir * (h - 1))) > 0xfff)))
+        return 0;
+
+    x_lo = MAX(MIN(x0, x0 + (xdir * (w - 1))), clip_l);
+    x_hi = MIN(MAX(x0, x0 + (xdir * (w - 1))), clip_r);
+    y_lo = MAX(MIN(y0, y0 + (ydir * (h - 1))), clip_t);
+    y_hi = MIN(MAX(y0, y0 + (ydir * (h - 1))), clip_b);
+
+    if ((x_lo <= x_hi) && (y_lo <= y_hi)) {
+        lo = (int64_t) dstbase + ((int64_t) y_lo * s3->width) + x_lo;
+        hi = (int64_t) dstbase + ((int64_t) y_hi * s3->width) + x_hi;
+        if ((lo < 0) || (hi > pix_mask) || (lo > hi))
+            return 0;
+
+        if (vram_src && (cmd == 6)) {
+            lo = (int64_t) srcbase + ((int64_t) (y_lo + sy0 - y0) * s3->width) + (x_lo + sx0 - x0);
+            hi = (int64_t) srcbase + ((int64_t) (y_hi + sy0 - y0) * s3->width) + (x_hi + sx0 - x0);
+            if ((lo < 0) || (hi > pix_mask) || (lo > hi))
+                return 0;
+        } else if (vram_src) {
+            /*The 8x8 pattern is fetched up front, so it must not be drawn over.*/
+            int64_t pat_lo = (int64_t) srcbase + s3->accel.pattern;
+            int64_t pat_hi = pat_lo + (7 * (int64_t) s3->width) + 7;
+
+            if ((pat_lo < 0) || (pat_hi > pix_mask) || (s3->width < 8) || ((pat_hi >= lo) && (pat_lo <= hi)))
+                return 0;
+
+            for (int py = 0; py < 8; py++) {
+                for (int px = 0; px < 8; px++) {
+                    uint32_t addr = srcbase + s3->accel.pattern + (py * s3->width) + px;
+
+                    if (shift == 0)
+                        pat[py][px] = svga->vram[addr];
+                    else if (shift == 1)
+                        pat[py][px] = ((uint16_t *) svga->vram)[addr];
+                    else
+                        pat[py][px] = ((uint32_t *) svga->vram)[addr];
+                }
+            }
+        }
+
+        for (int r = 0; r < h; r++) {
+            int      y   = y0 + (ydir * r);
+            int      n   = x_hi - x_lo + 1;
+            uint32_t dst = dstbase + (y * s3->width);
+
+            if ((y < y_lo) || (y > y_hi))
+                continue;
+
+            if (vram_src && (cmd == 6)) {
+                /*Start from the first pixel the engine would visit in this row.*/
+                int      dx  = (xdir > 0) ? x_lo : x_hi;
+                uint32_t src = srcbase + ((y + sy0 - y0) * s3->width) + (dx + sx0 - x0);
+
+                blit_rop3_span(&svga->vram[(dst + dx) << shift], &svga->vram[src << shift], n, 1 << shift, xdir,
+                               blit_mix_rop3[mix], 0, wrt_mask);
+            } else if (vram_src) {
+                if (shift == 0) {
+                    uint8_t row[8];
+
+                    for (int i = 0; i < 8; i++)
+                        row[i] = pat[y & 7][i];
+                    s3_accel_pattern_span8(&svga->vram[dst + x_lo], row, x_lo, n, wrt_mask, mix);
+                } else if (shift == 1) {
+                    uint16_t row[8];
+
+                    for (int i = 0; i < 8; i++)
+                        row[i] = pat[y & 7][i];
+                    s3_accel_pattern_span16(&((uint16_t *) svga->vram)[dst + x_lo], row, x_lo, n, wrt_mask, mix);
+                } else
+                    s3_accel_pattern_span32(&((uint32_t *) svga->vram)[dst + x_lo], pat[y & 7], x_lo, n, wrt_mask, mix);
+            } else
+                blit_rop3_span(&svga->vram[(dst + x_lo) << shift], NULL, n, 1 << shift, 1,
+                               blit_rop3_src_as_pat(blit_mix_rop3[mix]), src_dat, wrt_mask);
+
+            blit_mark_changed(svga->changedvram, (dst + x_lo) << shift, n << shift, svga->monitor->mon_changeframecount);
+        }
+    }
+
+    /*Leave the registers as the pixel engine would at the end of the operation.*/
+    s3->accel.sx = s3->accel.maj_axis_pcnt & 0xfff;
+    s3->accel.sy = -1;
+    if (cmd == 2) {
+        s3->accel.cy    = (y0 + (ydir * h)) & 0xfff;
+        s3->accel.dest  = dstbase + (s3->accel.cy * s3->width);
+        s3->accel.cur_x = s3->accel.cx;
+        s3->accel.cur_y = s3->accel.cy;
+    } else {
+        s3->accel.dy = y0 + (ydir * h);
+        if (cmd == 6) {
+            s3->accel.cy  = sy0 + (ydir * h);
+            s3->accel.src = srcbase + (s3->accel.cy * s3->width);
+        } else {
+            s3->accel.cy  = (sy0 + (ydir * h)) & 7;
+            s3->accel.src = srcbase + s3->accel.pattern + (s3->accel.cy * s3->width);
+        }
+        s3->accel.dest        = dstbase + (s3->accel.dy * s3->width);
+        s3->accel.destx_distp = s3->accel.dx;
+        s3->accel.desty_axstp = s3->accel.dy;
+    }
+
+    return 1;
+}
+
 void
 s3_short_stroke_start(s3_t *s3, uint8_t ssv)
 {
@@ -9338,6 +9582,9 @@ s3_accel_start(int count, int cpu_input, uint32_t mix_dat, uint32_t cpu_dat, voi
                 return;
             }
 
+            if (!cpu_input && s3_accel_fast(s3, cmd, mix_dat, cpu_dat, srcbase, dstbase, wrt_mask, clip_t, clip_l, clip_b, clip_r))
+                break;
+
             while (count-- && (s3->accel.sy >= 0)) {
                 if (s3->accel.b2e8_pix && s3_cpu_src(s3) && !s3->accel.temp_cnt) {
                     mix_dat >>= 16;
@@ -9861,6 +10108,9 @@ s3_accel_start(int count, int cpu_input, uint32_t mix_dat, uint32_t cpu_dat, voi
                 break;
             }
 
+            if (!cpu_input && s3_accel_fast(s3, cmd, mix_dat, cpu_dat, srcbase, dstbase, wrt_mask, clip_t, clip_l, clip_b, clip_r))
+                break;
+
             if (!cpu_input && (frgd_mix == 3) && !vram_mask && !(s3->accel.multifunc[0xe] & 0x100) && ((s3->accel.cmd & 0xa0) == 0xa0) && ((s3->accel.frgd_mix & 0xf) == 7) && ((s3->accel.bkgd_mix & 0xf) == 7)) {
                 s3_log("Special BitBLT.\n");
                 while (1) {
@@ -10181,6 +10431,9 @@ s3_accel_start(int count, int cpu_input, uint32_t mix_dat, uint32_t cpu_dat, voi
                 break;
             }
 
+            if (!cpu_input && s3_accel_fast(s3, cmd, mix_dat, cpu_dat, srcbase, dstbase, wrt_mask, clip_t, clip_l, clip_b, clip_r))
+                break;
+
             while (count-- && (s3->accel.sy >= 0)) {
                 if ((s3->accel.dx >= clip_l) && (s3->accel.dx <= clip_r) && (s3->accel.dy >= clip_t) && (s3->accel.dy <= clip_b)) {
                     if (vram_mask) {
@@ -43,8 +43,9 @@
 #include <86box/vid_svga_render.h>
 #include <86box/vid_xga_device.h>
 
-void svga_doblit(int wx, int wy, svga_t *svga);
-void svga_poll(void *priv);
+void        svga_doblit(int wx, int wy, svga_t *svga);
+static void svga_blit_frame(int wx, int wy, svga_t *svga);
+void        svga_poll(void *priv);
 
 svga_t *svga_8514;
 
@@ -1281,9 +1282,48 @@ svga_recalctimings(svga_t *svga)
     }
 }
 
+/* Dirty lines closer than this are merged into one region. */
+#define SVGA_DIRTY_GAP 8
+
+static void
+svga_dirty_line(svga_t *svga, int line)
+{
+    video_rect_t *r;
+
+    if (svga->dirty_count > VIDEO_DIRTY_RECTS_MAX)
+        return;
+
+    if (svga->dirty_count > 0) {
+        r = &svga->dirty[svga->dirty_count - 1];
+        if ((line >= r->y) && (line <= (r->y + r->h + SVGA_DIRTY_GAP))) {
+            if (line >= (r->y + r->h))
+                r->h = line - r->y + 1;
+            return;
+        }
+    }
+
+    if (svga->dirty_count < VIDEO_DIRTY_RECTS_MAX) {
+        r    = &svga->dirty[svga->dirty_count];
+        r->x = 0;
+        r->y = line;
+        r->w = 2048;
+        r->h = 1;
+    }
+    svga->dirty_count++;
+}
+
 static void
 svga_do_render(svga_t *svga)
 {
+    /* The border changes on every line if any of these did, so redraw the lot. */
+    if ((svga->overscan_color != svga->dirty_overscan_color) || (svga->scrollcache != svga->dirty_scrollcache) ||
+        (svga->dpms != svga->dirty_dpms)) {
+        svga->dirty_overscan_color = svga->overscan_color;
+        svga->dirty_scrollcache    = svga->scrollcache;
+        svga->dirty_dpms           = svga->dpms;
+        svga->dirty_full           = 1;
+    }
+
     /* Always render a blank screen and nothing else while in DPMS mode. */
     if (svga->dpms) {
         svga_render_blank(svga);
@@ -1293,27 +1333,37 @@ svga_do_render(svga_t *svga)
     if (!svga->override) {
         svga->render_line_offset = svga->start_retrace_latch - svga->crtc[0x4];
         svga->render(svga);
+
+        /* Renderers only touch the line (and move lastline_draw) if VRAM under it changed. */
+        if ((svga->lastline_draw == svga->displine) && (svga->firstline_draw != 2000))
+            svga_dirty_line(svga, svga->displine + svga->y_add);
     }
 
     if (svga->overlay_on) {
-        if (!svga->override && svga->overlay_draw)
+        if (!svga->override && svga->overlay_draw) {
             svga->overlay_draw(svga, svga->displine + svga->y_add);
+            svga_dirty_line(svga, svga->displine + svga->y_add);
+        }
         svga->overlay_on--;
         if (svga->overlay_on && svga->interlace)
             svga->overlay_on--;
     }
 
     if (svga->dac_hwcursor_on) {
-        if (!svga->override && svga->dac_hwcursor_draw)
+        if (!svga->override && svga->dac_hwcursor_draw) {
             svga->dac_hwcursor_draw(svga, (svga->displine + svga->y_add + ((svga->dac_hwcursor_latch.y >= 0) ? 0 : svga->dac_hwcursor_latch.y)) & 2047);
+            svga_dirty_line(svga, (svga->displine + svga->y_add + ((svga->dac_hwcursor_latch.y >= 0) ? 0 : svga->dac_hwcursor_latch.y)) & 2047);
+        }
         svga->dac_hwcursor_on--;
         if (svga->dac_hwcursor_on && svga->interlace)
             svga->dac_hwcursor_on--;
     }
 
     if (svga->hwcursor_on) {
-        if (!svga->override && svga->hwcursor_draw)
+        if (!svga->override && svga->hwcursor_draw) {
             svga->hwcursor_draw(svga, (svga->displine + svga->y_add + ((svga->hwcursor_latch.y >= 0) ? 0 : svga->hwcursor_latch.y)) & 2047);
+            svga_dirty_line(svga, (svga->displine + svga->y_add + ((svga->hwcursor_latch.y >= 0) ? 0 : svga->hwcursor_latch.y)) & 2047);
+        }
 
         svga->hwcursor_on--;
         if (svga->hwcursor_on && svga->interlace)
@@ -1564,11 +1614,11 @@ svga_poll(void *priv)
                 if (svga->vertical_linedbl) {
                     wy = (svga->lastline - svga->firstline) << 1;
                     svga->vdisp = wy + 1;
-                    svga_doblit(wx, wy, svga);
+                    svga_blit_frame(wx, wy, svga);
                 } else {
                     wy = svga->lastline - svga->firstline;
                     svga->vdisp = wy + 1;
-                    svga_doblit(wx, wy, svga);
+                    svga_blit_frame(wx, wy, svga);
                 }
             }
 
@@ -1577,6 +1627,8 @@ svga_poll(void *priv)
 
             svga->firstline_draw = 2000;
             svga->lastline_draw  = 0;
+            svga->dirty_count    = 0;
+            svga->dirty_full     = 0;
 
             svga->oddeven ^= 1;
 
@@ -2124,8 +2176,9 @@ svga_read_linear(uint32_t addr, void *priv)
     return svga_read_common(addr, 1, priv);
 }
 
-void
-svga_doblit(int wx, int wy, svga_t *svga)
+/* Blits the frame with the lines svga_poll() marked as dirty. */
+static void
+svga_blit_frame(int wx, int wy, svga_t *svga)
 {
     int       y_add;
     int       x_add;
@@ -2211,12 +2264,24 @@ svga_doblit(int wx, int wy, svga_t *svga)
         }
     }
 
-    video_blit_memtoscreen_monitor(x_start, y_start, svga->monitor->mon_xsize + x_add, svga->monitor->mon_ysize + y_add, svga->monitor_index);
+    if (svga->dirty_full)
+        video_blit_memtoscreen_monitor(x_start, y_start, svga->monitor->mon_xsize + x_add, svga->monitor->mon_ysize + y_add, svga->monitor_index);
+    else
+        video_blit_memtoscreen_dirty_monitor(x_start, y_start, svga->monitor->mon_xsize + x_add, svga->monitor->mon_ysize + y_add,
+                                             svga->dirty, svga->dirty_count, svga->monitor_index);
 
     if (svga->vertical_linedbl)
         svga->vertical_linedbl >>= 1;
 }
 
+/* The 8514/A, XGA and Voodoo pollers draw without marking lines, so their frames are blitted whole. */
+void
+svga_doblit(int wx, int wy, svga_t *svga)
+{
+    svga->dirty_full = 1;
+    svga_blit_frame(wx, wy, svga);
+}
+
 void
 svga_writeb_linear(uint32_t addr, uint8_t val, void *priv)
 {
@@ -27,6 +27,7 @@
 #include <86box/vid_svga.h>
 #include <86box/vid_svga_render.h>
 #include <86box/vid_svga_render_remap.h>
+#include <86box/vid_svga_render_simd.h>
 
 uint32_t
 svga_lookup_lut_ram(svga_t* svga, uint32_t val)
@@ -42,6 +43,100 @@ svga_lookup_lut_ram(svga_t* svga, uint32_t val)
 
 #define lookup_lut(val) svga_lookup_lut_ram(svga, val)
 
+/*
+   Returns a pointer to bytes of display memory starting at addr, or NULL if
+   the span wraps around the display mask and has to go through the scalar
+   renderer.
+ */
+static inline const uint8_t *
+svga_render_span(svga_t *svga, uint32_t addr, uint32_t bytes)
+{
+    addr &= svga->vram_display_mask;
+    if ((addr + bytes) > (svga->vram_display_mask + 1))
+        return NULL;
+
+    return &svga->vram[addr];
+}
+
+/*
+   Direct 8bpp scanout (no shifter tricks, blinking or address remapping):
+   hand the whole line to the vector palette lookup.
+ */
+static bool
+svga_render_8bpp_direct(svga_t *svga, uint32_t *p, uint32_t *col)
+{
+    const int      count = ((svga->hdisp + svga->scrollcache) & ~3) + 4;
+    const uint32_t addr  = svga->force_old_addr ? (svga->memaddr & ~3) : svga->memaddr;
+    const uint8_t *src   = svga_render_span(svga, addr, count);
+
+    if (src == NULL)
+        return false;
+
+    svga_render_kernels->pal8(p, src, count, svga->map8, svga->dac_mask);
+    *col = p[count - 1];
+
+    svga->memaddr += count;
+    svga->memaddr &= svga->vram_display_mask;
+    return true;
+}
+
+/* Same for 15/16bpp with the stock RAMDAC conversion. */
+static bool
+svga_render_16bpp_direct(svga_t *svga, uint32_t *p, int bpp)
+{
+    const int      count = ((svga->hdisp + svga->scrollcache) & ~7) + 8;
+    const uint8_t *src;
+
+    if (svga->conv_16to32 != svga_conv_16to32)
+        return false;
+    if ((src = svga_render_span(svga, svga->memaddr, count << 1)) == NULL)
+        return false;
+
+    if (bpp == 15)
+        svga_render_kernels->rgb555(p, src, count);
+    else
+        svga_render_kernels->rgb565(p, src, count);
+
+    svga->memaddr += count << 1;
+    svga->memaddr &= svga->vram_display_mask;
+    return true;
+}
+
+/* Same for packed 24bpp when the RAMDAC LUT is bypassed. */
+static bool
+svga_render_24bpp_direct(svga_t *svga, uint32_t *p)
+{
+    const int      count = ((svga->hdisp + svga->scrollcache) & ~3) + 4;
+    const uint8_t *src;
+
+    if (svga->lut_map)
+        return false;
+    if ((src = svga_render_span(svga, svga->memaddr, count * 3)) == NULL)
+        return false;
+
+    svga_render_kernels->rgb888(p, src, count);
+
+    svga->memaddr += count * 3;
+    svga->memaddr &= svga->vram_display_mask;
+    return true;
+}
+
+/* 32bpp leaves advancing memaddr to the caller, as the two address modes differ there. */
+static bool
+svga_render_32bpp_direct(svga_t *svga, uint32_t *p)
+{
+    const int      count = svga->hdisp + svga->scrollcache + 1;
+    const uint8_t *src;
+
+    if (svga->lut_map)
+        return false;
+    if ((src = svga_render_span(svga, svga->memaddr, count << 2)) == NULL)
+        return false;
+
+    svga_render_kernels->xrgb8888(p, src, count);
+    return true;
+}
+
 void
 svga_render_null(svga_t *svga)
 {
@@ -768,6 +863,10 @@ svga_render_indexed_gfx(svga_t *svga, bool highres, bool combine8bits)
     const uint32_t blinkmask = (attrblink ? 0x88888888 : 0x0);
     const uint32_t blinkval  = (attrblink && blinked ? 0x88888888 : 0x0);
 
+    const bool direct8bpp = combine8bits && highres && !svga->packed_4bpp && !svga->half_pixel && !svga->ati_4color &&
+                            (incevery == 1) && (loadevery == 1) && (planemask == 0xffffffff) && !attrblink &&
+                            (svga->force_old_addr ? ((incbypow2 == 0) && ((svga->crtc[0x17] & 0x03) == 0x03)) : !svga->remap_required);
+
     /*
        This is actually a 8x 3-bit lookup table,
        preshifted by 2 bits to allow shifting by multiples of 4 bits.
@@ -812,7 +911,12 @@ svga_render_indexed_gfx(svga_t *svga, bool highres, bool combine8bits)
     uint32_t edat         = 0;
     static uint32_t col          = 0;
     static uint32_t col2         = 0;
-    for (x = 0; x <= (svga->hdisp + svga->scrollcache); x += charwidth) {
+
+    x = 0;
+    if (direct8bpp && svga_render_8bpp_direct(svga, p, &col))
+        x = svga->hdisp + svga->scrollcache + 1; /* Whole line done, skip the shifter loop. */
+
+    for (; x <= (svga->hdisp + svga->scrollcache); x += charwidth) {
         if (load_counter == 0) {
             /* Find our address */
             if (svga->force_old_addr) {
@@ -1585,6 +1689,9 @@ svga_render_15bpp_highres(svga_t *svga)
                 svga->firstline_draw = svga->displine;
             svga->lastline_draw = svga->displine;
 
+            if (svga_render_16bpp_direct(svga, p, 15))
+                return;
+
             for (x = 0; x <= (svga->hdisp + svga->scrollcache); x += 8) {
                 dat      = *(uint32_t *) (&svga->vram[(svga->memaddr + (x << 1)) & svga->vram_display_mask]);
                 p[x]     = svga->conv_16to32(svga, dat & 0xffff, 15);
@@ -1616,6 +1723,9 @@ svga_render_15bpp_highres(svga_t *svga)
             svga->lastline_draw = svga->displine;
 
             if (!svga->remap_required) {
+                if (svga_render_16bpp_direct(svga, p, 15))
+                    return;
+
                 for (x = 0; x <= (svga->hdisp + svga->scrollcache); x += 8) {
                     dat  = *(uint32_t *) (&svga->vram[(svga->memaddr + (x << 1)) & svga->vram_display_mask]);
                     *p++ = svga->conv_16to32(svga, dat & 0xffff, 15);
@@ -1817,6 +1927,9 @@ svga_render_16bpp_highres(svga_t *svga)
                 svga->firstline_draw = svga->displine;
             svga->lastline_draw = svga->displine;
 
+            if (svga_render_16bpp_direct(svga, p, 16))
+                return;
+
             for (x = 0; x <= (svga->hdisp + svga->scrollcache); x += 8) {
                 uint32_t dat = *(uint32_t *) (&svga->vram[(svga->memaddr + (x << 1)) & svga->vram_display_mask]);
                 p[x]         = svga->conv_16to32(svga, dat & 0xffff, 16);
@@ -1848,6 +1961,9 @@ svga_render_16bpp_highres(svga_t *svga)
             svga->lastline_draw = svga->displine;
 
             if (!svga->remap_required) {
+                if (svga_render_16bpp_direct(svga, p, 16))
+                    return;
+
                 for (x = 0; x <= (svga->hdisp + svga->scrollcache); x += 8) {
                     dat  = *(uint32_t *) (&svga->vram[(svga->memaddr + (x << 1)) & svga->vram_display_mask]);
                     *p++ = svga->conv_16to32(svga, dat & 0xffff, 16);
@@ -1981,6 +2097,9 @@ svga_render_24bpp_highres(svga_t *svga)
                 svga->firstline_draw = svga->displine;
             svga->lastline_draw = svga->displine;
 
+            if (svga_render_24bpp_direct(svga, p))
+                return;
+
             for (x = 0; x <= (svga->hdisp + svga->scrollcache); x += 4) {
                 dat  = *(uint32_t *) (&svga->vram[svga->memaddr & svga->vram_display_mask]);
                 p[x] = lookup_lut(dat & 0xffffff);
@@ -2009,6 +2128,9 @@ svga_render_24bpp_highres(svga_t *svga)
             svga->lastline_draw = svga->displine;
 
             if (!svga->remap_required) {
+                if (svga_render_24bpp_direct(svga, p))
+                    return;
+
                 for (x = 0; x <= (svga->hdisp + svga->scrollcache); x += 4) {
                     dat0 = *(uint32_t *) (&svga->vram[svga->memaddr & svga->vram_display_mask]);
                     dat1 = *(uint32_t *) (&svga->vram[(svga->memaddr + 4) & svga->vram_display_mask]);
@@ -2119,7 +2241,11 @@ svga_render_32bpp_highres(svga_t *svga)
                 svga->firstline_draw = svga->displine;
             svga->lastline_draw = svga->displine;
 
-            for (x = 0; x <= (svga->hdisp + svga->scrollcache); x++) {
+            x = 0;
+            if (svga_render_32bpp_direct(svga, p))
+                x = svga->hdisp + svga->scrollcache + 1;
+
+            for (; x <= (svga->hdisp + svga->scrollcache); x++) {
                 dat  = *(uint32_t *) (&svga->vram[(svga->memaddr + (x << 2)) & svga->vram_display_mask]);
                 p[x] = lookup_lut(dat & 0xffffff);
             }
@@ -2137,7 +2263,11 @@ svga_render_32bpp_highres(svga_t *svga)
             svga->lastline_draw = svga->displine;
 
             if (!svga->remap_required) {
-                for (x = 0; x <= (svga->hdisp + svga->scrollcache); x++) {
+                x = 0;
+                if (svga_render_32bpp_direct(svga, p))
+                    x = svga->hdisp + svga->scrollcache + 1;
+
+                for (; x <= (svga->hdisp + svga->scrollcache); x++) {
                     dat  = *(uint32_t *) (&svga->vram[(svga->memaddr + (x << 2)) & svga->vram_display_mask]);
                     *p++ = lookup_lut(dat & 0xffffff);
                 }
@@ -0,0 +1,495 @@
+/*
+ * 86Box    A hypervisor and IBM PC system emulator that specializes in
+ *          running old operating systems and software designed for IBM
+ *          PC systems and compatibles from 1981 through fairly recent
+ *          system designs based on the PCI bus.
+ *
+ *          This file is part of the 86Box distribution.
+ *
+ *          Vectorized SVGA scanline converters.
+ *
+ *          SSE2 is part of the x86-64 baseline and NEON of the ARM64
+ *          one, so those are selected at compile time. AVX2 kernels are
+ *          compiled with a per-function target attribute and selected
+ *          at runtime if the host CPU reports support for them.
+ *
+ *          The 15/16bpp expansion reproduces the truncating double math
+ *          of calc_15to32()/calc_16to32() in video.c with a 16-bit
+ *          multiply-high: for a 5-bit channel v, (int) (v / 31.0 * 255.0)
+ *          equals ((v << 9) * 1053) >> 16, and for a 6-bit channel,
+ *          (int) (v / 63.0 * 255.0) equals ((v << 6) * 4145) >> 16.
+ *          benchmarks/svga_render_micro.c checks every kernel against
+ *          the scalar reference.
+ *
+ * Authors: 86Box contributors.
+ *
+ *          Copyright 2026 86Box contributors.
+ */
+#include <stddef.h>
+#include <stdint.h>
+#include <86box/vid_svga_render_simd.h>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#    define SVGA_RENDER_SSE2
+#    if defined(__GNUC__) || defined(__clang__)
+#        define SVGA_RENDER_AVX2
+#        define AVX2_TARGET __attribute__((target("avx2")))
+#    elif defined(_MSC_VER)
+#        define SVGA_RENDER_AVX2
+#        define AVX2_TARGET
+#        include <intrin.h>
+#    endif
+#    include <immintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#    define SVGA_RENDER_NEON
+#    include <arm_neon.h>
+#endif
+
+#define EXPAND5(v) ((((uint32_t) (v) << 9) * 1053) >> 16)
+#define EXPAND6(v) ((((uint32_t) (v) << 6) * 4145) >> 16)
+
+static inline uint32_t
+conv_555(uint16_t px)
+{
+    return 0xff000000 | (EXPAND5((px >> 10) & 0x1f) << 16) | (EXPAND5((px >> 5) & 0x1f) << 8) | EXPAND5(px & 0x1f);
+}
+
+static inline uint32_t
+conv_565(uint16_t px)
+{
+    return 0xff000000 | (EXPAND5(px >> 11) << 16) | (EXPAND6((px >> 5) & 0x3f) << 8) | EXPAND5(px & 0x1f);
+}
+
+/* Scalar kernels, also used for the tails of the vector ones. */
+static void
+pal8_scalar(uint32_t *dst, const uint8_t *src, int count, const uint32_t *pal, uint8_t mask)
+{
+    for (int i = 0; i < count; i++)
+        dst[i] = pal[src[i] & mask];
+}
+
+static void
+rgb555_scalar(uint32_t *dst, const uint8_t *src, int count)
+{
+    for (int i = 0; i < count; i++)
+        dst[i] = conv_555(src[i << 1] | (src[(i << 1) + 1] << 8));
+}
+
+static void
+rgb565_scalar(uint32_t *dst, const uint8_t *src, int count)
+{
+    for (int i = 0; i < count; i++)
+        dst[i] = conv_565(src[i << 1] | (src[(i << 1) + 1] << 8));
+}
+
+static void
+rgb888_scalar(uint32_t *dst, const uint8_t *src, int count)
+{
+    for (int i = 0; i < count; i++)
+        dst[i] = src[i * 3] | (src[i * 3 + 1] << 8) | (src[i * 3 + 2] << 16);
+}
+
+static void
+xrgb8888_scalar(uint32_t *dst, const uint8_t *src, int count)
+{
+    for (int i = 0; i < count; i++)
+        dst[i] = src[i << 2] | (src[(i << 2) + 1] << 8) | (src[(i << 2) + 2] << 16);
+}
+
+static const svga_render_kernels_t kernels_scalar = {
+    .name     = "scalar",
+    .pal8     = pal8_scalar,
+    .rgb555   = rgb555_scalar,
+    .rgb565   = rgb565_scalar,
+    .rgb888   = rgb888_scalar,
+    .xrgb8888 = xrgb8888_scalar
+};
+
+#ifdef SVGA_RENDER_SSE2
+/* SSE2 has no gather; an unrolled scalar loop is as good as it gets for pal8. */
+static void
+pal8_sse2(uint32_t *dst, const uint8_t *src, int count, const uint32_t *pal, uint8_t mask)
+{
+    int i = 0;
+
+    for (; (i + 4) <= count; i += 4) {
+        dst[i]     = pal[src[i] & mask];
+        dst[i + 1] = pal[src[i + 1] & mask];
+        dst[i + 2] = pal[src[i + 2] & mask];
+        dst[i + 3] = pal[src[i + 3] & mask];
+    }
+    pal8_scalar(dst + i, src + i, count - i, pal, mask);
+}
+
+/* Channels arrive pre-positioned at bit 9 (5-bit) or bit 6 (6-bit). */
+static inline void
+store_16to32_sse2(uint32_t *dst, __m128i r, __m128i g, __m128i b)
+{
+    const __m128i k5 = _mm_set1_epi16(1053);
+    const __m128i lo = _mm_or_si128(_mm_slli_epi16(g, 8), _mm_mulhi_epu16(b, k5));
+    const __m128i hi = _mm_or_si128(_mm_mulhi_epu16(r, k5), _mm_set1_epi16((short) 0xff00));
+
+    _mm_storeu_si128((__m128i *) dst, _mm_unpacklo_epi16(lo, hi));
+    _mm_storeu_si128((__m128i *) (dst + 4), _mm_unpackhi_epi16(lo, hi));
+}
+
+static void
+rgb555_sse2(uint32_t *dst, const uint8_t *src, int count)
+{
+    const __m128i m5 = _mm_set1_epi16(0x3e00);
+    const __m128i k5 = _mm_set1_epi16(1053);
+    int           i  = 0;
+
+    for (; (i + 8) <= count; i += 8) {
+        const __m128i px = _mm_loadu_si128((const __m128i *) (src + (i << 1)));
+        const __m128i r  = _mm_and_si128(_mm_srli_epi16(px, 1), m5);
+        const __m128i g  = _mm_mulhi_epu16(_mm_and_si128(_mm_slli_epi16(px, 4), m5), k5);
+        const __m128i b  = _mm_and_si128(_mm_slli_epi16(px, 9), m5);
+
+        store_16to32_sse2(dst + i, r, g, b);
+    }
+    rgb555_scalar(dst + i, src + (i << 1), count - i);
+}
+
+static void
+rgb565_sse2(uint32_t *dst, const uint8_t *src, int count)
+{
+    const __m128i m5 = _mm_set1_epi16(0x3e00);
+    const __m128i m6 = _mm_set1_epi16(0x0fc0);
+    const __m128i k6 = _mm_set1_epi16(4145);
+    int           i  = 0;
+
+    for (; (i + 8) <= count; i += 8) {
+        const __m128i px = _mm_loadu_si128((const __m128i *) (src + (i << 1)));
+        const __m128i r  = _mm_and_si128(_mm_srli_epi16(px, 2), m5);
+        const __m128i g  = _mm_mulhi_epu16(_mm_and_si128(_mm_slli_epi16(px, 1), m6), k6);
+        const __m128i b  = _mm_and_si128(_mm_slli_epi16(px, 9), m5);
+
+        store_16to32_sse2(dst + i, r, g, b);
+    }
+    rgb565_scalar(dst + i, src + (i << 1), count - i);
+}
+
+/* No PSHUFB in SSE2, so build the four pixels out of byte-shifted copies. */
+static void
+rgb888_sse2(uint32_t *dst, const uint8_t *src, int count)
+{
+    const __m128i mask = _mm_set1_epi32(0x00ffffff);
+    int           i    = 0;
+
+    for (; (i + 6) <= count; i += 4) {
+        const __m128i v  = _mm_loadu_si128((const __m128i *) (src + i * 3));
+        const __m128i p0 = _mm_unpacklo_epi32(v, _mm_srli_si128(v, 3));
+        const __m128i p1 = _mm_unpacklo_epi32(_mm_srli_si128(v, 6), _mm_srli_si128(v, 9));
+
+        _mm_storeu_si128((__m128i *) (dst + i), _mm_and_si128(_mm_unpacklo_epi64(p0, p1), mask));
+    }
+    rgb888_scalar(dst + i, src + i * 3, count - i);
+}
+
+static void
+xrgb8888_sse2(uint32_t *dst, const uint8_t *src, int count)
+{
+    const __m128i mask = _mm_set1_epi32(0x00ffffff);
+    int           i    = 0;
+
+    for (; (i + 8) <= count; i += 8) {
+        const __m128i v0 = _mm_loadu_si128((const __m128i *) (src + (i << 2)));
+        const __m128i v1 = _mm_loadu_si128((const __m128i *) (src + (i << 2) + 16));
+
+        _mm_storeu_si128((__m128i *) (dst + i), _mm_and_si128(v0, mask));
+        _mm_storeu_si128((__m128i *) (dst + i + 4), _mm_and_si128(v1, mask));
+    }
+    xrgb8888_scalar(dst + i, src + (i << 2), count - i);
+}
+
+static const svga_render_kernels_t kernels_sse2 = {
+    .name     = "sse2",
+    .pal8     = pal8_sse2,
+    .rgb555   = rgb555_sse2,
+    .rgb565   = rgb565_sse2,
+    .rgb888   = rgb888_sse2,
+    .xrgb8888 = xrgb8888_sse2
+};
+#endif
+
+#ifdef SVGA_RENDER_AVX2
+AVX2_TARGET static void
+pal8_avx2(uint32_t *dst, const uint8_t *src, int count, const uint32_t *pal, uint8_t mask)
+{
+    const __m256i vmask = _mm256_set1_epi32(mask);
+    int           i     = 0;
+
+    for (; (i + 8) <= count; i += 8) {
+        const __m256i idx = _mm256_and_si256(_mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *) (src + i))), vmask);
+
+        _mm256_storeu_si256((__m256i *) (dst + i), _mm256_i32gather_epi32((const int *) pal, idx, 4));
+    }
+    pal8_scalar(dst + i, src + i, count - i, pal, mask);
+}
+
+AVX2_TARGET static inline void
+store_16to32_avx2(uint32_t *dst, __m256i r, __m256i g, __m256i b)
+{
+    const __m256i k5 = _mm256_set1_epi16(1053);
+    const __m256i lo = _mm256_or_si256(_mm256_slli_epi16(g, 8), _mm256_mulhi_epu16(b, k5));
+    const __m256i hi = _mm256_or_si256(_mm256_mulhi_epu16(r, k5), _mm256_set1_epi16((short) 0xff00));
+    const __m256i p0 = _mm256_unpacklo_epi16(lo, hi);
+    const __m256i p1 = _mm256_unpackhi_epi16(lo, hi);
+
+    /* The unpacks work per 128-bit lane; put the pixels back in order. */
+    _mm256_storeu_si256((__m256i *) dst, _mm256_permute2x128_si256(p0, p1, 0x20));
+    _mm256_storeu_si256((__m256i *) (dst + 8), _mm256_permute2x128_si256(p0, p1, 0x31));
+}
+
+AVX2_TARGET static void
+rgb555_avx2(uint32_t *dst, const uint8_t *src, int count)
+{
+    const __m256i m5 = _mm256_set1_epi16(0x3e00);
+    const __m256i k5 = _mm256_set1_epi16(1053);
+    int           i  = 0;
+
+    for (; (i + 16) <= count; i += 16) {
+        const __m256i px = _mm256_loadu_si256((const __m256i *) (src + (i << 1)));
+        const __m256i r  = _mm256_and_si256(_mm256_srli_epi16(px, 1), m5);
+        const __m256i g  = _mm256_mulhi_epu16(_mm256_and_si256(_mm256_slli_epi16(px, 4), m5), k5);
+        const __m256i b  = _mm256_and_si256(_mm256_slli_epi16(px, 9), m5);
+
+        store_16to32_avx2(dst + i, r, g, b);
+    }
+    rgb555_scalar(dst + i, src + (i << 1), count - i);
+}
+
+AVX2_TARGET static void
+rgb565_avx2(uint32_t *dst, const uint8_t *src, int count)
+{
+    const __m256i m5 = _mm256_set1_epi16(0x3e00);
+    const __m256i m6 = _mm256_set1_epi16(0x0fc0);
+    const __m256i k6 = _mm256_set1_epi16(4145);
+    int           i  = 0;
+
+    for (; (i + 16) <= count; i += 16) {
+        const __m256i px = _mm256_loadu_si256((const __m256i *) (src + (i << 1)));
+        const __m256i r  = _mm256_and_si256(_mm256_srli_epi16(px, 2), m5);
+        const __m256i g  = _mm256_mulhi_epu16(_mm256_and_si256(_mm256_slli_epi16(px, 1), m6), k6);
+        const __m256i b  = _mm256_and_si256(_mm256_slli_epi16(px, 9), m5);
+
+        store_16to32_avx2(dst + i, r, g, b);
+    }
+    rgb565_scalar(dst + i, src + (i << 1), count - i);
+}
+
+AVX2_TARGET static void
+rgb888_avx2(uint32_t *dst, const uint8_t *src, int count)
+{
+    const __m256i shuf = _mm256_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1,
+                                          0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+    int           i    = 0;
+
+    /* Each lane takes 12 source bytes; the high lane load reads 4 bytes past them. */
+    for (; (i + 10) <= count; i += 8) {
+        const __m128i lo = _mm_loadu_si128((const __m128i *) (src + i * 3));
+        const __m128i hi = _mm_loadu_si128((const __m128i *) (src + i * 3 + 12));
+        const __m256i v  = _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+
+        _mm256_storeu_si256((__m256i *) (dst + i), _mm256_shuffle_epi8(v, shuf));
+    }
+    rgb888_scalar(dst + i, src + i * 3, count - i);
+}
+
+AVX2_TARGET static void
+xrgb8888_avx2(uint32_t *dst, const uint8_t *src, int count)
+{
+    const __m256i mask = _mm256_set1_epi32(0x00ffffff);
+    int           i    = 0;
+
+    for (; (i + 8) <= count; i += 8) {
+        const __m256i v = _mm256_loadu_si256((const __m256i *) (src + (i << 2)));
+
+        _mm256_storeu_si256((__m256i *) (dst + i), _mm256_and_si256(v, mask));
+    }
+    xrgb8888_scalar(dst + i, src + (i << 2), count - i);
+}
+
+static const svga_render_kernels_t kernels_avx2 = {
+    .name     = "avx2",
+    .pal8     = pal8_avx2,
+    .rgb555   = rgb555_avx2,
+    .rgb565   = rgb565_avx2,
+    .rgb888   = rgb888_avx2,
+    .xrgb8888 = xrgb8888_avx2
+};
+
+static int
+cpu_has_avx2(void)
+{
+#    if defined(_MSC_VER) && !defined(__clang__)
+    int regs[4];
+
+    __cpuid(regs, 0);
+    if (regs[0] < 7)
+        return 0;
+    /* AVX2 needs OS support for saving the YMM state (OSXSAVE + XCR0). */
+    __cpuid(regs, 1);
+    if (!(regs[2] & (1 << 27)) || ((_xgetbv(0) & 6) != 6))
+        return 0;
+    __cpuidex(regs, 7, 0);
+    return !!(regs[1] & (1 << 5));
+#    else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#    endif
+}
+#endif
+
+#ifdef SVGA_RENDER_NEON
+static void
+pal8_neon(uint32_t *dst, const uint8_t *src, int count, const uint32_t *pal, uint8_t mask)
+{
+    int i = 0;
+
+    /* NEON has no 32-bit gather either. */
+    for (; (i + 4) <= count; i += 4) {
+        dst[i]     = pal[src[i] & mask];
+        dst[i + 1] = pal[src[i + 1] & mask];
+        dst[i + 2] = pal[src[i + 2] & mask];
+        dst[i + 3] = pal[src[i + 3] & mask];
+    }
+    pal8_scalar(dst + i, src + i, count - i, pal, mask);
+}
+
+/*
+   Channels arrive pre-positioned at bit 8 (5-bit) or bit 5 (6-bit); VQDMULH
+   doubles the product, which makes up for the missing shift.
+ */
+static inline void
+store_16to32_neon(uint32_t *dst, uint16x8_t r, uint16x8_t g, uint16x8_t b)
+{
+    const int16x8_t k5 = vdupq_n_s16(1053);
+    uint16x8x2_t    out;
+
+    r          = vreinterpretq_u16_s16(vqdmulhq_s16(vreinterpretq_s16_u16(r), k5));
+    b          = vreinterpretq_u16_s16(vqdmulhq_s16(vreinterpretq_s16_u16(b), k5));
+    out.val[0] = vorrq_u16(vshlq_n_u16(g, 8), b);
+    out.val[1] = vorrq_u16(r, vdupq_n_u16(0xff00));
+    vst2q_u16((uint16_t *) dst, out);
+}
+
+static void
+rgb555_neon(uint32_t *dst, const uint8_t *src, int count)
+{
+    const uint16x8_t m5 = vdupq_n_u16(0x1f00);
+    const int16x8_t  k5 = vdupq_n_s16(1053);
+    int              i  = 0;
+
+    for (; (i + 8) <= count; i += 8) {
+        const uint16x8_t px = vreinterpretq_u16_u8(vld1q_u8(src + (i << 1)));
+        const uint16x8_t r  = vandq_u16(vshrq_n_u16(px, 2), m5);
+        const uint16x8_t g  = vreinterpretq_u16_s16(vqdmulhq_s16(vreinterpretq_s16_u16(vandq_u16(vshlq_n_u16(px, 3), m5)), k5));
+        const uint16x8_t b  = vandq_u16(vshlq_n_u16(px, 8), m5);
+
+        store_16to32_neon(dst + i, r, g, b);
+    }
+    rgb555_scalar(dst + i, src + (i << 1), count - i);
+}
+
+static void
+rgb565_neon(uint32_t *dst, const uint8_t *src, int count)
+{
+    const uint16x8_t m5 = vdupq_n_u16(0x1f00);
+    const uint16x8_t m6 = vdupq_n_u16(0x07e0);
+    const int16x8_t  k6 = vdupq_n_s16(4145);
+    int              i  = 0;
+
+    for (; (i + 8) <= count; i += 8) {
+        const uint16x8_t px = vreinterpretq_u16_u8(vld1q_u8(src + (i << 1)));
+        const uint16x8_t r  = vandq_u16(vshrq_n_u16(px, 3), m5);
+        const uint16x8_t g  = vreinterpretq_u16_s16(vqdmulhq_s16(vreinterpretq_s16_u16(vandq_u16(px, m6)), k6));
+        const uint16x8_t b  = vandq_u16(vshlq_n_u16(px, 8), m5);
+
+        store_16to32_neon(dst + i, r, g, b);
+    }
+    rgb565_scalar(dst + i, src + (i << 1), count - i);
+}
+
+static void
+rgb888_neon(uint32_t *dst, const uint8_t *src, int count)
+{
+    int i = 0;
+
+    for (; (i + 16) <= count; i += 16) {
+        const uint8x16x3_t in = vld3q_u8(src + i * 3);
+        uint8x16x4_t       out;
+
+        out.val[0] = in.val[0];
+        out.val[1] = in.val[1];
+        out.val[2] = in.val[2];
+        out.val[3] = vdupq_n_u8(0);
+        vst4q_u8((uint8_t *) (dst + i), out);
+    }
+    rgb888_scalar(dst + i, src + i * 3, count - i);
+}
+
+static void
+xrgb8888_neon(uint32_t *dst, const uint8_t *src, int count)
+{
+    const uint32x4_t mask = vdupq_n_u32(0x00ffffff);
+    int              i    = 0;
+
+    for (; (i + 8) <= count; i += 8) {
+        const uint32x4_t v0 = vreinterpretq_u32_u8(vld1q_u8(src + (i << 2)));
+        const uint32x4_t v1 = vreinterpretq_u32_u8(vld1q_u8(src + (i << 2) + 16));
+
+        vst1q_u32(dst + i, vandq_u32(v0, mask));
+        vst1q_u32(dst + i + 4, vandq_u32(v1, mask));
+    }
+    xrgb8888_scalar(dst + i, src + (i << 2), count - i);
+}
+
+static const svga_render_kernels_t kernels_neon = {
+    .name     = "neon",
+    .pal8     = pal8_neon,
+    .rgb555   = rgb555_neon,
+    .rgb565   = rgb565_neon,
+    .rgb888   = rgb888_neon,
+    .xrgb8888 = xrgb8888_neon
+};
+#endif
+
+const svga_render_kernels_t *svga_render_kernels = &kernels_scalar;
+
+const svga_render_kernels_t *
+svga_render_kernels_get(int impl)
+{
+    switch (impl) {
+        case SVGA_RENDER_IMPL_SCALAR:
+            return &kernels_scalar;
+#ifdef SVGA_RENDER_SSE2
+        case SVGA_RENDER_IMPL_SSE2:
+            return &kernels_sse2;
+#endif
+#ifdef SVGA_RENDER_AVX2
+        case SVGA_RENDER_IMPL_AVX2:
+            return cpu_has_avx2() ? &kernels_avx2 : NULL;
+#endif
+#ifdef SVGA_RENDER_NEON
+        case SVGA_RENDER_IMPL_NEON:
+            return &kernels_neon;
+#endif
+        default:
+            return NULL;
+    }
+}
+
+void
+svga_render_simd_init(void)
+{
+    const svga_render_kernels_t *k;
+
+    for (int impl = SVGA_RENDER_IMPL_MAX - 1; impl >= 0; impl--) {
+        if ((k = svga_render_kernels_get(impl)) != NULL) {
+            svga_render_kernels = k;
+            return;
+        }
+    }
+}
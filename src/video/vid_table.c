@@ -297,6 +297,8 @@ video_update_framerates(void* priv)
     for (i = 0; i < GFXCARD_MAX; i++) {
         monitors[i].mon_actualrenderedframes = monitors[i].mon_renderedframes;
         monitors[i].mon_renderedframes = 0;
+        monitors[i].mon_actualdroppedframes = monitors[i].mon_droppedframes;
+        monitors[i].mon_droppedframes = 0;
     }
 
     timer_on_auto(&framerate_timer, 1000 * 1000);
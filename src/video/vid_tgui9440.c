@@ -73,6 +73,7 @@
 #include <86box/vid_xga.h>
 #include <86box/vid_svga.h>
 #include <86box/vid_svga_render.h>
+#include <86box/vid_blit_kernels.h>
 
 #define ROM_TGUI_9400CXI          "roms/video/tgui9440/9400CXI.VBI"
 #define ROM_TGUI_9440_VLB         "roms/video/tgui9440/trident_9440_vlb.bin"
@@ -2287,6 +2288,62 @@ enum {
         svga->changedvram[((addr) & (tgui->vram_mask >> 2)) >> 10] = svga->monitor->mon_changeframecount; \
     }
 
+/*
+   Screen to screen BitBLTs without transparency whose pattern is either a
+   solid fill or unused by the ROP, run a row at a time through the shared
+   span kernels. Returns 0 to fall back to the pixel loop when a row wraps
+   around the end of VRAM.
+ */
+static int
+tgui_accel_blit_fast(tgui_t *tgui, uint32_t pat_dat, int xdir, int ydir)
+{
+    svga_t        *svga   = &tgui->svga;
+    const int      shift  = (tgui->accel.bpp == 0) ? 0 : ((tgui->accel.bpp == 1) ? 1 : 2);
+    const uint32_t mask   = tgui->vram_mask >> shift;
+    const uint32_t width  = MAX(tgui->accel.size_x, 0) + 1;
+    const uint32_t height = MAX(tgui->accel.size_y, 0) + 1;
+    uint32_t       src;
+    uint32_t       dst;
+
+    if ((tgui->accel.flags & TGUI_TRANSENA) ||
+        (!(tgui->accel.flags & TGUI_SOLIDFILL) && BLIT_ROP3_USES_P(tgui->accel.rop)))
+        return 0;
+
+    for (int pass = 0; pass < 2; pass++) {
+        src = tgui->accel.src_old;
+        dst = tgui->accel.dst_old;
+
+        for (uint32_t y = 0; y < height; y++) {
+            const uint32_t s = src & mask;
+            const uint32_t d = dst & mask;
+
+            if (pass == 0) {
+                if ((xdir > 0) ? (((s + width - 1) > mask) || ((d + width - 1) > mask)) :
+                                 ((s < (width - 1)) || (d < (width - 1))))
+                    return 0;
+            } else {
+                blit_rop3_span(&svga->vram[d << shift], &svga->vram[s << shift], width, 1 << shift, xdir,
+                               tgui->accel.rop, pat_dat, 0xffffffff);
+                blit_mark_changed(svga->changedvram, ((xdir > 0) ? d : (d - (width - 1))) << shift,
+                                  width << shift, svga->monitor->mon_changeframecount);
+            }
+
+            src += ydir * tgui->accel.pitch;
+            dst += ydir * tgui->accel.pitch;
+        }
+    }
+
+    /* Leave the engine as the pixel loop would at the end of the blit. */
+    tgui->accel.x     = 0;
+    tgui->accel.y     = height;
+    tgui->accel.pat_x = tgui->accel.dst_x;
+    tgui->accel.pat_y += (int) height * ydir;
+    tgui->accel.src = tgui->accel.src_old = src;
+    tgui->accel.dst = tgui->accel.dst_old = dst;
+
+    return 1;
+}
+
 static void
 tgui_accel_command(int count, uint32_t cpu_dat, tgui_t *tgui)
 {
@@ -2558,6 +2615,10 @@ tgui_accel_command(int count, uint32_t cpu_dat, tgui_t *tgui)
                     break;
 
                 default:
+                    if ((count == -1) &&
+                        tgui_accel_blit_fast(tgui, pattern_data[((tgui->accel.pat_y & 7) * 8) + (tgui->accel.pat_x & 7)], xdir, ydir))
+                        break;
+
                     while (count--) {
                         READ(tgui->accel.src, src_dat);
                         READ(tgui->accel.dst, dst_dat);
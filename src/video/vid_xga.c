@@ -32,6 +32,7 @@
 #include <86box/vid_svga.h>
 #include <86box/vid_svga_render.h>
 #include <86box/vid_xga_device.h>
+#include <86box/vid_blit_kernels.h>
 #include "cpu.h"
 #include <86box/plat.h>
 #include <86box/plat_unused.h>
@@ -1639,6 +1640,98 @@ xga_line_draw_write(svga_t *svga)
     }
 }
 
+/*
+   Fills with the foreground colour and plain copies between 8 or 16 bpp
+   maps in VRAM, run a row at a time through the shared span kernels. Only
+   taken with no mask map, colour compare, arithmetic mix or wrapping
+   source, and with every visible row inside the VRAM aperture. Returns 0
+   to leave the blit to the pixel loop.
+ */
+static int
+xga_bitblt_fast(svga_t *svga, int16_t dx0, int16_t dy0, int xdir, int ydir)
+{
+    xga_t         *xga       = (xga_t *) svga->xga;
+    const int      dst_map   = xga->accel.dst_map;
+    const int      src_map   = xga->accel.src_map;
+    const int      fmt       = xga->accel.px_map_format[dst_map] & 0x07;
+    const int      bpp       = (fmt == 4) ? 2 : 1;
+    const int      copy      = (((xga->accel.command >> 28) & 3) == 2);
+    const int      width     = (xga->accel.blt_width & 0xfff) + 1;
+    const int      height    = (xga->accel.blt_height & 0xfff) + 1;
+    const int      dstwidth  = xga->accel.px_map_width[dst_map];
+    const int      dstheight = xga->accel.px_map_height[dst_map];
+    const int      srcwidth  = xga->accel.px_map_width[src_map];
+    const uint32_t srcheight = xga->accel.px_map_height[src_map];
+    const uint32_t top       = xga->linear_base + 0xfffff;
+    uint32_t       rop       = BLIT_ROP3_NOP;
+    uint32_t       src_col   = BLIT_ROP3_SRCCOPY;
+    int16_t        dy        = dy0;
+    int            sy        = xga->accel.sy;
+
+    if ((xga->accel.command & 0xc0) || (xga->accel.cc_cond != 4) || ((xga->accel.frgd_mix & 0x1f) >= 0x10) ||
+        ((fmt != 3) && (fmt != 4)))
+        return 0;
+    if (copy && (xga->accel.pattern || ((xga->accel.px_map_format[src_map] & 0x07) != fmt)))
+        return 0;
+
+    /* The mix applied to the D and S columns of a ROP3 truth table is that ROP3. */
+    ROP(1, rop, src_col);
+    rop &= 0xff;
+
+    for (int pass = 0; pass < 2; pass++) {
+        dy = dy0;
+        sy = xga->accel.sy;
+
+        for (int y = 0; y < height; y++) {
+            const int x1    = dx0 + ((width - 1) * xdir);
+            const int left  = MAX(MIN(dx0, x1), 0);
+            const int right = MIN(MAX(dx0, x1), dstwidth);
+
+            if ((dy >= 0) && (dy <= dstheight) && (left <= right)) {
+                const int      count = right - left + 1;
+                const int      skip  = (xdir > 0) ? 0 : ((count - 1) * bpp);
+                const int      sx    = xga->accel.sx + (left - dx0);
+                const uint32_t bytes = count * bpp;
+                const uint32_t dst   = xga_add_to_addr(xga, xga->accel.px_map_base[dst_map], xga_calc_pos(left, dy, dstwidth), dst_map);
+                const uint32_t src   = xga_add_to_addr(xga, xga->accel.px_map_base[src_map], xga_calc_pos(sx, sy, srcwidth), src_map);
+
+                if (pass == 0) {
+                    if ((dst < xga->linear_base) || ((dst + bytes - 1) > top) ||
+                        (((dst & xga->vram_mask) + bytes - 1) > xga->vram_mask))
+                        return 0;
+                    if (copy && ((sx < 0) || ((sx + count - 1) > srcwidth) || (src < xga->linear_base) ||
+                                 ((src + bytes - 1) > top) || (((src & xga->vram_mask) + bytes - 1) > xga->vram_mask)))
+                        return 0;
+                } else {
+                    if (copy)
+                        blit_rop3_span(&xga->vram[(dst & xga->vram_mask) + skip], &xga->vram[(src & xga->vram_mask) + skip],
+                                       count, bpp, xdir, rop, 0, xga->accel.plane_mask);
+                    else
+                        blit_rop3_span(&xga->vram[(dst & xga->vram_mask) + skip], NULL, count, bpp, xdir,
+                                       blit_rop3_src_as_pat(rop), xga->accel.frgd_color, xga->accel.plane_mask);
+                    blit_mark_changed(xga->changedvram, dst & xga->vram_mask, bytes, svga->monitor->mon_changeframecount);
+                }
+            }
+
+            dy += ydir;
+            if (xga->accel.pattern)
+                sy = ((sy + ydir) & srcheight) | (sy & ~srcheight);
+            else
+                sy += ydir;
+        }
+    }
+
+    /* Leave the engine as the pixel loop would at the end of the blit. */
+    xga->accel.x         = xga->accel.blt_width & 0xfff;
+    xga->accel.y         = -1;
+    xga->accel.sy        = sy;
+    xga->accel.y_len     = height;
+    xga->accel.dst_map_x = dx0;
+    xga->accel.dst_map_y = dy;
+
+    return 1;
+}
+
 static void
 xga_bitblt(svga_t *svga)
 {
@@ -1713,6 +1806,9 @@ xga_bitblt(svga_t *svga)
               xga->accel.pattern, xga->accel.src_map, xga->accel.dst_map, (xga->accel.px_map_format[xga->accel.src_map] & 0x0f), (xga->accel.px_map_format[xga->accel.dst_map] & 0x0f),
               srcwidth, srcheight, dstwidth, dstheight, xga->accel.sx, xga->accel.sy);
 
+        if (xga_bitblt_fast(svga, dx, dy, xdir, ydir))
+            return;
+
         while (xga->accel.y >= 0) {
             if (xga->accel.command & 0xc0) {
                 if ((dx >= xga->accel.mask_map_origin_x_off) && (dx <= ((xga->accel.px_map_width[0] & 0xfff) + xga->accel.mask_map_origin_x_off)) && (dy >= xga->accel.mask_map_origin_y_off) && (dy <= ((xga->accel.px_map_height[0] & 0xfff) + xga->accel.mask_map_origin_y_off))) {
@@ -42,6 +42,7 @@
 #include <86box/thread.h>
 #include <86box/video.h>
 #include <86box/vid_svga.h>
+#include <86box/vid_svga_render_simd.h>
 
 #include <minitrace/minitrace.h>
 
@@ -201,17 +202,47 @@ const uint32_t shade[5][256] = {
     }
 };
 
+/*
+   The emulator renders into target_buffer and hands each finished frame
+   over by copying it into a free slot; the blit thread presents the most
+   recent slot. With three slots there is always one free to write, so a
+   slow frontend drops frames instead of stalling emulation.
+ */
+#define BLIT_SLOTS 3
+
+typedef struct blit_slot_t {
+    bitmap_t *buffer;
+    int       x, y, w, h;
+
+    /* Regions the frontend has to redraw when presenting this frame. */
+    video_rect_t dirty[VIDEO_DIRTY_RECTS_MAX];
+    int          dirty_count;
+    /* Regions of target_buffer changed since this slot was last filled,
+       more than VIDEO_DIRTY_RECTS_MAX entries means all of it. */
+    video_rect_t stale[VIDEO_DIRTY_RECTS_MAX];
+    int          stale_count;
+} blit_slot_t;
+
 typedef struct blit_data_struct {
-    int x, y, w, h;
+    int x, y, w, h; /* Frame being presented. */
     int busy;
-    int buffer_in_use;
     int thread_run;
     int monitor_index;
 
+    /* Geometry of the last frame handed over. */
+    video_rect_t last;
+    /* Set when the frontend may not hold the previous frame, e.g. after
+       a full-frame blit from another source or a new blit function. */
+    int          dirty_resync;
+
+    blit_slot_t slots[BLIT_SLOTS];
+    int         ready;   /* Newest unpresented frame, or -1. */
+    int         reading; /* Frame being presented, or -1. */
+    mutex_t    *slot_mutex;
+
     thread_t *blit_thread;
     event_t  *wake_blit_thread;
     event_t  *blit_complete;
-    event_t  *buffer_not_in_use;
 } blit_data_t;
 
 static uint32_t cga_2_table[16];
@@ -240,15 +271,21 @@ void
 video_setblit(void (*blit)(int, int, int, int, int))
 {
     blit_func = blit;
+
+    for (int i = 0; i < MONITORS_NUM; i++) {
+        if (monitors[i].mon_blit_data_ptr != NULL)
+            monitors[i].mon_blit_data_ptr->dirty_resync = 1;
+    }
 }
 
+/*
+   Frames are released when the blit function returns. This is kept for
+   the frontends, which still report when they are done with the source.
+ */
 void
-video_blit_complete_monitor(int monitor_index)
+video_blit_complete_monitor(UNUSED(int monitor_index))
 {
-    blit_data_t *blit_data_ptr   = monitors[monitor_index].mon_blit_data_ptr;
-    blit_data_ptr->buffer_in_use = 0;
-
-    thread_set_event(blit_data_ptr->buffer_not_in_use);
+    /* Intentionally a no-op with triple buffered blit slots. */
 }
 
 void
@@ -261,14 +298,11 @@ video_wait_for_blit_monitor(int monitor_index)
     thread_reset_event(blit_data_ptr->blit_complete);
 }
 
+/* The frontend never reads target_buffer, so it is always free. */
 void
-video_wait_for_buffer_monitor(int monitor_index)
+video_wait_for_buffer_monitor(UNUSED(int monitor_index))
 {
-    blit_data_t *blit_data_ptr = monitors[monitor_index].mon_blit_data_ptr;
-
-    while (blit_data_ptr->buffer_in_use)
-        thread_wait_event(blit_data_ptr->buffer_not_in_use, -1);
-    thread_reset_event(blit_data_ptr->buffer_not_in_use);
+    /* Intentionally a no-op with triple buffered blit slots. */
 }
 
 static png_structp png_ptr[MONITORS_NUM];
@@ -411,44 +445,223 @@ video_transform_copy(void *__restrict _Dst, const void *__restrict _Src, size_t
 static void
 blit_thread(void *param)
 {
-    blit_data_t *data = param;
+    blit_data_t       *data = param;
+    const blit_slot_t *slot;
+
     while (data->thread_run) {
         thread_wait_event(data->wake_blit_thread, -1);
         thread_reset_event(data->wake_blit_thread);
         MTR_BEGIN("video", "blit_thread");
 
-        if (blit_func)
-            blit_func(data->x, data->y, data->w, data->h, data->monitor_index);
+        thread_wait_mutex(data->slot_mutex);
+        data->reading = data->ready;
+        data->ready   = -1;
+        thread_release_mutex(data->slot_mutex);
 
-        data->busy = 0;
+        if (data->reading >= 0) {
+            slot    = &data->slots[data->reading];
+            data->x = slot->x;
+            data->y = slot->y;
+            data->w = slot->w;
+            data->h = slot->h;
+
+            if (blit_func)
+                blit_func(slot->x, slot->y, slot->w, slot->h, data->monitor_index);
+        }
+
+        thread_wait_mutex(data->slot_mutex);
+        data->reading = -1;
+        data->busy    = (data->ready >= 0);
+        thread_release_mutex(data->slot_mutex);
 
         MTR_END("video", "blit_thread");
         thread_set_event(data->blit_complete);
     }
 }
 
+/* Appends a rectangle; a list that overflows stands for the whole frame. */
+static void
+video_rect_add(video_rect_t *rects, int *count, const video_rect_t *rect)
+{
+    if (*count < VIDEO_DIRTY_RECTS_MAX)
+        rects[*count] = *rect;
+    if (*count <= VIDEO_DIRTY_RECTS_MAX)
+        (*count)++;
+}
+
+static void
+blit_slot_copy(bitmap_t *dst, const bitmap_t *src, const video_rect_t *rect, const video_rect_t *frame)
+{
+    int x1 = MAX(rect->x, frame->x);
+    int y1 = MAX(rect->y, frame->y);
+    int x2 = MIN(rect->x + rect->w, frame->x + frame->w);
+    int y2 = MIN(rect->y + rect->h, frame->y + frame->h);
+
+    for (int row = y1; row < y2; row++)
+        memcpy(&dst->line[row][x1], &src->line[row][x1], (x2 - x1) * sizeof(uint32_t));
+}
+
+/*
+   Blit only the parts of the frame that changed. The dirty regions are
+   clipped to the blit rectangle. A NULL list or a negative count means
+   the caller does not track changes, and the whole frame is copied.
+ */
 void
-video_blit_memtoscreen_monitor(int x, int y, int w, int h, int monitor_index)
+video_blit_memtoscreen_dirty_monitor(int x, int y, int w, int h, const video_rect_t *dirty, int dirty_count, int monitor_index)
 {
+    blit_data_t *blit_data_ptr = monitors[monitor_index].mon_blit_data_ptr;
+    video_rect_t frame         = { x, y, w, h };
+    video_rect_t rects[VIDEO_DIRTY_RECTS_MAX];
+    int          count         = 0;
+    int          full;
+    int          s;
+    blit_slot_t *slot;
+
     MTR_BEGIN("video", "video_blit_memtoscreen");
 
     if ((w <= 0) || (h <= 0))
         return;
 
-    video_wait_for_blit_monitor(monitor_index);
+    /* A different blit rectangle invalidates whatever the frontend kept. */
+    if ((x != blit_data_ptr->last.x) || (y != blit_data_ptr->last.y) || (w != blit_data_ptr->last.w) || (h != blit_data_ptr->last.h))
+        blit_data_ptr->dirty_resync = 1;
+    blit_data_ptr->last = frame;
+
+    full = (dirty == NULL) || (dirty_count < 0) || blit_data_ptr->dirty_resync || (dirty_count > VIDEO_DIRTY_RECTS_MAX);
+    blit_data_ptr->dirty_resync = (dirty == NULL) || (dirty_count < 0);
+    if (!full) {
+        for (int i = 0; i < dirty_count; i++) {
+            int x1 = MAX(dirty[i].x, x);
+            int y1 = MAX(dirty[i].y, y);
+            int x2 = MIN(dirty[i].x + dirty[i].w, x + w);
+            int y2 = MIN(dirty[i].y + dirty[i].h, y + h);
+
+            if ((x2 > x1) && (y2 > y1)) {
+                rects[count].x = x1;
+                rects[count].y = y1;
+                rects[count].w = x2 - x1;
+                rects[count].h = y2 - y1;
+                count++;
+            }
+        }
+    }
+
+    /* Any slot that is neither waiting to be presented nor being presented is ours. */
+    thread_wait_mutex(blit_data_ptr->slot_mutex);
+    for (s = 0; s < BLIT_SLOTS; s++) {
+        if ((s != blit_data_ptr->ready) && (s != blit_data_ptr->reading))
+            break;
+    }
+    thread_release_mutex(blit_data_ptr->slot_mutex);
+
+    slot = &blit_data_ptr->slots[s];
+    if (slot->buffer == NULL) {
+        slot->buffer      = create_bitmap(2048, 2048);
+        slot->stale_count = VIDEO_DIRTY_RECTS_MAX + 1;
+    }
+
+    /* Bring the slot up to date with everything it missed, then this frame. */
+    if (full || (slot->stale_count > VIDEO_DIRTY_RECTS_MAX))
+        blit_slot_copy(slot->buffer, monitors[monitor_index].target_buffer, &frame, &frame);
+    else {
+        for (int i = 0; i < slot->stale_count; i++)
+            blit_slot_copy(slot->buffer, monitors[monitor_index].target_buffer, &slot->stale[i], &frame);
+        for (int i = 0; i < count; i++)
+            blit_slot_copy(slot->buffer, monitors[monitor_index].target_buffer, &rects[i], &frame);
+    }
+    slot->stale_count = 0;
+
+    for (int i = 0; i < BLIT_SLOTS; i++) {
+        if (i == s)
+            continue;
+        if (full)
+            blit_data_ptr->slots[i].stale_count = VIDEO_DIRTY_RECTS_MAX + 1;
+        else {
+            for (int j = 0; j < count; j++)
+                video_rect_add(blit_data_ptr->slots[i].stale, &blit_data_ptr->slots[i].stale_count, &rects[j]);
+        }
+    }
+
+    slot->x = x;
+    slot->y = y;
+    slot->w = w;
+    slot->h = h;
+    if (full) {
+        slot->dirty[0]    = frame;
+        slot->dirty_count = 1;
+    } else {
+        memcpy(slot->dirty, rects, count * sizeof(video_rect_t));
+        slot->dirty_count = count;
+    }
+
+    thread_wait_mutex(blit_data_ptr->slot_mutex);
+    if (blit_data_ptr->ready >= 0) {
+        /* The frontend never saw the previous frame, so it also has to redraw what that one changed. */
+        const blit_slot_t *dropped = &blit_data_ptr->slots[blit_data_ptr->ready];
+
+        if (!full) {
+            for (int i = 0; i < dropped->dirty_count; i++)
+                video_rect_add(slot->dirty, &slot->dirty_count, &dropped->dirty[i]);
+            if (slot->dirty_count > VIDEO_DIRTY_RECTS_MAX) {
+                slot->dirty[0]    = frame;
+                slot->dirty_count = 1;
+            }
+        }
+        monitors[monitor_index].mon_droppedframes++;
+        monitors[monitor_index].mon_droppedframes_total++;
+    }
+    blit_data_ptr->ready = s;
+    blit_data_ptr->busy  = 1;
+    thread_release_mutex(blit_data_ptr->slot_mutex);
 
-    monitors[monitor_index].mon_blit_data_ptr->busy          = 1;
-    monitors[monitor_index].mon_blit_data_ptr->buffer_in_use = 1;
-    monitors[monitor_index].mon_blit_data_ptr->x             = x;
-    monitors[monitor_index].mon_blit_data_ptr->y             = y;
-    monitors[monitor_index].mon_blit_data_ptr->w             = w;
-    monitors[monitor_index].mon_blit_data_ptr->h             = h;
     monitors[monitor_index].mon_renderedframes++;
 
-    thread_set_event(monitors[monitor_index].mon_blit_data_ptr->wake_blit_thread);
+    thread_set_event(blit_data_ptr->wake_blit_thread);
     MTR_END("video", "video_blit_memtoscreen");
 }
 
+void
+video_blit_memtoscreen_monitor(int x, int y, int w, int h, int monitor_index)
+{
+    video_blit_memtoscreen_dirty_monitor(x, y, w, h, NULL, 0, monitor_index);
+}
+
+/*
+   For use by blit functions: copies the regions changed since the
+   previous blit into rects (VIDEO_DIRTY_RECTS_MAX entries) and returns
+   their count, which may be 0 if nothing changed.
+ */
+int
+video_blit_get_dirty_monitor(video_rect_t *rects, int monitor_index)
+{
+    const blit_data_t *blit_data_ptr = monitors[monitor_index].mon_blit_data_ptr;
+    const blit_slot_t *slot;
+
+    if (blit_data_ptr->reading < 0)
+        return 0;
+
+    slot = &blit_data_ptr->slots[blit_data_ptr->reading];
+    memcpy(rects, slot->dirty, slot->dirty_count * sizeof(video_rect_t));
+
+    return slot->dirty_count;
+}
+
+/*
+   For use by blit functions: the frame being presented. Frontends must
+   read from this rather than target_buffer, which the emulator is
+   already drawing the next frame into.
+ */
+bitmap_t *
+video_blit_source_monitor(int monitor_index)
+{
+    const blit_data_t *blit_data_ptr = monitors[monitor_index].mon_blit_data_ptr;
+
+    if ((blit_data_ptr == NULL) || (blit_data_ptr->reading < 0))
+        return monitors[monitor_index].target_buffer;
+
+    return blit_data_ptr->slots[blit_data_ptr->reading].buffer;
+}
+
 uint8_t
 pixels8(uint32_t *pixels)
 {
@@ -805,7 +1018,9 @@ video_monitor_init(int index)
     monitors[index].mon_blit_data_ptr                    = calloc(1, sizeof(blit_data_t));
     monitors[index].mon_blit_data_ptr->wake_blit_thread  = thread_create_event();
     monitors[index].mon_blit_data_ptr->blit_complete     = thread_create_event();
-    monitors[index].mon_blit_data_ptr->buffer_not_in_use = thread_create_event();
+    monitors[index].mon_blit_data_ptr->slot_mutex        = thread_create_mutex();
+    monitors[index].mon_blit_data_ptr->ready             = -1;
+    monitors[index].mon_blit_data_ptr->reading           = -1;
     monitors[index].mon_blit_data_ptr->thread_run        = 1;
     monitors[index].mon_blit_data_ptr->monitor_index     = index;
     monitors[index].mon_pal_lookup                       = calloc(sizeof(uint32_t), 256);
@@ -813,6 +1028,8 @@ video_monitor_init(int index)
     monitors[index].mon_force_resize                     = 1;
     monitors[index].mon_vid_type                         = VIDEO_FLAG_TYPE_NONE;
     atomic_init(&doresize_monitors[index], 0);
+    atomic_init(&monitors[index].mon_actualdroppedframes, 0);
+    atomic_init(&monitors[index].mon_droppedframes_total, 0);
     atomic_init(&monitors[index].mon_screenshots, 0);
     atomic_init(&monitors[index].mon_screenshots_clipboard, 0);
     atomic_init(&monitors[index].mon_screenshots_raw, 0);
@@ -833,9 +1050,13 @@ video_monitor_close(int monitor_index)
     thread_wait(monitors[monitor_index].mon_blit_data_ptr->blit_thread);
     if (monitor_index >= 1)
         ui_deinit_monitor(monitor_index);
-    thread_destroy_event(monitors[monitor_index].mon_blit_data_ptr->buffer_not_in_use);
     thread_destroy_event(monitors[monitor_index].mon_blit_data_ptr->blit_complete);
     thread_destroy_event(monitors[monitor_index].mon_blit_data_ptr->wake_blit_thread);
+    thread_close_mutex(monitors[monitor_index].mon_blit_data_ptr->slot_mutex);
+    for (int i = 0; i < BLIT_SLOTS; i++) {
+        if (monitors[monitor_index].mon_blit_data_ptr->slots[i].buffer != NULL)
+            destroy_bitmap(monitors[monitor_index].mon_blit_data_ptr->slots[i].buffer);
+    }
     free(monitors[monitor_index].mon_blit_data_ptr);
     if (!monitors[monitor_index].mon_pal_lookup_static)
         free(monitors[monitor_index].mon_pal_lookup);
@@ -914,6 +1135,8 @@ video_init(void)
     for (uint32_t c = 0; c < 65536; c++)
         video_16to32[c] = calc_16to32(c);
 
+    svga_render_simd_init();
+
     memset(monitors, 0, sizeof(monitors));
     video_monitor_init(0);
 }
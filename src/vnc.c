@@ -38,11 +38,15 @@
 static rfbScreenInfoPtr rfb = NULL;
 static int              clients;
 static int              updatingSize;
+static int              markAll;
 static int              allowedX;
 static int              allowedY;
 static int              ptr_x;
 static int              ptr_y;
 static int              ptr_but;
+/* Changes of frames that were not copied; a count above VIDEO_DIRTY_RECTS_MAX means all of it. */
+static video_rect_t     skipped[VIDEO_DIRTY_RECTS_MAX];
+static int              skipped_count;
 
 #ifdef ENABLE_VNC_LOG
 int vnc_do_log = ENABLE_VNC_LOG;
@@ -174,21 +178,73 @@ vnc_display(rfbClientPtr cl)
 static void
 vnc_blit(int x, int y, int w, int h, int monitor_index)
 {
+    video_rect_t dirty[VIDEO_DIRTY_RECTS_MAX * 2];
+    int          dirty_count;
+
     if (monitor_index || (x < 0) || (y < 0) || (w < VNC_MIN_X) || (h < VNC_MIN_Y) || (w > VNC_MAX_X) || (h > VNC_MAX_Y) || (buffer32 == NULL)) {
+        /* Keep what this frame changed for the next one that gets copied. */
+        if (!monitor_index) {
+            dirty_count = video_blit_get_dirty_monitor(dirty, monitor_index);
+            for (int i = 0; (i < dirty_count) && (skipped_count <= VIDEO_DIRTY_RECTS_MAX); i++) {
+                if (skipped_count < VIDEO_DIRTY_RECTS_MAX)
+                    skipped[skipped_count] = dirty[i];
+                skipped_count++;
+            }
+        }
         video_blit_complete_monitor(monitor_index);
         return;
     }
 
-    for (int row = 0; row < h; ++row)
-        video_copy(&(((uint8_t *) rfb->frameBuffer)[row * 2048 * sizeof(uint32_t)]), &(buffer32->line[y + row][x]), w * sizeof(uint32_t));
+    /* Only copy and encode what changed; rects are in buffer32 coordinates. */
+    const bitmap_t *source = video_blit_source_monitor(monitor_index);
+
+    if (skipped_count > VIDEO_DIRTY_RECTS_MAX) {
+        dirty[0].x  = x;
+        dirty[0].y  = y;
+        dirty[0].w  = w;
+        dirty[0].h  = h;
+        dirty_count = 1;
+    } else {
+        dirty_count = 0;
+        for (int i = 0; i < skipped_count; i++) {
+            int x1 = MAX(skipped[i].x, x);
+            int y1 = MAX(skipped[i].y, y);
+            int x2 = MIN(skipped[i].x + skipped[i].w, x + w);
+            int y2 = MIN(skipped[i].y + skipped[i].h, y + h);
+
+            if ((x2 > x1) && (y2 > y1)) {
+                dirty[dirty_count].x = x1;
+                dirty[dirty_count].y = y1;
+                dirty[dirty_count].w = x2 - x1;
+                dirty[dirty_count].h = y2 - y1;
+                dirty_count++;
+            }
+        }
+        dirty_count += video_blit_get_dirty_monitor(&dirty[dirty_count], monitor_index);
+    }
+    skipped_count = 0;
+
+    for (int i = 0; i < dirty_count; i++) {
+        for (int row = dirty[i].y; row < (dirty[i].y + dirty[i].h); ++row)
+            video_copy(&(((uint8_t *) rfb->frameBuffer)[(((row - y) * 2048) + (dirty[i].x - x)) * sizeof(uint32_t)]),
+                       &(source->line[row][dirty[i].x]), dirty[i].w * sizeof(uint32_t));
+    }
 
     if (screenshots)
         video_screenshot((uint32_t *) rfb->frameBuffer, 0, 0, VNC_MAX_X);
 
     video_blit_complete_monitor(monitor_index);
 
-    if (!updatingSize)
+    /* Changes made during a size update have not been sent, so send everything afterwards. */
+    if (updatingSize)
+        markAll = 1;
+    else if (markAll) {
         rfbMarkRectAsModified(rfb, 0, 0, allowedX, allowedY);
+        markAll = 0;
+    } else {
+        for (int i = 0; i < dirty_count; i++)
+            rfbMarkRectAsModified(rfb, dirty[i].x - x, dirty[i].y - y, dirty[i].x - x + dirty[i].w, dirty[i].y - y + dirty[i].h);
+    }
 }
 
 /* Initialize VNC for operation. */
@@ -0,0 +1,349 @@
+/*
+ * 86Box    A hypervisor and IBM PC system emulator that specializes in
+ *          running old operating systems and software designed for IBM
+ *          PC systems and compatibles from 1981 through fairly recent
+ *          system designs based on the PCI bus.
+ *
+ *          This file is part of the 86Box distribution.
+ *
+ *          Overlay hard disk image tool.
+ *
+ *          Creates copy-on-write overlays for hdd_overlay.c, shows their
+ *          backing chain, commits an overlay into its backing file and
+ *          flattens a chain into a raw image. The check command builds a
+ *          base image and a chain of two overlays, writes to them against
+ *          a model of the disk held in memory, and checks every read, a
+ *          reopen, flattening and committing; then times reads through
+ *          the shared block cache.
+ *
+ * Authors: 86Box contributors.
+ *
+ *          Copyright 2026 86Box contributors.
+ */
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <wchar.h>
+#include <86box/86box.h>
+#include <86box/hdd_overlay.h>
+
+static uint64_t
+now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ull + (uint64_t) ts.tv_nsec;
+}
+
+static uint32_t rng = 86;
+
+static uint32_t
+xr(void)
+{
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return rng;
+}
+
+/* Commands. */
+static int
+cmd_create(int argc, char **argv)
+{
+    uint32_t    block_sectors = HDD_OVERLAY_BLOCK_SECTORS;
+    uint64_t    sectors       = 0;
+    const char *files[2]      = { NULL, NULL };
+    int         n             = 0;
+
+    for (int i = 0; i < argc; i++) {
+        if (!strncmp(argv[i], "--block=", 8))
+            block_sectors = (uint32_t) strtoul(argv[i] + 8, NULL, 10) * 2;
+        else if (!strncmp(argv[i], "--sectors=", 10))
+            sectors = strtoull(argv[i] + 10, NULL, 10);
+        else if (n < 2)
+            files[n++] = argv[i];
+    }
+
+    if ((files[0] == NULL) || ((files[1] == NULL) && !sectors)) {
+        fprintf(stderr, "create: an overlay needs a backing file or a size\n");
+        return 1;
+    }
+
+    if (!hdd_overlay_create(files[0], files[1], sectors, block_sectors)) {
+        fprintf(stderr, "create: unable to create %s\n", files[0]);
+        return 1;
+    }
+
+    return 0;
+}
+
+static int
+cmd_info(const char *fn)
+{
+    hdd_overlay_t     *ovl = hdd_overlay_open(fn, 1);
+    hdd_overlay_info_t info;
+
+    if (ovl == NULL) {
+        fprintf(stderr, "info: %s is not an overlay\n", fn);
+        return 1;
+    }
+
+    for (hdd_overlay_t *l = ovl; l != NULL; l = hdd_overlay_get_backing(l)) {
+        hdd_overlay_get_info(l, &info);
+        printf("%s%s\n", (l == ovl) ? "" : "  backed by ", info.path);
+        printf("    %" PRIu64 " sectors", info.sectors);
+        if (info.tracks)
+            printf(", C/H/S %u/%u/%u", info.tracks, info.hpc, info.spt);
+        if (info.block_sectors)
+            printf(", %u kB blocks, %u of %u held", info.block_sectors / 2, info.allocated, info.blocks);
+        printf("\n");
+    }
+
+    hdd_overlay_close(ovl);
+
+    return 0;
+}
+
+/* Check. */
+#define CHECK_SECTORS 32768 /* 16 MB */
+
+static int
+check_against(hdd_overlay_t *ovl, const uint8_t *model, const char *what)
+{
+    uint8_t *buf    = malloc(300 << 9);
+    int      errors = 0;
+
+    for (uint64_t s = 0; s < CHECK_SECTORS; s += 256) {
+        if ((hdd_overlay_read(ovl, s, 256, buf) < 0) || memcmp(buf, model + (s << 9), 256 << 9))
+            errors++;
+    }
+
+    /* And some unaligned reads straddling blocks. */
+    for (int i = 0; i < 2000; i++) {
+        const uint32_t count  = 1 + (xr() % 300);
+        const uint64_t sector = xr() % (CHECK_SECTORS - count);
+
+        if ((hdd_overlay_read(ovl, sector, count, buf) < 0) || memcmp(buf, model + (sector << 9), (size_t) count << 9))
+            errors++;
+    }
+
+    free(buf);
+    printf("  %-30s: %d errors\n", what, errors);
+
+    return errors;
+}
+
+static void
+check_writes(hdd_overlay_t *ovl, uint8_t *model, int writes)
+{
+    uint8_t *buf = malloc(300 << 9);
+
+    for (int i = 0; i < writes; i++) {
+        const uint32_t count  = 1 + (xr() % 300);
+        const uint64_t sector = xr() % (CHECK_SECTORS - count);
+
+        for (uint32_t j = 0; j < (count << 9); j++)
+            buf[j] = (uint8_t) xr();
+
+        if ((xr() % 8) == 0) {
+            hdd_overlay_zero(ovl, sector, count);
+            memset(model + (sector << 9), 0, (size_t) count << 9);
+        } else {
+            hdd_overlay_write(ovl, sector, count, buf);
+            memcpy(model + (sector << 9), buf, (size_t) count << 9);
+        }
+    }
+
+    free(buf);
+}
+
+static int
+check_file(const char *fn, const uint8_t *model)
+{
+    FILE    *fp     = fopen(fn, "rb");
+    uint8_t *buf    = malloc(CHECK_SECTORS << 9);
+    int      errors = 1;
+
+    if (fp != NULL) {
+        errors = (fread(buf, 512, CHECK_SECTORS, fp) != CHECK_SECTORS) || memcmp(buf, model, CHECK_SECTORS << 9);
+        fclose(fp);
+    }
+    free(buf);
+
+    return errors;
+}
+
+static int
+cmd_check(const char *dir, uint64_t iters)
+{
+    char                      base[1024];
+    char                      snap[1024];
+    char                      top[1024];
+    char                      other[1024];
+    char                      flat[1024];
+    uint8_t                  *model     = malloc(CHECK_SECTORS << 9);
+    uint8_t                  *model_top = malloc(CHECK_SECTORS << 9);
+    uint8_t                  *buf       = malloc(8 << 9);
+    hdd_overlay_t            *ovl;
+    hdd_overlay_t            *ovl2;
+    hdd_overlay_cache_stats_t stats;
+    FILE                     *fp;
+    uint64_t                  start;
+    volatile uint32_t         sum    = 0;
+    int                       errors = 0;
+
+    snprintf(base, sizeof(base), "%s/ovl_check_base.img", dir);
+    snprintf(snap, sizeof(snap), "%s/ovl_check_snap.ovl", dir);
+    snprintf(top, sizeof(top), "%s/ovl_check_top.ovl", dir);
+    snprintf(other, sizeof(other), "%s/ovl_check_other.ovl", dir);
+    snprintf(flat, sizeof(flat), "%s/ovl_check_flat.img", dir);
+
+    for (size_t i = 0; i < (CHECK_SECTORS << 9); i++)
+        model[i] = (uint8_t) xr();
+    fp = fopen(base, "wb");
+    if ((fp == NULL) || (fwrite(model, 512, CHECK_SECTORS, fp) != CHECK_SECTORS)) {
+        fprintf(stderr, "check: unable to write %s\n", base);
+        return 1;
+    }
+    fclose(fp);
+
+    /* Backing names are relative to the overlay. */
+    if (!hdd_overlay_create(snap, "ovl_check_base.img", 0, 64) || !hdd_overlay_create(top, "ovl_check_snap.ovl", 0, 128) ||
+        !hdd_overlay_create(other, "ovl_check_base.img", 0, 128)) {
+        fprintf(stderr, "check: unable to create the overlays\n");
+        return 1;
+    }
+
+    ovl = hdd_overlay_open(snap, 0);
+    check_writes(ovl, model, 500);
+    errors += check_against(ovl, model, "snapshot");
+    hdd_overlay_close(ovl);
+
+    memcpy(model_top, model, CHECK_SECTORS << 9);
+    ovl = hdd_overlay_open(top, 0);
+    check_writes(ovl, model_top, 500);
+    errors += check_against(ovl, model_top, "overlay on snapshot");
+    hdd_overlay_close(ovl);
+
+    ovl = hdd_overlay_open(top, 0);
+    errors += check_against(ovl, model_top, "reopened");
+    hdd_overlay_close(ovl);
+
+    ovl = hdd_overlay_open(top, 1);
+    errors += check_against(ovl, model_top, "read-only, cached");
+    hdd_overlay_close(ovl);
+
+    /* The snapshot is now shared by the overlay on it, so it cannot be written as well. */
+    ovl  = hdd_overlay_open(top, 0);
+    ovl2 = hdd_overlay_open(snap, 0);
+    if (ovl2 != NULL) {
+        printf("  shared snapshot opened for writing\n");
+        hdd_overlay_close(ovl2);
+        errors++;
+    }
+    hdd_overlay_close(ovl);
+
+    if (!hdd_overlay_flatten(top, flat) || check_file(flat, model_top)) {
+        printf("  flatten failed\n");
+        errors++;
+    }
+
+    if (!hdd_overlay_commit(top)) {
+        printf("  commit failed\n");
+        errors++;
+    }
+    ovl = hdd_overlay_open(snap, 1);
+    errors += check_against(ovl, model_top, "snapshot after commit");
+    hdd_overlay_close(ovl);
+    ovl = hdd_overlay_open(top, 1);
+    errors += check_against(ovl, model_top, "overlay after commit");
+    hdd_overlay_close(ovl);
+
+    /* Two machines cloned from one base share its cache; half the disk fits in it. */
+    ovl  = hdd_overlay_open(other, 0);
+    ovl2 = hdd_overlay_open(top, 0);
+    start = now_ns();
+    for (uint64_t i = 0; i < iters; i++) {
+        const uint64_t sector = (xr() % (CHECK_SECTORS / 16)) * 8;
+
+        hdd_overlay_read((i & 1) ? ovl2 : ovl, sector, 8, buf);
+        sum += buf[xr() % (8 << 9)];
+    }
+    start = now_ns() - start;
+    hdd_overlay_get_cache_stats(&stats);
+    hdd_overlay_close(ovl2);
+    hdd_overlay_close(ovl);
+
+    printf("  %-30s: %d errors\n", "total", errors);
+    printf("speed   : %.1f ns per 4 kB read from two clones, cache %" PRIu64 " hits, %" PRIu64 " misses, %u blocks\n",
+           (double) start / (double) iters, stats.hits, stats.misses, stats.blocks);
+
+    remove(base);
+    remove(snap);
+    remove(top);
+    remove(other);
+    remove(flat);
+    free(model);
+    free(model_top);
+    free(buf);
+
+    return errors ? 1 : 0;
+}
+
+static void
+usage(const char *name)
+{
+    printf("Usage: %s create [--block=KB] [--sectors=N] <overlay> [<backing>]\n", name);
+    printf("       %s info <overlay>\n", name);
+    printf("       %s commit <overlay>\n", name);
+    printf("       %s flatten <overlay> <raw image>\n", name);
+    printf("       %s check [--dir=DIR] [--iters=N]\n\n", name);
+    printf("The backing file name is taken relative to the directory of the overlay.\n");
+    printf("Commit writes into the backing file, which changes the disk seen by any\n");
+    printf("other overlay on the same backing file.\n");
+}
+
+int
+main(int argc, char **argv)
+{
+    const char *dir   = ".";
+    uint64_t    iters = 200000ull;
+
+    if (argc < 2) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    if (!strcmp(argv[1], "create"))
+        return cmd_create(argc - 2, argv + 2);
+    else if (!strcmp(argv[1], "info") && (argc == 3))
+        return cmd_info(argv[2]);
+    else if (!strcmp(argv[1], "commit") && (argc == 3)) {
+        if (!hdd_overlay_commit(argv[2])) {
+            fprintf(stderr, "commit: unable to commit %s\n", argv[2]);
+            return 1;
+        }
+        return 0;
+    } else if (!strcmp(argv[1], "flatten") && (argc == 4)) {
+        if (!hdd_overlay_flatten(argv[2], argv[3])) {
+            fprintf(stderr, "flatten: unable to write %s\n", argv[3]);
+            return 1;
+        }
+        return 0;
+    } else if (!strcmp(argv[1], "check")) {
+        for (int i = 2; i < argc; i++) {
+            if (!strncmp(argv[i], "--dir=", 6))
+                dir = argv[i] + 6;
+            else if (!strncmp(argv[i], "--iters=", 8))
+                iters = strtoull(argv[i] + 8, NULL, 10);
+        }
+        return cmd_check(dir, iters);
+    }
+
+    usage(argv[0]);
+    return !strcmp(argv[1], "--help") ? 0 : 1;
+}